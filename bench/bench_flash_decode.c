@@ -0,0 +1,118 @@
+/*
+ * Split-KV decode attention benchmark
+ *
+ * Sweeps the context length from 512 to 32k positions for one decode step
+ * of a Qwen3-style layer (16 query heads, 8 KV heads, head_dim 128, FP16
+ * cache), comparing the serial per-head walk the model used before against
+ * flash_decode_f16().
+ *
+ * Usage: bench_flash_decode [threads]
+ */
+
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/attention/flash_decode.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NUM_HEADS 16
+#define NUM_KV_HEADS 8
+#define HEAD_DIM 128
+#define MAX_CTX 32768
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* The previous decode path: one head at a time, two expf per position */
+static void attend_serial(uint16_t *out, const uint16_t *q,
+                          const kv_block_table_t *kv, int kv_len,
+                          float scale) {
+  int group = NUM_HEADS / NUM_KV_HEADS;
+  for (int h = 0; h < NUM_HEADS; h++) {
+    const uint16_t *qh = q + h * HEAD_DIM;
+    int kv_off = (h / group) * HEAD_DIM;
+    float acc[HEAD_DIM] = {0};
+    float m = -1e9f, sum = 0.0f;
+    for (int t = 0; t < kv_len; t++) {
+      const uint16_t *k = (const uint16_t *)kv_block_table_key(kv, 0, t);
+      const uint16_t *v = (const uint16_t *)kv_block_table_value(kv, 0, t);
+      float score = 0.0f;
+      for (int d = 0; d < HEAD_DIM; d++)
+        score += f16_to_f32(qh[d]) * f16_to_f32(k[kv_off + d]);
+      score *= scale;
+      float m_new = score > m ? score : m;
+      float alpha = expf(m - m_new);
+      float w = expf(score - m_new);
+      for (int d = 0; d < HEAD_DIM; d++)
+        acc[d] = acc[d] * alpha + f16_to_f32(v[kv_off + d]) * w;
+      sum = sum * alpha + w;
+      m = m_new;
+    }
+    for (int d = 0; d < HEAD_DIM; d++)
+      out[h * HEAD_DIM + d] = f32_to_f16(acc[d] / sum);
+  }
+}
+
+int main(int argc, char **argv) {
+  if (argc > 1)
+    threadpool_set_num_threads(atoi(argv[1]));
+
+  kv_page_pool_t *pool = kv_page_pool_create(1, NUM_KV_HEADS, HEAD_DIM,
+                                             sizeof(uint16_t), 0, 0);
+  kv_block_table_t kv;
+  kv_block_table_init(&kv, pool);
+  if (!pool || !kv_block_table_reserve(&kv, MAX_CTX)) {
+    fprintf(stderr, "failed to allocate the cache\n");
+    return 1;
+  }
+
+  size_t kv_count = (size_t)MAX_CTX * NUM_KV_HEADS * HEAD_DIM;
+  uint16_t *kv_data = malloc(kv_count * sizeof(uint16_t));
+  uint16_t q[NUM_HEADS * HEAD_DIM], out[NUM_HEADS * HEAD_DIM];
+  for (size_t i = 0; i < kv_count; i++)
+    kv_data[i] = f32_to_f16((float)((i * 2654435761u) % 2001) / 1000.0f - 1);
+  for (int i = 0; i < NUM_HEADS * HEAD_DIM; i++)
+    q[i] = f32_to_f16((float)(i % 17) / 8.0f - 1.0f);
+  kv_cache_append_paged_f16(&kv, 0, kv_data, kv_data, 0, MAX_CTX);
+
+  void *scratch = malloc(flash_decode_scratch_bytes(NUM_HEADS, HEAD_DIM));
+  float scale = 1.0f / sqrtf((float)HEAD_DIM);
+
+  printf("threads: %d\n", threadpool_get_num_threads());
+  printf("%8s %12s %12s %9s %10s\n", "ctx", "serial ms", "split ms",
+         "speedup", "GB/s");
+  for (int ctx = 512; ctx <= MAX_CTX; ctx *= 2) {
+    int iters = ctx <= 4096 ? 50 : 10;
+
+    attend_serial(out, q, &kv, ctx, scale);
+    double t0 = now_ms();
+    for (int i = 0; i < iters; i++)
+      attend_serial(out, q, &kv, ctx, scale);
+    double serial = (now_ms() - t0) / iters;
+
+    flash_decode_f16(out, q, &kv, 0, ctx, NUM_HEADS, NUM_KV_HEADS, HEAD_DIM,
+                     scale, scratch);
+    t0 = now_ms();
+    for (int i = 0; i < iters; i++)
+      flash_decode_f16(out, q, &kv, 0, ctx, NUM_HEADS, NUM_KV_HEADS,
+                       HEAD_DIM, scale, scratch);
+    double split = (now_ms() - t0) / iters;
+
+    double bytes = 2.0 * ctx * NUM_KV_HEADS * HEAD_DIM * sizeof(uint16_t);
+    printf("%8d %12.3f %12.3f %8.1fx %10.2f\n", ctx, serial, split,
+           serial / split, bytes / (split * 1e6));
+  }
+
+  free(scratch);
+  free(kv_data);
+  kv_block_table_free(&kv);
+  kv_page_pool_destroy(pool);
+  return 0;
+}
@@ -0,0 +1,132 @@
+/*
+ * NUMA decode benchmark
+ *
+ * Decode is bound by how fast the weights stream from memory, so one
+ * "token" here is an FP16 GEMV over every matrix of a synthetic model
+ * (stored transposed, as the model keeps them). Tokens/sec are reported
+ * for three placements:
+ *
+ *   1 socket       threads and weights on the first node
+ *   N sockets      threads on every node, weights where first touch put
+ *                  them (all on the first node)
+ *   N sockets, il  threads on every node, weights interleaved over the
+ *                  nodes with numa_interleave()
+ *
+ * On a single-node host only the first row is meaningful.
+ *
+ * Usage: bench_numa [model_mb] [tokens]
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/backend/numa.h"
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/gemv/gemv.h"
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/* One [HIDDEN, HIDDEN] FP16 matrix is 32 MB */
+#define HIDDEN 4096
+
+static double now_ms(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/* Restrict this thread, and the pool workers it creates, to one node */
+static int bind_to_node(const cpu_set_t *all, int node) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (CPU_ISSET(cpu, all) && caps_numa_node_of_cpu(cpu) == node)
+      CPU_SET(cpu, &set);
+  }
+  sched_setaffinity(0, sizeof(set), &set);
+  return CPU_COUNT(&set);
+}
+
+static double run(uint16_t **w, int num_mats, const float *x, float *y,
+                  int tokens) {
+  for (int m = 0; m < num_mats; m++)
+    gemv_f16(w[m], x, y, HIDDEN, HIDDEN, true);
+  double t0 = now_ms();
+  for (int t = 0; t < tokens; t++) {
+    for (int m = 0; m < num_mats; m++)
+      gemv_f16(w[m], x, y, HIDDEN, HIDDEN, true);
+  }
+  return tokens * 1e3 / (now_ms() - t0);
+}
+
+int main(int argc, char **argv) {
+  int model_mb = argc > 1 ? atoi(argv[1]) : 4096;
+  int tokens = argc > 2 ? atoi(argv[2]) : 8;
+  size_t mat_bytes = (size_t)HIDDEN * HIDDEN * sizeof(uint16_t);
+  int num_mats = (int)(((size_t)model_mb << 20) / mat_bytes);
+  if (num_mats < 1)
+    num_mats = 1;
+
+  const system_caps_t *caps = caps_get();
+  cpu_set_t all;
+  sched_getaffinity(0, sizeof(all), &all);
+  int node0_cpus = bind_to_node(&all, 0);
+
+  /* First touch from node 0 puts every page there */
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  uint16_t **w = malloc(num_mats * sizeof(uint16_t *));
+  for (int m = 0; m < num_mats; m++) {
+    w[m] = aligned_alloc(page, mat_bytes);
+    if (!w[m]) {
+      fprintf(stderr, "failed to allocate %d MB of weights\n", model_mb);
+      return 1;
+    }
+    for (size_t i = 0; i < (size_t)HIDDEN * HIDDEN; i++)
+      w[m][i] = f32_to_f16((float)((i * 2654435761u + m) % 2001) / 1e5f);
+  }
+  float *x = malloc(HIDDEN * sizeof(float));
+  float *y = malloc(HIDDEN * sizeof(float));
+  for (int i = 0; i < HIDDEN; i++)
+    x[i] = (float)(i % 13) / 13.0f;
+
+  printf("nodes: %d, weights: %d MB in %d matrices, tokens: %d\n",
+         caps->num_numa_nodes, (int)(num_mats * (mat_bytes >> 20)), num_mats,
+         tokens);
+  printf("%-16s %8s %10s %10s\n", "placement", "threads", "tok/s", "GB/s");
+
+  threadpool_set_num_threads(node0_cpus);
+  double tps = run(w, num_mats, x, y, tokens);
+  printf("%-16s %8d %10.2f %10.2f\n", "1 socket", threadpool_get_num_threads(),
+         tps, tps * num_mats * mat_bytes / 1e9);
+
+  if (caps->num_numa_nodes > 1) {
+    sched_setaffinity(0, sizeof(all), &all);
+    threadpool_set_num_threads(CPU_COUNT(&all));
+    tps = run(w, num_mats, x, y, tokens);
+    printf("%-16s %8d %10.2f %10.2f\n", "N sockets",
+           threadpool_get_num_threads(), tps,
+           tps * num_mats * mat_bytes / 1e9);
+
+    bool placed = true;
+    for (int m = 0; m < num_mats; m++)
+      placed = numa_interleave(w[m], mat_bytes) && placed;
+    tps = run(w, num_mats, x, y, tokens);
+    printf("%-16s %8d %10.2f %10.2f%s\n", "N sockets, il",
+           threadpool_get_num_threads(), tps,
+           tps * num_mats * mat_bytes / 1e9,
+           placed ? "" : "  (mbind failed)");
+  } else {
+    printf("single NUMA node: nothing to compare against\n");
+  }
+
+  for (int m = 0; m < num_mats; m++)
+    free(w[m]);
+  free(w);
+  free(x);
+  free(y);
+  return 0;
+}
@@ -0,0 +1,125 @@
+/*
+ * Measures aggregate decode throughput of the continuous batching scheduler
+ * for increasing numbers of concurrent sequences.
+ */
+
+#include "inference/model/base.h"
+#include "inference/model/scheduler.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+static double get_time_ms(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void print_usage(const char *prog) {
+  fprintf(stderr, "Usage: %s [options] <model_dir>\n", prog);
+  fprintf(stderr, "Options:\n");
+  fprintf(stderr, "  --dtype <f32|f16>  Set compute dtype (default: f16)\n");
+  fprintf(stderr, "  --max-batch <n>    Largest batch size (default: 16)\n");
+  fprintf(stderr, "  --prompt <n>       Prompt tokens per sequence "
+                  "(default: 64)\n");
+  fprintf(stderr, "  --tokens <n>       Tokens generated per sequence "
+                  "(default: 64)\n");
+  fprintf(stderr, "  --help             Show this help message\n");
+}
+
+int main(int argc, char **argv) {
+  inference_dtype_t dtype = INFERENCE_DTYPE_F16;
+  const char *model_dir = NULL;
+  int max_batch = 16;
+  int prompt_len = 64;
+  int gen_tokens = 64;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--dtype") == 0 && i + 1 < argc) {
+      i++;
+      dtype = strcmp(argv[i], "f32") == 0 ? INFERENCE_DTYPE_F32
+                                          : INFERENCE_DTYPE_F16;
+    } else if (strcmp(argv[i], "--max-batch") == 0 && i + 1 < argc) {
+      max_batch = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--prompt") == 0 && i + 1 < argc) {
+      prompt_len = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--tokens") == 0 && i + 1 < argc) {
+      gen_tokens = atoi(argv[++i]);
+    } else if (strcmp(argv[i], "--help") == 0) {
+      print_usage(argv[0]);
+      return 0;
+    } else if (model_dir == NULL) {
+      model_dir = argv[i];
+    }
+  }
+
+  if (model_dir == NULL || max_batch <= 0 || prompt_len <= 0 ||
+      gen_tokens <= 0) {
+    print_usage(argv[0]);
+    return 1;
+  }
+
+  inference_model_t model;
+  if (!inference_model_load(&model, NULL, model_dir, dtype)) {
+    fprintf(stderr, "Failed to load model\n");
+    return 1;
+  }
+
+  int *prompt = (int *)malloc(prompt_len * sizeof(int));
+  if (!prompt) {
+    inference_model_free(&model);
+    return 1;
+  }
+
+  printf("%6s %10s %12s %12s %10s\n", "batch", "steps", "prefill ms",
+         "decode ms", "tok/s");
+
+  for (int batch = 1; batch <= max_batch; batch *= 2) {
+    scheduler_config_t config = {batch, batch * prompt_len, prompt_len};
+    scheduler_t *sched = scheduler_create(&model, &config);
+    if (!sched) {
+      fprintf(stderr, "Failed to create scheduler\n");
+      break;
+    }
+
+    scheduler_params_t params;
+    memset(&params, 0, sizeof(params));
+    params.max_tokens = gen_tokens;
+    params.eos_token_id = -1;
+
+    /* Distinct prompts so that no two sequences, in this run or an earlier
+     * one, share a prefix */
+    for (int s = 0; s < batch; s++) {
+      for (int i = 0; i < prompt_len; i++)
+        prompt[i] = (i * 131 + (batch + s) * 977 + 7) % model.vocab_size;
+      scheduler_submit(sched, prompt, prompt_len, &params, NULL, NULL);
+    }
+
+    /* The first step prefills every prompt and samples their first token */
+    double start = get_time_ms();
+    scheduler_step(sched);
+    double prefill_ms = get_time_ms() - start;
+
+    start = get_time_ms();
+    while (scheduler_num_active(sched) > 0) {
+      if (scheduler_step(sched) < 0) {
+        fprintf(stderr, "Forward pass failed\n");
+        break;
+      }
+    }
+    double decode_ms = get_time_ms() - start;
+
+    scheduler_stats_t stats;
+    scheduler_get_stats(sched, &stats);
+    double decoded = (double)stats.decode_tokens - batch;
+    printf("%6d %10llu %12.1f %12.1f %10.1f\n", batch,
+           (unsigned long long)stats.steps, prefill_ms, decode_ms,
+           decode_ms > 0 ? decoded * 1000.0 / decode_ms : 0.0);
+    scheduler_destroy(sched);
+  }
+
+  free(prompt);
+  inference_model_free(&model);
+  return 0;
+}
@@ -212,6 +212,9 @@ int main(int argc, char **argv) {
   printf("  Decode time:      %.1f ms  (%.1f tok/s)\n", decode_time, output_tok_per_s);
   printf("  Time to 1st:      %.1f ms\n", time_to_first_token);
   printf("  Total time:       %.1f ms\n", prefill_time + decode_time);
+  printf("  KV cache:         %.1f MB (%d pages)\n",
+         kv_page_pool_bytes(model.kv_pool) / (1024.0 * 1024.0),
+         kv_page_pool_pages_in_use(model.kv_pool));
 
   long long bytes_processed = 0;
   long long hidden_size_bytes = (long long)model.config.hidden_size * 4;
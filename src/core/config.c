@@ -8,9 +8,9 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
-static const char *API_TYPE_NAMES[] = {"openai",   "aphrodite", "vllm",
-                                       "llamacpp", "koboldcpp", "tabby",
-                                       "anthropic"};
+static const char *API_TYPE_NAMES[] = {"openai",    "aphrodite", "vllm",
+                                       "llamacpp",  "koboldcpp", "tabby",
+                                       "anthropic", "local"};
 
 const char *api_type_name(ApiType type) {
   if (type >= 0 && type < API_TYPE_COUNT)
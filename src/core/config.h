@@ -19,6 +19,7 @@ typedef enum {
   API_TYPE_KOBOLDCPP,
   API_TYPE_TABBY,
   API_TYPE_ANTHROPIC,
+  API_TYPE_LOCAL,
   API_TYPE_COUNT
 } ApiType;
 
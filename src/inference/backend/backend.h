@@ -11,6 +11,7 @@
 #define INFERENCE_BACKEND_BACKEND_H
 
 #include "inference/backend/caps.h"
+#include "inference/backend/threadpool.h"
 #include "inference/core/dtype.h"
 #include "inference/core/tensor.h"
 #include <stdbool.h>
@@ -264,6 +265,7 @@ typedef struct {
 struct backend {
   const backend_ops_t *ops; /**< Operations vtable */
   void *ctx;                /**< Backend-specific context */
+  threadpool_t *pool;       /**< Worker pool for parallel operations */
   int num_threads;          /**< Thread count for parallel operations */
   dtype_t preferred_dtype;  /**< Preferred dtype for this backend */
 };
@@ -313,6 +315,9 @@ void backend_set_default(backend_t *backend);
 
 /**
  * Set the number of threads for a backend.
+ * Every backend shares the process-wide worker pool, so this resizes the pool
+ * used by all kernels. Must not be called while kernels are running.
+ *
  * @param backend Backend instance
  * @param num_threads Number of threads (0 = use all CPUs)
  */
@@ -336,6 +341,9 @@ int backend_get_num_threads(const backend_t *backend);
 void backend_gemm(const tensor_t *A, const tensor_t *B, tensor_t *C,
                   bool transpose_A, bool transpose_B);
 
+/** GEMV using default backend */
+void backend_gemv(const tensor_t *A, const tensor_t *x, tensor_t *y);
+
 /** RMS norm using default backend */
 void backend_rms_norm(tensor_t *out, const tensor_t *in, const tensor_t *weight,
                       float eps);
@@ -4,7 +4,10 @@
  */
 
 #include "inference/backend/caps.h"
+#include <limits.h>
 #include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 #ifdef _WIN32
@@ -13,15 +16,31 @@
 #include <unistd.h>
 #endif
 
+#if defined(__linux__)
+#include <dirent.h>
+#include <stdio.h>
+#endif
+
 #if defined(__APPLE__)
 #include <sys/sysctl.h>
 #endif
 
+#if (defined(__x86_64__) || defined(_M_X64)) && defined(__GNUC__)
+#include <cpuid.h>
+#define CAPS_X86_CPUID 1
+#else
+#define CAPS_X86_CPUID 0
+#endif
+
 /* Static storage for capabilities */
 static system_caps_t g_caps;
 static atomic_int g_initialized = 0;
 static int g_user_num_threads = 0;
 
+/* NUMA topology: dense node of each CPU, kernel id of each dense node */
+static unsigned char g_cpu_node[CAPS_MAX_CPUS];
+static int g_node_ids[CAPS_MAX_NUMA_NODES];
+
 /* Capability names */
 static const char *cap_names[CAP_COUNT] = {
     [CAP_SCALAR] = "scalar", [CAP_NEON] = "neon",
@@ -64,6 +83,174 @@ static size_t get_cache_size(const char *name) {
 }
 #endif
 
+#if CAPS_X86_CPUID
+/* XCR0 via xgetbv; only valid once CPUID reports OSXSAVE */
+static uint64_t read_xcr0(void) {
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return ((uint64_t)edx << 32) | eax;
+}
+
+/*
+ * The instruction set alone is not enough: the OS must also save the wider
+ * register state on context switch (XCR0 bits 1-2 for YMM, 5-7 for ZMM).
+ */
+static void detect_x86_features(system_caps_t *caps) {
+  unsigned int eax, ebx, ecx, edx;
+
+  if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    return;
+
+  bool osxsave = (ecx & bit_OSXSAVE) != 0;
+  bool avx = (ecx & bit_AVX) != 0;
+  bool fma = (ecx & bit_FMA) != 0;
+  bool f16c = (ecx & bit_F16C) != 0;
+  if (!osxsave || !avx)
+    return;
+
+  uint64_t xcr0 = read_xcr0();
+  bool ymm_state = (xcr0 & 0x6) == 0x6;
+  bool zmm_state = (xcr0 & 0xe6) == 0xe6;
+
+  if (!__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+    return;
+
+  bool avx2 = (ebx & bit_AVX2) != 0;
+  bool avx512 = (ebx & bit_AVX512F) && (ebx & bit_AVX512BW) &&
+                (ebx & bit_AVX512VL) && (ebx & bit_AVX512DQ);
+  bool vnni = (ecx & bit_AVX512VNNI) != 0;
+  bool fp16 = (edx & bit_AVX512FP16) != 0;
+
+  unsigned int eax1 = 0, ebx1, ecx1, edx1;
+  __get_cpuid_count(7, 1, &eax1, &ebx1, &ecx1, &edx1);
+  bool bf16 = (eax1 & bit_AVX512BF16) != 0;
+
+  if (avx2 && fma && f16c && ymm_state) {
+    caps->available[CAP_AVX2] = true;
+    caps->priority[CAP_AVX2] = default_priorities[CAP_AVX2];
+
+    if (avx512 && zmm_state) {
+      caps->available[CAP_AVX512] = true;
+      caps->priority[CAP_AVX512] = default_priorities[CAP_AVX512];
+      caps->has_avx512_bf16 = bf16;
+      caps->has_avx512_fp16 = fp16;
+      caps->has_avx512_vnni = vnni;
+    }
+  }
+}
+#endif
+
+#if CAPS_X86_CPUID
+/*
+ * Per-core data cache sizes from the deterministic cache parameters leaf
+ * (leaf 4 on Intel, 0x8000001D on AMD; both use the same layout).
+ */
+static void detect_x86_caches(system_caps_t *caps) {
+  unsigned int leaves[2] = {4, 0x8000001D};
+  for (int l = 0; l < 2; l++) {
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(leaves[l] & 0x80000000, NULL) < leaves[l])
+      continue;
+    for (unsigned int sub = 0; sub < 16; sub++) {
+      __cpuid_count(leaves[l], sub, eax, ebx, ecx, edx);
+      unsigned int type = eax & 0x1F; /* 1 = data, 3 = unified */
+      if (type == 0)
+        break;
+      if (type != 1 && type != 3)
+        continue;
+      size_t size = (size_t)((ebx >> 22) + 1) *
+                    (((ebx >> 12) & 0x3FF) + 1) * ((ebx & 0xFFF) + 1) *
+                    ((size_t)ecx + 1);
+      unsigned int level = (eax >> 5) & 0x7;
+      if (level == 1 && !caps->l1_cache_size)
+        caps->l1_cache_size = size;
+      else if (level == 2 && !caps->l2_cache_size)
+        caps->l2_cache_size = size;
+    }
+    if (caps->l1_cache_size && caps->l2_cache_size)
+      return;
+  }
+}
+#endif
+
+#if defined(__linux__)
+static int compare_ints(const void *a, const void *b) {
+  int x = *(const int *)a, y = *(const int *)b;
+  return (x > y) - (x < y);
+}
+
+/* Nodes from /sys/devices/system/node/node<id>/cpulist, by ascending id */
+static void detect_numa(system_caps_t *caps) {
+  DIR *dir = opendir("/sys/devices/system/node");
+  if (!dir)
+    return;
+
+  int ids[CAPS_MAX_NUMA_NODES];
+  int num_ids = 0;
+  struct dirent *entry;
+  while ((entry = readdir(dir)) != NULL && num_ids < CAPS_MAX_NUMA_NODES) {
+    int id;
+    char extra;
+    if (sscanf(entry->d_name, "node%d%c", &id, &extra) == 1 && id >= 0)
+      ids[num_ids++] = id;
+  }
+  closedir(dir);
+  qsort(ids, num_ids, sizeof(int), compare_ints);
+
+  bool cpus[CAPS_MAX_CPUS];
+  char list[8192];
+  int nodes = 0;
+  for (int i = 0; i < num_ids; i++) {
+    char path[64];
+    snprintf(path, sizeof(path), "/sys/devices/system/node/node%d/cpulist",
+             ids[i]);
+    FILE *f = fopen(path, "r");
+    if (!f)
+      continue;
+    bool read_ok = fgets(list, sizeof(list), f) != NULL;
+    fclose(f);
+    if (!read_ok || caps_parse_cpulist(list, cpus, CAPS_MAX_CPUS) <= 0)
+      continue;
+
+    for (int cpu = 0; cpu < CAPS_MAX_CPUS; cpu++) {
+      if (cpus[cpu])
+        g_cpu_node[cpu] = (unsigned char)nodes;
+    }
+    g_node_ids[nodes++] = ids[i];
+  }
+  if (nodes > 0)
+    caps->num_numa_nodes = nodes;
+}
+#endif
+
+/* SILLYTUI_FORCE_BACKEND=<cap name> masks every tier preferred over it */
+static void apply_forced_backend(system_caps_t *caps) {
+  caps->forced = CAP_COUNT;
+
+  const char *name = getenv("SILLYTUI_FORCE_BACKEND");
+  if (!name || !*name)
+    return;
+
+  for (int c = 0; c < CAP_COUNT; c++) {
+    if (strcmp(name, cap_names[c]) != 0)
+      continue;
+    if (!caps->available[c])
+      return;
+
+    for (int other = 0; other < CAP_COUNT; other++) {
+      if (other != c && caps->priority[other] > caps->priority[c])
+        caps->available[other] = false;
+    }
+    if (c != CAP_AVX512) {
+      caps->has_avx512_bf16 = false;
+      caps->has_avx512_fp16 = false;
+      caps->has_avx512_vnni = false;
+    }
+    caps->forced = (cap_t)c;
+    return;
+  }
+}
+
 static void detect_capabilities(system_caps_t *caps) {
   memset(caps, 0, sizeof(*caps));
 
@@ -75,6 +262,14 @@ static void detect_capabilities(system_caps_t *caps) {
   caps->num_cpus = get_cpu_count();
   caps->num_threads = caps->num_cpus;
 
+  /* One node unless the OS reports more */
+  caps->num_numa_nodes = 1;
+  memset(g_cpu_node, 0, sizeof(g_cpu_node));
+  g_node_ids[0] = 0;
+#if defined(__linux__)
+  detect_numa(caps);
+#endif
+
   /* ARM NEON detection */
 #if defined(__ARM_NEON) || defined(__ARM_NEON__)
   caps->available[CAP_NEON] = true;
@@ -97,19 +292,10 @@ static void detect_capabilities(system_caps_t *caps) {
   caps->l2_cache_size = get_cache_size("hw.l2cachesize");
 #endif
 
-  /* x86 SIMD detection would go here */
-#if defined(__x86_64__) || defined(_M_X64)
-  /* TODO: Proper CPUID-based detection for AVX2/AVX512 */
-  /* For now, we can use compiler-defined macros */
-#ifdef __AVX2__
-  caps->available[CAP_AVX2] = true;
-  caps->priority[CAP_AVX2] = default_priorities[CAP_AVX2];
-#endif
-
-#ifdef __AVX512F__
-  caps->available[CAP_AVX512] = true;
-  caps->priority[CAP_AVX512] = default_priorities[CAP_AVX512];
-#endif
+  /* x86 SIMD tiers are probed at runtime so one binary serves every host */
+#if CAPS_X86_CPUID
+  detect_x86_features(caps);
+  detect_x86_caches(caps);
 #endif
 
   /* Metal is potentially available on Apple platforms but requires runtime
@@ -122,6 +308,8 @@ static void detect_capabilities(system_caps_t *caps) {
 
   /* CUDA would require runtime check */
   caps->available[CAP_CUDA] = false;
+
+  apply_forced_backend(caps);
 }
 
 /* ============================================================================
@@ -178,6 +366,53 @@ void caps_set_num_threads(int num_threads) {
   }
 }
 
+int caps_numa_node_of_cpu(int cpu) {
+  caps_get();
+  if (cpu < 0 || cpu >= CAPS_MAX_CPUS)
+    return 0;
+  return g_cpu_node[cpu];
+}
+
+int caps_numa_node_id(int node) {
+  const system_caps_t *caps = caps_get();
+  if (node < 0 || node >= caps->num_numa_nodes)
+    return -1;
+  return g_node_ids[node];
+}
+
+int caps_parse_cpulist(const char *list, bool *cpus, int max_cpus) {
+  if (!list || !cpus || max_cpus <= 0)
+    return -1;
+  memset(cpus, 0, (size_t)max_cpus * sizeof(bool));
+
+  int count = 0;
+  const char *p = list;
+  while (*p && *p != '\n') {
+    char *end;
+    long lo = strtol(p, &end, 10);
+    if (end == p || lo < 0)
+      return -1;
+    long hi = lo;
+    p = end;
+    if (*p == '-') {
+      hi = strtol(p + 1, &end, 10);
+      if (end == p + 1 || hi < lo)
+        return -1;
+      p = end;
+    }
+    for (long cpu = lo; cpu <= hi && cpu < max_cpus; cpu++)
+      cpus[cpu] = true;
+    if (hi - lo + 1 > INT_MAX - count)
+      return -1;
+    count += (int)(hi - lo + 1);
+    if (*p == ',')
+      p++;
+    else if (*p && *p != '\n')
+      return -1;
+  }
+  return count;
+}
+
 cap_t caps_best_for_gemm(void) {
   const system_caps_t *caps = caps_get();
 
@@ -31,6 +31,10 @@ typedef enum {
   CAP_COUNT
 } cap_t;
 
+/** Most CPUs and NUMA nodes the topology tables track */
+#define CAPS_MAX_CPUS 1024
+#define CAPS_MAX_NUMA_NODES 64
+
 /**
  * System capabilities structure.
  * Detected once at initialization and cached.
@@ -41,13 +45,25 @@ typedef struct {
                                 preferred) */
   int num_cpus;              /**< Number of CPU cores */
   int num_threads;           /**< Recommended thread count */
+  int num_numa_nodes;        /**< NUMA nodes with CPUs (1 if unknown) */
   size_t l1_cache_size;      /**< L1 cache size in bytes (0 if unknown) */
   size_t l2_cache_size;      /**< L2 cache size in bytes (0 if unknown) */
+  bool has_avx512_bf16;      /**< AVX512_BF16 (vdpbf16ps) */
+  bool has_avx512_fp16;      /**< AVX512_FP16 native half arithmetic */
+  bool has_avx512_vnni;      /**< AVX512_VNNI int8 dot products */
+  cap_t forced;              /**< Tier pinned by SILLYTUI_FORCE_BACKEND, or
+                                CAP_COUNT when not forced */
 } system_caps_t;
 
 /**
  * Initialize capability detection.
  * Call once at program startup. Thread-safe, can be called multiple times.
+ *
+ * On x86-64 the SIMD tiers are detected at runtime with CPUID/XGETBV, so a
+ * single binary picks AVX-512 or AVX2 per host. Setting the environment
+ * variable SILLYTUI_FORCE_BACKEND to a capability name ("scalar", "avx2",
+ * "avx512", ...) masks off every tier preferred over it, which pins both
+ * backend_find_best() and the per-kernel dispatchers to that tier.
  */
 void caps_init(void);
 
@@ -91,6 +107,37 @@ int caps_num_threads(void);
  */
 void caps_set_num_threads(int num_threads);
 
+/**
+ * Get the NUMA node of a CPU.
+ *
+ * On Linux the topology is read from /sys/devices/system/node (no libnuma
+ * needed); nodes without CPUs are left out. Nodes are numbered densely in
+ * the order of their kernel ids, see caps_numa_node_id().
+ *
+ * @param cpu CPU number
+ * @return Node in [0, num_numa_nodes), 0 if unknown
+ */
+int caps_numa_node_of_cpu(int cpu);
+
+/**
+ * Get the kernel's id of a NUMA node (the N of /sys/.../nodeN), as memory
+ * policies expect it.
+ *
+ * @param node Node in [0, num_numa_nodes)
+ * @return Kernel node id, or -1 for an invalid node
+ */
+int caps_numa_node_id(int node);
+
+/**
+ * Parse a Linux cpulist such as "0-3,8,10-11\n".
+ *
+ * @param list cpulist text
+ * @param cpus Output, cpus[i] set for every listed CPU below max_cpus
+ * @param max_cpus Length of cpus
+ * @return Number of CPUs listed, or -1 if the list is malformed
+ */
+int caps_parse_cpulist(const char *list, bool *cpus, int max_cpus);
+
 /**
  * Get the best available capability for GEMM operations.
  * Priority: Accelerate > AMX (for FP16) > NEON > AVX2 > Scalar
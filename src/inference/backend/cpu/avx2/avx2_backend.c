@@ -0,0 +1,670 @@
+#include "inference/backend/cpu/avx2/avx2_backend.h"
+#include "inference/backend/registry.h"
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include "inference/core/dtype.h"
+#include "inference/kernels/activation/activation.h"
+#include "inference/kernels/activation/activation_kernels.h"
+#include "inference/kernels/attention/attention.h"
+#include "inference/kernels/embedding/embedding.h"
+#include "inference/kernels/gemm/gemm_kernels.h"
+#include "inference/kernels/gemv/gemv.h"
+#include "inference/kernels/kv_cache/kv_cache.h"
+#include "inference/kernels/norm/layernorm_kernels.h"
+#include "inference/kernels/rope/rope_kernels.h"
+#include "inference/kernels/sampling/sampling_kernels.h"
+#include "inference/kernels/softmax/softmax_kernels.h"
+#include <immintrin.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static inline float avx2_hsum(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+static inline __m256 avx2_load_bf16(const uint16_t *p) {
+  __m128i h = _mm_loadu_si128((const __m128i *)p);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+static inline __m256 avx2_load_f16(const uint16_t *p) {
+  return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+static bool avx2_init(backend_t *backend) {
+  (void)backend;
+  return true;
+}
+
+static void avx2_destroy(backend_t *backend) { (void)backend; }
+
+static void avx2_gemm(backend_t *backend, const tensor_t *A, const tensor_t *B,
+                      tensor_t *C, bool transpose_A, bool transpose_B) {
+  if (!A || !B || !C || !A->data || !B->data || !C->data)
+    return;
+
+  int M = (int)tensor_dim(C, 0);
+  int N = (int)tensor_dim(C, 1);
+  int K = (int)tensor_dim(A, transpose_A ? 0 : 1);
+  int num_threads = backend ? backend->num_threads : 1;
+
+  /* Only the F32 kernels read transposed operands */
+  if (A->dtype == DTYPE_F32) {
+    gemm_f32_kernel_avx2_trans(tensor_data_f32_const(A),
+                               tensor_data_f32_const(B), tensor_data_f32(C),
+                               M, N, K, transpose_A, transpose_B, num_threads);
+    return;
+  }
+
+  if (transpose_A || transpose_B)
+    return;
+
+  if (A->dtype == DTYPE_F16) {
+    const uint16_t *a = tensor_data_f16_const(A);
+    const uint16_t *b = tensor_data_f16_const(B);
+    uint16_t *c = tensor_data_f16(C);
+
+    if (num_threads > 1) {
+      gemm_f16_kernel_avx2_mt(a, b, c, M, N, K, num_threads);
+    } else {
+      gemm_f16_kernel_avx2(a, b, c, M, N, K);
+    }
+  } else if (A->dtype == DTYPE_BF16) {
+    const uint16_t *a = tensor_data_f16_const(A);
+    const uint16_t *b = tensor_data_f16_const(B);
+    uint16_t *c = tensor_data_f16(C);
+
+    if (num_threads > 1) {
+      gemm_bf16_kernel_avx2_mt(a, b, c, M, N, K, num_threads);
+    } else {
+      gemm_bf16_kernel_avx2(a, b, c, M, N, K);
+    }
+  }
+}
+
+static void avx2_silu(backend_t *backend, tensor_t *out, const tensor_t *in) {
+  (void)backend;
+
+  if (!out || !in)
+    return;
+
+  int n = (int)tensor_numel(in);
+
+  if (in->dtype == DTYPE_F32) {
+    silu_f32_kernel_avx2(tensor_data_f32(out), tensor_data_f32_const(in), 1, n);
+  } else if (in->dtype == DTYPE_F16) {
+    silu_f16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in), 1, n);
+  } else if (in->dtype == DTYPE_BF16) {
+    silu_bf16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in), 1,
+                          n);
+  }
+}
+
+/* ============================================================================
+ * SiLU-Mul - silu(gate) * up with gate and up in separate buffers
+ * ============================================================================
+ */
+static void avx2_silu_mul(backend_t *backend, tensor_t *out,
+                          const tensor_t *gate, const tensor_t *up) {
+  (void)backend;
+
+  if (!out || !gate || !up)
+    return;
+
+  size_t n = tensor_numel(gate);
+  const float *g = tensor_data_f32_const(gate);
+  const float *u = tensor_data_f32_const(up);
+  float *dst = tensor_data_f32(out);
+
+  /* silu(g) through the vectorized kernel, then scale by up in place */
+  silu_f32_kernel_avx2(dst, g, 1, (int)n);
+
+  size_t i = 0;
+  for (; i + 8 <= n; i += 8) {
+    __m256 s = _mm256_loadu_ps(dst + i);
+    _mm256_storeu_ps(dst + i, _mm256_mul_ps(s, _mm256_loadu_ps(u + i)));
+  }
+  for (; i < n; i++) {
+    dst[i] *= u[i];
+  }
+}
+
+static void avx2_gelu(backend_t *backend, tensor_t *out, const tensor_t *in) {
+  (void)backend;
+
+  if (!out || !in)
+    return;
+
+  int n = (int)tensor_numel(in);
+
+  if (in->dtype == DTYPE_F32) {
+    gelu_f32(tensor_data_f32(out), tensor_data_f32_const(in), 1, n);
+  } else if (in->dtype == DTYPE_F16) {
+    gelu_f16(tensor_data_f16(out), tensor_data_f16_const(in), 1, n);
+  } else if (in->dtype == DTYPE_BF16) {
+    gelu_bf16(tensor_data_f16(out), tensor_data_f16_const(in), 1, n);
+  }
+}
+
+static void avx2_gelu_tanh(backend_t *backend, tensor_t *out,
+                           const tensor_t *in) {
+  (void)backend;
+
+  if (!out || !in)
+    return;
+
+  int n = (int)tensor_numel(in);
+
+  if (in->dtype == DTYPE_F32) {
+    gelu_tanh_f32_kernel_avx2(tensor_data_f32(out), tensor_data_f32_const(in),
+                              1, n);
+  } else if (in->dtype == DTYPE_F16) {
+    gelu_tanh_f16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in),
+                              1, n);
+  } else if (in->dtype == DTYPE_BF16) {
+    gelu_tanh_bf16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in),
+                               1, n);
+  }
+}
+
+static void avx2_rms_norm(backend_t *backend, tensor_t *out, const tensor_t *in,
+                          const tensor_t *weight, float eps) {
+  (void)backend;
+
+  if (!out || !in || !weight)
+    return;
+
+  int num_tokens = (int)tensor_dim(in, 0);
+  int hidden_size = (int)tensor_dim(in, 1);
+
+  if (in->dtype == DTYPE_F32) {
+    rms_norm_f32_kernel_avx2(tensor_data_f32(out), tensor_data_f32_const(in),
+                             tensor_data_f32_const(weight), eps, num_tokens,
+                             hidden_size);
+  } else if (in->dtype == DTYPE_F16) {
+    rms_norm_f16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in),
+                             tensor_data_f16_const(weight), eps, num_tokens,
+                             hidden_size);
+  } else if (in->dtype == DTYPE_BF16) {
+    rms_norm_bf16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in),
+                              tensor_data_f16_const(weight), eps, num_tokens,
+                              hidden_size);
+  }
+}
+
+static void avx2_softmax(backend_t *backend, tensor_t *out, const tensor_t *in,
+                         int axis) {
+  (void)backend;
+  (void)axis;
+
+  if (!out || !in)
+    return;
+
+  int num_rows = (int)tensor_dim(in, 0);
+  int row_size = (int)tensor_dim(in, 1);
+  float scale = 1.0f;
+
+  if (in->dtype == DTYPE_F32) {
+    softmax_f32_kernel_avx2(tensor_data_f32(out), tensor_data_f32_const(in),
+                            num_rows, row_size, scale);
+  } else if (in->dtype == DTYPE_F16) {
+    softmax_f16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in),
+                            num_rows, row_size, scale);
+  } else if (in->dtype == DTYPE_BF16) {
+    softmax_bf16_kernel_avx2(tensor_data_f16(out), tensor_data_f16_const(in),
+                             num_rows, row_size, scale);
+  }
+}
+
+/* ============================================================================
+ * GEMV - Matrix-Vector Multiplication
+ * Computes: y = A @ x where A is [M x K] and x is [K]; runs on the threaded
+ * GEMV kernels, which accumulate in F32 whatever the tensor dtype
+ * ============================================================================
+ */
+static void avx2_gemv(backend_t *backend, const tensor_t *A, const tensor_t *x,
+                      tensor_t *y) {
+  (void)backend;
+
+  if (!A || !x || !y || !A->data || !x->data || !y->data)
+    return;
+
+  gemv_dtype(A->dtype, A->data, x->data, y->data, (int)tensor_dim(A, 0),
+             (int)tensor_dim(A, 1));
+}
+
+/* ============================================================================
+ * Layer Normalization with AVX2
+ * out = (in - mean) / sqrt(var + eps) * weight + bias
+ * ============================================================================
+ */
+static void avx2_layer_norm(backend_t *backend, tensor_t *out,
+                            const tensor_t *in, const tensor_t *weight,
+                            const tensor_t *bias, float eps) {
+  (void)backend;
+
+  if (!out || !in)
+    return;
+
+  int num_tokens = (int)tensor_dim(in, 0);
+  int hidden_size = (int)tensor_dim(in, 1);
+
+  if (in->dtype == DTYPE_F32) {
+    const float *in_data = tensor_data_f32_const(in);
+    float *out_data = tensor_data_f32(out);
+    const float *w_data = weight ? tensor_data_f32_const(weight) : NULL;
+    const float *b_data = bias ? tensor_data_f32_const(bias) : NULL;
+
+    for (int t = 0; t < num_tokens; t++) {
+      const float *row = in_data + (size_t)t * hidden_size;
+      float *out_row = out_data + (size_t)t * hidden_size;
+
+      /* Compute mean */
+      __m256 sum_vec = _mm256_setzero_ps();
+      int i = 0;
+      for (; i + 8 <= hidden_size; i += 8) {
+        sum_vec = _mm256_add_ps(sum_vec, _mm256_loadu_ps(row + i));
+      }
+      float mean = avx2_hsum(sum_vec);
+      for (; i < hidden_size; i++) {
+        mean += row[i];
+      }
+      mean /= (float)hidden_size;
+
+      /* Compute variance */
+      __m256 var_vec = _mm256_setzero_ps();
+      __m256 mean_vec = _mm256_set1_ps(mean);
+      i = 0;
+      for (; i + 8 <= hidden_size; i += 8) {
+        __m256 diff = _mm256_sub_ps(_mm256_loadu_ps(row + i), mean_vec);
+        var_vec = _mm256_fmadd_ps(diff, diff, var_vec);
+      }
+      float var = avx2_hsum(var_vec);
+      for (; i < hidden_size; i++) {
+        float diff = row[i] - mean;
+        var += diff * diff;
+      }
+      var /= (float)hidden_size;
+
+      float inv_std = 1.0f / sqrtf(var + eps);
+      __m256 inv_std_vec = _mm256_set1_ps(inv_std);
+
+      /* Normalize and apply weight/bias */
+      i = 0;
+      for (; i + 8 <= hidden_size; i += 8) {
+        __m256 v = _mm256_loadu_ps(row + i);
+        __m256 norm = _mm256_mul_ps(_mm256_sub_ps(v, mean_vec), inv_std_vec);
+        if (w_data) {
+          norm = _mm256_mul_ps(norm, _mm256_loadu_ps(w_data + i));
+        }
+        if (b_data) {
+          norm = _mm256_add_ps(norm, _mm256_loadu_ps(b_data + i));
+        }
+        _mm256_storeu_ps(out_row + i, norm);
+      }
+      for (; i < hidden_size; i++) {
+        float norm = (row[i] - mean) * inv_std;
+        if (w_data)
+          norm *= w_data[i];
+        if (b_data)
+          norm += b_data[i];
+        out_row[i] = norm;
+      }
+    }
+  } else if (in->dtype == DTYPE_F16 || in->dtype == DTYPE_BF16) {
+    bool is_f16 = in->dtype == DTYPE_F16;
+    const uint16_t *in_data = tensor_data_f16_const(in);
+    uint16_t *out_data = tensor_data_f16(out);
+    const uint16_t *w_data = weight ? tensor_data_f16_const(weight) : NULL;
+    const uint16_t *b_data = bias ? tensor_data_f16_const(bias) : NULL;
+
+    for (int t = 0; t < num_tokens; t++) {
+      const uint16_t *row = in_data + (size_t)t * hidden_size;
+      uint16_t *out_row = out_data + (size_t)t * hidden_size;
+
+      /* Compute mean */
+      __m256 sum_vec = _mm256_setzero_ps();
+      int i = 0;
+      for (; i + 8 <= hidden_size; i += 8) {
+        __m256 v = is_f16 ? avx2_load_f16(row + i) : avx2_load_bf16(row + i);
+        sum_vec = _mm256_add_ps(sum_vec, v);
+      }
+      float mean = avx2_hsum(sum_vec);
+      for (; i < hidden_size; i++) {
+        mean += is_f16 ? f16_to_f32(row[i]) : bf16_to_f32(row[i]);
+      }
+      mean /= (float)hidden_size;
+
+      /* Compute variance */
+      __m256 var_vec = _mm256_setzero_ps();
+      __m256 mean_vec = _mm256_set1_ps(mean);
+      i = 0;
+      for (; i + 8 <= hidden_size; i += 8) {
+        __m256 v = is_f16 ? avx2_load_f16(row + i) : avx2_load_bf16(row + i);
+        __m256 diff = _mm256_sub_ps(v, mean_vec);
+        var_vec = _mm256_fmadd_ps(diff, diff, var_vec);
+      }
+      float var = avx2_hsum(var_vec);
+      for (; i < hidden_size; i++) {
+        float val = is_f16 ? f16_to_f32(row[i]) : bf16_to_f32(row[i]);
+        float diff = val - mean;
+        var += diff * diff;
+      }
+      var /= (float)hidden_size;
+
+      float inv_std = 1.0f / sqrtf(var + eps);
+
+      /* Normalize and apply weight/bias */
+      for (i = 0; i < hidden_size; i++) {
+        float val = is_f16 ? f16_to_f32(row[i]) : bf16_to_f32(row[i]);
+        float norm = (val - mean) * inv_std;
+        if (w_data)
+          norm *= is_f16 ? f16_to_f32(w_data[i]) : bf16_to_f32(w_data[i]);
+        if (b_data)
+          norm += is_f16 ? f16_to_f32(b_data[i]) : bf16_to_f32(b_data[i]);
+        out_row[i] = is_f16 ? f32_to_f16(norm) : f32_to_bf16(norm);
+      }
+    }
+  }
+}
+
+/* ============================================================================
+ * RoPE - Rotary Position Embeddings using AVX2 kernels
+ * ============================================================================
+ */
+static void avx2_rope(backend_t *backend, tensor_t *query, tensor_t *key,
+                      const tensor_t *cos_sin_cache, const int64_t *positions,
+                      int num_heads, int num_kv_heads, int head_dim,
+                      bool is_neox) {
+  (void)backend;
+
+  if (!query || !cos_sin_cache || !positions)
+    return;
+
+  int num_tokens = (int)tensor_dim(query, 0);
+  int rot_dim = head_dim;
+
+  if (query->dtype == DTYPE_F32) {
+    float *q_data = tensor_data_f32(query);
+    float *k_data = key ? tensor_data_f32(key) : NULL;
+    const float *cache = tensor_data_f32_const(cos_sin_cache);
+
+    if (is_neox) {
+      rope_neox_f32_kernel_avx2(positions, q_data, k_data, cache, num_tokens,
+                                num_heads, num_kv_heads, head_dim, rot_dim);
+    } else {
+      rope_gptj_f32_kernel_avx2(positions, q_data, k_data, cache, num_tokens,
+                                num_heads, num_kv_heads, head_dim, rot_dim);
+    }
+  } else if (query->dtype == DTYPE_F16) {
+    uint16_t *q_data = tensor_data_f16(query);
+    uint16_t *k_data = key ? tensor_data_f16(key) : NULL;
+    const uint16_t *cache = tensor_data_f16_const(cos_sin_cache);
+
+    if (is_neox) {
+      rope_neox_f16_kernel_avx2(positions, q_data, k_data, cache, num_tokens,
+                                num_heads, num_kv_heads, head_dim, rot_dim);
+    } else {
+      rope_gptj_f16_kernel_avx2(positions, q_data, k_data, cache, num_tokens,
+                                num_heads, num_kv_heads, head_dim, rot_dim);
+    }
+  } else if (query->dtype == DTYPE_BF16) {
+    uint16_t *q_data = tensor_data_f16(query);
+    uint16_t *k_data = key ? tensor_data_f16(key) : NULL;
+    const uint16_t *cache = tensor_data_f16_const(cos_sin_cache);
+
+    if (is_neox) {
+      rope_neox_bf16_kernel_avx2(positions, q_data, k_data, cache, num_tokens,
+                                 num_heads, num_kv_heads, head_dim, rot_dim);
+    } else {
+      rope_gptj_bf16_kernel_avx2(positions, q_data, k_data, cache, num_tokens,
+                                 num_heads, num_kv_heads, head_dim, rot_dim);
+    }
+  }
+}
+
+/* ============================================================================
+ * Attention - Scaled dot-product attention with KV cache
+ * Uses flash attention for memory efficiency
+ * ============================================================================
+ */
+static void avx2_attention(backend_t *backend, tensor_t *out, const tensor_t *Q,
+                           const tensor_t *K, const tensor_t *V,
+                           tensor_t *key_cache, tensor_t *value_cache,
+                           int cache_len, float scale) {
+  (void)backend;
+
+  if (!out || !Q || !K || !V || !key_cache || !value_cache)
+    return;
+
+  int num_tokens = (int)tensor_dim(Q, 0);
+  int num_heads = (int)tensor_dim(Q, 1);
+  int head_dim = (int)tensor_dim(Q, 2);
+  int num_kv_heads = (int)tensor_dim(K, 1);
+  int seq_len_kv = cache_len + num_tokens;
+
+  /* First, append new K/V to caches */
+  if (Q->dtype == DTYPE_F32) {
+    kv_cache_append_f32(tensor_data_f32(key_cache),
+                        tensor_data_f32(value_cache), tensor_data_f32_const(K),
+                        tensor_data_f32_const(V), cache_len, num_tokens,
+                        num_kv_heads, head_dim);
+  } else if (Q->dtype == DTYPE_F16) {
+    kv_cache_append_f16(tensor_data_f16(key_cache),
+                        tensor_data_f16(value_cache), tensor_data_f16_const(K),
+                        tensor_data_f16_const(V), cache_len, num_tokens,
+                        num_kv_heads, head_dim);
+  } else if (Q->dtype == DTYPE_BF16) {
+    kv_cache_append_bf16(tensor_data_f16(key_cache),
+                         tensor_data_f16(value_cache), tensor_data_f16_const(K),
+                         tensor_data_f16_const(V), cache_len, num_tokens,
+                         num_kv_heads, head_dim);
+  }
+
+  /* Compute attention for each head */
+  int heads_per_kv = num_heads / num_kv_heads;
+
+  if (Q->dtype == DTYPE_F32) {
+    const float *q_data = tensor_data_f32_const(Q);
+    const float *k_cache = tensor_data_f32_const(key_cache);
+    const float *v_cache = tensor_data_f32_const(value_cache);
+    float *out_data = tensor_data_f32(out);
+
+    for (int h = 0; h < num_heads; h++) {
+      int kv_h = h / heads_per_kv;
+
+      const float *q = q_data + h * num_tokens * head_dim;
+      const float *k = k_cache + kv_h * seq_len_kv * head_dim;
+      const float *v = v_cache + kv_h * seq_len_kv * head_dim;
+      float *o = out_data + h * num_tokens * head_dim;
+
+      flash_attention_f32(o, q, k, v, num_tokens, seq_len_kv, head_dim, scale,
+                          NULL);
+    }
+  } else if (Q->dtype == DTYPE_F16) {
+    const uint16_t *q_data = tensor_data_f16_const(Q);
+    const uint16_t *k_cache = tensor_data_f16_const(key_cache);
+    const uint16_t *v_cache = tensor_data_f16_const(value_cache);
+    uint16_t *out_data = tensor_data_f16(out);
+
+    for (int h = 0; h < num_heads; h++) {
+      int kv_h = h / heads_per_kv;
+
+      const uint16_t *q = q_data + h * num_tokens * head_dim;
+      const uint16_t *k = k_cache + kv_h * seq_len_kv * head_dim;
+      const uint16_t *v = v_cache + kv_h * seq_len_kv * head_dim;
+      uint16_t *o = out_data + h * num_tokens * head_dim;
+
+      flash_attention_f16(o, q, k, v, num_tokens, seq_len_kv, head_dim, scale,
+                          NULL);
+    }
+  } else if (Q->dtype == DTYPE_BF16) {
+    const uint16_t *q_data = tensor_data_f16_const(Q);
+    const uint16_t *k_cache = tensor_data_f16_const(key_cache);
+    const uint16_t *v_cache = tensor_data_f16_const(value_cache);
+    uint16_t *out_data = tensor_data_f16(out);
+
+    for (int h = 0; h < num_heads; h++) {
+      int kv_h = h / heads_per_kv;
+
+      const uint16_t *q = q_data + h * num_tokens * head_dim;
+      const uint16_t *k = k_cache + kv_h * seq_len_kv * head_dim;
+      const uint16_t *v = v_cache + kv_h * seq_len_kv * head_dim;
+      uint16_t *o = out_data + h * num_tokens * head_dim;
+
+      flash_attention_bf16(o, q, k, v, num_tokens, seq_len_kv, head_dim, scale,
+                           NULL);
+    }
+  }
+}
+
+/* ============================================================================
+ * Sample - Token sampling from logits using AVX2 kernel
+ * ============================================================================
+ */
+static int avx2_sample(backend_t *backend, const tensor_t *logits,
+                       float temperature, int top_k, float top_p, void *rng) {
+  (void)backend;
+
+  if (!logits)
+    return 0;
+
+  int vocab_size = (int)tensor_numel(logits);
+
+  if (logits->dtype == DTYPE_F32) {
+    const float *logits_data = tensor_data_f32_const(logits);
+    return sampling_sample_f32_kernel_avx2(logits_data, vocab_size,
+                                           temperature, top_k, top_p, 0.0f,
+                                           (unsigned long long *)rng);
+  } else if (logits->dtype == DTYPE_F16 || logits->dtype == DTYPE_BF16) {
+    /* Widen 16-bit logits to F32 for sampling */
+    const uint16_t *logits_h = tensor_data_f16_const(logits);
+    float *logits_f32 = (float *)malloc(vocab_size * sizeof(float));
+    if (!logits_f32)
+      return 0;
+
+    bool is_f16 = logits->dtype == DTYPE_F16;
+    int i = 0;
+    for (; i + 8 <= vocab_size; i += 8) {
+      __m256 v = is_f16 ? avx2_load_f16(logits_h + i)
+                        : avx2_load_bf16(logits_h + i);
+      _mm256_storeu_ps(logits_f32 + i, v);
+    }
+    for (; i < vocab_size; i++) {
+      logits_f32[i] =
+          is_f16 ? f16_to_f32(logits_h[i]) : bf16_to_f32(logits_h[i]);
+    }
+
+    int token = sampling_sample_f32_kernel_avx2(
+        logits_f32, vocab_size, temperature, top_k, top_p, 0.0f,
+        (unsigned long long *)rng);
+    free(logits_f32);
+    return token;
+  }
+
+  return 0;
+}
+
+/* ============================================================================
+ * Embedding Lookup
+ * ============================================================================
+ */
+static void avx2_embedding_lookup(backend_t *backend, tensor_t *out,
+                                  const tensor_t *weight,
+                                  const int64_t *indices, int num_indices) {
+  (void)backend;
+
+  if (!out || !weight || !indices)
+    return;
+
+  int vocab_size = (int)tensor_dim(weight, 0);
+  int embedding_dim = (int)tensor_dim(weight, 1);
+
+  if (weight->dtype == DTYPE_F32) {
+    embedding_lookup_f32(tensor_data_f32(out), indices,
+                         tensor_data_f32_const(weight), num_indices,
+                         vocab_size, embedding_dim, -1);
+  } else if (weight->dtype == DTYPE_F16) {
+    embedding_lookup_f16(tensor_data_f16(out), indices,
+                         tensor_data_f16_const(weight), num_indices,
+                         vocab_size, embedding_dim, -1);
+  } else if (weight->dtype == DTYPE_BF16) {
+    embedding_lookup_bf16(tensor_data_f16(out), indices,
+                          tensor_data_f16_const(weight), num_indices,
+                          vocab_size, embedding_dim, -1);
+  }
+}
+
+/* ============================================================================
+ * KV Cache Update
+ * ============================================================================
+ */
+static int avx2_kv_cache_update(backend_t *backend, tensor_t *key_cache,
+                                tensor_t *value_cache, const tensor_t *new_keys,
+                                const tensor_t *new_values, int cache_len) {
+  (void)backend;
+
+  if (!key_cache || !value_cache || !new_keys || !new_values)
+    return cache_len;
+
+  int num_tokens = (int)tensor_dim(new_keys, 0);
+  int num_heads = (int)tensor_dim(new_keys, 1);
+  int head_dim = (int)tensor_dim(new_keys, 2);
+
+  if (new_keys->dtype == DTYPE_F32) {
+    kv_cache_append_f32(
+        tensor_data_f32(key_cache), tensor_data_f32(value_cache),
+        tensor_data_f32_const(new_keys), tensor_data_f32_const(new_values),
+        cache_len, num_tokens, num_heads, head_dim);
+  } else if (new_keys->dtype == DTYPE_F16) {
+    kv_cache_append_f16(
+        tensor_data_f16(key_cache), tensor_data_f16(value_cache),
+        tensor_data_f16_const(new_keys), tensor_data_f16_const(new_values),
+        cache_len, num_tokens, num_heads, head_dim);
+  } else if (new_keys->dtype == DTYPE_BF16) {
+    kv_cache_append_bf16(
+        tensor_data_f16(key_cache), tensor_data_f16(value_cache),
+        tensor_data_f16_const(new_keys), tensor_data_f16_const(new_values),
+        cache_len, num_tokens, num_heads, head_dim);
+  }
+
+  return cache_len + num_tokens;
+}
+
+static const backend_ops_t avx2_ops = {
+    .name = "avx2",
+    .capability = CAP_AVX2,
+    .init = avx2_init,
+    .destroy = avx2_destroy,
+    .gemm = avx2_gemm,
+    .gemv = avx2_gemv,
+    .silu = avx2_silu,
+    .silu_mul = avx2_silu_mul,
+    .gelu = avx2_gelu,
+    .gelu_tanh = avx2_gelu_tanh,
+    .rms_norm = avx2_rms_norm,
+    .layer_norm = avx2_layer_norm,
+    .rope = avx2_rope,
+    .attention = avx2_attention,
+    .softmax = avx2_softmax,
+    .sample = avx2_sample,
+    .embedding_lookup = avx2_embedding_lookup,
+    .kv_cache_update = avx2_kv_cache_update,
+};
+
+const backend_ops_t *avx2_backend_ops(void) { return &avx2_ops; }
+
+__attribute__((constructor)) static void register_avx2_backend(void) {
+  backend_register(&avx2_ops);
+}
+
+#else
+
+const backend_ops_t *avx2_backend_ops(void) { return NULL; }
+
+#endif
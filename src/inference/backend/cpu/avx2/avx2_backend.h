@@ -0,0 +1,16 @@
+#ifndef INFERENCE_BACKEND_CPU_AVX2_H
+#define INFERENCE_BACKEND_CPU_AVX2_H
+
+#include "inference/backend/backend.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+const backend_ops_t *avx2_backend_ops(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,118 @@
+#include "inference/backend/cpu/avx512/avx512_backend.h"
+#include "inference/backend/cpu/avx2/avx2_backend.h"
+#include "inference/backend/registry.h"
+
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+
+#include "inference/core/dtype.h"
+#include "inference/kernels/gemm/gemm_kernels.h"
+#include "inference/kernels/gemv/gemv.h"
+
+/*
+ * The AVX-512 tier overrides the compute-bound ops (GEMM/GEMV). Elementwise,
+ * norm, rope, attention and sampling ops are memory-bound at these sizes and
+ * are inherited from the AVX2 backend when the ops table is registered.
+ */
+
+static void avx512_gemm(backend_t *backend, const tensor_t *A,
+                        const tensor_t *B, tensor_t *C, bool transpose_A,
+                        bool transpose_B) {
+  if (!A || !B || !C || !A->data || !B->data || !C->data)
+    return;
+
+  /* The AVX2 op covers the transposed layouts */
+  if (transpose_A || transpose_B) {
+    avx2_backend_ops()->gemm(backend, A, B, C, transpose_A, transpose_B);
+    return;
+  }
+
+  int M = (int)tensor_dim(C, 0);
+  int N = (int)tensor_dim(C, 1);
+  int K = (int)tensor_dim(A, 1);
+  int num_threads = backend ? backend->num_threads : 1;
+  bool packed = M >= GEMM_AVX512_PACK_MIN_M;
+
+  if (A->dtype == DTYPE_F32) {
+    const float *a = tensor_data_f32_const(A);
+    const float *b = tensor_data_f32_const(B);
+    float *c = tensor_data_f32(C);
+
+    if (packed) {
+      gemm_f32_kernel_avx512_packed(a, b, c, M, N, K, false, false,
+                                    num_threads);
+    } else {
+      gemm_f32_kernel_avx512(a, b, c, M, N, K);
+    }
+  } else if (A->dtype == DTYPE_F16) {
+    const uint16_t *a = tensor_data_f16_const(A);
+    const uint16_t *b = tensor_data_f16_const(B);
+    uint16_t *c = tensor_data_f16(C);
+
+    if (packed) {
+      gemm_f16_kernel_avx512_packed(a, b, c, M, N, K, num_threads);
+    } else {
+      gemm_f16_kernel_avx512(a, b, c, M, N, K);
+    }
+  } else if (A->dtype == DTYPE_BF16) {
+    const uint16_t *a = tensor_data_f16_const(A);
+    const uint16_t *b = tensor_data_f16_const(B);
+    uint16_t *c = tensor_data_f16(C);
+
+    if (packed) {
+      gemm_bf16_kernel_avx512_packed(a, b, c, M, N, K, num_threads);
+    } else {
+      gemm_bf16_kernel_avx512(a, b, c, M, N, K);
+    }
+  }
+}
+
+/* ============================================================================
+ * GEMV - Matrix-Vector Multiplication with AVX-512
+ * Computes: y = A @ x where A is [M x K] and x is [K]; the threaded GEMV
+ * picks its zmm kernels on this tier, with vdpbf16ps for BF16 weights when
+ * the host has AVX512_BF16
+ * ============================================================================
+ */
+static void avx512_gemv(backend_t *backend, const tensor_t *A,
+                        const tensor_t *x, tensor_t *y) {
+  (void)backend;
+
+  if (!A || !x || !y || !A->data || !x->data || !y->data)
+    return;
+
+  gemv_dtype(A->dtype, A->data, x->data, y->data, (int)tensor_dim(A, 0),
+             (int)tensor_dim(A, 1));
+}
+
+/* Filled at registration: AVX2 ops with the AVX-512 overrides applied */
+static backend_ops_t avx512_ops;
+
+const backend_ops_t *avx512_backend_ops(void) {
+  return avx512_ops.name ? &avx512_ops : NULL;
+}
+
+/*
+ * This file is built with AVX-512 enabled, so nothing here may run before the
+ * CPUID check: the struct copy below is free to use zmm moves.
+ */
+__attribute__((constructor)) static void register_avx512_backend(void) {
+  if (!caps_has(CAP_AVX512))
+    return;
+
+  const backend_ops_t *base = avx2_backend_ops();
+  if (!base)
+    return;
+
+  avx512_ops = *base;
+  avx512_ops.name = "avx512";
+  avx512_ops.capability = CAP_AVX512;
+  avx512_ops.gemm = avx512_gemm;
+  avx512_ops.gemv = avx512_gemv;
+  backend_register(&avx512_ops);
+}
+
+#else
+
+const backend_ops_t *avx512_backend_ops(void) { return NULL; }
+
+#endif
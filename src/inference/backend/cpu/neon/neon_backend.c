@@ -8,6 +8,7 @@
 #include "inference/kernels/attention/attention.h"
 #include "inference/kernels/embedding/embedding_kernels.h"
 #include "inference/kernels/gemm/gemm_kernels.h"
+#include "inference/kernels/gemv/gemv.h"
 #include "inference/kernels/kv_cache/kv_cache_kernels.h"
 #include "inference/kernels/norm/layernorm_kernels.h"
 #include "inference/kernels/rope/rope_kernels.h"
@@ -235,8 +236,9 @@ static void neon_softmax(backend_t *backend, tensor_t *out, const tensor_t *in,
 }
 
 /* ============================================================================
- * GEMV - Matrix-Vector Multiplication with NEON
- * Computes: y = A @ x where A is [M x K] and x is [K]
+ * GEMV - Matrix-Vector Multiplication
+ * Computes: y = A @ x where A is [M x K] and x is [K]; runs on the threaded
+ * GEMV kernels, which accumulate in F32 whatever the tensor dtype
  * ============================================================================
  */
 static void neon_gemv(backend_t *backend, const tensor_t *A, const tensor_t *x,
@@ -246,110 +248,8 @@ static void neon_gemv(backend_t *backend, const tensor_t *A, const tensor_t *x,
   if (!A || !x || !y || !A->data || !x->data || !y->data)
     return;
 
-  int M = (int)tensor_dim(A, 0);
-  int K = (int)tensor_dim(A, 1);
-
-  if (A->dtype == DTYPE_F32) {
-    const float *a_data = tensor_data_f32_const(A);
-    const float *x_data = tensor_data_f32_const(x);
-    float *y_data = tensor_data_f32(y);
-
-    for (int m = 0; m < M; m++) {
-      const float *row = a_data + m * K;
-      float32x4_t sum_vec = vdupq_n_f32(0.0f);
-
-      int k = 0;
-      for (; k + 16 <= K; k += 16) {
-        float32x4_t a0 = vld1q_f32(row + k);
-        float32x4_t a1 = vld1q_f32(row + k + 4);
-        float32x4_t a2 = vld1q_f32(row + k + 8);
-        float32x4_t a3 = vld1q_f32(row + k + 12);
-        float32x4_t x0 = vld1q_f32(x_data + k);
-        float32x4_t x1 = vld1q_f32(x_data + k + 4);
-        float32x4_t x2 = vld1q_f32(x_data + k + 8);
-        float32x4_t x3 = vld1q_f32(x_data + k + 12);
-        sum_vec = vmlaq_f32(sum_vec, a0, x0);
-        sum_vec = vmlaq_f32(sum_vec, a1, x1);
-        sum_vec = vmlaq_f32(sum_vec, a2, x2);
-        sum_vec = vmlaq_f32(sum_vec, a3, x3);
-      }
-      for (; k + 4 <= K; k += 4) {
-        float32x4_t a_v = vld1q_f32(row + k);
-        float32x4_t x_v = vld1q_f32(x_data + k);
-        sum_vec = vmlaq_f32(sum_vec, a_v, x_v);
-      }
-
-      float sum = vaddvq_f32(sum_vec);
-      for (; k < K; k++) {
-        sum += row[k] * x_data[k];
-      }
-      y_data[m] = sum;
-    }
-  } else if (A->dtype == DTYPE_F16) {
-    const uint16_t *a_data = tensor_data_f16_const(A);
-    const uint16_t *x_data = tensor_data_f16_const(x);
-    uint16_t *y_data = tensor_data_f16(y);
-
-    for (int m = 0; m < M; m++) {
-      const uint16_t *row = a_data + m * K;
-      float32x4_t sum_vec = vdupq_n_f32(0.0f);
-
-      int k = 0;
-      for (; k + 8 <= K; k += 8) {
-        float16x8_t a_h = vld1q_f16((const float16_t *)(row + k));
-        float16x8_t x_h = vld1q_f16((const float16_t *)(x_data + k));
-        float32x4_t a_lo = vcvt_f32_f16(vget_low_f16(a_h));
-        float32x4_t a_hi = vcvt_f32_f16(vget_high_f16(a_h));
-        float32x4_t x_lo = vcvt_f32_f16(vget_low_f16(x_h));
-        float32x4_t x_hi = vcvt_f32_f16(vget_high_f16(x_h));
-        sum_vec = vmlaq_f32(sum_vec, a_lo, x_lo);
-        sum_vec = vmlaq_f32(sum_vec, a_hi, x_hi);
-      }
-      for (; k + 4 <= K; k += 4) {
-        float16x4_t a_h = vld1_f16((const float16_t *)(row + k));
-        float16x4_t x_h = vld1_f16((const float16_t *)(x_data + k));
-        float32x4_t a_f = vcvt_f32_f16(a_h);
-        float32x4_t x_f = vcvt_f32_f16(x_h);
-        sum_vec = vmlaq_f32(sum_vec, a_f, x_f);
-      }
-
-      float sum = vaddvq_f32(sum_vec);
-      for (; k < K; k++) {
-        sum += f16_to_f32(row[k]) * f16_to_f32(x_data[k]);
-      }
-      y_data[m] = f32_to_f16(sum);
-    }
-  } else if (A->dtype == DTYPE_BF16) {
-    const uint16_t *a_data = tensor_data_f16_const(A);
-    const uint16_t *x_data = tensor_data_f16_const(x);
-    uint16_t *y_data = tensor_data_f16(y);
-
-    for (int m = 0; m < M; m++) {
-      const uint16_t *row = a_data + m * K;
-      float32x4_t sum_vec = vdupq_n_f32(0.0f);
-
-      int k = 0;
-      for (; k + 4 <= K; k += 4) {
-        float a0 = bf16_to_f32(row[k]);
-        float a1 = bf16_to_f32(row[k + 1]);
-        float a2 = bf16_to_f32(row[k + 2]);
-        float a3 = bf16_to_f32(row[k + 3]);
-        float x0 = bf16_to_f32(x_data[k]);
-        float x1 = bf16_to_f32(x_data[k + 1]);
-        float x2 = bf16_to_f32(x_data[k + 2]);
-        float x3 = bf16_to_f32(x_data[k + 3]);
-        float32x4_t a_v = {a0, a1, a2, a3};
-        float32x4_t x_v = {x0, x1, x2, x3};
-        sum_vec = vmlaq_f32(sum_vec, a_v, x_v);
-      }
-
-      float sum = vaddvq_f32(sum_vec);
-      for (; k < K; k++) {
-        sum += bf16_to_f32(row[k]) * bf16_to_f32(x_data[k]);
-      }
-      y_data[m] = f32_to_bf16(sum);
-    }
-  }
+  gemv_dtype(A->dtype, A->data, x->data, y->data, (int)tensor_dim(A, 0),
+             (int)tensor_dim(A, 1));
 }
 
 /* ============================================================================
@@ -1,6 +1,7 @@
 #include "inference/backend/cpu/scalar/scalar_backend.h"
 #include "inference/backend/registry.h"
 #include "inference/core/dtype.h"
+#include "inference/kernels/gemv/gemv.h"
 #include <math.h>
 #include <stdlib.h>
 #include <string.h>
@@ -87,23 +88,11 @@ static void scalar_gemv(backend_t *backend, const tensor_t *A,
                         const tensor_t *x, tensor_t *y) {
   (void)backend;
 
-  if (!A || !x || !y)
+  if (!A || !x || !y || !A->data || !x->data || !y->data)
     return;
 
-  int M = (int)tensor_dim(A, 0);
-  int K = (int)tensor_dim(A, 1);
-
-  const float *a = tensor_data_f32_const(A);
-  const float *xv = tensor_data_f32_const(x);
-  float *yv = tensor_data_f32(y);
-
-  for (int i = 0; i < M; i++) {
-    float sum = 0.0f;
-    for (int k = 0; k < K; k++) {
-      sum += a[i * K + k] * xv[k];
-    }
-    yv[i] = sum;
-  }
+  gemv_dtype(A->dtype, A->data, x->data, y->data, (int)tensor_dim(A, 0),
+             (int)tensor_dim(A, 1));
 }
 
 static void scalar_silu(backend_t *backend, tensor_t *out, const tensor_t *in) {
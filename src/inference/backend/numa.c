@@ -0,0 +1,67 @@
+/**
+ * @file numa.c
+ * @brief Implementation of NUMA weight placement.
+ */
+
+#include "inference/backend/numa.h"
+#include "inference/backend/caps.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#if defined(__linux__) && defined(SYS_mbind)
+#define NUMA_HAVE_MBIND 1
+#else
+#define NUMA_HAVE_MBIND 0
+#endif
+
+/* From <linux/mempolicy.h>, which is not always installed */
+#define NUMA_MPOL_INTERLEAVE 3
+#define NUMA_MPOL_MF_MOVE (1 << 1)
+
+/* Highest kernel node id the policy mask covers, plus one */
+#define NUMA_MASK_BITS 1024
+
+numa_placement_t numa_weight_placement(void) {
+  const char *mode = getenv("SILLYTUI_NUMA");
+  if (mode && strcmp(mode, "off") == 0)
+    return NUMA_PLACEMENT_NONE;
+  if (mode && strcmp(mode, "interleave") == 0)
+    return NUMA_PLACEMENT_INTERLEAVE;
+  return caps_get()->num_numa_nodes > 1 ? NUMA_PLACEMENT_INTERLEAVE
+                                        : NUMA_PLACEMENT_NONE;
+}
+
+bool numa_interleave(const void *addr, size_t len) {
+#if NUMA_HAVE_MBIND
+  const system_caps_t *caps = caps_get();
+  if (!addr || len == 0 || caps->num_numa_nodes < 2)
+    return false;
+
+  unsigned long mask[NUMA_MASK_BITS / (8 * sizeof(unsigned long))];
+  memset(mask, 0, sizeof(mask));
+  const size_t bits = 8 * sizeof(unsigned long);
+  for (int n = 0; n < caps->num_numa_nodes; n++) {
+    int id = caps_numa_node_id(n);
+    if (id >= 0 && id < NUMA_MASK_BITS)
+      mask[id / bits] |= 1UL << (id % bits);
+  }
+
+  uintptr_t page = (uintptr_t)sysconf(_SC_PAGESIZE);
+  uintptr_t start = (uintptr_t)addr & ~(page - 1);
+  size_t span = (size_t)((uintptr_t)addr + len - start);
+  /* The kernel reads maxnode - 1 bits of the mask */
+  return syscall(SYS_mbind, (void *)start, span, NUMA_MPOL_INTERLEAVE, mask,
+                 (unsigned long)NUMA_MASK_BITS + 1,
+                 (unsigned)NUMA_MPOL_MF_MOVE) == 0;
+#else
+  (void)addr;
+  (void)len;
+  return false;
+#endif
+}
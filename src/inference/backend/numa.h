@@ -0,0 +1,56 @@
+/**
+ * @file numa.h
+ * @brief Placement of model weights across NUMA nodes.
+ *
+ * Decode streams every weight once per token, and the thread pool spreads
+ * each matrix over every socket. Left where first touch put them, the
+ * weights sit on one node: that node's memory controller serves all of the
+ * reads, and the other sockets pull theirs across the interconnect.
+ * Interleaving the weight pages over the nodes spreads the traffic over
+ * every controller. The policy is set with the mbind system call directly,
+ * so libnuma is not needed.
+ */
+
+#ifndef INFERENCE_BACKEND_NUMA_H
+#define INFERENCE_BACKEND_NUMA_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Where model weights are placed.
+ */
+typedef enum {
+  NUMA_PLACEMENT_NONE = 0,   /**< Leave pages where first touch put them */
+  NUMA_PLACEMENT_INTERLEAVE, /**< Spread pages round-robin over the nodes */
+} numa_placement_t;
+
+/**
+ * Get the weight placement: SILLYTUI_NUMA=interleave or off, and otherwise
+ * interleaved on hosts with more than one NUMA node.
+ *
+ * @return Placement mode
+ */
+numa_placement_t numa_weight_placement(void);
+
+/**
+ * Interleave the pages of a range over every NUMA node with CPUs. Pages
+ * already in memory are migrated. The range is widened to whole pages, so
+ * neighbouring data on the same pages is moved too.
+ *
+ * @param addr Start of the range
+ * @param len Bytes in the range
+ * @return true if the policy was applied; false on a single node, on
+ *         platforms without mbind, or if the kernel refused
+ */
+bool numa_interleave(const void *addr, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFERENCE_BACKEND_NUMA_H */
@@ -150,7 +150,8 @@ backend_t *backend_create(cap_t preferred) {
     return NULL;
 
   backend->ops = ops;
-  backend->num_threads = caps_num_threads();
+  backend->pool = threadpool_global();
+  backend->num_threads = threadpool_size(backend->pool);
   backend->preferred_dtype = DTYPE_F32;
 
   /* Initialize if ops has init function */
@@ -200,17 +201,14 @@ void backend_set_num_threads(backend_t *backend, int num_threads) {
   if (!backend)
     return;
 
-  if (num_threads <= 0) {
-    backend->num_threads = caps_num_threads();
-  } else {
-    backend->num_threads = num_threads;
-  }
+  threadpool_set_num_threads(num_threads);
+  backend->num_threads = threadpool_size(backend->pool);
 }
 
 int backend_get_num_threads(const backend_t *backend) {
   if (!backend)
     return 1;
-  return backend->num_threads;
+  return threadpool_size(backend->pool);
 }
 
 /* ============================================================================
@@ -226,6 +224,13 @@ void backend_gemm(const tensor_t *A, const tensor_t *B, tensor_t *C,
   }
 }
 
+void backend_gemv(const tensor_t *A, const tensor_t *x, tensor_t *y) {
+  backend_t *backend = backend_default();
+  if (backend && backend->ops && backend->ops->gemv) {
+    backend->ops->gemv(backend, A, x, y);
+  }
+}
+
 void backend_rms_norm(tensor_t *out, const tensor_t *in, const tensor_t *weight,
                       float eps) {
   backend_t *backend = backend_default();
@@ -0,0 +1,389 @@
+/*
+ * Persistent Thread Pool - fork/join parallel-for shared by all kernels
+ *
+ * Each worker owns a mailbox (a generation counter) that the dispatcher
+ * bumps when the worker has a chunk of the current job. Workers poll their
+ * mailbox for spin_us before parking on the pool's condition variable, so a
+ * decode step that issues dozens of small kernels back to back keeps the
+ * workers hot, while an idle pool (between tokens, waiting on the UI) stops
+ * burning cores.
+ *
+ * On a multi-socket host the pinned participants are split into one block
+ * per NUMA node. A job's chunks are contiguous, so each socket works on
+ * one contiguous part of every matrix.
+ */
+
+#include "inference/backend/threadpool.h"
+#include "inference/backend/caps.h"
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define THREADPOOL_MAX_THREADS 64
+
+/* Roughly the gap between two decode steps on a small model */
+#define THREADPOOL_DEFAULT_SPIN_US 200
+
+typedef struct {
+  threadpool_fn_t fn;
+  void *arg;
+  int start;
+  int end;
+  int chunk;
+} threadpool_job_t;
+
+typedef struct {
+  alignas(64) atomic_uint mailbox;
+  threadpool_t *pool;
+  pthread_t thread;
+  int index; /* participant index; the dispatching thread is 0 */
+} threadpool_worker_t;
+
+struct threadpool {
+  threadpool_worker_t *workers;
+  int num_workers;
+  int num_threads;
+  atomic_int spin_us;
+  bool pin;
+  int pin_threads; /* Participants the CPUs are divided among */
+
+  threadpool_job_t job;
+  alignas(64) atomic_int pending;
+  atomic_int sleepers;
+  atomic_int shutdown;
+
+  pthread_mutex_t park_mutex;
+  pthread_cond_t park_cond;
+  pthread_mutex_t dispatch_mutex;
+};
+
+static _Thread_local bool tls_in_job = false;
+
+static inline void cpu_relax(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  __builtin_ia32_pause();
+#elif defined(__aarch64__)
+  __asm__ __volatile__("yield");
+#endif
+}
+
+static uint64_t now_us(void) {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+#if defined(__linux__)
+/*
+ * Pin participant `index` of `num_threads` to a CPU of the inherited mask:
+ * the index-th one on a single node. When the mask spans several NUMA
+ * nodes, participants form one contiguous block per node (rather than
+ * filling the lowest-numbered node first) and take that node's CPUs in
+ * order.
+ */
+static void pin_current_thread(int index, int num_threads) {
+  cpu_set_t allowed;
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    return;
+
+  int count = CPU_COUNT(&allowed);
+  if (count <= 1)
+    return;
+
+  int node = -1;
+  int target = index % count;
+  if (caps_get()->num_numa_nodes > 1) {
+    int per_node[CAPS_MAX_NUMA_NODES] = {0};
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed))
+        per_node[caps_numa_node_of_cpu(cpu)]++;
+    }
+    int active[CAPS_MAX_NUMA_NODES];
+    int num_active = 0;
+    for (int n = 0; n < caps_get()->num_numa_nodes; n++) {
+      if (per_node[n] > 0)
+        active[num_active++] = n;
+    }
+    if (num_active > 1 && index < num_threads) {
+      int block = index * num_active / num_threads;
+      int first = (block * num_threads + num_active - 1) / num_active;
+      node = active[block];
+      target = (index - first) % per_node[node];
+    }
+  }
+
+  for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+    if (!CPU_ISSET(cpu, &allowed))
+      continue;
+    if (node >= 0 && caps_numa_node_of_cpu(cpu) != node)
+      continue;
+    if (target-- == 0) {
+      cpu_set_t one;
+      CPU_ZERO(&one);
+      CPU_SET(cpu, &one);
+      pthread_setaffinity_np(pthread_self(), sizeof(one), &one);
+      return;
+    }
+  }
+}
+#else
+static void pin_current_thread(int index, int num_threads) {
+  (void)index;
+  (void)num_threads;
+}
+#endif
+
+static void run_chunk(const threadpool_job_t *job, int index) {
+  int lo = job->start + index * job->chunk;
+  int hi = lo + job->chunk;
+  if (hi > job->end)
+    hi = job->end;
+  if (lo < hi)
+    job->fn(job->arg, lo, hi);
+}
+
+/* Spin on the mailbox, then park; returns the new mailbox value */
+static unsigned wait_for_work(threadpool_worker_t *w, unsigned seen) {
+  threadpool_t *pool = w->pool;
+  int spin_us = atomic_load_explicit(&pool->spin_us, memory_order_relaxed);
+
+  if (spin_us > 0) {
+    uint64_t deadline = now_us() + (uint64_t)spin_us;
+    for (unsigned iter = 1;; iter++) {
+      unsigned cur = atomic_load_explicit(&w->mailbox, memory_order_acquire);
+      if (cur != seen || atomic_load(&pool->shutdown))
+        return cur;
+      cpu_relax();
+      if ((iter & 255) == 0 && now_us() >= deadline)
+        break;
+    }
+  }
+
+  pthread_mutex_lock(&pool->park_mutex);
+  atomic_fetch_add(&pool->sleepers, 1);
+  while (atomic_load(&w->mailbox) == seen && !atomic_load(&pool->shutdown))
+    pthread_cond_wait(&pool->park_cond, &pool->park_mutex);
+  atomic_fetch_sub(&pool->sleepers, 1);
+  pthread_mutex_unlock(&pool->park_mutex);
+
+  return atomic_load_explicit(&w->mailbox, memory_order_acquire);
+}
+
+static void *worker_main(void *arg) {
+  threadpool_worker_t *w = (threadpool_worker_t *)arg;
+  threadpool_t *pool = w->pool;
+
+  if (pool->pin)
+    pin_current_thread(w->index, pool->pin_threads);
+  tls_in_job = true;
+
+  /* Not the current mailbox value: a job may already have been posted */
+  unsigned seen = 0;
+  for (;;) {
+    seen = wait_for_work(w, seen);
+    if (atomic_load(&pool->shutdown))
+      break;
+
+    run_chunk(&pool->job, w->index);
+    atomic_fetch_sub_explicit(&pool->pending, 1, memory_order_release);
+  }
+  return NULL;
+}
+
+static int clamp_threads(int num_threads) {
+  if (num_threads <= 0)
+    num_threads = caps_num_threads();
+  if (num_threads > THREADPOOL_MAX_THREADS)
+    num_threads = THREADPOOL_MAX_THREADS;
+  return num_threads < 1 ? 1 : num_threads;
+}
+
+static bool start_workers(threadpool_t *pool, int num_threads) {
+  /* Spinning or pinning more threads than cores only steals their time */
+  bool oversubscribed = num_threads > caps_get()->num_cpus;
+  atomic_store(&pool->spin_us,
+               oversubscribed ? 0 : THREADPOOL_DEFAULT_SPIN_US);
+  atomic_store(&pool->shutdown, 0);
+  pool->pin = !oversubscribed;
+  pool->pin_threads = num_threads;
+  pool->num_workers = 0;
+  pool->num_threads = 1;
+
+  int num_workers = num_threads - 1;
+  if (num_workers <= 0)
+    return true;
+
+  pool->workers = (threadpool_worker_t *)aligned_alloc(
+      64, ((num_workers * sizeof(threadpool_worker_t) + 63) / 64) * 64);
+  if (!pool->workers)
+    return false;
+
+  for (int i = 0; i < num_workers; i++) {
+    threadpool_worker_t *w = &pool->workers[i];
+    atomic_init(&w->mailbox, 0);
+    w->pool = pool;
+    w->index = i + 1;
+    if (pthread_create(&w->thread, NULL, worker_main, w) != 0)
+      break;
+    pool->num_workers++;
+  }
+  pool->num_threads = pool->num_workers + 1;
+  return true;
+}
+
+static void stop_workers(threadpool_t *pool) {
+  pthread_mutex_lock(&pool->park_mutex);
+  atomic_store(&pool->shutdown, 1);
+  pthread_cond_broadcast(&pool->park_cond);
+  pthread_mutex_unlock(&pool->park_mutex);
+
+  for (int i = 0; i < pool->num_workers; i++)
+    pthread_join(pool->workers[i].thread, NULL);
+
+  free(pool->workers);
+  pool->workers = NULL;
+  pool->num_workers = 0;
+  pool->num_threads = 1;
+}
+
+threadpool_t *threadpool_create(int num_threads) {
+  threadpool_t *pool = (threadpool_t *)calloc(1, sizeof(threadpool_t));
+  if (!pool)
+    return NULL;
+
+  pthread_mutex_init(&pool->park_mutex, NULL);
+  pthread_cond_init(&pool->park_cond, NULL);
+  pthread_mutex_init(&pool->dispatch_mutex, NULL);
+  atomic_init(&pool->pending, 0);
+  atomic_init(&pool->sleepers, 0);
+  atomic_init(&pool->shutdown, 0);
+  atomic_init(&pool->spin_us, 0);
+
+  if (!start_workers(pool, clamp_threads(num_threads))) {
+    threadpool_destroy(pool);
+    return NULL;
+  }
+  return pool;
+}
+
+void threadpool_destroy(threadpool_t *pool) {
+  if (!pool)
+    return;
+
+  stop_workers(pool);
+  pthread_mutex_destroy(&pool->park_mutex);
+  pthread_cond_destroy(&pool->park_cond);
+  pthread_mutex_destroy(&pool->dispatch_mutex);
+  free(pool);
+}
+
+int threadpool_size(const threadpool_t *pool) {
+  return pool ? pool->num_threads : 1;
+}
+
+void threadpool_set_spin_us(threadpool_t *pool, int spin_us) {
+  if (pool)
+    atomic_store(&pool->spin_us, spin_us > 0 ? spin_us : 0);
+}
+
+void threadpool_parallel_for(threadpool_t *pool, int start, int end, int grain,
+                             threadpool_fn_t fn, void *arg) {
+  int total = end - start;
+  if (total <= 0)
+    return;
+  if (grain < 1)
+    grain = 1;
+
+  if (!pool || tls_in_job || total <= grain ||
+      pthread_mutex_trylock(&pool->dispatch_mutex) != 0) {
+    fn(arg, start, end);
+    return;
+  }
+
+  int n = pool->num_threads;
+  int max_chunks = (total + grain - 1) / grain;
+  if (n > max_chunks)
+    n = max_chunks;
+  if (n <= 1) {
+    pthread_mutex_unlock(&pool->dispatch_mutex);
+    fn(arg, start, end);
+    return;
+  }
+
+  int chunk = (total + n - 1) / n;
+  chunk = ((chunk + grain - 1) / grain) * grain;
+  n = (total + chunk - 1) / chunk;
+
+  pool->job = (threadpool_job_t){fn, arg, start, end, chunk};
+  atomic_store_explicit(&pool->pending, n - 1, memory_order_relaxed);
+
+  for (int i = 1; i < n; i++)
+    atomic_fetch_add(&pool->workers[i - 1].mailbox, 1);
+
+  if (atomic_load(&pool->sleepers) > 0) {
+    pthread_mutex_lock(&pool->park_mutex);
+    pthread_cond_broadcast(&pool->park_cond);
+    pthread_mutex_unlock(&pool->park_mutex);
+  }
+
+  tls_in_job = true;
+  run_chunk(&pool->job, 0);
+  tls_in_job = false;
+
+  for (unsigned iter = 1;
+       atomic_load_explicit(&pool->pending, memory_order_acquire) > 0;
+       iter++) {
+    if (iter < 4096)
+      cpu_relax();
+    else
+      sched_yield();
+  }
+
+  pthread_mutex_unlock(&pool->dispatch_mutex);
+}
+
+/* ============================================================================
+ * Shared Pool
+ * ============================================================================
+ */
+
+static threadpool_t *g_pool = NULL;
+static pthread_mutex_t g_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+threadpool_t *threadpool_global(void) {
+  threadpool_t *pool = __atomic_load_n(&g_pool, __ATOMIC_ACQUIRE);
+  if (pool)
+    return pool;
+
+  pthread_mutex_lock(&g_pool_mutex);
+  if (!g_pool)
+    __atomic_store_n(&g_pool, threadpool_create(0), __ATOMIC_RELEASE);
+  pool = g_pool;
+  pthread_mutex_unlock(&g_pool_mutex);
+  return pool;
+}
+
+void threadpool_set_num_threads(int num_threads) {
+  caps_set_num_threads(num_threads);
+  threadpool_t *pool = threadpool_global();
+  if (!pool)
+    return;
+
+  /* Resize in place so pointers held by backends stay valid */
+  int wanted = clamp_threads(caps_num_threads());
+  pthread_mutex_lock(&pool->dispatch_mutex);
+  if (pool->num_threads != wanted) {
+    stop_workers(pool);
+    start_workers(pool, wanted);
+  }
+  pthread_mutex_unlock(&pool->dispatch_mutex);
+}
+
+int threadpool_get_num_threads(void) {
+  return threadpool_size(threadpool_global());
+}
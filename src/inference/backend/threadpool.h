@@ -0,0 +1,106 @@
+/**
+ * @file threadpool.h
+ * @brief Persistent worker pool shared by the inference kernels.
+ *
+ * Kernels split their work with threadpool_parallel_for() instead of
+ * spawning threads per call. Workers are created once, pinned to a core
+ * where the OS allows it, and spin briefly between jobs before parking so
+ * that the back-to-back small kernels of a decode step do not pay a wakeup
+ * each time.
+ */
+
+#ifndef INFERENCE_BACKEND_THREADPOOL_H
+#define INFERENCE_BACKEND_THREADPOOL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct threadpool threadpool_t;
+
+/**
+ * Work callback: processes the half-open range [start, end).
+ */
+typedef void (*threadpool_fn_t)(void *arg, int start, int end);
+
+/**
+ * Create a pool that runs jobs on num_threads threads, counting the calling
+ * thread (so num_threads - 1 workers are started).
+ *
+ * @param num_threads Total thread count (0 = caps_num_threads())
+ * @return New pool, or NULL on failure
+ */
+threadpool_t *threadpool_create(int num_threads);
+
+/**
+ * Stop the workers and free the pool.
+ * @param pool Pool to destroy (can be NULL)
+ */
+void threadpool_destroy(threadpool_t *pool);
+
+/**
+ * Get the total thread count of a pool, including the calling thread.
+ * @param pool Pool instance (NULL counts as a single thread)
+ * @return Thread count (always >= 1)
+ */
+int threadpool_size(const threadpool_t *pool);
+
+/**
+ * Set how long an idle worker spins before parking on a condition variable.
+ * Longer spins cut dispatch latency at the cost of burning idle cores.
+ *
+ * @param pool Pool instance
+ * @param spin_us Spin budget in microseconds (0 = park immediately)
+ */
+void threadpool_set_spin_us(threadpool_t *pool, int spin_us);
+
+/**
+ * Run fn over [start, end), split into at most threadpool_size() contiguous
+ * chunks whose sizes are multiples of grain (except the last). The calling
+ * thread runs the first chunk and returns once every chunk is done.
+ *
+ * Calls made from inside a job, or while another thread is dispatching on
+ * the same pool, run fn serially on the caller.
+ *
+ * @param pool Pool instance (NULL runs serially)
+ * @param start First index
+ * @param end One past the last index
+ * @param grain Minimum chunk size and chunk alignment (<= 0 treated as 1)
+ * @param fn Work callback
+ * @param arg Opaque argument passed to fn
+ */
+void threadpool_parallel_for(threadpool_t *pool, int start, int end, int grain,
+                             threadpool_fn_t fn, void *arg);
+
+/* ============================================================================
+ * Shared Pool
+ *
+ * One pool serves every kernel and backend in the process.
+ * ============================================================================
+ */
+
+/**
+ * Get the shared pool, creating it on first use with caps_num_threads()
+ * threads.
+ *
+ * @return Shared pool (NULL only if creation failed)
+ */
+threadpool_t *threadpool_global(void);
+
+/**
+ * Resize the shared pool. Must not be called while kernels are running.
+ * @param num_threads Thread count (0 = use all CPUs)
+ */
+void threadpool_set_num_threads(int num_threads);
+
+/**
+ * Get the thread count of the shared pool.
+ * @return Thread count (always >= 1)
+ */
+int threadpool_get_num_threads(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFERENCE_BACKEND_THREADPOOL_H */
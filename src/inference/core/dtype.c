@@ -26,13 +26,27 @@ static const size_t dtype_sizes[DTYPE_COUNT] = {
     [DTYPE_F32] = 4,  /* float32: 4 bytes */
     [DTYPE_F16] = 2,  /* float16: 2 bytes */
     [DTYPE_BF16] = 2, /* bfloat16: 2 bytes */
-    [DTYPE_INT8] = 1, /* int8: 1 byte */
-    [DTYPE_INT4] = 1, /* int4: 1 byte (packed, but minimum addressable) */
+    [DTYPE_Q8_0] = 0, /* block-quantized: see dtype_nbytes */
+    [DTYPE_Q4_0] = 0, /* block-quantized: see dtype_nbytes */
+};
+
+/* Elements per block and bytes per block */
+static const size_t dtype_block_elems[DTYPE_COUNT] = {
+    [DTYPE_F32] = 1,   [DTYPE_F16] = 1,   [DTYPE_BF16] = 1,
+    [DTYPE_Q8_0] = 32, [DTYPE_Q4_0] = 32,
+};
+
+static const size_t dtype_block_bytes[DTYPE_COUNT] = {
+    [DTYPE_F32] = 4,   /* one float32 */
+    [DTYPE_F16] = 2,   /* one float16 */
+    [DTYPE_BF16] = 2,  /* one bfloat16 */
+    [DTYPE_Q8_0] = 34, /* fp16 scale + 32 x int8 */
+    [DTYPE_Q4_0] = 18, /* fp16 scale + 32 x 4 bit */
 };
 
 static const char *dtype_names[DTYPE_COUNT] = {
     [DTYPE_F32] = "f32",   [DTYPE_F16] = "f16",   [DTYPE_BF16] = "bf16",
-    [DTYPE_INT8] = "int8", [DTYPE_INT4] = "int4",
+    [DTYPE_Q8_0] = "q8_0", [DTYPE_Q4_0] = "q4_0",
 };
 
 size_t dtype_size(dtype_t dtype) {
@@ -41,6 +55,22 @@ size_t dtype_size(dtype_t dtype) {
   return dtype_sizes[dtype];
 }
 
+size_t dtype_block_size(dtype_t dtype) {
+  if (dtype < 0 || dtype >= DTYPE_COUNT)
+    return 0;
+  return dtype_block_elems[dtype];
+}
+
+size_t dtype_nbytes(dtype_t dtype, size_t count) {
+  if (dtype < 0 || dtype >= DTYPE_COUNT)
+    return 0;
+  return count / dtype_block_elems[dtype] * dtype_block_bytes[dtype];
+}
+
+int dtype_is_quantized(dtype_t dtype) {
+  return dtype == DTYPE_Q8_0 || dtype == DTYPE_Q4_0;
+}
+
 const char *dtype_name(dtype_t dtype) {
   if (dtype < 0 || dtype >= DTYPE_COUNT)
     return "unknown";
@@ -212,7 +242,7 @@ int dtype_convert_array(const void *src, dtype_t src_dtype, void *dst,
 
   /* Same type - just copy */
   if (src_dtype == dst_dtype) {
-    memcpy(dst, src, count * dtype_size(src_dtype));
+    memcpy(dst, src, dtype_nbytes(src_dtype, count));
     return 0;
   }
 
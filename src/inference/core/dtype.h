@@ -23,18 +23,41 @@ typedef enum {
   DTYPE_F32 = 0,  /**< 32-bit floating point */
   DTYPE_F16 = 1,  /**< 16-bit floating point (IEEE 754) */
   DTYPE_BF16 = 2, /**< 16-bit brain floating point */
-  DTYPE_INT8 = 3, /**< 8-bit signed integer (future quantization) */
-  DTYPE_INT4 = 4, /**< 4-bit signed integer (future quantization) */
+  DTYPE_Q8_0 = 3, /**< Blocks of 32 int8 values with an FP16 scale */
+  DTYPE_Q4_0 = 4, /**< Blocks of 32 4-bit values with an FP16 scale */
   DTYPE_COUNT
 } dtype_t;
 
 /**
  * Get the size in bytes for a given dtype.
  * @param dtype The data type
- * @return Size in bytes (0 for invalid dtype)
+ * @return Size in bytes (0 for invalid dtype and for block-quantized dtypes,
+ *         whose elements are not individually addressable)
  */
 size_t dtype_size(dtype_t dtype);
 
+/**
+ * Get the number of elements stored together in one block.
+ * @param dtype The data type
+ * @return Elements per block (1 for unquantized dtypes, 0 for invalid dtype)
+ */
+size_t dtype_block_size(dtype_t dtype);
+
+/**
+ * Get the storage size of count elements.
+ * @param dtype The data type
+ * @param count Number of elements (a multiple of dtype_block_size())
+ * @return Size in bytes (0 for invalid dtype)
+ */
+size_t dtype_nbytes(dtype_t dtype, size_t count);
+
+/**
+ * Check if a dtype is block-quantized.
+ * @param dtype The data type
+ * @return true for DTYPE_Q8_0 and DTYPE_Q4_0, false otherwise
+ */
+int dtype_is_quantized(dtype_t dtype);
+
 /**
  * Get a human-readable name for a dtype.
  * @param dtype The data type
@@ -0,0 +1,188 @@
+/**
+ * @file large_alloc.c
+ * @brief Implementation of huge-page backed allocations.
+ *
+ * Every block starts with a LARGE_ALLOC_ALIGN-byte header recording how it
+ * was obtained, so large_free() can tell mappings from heap blocks.
+ */
+
+#include "inference/core/large_alloc.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#define LARGE_HAVE_MMAP 1
+#else
+#define LARGE_HAVE_MMAP 0
+#endif
+
+typedef struct {
+  size_t size;      /* Bytes of the whole block, header included */
+  uint32_t backing; /* large_pages_t */
+  uint32_t mapped;  /* 1 if the block is an mmap() region */
+} block_header_t;
+
+_Static_assert(sizeof(block_header_t) <= LARGE_ALLOC_ALIGN,
+               "block header must fit in the alignment padding");
+
+typedef enum { MODE_OFF, MODE_THP, MODE_HUGETLB } huge_mode_t;
+
+static atomic_size_t g_live[LARGE_PAGES_COUNT];
+
+static size_t round_up(size_t n, size_t align) {
+  return (n + align - 1) & ~(align - 1);
+}
+
+static huge_mode_t huge_mode(void) {
+  const char *mode = getenv("SILLYTUI_HUGEPAGES");
+  if (mode && strcmp(mode, "off") == 0)
+    return MODE_OFF;
+  if (mode && strcmp(mode, "hugetlb") == 0)
+    return MODE_HUGETLB;
+  return MODE_THP;
+}
+
+#if LARGE_HAVE_MMAP
+#ifdef MAP_HUGE_SHIFT
+#define LARGE_MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#else
+#define LARGE_MAP_HUGE_2MB 0
+#endif
+
+/* -1 until read: whether THP is enabled at all ("[never]" disables it) */
+static atomic_int g_thp_enabled = -1;
+
+static bool thp_enabled(void) {
+  int enabled = atomic_load(&g_thp_enabled);
+  if (enabled >= 0)
+    return enabled;
+
+  enabled = 0;
+  FILE *f = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+  if (f) {
+    char line[128];
+    if (fgets(line, sizeof(line), f))
+      enabled = strstr(line, "[never]") == NULL;
+    fclose(f);
+  }
+  atomic_store(&g_thp_enabled, enabled);
+  return enabled;
+}
+
+static void *map_hugetlb(size_t size) {
+#ifdef MAP_HUGETLB
+  int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | LARGE_MAP_HUGE_2MB;
+  void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, flags, -1, 0);
+  return p == MAP_FAILED ? NULL : p;
+#else
+  (void)size;
+  return NULL;
+#endif
+}
+
+/* Map size bytes at a LARGE_PAGE_SIZE boundary by trimming a larger map */
+static void *map_aligned(size_t size) {
+  size_t span = size + LARGE_PAGE_SIZE;
+  uint8_t *p = (uint8_t *)mmap(NULL, span, PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if ((void *)p == MAP_FAILED)
+    return NULL;
+
+  uint8_t *start = (uint8_t *)round_up((uintptr_t)p, LARGE_PAGE_SIZE);
+  size_t head = (size_t)(start - p);
+  if (head > 0)
+    munmap(p, head);
+  if (span - head > size)
+    munmap(start + size, span - head - size);
+  return start;
+}
+
+static block_header_t *map_block(size_t bytes) {
+  huge_mode_t mode = huge_mode();
+  if (mode == MODE_OFF)
+    return NULL;
+
+  size_t size = round_up(bytes + LARGE_ALLOC_ALIGN, LARGE_PAGE_SIZE);
+  large_pages_t backing = LARGE_PAGES_HUGETLB;
+  void *p = mode == MODE_HUGETLB ? map_hugetlb(size) : NULL;
+  if (!p) {
+    p = map_aligned(size);
+    if (!p)
+      return NULL;
+    backing = LARGE_PAGES_NONE;
+    if (thp_enabled() && madvise(p, size, MADV_HUGEPAGE) == 0)
+      backing = LARGE_PAGES_THP;
+  }
+
+  block_header_t *h = (block_header_t *)p;
+  h->size = size;
+  h->backing = backing;
+  h->mapped = 1;
+  return h;
+}
+#endif
+
+static block_header_t *heap_block(size_t bytes) {
+  size_t size = round_up(bytes + LARGE_ALLOC_ALIGN, LARGE_ALLOC_ALIGN);
+  block_header_t *h = (block_header_t *)aligned_alloc(LARGE_ALLOC_ALIGN, size);
+  if (!h)
+    return NULL;
+  memset(h, 0, size);
+  h->size = size;
+  h->backing = LARGE_PAGES_NONE;
+  h->mapped = 0;
+  return h;
+}
+
+void *large_alloc(size_t bytes) {
+  if (bytes > SIZE_MAX - LARGE_ALLOC_ALIGN - LARGE_PAGE_SIZE)
+    return NULL;
+
+  block_header_t *h = NULL;
+#if LARGE_HAVE_MMAP
+  /* Blocks under half a huge page would waste most of one */
+  if (bytes + LARGE_ALLOC_ALIGN >= LARGE_PAGE_SIZE / 2)
+    h = map_block(bytes);
+#endif
+  if (!h)
+    h = heap_block(bytes);
+  if (!h)
+    return NULL;
+
+  atomic_fetch_add(&g_live[h->backing], h->size);
+  return (uint8_t *)h + LARGE_ALLOC_ALIGN;
+}
+
+void large_free(void *ptr) {
+  if (!ptr)
+    return;
+  block_header_t *h = (block_header_t *)((uint8_t *)ptr - LARGE_ALLOC_ALIGN);
+  atomic_fetch_sub(&g_live[h->backing], h->size);
+#if LARGE_HAVE_MMAP
+  if (h->mapped) {
+    munmap(h, h->size);
+    return;
+  }
+#endif
+  free(h);
+}
+
+large_pages_t large_alloc_backing(const void *ptr) {
+  if (!ptr)
+    return LARGE_PAGES_NONE;
+  const block_header_t *h =
+      (const block_header_t *)((const uint8_t *)ptr - LARGE_ALLOC_ALIGN);
+  return (large_pages_t)h->backing;
+}
+
+void large_alloc_stats(large_alloc_stats_t *stats) {
+  if (!stats)
+    return;
+  for (int i = 0; i < LARGE_PAGES_COUNT; i++)
+    stats->bytes[i] = atomic_load(&g_live[i]);
+}
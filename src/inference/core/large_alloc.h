@@ -0,0 +1,71 @@
+/**
+ * @file large_alloc.h
+ * @brief Huge-page backed allocations for weights, KV pages and workspaces.
+ *
+ * Decode streams every weight once per token, so with 4 KB pages a
+ * multi-GB model costs a TLB miss every few kilobytes. Blocks of at least
+ * half a huge page are mapped 2 MB aligned and backed by, in order of
+ * preference:
+ *   - explicit huge pages (MAP_HUGETLB), when SILLYTUI_HUGEPAGES=hugetlb and
+ *     the hugetlbfs pool has room
+ *   - transparent huge pages, requested with madvise(MADV_HUGEPAGE), unless
+ *     THP is disabled system-wide or SILLYTUI_HUGEPAGES=off
+ *   - ordinary pages
+ * Smaller blocks, and every block off Linux, come from aligned_alloc().
+ * Memory is zeroed either way and must be released with large_free().
+ */
+
+#ifndef INFERENCE_CORE_LARGE_ALLOC_H
+#define INFERENCE_CORE_LARGE_ALLOC_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Huge page size the allocator aligns mappings to */
+#define LARGE_PAGE_SIZE ((size_t)2 << 20)
+
+/** Alignment of every block */
+#define LARGE_ALLOC_ALIGN 64
+
+typedef enum {
+  LARGE_PAGES_NONE,    /**< Ordinary pages */
+  LARGE_PAGES_THP,     /**< Transparent huge pages */
+  LARGE_PAGES_HUGETLB, /**< Explicit huge pages */
+  LARGE_PAGES_COUNT
+} large_pages_t;
+
+/** Live bytes per backing, summed over every outstanding block */
+typedef struct {
+  size_t bytes[LARGE_PAGES_COUNT];
+} large_alloc_stats_t;
+
+/**
+ * Allocate a zeroed block.
+ * @param bytes Size in bytes
+ * @return LARGE_ALLOC_ALIGN-aligned memory, or NULL if allocation failed
+ */
+void *large_alloc(size_t bytes);
+
+/**
+ * Release a block from large_alloc().
+ * @param ptr Block (can be NULL)
+ */
+void large_free(void *ptr);
+
+/**
+ * Backing a block obtained. LARGE_PAGES_THP means the kernel was asked for
+ * huge pages; it still falls back to small ones when it has none free.
+ */
+large_pages_t large_alloc_backing(const void *ptr);
+
+/** Snapshot of the live bytes per backing */
+void large_alloc_stats(large_alloc_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -4,6 +4,7 @@
  */
 
 #include "inference/core/tensor.h"
+#include "inference/core/large_alloc.h"
 #include <stdlib.h>
 #include <string.h>
 
@@ -29,7 +30,7 @@ static void tensor_compute_metadata(tensor_t *t) {
   }
 
   /* Calculate bytes */
-  t->nbytes = t->numel * dtype_size(t->dtype);
+  t->nbytes = dtype_nbytes(t->dtype, t->numel);
 
   /* Set up contiguous (row-major) strides */
   t->stride[t->ndim - 1] = 1;
@@ -57,7 +58,7 @@ tensor_t *tensor_create(dtype_t dtype, int ndim, const int64_t *shape) {
   tensor_compute_metadata(t);
 
   if (t->nbytes > 0) {
-    t->data = calloc(1, t->nbytes);
+    t->data = large_alloc(t->nbytes);
     if (!t->data) {
       free(t);
       return NULL;
@@ -103,7 +104,7 @@ int tensor_init(tensor_t *t, void *data, dtype_t dtype, int ndim,
     t->owns_data = false;
   } else {
     if (t->nbytes > 0) {
-      t->data = calloc(1, t->nbytes);
+      t->data = large_alloc(t->nbytes);
       if (!t->data)
         return -1;
     }
@@ -118,7 +119,7 @@ void tensor_free(tensor_t *t) {
     return;
 
   if (t->owns_data && t->data) {
-    free(t->data);
+    large_free(t->data);
   }
   free(t);
 }
@@ -128,7 +129,7 @@ void tensor_reset(tensor_t *t) {
     return;
 
   if (t->owns_data && t->data) {
-    free(t->data);
+    large_free(t->data);
   }
   memset(t, 0, sizeof(tensor_t));
 }
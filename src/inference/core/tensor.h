@@ -43,7 +43,8 @@ typedef struct {
 
 /**
  * Create a new tensor with allocated memory.
- * The tensor owns its data and will free it on tensor_free.
+ * The tensor owns its data and will free it on tensor_free. The data is
+ * zeroed and comes from large_alloc(), so big tensors get huge pages.
  *
  * @param dtype Data type for elements
  * @param ndim Number of dimensions
@@ -0,0 +1,74 @@
+/**
+ * @file workspace.c
+ * @brief Implementation of the forward-pass workspace.
+ */
+
+#include "inference/core/workspace.h"
+#include "inference/core/large_alloc.h"
+#include <stdlib.h>
+#include <string.h>
+
+size_t workspace_slice_bytes(size_t bytes) {
+  return (bytes + WORKSPACE_ALIGN - 1) & ~(size_t)(WORKSPACE_ALIGN - 1);
+}
+
+bool workspace_init(workspace_t *ws, size_t capacity) {
+  if (!ws)
+    return false;
+  memset(ws, 0, sizeof(*ws));
+  return capacity == 0 || workspace_reserve(ws, capacity);
+}
+
+void workspace_free(workspace_t *ws) {
+  if (!ws)
+    return;
+  large_free(ws->base);
+  memset(ws, 0, sizeof(*ws));
+}
+
+bool workspace_reserve(workspace_t *ws, size_t bytes) {
+  if (!ws)
+    return false;
+  if (bytes <= ws->capacity)
+    return true;
+  if (ws->used != 0)
+    return false;
+
+  size_t capacity = ws->capacity + ws->capacity / 2;
+  if (capacity < bytes)
+    capacity = bytes;
+  capacity = workspace_slice_bytes(capacity);
+
+  uint8_t *base = (uint8_t *)large_alloc(capacity);
+  if (!base)
+    return false;
+  memset(base, 0, capacity);
+
+  large_free(ws->base);
+  ws->base = base;
+  ws->capacity = capacity;
+  return true;
+}
+
+void *workspace_alloc(workspace_t *ws, size_t bytes) {
+  if (!ws || !ws->base)
+    return NULL;
+  size_t size = workspace_slice_bytes(bytes);
+  if (size > ws->capacity - ws->used)
+    return NULL;
+
+  void *slice = ws->base + ws->used;
+  ws->used += size;
+  if (ws->used > ws->peak)
+    ws->peak = ws->used;
+  return slice;
+}
+
+size_t workspace_mark(const workspace_t *ws) { return ws ? ws->used : 0; }
+
+void workspace_reset(workspace_t *ws, size_t mark) {
+  if (ws && mark <= ws->used)
+    ws->used = mark;
+}
+
+size_t workspace_peak(const workspace_t *ws) { return ws ? ws->peak : 0; }
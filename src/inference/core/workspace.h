@@ -0,0 +1,84 @@
+/**
+ * @file workspace.h
+ * @brief Preallocated scratch memory for forward passes.
+ *
+ * A workspace is one block of memory handed out in aligned slices by
+ * bumping an offset. Callers take a mark before allocating and reset to it
+ * when done, so nested functions release their scratch in LIFO order and a
+ * forward pass that fits never touches the heap. The block only grows
+ * between passes, through workspace_reserve().
+ */
+
+#ifndef INFERENCE_CORE_WORKSPACE_H
+#define INFERENCE_CORE_WORKSPACE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Alignment of every slice, one cache line */
+#define WORKSPACE_ALIGN 64
+
+typedef struct {
+  uint8_t *base;   /**< Start of the block (NULL until first reserve) */
+  size_t capacity; /**< Bytes in the block */
+  size_t used;     /**< Bytes handed out */
+  size_t peak;     /**< Highest used since init */
+} workspace_t;
+
+/**
+ * Initialize a workspace and reserve capacity bytes.
+ * @param ws Workspace to initialize
+ * @param capacity Initial size in bytes (0 defers allocation)
+ * @return true on success, false if allocation failed
+ */
+bool workspace_init(workspace_t *ws, size_t capacity);
+
+/**
+ * Release the block.
+ * @param ws Workspace (can be NULL)
+ */
+void workspace_free(workspace_t *ws);
+
+/**
+ * Ensure the block holds at least bytes. Growing replaces the block, so it
+ * is only allowed while nothing is allocated; the new size is at least 1.5x
+ * the old one so that a run of slightly larger passes does not reallocate
+ * each time. New memory comes from large_alloc() and is touched up front so
+ * its (huge) pages fault in here rather than in the middle of a pass.
+ *
+ * @param ws Workspace
+ * @param bytes Required capacity
+ * @return true if the block is large enough
+ */
+bool workspace_reserve(workspace_t *ws, size_t bytes);
+
+/**
+ * Take bytes from the workspace, aligned to WORKSPACE_ALIGN.
+ * @param ws Workspace
+ * @param bytes Slice size
+ * @return Slice, or NULL if the workspace is exhausted
+ */
+void *workspace_alloc(workspace_t *ws, size_t bytes);
+
+/** Current allocation offset, to be passed to workspace_reset() */
+size_t workspace_mark(const workspace_t *ws);
+
+/** Release every slice allocated since mark was taken */
+void workspace_reset(workspace_t *ws, size_t mark);
+
+/** Bytes a slice of the given size occupies, including alignment */
+size_t workspace_slice_bytes(size_t bytes);
+
+/** Highest number of bytes in use at once since init */
+size_t workspace_peak(const workspace_t *ws);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFERENCE_CORE_WORKSPACE_H */
@@ -124,6 +124,11 @@ void silu_f32(float *out, const float *input, int num_tokens, int d) {
     return;
   }
 
+  if (caps.has_avx2) {
+    silu_f32_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     for (int j = 0; j < d; j++) {
       int idx = i * d + j;
@@ -142,6 +147,11 @@ void silu_bf16(uint16_t *out, const uint16_t *input, int num_tokens, int d) {
     return;
   }
 
+  if (caps.has_avx2) {
+    silu_bf16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     for (int j = 0; j < d; j++) {
       int idx = i * d + j;
@@ -161,6 +171,11 @@ void silu_f16(uint16_t *out, const uint16_t *input, int num_tokens, int d) {
     return;
   }
 
+  if (caps.has_avx2) {
+    silu_f16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     for (int j = 0; j < d; j++) {
       int idx = i * d + j;
@@ -182,6 +197,11 @@ void silu_and_mul_f32(float *out, const float *input, int num_tokens, int d) {
     return;
   }
 
+  if (caps.has_avx2) {
+    silu_and_mul_f32_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     int in_start = i * 2 * d;
     int out_start = i * d;
@@ -204,6 +224,11 @@ void silu_and_mul_bf16(uint16_t *out, const uint16_t *input, int num_tokens,
     return;
   }
 
+  if (caps.has_avx2) {
+    silu_and_mul_bf16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     int in_start = i * 2 * d;
     int out_start = i * d;
@@ -226,6 +251,11 @@ void silu_and_mul_f16(uint16_t *out, const uint16_t *input, int num_tokens,
     return;
   }
 
+  if (caps.has_avx2) {
+    silu_and_mul_f16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     int in_start = i * 2 * d;
     int out_start = i * d;
@@ -374,6 +404,11 @@ void gelu_tanh_f32(float *out, const float *input, int num_tokens, int d) {
     return;
   }
 
+  if (caps.has_avx2) {
+    gelu_tanh_f32_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     for (int j = 0; j < d; j++) {
       int idx = i * d + j;
@@ -393,6 +428,11 @@ void gelu_tanh_bf16(uint16_t *out, const uint16_t *input, int num_tokens,
     return;
   }
 
+  if (caps.has_avx2) {
+    gelu_tanh_bf16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     for (int j = 0; j < d; j++) {
       int idx = i * d + j;
@@ -413,6 +453,11 @@ void gelu_tanh_f16(uint16_t *out, const uint16_t *input, int num_tokens,
     return;
   }
 
+  if (caps.has_avx2) {
+    gelu_tanh_f16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     for (int j = 0; j < d; j++) {
       int idx = i * d + j;
@@ -435,6 +480,11 @@ void gelu_tanh_and_mul_f32(float *out, const float *input, int num_tokens,
     return;
   }
 
+  if (caps.has_avx2) {
+    gelu_tanh_and_mul_f32_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     int in_start = i * 2 * d;
     int out_start = i * d;
@@ -457,6 +507,11 @@ void gelu_tanh_and_mul_bf16(uint16_t *out, const uint16_t *input,
     return;
   }
 
+  if (caps.has_avx2) {
+    gelu_tanh_and_mul_bf16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     int in_start = i * 2 * d;
     int out_start = i * d;
@@ -479,6 +534,11 @@ void gelu_tanh_and_mul_f16(uint16_t *out, const uint16_t *input, int num_tokens,
     return;
   }
 
+  if (caps.has_avx2) {
+    gelu_tanh_and_mul_f16_kernel_avx2(out, input, num_tokens, d);
+    return;
+  }
+
   for (int i = 0; i < num_tokens; i++) {
     int in_start = i * 2 * d;
     int out_start = i * d;
@@ -0,0 +1,349 @@
+/*
+ * Activation Functions - AVX2/FMA Optimized Kernels
+ *
+ * SiLU and tanh-approximated GELU (plus their gated "*_and_mul" forms) for
+ * FP32, BF16 and FP16. All math is done in F32 lanes using a vectorized
+ * exp(); tanh is expressed through the sigmoid as tanh(x) = 2*sigmoid(2x) - 1.
+ */
+
+#include "inference/kernels/activation/activation_kernels.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+#ifndef M_SQRT2
+#define M_SQRT2 1.41421356237309504880
+#endif
+
+#ifndef M_2_SQRTPI
+#define M_2_SQRTPI 1.12837916709551257390
+#endif
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+enum { ACT_SILU = 0, ACT_GELU_TANH = 1 };
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+/* ============ Vector Math ============ */
+
+/*
+ * exp(x) via range reduction x = n*ln2 + r and a degree-5 polynomial for
+ * e^r (Cephes expf coefficients), max rel. error ~2 ulp over [-88, 88].
+ */
+AVX2_INLINE __m256 exp256_ps(__m256 x) {
+  const __m256 exp_hi = _mm256_set1_ps(88.3762626647949f);
+  const __m256 exp_lo = _mm256_set1_ps(-88.3762626647949f);
+  const __m256 log2e = _mm256_set1_ps(1.44269504088896341f);
+  const __m256 c1 = _mm256_set1_ps(0.693359375f);
+  const __m256 c2 = _mm256_set1_ps(-2.12194440e-4f);
+
+  x = _mm256_min_ps(_mm256_max_ps(x, exp_lo), exp_hi);
+
+  __m256 fx = _mm256_fmadd_ps(x, log2e, _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, c1, x);
+  x = _mm256_fnmadd_ps(fx, c2, x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+/* sigmoid(x) = 1 / (1 + exp(-x)) */
+AVX2_INLINE __m256 sigmoid256_ps(__m256 x) {
+  const __m256 one = _mm256_set1_ps(1.0f);
+  __m256 e = exp256_ps(_mm256_sub_ps(_mm256_setzero_ps(), x));
+  return _mm256_div_ps(one, _mm256_add_ps(one, e));
+}
+
+AVX2_INLINE __m256 act256_ps(__m256 x, int act) {
+  if (act == ACT_SILU)
+    return _mm256_mul_ps(x, sigmoid256_ps(x));
+
+  /* 0.5*x*(1 + tanh(u)) == x*sigmoid(2u), u = sqrt(2/pi)*(x + 0.044715x^3) */
+  const __m256 w1 = _mm256_set1_ps((float)(M_SQRT2 * M_2_SQRTPI * 0.5));
+  const __m256 w3 = _mm256_set1_ps(0.044715f);
+  __m256 x2 = _mm256_mul_ps(x, x);
+  __m256 inner =
+      _mm256_mul_ps(w1, _mm256_fmadd_ps(_mm256_mul_ps(x2, x), w3, x));
+  return _mm256_mul_ps(x, sigmoid256_ps(_mm256_add_ps(inner, inner)));
+}
+
+AVX2_INLINE float act_scalar(float x, int act) {
+  if (act == ACT_SILU)
+    return x / (1.0f + expf(-x));
+  const float w1 = (float)(M_SQRT2 * M_2_SQRTPI * 0.5);
+  float inner = w1 * (x + 0.044715f * x * x * x);
+  return x * 0.5f * (1.0f + tanhf(inner));
+}
+
+/* ============ Load/Store Helpers ============ */
+
+AVX2_INLINE __m256 load8(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm256_loadu_ps((const float *)p + idx);
+  __m128i h = _mm_loadu_si128((const __m128i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm256_cvtph_ps(h);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+AVX2_INLINE void store8(void *p, size_t idx, __m256 v, int kind) {
+  if (kind == ELEM_F32) {
+    _mm256_storeu_ps((float *)p + idx, v);
+    return;
+  }
+  __m128i h;
+  if (kind == ELEM_F16) {
+    h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i lsb =
+        _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    bits = _mm256_add_epi32(bits,
+                            _mm256_add_epi32(_mm256_set1_epi32(0x7fff), lsb));
+    bits = _mm256_srli_epi32(bits, 16);
+    h = _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                         _mm256_extracti128_si256(bits, 1));
+  }
+  _mm_storeu_si128((__m128i *)((uint16_t *)p + idx), h);
+}
+
+AVX2_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX2_INLINE void store1(void *p, size_t idx, float v, int kind) {
+  if (kind == ELEM_F32) {
+    ((float *)p)[idx] = v;
+  } else if (kind == ELEM_F16) {
+    ((uint16_t *)p)[idx] = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    ((uint16_t *)p)[idx] = (uint16_t)(bits >> 16);
+  }
+}
+
+/* ============ Generic Row Loops ============ */
+
+AVX2_INLINE void act_avx2(void *out, const void *input, int num_tokens, int d,
+                          int act, int kind) {
+  size_t n = (size_t)num_tokens * d;
+  size_t i = 0;
+  for (; i + 16 <= n; i += 16) {
+    __m256 x0 = load8(input, i, kind);
+    __m256 x1 = load8(input, i + 8, kind);
+    store8(out, i, act256_ps(x0, act), kind);
+    store8(out, i + 8, act256_ps(x1, act), kind);
+  }
+  for (; i + 8 <= n; i += 8)
+    store8(out, i, act256_ps(load8(input, i, kind), act), kind);
+  for (; i < n; i++)
+    store1(out, i, act_scalar(load1(input, i, kind), act), kind);
+}
+
+AVX2_INLINE void act_and_mul_avx2(void *out, const void *input, int num_tokens,
+                                  int d, int act, int kind) {
+  for (int t = 0; t < num_tokens; t++) {
+    size_t in_start = (size_t)t * 2 * d;
+    size_t out_start = (size_t)t * d;
+    int j = 0;
+    for (; j + 8 <= d; j += 8) {
+      __m256 x = load8(input, in_start + j, kind);
+      __m256 gate = load8(input, in_start + d + j, kind);
+      store8(out, out_start + j, _mm256_mul_ps(act256_ps(x, act), gate), kind);
+    }
+    for (; j < d; j++) {
+      float x = load1(input, in_start + j, kind);
+      float gate = load1(input, in_start + d + j, kind);
+      store1(out, out_start + j, act_scalar(x, act) * gate, kind);
+    }
+  }
+}
+
+/* ============ SiLU ============ */
+
+void silu_f32_kernel_avx2(float *out, const float *input, int num_tokens,
+                          int d) {
+  act_avx2(out, input, num_tokens, d, ACT_SILU, ELEM_F32);
+}
+
+void silu_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                           int num_tokens, int d) {
+  act_avx2(out, input, num_tokens, d, ACT_SILU, ELEM_BF16);
+}
+
+void silu_f16_kernel_avx2(uint16_t *out, const uint16_t *input, int num_tokens,
+                          int d) {
+  act_avx2(out, input, num_tokens, d, ACT_SILU, ELEM_F16);
+}
+
+void silu_and_mul_f32_kernel_avx2(float *out, const float *input,
+                                  int num_tokens, int d) {
+  act_and_mul_avx2(out, input, num_tokens, d, ACT_SILU, ELEM_F32);
+}
+
+void silu_and_mul_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                   int num_tokens, int d) {
+  act_and_mul_avx2(out, input, num_tokens, d, ACT_SILU, ELEM_BF16);
+}
+
+void silu_and_mul_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                  int num_tokens, int d) {
+  act_and_mul_avx2(out, input, num_tokens, d, ACT_SILU, ELEM_F16);
+}
+
+/* ============ GELU Tanh ============ */
+
+void gelu_tanh_f32_kernel_avx2(float *out, const float *input, int num_tokens,
+                               int d) {
+  act_avx2(out, input, num_tokens, d, ACT_GELU_TANH, ELEM_F32);
+}
+
+void gelu_tanh_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                int num_tokens, int d) {
+  act_avx2(out, input, num_tokens, d, ACT_GELU_TANH, ELEM_BF16);
+}
+
+void gelu_tanh_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                               int num_tokens, int d) {
+  act_avx2(out, input, num_tokens, d, ACT_GELU_TANH, ELEM_F16);
+}
+
+void gelu_tanh_and_mul_f32_kernel_avx2(float *out, const float *input,
+                                       int num_tokens, int d) {
+  act_and_mul_avx2(out, input, num_tokens, d, ACT_GELU_TANH, ELEM_F32);
+}
+
+void gelu_tanh_and_mul_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                        int num_tokens, int d) {
+  act_and_mul_avx2(out, input, num_tokens, d, ACT_GELU_TANH, ELEM_BF16);
+}
+
+void gelu_tanh_and_mul_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                       int num_tokens, int d) {
+  act_and_mul_avx2(out, input, num_tokens, d, ACT_GELU_TANH, ELEM_F16);
+}
+
+#else /* stubs */
+
+void silu_f32_kernel_avx2(float *out, const float *input, int num_tokens,
+                          int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void silu_bf16_kernel_avx2(uint16_t *out, const uint16_t *input, int num_tokens,
+                           int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void silu_f16_kernel_avx2(uint16_t *out, const uint16_t *input, int num_tokens,
+                          int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void silu_and_mul_f32_kernel_avx2(float *out, const float *input,
+                                  int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void silu_and_mul_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                   int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void silu_and_mul_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                  int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void gelu_tanh_f32_kernel_avx2(float *out, const float *input, int num_tokens,
+                               int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void gelu_tanh_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void gelu_tanh_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                               int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void gelu_tanh_and_mul_f32_kernel_avx2(float *out, const float *input,
+                                       int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void gelu_tanh_and_mul_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                        int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+void gelu_tanh_and_mul_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                       int num_tokens, int d) {
+  (void)out;
+  (void)input;
+  (void)num_tokens;
+  (void)d;
+}
+
+#endif
@@ -78,4 +78,33 @@ void gelu_quick_and_mul_bf16_kernel(uint16_t *out, const uint16_t *input,
 void gelu_quick_and_mul_f16_kernel(uint16_t *out, const uint16_t *input,
                                    int num_tokens, int d);
 
+/* AVX2/FMA kernels (x86-64) */
+void silu_f32_kernel_avx2(float *out, const float *input, int num_tokens,
+                          int d);
+void silu_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                           int num_tokens, int d);
+void silu_f16_kernel_avx2(uint16_t *out, const uint16_t *input, int num_tokens,
+                          int d);
+
+void silu_and_mul_f32_kernel_avx2(float *out, const float *input,
+                                  int num_tokens, int d);
+void silu_and_mul_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                   int num_tokens, int d);
+void silu_and_mul_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                  int num_tokens, int d);
+
+void gelu_tanh_f32_kernel_avx2(float *out, const float *input, int num_tokens,
+                               int d);
+void gelu_tanh_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                int num_tokens, int d);
+void gelu_tanh_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                               int num_tokens, int d);
+
+void gelu_tanh_and_mul_f32_kernel_avx2(float *out, const float *input,
+                                       int num_tokens, int d);
+void gelu_tanh_and_mul_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                        int num_tokens, int d);
+void gelu_tanh_and_mul_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                       int num_tokens, int d);
+
 #endif /* ACTIVATION_KERNELS_H */
@@ -6,11 +6,11 @@
  */
 
 #include "inference/kernels/attention/attention.h"
+#include "inference/backend/caps.h"
+#include "inference/backend/threadpool.h"
 #include <math.h>
-#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
 
 #if defined(__ARM_NEON) || defined(__ARM_NEON__)
 #define HAS_NEON 1
@@ -30,27 +30,30 @@ void flash_attention_f16_neon(uint16_t *output, const uint16_t *query,
 #define HAS_NEON 0
 #endif
 
-static int g_num_threads = 0;
-
-static int get_cpu_count(void) {
-  int count = (int)sysconf(_SC_NPROCESSORS_ONLN);
-  return count > 0 ? count : 1;
-}
+/* AVX2 kernels are built for every x86-64 target and gated on CPUID */
+#if defined(__x86_64__) || defined(_M_X64)
+#define HAS_AVX2 1
+void flash_attention_f32_avx2(float *output, const float *query,
+                              const float *key, const float *value,
+                              int seq_len_q, int seq_len_kv, int head_dim,
+                              float scale, const float *mask);
+void flash_attention_bf16_avx2(uint16_t *output, const uint16_t *query,
+                               const uint16_t *key, const uint16_t *value,
+                               int seq_len_q, int seq_len_kv, int head_dim,
+                               float scale, const float *mask);
+void flash_attention_f16_avx2(uint16_t *output, const uint16_t *query,
+                              const uint16_t *key, const uint16_t *value,
+                              int seq_len_q, int seq_len_kv, int head_dim,
+                              float scale, const float *mask);
+#else
+#define HAS_AVX2 0
+#endif
 
 void attention_set_num_threads(int num_threads) {
-  if (num_threads <= 0) {
-    g_num_threads = get_cpu_count();
-  } else {
-    g_num_threads = num_threads;
-  }
+  threadpool_set_num_threads(num_threads);
 }
 
-int attention_get_num_threads(void) {
-  if (g_num_threads == 0) {
-    g_num_threads = get_cpu_count();
-  }
-  return g_num_threads;
-}
+int attention_get_num_threads(void) { return threadpool_get_num_threads(); }
 
 static inline float bf16_to_float(uint16_t bf16) {
   uint32_t bits = ((uint32_t)bf16) << 16;
@@ -199,6 +202,13 @@ void flash_attention_f32(float *output, const float *query, const float *key,
   flash_attention_f32_neon(output, query, key, value, seq_len_q, seq_len_kv,
                            head_dim, scale, mask);
 #else
+#if HAS_AVX2
+  if (caps_has(CAP_AVX2)) {
+    flash_attention_f32_avx2(output, query, key, value, seq_len_q, seq_len_kv,
+                             head_dim, scale, mask);
+    return;
+  }
+#endif
   flash_attention_f32_scalar(output, query, key, value, seq_len_q, seq_len_kv,
                              head_dim, scale, mask);
 #endif
@@ -282,6 +292,13 @@ void flash_attention_bf16(uint16_t *output, const uint16_t *query,
   flash_attention_bf16_neon(output, query, key, value, seq_len_q, seq_len_kv,
                             head_dim, scale, mask);
 #else
+#if HAS_AVX2
+  if (caps_has(CAP_AVX2)) {
+    flash_attention_bf16_avx2(output, query, key, value, seq_len_q, seq_len_kv,
+                              head_dim, scale, mask);
+    return;
+  }
+#endif
   flash_attention_bf16_scalar(output, query, key, value, seq_len_q, seq_len_kv,
                               head_dim, scale, mask);
 #endif
@@ -365,6 +382,13 @@ void flash_attention_f16(uint16_t *output, const uint16_t *query,
   flash_attention_f16_neon(output, query, key, value, seq_len_q, seq_len_kv,
                            head_dim, scale, mask);
 #else
+#if HAS_AVX2
+  if (caps_has(CAP_AVX2)) {
+    flash_attention_f16_avx2(output, query, key, value, seq_len_q, seq_len_kv,
+                             head_dim, scale, mask);
+    return;
+  }
+#endif
   flash_attention_f16_scalar(output, query, key, value, seq_len_q, seq_len_kv,
                              head_dim, scale, mask);
 #endif
@@ -407,16 +431,8 @@ static void mha_work(mha_ctx_t *ctx, int start_head, int end_head) {
   }
 }
 
-typedef struct {
-  mha_ctx_t *ctx;
-  int start_head;
-  int end_head;
-} mha_task_t;
-
-static void *mha_thread_fn(void *arg) {
-  mha_task_t *task = (mha_task_t *)arg;
-  mha_work(task->ctx, task->start_head, task->end_head);
-  return NULL;
+static void mha_range(void *arg, int start_head, int end_head) {
+  mha_work((mha_ctx_t *)arg, start_head, end_head);
 }
 
 void flash_attention_mha_f32(float *output, const float *query,
@@ -428,40 +444,11 @@ void flash_attention_mha_f32(float *output, const float *query,
                    batch,      num_heads, num_kv_heads, seq_len_q,
                    seq_len_kv, head_dim,  scale,        mask};
 
-  int num_threads = attention_get_num_threads();
-  int total_heads = batch * num_heads;
-
-  if (num_threads <= 1 || total_heads < 4) {
+  if (batch * num_heads < 4) {
     mha_work(&ctx, 0, num_heads);
     return;
   }
 
-  if (num_threads > num_heads)
-    num_threads = num_heads;
-
-  pthread_t *threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
-  mha_task_t *tasks = (mha_task_t *)malloc(num_threads * sizeof(mha_task_t));
-
-  int heads_per_thread = (num_heads + num_threads - 1) / num_threads;
-
-  for (int t = 0; t < num_threads; t++) {
-    tasks[t].ctx = &ctx;
-    tasks[t].start_head = t * heads_per_thread;
-    tasks[t].end_head = tasks[t].start_head + heads_per_thread;
-    if (tasks[t].end_head > num_heads)
-      tasks[t].end_head = num_heads;
-
-    if (tasks[t].start_head < num_heads) {
-      pthread_create(&threads[t], NULL, mha_thread_fn, &tasks[t]);
-    }
-  }
-
-  for (int t = 0; t < num_threads; t++) {
-    if (tasks[t].start_head < num_heads) {
-      pthread_join(threads[t], NULL);
-    }
-  }
-
-  free(threads);
-  free(tasks);
+  threadpool_parallel_for(threadpool_global(), 0, num_heads, 1, mha_range,
+                          &ctx);
 }
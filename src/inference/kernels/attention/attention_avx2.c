@@ -0,0 +1,240 @@
+/*
+ * Flash Attention - AVX2/FMA Optimized Implementation
+ *
+ * Online softmax over KV blocks: scores for a block of keys are computed
+ * first, the running max/accumulator is rescaled once per block, and the
+ * block's exponentials are evaluated 8-wide.
+ */
+
+#include "inference/kernels/attention/attention.h"
+#include <math.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+#define ATTN_KV_BLOCK 64
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+AVX2_INLINE __m256 exp256_ps(__m256 x) {
+  const __m256 exp_hi = _mm256_set1_ps(88.3762626647949f);
+  const __m256 exp_lo = _mm256_set1_ps(-88.3762626647949f);
+  const __m256 log2e = _mm256_set1_ps(1.44269504088896341f);
+  const __m256 c1 = _mm256_set1_ps(0.693359375f);
+  const __m256 c2 = _mm256_set1_ps(-2.12194440e-4f);
+
+  x = _mm256_min_ps(_mm256_max_ps(x, exp_lo), exp_hi);
+
+  __m256 fx = _mm256_fmadd_ps(x, log2e, _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, c1, x);
+  x = _mm256_fnmadd_ps(fx, c2, x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+AVX2_INLINE float hsum256_ps(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+AVX2_INLINE __m256 load8(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm256_loadu_ps((const float *)p + idx);
+  __m128i h = _mm_loadu_si128((const __m128i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm256_cvtph_ps(h);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+AVX2_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX2_INLINE void store1(void *p, size_t idx, float v, int kind) {
+  if (kind == ELEM_F32) {
+    ((float *)p)[idx] = v;
+  } else if (kind == ELEM_F16) {
+    ((uint16_t *)p)[idx] = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    ((uint16_t *)p)[idx] = (uint16_t)(bits >> 16);
+  }
+}
+
+/* q is F32 (already converted); k row may be any element kind */
+AVX2_INLINE float dot_q_k(const float *q, const void *k, size_t off, int n,
+                          int kind) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  int d = 0;
+  for (; d + 16 <= n; d += 16) {
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(q + d), load8(k, off + d, kind),
+                           acc0);
+    acc1 = _mm256_fmadd_ps(_mm256_loadu_ps(q + d + 8),
+                           load8(k, off + d + 8, kind), acc1);
+  }
+  for (; d + 8 <= n; d += 8)
+    acc0 = _mm256_fmadd_ps(_mm256_loadu_ps(q + d), load8(k, off + d, kind),
+                           acc0);
+  float sum = hsum256_ps(_mm256_add_ps(acc0, acc1));
+  for (; d < n; d++)
+    sum += q[d] * load1(k, off + d, kind);
+  return sum;
+}
+
+AVX2_INLINE void vec_scale(float *v, float s, int n) {
+  __m256 sv = _mm256_set1_ps(s);
+  int d = 0;
+  for (; d + 8 <= n; d += 8)
+    _mm256_storeu_ps(v + d, _mm256_mul_ps(_mm256_loadu_ps(v + d), sv));
+  for (; d < n; d++)
+    v[d] *= s;
+}
+
+AVX2_INLINE void vec_mad(float *acc, const void *v, size_t off, float p, int n,
+                         int kind) {
+  __m256 pv = _mm256_set1_ps(p);
+  int d = 0;
+  for (; d + 8 <= n; d += 8)
+    _mm256_storeu_ps(acc + d, _mm256_fmadd_ps(load8(v, off + d, kind), pv,
+                                              _mm256_loadu_ps(acc + d)));
+  for (; d < n; d++)
+    acc[d] += load1(v, off + d, kind) * p;
+}
+
+AVX2_INLINE void flash_attention_avx2(void *output, const void *query,
+                                      const void *key, const void *value,
+                                      int seq_len_q, int seq_len_kv,
+                                      int head_dim, float scale,
+                                      const float *mask, int kind) {
+  size_t alloc_size = ((2 * head_dim * sizeof(float) + 63) / 64) * 64;
+  float *q_f32 = (float *)aligned_alloc(64, alloc_size);
+  if (!q_f32)
+    return;
+  float *acc = q_f32 + head_dim;
+  float scores[ATTN_KV_BLOCK];
+  const float neg_inf = -__builtin_inff();
+
+  for (int q_idx = 0; q_idx < seq_len_q; q_idx++) {
+    size_t q_off = (size_t)q_idx * head_dim;
+    const float *mask_row = mask ? mask + (size_t)q_idx * seq_len_kv : NULL;
+
+    /* Fold the softmax scale into q once */
+    for (int d = 0; d < head_dim; d++)
+      q_f32[d] = load1(query, q_off + d, kind) * scale;
+
+    float M = neg_inf;
+    float S = 0.0f;
+    memset(acc, 0, head_dim * sizeof(float));
+
+    for (int kb = 0; kb < seq_len_kv; kb += ATTN_KV_BLOCK) {
+      int n = seq_len_kv - kb < ATTN_KV_BLOCK ? seq_len_kv - kb : ATTN_KV_BLOCK;
+
+      float block_max = neg_inf;
+      for (int j = 0; j < n; j++) {
+        float s = dot_q_k(q_f32, key, (size_t)(kb + j) * head_dim, head_dim,
+                          kind);
+        if (mask_row)
+          s += mask_row[kb + j];
+        scores[j] = s;
+        if (s > block_max)
+          block_max = s;
+      }
+
+      if (block_max == neg_inf)
+        continue;
+
+      if (block_max > M) {
+        if (M != neg_inf) {
+          float alpha = expf(M - block_max);
+          vec_scale(acc, alpha, head_dim);
+          S *= alpha;
+        }
+        M = block_max;
+      }
+
+      /* p_j = exp(s_j - M); fully masked keys contribute exactly zero */
+      const __m256 m_v = _mm256_set1_ps(M);
+      const __m256 ninf_v = _mm256_set1_ps(neg_inf);
+      int j = 0;
+      for (; j + 8 <= n; j += 8) {
+        __m256 s = _mm256_loadu_ps(scores + j);
+        __m256 p = exp256_ps(_mm256_sub_ps(s, m_v));
+        p = _mm256_andnot_ps(_mm256_cmp_ps(s, ninf_v, _CMP_EQ_OQ), p);
+        _mm256_storeu_ps(scores + j, p);
+      }
+      for (; j < n; j++)
+        scores[j] = scores[j] == neg_inf ? 0.0f : expf(scores[j] - M);
+
+      for (j = 0; j < n; j++) {
+        float p = scores[j];
+        if (p == 0.0f)
+          continue;
+        vec_mad(acc, value, (size_t)(kb + j) * head_dim, p, head_dim, kind);
+        S += p;
+      }
+    }
+
+    float S_inv = S > 0.0f ? 1.0f / S : 0.0f;
+    for (int d = 0; d < head_dim; d++)
+      store1(output, q_off + d, acc[d] * S_inv, kind);
+  }
+
+  free(q_f32);
+}
+
+void flash_attention_f32_avx2(float *output, const float *query,
+                              const float *key, const float *value,
+                              int seq_len_q, int seq_len_kv, int head_dim,
+                              float scale, const float *mask) {
+  flash_attention_avx2(output, query, key, value, seq_len_q, seq_len_kv,
+                       head_dim, scale, mask, ELEM_F32);
+}
+
+void flash_attention_bf16_avx2(uint16_t *output, const uint16_t *query,
+                               const uint16_t *key, const uint16_t *value,
+                               int seq_len_q, int seq_len_kv, int head_dim,
+                               float scale, const float *mask) {
+  flash_attention_avx2(output, query, key, value, seq_len_q, seq_len_kv,
+                       head_dim, scale, mask, ELEM_BF16);
+}
+
+void flash_attention_f16_avx2(uint16_t *output, const uint16_t *query,
+                              const uint16_t *key, const uint16_t *value,
+                              int seq_len_q, int seq_len_kv, int head_dim,
+                              float scale, const float *mask) {
+  flash_attention_avx2(output, query, key, value, seq_len_q, seq_len_kv,
+                       head_dim, scale, mask, ELEM_F16);
+}
+
+#endif
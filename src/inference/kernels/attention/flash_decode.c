@@ -0,0 +1,369 @@
+/*
+ * Split-KV Decode Attention - Dispatcher and Scalar Kernels
+ *
+ * Work items are (KV head, range of positions) pairs. An item walks its
+ * range one chunk at a time: the scores of all query heads in the group are
+ * taken against the chunk's keys, the running max is updated once per chunk
+ * so each score costs a single expf, and the chunk's values are folded into
+ * the group's accumulators. Ranges start on page boundaries, so a chunk
+ * never crosses a page. FP16 and INT8 caches are converted a chunk at a
+ * time into FP32 rows.
+ *
+ * Based on "Flash-Decoding for long-context inference" (Dao et al., 2023).
+ */
+
+#include "inference/kernels/attention/flash_decode.h"
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/attention/flash_decode_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Upper bound on ranges per KV head, sizes the partial states in scratch */
+#define FLASH_DECODE_MAX_SPLITS 16
+
+/* Positions per range below which splitting costs more than it saves */
+#define FLASH_DECODE_SPLIT_MIN 256
+
+/* Below this many K/V bytes the whole row stays on the calling thread */
+#define FLASH_DECODE_MT_MIN_BYTES (128 * 1024)
+
+/* ============================================================================
+ * Scalar Kernels
+ * ============================================================================
+ */
+
+static void scores_scalar(const float *q, const float *k, size_t k_stride,
+                          float *scores, int G, int n, int D) {
+  for (int g = 0; g < G; g++) {
+    const float *qg = q + (size_t)g * D;
+    for (int t = 0; t < n; t++) {
+      const float *kt = k + (size_t)t * k_stride;
+      float sum = 0.0f;
+      for (int d = 0; d < D; d++)
+        sum += qg[d] * kt[d];
+      scores[g * FLASH_DECODE_CHUNK + t] = sum;
+    }
+  }
+}
+
+static void accum_scalar(float *acc, const float *p, const float *v,
+                         size_t v_stride, int G, int n, int D) {
+  for (int g = 0; g < G; g++) {
+    float *ag = acc + (size_t)g * D;
+    const float *pg = p + g * FLASH_DECODE_CHUNK;
+    for (int t = 0; t < n; t++) {
+      const float *vt = v + (size_t)t * v_stride;
+      for (int d = 0; d < D; d++)
+        ag[d] += pg[t] * vt[d];
+    }
+  }
+}
+
+static void load_f16_scalar(const uint16_t *src, size_t src_stride,
+                            float *dst, int n, int D) {
+  for (int t = 0; t < n; t++)
+    for (int d = 0; d < D; d++)
+      dst[(size_t)t * D + d] = f16_to_f32(src[(size_t)t * src_stride + d]);
+}
+
+static void load_q8_scalar(const int8_t *src, size_t src_stride,
+                           const float *scales, size_t scale_stride,
+                           float *dst, int n, int D) {
+  for (int t = 0; t < n; t++) {
+    float scale = scales[(size_t)t * scale_stride];
+    for (int d = 0; d < D; d++)
+      dst[(size_t)t * D + d] = (float)src[(size_t)t * src_stride + d] * scale;
+  }
+}
+
+/* ============================================================================
+ * Dispatch
+ * ============================================================================
+ */
+
+typedef void (*scores_fn)(const float *q, const float *k, size_t k_stride,
+                          float *scores, int G, int n, int D);
+typedef void (*accum_fn)(float *acc, const float *p, const float *v,
+                         size_t v_stride, int G, int n, int D);
+typedef void (*load_f16_fn)(const uint16_t *src, size_t src_stride,
+                            float *dst, int n, int D);
+typedef void (*load_q8_fn)(const int8_t *src, size_t src_stride,
+                           const float *scales, size_t scale_stride,
+                           float *dst, int n, int D);
+
+typedef struct {
+  const kv_block_table_t *kv;
+  const float *q; /* [num_heads, D], pre-scaled */
+  float *parts;   /* Partial state per item */
+  int layer;
+  int kv_len;
+  int num_kv_heads;
+  int group; /* Query heads per KV head */
+  int head_dim;
+  bool f16;  /* FP16 cache */
+  bool int8; /* INT8 cache with per-head scales */
+  int num_splits;
+  int split_len;
+  scores_fn scores;
+  accum_fn accum;
+  load_f16_fn load_f16;
+  load_q8_fn load_q8;
+} decode_task_t;
+
+/* Floats of one item's partial state: max[G], sum[G], acc[G, D], scores */
+static size_t part_floats(int group, int head_dim) {
+  return (size_t)group * (2 + head_dim + FLASH_DECODE_CHUNK);
+}
+
+size_t flash_decode_scratch_bytes(int num_heads, int head_dim) {
+  size_t floats = (size_t)num_heads * head_dim +
+                  (size_t)num_heads * FLASH_DECODE_MAX_SPLITS *
+                      (2 + head_dim + FLASH_DECODE_CHUNK);
+  return floats * sizeof(float);
+}
+
+static void decode_item(const decode_task_t *t, int item) {
+  int G = t->group;
+  int D = t->head_dim;
+  int kv_head = item / t->num_splits;
+  int start = (item % t->num_splits) * t->split_len;
+  int end = start + t->split_len < t->kv_len ? start + t->split_len
+                                             : t->kv_len;
+
+  float *m = t->parts + (size_t)item * part_floats(G, D);
+  float *l = m + G;
+  float *acc = l + G;
+  float *scores = acc + (size_t)G * D;
+  for (int g = 0; g < G; g++) {
+    m[g] = -INFINITY;
+    l[g] = 0.0f;
+  }
+  memset(acc, 0, (size_t)G * D * sizeof(float));
+
+  const float *q = t->q + (size_t)kv_head * G * D;
+  size_t row = (size_t)t->num_kv_heads * D;
+  size_t head_offset = (size_t)kv_head * D;
+  int page_tokens = t->kv->pool->page_tokens;
+  float rows_f32[FLASH_DECODE_CHUNK * FLASH_DECODE_MAX_HEAD_DIM];
+
+  for (int pos = start; pos < end;) {
+    int page_end = (pos / page_tokens + 1) * page_tokens;
+    int n = end < page_end ? end - pos : page_end - pos;
+    if (n > FLASH_DECODE_CHUNK)
+      n = FLASH_DECODE_CHUNK;
+
+    const void *k = kv_block_table_key(t->kv, t->layer, pos);
+    const void *v = kv_block_table_value(t->kv, t->layer, pos);
+    if (t->int8) {
+      const float *ks = kv_block_table_key_scales(t->kv, t->layer, pos);
+      t->load_q8((const int8_t *)k + head_offset, row, ks + kv_head,
+                 t->num_kv_heads, rows_f32, n, D);
+      t->scores(q, rows_f32, D, scores, G, n, D);
+    } else if (t->f16) {
+      t->load_f16((const uint16_t *)k + head_offset, row, rows_f32, n, D);
+      t->scores(q, rows_f32, D, scores, G, n, D);
+    } else {
+      t->scores(q, (const float *)k + head_offset, row, scores, G, n, D);
+    }
+
+    /* Online softmax: rescale once per chunk, one expf per score */
+    for (int g = 0; g < G; g++) {
+      float *sg = scores + g * FLASH_DECODE_CHUNK;
+      float m_new = m[g];
+      for (int i = 0; i < n; i++)
+        m_new = sg[i] > m_new ? sg[i] : m_new;
+      if (m_new > m[g]) {
+        float alpha = expf(m[g] - m_new);
+        float *ag = acc + (size_t)g * D;
+        for (int d = 0; d < D; d++)
+          ag[d] *= alpha;
+        l[g] *= alpha;
+        m[g] = m_new;
+      }
+      for (int i = 0; i < n; i++) {
+        sg[i] = expf(sg[i] - m_new);
+        l[g] += sg[i];
+      }
+    }
+
+    if (t->int8) {
+      const float *vs = kv_block_table_value_scales(t->kv, t->layer, pos);
+      t->load_q8((const int8_t *)v + head_offset, row, vs + kv_head,
+                 t->num_kv_heads, rows_f32, n, D);
+      t->accum(acc, scores, rows_f32, D, G, n, D);
+    } else if (t->f16) {
+      t->load_f16((const uint16_t *)v + head_offset, row, rows_f32, n, D);
+      t->accum(acc, scores, rows_f32, D, G, n, D);
+    } else {
+      t->accum(acc, scores, (const float *)v + head_offset, row, G, n, D);
+    }
+    pos += n;
+  }
+}
+
+static void decode_range(void *arg, int start, int end) {
+  const decode_task_t *t = (const decode_task_t *)arg;
+  for (int item = start; item < end; item++)
+    decode_item(t, item);
+}
+
+/* Merge the ranges of head h into out[D] */
+static void merge_head(const decode_task_t *t, int h, float *out) {
+  int G = t->group;
+  int D = t->head_dim;
+  int kv_head = h / G;
+  int g = h % G;
+  size_t stride = part_floats(G, D);
+  const float *first = t->parts + (size_t)kv_head * t->num_splits * stride;
+
+  float m = -INFINITY;
+  for (int s = 0; s < t->num_splits; s++) {
+    float ms = first[s * stride + g];
+    m = ms > m ? ms : m;
+  }
+
+  memset(out, 0, (size_t)D * sizeof(float));
+  float sum = 0.0f;
+  for (int s = 0; s < t->num_splits; s++) {
+    const float *part = first + s * stride;
+    if (part[g] == -INFINITY)
+      continue;
+    float w = expf(part[g] - m);
+    const float *acc = part + 2 * G + (size_t)g * D;
+    for (int d = 0; d < D; d++)
+      out[d] += w * acc[d];
+    sum += w * part[G + g];
+  }
+
+  float inv = sum > 0.0f ? 1.0f / sum : 0.0f;
+  for (int d = 0; d < D; d++)
+    out[d] *= inv;
+}
+
+static int choose_splits(int kv_len, int num_kv_heads, int page_tokens,
+                         size_t kv_bytes, int *split_len) {
+  int threads = threadpool_get_num_threads();
+  int splits = 1;
+  if (threads > 1 && kv_bytes >= FLASH_DECODE_MT_MIN_BYTES) {
+    /* About two items per thread, for balance */
+    splits = (2 * threads + num_kv_heads - 1) / num_kv_heads;
+    int by_len = kv_len / FLASH_DECODE_SPLIT_MIN;
+    if (splits > by_len)
+      splits = by_len;
+    if (splits > FLASH_DECODE_MAX_SPLITS)
+      splits = FLASH_DECODE_MAX_SPLITS;
+    if (splits < 1)
+      splits = 1;
+  }
+
+  int len = (kv_len + splits - 1) / splits;
+  len = (len + page_tokens - 1) / page_tokens * page_tokens;
+  *split_len = len;
+  return (kv_len + len - 1) / len;
+}
+
+static bool flash_decode_run(void *out, const void *q,
+                             const kv_block_table_t *kv, int layer,
+                             int kv_len, int num_heads, int num_kv_heads,
+                             int head_dim, float scale, void *scratch,
+                             bool f16) {
+  if (!out || !q || !kv || num_heads <= 0 || num_kv_heads <= 0 ||
+      num_heads % num_kv_heads != 0 || head_dim <= 0 ||
+      head_dim > FLASH_DECODE_MAX_HEAD_DIM)
+    return false;
+
+  int q_size = num_heads * head_dim;
+  if (kv_len <= 0) {
+    memset(out, 0, (size_t)q_size * (f16 ? sizeof(uint16_t) : sizeof(float)));
+    return true;
+  }
+
+  void *owned = NULL;
+  if (!scratch) {
+    owned = malloc(flash_decode_scratch_bytes(num_heads, head_dim));
+    if (!owned)
+      return false;
+    scratch = owned;
+  }
+
+  /* The scale is folded into the query once instead of into every score */
+  float *q32 = (float *)scratch;
+  if (f16)
+    for (int i = 0; i < q_size; i++)
+      q32[i] = f16_to_f32(((const uint16_t *)q)[i]) * scale;
+  else
+    for (int i = 0; i < q_size; i++)
+      q32[i] = ((const float *)q)[i] * scale;
+
+  decode_task_t task;
+  task.kv = kv;
+  task.q = q32;
+  task.parts = q32 + q_size;
+  task.layer = layer;
+  task.kv_len = kv_len;
+  task.num_kv_heads = num_kv_heads;
+  task.group = num_heads / num_kv_heads;
+  task.head_dim = head_dim;
+  task.int8 = kv->pool->elem_size == KV_CACHE_INT8;
+  task.f16 = f16 && !task.int8;
+  task.scores = scores_scalar;
+  task.accum = accum_scalar;
+  task.load_f16 = load_f16_scalar;
+  task.load_q8 = load_q8_scalar;
+
+  flash_decode_caps_t caps = flash_decode_get_capabilities();
+  if (caps.has_neon) {
+    task.scores = flash_decode_scores_kernel;
+    task.accum = flash_decode_accum_kernel;
+    task.load_f16 = flash_decode_load_f16_kernel;
+    task.load_q8 = flash_decode_load_q8_kernel;
+  } else if (caps.has_avx2) {
+    task.scores = flash_decode_scores_kernel_avx2;
+    task.accum = flash_decode_accum_kernel_avx2;
+    task.load_f16 = flash_decode_load_f16_kernel_avx2;
+    task.load_q8 = flash_decode_load_q8_kernel_avx2;
+  }
+
+  size_t kv_bytes =
+      (size_t)2 * kv_len * num_kv_heads * head_dim * kv->pool->elem_size;
+  task.num_splits = choose_splits(kv_len, num_kv_heads,
+                                  kv->pool->page_tokens, kv_bytes,
+                                  &task.split_len);
+
+  int items = num_kv_heads * task.num_splits;
+  threadpool_t *pool = items > 1 && kv_bytes >= FLASH_DECODE_MT_MIN_BYTES
+                           ? threadpool_global()
+                           : NULL;
+  threadpool_parallel_for(pool, 0, items, 1, decode_range, &task);
+
+  float merged[FLASH_DECODE_MAX_HEAD_DIM];
+  for (int h = 0; h < num_heads; h++) {
+    size_t offset = (size_t)h * head_dim;
+    if (f16) {
+      merge_head(&task, h, merged);
+      f32_to_f16_array(merged, (uint16_t *)out + offset, (size_t)head_dim);
+    } else {
+      merge_head(&task, h, (float *)out + offset);
+    }
+  }
+
+  free(owned);
+  return true;
+}
+
+bool flash_decode_f32(float *out, const float *q, const kv_block_table_t *kv,
+                      int layer, int kv_len, int num_heads, int num_kv_heads,
+                      int head_dim, float scale, void *scratch) {
+  return flash_decode_run(out, q, kv, layer, kv_len, num_heads, num_kv_heads,
+                          head_dim, scale, scratch, false);
+}
+
+bool flash_decode_f16(uint16_t *out, const uint16_t *q,
+                      const kv_block_table_t *kv, int layer, int kv_len,
+                      int num_heads, int num_kv_heads, int head_dim,
+                      float scale, void *scratch) {
+  return flash_decode_run(out, q, kv, layer, kv_len, num_heads, num_kv_heads,
+                          head_dim, scale, scratch, true);
+}
@@ -0,0 +1,65 @@
+/*
+ * Split-KV Decode Attention (Flash-Decoding) - Public API
+ *
+ * One query row attends over the first kv_len positions of a paged K/V
+ * cache. At long contexts the cached positions dominate the work, so they
+ * are split into ranges that run on the shared thread pool. Each range
+ * keeps a partial online-softmax state (running max, sum and weighted V)
+ * per head, and the partial states are merged at the end.
+ *
+ * Query heads that share a KV head (GQA) are evaluated together: every
+ * K/V row is read from the cache once per group, not once per query head.
+ *
+ * Either entry point also reads an INT8 pool (KV_CACHE_INT8), dequantizing
+ * each row with its per-head scale as it is loaded.
+ */
+
+#ifndef FLASH_DECODE_H
+#define FLASH_DECODE_H
+
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest head_dim the kernels accept */
+#define FLASH_DECODE_MAX_HEAD_DIM 256
+
+/* Scratch bytes flash_decode_*() needs for one query row */
+size_t flash_decode_scratch_bytes(int num_heads, int head_dim);
+
+/*
+ * out = softmax(q K^T * scale) V for one query row (FP32 or INT8 cache)
+ *
+ * Parameters:
+ *   out:          [num_heads, head_dim] output
+ *   q:            [num_heads, head_dim] query; head h uses KV head
+ *                 h / (num_heads / num_kv_heads)
+ *   kv:           block table with positions [0, kv_len) mapped
+ *   layer:        layer whose K/V are read
+ *   kv_len:       positions attended
+ *   scale:        score scale (typically 1/sqrt(head_dim))
+ *   scratch:      flash_decode_scratch_bytes() bytes, or NULL to allocate
+ *
+ * Returns: false if head_dim exceeds FLASH_DECODE_MAX_HEAD_DIM, num_heads is
+ * not a multiple of num_kv_heads, or scratch could not be allocated
+ */
+bool flash_decode_f32(float *out, const float *q, const kv_block_table_t *kv,
+                      int layer, int kv_len, int num_heads, int num_kv_heads,
+                      int head_dim, float scale, void *scratch);
+
+/* As flash_decode_f32() with FP16 query and output, FP16 or INT8 cache */
+bool flash_decode_f16(uint16_t *out, const uint16_t *q,
+                      const kv_block_table_t *kv, int layer, int kv_len,
+                      int num_heads, int num_kv_heads, int head_dim,
+                      float scale, void *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,176 @@
+/*
+ * AVX2/FMA Split-KV Decode Attention Kernels on x86-64
+ *
+ * Scores are taken four keys at a time so each load of the query is shared;
+ * the accumulation keeps an 8-wide strip of a head's output in a register
+ * across every position of the chunk.
+ */
+
+#include "inference/kernels/attention/flash_decode_kernels.h"
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+AVX2_INLINE float hsum(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+  return _mm_cvtss_f32(lo);
+}
+
+AVX2_INLINE float dot_tail(const float *a, const float *b, int d, int D) {
+  float sum = 0.0f;
+  for (; d < D; d++)
+    sum += a[d] * b[d];
+  return sum;
+}
+
+void flash_decode_scores_kernel_avx2(const float *q, const float *k,
+                                     size_t k_stride, float *scores, int G,
+                                     int n, int D) {
+  int D8 = D & ~7;
+  for (int g = 0; g < G; g++) {
+    const float *qg = q + (size_t)g * D;
+    float *sg = scores + g * FLASH_DECODE_CHUNK;
+    int t = 0;
+    for (; t + 4 <= n; t += 4) {
+      const float *k0 = k + (size_t)t * k_stride;
+      const float *k1 = k0 + k_stride;
+      const float *k2 = k1 + k_stride;
+      const float *k3 = k2 + k_stride;
+      __m256 s0 = _mm256_setzero_ps();
+      __m256 s1 = _mm256_setzero_ps();
+      __m256 s2 = _mm256_setzero_ps();
+      __m256 s3 = _mm256_setzero_ps();
+      for (int d = 0; d < D8; d += 8) {
+        __m256 qv = _mm256_loadu_ps(qg + d);
+        s0 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k0 + d), s0);
+        s1 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k1 + d), s1);
+        s2 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k2 + d), s2);
+        s3 = _mm256_fmadd_ps(qv, _mm256_loadu_ps(k3 + d), s3);
+      }
+      sg[t] = hsum(s0) + dot_tail(qg, k0, D8, D);
+      sg[t + 1] = hsum(s1) + dot_tail(qg, k1, D8, D);
+      sg[t + 2] = hsum(s2) + dot_tail(qg, k2, D8, D);
+      sg[t + 3] = hsum(s3) + dot_tail(qg, k3, D8, D);
+    }
+    for (; t < n; t++) {
+      const float *kt = k + (size_t)t * k_stride;
+      __m256 s = _mm256_setzero_ps();
+      for (int d = 0; d < D8; d += 8)
+        s = _mm256_fmadd_ps(_mm256_loadu_ps(qg + d), _mm256_loadu_ps(kt + d),
+                            s);
+      sg[t] = hsum(s) + dot_tail(qg, kt, D8, D);
+    }
+  }
+}
+
+void flash_decode_accum_kernel_avx2(float *acc, const float *p,
+                                    const float *v, size_t v_stride, int G,
+                                    int n, int D) {
+  int D8 = D & ~7;
+  for (int g = 0; g < G; g++) {
+    float *ag = acc + (size_t)g * D;
+    const float *pg = p + g * FLASH_DECODE_CHUNK;
+    for (int d = 0; d < D8; d += 8) {
+      __m256 a = _mm256_loadu_ps(ag + d);
+      for (int t = 0; t < n; t++)
+        a = _mm256_fmadd_ps(_mm256_set1_ps(pg[t]),
+                            _mm256_loadu_ps(v + (size_t)t * v_stride + d), a);
+      _mm256_storeu_ps(ag + d, a);
+    }
+    for (int d = D8; d < D; d++)
+      for (int t = 0; t < n; t++)
+        ag[d] += pg[t] * v[(size_t)t * v_stride + d];
+  }
+}
+
+void flash_decode_load_f16_kernel_avx2(const uint16_t *src, size_t src_stride,
+                                       float *dst, int n, int D) {
+  int D8 = D & ~7;
+  for (int t = 0; t < n; t++) {
+    const uint16_t *s = src + (size_t)t * src_stride;
+    float *o = dst + (size_t)t * D;
+    for (int d = 0; d < D8; d += 8) {
+      __m128i h = _mm_loadu_si128((const __m128i *)(s + d));
+      _mm256_storeu_ps(o + d, _mm256_cvtph_ps(h));
+    }
+    for (int d = D8; d < D; d++)
+      o[d] = _cvtsh_ss(s[d]);
+  }
+}
+
+void flash_decode_load_q8_kernel_avx2(const int8_t *src, size_t src_stride,
+                                      const float *scales,
+                                      size_t scale_stride, float *dst, int n,
+                                      int D) {
+  int D8 = D & ~7;
+  for (int t = 0; t < n; t++) {
+    const int8_t *s = src + (size_t)t * src_stride;
+    float *o = dst + (size_t)t * D;
+    float scale = scales[(size_t)t * scale_stride];
+    __m256 vscale = _mm256_set1_ps(scale);
+    for (int d = 0; d < D8; d += 8) {
+      __m128i b = _mm_loadl_epi64((const __m128i *)(s + d));
+      __m256 x = _mm256_cvtepi32_ps(_mm256_cvtepi8_epi32(b));
+      _mm256_storeu_ps(o + d, _mm256_mul_ps(x, vscale));
+    }
+    for (int d = D8; d < D; d++)
+      o[d] = (float)s[d] * scale;
+  }
+}
+
+#else
+
+void flash_decode_scores_kernel_avx2(const float *q, const float *k,
+                                     size_t k_stride, float *scores, int G,
+                                     int n, int D) {
+  (void)q;
+  (void)k;
+  (void)k_stride;
+  (void)scores;
+  (void)G;
+  (void)n;
+  (void)D;
+}
+
+void flash_decode_accum_kernel_avx2(float *acc, const float *p,
+                                    const float *v, size_t v_stride, int G,
+                                    int n, int D) {
+  (void)acc;
+  (void)p;
+  (void)v;
+  (void)v_stride;
+  (void)G;
+  (void)n;
+  (void)D;
+}
+
+void flash_decode_load_f16_kernel_avx2(const uint16_t *src, size_t src_stride,
+                                       float *dst, int n, int D) {
+  (void)src;
+  (void)src_stride;
+  (void)dst;
+  (void)n;
+  (void)D;
+}
+
+void flash_decode_load_q8_kernel_avx2(const int8_t *src, size_t src_stride,
+                                      const float *scales,
+                                      size_t scale_stride, float *dst, int n,
+                                      int D) {
+  (void)src;
+  (void)src_stride;
+  (void)scales;
+  (void)scale_stride;
+  (void)dst;
+  (void)n;
+  (void)D;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/*
+ * Split-KV decode attention kernel interface for architecture-specific
+ * implementations
+ *
+ * The kernels work on a chunk of n <= FLASH_DECODE_CHUNK consecutive
+ * positions and the G query heads of one KV head. K/V rows are FP32 at a
+ * row stride in floats: either the cache page itself or a copy converted
+ * from FP16 or dequantized from INT8.
+ * Scores for head g and position t live at scores[g * FLASH_DECODE_CHUNK + t].
+ */
+
+#ifndef FLASH_DECODE_KERNELS_H
+#define FLASH_DECODE_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  bool has_neon;
+  bool has_avx2;
+} flash_decode_caps_t;
+
+flash_decode_caps_t flash_decode_get_capabilities(void);
+
+/* Positions scored and accumulated per step, one KV page by default */
+#define FLASH_DECODE_CHUNK 16
+
+/* scores[g][t] = q[g] . k[t] for G heads of q ([G, D]) and n keys */
+void flash_decode_scores_kernel(const float *q, const float *k,
+                                size_t k_stride, float *scores, int G, int n,
+                                int D);
+
+/* acc[g] += sum over t of p[g][t] * v[t], acc is [G, D] */
+void flash_decode_accum_kernel(float *acc, const float *p, const float *v,
+                               size_t v_stride, int G, int n, int D);
+
+/* dst[t] = src[t] for n FP16 rows of D values at src_stride, into [n, D] */
+void flash_decode_load_f16_kernel(const uint16_t *src, size_t src_stride,
+                                  float *dst, int n, int D);
+
+/*
+ * dst[t] = src[t] * scales[t * scale_stride] for n INT8 rows of D values at
+ * src_stride, into [n, D]
+ */
+void flash_decode_load_q8_kernel(const int8_t *src, size_t src_stride,
+                                 const float *scales, size_t scale_stride,
+                                 float *dst, int n, int D);
+
+void flash_decode_scores_kernel_avx2(const float *q, const float *k,
+                                     size_t k_stride, float *scores, int G,
+                                     int n, int D);
+void flash_decode_accum_kernel_avx2(float *acc, const float *p,
+                                    const float *v, size_t v_stride, int G,
+                                    int n, int D);
+void flash_decode_load_f16_kernel_avx2(const uint16_t *src, size_t src_stride,
+                                       float *dst, int n, int D);
+void flash_decode_load_q8_kernel_avx2(const int8_t *src, size_t src_stride,
+                                      const float *scales,
+                                      size_t scale_stride, float *dst, int n,
+                                      int D);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
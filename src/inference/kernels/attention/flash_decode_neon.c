@@ -0,0 +1,180 @@
+/*
+ * NEON Split-KV Decode Attention Kernels on ARM64
+ *
+ * Same structure as the AVX2 kernels: four keys share each query load when
+ * scoring, and 4-wide output strips stay in registers while the chunk's
+ * values are accumulated.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/kernels/attention/flash_decode_kernels.h"
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAS_NEON 1
+#else
+#define HAS_NEON 0
+#endif
+
+flash_decode_caps_t flash_decode_get_capabilities(void) {
+  flash_decode_caps_t caps = {0};
+  caps.has_neon = caps_has(CAP_NEON);
+  caps.has_avx2 = caps_has(CAP_AVX2);
+  return caps;
+}
+
+#if HAS_NEON
+
+#define NEON_INLINE static inline __attribute__((always_inline))
+
+NEON_INLINE float dot_tail(const float *a, const float *b, int d, int D) {
+  float sum = 0.0f;
+  for (; d < D; d++)
+    sum += a[d] * b[d];
+  return sum;
+}
+
+void flash_decode_scores_kernel(const float *q, const float *k,
+                                size_t k_stride, float *scores, int G, int n,
+                                int D) {
+  int D4 = D & ~3;
+  for (int g = 0; g < G; g++) {
+    const float *qg = q + (size_t)g * D;
+    float *sg = scores + g * FLASH_DECODE_CHUNK;
+    int t = 0;
+    for (; t + 4 <= n; t += 4) {
+      const float *k0 = k + (size_t)t * k_stride;
+      const float *k1 = k0 + k_stride;
+      const float *k2 = k1 + k_stride;
+      const float *k3 = k2 + k_stride;
+      float32x4_t s0 = vdupq_n_f32(0.0f);
+      float32x4_t s1 = vdupq_n_f32(0.0f);
+      float32x4_t s2 = vdupq_n_f32(0.0f);
+      float32x4_t s3 = vdupq_n_f32(0.0f);
+      for (int d = 0; d < D4; d += 4) {
+        float32x4_t qv = vld1q_f32(qg + d);
+        s0 = vfmaq_f32(s0, qv, vld1q_f32(k0 + d));
+        s1 = vfmaq_f32(s1, qv, vld1q_f32(k1 + d));
+        s2 = vfmaq_f32(s2, qv, vld1q_f32(k2 + d));
+        s3 = vfmaq_f32(s3, qv, vld1q_f32(k3 + d));
+      }
+      sg[t] = vaddvq_f32(s0) + dot_tail(qg, k0, D4, D);
+      sg[t + 1] = vaddvq_f32(s1) + dot_tail(qg, k1, D4, D);
+      sg[t + 2] = vaddvq_f32(s2) + dot_tail(qg, k2, D4, D);
+      sg[t + 3] = vaddvq_f32(s3) + dot_tail(qg, k3, D4, D);
+    }
+    for (; t < n; t++) {
+      const float *kt = k + (size_t)t * k_stride;
+      float32x4_t s = vdupq_n_f32(0.0f);
+      for (int d = 0; d < D4; d += 4)
+        s = vfmaq_f32(s, vld1q_f32(qg + d), vld1q_f32(kt + d));
+      sg[t] = vaddvq_f32(s) + dot_tail(qg, kt, D4, D);
+    }
+  }
+}
+
+void flash_decode_accum_kernel(float *acc, const float *p, const float *v,
+                               size_t v_stride, int G, int n, int D) {
+  int D4 = D & ~3;
+  for (int g = 0; g < G; g++) {
+    float *ag = acc + (size_t)g * D;
+    const float *pg = p + g * FLASH_DECODE_CHUNK;
+    for (int d = 0; d < D4; d += 4) {
+      float32x4_t a = vld1q_f32(ag + d);
+      for (int t = 0; t < n; t++)
+        a = vfmaq_n_f32(a, vld1q_f32(v + (size_t)t * v_stride + d), pg[t]);
+      vst1q_f32(ag + d, a);
+    }
+    for (int d = D4; d < D; d++)
+      for (int t = 0; t < n; t++)
+        ag[d] += pg[t] * v[(size_t)t * v_stride + d];
+  }
+}
+
+void flash_decode_load_f16_kernel(const uint16_t *src, size_t src_stride,
+                                  float *dst, int n, int D) {
+  int D8 = D & ~7;
+  for (int t = 0; t < n; t++) {
+    const uint16_t *s = src + (size_t)t * src_stride;
+    float *o = dst + (size_t)t * D;
+    for (int d = 0; d < D8; d += 8) {
+      float16x8_t h = vld1q_f16((const float16_t *)(s + d));
+      vst1q_f32(o + d, vcvt_f32_f16(vget_low_f16(h)));
+      vst1q_f32(o + d + 4, vcvt_f32_f16(vget_high_f16(h)));
+    }
+    for (int d = D8; d < D; d++) {
+      float16_t h;
+      memcpy(&h, &s[d], sizeof(h));
+      o[d] = (float)h;
+    }
+  }
+}
+
+void flash_decode_load_q8_kernel(const int8_t *src, size_t src_stride,
+                                 const float *scales, size_t scale_stride,
+                                 float *dst, int n, int D) {
+  int D8 = D & ~7;
+  for (int t = 0; t < n; t++) {
+    const int8_t *s = src + (size_t)t * src_stride;
+    float *o = dst + (size_t)t * D;
+    float scale = scales[(size_t)t * scale_stride];
+    for (int d = 0; d < D8; d += 8) {
+      int16x8_t w = vmovl_s8(vld1_s8(s + d));
+      float32x4_t lo = vcvtq_f32_s32(vmovl_s16(vget_low_s16(w)));
+      float32x4_t hi = vcvtq_f32_s32(vmovl_s16(vget_high_s16(w)));
+      vst1q_f32(o + d, vmulq_n_f32(lo, scale));
+      vst1q_f32(o + d + 4, vmulq_n_f32(hi, scale));
+    }
+    for (int d = D8; d < D; d++)
+      o[d] = (float)s[d] * scale;
+  }
+}
+
+#else
+
+void flash_decode_scores_kernel(const float *q, const float *k,
+                                size_t k_stride, float *scores, int G, int n,
+                                int D) {
+  (void)q;
+  (void)k;
+  (void)k_stride;
+  (void)scores;
+  (void)G;
+  (void)n;
+  (void)D;
+}
+
+void flash_decode_accum_kernel(float *acc, const float *p, const float *v,
+                               size_t v_stride, int G, int n, int D) {
+  (void)acc;
+  (void)p;
+  (void)v;
+  (void)v_stride;
+  (void)G;
+  (void)n;
+  (void)D;
+}
+
+void flash_decode_load_f16_kernel(const uint16_t *src, size_t src_stride,
+                                  float *dst, int n, int D) {
+  (void)src;
+  (void)src_stride;
+  (void)dst;
+  (void)n;
+  (void)D;
+}
+
+void flash_decode_load_q8_kernel(const int8_t *src, size_t src_stride,
+                                 const float *scales, size_t scale_stride,
+                                 float *dst, int n, int D) {
+  (void)src;
+  (void)src_stride;
+  (void)scales;
+  (void)scale_stride;
+  (void)dst;
+  (void)n;
+  (void)D;
+}
+
+#endif
@@ -0,0 +1,388 @@
+/*
+ * Tiled Causal Prefill Attention - Dispatcher and Scalar Kernels
+ *
+ * Work items are (KV head, block of query positions) pairs. An item stacks
+ * the group's query heads for its positions into one [M, D] tile, then
+ * walks the cache in tiles of FLASH_PREFILL_BLOCK_N positions up to its
+ * last query: the tile's keys are converted once into a [D, n] panel so
+ * S = Q K^T is a plain GEMM, the causal mask is applied only on tiles that
+ * cross the diagonal, and P V is a second GEMM added into the output after
+ * the online-softmax rescale.
+ *
+ * The GEMMs run on the calling thread through the same micro-kernels as
+ * gemm_f32(), without packing, and FP16 or INT8 rows are converted with
+ * the split-KV decode kernels. Each pool worker takes a fixed slot of scratch
+ * and strides through the items, so no buffer is shared between threads
+ * and nothing is allocated per tile.
+ *
+ * Based on "FlashAttention: Fast and Memory-Efficient Exact Attention with
+ * IO-Awareness" (Dao et al., 2022).
+ */
+
+#include "inference/kernels/attention/flash_prefill.h"
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/attention/flash_decode_kernels.h"
+#include "inference/kernels/attention/flash_prefill_kernels.h"
+#include "inference/kernels/gemm/gemm_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Below this many score multiply-adds the whole prefill stays on one thread */
+#define FLASH_PREFILL_MT_MIN_MACS (1 << 20)
+
+/* Scratch slots start on cache lines */
+#define FLASH_PREFILL_ALIGN 16
+
+/* ============================================================================
+ * Scalar Kernels
+ * ============================================================================
+ */
+
+static void gemm_tile_scalar(const float *A, const float *B, float *C, int M,
+                             int N, int K) {
+  for (int i = 0; i < M; i++) {
+    float *c = C + (size_t)i * N;
+    memset(c, 0, (size_t)N * sizeof(float));
+    for (int k = 0; k < K; k++) {
+      float a = A[(size_t)i * K + k];
+      const float *b = B + (size_t)k * N;
+      for (int j = 0; j < N; j++)
+        c[j] += a * b[j];
+    }
+  }
+}
+
+static void load_f16_scalar(const uint16_t *src, size_t src_stride,
+                            float *dst, int n, int D) {
+  for (int t = 0; t < n; t++)
+    for (int d = 0; d < D; d++)
+      dst[(size_t)t * D + d] = f16_to_f32(src[(size_t)t * src_stride + d]);
+}
+
+static void load_q8_scalar(const int8_t *src, size_t src_stride,
+                           const float *scales, size_t scale_stride,
+                           float *dst, int n, int D) {
+  for (int t = 0; t < n; t++) {
+    float scale = scales[(size_t)t * scale_stride];
+    for (int d = 0; d < D; d++)
+      dst[(size_t)t * D + d] = (float)src[(size_t)t * src_stride + d] * scale;
+  }
+}
+
+static float exp_scalar(float *x, int n, float max) {
+  float sum = 0.0f;
+  for (int j = 0; j < n; j++) {
+    x[j] = expf(x[j] - max);
+    sum += x[j];
+  }
+  return sum;
+}
+
+/* ============================================================================
+ * Dispatch
+ * ============================================================================
+ */
+
+typedef void (*gemm_tile_fn)(const float *A, const float *B, float *C, int M,
+                             int N, int K);
+typedef void (*load_f16_fn)(const uint16_t *src, size_t src_stride,
+                            float *dst, int n, int D);
+typedef void (*load_q8_fn)(const int8_t *src, size_t src_stride,
+                           const float *scales, size_t scale_stride,
+                           float *dst, int n, int D);
+typedef float (*exp_fn)(float *x, int n, float max);
+
+typedef struct {
+  const kv_block_table_t *kv;
+  const void *q;
+  void *out;
+  float *scratch;
+  float scale;
+  int layer;
+  int start_pos;
+  int num_tokens;
+  int num_kv_heads;
+  int group; /* Query heads per KV head */
+  int head_dim;
+  int block_q; /* Query positions per item */
+  int num_items;
+  int num_slots;
+  bool f16;  /* FP16 queries, output and cache */
+  bool int8; /* INT8 cache with per-head scales */
+  gemm_tile_fn gemm;
+  load_f16_fn load_f16;
+  load_q8_fn load_q8;
+  exp_fn exp;
+} prefill_task_t;
+
+static size_t align_floats(size_t n) {
+  return (n + FLASH_PREFILL_ALIGN - 1) / FLASH_PREFILL_ALIGN *
+         FLASH_PREFILL_ALIGN;
+}
+
+static int block_positions(int group) {
+  int block = FLASH_PREFILL_BLOCK_M / group;
+  return block > 0 ? block : 1;
+}
+
+/*
+ * Floats of one worker's slot: Q, O and P.V tiles [M, D], the key panel
+ * [D, N], the value rows [N, D], scores [M, N], then max and sum per row
+ */
+static size_t slot_floats(int group, int head_dim) {
+  size_t M = (size_t)group * block_positions(group);
+  size_t N = FLASH_PREFILL_BLOCK_N;
+  return 3 * align_floats(M * head_dim) + 2 * align_floats(N * head_dim) +
+         align_floats(M * N) + 2 * align_floats(M);
+}
+
+size_t flash_prefill_scratch_bytes(int num_heads, int num_kv_heads,
+                                   int head_dim) {
+  if (num_kv_heads <= 0 || num_heads < num_kv_heads)
+    return 0;
+  size_t slots = (size_t)threadpool_get_num_threads();
+  size_t floats = slots * slot_floats(num_heads / num_kv_heads, head_dim);
+  return (floats + FLASH_PREFILL_ALIGN) * sizeof(float);
+}
+
+/* dst[t] = K or V of kv_head at positions [pos, pos + n), as [n, D] FP32 */
+static void gather_rows(const prefill_task_t *t, bool value, int kv_head,
+                        int pos, int n, float *dst) {
+  int D = t->head_dim;
+  size_t row = (size_t)t->num_kv_heads * D;
+  size_t head_offset = (size_t)kv_head * D;
+  int page_tokens = t->kv->pool->page_tokens;
+  int end = pos + n;
+
+  while (pos < end) {
+    int page_end = (pos / page_tokens + 1) * page_tokens;
+    int count = end < page_end ? end - pos : page_end - pos;
+    const void *src = value ? kv_block_table_value(t->kv, t->layer, pos)
+                            : kv_block_table_key(t->kv, t->layer, pos);
+    if (t->int8) {
+      const float *scales =
+          value ? kv_block_table_value_scales(t->kv, t->layer, pos)
+                : kv_block_table_key_scales(t->kv, t->layer, pos);
+      t->load_q8((const int8_t *)src + head_offset, row, scales + kv_head,
+                 t->num_kv_heads, dst, count, D);
+    } else if (t->f16) {
+      t->load_f16((const uint16_t *)src + head_offset, row, dst, count, D);
+    } else {
+      const float *s = (const float *)src + head_offset;
+      for (int i = 0; i < count; i++)
+        memcpy(dst + (size_t)i * D, s + i * row, (size_t)D * sizeof(float));
+    }
+    dst += (size_t)count * D;
+    pos += count;
+  }
+}
+
+static void prefill_item(const prefill_task_t *t, int item, float *slot) {
+  int G = t->group;
+  int D = t->head_dim;
+  int kv_head = item % t->num_kv_heads;
+  int i0 = item / t->num_kv_heads * t->block_q;
+  int i1 = i0 + t->block_q < t->num_tokens ? i0 + t->block_q : t->num_tokens;
+  int nq = i1 - i0;
+  int M = G * nq;
+  size_t tile = align_floats((size_t)G * t->block_q * D);
+  size_t kv_tile = align_floats((size_t)FLASH_PREFILL_BLOCK_N * D);
+
+  float *qs = slot;
+  float *o = qs + tile;
+  float *pv = o + tile;
+  float *kt = pv + tile;
+  float *rows = kt + kv_tile;
+  float *s = rows + kv_tile;
+  float *m = s + align_floats((size_t)G * t->block_q * FLASH_PREFILL_BLOCK_N);
+  float *l = m + align_floats((size_t)G * t->block_q);
+
+  /* Row r = g * nq + i is query head kv_head * G + g at position i0 + i */
+  size_t q_stride = (size_t)t->num_kv_heads * G * D;
+  for (int g = 0; g < G; g++) {
+    size_t offset = (size_t)i0 * q_stride + (size_t)(kv_head * G + g) * D;
+    float *dst = qs + (size_t)g * nq * D;
+    if (t->f16) {
+      t->load_f16((const uint16_t *)t->q + offset, q_stride, dst, nq, D);
+    } else {
+      const float *src = (const float *)t->q + offset;
+      for (int i = 0; i < nq; i++)
+        memcpy(dst + (size_t)i * D, src + i * q_stride,
+               (size_t)D * sizeof(float));
+    }
+  }
+  /* The scale is folded into the queries instead of into every score */
+  for (size_t i = 0; i < (size_t)M * D; i++)
+    qs[i] *= t->scale;
+
+  for (int r = 0; r < M; r++) {
+    m[r] = -INFINITY;
+    l[r] = 0.0f;
+  }
+  memset(o, 0, (size_t)M * D * sizeof(float));
+
+  int first_pos = t->start_pos + i0;
+  int kv_end = t->start_pos + i1;
+  for (int c0 = 0; c0 < kv_end; c0 += FLASH_PREFILL_BLOCK_N) {
+    int n = kv_end - c0 < FLASH_PREFILL_BLOCK_N ? kv_end - c0
+                                                : FLASH_PREFILL_BLOCK_N;
+
+    gather_rows(t, false, kv_head, c0, n, rows);
+    for (int j = 0; j < n; j++)
+      for (int d = 0; d < D; d++)
+        kt[(size_t)d * n + j] = rows[(size_t)j * D + d];
+    t->gemm(qs, kt, s, M, n, D);
+
+    /* Only tiles crossing the diagonal hold keys after some query */
+    if (c0 + n - 1 > first_pos) {
+      for (int r = 0; r < M; r++) {
+        int visible = first_pos + r % nq + 1 - c0;
+        float *sr = s + (size_t)r * n;
+        for (int j = visible > 0 ? visible : 0; j < n; j++)
+          sr[j] = -INFINITY;
+      }
+    }
+
+    /* Online softmax: rescale each row once per tile */
+    for (int r = 0; r < M; r++) {
+      float *sr = s + (size_t)r * n;
+      float m_new = m[r];
+      for (int j = 0; j < n; j++)
+        m_new = sr[j] > m_new ? sr[j] : m_new;
+      if (m_new == -INFINITY) {
+        memset(sr, 0, (size_t)n * sizeof(float));
+        continue;
+      }
+      if (m_new > m[r]) {
+        float alpha = expf(m[r] - m_new);
+        float *orow = o + (size_t)r * D;
+        for (int d = 0; d < D; d++)
+          orow[d] *= alpha;
+        l[r] *= alpha;
+        m[r] = m_new;
+      }
+      l[r] += t->exp(sr, n, m_new);
+    }
+
+    gather_rows(t, true, kv_head, c0, n, rows);
+    t->gemm(s, rows, pv, M, D, n);
+    for (size_t i = 0; i < (size_t)M * D; i++)
+      o[i] += pv[i];
+  }
+
+  for (int r = 0; r < M; r++) {
+    int g = r / nq;
+    int i = r % nq;
+    float *orow = o + (size_t)r * D;
+    float inv = l[r] > 0.0f ? 1.0f / l[r] : 0.0f;
+    for (int d = 0; d < D; d++)
+      orow[d] *= inv;
+    size_t offset =
+        (size_t)(i0 + i) * q_stride + (size_t)(kv_head * G + g) * D;
+    if (t->f16)
+      f32_to_f16_array(orow, (uint16_t *)t->out + offset, (size_t)D);
+    else
+      memcpy((float *)t->out + offset, orow, (size_t)D * sizeof(float));
+  }
+}
+
+/* Slot s takes items s, s + num_slots, ... so heavy blocks spread evenly */
+static void prefill_slots(void *arg, int start, int end) {
+  const prefill_task_t *t = (const prefill_task_t *)arg;
+  size_t stride = slot_floats(t->group, t->head_dim);
+  for (int s = start; s < end; s++)
+    for (int item = s; item < t->num_items; item += t->num_slots)
+      prefill_item(t, item, t->scratch + (size_t)s * stride);
+}
+
+static bool flash_prefill_run(void *out, const void *q,
+                              const kv_block_table_t *kv, int layer,
+                              int start_pos, int num_tokens, int num_heads,
+                              int num_kv_heads, int head_dim, float scale,
+                              void *scratch, bool f16) {
+  if (!out || !q || !kv || start_pos < 0 || num_heads <= 0 ||
+      num_kv_heads <= 0 || num_heads % num_kv_heads != 0 || head_dim <= 0 ||
+      head_dim > FLASH_PREFILL_MAX_HEAD_DIM)
+    return false;
+  if (num_tokens <= 0)
+    return true;
+
+  void *owned = NULL;
+  if (!scratch) {
+    owned = malloc(
+        flash_prefill_scratch_bytes(num_heads, num_kv_heads, head_dim));
+    if (!owned)
+      return false;
+    scratch = owned;
+  }
+
+  prefill_task_t task;
+  task.kv = kv;
+  task.q = q;
+  task.out = out;
+  task.scratch = (float *)(((uintptr_t)scratch + 63) & ~(uintptr_t)63);
+  task.scale = scale;
+  task.layer = layer;
+  task.start_pos = start_pos;
+  task.num_tokens = num_tokens;
+  task.num_kv_heads = num_kv_heads;
+  task.group = num_heads / num_kv_heads;
+  task.head_dim = head_dim;
+  task.block_q = block_positions(task.group);
+  task.f16 = f16;
+  task.int8 = kv->pool->elem_size == KV_CACHE_INT8;
+  task.gemm = gemm_tile_scalar;
+  task.load_f16 = load_f16_scalar;
+  task.load_q8 = load_q8_scalar;
+  task.exp = exp_scalar;
+
+  flash_prefill_caps_t caps = flash_prefill_get_capabilities();
+  if (caps.has_neon) {
+    task.gemm = gemm_f32_kernel;
+    task.load_f16 = flash_decode_load_f16_kernel;
+    task.load_q8 = flash_decode_load_q8_kernel;
+    task.exp = flash_prefill_exp_kernel;
+  } else if (caps.has_avx2) {
+    task.gemm = gemm_f32_tile_kernel_avx2;
+    task.load_f16 = flash_decode_load_f16_kernel_avx2;
+    task.load_q8 = flash_decode_load_q8_kernel_avx2;
+    task.exp = flash_prefill_exp_kernel_avx2;
+  }
+
+  int blocks = (num_tokens + task.block_q - 1) / task.block_q;
+  task.num_items = blocks * num_kv_heads;
+
+  /* Causal: about half of the num_tokens x kv_len scores are computed */
+  double kv_len = (double)start_pos + num_tokens;
+  double macs = (double)num_tokens * kv_len * num_heads * head_dim / 2;
+  int threads = threadpool_get_num_threads();
+  task.num_slots = 1;
+  if (threads > 1 && macs >= FLASH_PREFILL_MT_MIN_MACS)
+    task.num_slots = task.num_items < threads ? task.num_items : threads;
+
+  threadpool_t *pool = task.num_slots > 1 ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, task.num_slots, 1, prefill_slots, &task);
+
+  free(owned);
+  return true;
+}
+
+bool flash_prefill_f32(float *out, const float *q, const kv_block_table_t *kv,
+                       int layer, int start_pos, int num_tokens,
+                       int num_heads, int num_kv_heads, int head_dim,
+                       float scale, void *scratch) {
+  return flash_prefill_run(out, q, kv, layer, start_pos, num_tokens,
+                           num_heads, num_kv_heads, head_dim, scale, scratch,
+                           false);
+}
+
+bool flash_prefill_f16(uint16_t *out, const uint16_t *q,
+                       const kv_block_table_t *kv, int layer, int start_pos,
+                       int num_tokens, int num_heads, int num_kv_heads,
+                       int head_dim, float scale, void *scratch) {
+  return flash_prefill_run(out, q, kv, layer, start_pos, num_tokens,
+                           num_heads, num_kv_heads, head_dim, scale, scratch,
+                           true);
+}
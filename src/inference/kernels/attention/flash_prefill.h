@@ -0,0 +1,79 @@
+/*
+ * Tiled Causal Prefill Attention (FlashAttention) - Public API
+ *
+ * A block of query rows attends causally over a paged K/V cache that
+ * already holds their own keys and values. Queries are taken in blocks and
+ * keys in tiles: each (query block, key tile) pair is a small GEMM for the
+ * scores and another for P.V, folded into the output with an online
+ * softmax, so every K/V tile is converted once and reused by the whole
+ * block. Tiles entirely above the diagonal are never visited.
+ *
+ * Query heads that share a KV head (GQA) are stacked as rows of the same
+ * tile, so the tile GEMMs see group * block rows. INT8 pools
+ * (KV_CACHE_INT8) are dequantized tile by tile as they are gathered.
+ */
+
+#ifndef FLASH_PREFILL_H
+#define FLASH_PREFILL_H
+
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Largest head_dim the kernels accept */
+#define FLASH_PREFILL_MAX_HEAD_DIM 256
+
+/* Query rows (group heads times positions) per tile */
+#define FLASH_PREFILL_BLOCK_M 64
+
+/* Key positions per tile */
+#define FLASH_PREFILL_BLOCK_N 64
+
+/*
+ * Scratch bytes flash_prefill_*() needs with the current thread count, one
+ * set of tile buffers per worker
+ */
+size_t flash_prefill_scratch_bytes(int num_heads, int num_kv_heads,
+                                   int head_dim);
+
+/*
+ * out = softmax(mask(q K^T * scale)) V for num_tokens query rows (FP32
+ * queries and output, FP32 or INT8 cache)
+ *
+ * Parameters:
+ *   out:          [num_tokens, num_heads, head_dim] output
+ *   q:            [num_tokens, num_heads, head_dim] queries; row i sits at
+ *                 cache position start_pos + i and attends positions
+ *                 [0, start_pos + i]
+ *   kv:           block table with positions [0, start_pos + num_tokens)
+ *                 mapped and written
+ *   layer:        layer whose K/V are read
+ *   start_pos:    cache position of the first query row
+ *   num_tokens:   query rows
+ *   scale:        score scale (typically 1/sqrt(head_dim))
+ *   scratch:      flash_prefill_scratch_bytes() bytes, or NULL to allocate
+ *
+ * Returns: false if head_dim exceeds FLASH_PREFILL_MAX_HEAD_DIM, num_heads
+ * is not a multiple of num_kv_heads, or scratch could not be allocated
+ */
+bool flash_prefill_f32(float *out, const float *q, const kv_block_table_t *kv,
+                       int layer, int start_pos, int num_tokens,
+                       int num_heads, int num_kv_heads, int head_dim,
+                       float scale, void *scratch);
+
+/* As flash_prefill_f32() with FP16 queries and output, FP16 or INT8 cache */
+bool flash_prefill_f16(uint16_t *out, const uint16_t *q,
+                       const kv_block_table_t *kv, int layer, int start_pos,
+                       int num_tokens, int num_heads, int num_kv_heads,
+                       int head_dim, float scale, void *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * AVX2/FMA Tiled Prefill Attention Kernels on x86-64
+ *
+ * Exponentiation uses the same range reduction and polynomial as the AVX2
+ * softmax, eight scores at a time.
+ */
+
+#include "inference/kernels/attention/flash_prefill_kernels.h"
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+#include <math.h>
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+AVX2_INLINE __m256 exp256_ps(__m256 x) {
+  const __m256 exp_hi = _mm256_set1_ps(88.3762626647949f);
+  const __m256 exp_lo = _mm256_set1_ps(-88.3762626647949f);
+  const __m256 log2e = _mm256_set1_ps(1.44269504088896341f);
+  const __m256 c1 = _mm256_set1_ps(0.693359375f);
+  const __m256 c2 = _mm256_set1_ps(-2.12194440e-4f);
+
+  x = _mm256_min_ps(_mm256_max_ps(x, exp_lo), exp_hi);
+
+  __m256 fx = _mm256_fmadd_ps(x, log2e, _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, c1, x);
+  x = _mm256_fnmadd_ps(fx, c2, x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+AVX2_INLINE float hsum(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+  return _mm_cvtss_f32(lo);
+}
+
+float flash_prefill_exp_kernel_avx2(float *x, int n, float max) {
+  __m256 max_v = _mm256_set1_ps(max);
+  __m256 sum_v = _mm256_setzero_ps();
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256 e = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(x + j), max_v));
+    _mm256_storeu_ps(x + j, e);
+    sum_v = _mm256_add_ps(sum_v, e);
+  }
+  float sum = hsum(sum_v);
+  for (; j < n; j++) {
+    x[j] = expf(x[j] - max);
+    sum += x[j];
+  }
+  return sum;
+}
+
+#else
+
+float flash_prefill_exp_kernel_avx2(float *x, int n, float max) {
+  (void)x;
+  (void)n;
+  (void)max;
+  return 0.0f;
+}
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * Tiled prefill attention kernel interface for architecture-specific
+ * implementations
+ *
+ * The tile GEMMs go through the GEMM micro-kernels; what is left per tile is
+ * the exponentiation of each score row, which at one expf per score costs
+ * as much as the Q K^T multiply itself when done in scalar code.
+ */
+
+#ifndef FLASH_PREFILL_KERNELS_H
+#define FLASH_PREFILL_KERNELS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  bool has_neon;
+  bool has_avx2;
+} flash_prefill_caps_t;
+
+flash_prefill_caps_t flash_prefill_get_capabilities(void);
+
+/*
+ * x[j] = exp(x[j] - max) for n scores, returning their sum. Masked scores
+ * (-INFINITY) come out as zero or negligibly small.
+ */
+float flash_prefill_exp_kernel(float *x, int n, float max);
+
+float flash_prefill_exp_kernel_avx2(float *x, int n, float max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
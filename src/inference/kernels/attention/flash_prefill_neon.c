@@ -0,0 +1,79 @@
+/*
+ * NEON Tiled Prefill Attention Kernels on ARM64
+ *
+ * Exponentiation by range reduction to 2^n * exp(r), with the same
+ * polynomial as the AVX2 kernel, four scores at a time.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/kernels/attention/flash_prefill_kernels.h"
+#include <math.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAS_NEON 1
+#else
+#define HAS_NEON 0
+#endif
+
+flash_prefill_caps_t flash_prefill_get_capabilities(void) {
+  flash_prefill_caps_t caps = {0};
+  caps.has_neon = caps_has(CAP_NEON);
+  caps.has_avx2 = caps_has(CAP_AVX2);
+  return caps;
+}
+
+#if HAS_NEON
+
+#define NEON_INLINE static inline __attribute__((always_inline))
+
+NEON_INLINE float32x4_t exp_f32x4(float32x4_t x) {
+  x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-88.3762626647949f)),
+                vdupq_n_f32(88.3762626647949f));
+
+  float32x4_t fx = vrndmq_f32(
+      vfmaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(1.44269504088896341f)));
+  x = vfmsq_f32(x, fx, vdupq_n_f32(0.693359375f));
+  x = vfmsq_f32(x, fx, vdupq_n_f32(-2.12194440e-4f));
+
+  float32x4_t y = vdupq_n_f32(1.9875691500e-4f);
+  y = vfmaq_f32(vdupq_n_f32(1.3981999507e-3f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(8.3334519073e-3f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(4.1665795894e-2f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(1.6666665459e-1f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(5.0000001201e-1f), y, x);
+  y = vfmaq_f32(x, y, vmulq_f32(x, x));
+  y = vaddq_f32(y, vdupq_n_f32(1.0f));
+
+  int32x4_t n = vcvtq_s32_f32(fx);
+  n = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+  return vmulq_f32(y, vreinterpretq_f32_s32(n));
+}
+
+float flash_prefill_exp_kernel(float *x, int n, float max) {
+  float32x4_t max_v = vdupq_n_f32(max);
+  float32x4_t sum_v = vdupq_n_f32(0.0f);
+  int j = 0;
+  for (; j + 4 <= n; j += 4) {
+    float32x4_t e = exp_f32x4(vsubq_f32(vld1q_f32(x + j), max_v));
+    vst1q_f32(x + j, e);
+    sum_v = vaddq_f32(sum_v, e);
+  }
+  float sum = vaddvq_f32(sum_v);
+  for (; j < n; j++) {
+    x[j] = expf(x[j] - max);
+    sum += x[j];
+  }
+  return sum;
+}
+
+#else
+
+float flash_prefill_exp_kernel(float *x, int n, float max) {
+  (void)x;
+  (void)n;
+  (void)max;
+  return 0.0f;
+}
+
+#endif
@@ -1,15 +1,11 @@
 #include "inference/kernels/gemm/gemm.h"
+#include "inference/backend/caps.h"
+#include "inference/backend/threadpool.h"
 #include "inference/kernels/gemm/gemm_kernels.h"
 #include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 
-#ifdef _WIN32
-#include <windows.h>
-#else
-#include <unistd.h>
-#endif
-
 #if defined(__APPLE__)
 #include <Accelerate/Accelerate.h>
 #define HAS_ACCELERATE 1
@@ -19,35 +15,14 @@
 #include <arm_neon.h>
 #endif
 
-static int g_num_threads = 0;
-
-static int get_cpu_count(void) {
-#ifdef _WIN32
-  SYSTEM_INFO sysinfo;
-  GetSystemInfo(&sysinfo);
-  return sysinfo.dwNumberOfProcessors;
-#else
-  long n = sysconf(_SC_NPROCESSORS_ONLN);
-  return n > 0 ? (int)n : 1;
-#endif
-}
-
+/* Thread count is a property of the shared pool; these are kept as aliases */
 void gemm_set_num_threads(int num_threads) {
-  if (num_threads <= 0) {
-    g_num_threads = get_cpu_count();
-  } else {
-    g_num_threads = num_threads;
-  }
+  threadpool_set_num_threads(num_threads);
 }
 
-int gemm_get_num_threads(void) {
-  if (g_num_threads == 0) {
-    g_num_threads = get_cpu_count();
-  }
-  return g_num_threads;
-}
+int gemm_get_num_threads(void) { return threadpool_get_num_threads(); }
 
-int gemm_get_max_threads(void) { return get_cpu_count(); }
+int gemm_get_max_threads(void) { return caps_get()->num_cpus; }
 
 #define MT_THRESHOLD_M 64
 #define MT_THRESHOLD_FLOPS (64 * 64 * 64 * 2)
@@ -247,6 +222,30 @@ void gemm_f32(const float *A, const float *B, float *C, int M, int N, int K,
     return;
   }
 
+  /* Prefill-sized products go through the cache-blocked AVX-512 kernels,
+   * which also read the transposed layouts; a few rows read B in place */
+  if (caps.has_avx512 && (M >= GEMM_AVX512_PACK_MIN_M || transpose_A)) {
+    long long flops = (long long)M * N * K * 2;
+    int nt = flops >= MT_THRESHOLD_FLOPS ? gemm_get_num_threads() : 1;
+    gemm_f32_kernel_avx512_packed(A, B, C, M, N, K, transpose_A, transpose_B,
+                                  nt);
+    return;
+  }
+
+  if (caps.has_avx512 && !transpose_B) {
+    gemm_f32_kernel_avx512(A, B, C, M, N, K);
+    return;
+  }
+
+  /* The AVX2 kernels split C in both dimensions, so even a single row
+   * can use every thread; they also cover the transposed layouts */
+  if (caps.has_avx2) {
+    long long flops = (long long)M * N * K * 2;
+    int nt = flops >= MT_THRESHOLD_FLOPS ? gemm_get_num_threads() : 1;
+    gemm_f32_kernel_avx2_trans(A, B, C, M, N, K, transpose_A, transpose_B, nt);
+    return;
+  }
+
   gemm_f32_naive(A, B, C, M, N, K, transpose_A, transpose_B);
 }
 
@@ -282,6 +281,27 @@ void gemm_bf16(const uint16_t *A, const uint16_t *B, uint16_t *C, int M, int N,
     return;
   }
 
+  if (caps.has_avx512) {
+    long long flops = (long long)M * N * K * 2;
+    int nt = flops >= MT_THRESHOLD_FLOPS ? gemm_get_num_threads() : 1;
+    if (M >= GEMM_AVX512_PACK_MIN_M)
+      gemm_bf16_kernel_avx512_packed(A, B, C, M, N, K, nt);
+    else
+      gemm_bf16_kernel_avx512(A, B, C, M, N, K);
+    return;
+  }
+
+  if (caps.has_avx2) {
+    int nt = gemm_get_num_threads();
+    long long flops = (long long)M * N * K * 2;
+    if (nt > 1 && flops >= MT_THRESHOLD_FLOPS) {
+      gemm_bf16_kernel_avx2_mt(A, B, C, M, N, K, nt);
+    } else {
+      gemm_bf16_kernel_avx2(A, B, C, M, N, K);
+    }
+    return;
+  }
+
   gemm_bf16_naive(A, B, C, M, N, K);
 }
 
@@ -437,5 +457,26 @@ void gemm_f16(const uint16_t *A, const uint16_t *B, uint16_t *C, int M, int N,
     return;
   }
 
+  if (caps.has_avx512) {
+    long long flops = (long long)M * N * K * 2;
+    int nt = flops >= MT_THRESHOLD_FLOPS ? gemm_get_num_threads() : 1;
+    if (M >= GEMM_AVX512_PACK_MIN_M)
+      gemm_f16_kernel_avx512_packed(A, B, C, M, N, K, nt);
+    else
+      gemm_f16_kernel_avx512(A, B, C, M, N, K);
+    return;
+  }
+
+  if (caps.has_avx2) {
+    int nt = gemm_get_num_threads();
+    long long flops = (long long)M * N * K * 2;
+    if (nt > 1 && flops >= MT_THRESHOLD_FLOPS) {
+      gemm_f16_kernel_avx2_mt(A, B, C, M, N, K, nt);
+    } else {
+      gemm_f16_kernel_avx2(A, B, C, M, N, K);
+    }
+    return;
+  }
+
   gemm_f16_naive(A, B, C, M, N, K);
 }
@@ -6,6 +6,7 @@
  * BF16: Converts to F32 on-the-fly and uses AMX F32 instructions.
  */
 
+#include "inference/backend/threadpool.h"
 #include "inference/kernels/gemm/gemm_kernels.h"
 #include <stdlib.h>
 #include <string.h>
@@ -14,8 +15,6 @@
 
 #include "inference/kernels/amx/aarch64.h"
 #include <arm_neon.h>
-#include <dispatch/dispatch.h>
-#include <pthread.h>
 
 /* AMX Operations */
 #define FMA16_MATRIX_MODE 0
@@ -368,7 +367,7 @@ void gemm_bf16_kernel_amx(const uint16_t *A, const uint16_t *B, uint16_t *C,
 }
 
 /* ============================================================================
- * Multi-threaded Dispatchers (GCD-based)
+ * Multi-threaded Dispatchers (shared thread pool)
  * ============================================================================
  */
 
@@ -380,7 +379,7 @@ typedef struct {
   int n_tiles;
   int m_tiles_per_job;
   int total_m_tiles;
-} gcd_gemm_context_t;
+} amx_gemm_context_t;
 
 /* Thread-local storage for pack_a buffers */
 static __thread uint16_t *tls_pack_a = NULL;
@@ -395,8 +394,7 @@ static uint16_t *get_tls_pack_a(size_t size) {
   return tls_pack_a;
 }
 
-static void gcd_f16_worker(void *context, size_t job_idx) {
-  gcd_gemm_context_t *ctx = (gcd_gemm_context_t *)context;
+static void amx_f16_job(amx_gemm_context_t *ctx, int job_idx) {
   const uint16_t *A = ctx->A;
   const uint16_t *packed_B = ctx->packed_B;
   uint16_t *C = ctx->C;
@@ -405,7 +403,7 @@ static void gcd_f16_worker(void *context, size_t job_idx) {
   int m_tiles_per_job = ctx->m_tiles_per_job;
   int total_m_tiles = ctx->total_m_tiles;
 
-  int m_tile_start = (int)job_idx * m_tiles_per_job;
+  int m_tile_start = job_idx * m_tiles_per_job;
   int m_tile_end = m_tile_start + m_tiles_per_job;
   if (m_tile_end > total_m_tiles)
     m_tile_end = total_m_tiles;
@@ -435,9 +433,14 @@ static void gcd_f16_worker(void *context, size_t job_idx) {
   AMX_CLR();
 }
 
+static void amx_f16_work(void *arg, int job_start, int job_end) {
+  for (int job = job_start; job < job_end; job++)
+    amx_f16_job((amx_gemm_context_t *)arg, job);
+}
+
 void gemm_f16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
                             int M, int N, int K, int nt) {
-  (void)nt; /* Thread count hint ignored - GCD handles this */
+  (void)nt; /* The shared pool decides the split */
 
   int m_tiles = (M + 31) / 32;
   int n_tiles = (N + 31) / 32;
@@ -468,7 +471,7 @@ void gemm_f16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
     return;
   prepack_b_f16(B, N, N, K, packed_B);
 
-  gcd_gemm_context_t ctx = {.A = A,
+  amx_gemm_context_t ctx = {.A = A,
                             .packed_B = packed_B,
                             .C = C,
                             .M = M,
@@ -478,24 +481,21 @@ void gemm_f16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
                             .m_tiles_per_job = m_tiles_per_job,
                             .total_m_tiles = m_tiles};
 
-  dispatch_apply((size_t)num_jobs,
-                 dispatch_get_global_queue(QOS_CLASS_USER_INITIATED, 0),
-                 ^(size_t idx) {
-                   gcd_f16_worker((void *)&ctx, idx);
-                 });
+  threadpool_parallel_for(threadpool_global(), 0, num_jobs, 1, amx_f16_work,
+                          &ctx);
 
   free(packed_B);
 }
 
-/* BF16 multi-threaded (pthread-based, unchanged) */
+/* BF16 multi-threaded: row partitions aligned to the 16-row tile */
 
 typedef struct {
   const uint16_t *A, *B;
   uint16_t *C;
-  int M, N, K, m_start, m_end;
+  int M, N, K;
 } amx_mt_args;
 
-static void *bf16_mt_worker(void *ptr) {
+static void bf16_mt_work(void *ptr, int m_start, int m_end) {
   amx_mt_args *args = (amx_mt_args *)ptr;
   int K = args->K;
   int M = args->M;
@@ -503,11 +503,14 @@ static void *bf16_mt_worker(void *ptr) {
 
   float *pack_a = aligned_alloc(64, K * 16 * sizeof(float));
   float *pack_b = aligned_alloc(64, K * 16 * sizeof(float));
-  if (!pack_a || !pack_b)
-    return NULL;
+  if (!pack_a || !pack_b) {
+    free(pack_a);
+    free(pack_b);
+    return;
+  }
 
   AMX_SET();
-  for (int m = args->m_start; m < args->m_end; m += 16) {
+  for (int m = m_start; m < m_end; m += 16) {
     int m_len = (m + 16 > M) ? (M - m) : 16;
     pack_a_bf16_to_f32(args->A + m * K, K, m_len, K, pack_a);
     for (int n = 0; n < N; n += 16) {
@@ -520,7 +523,6 @@ static void *bf16_mt_worker(void *ptr) {
   AMX_CLR();
   free(pack_a);
   free(pack_b);
-  return NULL;
 }
 
 void gemm_bf16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
@@ -530,29 +532,12 @@ void gemm_bf16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
     return;
   }
 
-  pthread_t *threads = malloc(nt * sizeof(pthread_t));
-  amx_mt_args *args = malloc(nt * sizeof(amx_mt_args));
-
   int rows_per = (M + nt - 1) / nt;
   rows_per = (rows_per + 15) & ~15; /* Align to 16 */
 
-  int active = 0;
-  for (int i = 0; i < nt; i++) {
-    int start = i * rows_per;
-    if (start >= M)
-      break;
-    int end = start + rows_per;
-    if (end > M)
-      end = M;
-
-    args[i] = (amx_mt_args){A, B, C, M, N, K, start, end};
-    pthread_create(&threads[i], NULL, bf16_mt_worker, &args[i]);
-    active++;
-  }
-  for (int i = 0; i < active; i++)
-    pthread_join(threads[i], NULL);
-  free(threads);
-  free(args);
+  amx_mt_args args = {A, B, C, M, N, K};
+  threadpool_parallel_for(threadpool_global(), 0, M, rows_per, bf16_mt_work,
+                          &args);
 }
 
 #else
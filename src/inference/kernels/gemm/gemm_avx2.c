@@ -0,0 +1,715 @@
+/*
+ * AVX2/FMA GEMM for FP32, FP16 and BF16 on x86-64
+ *
+ * C[M,N] = A[M,K] @ B[K,N], all row-major; the F32 entry point also takes
+ * transposed A and/or B. Accumulation is always F32; FP16 operands are
+ * widened with F16C, BF16 operands with a 16-bit shift.
+ *
+ * Large M goes through a cache-blocked path with packed panels and a 6x16
+ * micro-kernel, partitioned over C tiles in both dimensions. A handful of
+ * rows (decode) reads B in place with a 4x16 micro-kernel, or as row dot
+ * products when B is transposed, split over columns.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/backend/threadpool.h"
+#include "inference/kernels/gemm/gemm_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+#define GEMM_MR 4
+#define GEMM_NR 16
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+AVX2_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX2_INLINE __m256 load8(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm256_loadu_ps((const float *)p + idx);
+  __m128i h = _mm_loadu_si128((const __m128i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm256_cvtph_ps(h);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+AVX2_INLINE uint16_t f32_to_bf16_1(float f) {
+  uint32_t bits;
+  memcpy(&bits, &f, sizeof(bits));
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return (uint16_t)(bits >> 16);
+}
+
+AVX2_INLINE void store1(void *p, size_t idx, float v, int kind) {
+  if (kind == ELEM_F32)
+    ((float *)p)[idx] = v;
+  else if (kind == ELEM_F16)
+    ((uint16_t *)p)[idx] = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+  else
+    ((uint16_t *)p)[idx] = f32_to_bf16_1(v);
+}
+
+AVX2_INLINE void store8(void *p, size_t idx, __m256 v, int kind) {
+  if (kind == ELEM_F32) {
+    _mm256_storeu_ps((float *)p + idx, v);
+    return;
+  }
+  __m128i h;
+  if (kind == ELEM_F16) {
+    h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    /* Round-to-nearest-even, then narrow 8x u32 -> 8x u16 */
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i lsb = _mm256_and_si256(_mm256_srli_epi32(bits, 16),
+                                   _mm256_set1_epi32(1));
+    bits = _mm256_add_epi32(bits,
+                            _mm256_add_epi32(_mm256_set1_epi32(0x7fff), lsb));
+    bits = _mm256_srli_epi32(bits, 16);
+    h = _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                         _mm256_extracti128_si256(bits, 1));
+  }
+  _mm_storeu_si128((__m128i *)((uint16_t *)p + idx), h);
+}
+
+/*
+ * 4x16 micro-kernel. Rows beyond `mr` alias the last valid row so the inner
+ * loop stays branch-free; their results are simply not stored.
+ */
+AVX2_INLINE void micro_4x16(const void *A, const void *B, void *C, int N,
+                            int K, int i, int j, int mr, int kind) {
+  size_t r0 = (size_t)i * K;
+  size_t r1 = (size_t)(i + (mr > 1 ? 1 : 0)) * K;
+  size_t r2 = (size_t)(i + (mr > 2 ? 2 : 0)) * K;
+  size_t r3 = (size_t)(i + (mr > 3 ? 3 : 0)) * K;
+
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+
+  for (int k = 0; k < K; k++) {
+    size_t boff = (size_t)k * N + j;
+    __m256 b0 = load8(B, boff, kind);
+    __m256 b1 = load8(B, boff + 8, kind);
+
+    __m256 a = _mm256_set1_ps(load1(A, r0 + k, kind));
+    c00 = _mm256_fmadd_ps(a, b0, c00);
+    c01 = _mm256_fmadd_ps(a, b1, c01);
+    a = _mm256_set1_ps(load1(A, r1 + k, kind));
+    c10 = _mm256_fmadd_ps(a, b0, c10);
+    c11 = _mm256_fmadd_ps(a, b1, c11);
+    a = _mm256_set1_ps(load1(A, r2 + k, kind));
+    c20 = _mm256_fmadd_ps(a, b0, c20);
+    c21 = _mm256_fmadd_ps(a, b1, c21);
+    a = _mm256_set1_ps(load1(A, r3 + k, kind));
+    c30 = _mm256_fmadd_ps(a, b0, c30);
+    c31 = _mm256_fmadd_ps(a, b1, c31);
+  }
+
+  size_t c = (size_t)i * N + j;
+  store8(C, c, c00, kind);
+  store8(C, c + 8, c01, kind);
+  if (mr > 1) {
+    store8(C, c + N, c10, kind);
+    store8(C, c + N + 8, c11, kind);
+  }
+  if (mr > 2) {
+    store8(C, c + 2 * (size_t)N, c20, kind);
+    store8(C, c + 2 * (size_t)N + 8, c21, kind);
+  }
+  if (mr > 3) {
+    store8(C, c + 3 * (size_t)N, c30, kind);
+    store8(C, c + 3 * (size_t)N + 8, c31, kind);
+  }
+}
+
+/* Column tail: one row at a time, 8 columns then scalar */
+AVX2_INLINE void gemm_row_tail(const void *A, const void *B, void *C, int N,
+                               int K, int i, int j_start, int j_end,
+                               int kind) {
+  size_t arow = (size_t)i * K;
+  int j = j_start;
+  for (; j + 8 <= j_end; j += 8) {
+    __m256 acc = _mm256_setzero_ps();
+    for (int k = 0; k < K; k++) {
+      __m256 a = _mm256_set1_ps(load1(A, arow + k, kind));
+      acc = _mm256_fmadd_ps(a, load8(B, (size_t)k * N + j, kind), acc);
+    }
+    store8(C, (size_t)i * N + j, acc, kind);
+  }
+  for (; j < j_end; j++) {
+    float sum = 0.0f;
+    for (int k = 0; k < K; k++)
+      sum += load1(A, arow + k, kind) * load1(B, (size_t)k * N + j, kind);
+    store1(C, (size_t)i * N + j, sum, kind);
+  }
+}
+
+/* All M rows of C over columns [j_start, j_end), reading B in place */
+AVX2_INLINE void gemm_cols_avx2(const void *A, const void *B, void *C, int M,
+                                int N, int K, int j_start, int j_end,
+                                int kind) {
+  int n_main = j_start + (j_end - j_start) / GEMM_NR * GEMM_NR;
+
+  for (int i = 0; i < M; i += GEMM_MR) {
+    int mr = M - i < GEMM_MR ? M - i : GEMM_MR;
+
+    for (int j = j_start; j < n_main; j += GEMM_NR)
+      micro_4x16(A, B, C, N, K, i, j, mr, kind);
+
+    if (n_main < j_end) {
+      for (int r = 0; r < mr; r++)
+        gemm_row_tail(A, B, C, N, K, i + r, n_main, j_end, kind);
+    }
+  }
+}
+
+/*
+ * C = A x B^T for few rows of A: every output is a dot product of two
+ * contiguous rows, so B is streamed once without packing.
+ */
+AVX2_INLINE void gemm_dot_cols(const void *A, const void *B, void *C, int M,
+                               int N, int K, int j_start, int j_end,
+                               int kind) {
+  for (int i = 0; i < M; i++) {
+    size_t arow = (size_t)i * K;
+    for (int j = j_start; j < j_end; j++) {
+      size_t brow = (size_t)j * K;
+      __m256 acc0 = _mm256_setzero_ps(), acc1 = _mm256_setzero_ps();
+      int k = 0;
+      for (; k + 16 <= K; k += 16) {
+        acc0 = _mm256_fmadd_ps(load8(A, arow + k, kind),
+                               load8(B, brow + k, kind), acc0);
+        acc1 = _mm256_fmadd_ps(load8(A, arow + k + 8, kind),
+                               load8(B, brow + k + 8, kind), acc1);
+      }
+      for (; k + 8 <= K; k += 8)
+        acc0 = _mm256_fmadd_ps(load8(A, arow + k, kind),
+                               load8(B, brow + k, kind), acc0);
+      acc0 = _mm256_add_ps(acc0, acc1);
+      __m128 s = _mm_add_ps(_mm256_castps256_ps128(acc0),
+                            _mm256_extractf128_ps(acc0, 1));
+      s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+      s = _mm_add_ss(s, _mm_movehdup_ps(s));
+      float sum = _mm_cvtss_f32(s);
+      for (; k < K; k++)
+        sum += load1(A, arow + k, kind) * load1(B, brow + k, kind);
+      store1(C, (size_t)i * N + j, sum, kind);
+    }
+  }
+}
+
+/* ============ Cache-blocked path (packed panels) ============ */
+
+/*
+ * Goto-style blocking: C is cut into MC x NC tiles that are computed
+ * independently (the unit of 2D thread partitioning). For each KC slice
+ * the tile's block of A is packed into MR-row strips and its block of B
+ * into NR-column strips, both converted to F32, so the micro-kernel streams
+ * two contiguous buffers whatever the source dtype and transposition.
+ * The B strip stays in L1 while the micro-kernel walks the A block in L2.
+ */
+
+#define PACK_MR 6
+#define PACK_NR 16
+
+typedef struct {
+  int kc;
+  int mc;
+  int nc;
+} gemm_blocking_t;
+
+static int clamp_block(int v, int lo, int hi, int mult) {
+  v = v / mult * mult;
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static gemm_blocking_t gemm_blocking(void) {
+  const system_caps_t *caps = caps_get();
+  size_t l1 = caps->l1_cache_size ? caps->l1_cache_size : 32 * 1024;
+  size_t l2 = caps->l2_cache_size ? caps->l2_cache_size : 256 * 1024;
+
+  gemm_blocking_t b;
+  /* One A strip and one B strip share half of L1 */
+  b.kc = clamp_block((int)(l1 / 2 / ((PACK_MR + PACK_NR) * sizeof(float))),
+                     64, 512, 8);
+  /* The packed A block takes a quarter of L2, the B block half of it */
+  b.mc = clamp_block((int)(l2 / 4 / (b.kc * sizeof(float))), PACK_MR, 192,
+                     PACK_MR);
+  b.nc = clamp_block((int)(l2 / 2 / (b.kc * sizeof(float))), PACK_NR, 512,
+                     PACK_NR);
+  return b;
+}
+
+/* Element (i, k) of A or (k, j) of B, honoring the transpose flags */
+AVX2_INLINE size_t a_index(int i, int k, int M, int K, bool trans) {
+  return trans ? (size_t)k * M + i : (size_t)i * K + k;
+}
+
+AVX2_INLINE size_t b_index(int k, int j, int N, int K, bool trans) {
+  return trans ? (size_t)j * K + k : (size_t)k * N + j;
+}
+
+/* dst[strip][k][r]: MR-row strips of A[i0 : i0+mc, p0 : p0+kc], zero padded */
+static void pack_a(const void *A, float *dst, int M, int K, bool trans,
+                   int i0, int mc, int p0, int kc, int kind) {
+  for (int ir = 0; ir < mc; ir += PACK_MR) {
+    float *d = dst + (size_t)ir * kc;
+    int mr = mc - ir < PACK_MR ? mc - ir : PACK_MR;
+    if (mr < PACK_MR)
+      memset(d, 0, (size_t)kc * PACK_MR * sizeof(float));
+    if (trans) {
+      for (int k = 0; k < kc; k++)
+        for (int r = 0; r < mr; r++)
+          d[k * PACK_MR + r] =
+              load1(A, a_index(i0 + ir + r, p0 + k, M, K, true), kind);
+    } else {
+      for (int r = 0; r < mr; r++) {
+        size_t row = a_index(i0 + ir + r, p0, M, K, false);
+        for (int k = 0; k < kc; k++)
+          d[k * PACK_MR + r] = load1(A, row + k, kind);
+      }
+    }
+  }
+}
+
+/* dst[strip][k][c]: NR-column strips of B[p0 : p0+kc, j0 : j0+nc] */
+static void pack_b(const void *B, float *dst, int N, int K, bool trans,
+                   int j0, int nc, int p0, int kc, int kind) {
+  for (int jr = 0; jr < nc; jr += PACK_NR) {
+    float *d = dst + (size_t)jr * kc;
+    int nr = nc - jr < PACK_NR ? nc - jr : PACK_NR;
+    if (nr < PACK_NR)
+      memset(d, 0, (size_t)kc * PACK_NR * sizeof(float));
+    if (trans) {
+      for (int c = 0; c < nr; c++) {
+        size_t col = b_index(p0, j0 + jr + c, N, K, true);
+        for (int k = 0; k < kc; k++)
+          d[k * PACK_NR + c] = load1(B, col + k, kind);
+      }
+    } else if (nr == PACK_NR) {
+      for (int k = 0; k < kc; k++) {
+        size_t row = b_index(p0 + k, j0 + jr, N, K, false);
+        _mm256_storeu_ps(d + k * PACK_NR, load8(B, row, kind));
+        _mm256_storeu_ps(d + k * PACK_NR + 8, load8(B, row + 8, kind));
+      }
+    } else {
+      for (int k = 0; k < kc; k++) {
+        size_t row = b_index(p0 + k, j0 + jr, N, K, false);
+        for (int c = 0; c < nr; c++)
+          d[k * PACK_NR + c] = load1(B, row + c, kind);
+      }
+    }
+  }
+}
+
+#define MICRO_ROW(r, c0, c1)                                                   \
+  do {                                                                         \
+    __m256 a_ = _mm256_broadcast_ss(a + (r));                                  \
+    c0 = _mm256_fmadd_ps(a_, b0, c0);                                          \
+    c1 = _mm256_fmadd_ps(a_, b1, c1);                                          \
+  } while (0)
+
+#define MICRO_STORE(r, c0, c1)                                                 \
+  do {                                                                         \
+    float *row_ = c + (r) * ldc;                                               \
+    if (accumulate) {                                                          \
+      c0 = _mm256_add_ps(c0, _mm256_loadu_ps(row_));                           \
+      c1 = _mm256_add_ps(c1, _mm256_loadu_ps(row_ + 8));                       \
+    }                                                                          \
+    _mm256_storeu_ps(row_, c0);                                                \
+    _mm256_storeu_ps(row_ + 8, c1);                                            \
+  } while (0)
+
+/*
+ * 6x16 micro-kernel over packed strips: 12 accumulators, 2 B vectors and
+ * one broadcast fill 15 of the 16 YMM registers. Partial tiles go through
+ * a stack buffer.
+ */
+static void micro_6x16_packed(const float *a, const float *b, int kc,
+                              float *c, size_t ldc, int mr, int nr,
+                              bool accumulate) {
+  __m256 c00 = _mm256_setzero_ps(), c01 = _mm256_setzero_ps();
+  __m256 c10 = _mm256_setzero_ps(), c11 = _mm256_setzero_ps();
+  __m256 c20 = _mm256_setzero_ps(), c21 = _mm256_setzero_ps();
+  __m256 c30 = _mm256_setzero_ps(), c31 = _mm256_setzero_ps();
+  __m256 c40 = _mm256_setzero_ps(), c41 = _mm256_setzero_ps();
+  __m256 c50 = _mm256_setzero_ps(), c51 = _mm256_setzero_ps();
+
+  for (int k = 0; k < kc; k++) {
+    __m256 b0 = _mm256_loadu_ps(b);
+    __m256 b1 = _mm256_loadu_ps(b + 8);
+    MICRO_ROW(0, c00, c01);
+    MICRO_ROW(1, c10, c11);
+    MICRO_ROW(2, c20, c21);
+    MICRO_ROW(3, c30, c31);
+    MICRO_ROW(4, c40, c41);
+    MICRO_ROW(5, c50, c51);
+    a += PACK_MR;
+    b += PACK_NR;
+  }
+
+  if (mr == PACK_MR && nr == PACK_NR) {
+    MICRO_STORE(0, c00, c01);
+    MICRO_STORE(1, c10, c11);
+    MICRO_STORE(2, c20, c21);
+    MICRO_STORE(3, c30, c31);
+    MICRO_STORE(4, c40, c41);
+    MICRO_STORE(5, c50, c51);
+    return;
+  }
+
+  float *out = c;
+  size_t out_ldc = ldc;
+  bool out_accumulate = accumulate;
+  float tmp[PACK_MR * PACK_NR];
+  c = tmp;
+  ldc = PACK_NR;
+  accumulate = false;
+  MICRO_STORE(0, c00, c01);
+  MICRO_STORE(1, c10, c11);
+  MICRO_STORE(2, c20, c21);
+  MICRO_STORE(3, c30, c31);
+  MICRO_STORE(4, c40, c41);
+  MICRO_STORE(5, c50, c51);
+
+  for (int r = 0; r < mr; r++) {
+    float *dst = out + r * out_ldc;
+    for (int j = 0; j < nr; j++)
+      dst[j] = out_accumulate ? dst[j] + tmp[r * PACK_NR + j]
+                              : tmp[r * PACK_NR + j];
+  }
+}
+
+typedef struct {
+  const void *A;
+  const void *B;
+  void *C;
+  int M;
+  int N;
+  int K;
+  bool transpose_A;
+  bool transpose_B;
+  int kind;
+  gemm_blocking_t blk;
+  int n_tiles; /* Tiles per row of C */
+} gemm_packed_task_t;
+
+/* Packing buffers, kept per worker thread and grown on demand */
+static _Thread_local float *tls_pack = NULL;
+static _Thread_local size_t tls_pack_floats = 0;
+
+static float *pack_buffer(size_t floats) {
+  if (tls_pack_floats < floats) {
+    size_t bytes = (floats * sizeof(float) + 63) & ~(size_t)63;
+    float *p = (float *)aligned_alloc(64, bytes);
+    if (!p)
+      return NULL;
+    free(tls_pack);
+    tls_pack = p;
+    tls_pack_floats = floats;
+  }
+  return tls_pack;
+}
+
+/* Out of memory for the packing buffers: compute the tile in place */
+static void gemm_tile_unpacked(const gemm_packed_task_t *t, int i0, int mc,
+                               int j0, int nc) {
+  if (!t->transpose_A) {
+    size_t elem = t->kind == ELEM_F32 ? sizeof(float) : sizeof(uint16_t);
+    const uint8_t *a = (const uint8_t *)t->A + (size_t)i0 * t->K * elem;
+    uint8_t *c = (uint8_t *)t->C + (size_t)i0 * t->N * elem;
+    if (t->transpose_B)
+      gemm_dot_cols(a, t->B, c, mc, t->N, t->K, j0, j0 + nc, t->kind);
+    else
+      gemm_cols_avx2(a, t->B, c, mc, t->N, t->K, j0, j0 + nc, t->kind);
+    return;
+  }
+
+  for (int i = i0; i < i0 + mc; i++) {
+    for (int j = j0; j < j0 + nc; j++) {
+      float sum = 0.0f;
+      for (int k = 0; k < t->K; k++)
+        sum += load1(t->A, a_index(i, k, t->M, t->K, true), t->kind) *
+               load1(t->B, b_index(k, j, t->N, t->K, t->transpose_B),
+                     t->kind);
+      store1(t->C, (size_t)i * t->N + j, sum, t->kind);
+    }
+  }
+}
+
+static void gemm_packed_work(void *arg, int tile_start, int tile_end) {
+  const gemm_packed_task_t *t = (const gemm_packed_task_t *)arg;
+  const gemm_blocking_t *blk = &t->blk;
+  int nc_pad = (blk->nc + PACK_NR - 1) / PACK_NR * PACK_NR;
+
+  size_t a_floats = (size_t)blk->mc * blk->kc;
+  size_t b_floats = (size_t)nc_pad * blk->kc;
+  /* 16-bit outputs accumulate in F32 and are rounded once per tile */
+  size_t c_floats = t->kind == ELEM_F32 ? 0 : (size_t)blk->mc * blk->nc;
+  float *a_pack = pack_buffer(a_floats + b_floats + c_floats);
+  float *b_pack = a_pack ? a_pack + a_floats : NULL;
+  float *c_tile = a_pack && c_floats ? b_pack + b_floats : NULL;
+
+  for (int tile = tile_start; tile < tile_end; tile++) {
+    int i0 = tile / t->n_tiles * blk->mc;
+    int j0 = tile % t->n_tiles * blk->nc;
+    int mc = t->M - i0 < blk->mc ? t->M - i0 : blk->mc;
+    int nc = t->N - j0 < blk->nc ? t->N - j0 : blk->nc;
+
+    if (!a_pack) {
+      gemm_tile_unpacked(t, i0, mc, j0, nc);
+      continue;
+    }
+
+    float *c = c_tile ? c_tile : (float *)t->C + (size_t)i0 * t->N + j0;
+    size_t ldc = c_tile ? (size_t)nc : (size_t)t->N;
+
+    for (int p0 = 0; p0 < t->K; p0 += blk->kc) {
+      int kc = t->K - p0 < blk->kc ? t->K - p0 : blk->kc;
+      pack_b(t->B, b_pack, t->N, t->K, t->transpose_B, j0, nc, p0, kc,
+             t->kind);
+      pack_a(t->A, a_pack, t->M, t->K, t->transpose_A, i0, mc, p0, kc,
+             t->kind);
+
+      for (int jr = 0; jr < nc; jr += PACK_NR) {
+        int nr = nc - jr < PACK_NR ? nc - jr : PACK_NR;
+        for (int ir = 0; ir < mc; ir += PACK_MR) {
+          int mr = mc - ir < PACK_MR ? mc - ir : PACK_MR;
+          micro_6x16_packed(a_pack + (size_t)ir * kc, b_pack + (size_t)jr * kc,
+                            kc, c + ir * ldc + jr, ldc, mr, nr, p0 > 0);
+        }
+      }
+    }
+
+    if (c_tile) {
+      for (int r = 0; r < mc; r++) {
+        size_t out = (size_t)(i0 + r) * t->N + j0;
+        const float *src = c_tile + (size_t)r * nc;
+        int j = 0;
+        for (; j + 8 <= nc; j += 8)
+          store8(t->C, out + j, _mm256_loadu_ps(src + j), t->kind);
+        for (; j < nc; j++)
+          store1(t->C, out + j, src[j], t->kind);
+      }
+    }
+  }
+}
+
+static void gemm_packed(const void *A, const void *B, void *C, int M, int N,
+                        int K, bool transpose_A, bool transpose_B,
+                        int num_threads, int kind) {
+  gemm_packed_task_t task = {
+      A, B, C, M, N, K, transpose_A, transpose_B, kind, gemm_blocking(), 0};
+  gemm_blocking_t *blk = &task.blk;
+
+  /* Shrink the tiles until every thread has at least two */
+  int m_tiles = (M + blk->mc - 1) / blk->mc;
+  int n_tiles = (N + blk->nc - 1) / blk->nc;
+  while (num_threads > 1 && m_tiles * n_tiles < 2 * num_threads) {
+    if (blk->nc > 4 * PACK_NR)
+      blk->nc = (blk->nc / 2 + PACK_NR - 1) / PACK_NR * PACK_NR;
+    else if (blk->mc > 4 * PACK_MR)
+      blk->mc = (blk->mc / 2 + PACK_MR - 1) / PACK_MR * PACK_MR;
+    else
+      break;
+    m_tiles = (M + blk->mc - 1) / blk->mc;
+    n_tiles = (N + blk->nc - 1) / blk->nc;
+  }
+  task.n_tiles = n_tiles;
+
+  threadpool_t *pool = num_threads > 1 ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, m_tiles * n_tiles, 1, gemm_packed_work,
+                          &task);
+}
+
+/* ============ Small-M path (no packing) ============ */
+
+typedef struct {
+  const void *A;
+  const void *B;
+  void *C;
+  int M;
+  int N;
+  int K;
+  bool transpose_B;
+} gemm_small_task_t;
+
+#define SMALL_WORK(name, kind)                                                 \
+  static void name(void *arg, int j_start, int j_end) {                        \
+    const gemm_small_task_t *t = (const gemm_small_task_t *)arg;               \
+    if (t->transpose_B)                                                        \
+      gemm_dot_cols(t->A, t->B, t->C, t->M, t->N, t->K, j_start, j_end,        \
+                    kind);                                                     \
+    else                                                                       \
+      gemm_cols_avx2(t->A, t->B, t->C, t->M, t->N, t->K, j_start, j_end,       \
+                     kind);                                                    \
+  }
+
+SMALL_WORK(gemm_small_f32_work, ELEM_F32)
+SMALL_WORK(gemm_small_f16_work, ELEM_F16)
+SMALL_WORK(gemm_small_bf16_work, ELEM_BF16)
+
+/*
+ * Few rows: B is streamed straight from memory and the columns are split
+ * across threads. Otherwise the cache-blocked path.
+ */
+static void gemm_avx2(const void *A, const void *B, void *C, int M, int N,
+                      int K, bool transpose_A, bool transpose_B,
+                      int num_threads, int kind) {
+  if (M >= GEMM_AVX2_PACK_MIN_M || transpose_A) {
+    gemm_packed(A, B, C, M, N, K, transpose_A, transpose_B, num_threads,
+                kind);
+    return;
+  }
+
+  gemm_small_task_t task = {A, B, C, M, N, K, transpose_B};
+  threadpool_fn_t fn = kind == ELEM_F32   ? gemm_small_f32_work
+                       : kind == ELEM_F16 ? gemm_small_f16_work
+                                          : gemm_small_bf16_work;
+  threadpool_t *pool = num_threads > 1 ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, N, GEMM_NR, fn, &task);
+}
+
+void gemm_f32_kernel_avx2(const float *A, const float *B, float *C, int M,
+                          int N, int K) {
+  gemm_avx2(A, B, C, M, N, K, false, false, 1, ELEM_F32);
+}
+
+void gemm_f16_kernel_avx2(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                          int M, int N, int K) {
+  gemm_avx2(A, B, C, M, N, K, false, false, 1, ELEM_F16);
+}
+
+void gemm_bf16_kernel_avx2(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                           int M, int N, int K) {
+  gemm_avx2(A, B, C, M, N, K, false, false, 1, ELEM_BF16);
+}
+
+void gemm_f32_kernel_avx2_mt(const float *A, const float *B, float *C, int M,
+                             int N, int K, int num_threads) {
+  gemm_avx2(A, B, C, M, N, K, false, false, num_threads, ELEM_F32);
+}
+
+void gemm_f16_kernel_avx2_mt(const uint16_t *A, const uint16_t *B,
+                             uint16_t *C, int M, int N, int K,
+                             int num_threads) {
+  gemm_avx2(A, B, C, M, N, K, false, false, num_threads, ELEM_F16);
+}
+
+void gemm_bf16_kernel_avx2_mt(const uint16_t *A, const uint16_t *B,
+                              uint16_t *C, int M, int N, int K,
+                              int num_threads) {
+  gemm_avx2(A, B, C, M, N, K, false, false, num_threads, ELEM_BF16);
+}
+
+void gemm_f32_kernel_avx2_trans(const float *A, const float *B, float *C,
+                                int M, int N, int K, bool transpose_A,
+                                bool transpose_B, int num_threads) {
+  gemm_avx2(A, B, C, M, N, K, transpose_A, transpose_B, num_threads,
+            ELEM_F32);
+}
+
+void gemm_f32_tile_kernel_avx2(const float *A, const float *B, float *C,
+                               int M, int N, int K) {
+  gemm_cols_avx2(A, B, C, M, N, K, 0, N, ELEM_F32);
+}
+
+#else
+
+void gemm_f32_kernel_avx2(const float *A, const float *B, float *C, int M,
+                          int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+void gemm_f16_kernel_avx2(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                          int M, int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+void gemm_bf16_kernel_avx2(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                           int M, int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+void gemm_f32_kernel_avx2_mt(const float *A, const float *B, float *C, int M,
+                             int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_f16_kernel_avx2_mt(const uint16_t *A, const uint16_t *B,
+                             uint16_t *C, int M, int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_bf16_kernel_avx2_mt(const uint16_t *A, const uint16_t *B,
+                              uint16_t *C, int M, int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_f32_kernel_avx2_trans(const float *A, const float *B, float *C,
+                                int M, int N, int K, bool transpose_A,
+                                bool transpose_B, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)transpose_A;
+  (void)transpose_B;
+  (void)nt;
+}
+
+void gemm_f32_tile_kernel_avx2(const float *A, const float *B, float *C,
+                               int M, int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+#endif
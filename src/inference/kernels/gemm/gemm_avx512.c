@@ -0,0 +1,689 @@
+/*
+ * AVX-512 GEMM for FP32, FP16 and BF16 on x86-64
+ *
+ * C[M,N] = A[M,K] @ B[K,N], all row-major, F32 accumulation throughout.
+ *
+ * A handful of rows reads B in place with an 8x32 register-blocked
+ * micro-kernel (16 zmm accumulators). When the host has AVX512_BF16 that
+ * BF16 path consumes K in pairs with vdpbf16ps; otherwise BF16/FP16
+ * operands are widened to F32 and fed to vfmadd.
+ *
+ * Larger M goes through the same cache-blocked scheme as the AVX2 kernels
+ * (packed F32 panels, 2D partitioning over C tiles), with a 14x32
+ * micro-kernel; the F32 entry point also takes transposed A and/or B.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/backend/threadpool.h"
+#include "inference/kernels/gemm/gemm_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+
+#include <immintrin.h>
+
+#define GEMM_MR 8
+#define GEMM_NR 32
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX512_INLINE static inline __attribute__((always_inline))
+
+AVX512_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX512_INLINE __m512 load16(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm512_loadu_ps((const float *)p + idx);
+  __m256i h = _mm256_loadu_si256((const __m256i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm512_cvtph_ps(h);
+  return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+}
+
+AVX512_INLINE void store1(void *p, size_t idx, float v, int kind) {
+  if (kind == ELEM_F32) {
+    ((float *)p)[idx] = v;
+  } else if (kind == ELEM_F16) {
+    ((uint16_t *)p)[idx] = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    ((uint16_t *)p)[idx] = (uint16_t)(bits >> 16);
+  }
+}
+
+AVX512_INLINE void store16(void *p, size_t idx, __m512 v, int kind) {
+  if (kind == ELEM_F32) {
+    _mm512_storeu_ps((float *)p + idx, v);
+    return;
+  }
+  __m256i h;
+  if (kind == ELEM_F16) {
+    h = _mm512_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    /* Round-to-nearest-even, then narrow 16x u32 -> 16x u16 */
+    __m512i bits = _mm512_castps_si512(v);
+    __m512i lsb = _mm512_and_si512(_mm512_srli_epi32(bits, 16),
+                                   _mm512_set1_epi32(1));
+    bits = _mm512_add_epi32(bits,
+                            _mm512_add_epi32(_mm512_set1_epi32(0x7fff), lsb));
+    h = _mm512_cvtepi32_epi16(_mm512_srli_epi32(bits, 16));
+  }
+  _mm256_storeu_si256((__m256i *)((uint16_t *)p + idx), h);
+}
+
+/*
+ * 8x32 micro-kernel. Rows beyond `mr` alias the last valid row so the inner
+ * loop stays branch-free; their results are simply not stored.
+ */
+AVX512_INLINE void micro_8x32(const void *A, const void *B, void *C, int N,
+                              int K, int i, int j, int mr, int kind) {
+  size_t arow[GEMM_MR];
+  for (int r = 0; r < GEMM_MR; r++)
+    arow[r] = (size_t)(i + (r < mr ? r : mr - 1)) * K;
+
+  __m512 acc[GEMM_MR][2];
+  for (int r = 0; r < GEMM_MR; r++) {
+    acc[r][0] = _mm512_setzero_ps();
+    acc[r][1] = _mm512_setzero_ps();
+  }
+
+  for (int k = 0; k < K; k++) {
+    size_t boff = (size_t)k * N + j;
+    __m512 b0 = load16(B, boff, kind);
+    __m512 b1 = load16(B, boff + 16, kind);
+    for (int r = 0; r < GEMM_MR; r++) {
+      __m512 a = _mm512_set1_ps(load1(A, arow[r] + k, kind));
+      acc[r][0] = _mm512_fmadd_ps(a, b0, acc[r][0]);
+      acc[r][1] = _mm512_fmadd_ps(a, b1, acc[r][1]);
+    }
+  }
+
+  for (int r = 0; r < mr; r++) {
+    size_t c = (size_t)(i + r) * N + j;
+    store16(C, c, acc[r][0], kind);
+    store16(C, c + 16, acc[r][1], kind);
+  }
+}
+
+/*
+ * BF16 x BF16 -> F32 with vdpbf16ps. Each 32-bit lane of the B operand holds
+ * the (k, k+1) pair for one column, so rows k and k+1 of B are interleaved
+ * on the fly; A contributes the matching pair as a 32-bit broadcast.
+ */
+__attribute__((target("avx512bf16"))) static void
+micro_8x32_dpbf16(const uint16_t *A, const uint16_t *B, uint16_t *C, int N,
+                  int K, int i, int j, int mr) {
+  const __m512i lo_idx = _mm512_set_epi16(
+      47, 15, 46, 14, 45, 13, 44, 12, 43, 11, 42, 10, 41, 9, 40, 8, 39, 7, 38,
+      6, 37, 5, 36, 4, 35, 3, 34, 2, 33, 1, 32, 0);
+  const __m512i hi_idx = _mm512_set_epi16(
+      63, 31, 62, 30, 61, 29, 60, 28, 59, 27, 58, 26, 57, 25, 56, 24, 55, 23,
+      54, 22, 53, 21, 52, 20, 51, 19, 50, 18, 49, 17, 48, 16);
+
+  size_t arow[GEMM_MR];
+  for (int r = 0; r < GEMM_MR; r++)
+    arow[r] = (size_t)(i + (r < mr ? r : mr - 1)) * K;
+
+  __m512 acc[GEMM_MR][2];
+  for (int r = 0; r < GEMM_MR; r++) {
+    acc[r][0] = _mm512_setzero_ps();
+    acc[r][1] = _mm512_setzero_ps();
+  }
+
+  int k = 0;
+  for (; k + 2 <= K; k += 2) {
+    __m512i r0 = _mm512_loadu_si512((const void *)(B + (size_t)k * N + j));
+    __m512i r1 =
+        _mm512_loadu_si512((const void *)(B + (size_t)(k + 1) * N + j));
+    __m512bh b0 = (__m512bh)_mm512_permutex2var_epi16(r0, lo_idx, r1);
+    __m512bh b1 = (__m512bh)_mm512_permutex2var_epi16(r0, hi_idx, r1);
+    for (int r = 0; r < GEMM_MR; r++) {
+      uint32_t pair;
+      memcpy(&pair, A + arow[r] + k, sizeof(pair));
+      __m512bh a = (__m512bh)_mm512_set1_epi32((int)pair);
+      acc[r][0] = _mm512_dpbf16_ps(acc[r][0], a, b0);
+      acc[r][1] = _mm512_dpbf16_ps(acc[r][1], a, b1);
+    }
+  }
+  if (k < K) {
+    size_t boff = (size_t)k * N + j;
+    __m512 b0 = load16(B, boff, ELEM_BF16);
+    __m512 b1 = load16(B, boff + 16, ELEM_BF16);
+    for (int r = 0; r < GEMM_MR; r++) {
+      __m512 a = _mm512_set1_ps(load1(A, arow[r] + k, ELEM_BF16));
+      acc[r][0] = _mm512_fmadd_ps(a, b0, acc[r][0]);
+      acc[r][1] = _mm512_fmadd_ps(a, b1, acc[r][1]);
+    }
+  }
+
+  for (int r = 0; r < mr; r++) {
+    size_t c = (size_t)(i + r) * N + j;
+    store16(C, c, acc[r][0], ELEM_BF16);
+    store16(C, c + 16, acc[r][1], ELEM_BF16);
+  }
+}
+
+/* Column tail: one row at a time, 16 columns then a masked remainder */
+AVX512_INLINE void gemm_row_tail(const void *A, const void *B, void *C, int N,
+                                 int K, int i, int j_start, int kind) {
+  size_t arow = (size_t)i * K;
+  int j = j_start;
+  for (; j + 16 <= N; j += 16) {
+    __m512 acc = _mm512_setzero_ps();
+    for (int k = 0; k < K; k++) {
+      __m512 a = _mm512_set1_ps(load1(A, arow + k, kind));
+      acc = _mm512_fmadd_ps(a, load16(B, (size_t)k * N + j, kind), acc);
+    }
+    store16(C, (size_t)i * N + j, acc, kind);
+  }
+  for (; j < N; j++) {
+    float sum = 0.0f;
+    for (int k = 0; k < K; k++)
+      sum += load1(A, arow + k, kind) * load1(B, (size_t)k * N + j, kind);
+    store1(C, (size_t)i * N + j, sum, kind);
+  }
+}
+
+static void gemm_rows_avx512(const void *A, const void *B, void *C, int N,
+                             int K, int row_start, int row_end, int kind) {
+  int n_main = N - N % GEMM_NR;
+  bool use_dpbf16 = kind == ELEM_BF16 && caps_get()->has_avx512_bf16;
+
+  for (int i = row_start; i < row_end; i += GEMM_MR) {
+    int mr = row_end - i < GEMM_MR ? row_end - i : GEMM_MR;
+
+    for (int j = 0; j < n_main; j += GEMM_NR) {
+      if (use_dpbf16)
+        micro_8x32_dpbf16(A, B, C, N, K, i, j, mr);
+      else
+        micro_8x32(A, B, C, N, K, i, j, mr, kind);
+    }
+
+    if (n_main < N) {
+      for (int r = 0; r < mr; r++)
+        gemm_row_tail(A, B, C, N, K, i + r, n_main, kind);
+    }
+  }
+}
+
+void gemm_f32_kernel_avx512(const float *A, const float *B, float *C, int M,
+                            int N, int K) {
+  gemm_rows_avx512(A, B, C, N, K, 0, M, ELEM_F32);
+}
+
+void gemm_f16_kernel_avx512(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                            int M, int N, int K) {
+  gemm_rows_avx512(A, B, C, N, K, 0, M, ELEM_F16);
+}
+
+void gemm_bf16_kernel_avx512(const uint16_t *A, const uint16_t *B,
+                             uint16_t *C, int M, int N, int K) {
+  gemm_rows_avx512(A, B, C, N, K, 0, M, ELEM_BF16);
+}
+
+/* ============ Multi-threaded variants (row partitioning) ============ */
+
+typedef struct {
+  const void *A;
+  const void *B;
+  void *C;
+  int N;
+  int K;
+  int kind;
+} gemm_avx512_task_t;
+
+static void gemm_avx512_work(void *arg, int row_start, int row_end) {
+  gemm_avx512_task_t *t = (gemm_avx512_task_t *)arg;
+  gemm_rows_avx512(t->A, t->B, t->C, t->N, t->K, row_start, row_end,
+                   t->kind);
+}
+
+static void gemm_avx512_mt(const void *A, const void *B, void *C, int M,
+                           int N, int K, int num_threads, int kind) {
+  gemm_avx512_task_t task = {A, B, C, N, K, kind};
+
+  /* At most num_threads partitions, aligned to the micro-kernel height */
+  int grain = M;
+  if (num_threads > 1) {
+    grain = (M + num_threads - 1) / num_threads;
+    grain = (grain + GEMM_MR - 1) / GEMM_MR * GEMM_MR;
+  }
+  threadpool_parallel_for(threadpool_global(), 0, M, grain, gemm_avx512_work,
+                          &task);
+}
+
+void gemm_f32_kernel_avx512_mt(const float *A, const float *B, float *C, int M,
+                               int N, int K, int num_threads) {
+  gemm_avx512_mt(A, B, C, M, N, K, num_threads, ELEM_F32);
+}
+
+void gemm_f16_kernel_avx512_mt(const uint16_t *A, const uint16_t *B,
+                               uint16_t *C, int M, int N, int K,
+                               int num_threads) {
+  gemm_avx512_mt(A, B, C, M, N, K, num_threads, ELEM_F16);
+}
+
+void gemm_bf16_kernel_avx512_mt(const uint16_t *A, const uint16_t *B,
+                                uint16_t *C, int M, int N, int K,
+                                int num_threads) {
+  gemm_avx512_mt(A, B, C, M, N, K, num_threads, ELEM_BF16);
+}
+
+
+/* ============ Cache-blocked path (packed panels) ============ */
+
+/*
+ * Goto-style blocking as in gemm_avx2.c: C is cut into MC x NC tiles that
+ * are computed independently. For each KC slice the tile's block of A is
+ * packed into MR-row strips and its block of B into NR-column strips, both
+ * converted to F32, so the micro-kernel streams two contiguous buffers
+ * whatever the source dtype and transposition.
+ */
+
+#define PACK_MR 14
+#define PACK_NR 32
+
+typedef struct {
+  int kc;
+  int mc;
+  int nc;
+} gemm_blocking_t;
+
+static int clamp_block(int v, int lo, int hi, int mult) {
+  v = v / mult * mult;
+  return v < lo ? lo : (v > hi ? hi : v);
+}
+
+static gemm_blocking_t gemm_blocking(void) {
+  const system_caps_t *caps = caps_get();
+  size_t l1 = caps->l1_cache_size ? caps->l1_cache_size : 32 * 1024;
+  size_t l2 = caps->l2_cache_size ? caps->l2_cache_size : 256 * 1024;
+
+  gemm_blocking_t b;
+  /* One A strip and one B strip share half of L1 */
+  b.kc = clamp_block((int)(l1 / 2 / ((PACK_MR + PACK_NR) * sizeof(float))),
+                     64, 512, 8);
+  /* The packed A block takes a quarter of L2, the B block half of it */
+  b.mc = clamp_block((int)(l2 / 4 / (b.kc * sizeof(float))), PACK_MR,
+                     14 * PACK_MR, PACK_MR);
+  b.nc = clamp_block((int)(l2 / 2 / (b.kc * sizeof(float))), PACK_NR, 512,
+                     PACK_NR);
+  return b;
+}
+
+/* Element (i, k) of A or (k, j) of B, honoring the transpose flags */
+AVX512_INLINE size_t a_index(int i, int k, int M, int K, bool trans) {
+  return trans ? (size_t)k * M + i : (size_t)i * K + k;
+}
+
+AVX512_INLINE size_t b_index(int k, int j, int N, int K, bool trans) {
+  return trans ? (size_t)j * K + k : (size_t)k * N + j;
+}
+
+/* dst[strip][k][r]: MR-row strips of A[i0 : i0+mc, p0 : p0+kc], zero padded */
+static void pack_a(const void *A, float *dst, int M, int K, bool trans,
+                   int i0, int mc, int p0, int kc, int kind) {
+  for (int ir = 0; ir < mc; ir += PACK_MR) {
+    float *d = dst + (size_t)ir * kc;
+    int mr = mc - ir < PACK_MR ? mc - ir : PACK_MR;
+    if (mr < PACK_MR)
+      memset(d, 0, (size_t)kc * PACK_MR * sizeof(float));
+    if (trans) {
+      for (int k = 0; k < kc; k++)
+        for (int r = 0; r < mr; r++)
+          d[k * PACK_MR + r] =
+              load1(A, a_index(i0 + ir + r, p0 + k, M, K, true), kind);
+    } else {
+      for (int r = 0; r < mr; r++) {
+        size_t row = a_index(i0 + ir + r, p0, M, K, false);
+        for (int k = 0; k < kc; k++)
+          d[k * PACK_MR + r] = load1(A, row + k, kind);
+      }
+    }
+  }
+}
+
+/* dst[strip][k][c]: NR-column strips of B[p0 : p0+kc, j0 : j0+nc] */
+static void pack_b(const void *B, float *dst, int N, int K, bool trans,
+                   int j0, int nc, int p0, int kc, int kind) {
+  for (int jr = 0; jr < nc; jr += PACK_NR) {
+    float *d = dst + (size_t)jr * kc;
+    int nr = nc - jr < PACK_NR ? nc - jr : PACK_NR;
+    if (nr < PACK_NR)
+      memset(d, 0, (size_t)kc * PACK_NR * sizeof(float));
+    if (trans) {
+      for (int c = 0; c < nr; c++) {
+        size_t col = b_index(p0, j0 + jr + c, N, K, true);
+        for (int k = 0; k < kc; k++)
+          d[k * PACK_NR + c] = load1(B, col + k, kind);
+      }
+    } else if (nr == PACK_NR) {
+      for (int k = 0; k < kc; k++) {
+        size_t row = b_index(p0 + k, j0 + jr, N, K, false);
+        _mm512_storeu_ps(d + k * PACK_NR, load16(B, row, kind));
+        _mm512_storeu_ps(d + k * PACK_NR + 16, load16(B, row + 16, kind));
+      }
+    } else {
+      for (int k = 0; k < kc; k++) {
+        size_t row = b_index(p0 + k, j0 + jr, N, K, false);
+        for (int c = 0; c < nr; c++)
+          d[k * PACK_NR + c] = load1(B, row + c, kind);
+      }
+    }
+  }
+}
+
+AVX512_INLINE __mmask16 lane_mask(int n) {
+  return n >= 16 ? (__mmask16)0xffff
+                 : (n <= 0 ? (__mmask16)0 : (__mmask16)((1u << n) - 1));
+}
+
+/* X(r) for each row of the micro-tile */
+#define MICRO_ROWS(X)                                                          \
+  X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13)
+
+#define MICRO_ZERO(r)                                                          \
+  __m512 c##r##_0 = _mm512_setzero_ps();                                       \
+  __m512 c##r##_1 = _mm512_setzero_ps();
+
+#define MICRO_FMA(r)                                                           \
+  {                                                                            \
+    __m512 a_ = _mm512_set1_ps(a[r]);                                          \
+    c##r##_0 = _mm512_fmadd_ps(a_, b0, c##r##_0);                              \
+    c##r##_1 = _mm512_fmadd_ps(a_, b1, c##r##_1);                              \
+  }
+
+#define MICRO_STORE(r)                                                         \
+  if ((r) < mr) {                                                              \
+    float *row_ = c + (r) * ldc;                                               \
+    if (accumulate) {                                                          \
+      c##r##_0 = _mm512_add_ps(c##r##_0, _mm512_maskz_loadu_ps(m0, row_));     \
+      c##r##_1 =                                                               \
+          _mm512_add_ps(c##r##_1, _mm512_maskz_loadu_ps(m1, row_ + 16));       \
+    }                                                                          \
+    _mm512_mask_storeu_ps(row_, m0, c##r##_0);                                 \
+    _mm512_mask_storeu_ps(row_ + 16, m1, c##r##_1);                            \
+  }
+
+/*
+ * 14x32 micro-kernel over packed strips: 28 accumulators, 2 B vectors and
+ * one broadcast fill 31 of the 32 zmm registers. Kept out of line: inlined
+ * into the tile loop, the caller's live values push a B vector onto the
+ * stack. Partial tiles store only their first mr rows and nr columns.
+ */
+static __attribute__((noinline)) void
+micro_14x32_packed(const float *a, const float *b, int kc, float *c,
+                   size_t ldc, int mr, int nr, bool accumulate) {
+  MICRO_ROWS(MICRO_ZERO)
+
+  for (int k = 0; k < kc; k++) {
+    __m512 b0 = _mm512_loadu_ps(b);
+    __m512 b1 = _mm512_loadu_ps(b + 16);
+    MICRO_ROWS(MICRO_FMA)
+    a += PACK_MR;
+    b += PACK_NR;
+  }
+
+  __mmask16 m0 = lane_mask(nr);
+  __mmask16 m1 = lane_mask(nr - 16);
+  MICRO_ROWS(MICRO_STORE)
+}
+
+typedef struct {
+  const void *A;
+  const void *B;
+  void *C;
+  int M;
+  int N;
+  int K;
+  bool transpose_A;
+  bool transpose_B;
+  int kind;
+  gemm_blocking_t blk;
+  int n_tiles; /* Tiles per row of C */
+} gemm_packed_task_t;
+
+/* Packing buffers, kept per worker thread and grown on demand */
+static _Thread_local float *tls_pack = NULL;
+static _Thread_local size_t tls_pack_floats = 0;
+
+static float *pack_buffer(size_t floats) {
+  if (tls_pack_floats < floats) {
+    size_t bytes = (floats * sizeof(float) + 63) & ~(size_t)63;
+    float *p = (float *)aligned_alloc(64, bytes);
+    if (!p)
+      return NULL;
+    free(tls_pack);
+    tls_pack = p;
+    tls_pack_floats = floats;
+  }
+  return tls_pack;
+}
+
+/* Out of memory for the packing buffers: compute the tile in place */
+static void gemm_tile_unpacked(const gemm_packed_task_t *t, int i0, int mc,
+                               int j0, int nc) {
+  for (int i = i0; i < i0 + mc; i++) {
+    for (int j = j0; j < j0 + nc; j++) {
+      float sum = 0.0f;
+      for (int k = 0; k < t->K; k++)
+        sum += load1(t->A, a_index(i, k, t->M, t->K, t->transpose_A),
+                     t->kind) *
+               load1(t->B, b_index(k, j, t->N, t->K, t->transpose_B),
+                     t->kind);
+      store1(t->C, (size_t)i * t->N + j, sum, t->kind);
+    }
+  }
+}
+
+static void gemm_packed_work(void *arg, int tile_start, int tile_end) {
+  const gemm_packed_task_t *t = (const gemm_packed_task_t *)arg;
+  const gemm_blocking_t *blk = &t->blk;
+  int nc_pad = (blk->nc + PACK_NR - 1) / PACK_NR * PACK_NR;
+
+  size_t a_floats = (size_t)blk->mc * blk->kc;
+  size_t b_floats = (size_t)nc_pad * blk->kc;
+  /* 16-bit outputs accumulate in F32 and are rounded once per tile */
+  size_t c_floats = t->kind == ELEM_F32 ? 0 : (size_t)blk->mc * blk->nc;
+  float *a_pack = pack_buffer(a_floats + b_floats + c_floats);
+  float *b_pack = a_pack ? a_pack + a_floats : NULL;
+  float *c_tile = a_pack && c_floats ? b_pack + b_floats : NULL;
+
+  for (int tile = tile_start; tile < tile_end; tile++) {
+    int i0 = tile / t->n_tiles * blk->mc;
+    int j0 = tile % t->n_tiles * blk->nc;
+    int mc = t->M - i0 < blk->mc ? t->M - i0 : blk->mc;
+    int nc = t->N - j0 < blk->nc ? t->N - j0 : blk->nc;
+
+    if (!a_pack) {
+      gemm_tile_unpacked(t, i0, mc, j0, nc);
+      continue;
+    }
+
+    float *c = c_tile ? c_tile : (float *)t->C + (size_t)i0 * t->N + j0;
+    size_t ldc = c_tile ? (size_t)nc : (size_t)t->N;
+
+    for (int p0 = 0; p0 < t->K; p0 += blk->kc) {
+      int kc = t->K - p0 < blk->kc ? t->K - p0 : blk->kc;
+      pack_b(t->B, b_pack, t->N, t->K, t->transpose_B, j0, nc, p0, kc,
+             t->kind);
+      pack_a(t->A, a_pack, t->M, t->K, t->transpose_A, i0, mc, p0, kc,
+             t->kind);
+
+      for (int jr = 0; jr < nc; jr += PACK_NR) {
+        int nr = nc - jr < PACK_NR ? nc - jr : PACK_NR;
+        for (int ir = 0; ir < mc; ir += PACK_MR) {
+          int mr = mc - ir < PACK_MR ? mc - ir : PACK_MR;
+          micro_14x32_packed(a_pack + (size_t)ir * kc,
+                             b_pack + (size_t)jr * kc, kc,
+                             c + ir * ldc + jr, ldc, mr, nr, p0 > 0);
+        }
+      }
+    }
+
+    if (c_tile) {
+      for (int r = 0; r < mc; r++) {
+        size_t out = (size_t)(i0 + r) * t->N + j0;
+        const float *src = c_tile + (size_t)r * nc;
+        int j = 0;
+        for (; j + 16 <= nc; j += 16)
+          store16(t->C, out + j, _mm512_loadu_ps(src + j), t->kind);
+        for (; j < nc; j++)
+          store1(t->C, out + j, src[j], t->kind);
+      }
+    }
+  }
+}
+
+static void gemm_packed(const void *A, const void *B, void *C, int M, int N,
+                        int K, bool transpose_A, bool transpose_B,
+                        int num_threads, int kind) {
+  gemm_packed_task_t task = {
+      A, B, C, M, N, K, transpose_A, transpose_B, kind, gemm_blocking(), 0};
+  gemm_blocking_t *blk = &task.blk;
+
+  /* Shrink the tiles until every thread has at least two */
+  int m_tiles = (M + blk->mc - 1) / blk->mc;
+  int n_tiles = (N + blk->nc - 1) / blk->nc;
+  while (num_threads > 1 && m_tiles * n_tiles < 2 * num_threads) {
+    if (blk->nc > 4 * PACK_NR)
+      blk->nc = (blk->nc / 2 + PACK_NR - 1) / PACK_NR * PACK_NR;
+    else if (blk->mc > 4 * PACK_MR)
+      blk->mc = (blk->mc / 2 + PACK_MR - 1) / PACK_MR * PACK_MR;
+    else
+      break;
+    m_tiles = (M + blk->mc - 1) / blk->mc;
+    n_tiles = (N + blk->nc - 1) / blk->nc;
+  }
+  task.n_tiles = n_tiles;
+
+  threadpool_t *pool = num_threads > 1 ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, m_tiles * n_tiles, 1, gemm_packed_work,
+                          &task);
+}
+
+void gemm_f32_kernel_avx512_packed(const float *A, const float *B, float *C,
+                                   int M, int N, int K, bool transpose_A,
+                                   bool transpose_B, int num_threads) {
+  gemm_packed(A, B, C, M, N, K, transpose_A, transpose_B, num_threads,
+              ELEM_F32);
+}
+
+void gemm_f16_kernel_avx512_packed(const uint16_t *A, const uint16_t *B,
+                                   uint16_t *C, int M, int N, int K,
+                                   int num_threads) {
+  gemm_packed(A, B, C, M, N, K, false, false, num_threads, ELEM_F16);
+}
+
+void gemm_bf16_kernel_avx512_packed(const uint16_t *A, const uint16_t *B,
+                                    uint16_t *C, int M, int N, int K,
+                                    int num_threads) {
+  gemm_packed(A, B, C, M, N, K, false, false, num_threads, ELEM_BF16);
+}
+
+#else
+
+void gemm_f32_kernel_avx512(const float *A, const float *B, float *C, int M,
+                            int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+void gemm_f16_kernel_avx512(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                            int M, int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+void gemm_bf16_kernel_avx512(const uint16_t *A, const uint16_t *B,
+                             uint16_t *C, int M, int N, int K) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+}
+void gemm_f32_kernel_avx512_mt(const float *A, const float *B, float *C, int M,
+                               int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_f16_kernel_avx512_mt(const uint16_t *A, const uint16_t *B,
+                               uint16_t *C, int M, int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_bf16_kernel_avx512_mt(const uint16_t *A, const uint16_t *B,
+                                uint16_t *C, int M, int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_f32_kernel_avx512_packed(const float *A, const float *B, float *C,
+                                   int M, int N, int K, bool transpose_A,
+                                   bool transpose_B, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)transpose_A;
+  (void)transpose_B;
+  (void)nt;
+}
+void gemm_f16_kernel_avx512_packed(const uint16_t *A, const uint16_t *B,
+                                   uint16_t *C, int M, int N, int K, int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+void gemm_bf16_kernel_avx512_packed(const uint16_t *A, const uint16_t *B,
+                                    uint16_t *C, int M, int N, int K,
+                                    int nt) {
+  (void)A;
+  (void)B;
+  (void)C;
+  (void)M;
+  (void)N;
+  (void)K;
+  (void)nt;
+}
+#endif
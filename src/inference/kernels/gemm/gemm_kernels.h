@@ -38,4 +38,69 @@ void gemm_f16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
 void gemm_bf16_kernel_amx_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
                              int M, int N, int K, int num_threads);
 
+void gemm_f32_kernel_avx2(const float *A, const float *B, float *C, int M,
+                          int N, int K);
+void gemm_f16_kernel_avx2(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                          int M, int N, int K);
+void gemm_bf16_kernel_avx2(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                           int M, int N, int K);
+void gemm_f32_kernel_avx2_mt(const float *A, const float *B, float *C, int M,
+                             int N, int K, int num_threads);
+void gemm_f16_kernel_avx2_mt(const uint16_t *A, const uint16_t *B,
+                             uint16_t *C, int M, int N, int K,
+                             int num_threads);
+void gemm_bf16_kernel_avx2_mt(const uint16_t *A, const uint16_t *B,
+                              uint16_t *C, int M, int N, int K,
+                              int num_threads);
+/*
+ * From this many rows the AVX2 kernels pack cache-sized panels; below it
+ * packing B costs about as much as the multiply
+ */
+#define GEMM_AVX2_PACK_MIN_M 16
+
+/* Any transpose combination; num_threads <= 1 stays on the caller */
+void gemm_f32_kernel_avx2_trans(const float *A, const float *B, float *C,
+                                int M, int N, int K, bool transpose_A,
+                                bool transpose_B, int num_threads);
+
+/*
+ * C = A x B on small contiguous tiles with the 4x16 micro-kernel, on the
+ * calling thread and without packing or allocation. For kernels that tile
+ * a larger problem themselves.
+ */
+void gemm_f32_tile_kernel_avx2(const float *A, const float *B, float *C,
+                               int M, int N, int K);
+
+void gemm_f32_kernel_avx512(const float *A, const float *B, float *C, int M,
+                            int N, int K);
+void gemm_f16_kernel_avx512(const uint16_t *A, const uint16_t *B, uint16_t *C,
+                            int M, int N, int K);
+void gemm_bf16_kernel_avx512(const uint16_t *A, const uint16_t *B,
+                             uint16_t *C, int M, int N, int K);
+void gemm_f32_kernel_avx512_mt(const float *A, const float *B, float *C, int M,
+                               int N, int K, int num_threads);
+void gemm_f16_kernel_avx512_mt(const uint16_t *A, const uint16_t *B,
+                               uint16_t *C, int M, int N, int K,
+                               int num_threads);
+void gemm_bf16_kernel_avx512_mt(const uint16_t *A, const uint16_t *B,
+                                uint16_t *C, int M, int N, int K,
+                                int num_threads);
+
+/*
+ * From this many rows the AVX-512 kernels pack cache-sized panels for the
+ * 14x32 micro-kernel; below it they read B in place
+ */
+#define GEMM_AVX512_PACK_MIN_M 16
+
+/* Cache-blocked AVX-512 paths; num_threads <= 1 stays on the caller */
+void gemm_f32_kernel_avx512_packed(const float *A, const float *B, float *C,
+                                   int M, int N, int K, bool transpose_A,
+                                   bool transpose_B, int num_threads);
+void gemm_f16_kernel_avx512_packed(const uint16_t *A, const uint16_t *B,
+                                   uint16_t *C, int M, int N, int K,
+                                   int num_threads);
+void gemm_bf16_kernel_avx512_packed(const uint16_t *A, const uint16_t *B,
+                                    uint16_t *C, int M, int N, int K,
+                                    int num_threads);
+
 #endif
@@ -1,12 +1,9 @@
 #include "inference/backend/caps.h"
+#include "inference/backend/threadpool.h"
 #include "inference/kernels/gemm/gemm_kernels.h"
 #include <stdlib.h>
 #include <string.h>
 
-#ifndef _WIN32
-#include <pthread.h>
-#endif
-
 #if defined(__ARM_NEON) || defined(__ARM_NEON__)
 #include <arm_neon.h>
 #define HAS_NEON 1
@@ -733,26 +730,30 @@ typedef struct {
   const float *A;
   const float *B;
   float *C;
-  int M, N, K;
-  int m_start, m_end;
+  int N, K;
 } gemm_f32_task_t;
 
-static void *gemm_f32_thread_fn(void *arg) {
+static void gemm_f32_work(void *arg, int m_start, int m_end) {
   gemm_f32_task_t *task = (gemm_f32_task_t *)arg;
-  const float *A = task->A;
+  const float *A = task->A + (size_t)m_start * task->K;
   const float *B = task->B;
-  float *C = task->C;
+  float *C = task->C + (size_t)m_start * task->N;
   int N = task->N;
   int K = task->K;
 
-  for (int mi = task->m_start; mi < task->m_end; mi += 8) {
-    int mi_end = (mi + 8 > task->m_end) ? task->m_end : mi + 8;
+  for (int mi = m_start; mi < m_end; mi += 8) {
+    int mi_end = (mi + 8 > m_end) ? m_end : mi + 8;
     for (int ni = 0; ni < N; ni += 8) {
-      micro_kernel_8x8_neon(A, B, C, mi_end - task->m_start, N, K, K, N, N,
-                            mi - task->m_start, ni);
+      micro_kernel_8x8_neon(A, B, C, mi_end - m_start, N, K, K, N, N,
+                            mi - m_start, ni);
     }
   }
-  return NULL;
+}
+
+/* Rows per partition: at most num_threads partitions, multiples of 8 */
+static int gemm_mt_grain(int M, int num_threads) {
+  int rows_per_thread = (M + num_threads - 1) / num_threads;
+  return ((rows_per_thread + 7) / 8) * 8;
 }
 
 void gemm_f32_kernel_mt(const float *A, const float *B, float *C, int M, int N,
@@ -764,62 +765,24 @@ void gemm_f32_kernel_mt(const float *A, const float *B, float *C, int M, int N,
     return;
   }
 
-  if (num_threads > M / 8)
-    num_threads = M / 8;
-  if (num_threads < 1)
-    num_threads = 1;
-
-  pthread_t *threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
-  gemm_f32_task_t *tasks =
-      (gemm_f32_task_t *)malloc(num_threads * sizeof(gemm_f32_task_t));
-
-  int rows_per_thread = (M + num_threads - 1) / num_threads;
-  rows_per_thread = ((rows_per_thread + 7) / 8) * 8;
-
-  for (int t = 0; t < num_threads; t++) {
-    int m_start = t * rows_per_thread;
-    int m_end = m_start + rows_per_thread;
-    if (m_end > M)
-      m_end = M;
-    if (m_start >= M) {
-      num_threads = t;
-      break;
-    }
-
-    tasks[t].A = A + m_start * K;
-    tasks[t].B = B;
-    tasks[t].C = C + m_start * N;
-    tasks[t].M = M;
-    tasks[t].N = N;
-    tasks[t].K = K;
-    tasks[t].m_start = m_start;
-    tasks[t].m_end = m_end;
-
-    pthread_create(&threads[t], NULL, gemm_f32_thread_fn, &tasks[t]);
-  }
-
-  for (int t = 0; t < num_threads; t++) {
-    pthread_join(threads[t], NULL);
-  }
-
-  free(threads);
-  free(tasks);
+  gemm_f32_task_t task = {A, B, C, N, K};
+  threadpool_parallel_for(threadpool_global(), 0, M,
+                          gemm_mt_grain(M, num_threads), gemm_f32_work, &task);
 }
 
 typedef struct {
   const uint16_t *A;
   const uint16_t *B;
   uint16_t *C;
-  int M, N, K;
-  int m_start, m_end;
-} gemm_bf16_task_t;
+  int N, K;
+} gemm_half_task_t;
 
-static void *gemm_bf16_thread_fn(void *arg) {
-  gemm_bf16_task_t *task = (gemm_bf16_task_t *)arg;
-  const uint16_t *A = task->A;
+static void gemm_bf16_work(void *arg, int m_start, int m_end) {
+  gemm_half_task_t *task = (gemm_half_task_t *)arg;
+  const uint16_t *A = task->A + (size_t)m_start * task->K;
   const uint16_t *B = task->B;
-  uint16_t *C = task->C;
-  int M_local = task->m_end - task->m_start;
+  uint16_t *C = task->C + (size_t)m_start * task->N;
+  int M_local = m_end - m_start;
   int N = task->N;
   int K = task->K;
 
@@ -828,7 +791,6 @@ static void *gemm_bf16_thread_fn(void *arg) {
       micro_kernel_bf16_8x8_neon(A, B, C, M_local, N, K, mi, ni);
     }
   }
-  return NULL;
 }
 
 void gemm_bf16_kernel_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
@@ -838,62 +800,17 @@ void gemm_bf16_kernel_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
     return;
   }
 
-  if (num_threads > M / 8)
-    num_threads = M / 8;
-  if (num_threads < 1)
-    num_threads = 1;
-
-  pthread_t *threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
-  gemm_bf16_task_t *tasks =
-      (gemm_bf16_task_t *)malloc(num_threads * sizeof(gemm_bf16_task_t));
-
-  int rows_per_thread = (M + num_threads - 1) / num_threads;
-  rows_per_thread = ((rows_per_thread + 7) / 8) * 8;
-
-  for (int t = 0; t < num_threads; t++) {
-    int m_start = t * rows_per_thread;
-    int m_end = m_start + rows_per_thread;
-    if (m_end > M)
-      m_end = M;
-    if (m_start >= M) {
-      num_threads = t;
-      break;
-    }
-
-    tasks[t].A = A + m_start * K;
-    tasks[t].B = B;
-    tasks[t].C = C + m_start * N;
-    tasks[t].M = M;
-    tasks[t].N = N;
-    tasks[t].K = K;
-    tasks[t].m_start = m_start;
-    tasks[t].m_end = m_end;
-
-    pthread_create(&threads[t], NULL, gemm_bf16_thread_fn, &tasks[t]);
-  }
-
-  for (int t = 0; t < num_threads; t++) {
-    pthread_join(threads[t], NULL);
-  }
-
-  free(threads);
-  free(tasks);
+  gemm_half_task_t task = {A, B, C, N, K};
+  threadpool_parallel_for(threadpool_global(), 0, M,
+                          gemm_mt_grain(M, num_threads), gemm_bf16_work, &task);
 }
 
-typedef struct {
-  const uint16_t *A;
-  const uint16_t *B;
-  uint16_t *C;
-  int M, N, K;
-  int m_start, m_end;
-} gemm_f16_task_t;
-
-static void *gemm_f16_thread_fn(void *arg) {
-  gemm_f16_task_t *task = (gemm_f16_task_t *)arg;
-  const uint16_t *A = task->A;
+static void gemm_f16_work(void *arg, int m_start, int m_end) {
+  gemm_half_task_t *task = (gemm_half_task_t *)arg;
+  const uint16_t *A = task->A + (size_t)m_start * task->K;
   const uint16_t *B = task->B;
-  uint16_t *C = task->C;
-  int M_local = task->m_end - task->m_start;
+  uint16_t *C = task->C + (size_t)m_start * task->N;
+  int M_local = m_end - m_start;
   int N = task->N;
   int K = task->K;
 
@@ -902,7 +819,6 @@ static void *gemm_f16_thread_fn(void *arg) {
       micro_kernel_f16_8x8_neon(A, B, C, M_local, N, K, mi, ni);
     }
   }
-  return NULL;
 }
 
 void gemm_f16_kernel_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
@@ -912,46 +828,9 @@ void gemm_f16_kernel_mt(const uint16_t *A, const uint16_t *B, uint16_t *C,
     return;
   }
 
-  if (num_threads > M / 8)
-    num_threads = M / 8;
-  if (num_threads < 1)
-    num_threads = 1;
-
-  pthread_t *threads = (pthread_t *)malloc(num_threads * sizeof(pthread_t));
-  gemm_f16_task_t *tasks =
-      (gemm_f16_task_t *)malloc(num_threads * sizeof(gemm_f16_task_t));
-
-  int rows_per_thread = (M + num_threads - 1) / num_threads;
-  rows_per_thread = ((rows_per_thread + 7) / 8) * 8;
-
-  for (int t = 0; t < num_threads; t++) {
-    int m_start = t * rows_per_thread;
-    int m_end = m_start + rows_per_thread;
-    if (m_end > M)
-      m_end = M;
-    if (m_start >= M) {
-      num_threads = t;
-      break;
-    }
-
-    tasks[t].A = A + m_start * K;
-    tasks[t].B = B;
-    tasks[t].C = C + m_start * N;
-    tasks[t].M = M;
-    tasks[t].N = N;
-    tasks[t].K = K;
-    tasks[t].m_start = m_start;
-    tasks[t].m_end = m_end;
-
-    pthread_create(&threads[t], NULL, gemm_f16_thread_fn, &tasks[t]);
-  }
-
-  for (int t = 0; t < num_threads; t++) {
-    pthread_join(threads[t], NULL);
-  }
-
-  free(threads);
-  free(tasks);
+  gemm_half_task_t task = {A, B, C, N, K};
+  threadpool_parallel_for(threadpool_global(), 0, M,
+                          gemm_mt_grain(M, num_threads), gemm_f16_work, &task);
 }
 
 #else
@@ -0,0 +1,250 @@
+/*
+ * Matrix-Vector Products - Dispatcher and Scalar Kernels
+ *
+ * The outputs are split into contiguous ranges across the shared thread
+ * pool, so every thread streams a disjoint part of W and no reduction is
+ * needed afterwards. Small matrices stay on the calling thread, where the
+ * dispatch would cost more than the product.
+ */
+
+#include "inference/kernels/gemv/gemv.h"
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/gemv/gemv_kernels.h"
+#include <stdlib.h>
+#include <string.h>
+
+/* Below this many weight bytes the GEMV stays on the calling thread */
+#define GEMV_MT_MIN_BYTES (256 * 1024)
+
+/* Outputs per chunk handed to a thread */
+#define GEMV_GRAIN 16
+
+/* ============================================================================
+ * Scalar Kernels
+ * ============================================================================
+ */
+
+static inline float load_f32(const void *W, size_t idx, dtype_t dtype) {
+  if (dtype == DTYPE_F32)
+    return ((const float *)W)[idx];
+  if (dtype == DTYPE_F16)
+    return f16_to_f32(((const uint16_t *)W)[idx]);
+  return bf16_to_f32(((const uint16_t *)W)[idx]);
+}
+
+static void gemv_rows_scalar(const void *W, const float *x, float *y, int K,
+                             int n_start, int n_end, dtype_t dtype) {
+  for (int n = n_start; n < n_end; n++) {
+    size_t row = (size_t)n * K;
+    float sum = 0.0f;
+    for (int k = 0; k < K; k++)
+      sum += load_f32(W, row + k, dtype) * x[k];
+    y[n] = sum;
+  }
+}
+
+static void gemv_cols_scalar(const void *W, const float *x, float *y, int N,
+                             int K, int n_start, int n_end, dtype_t dtype) {
+  float acc[GEMV_COL_TILE];
+  for (int n0 = n_start; n0 < n_end; n0 += GEMV_COL_TILE) {
+    int width = n_end - n0 < GEMV_COL_TILE ? n_end - n0 : GEMV_COL_TILE;
+    memset(acc, 0, (size_t)width * sizeof(float));
+    for (int k = 0; k < K; k++) {
+      size_t row = (size_t)k * N + n0;
+      for (int j = 0; j < width; j++)
+        acc[j] += load_f32(W, row + j, dtype) * x[k];
+    }
+    memcpy(y + n0, acc, (size_t)width * sizeof(float));
+  }
+}
+
+/* ============================================================================
+ * Dispatch
+ * ============================================================================
+ */
+
+typedef void (*gemv_kernel_fn)(const void *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end);
+
+typedef struct {
+  const void *W;
+  const float *x;
+  float *y;
+  int N;
+  int K;
+  dtype_t dtype;
+  bool transposed;
+  gemv_kernel_fn kernel; /* NULL selects the scalar loops */
+} gemv_task_t;
+
+static gemv_kernel_fn select_kernel(dtype_t dtype, bool transposed) {
+  gemv_caps_t caps = gemv_get_capabilities();
+  if (caps.has_neon) {
+    if (dtype == DTYPE_F32)
+      return transposed ? (gemv_kernel_fn)gemv_cols_f32_kernel
+                        : (gemv_kernel_fn)gemv_rows_f32_kernel;
+    if (dtype == DTYPE_F16)
+      return transposed ? (gemv_kernel_fn)gemv_cols_f16_kernel
+                        : (gemv_kernel_fn)gemv_rows_f16_kernel;
+    return transposed ? (gemv_kernel_fn)gemv_cols_bf16_kernel
+                      : (gemv_kernel_fn)gemv_rows_bf16_kernel;
+  }
+  if (caps.has_avx512) {
+    if (dtype == DTYPE_F32)
+      return transposed ? (gemv_kernel_fn)gemv_cols_f32_kernel_avx512
+                        : (gemv_kernel_fn)gemv_rows_f32_kernel_avx512;
+    if (dtype == DTYPE_F16)
+      return transposed ? (gemv_kernel_fn)gemv_cols_f16_kernel_avx512
+                        : (gemv_kernel_fn)gemv_rows_f16_kernel_avx512;
+    return transposed ? (gemv_kernel_fn)gemv_cols_bf16_kernel_avx512
+                      : (gemv_kernel_fn)gemv_rows_bf16_kernel_avx512;
+  }
+  if (caps.has_avx2) {
+    if (dtype == DTYPE_F32)
+      return transposed ? (gemv_kernel_fn)gemv_cols_f32_kernel_avx2
+                        : (gemv_kernel_fn)gemv_rows_f32_kernel_avx2;
+    if (dtype == DTYPE_F16)
+      return transposed ? (gemv_kernel_fn)gemv_cols_f16_kernel_avx2
+                        : (gemv_kernel_fn)gemv_rows_f16_kernel_avx2;
+    return transposed ? (gemv_kernel_fn)gemv_cols_bf16_kernel_avx2
+                      : (gemv_kernel_fn)gemv_rows_bf16_kernel_avx2;
+  }
+  return NULL;
+}
+
+static void gemv_work(void *arg, int n_start, int n_end) {
+  const gemv_task_t *t = (const gemv_task_t *)arg;
+  if (t->kernel)
+    t->kernel(t->W, t->x, t->y, t->N, t->K, n_start, n_end);
+  else if (t->transposed)
+    gemv_cols_scalar(t->W, t->x, t->y, t->N, t->K, n_start, n_end, t->dtype);
+  else
+    gemv_rows_scalar(t->W, t->x, t->y, t->K, n_start, n_end, t->dtype);
+}
+
+static void gemv_run(const void *W, const float *x, float *y, int N, int K,
+                     bool transposed, dtype_t dtype) {
+  if (!W || !x || !y || N <= 0)
+    return;
+  if (K <= 0) {
+    memset(y, 0, (size_t)N * sizeof(float));
+    return;
+  }
+
+  gemv_task_t task = {W, x, y, N, K, dtype, transposed,
+                      select_kernel(dtype, transposed)};
+  size_t w_bytes = (size_t)N * K * dtype_size(dtype);
+  threadpool_t *pool =
+      w_bytes >= GEMV_MT_MIN_BYTES ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, N, GEMV_GRAIN, gemv_work, &task);
+}
+
+typedef struct {
+  gemv_task_t gemv; /* Over the stacked [2N] outputs */
+  float *y;         /* [N] gated outputs */
+  gemv_glu_fn act;
+} gemv_glu_task_t;
+
+/*
+ * Outputs [n_start, n_end) of the gated unit, a strip at a time: the gate
+ * and up halves of the strip land side by side in tmp, which is exactly
+ * the [gate | up] row act expects. Shifting W to the strip keeps the
+ * kernels writing from tmp[0].
+ */
+static void gemv_glu_work(void *arg, int n_start, int n_end) {
+  const gemv_glu_task_t *t = (const gemv_glu_task_t *)arg;
+  const gemv_task_t *g = &t->gemv;
+  size_t elem = dtype_size(g->dtype);
+  int N = g->N / 2;
+  float tmp[2 * GEMV_COL_TILE];
+
+  for (int n0 = n_start; n0 < n_end; n0 += GEMV_COL_TILE) {
+    int width = n_end - n0 < GEMV_COL_TILE ? n_end - n0 : GEMV_COL_TILE;
+    for (int half = 0; half < 2; half++) {
+      size_t n = (size_t)half * N + n0;
+      const uint8_t *W = (const uint8_t *)g->W +
+                         (g->transposed ? n : n * g->K) * elem;
+      float *out = tmp + half * width;
+      if (g->kernel)
+        g->kernel(W, g->x, out, g->N, g->K, 0, width);
+      else if (g->transposed)
+        gemv_cols_scalar(W, g->x, out, g->N, g->K, 0, width, g->dtype);
+      else
+        gemv_rows_scalar(W, g->x, out, g->K, 0, width, g->dtype);
+    }
+    t->act(t->y + n0, tmp, 1, width);
+  }
+}
+
+static void gemv_glu_run(const void *W, const float *x, float *y, int N,
+                         int K, bool transposed, dtype_t dtype,
+                         gemv_glu_fn act) {
+  if (!W || !x || !y || !act || N <= 0 || K <= 0)
+    return;
+
+  gemv_glu_task_t task = {{W, x, NULL, 2 * N, K, dtype, transposed,
+                           select_kernel(dtype, transposed)},
+                          y,
+                          act};
+  size_t w_bytes = (size_t)2 * N * K * dtype_size(dtype);
+  threadpool_t *pool =
+      w_bytes >= GEMV_MT_MIN_BYTES ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, N, GEMV_GRAIN, gemv_glu_work, &task);
+}
+
+void gemv_f32(const float *W, const float *x, float *y, int N, int K,
+              bool transposed) {
+  gemv_run(W, x, y, N, K, transposed, DTYPE_F32);
+}
+
+void gemv_f16(const uint16_t *W, const float *x, float *y, int N, int K,
+              bool transposed) {
+  gemv_run(W, x, y, N, K, transposed, DTYPE_F16);
+}
+
+void gemv_bf16(const uint16_t *W, const float *x, float *y, int N, int K,
+               bool transposed) {
+  gemv_run(W, x, y, N, K, transposed, DTYPE_BF16);
+}
+
+void gemv_glu_f32(const float *W, const float *x, float *y, int N, int K,
+                  bool transposed, gemv_glu_fn act) {
+  gemv_glu_run(W, x, y, N, K, transposed, DTYPE_F32, act);
+}
+
+void gemv_glu_f16(const uint16_t *W, const float *x, float *y, int N, int K,
+                  bool transposed, gemv_glu_fn act) {
+  gemv_glu_run(W, x, y, N, K, transposed, DTYPE_F16, act);
+}
+
+bool gemv_dtype(dtype_t dtype, const void *W, const void *x, void *y, int N,
+                int K) {
+  if (dtype == DTYPE_F32) {
+    gemv_f32((const float *)W, (const float *)x, (float *)y, N, K, false);
+    return true;
+  }
+  if (dtype != DTYPE_F16 && dtype != DTYPE_BF16)
+    return false;
+
+  float *x_f32 = (float *)malloc((size_t)K * sizeof(float));
+  float *y_f32 = (float *)malloc((size_t)N * sizeof(float));
+  if (!x_f32 || !y_f32) {
+    free(x_f32);
+    free(y_f32);
+    return false;
+  }
+
+  if (dtype == DTYPE_F16) {
+    f16_to_f32_array((const uint16_t *)x, x_f32, (size_t)K);
+    gemv_f16((const uint16_t *)W, x_f32, y_f32, N, K, false);
+    f32_to_f16_array(y_f32, (uint16_t *)y, (size_t)N);
+  } else {
+    bf16_to_f32_array((const uint16_t *)x, x_f32, (size_t)K);
+    gemv_bf16((const uint16_t *)W, x_f32, y_f32, N, K, false);
+    f32_to_bf16_array(y_f32, (uint16_t *)y, (size_t)N);
+  }
+  free(x_f32);
+  free(y_f32);
+  return true;
+}
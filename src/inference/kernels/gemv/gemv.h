@@ -0,0 +1,82 @@
+/*
+ * Matrix-Vector Products - Public API
+ *
+ * Single-token decode multiplies every weight matrix by one activation
+ * vector, so it is bound by how fast the weights stream from memory rather
+ * than by arithmetic. These kernels read each weight exactly once,
+ * accumulate in FP32 and split the outputs across the shared thread pool.
+ *
+ * W is [N, K] (one output per row), or [K, N] with transposed set, which is
+ * how the pre-transposed FP16 model weights are stored. The activation
+ * vector and the outputs are always FP32.
+ */
+
+#ifndef GEMV_H
+#define GEMV_H
+
+#include "inference/core/dtype.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * y[N] = W x[K]
+ *
+ * Parameters:
+ *   W:          [N, K] weights, or [K, N] when transposed
+ *   x:          [K] input vector
+ *   y:          [N] output vector
+ *   transposed: W is stored [K, N]
+ */
+void gemv_f32(const float *W, const float *x, float *y, int N, int K,
+              bool transposed);
+void gemv_f16(const uint16_t *W, const float *x, float *y, int N, int K,
+              bool transposed);
+void gemv_bf16(const uint16_t *W, const float *x, float *y, int N, int K,
+               bool transposed);
+
+/*
+ * Gated activation of one row laid out [gate(d) | up(d)], as the
+ * *_and_mul_f32() activation kernels take it
+ */
+typedef void (*gemv_glu_fn)(float *out, const float *input, int num_tokens,
+                            int d);
+
+/*
+ * y[N] = act(W_gate x) * (W_up x) for a gated unit whose gate and up
+ * matrices are stacked along the outputs of W
+ *
+ * Parameters:
+ *   W:          [2N, K] weights (gate rows, then up rows), or [K, 2N] when
+ *               transposed
+ *   x:          [K] input vector
+ *   y:          [N] output vector
+ *   act:        gated activation, e.g. silu_and_mul_f32
+ *
+ * Each thread applies act to the gate and up outputs it has just produced,
+ * so the [2N] intermediate never goes back to memory.
+ */
+void gemv_glu_f32(const float *W, const float *x, float *y, int N, int K,
+                  bool transposed, gemv_glu_fn act);
+void gemv_glu_f16(const uint16_t *W, const float *x, float *y, int N, int K,
+                  bool transposed, gemv_glu_fn act);
+
+/*
+ * y[N] = W x[K] with W [N, K] and x, y in the weight dtype (F32, F16 or
+ * BF16), for callers that keep activations in that dtype. Accumulation is
+ * still FP32.
+ *
+ * Returns: false for other dtypes or if the FP32 staging buffers cannot be
+ * allocated
+ */
+bool gemv_dtype(dtype_t dtype, const void *W, const void *x, void *y, int N,
+                int K);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
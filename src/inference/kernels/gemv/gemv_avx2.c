@@ -0,0 +1,249 @@
+/*
+ * AVX2/FMA GEMV for FP32, FP16 and BF16 weights on x86-64
+ *
+ * The rows kernel takes four dot products at once so the activation vector
+ * is loaded once per four weight rows. The cols kernel keeps a strip of
+ * GEMV_COL_TILE outputs in L1 and folds four weight rows into it per pass.
+ * Both prefetch the weights ahead of use: within a row the hardware
+ * prefetcher keeps up, but it does not follow the jump between rows.
+ */
+
+#include "inference/kernels/gemv/gemv_kernels.h"
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+/* Elements per 64-byte cache line */
+#define LINE_ELEMS(kind) ((kind) == ELEM_F32 ? 16 : 32)
+
+AVX2_INLINE const char *elem_ptr(const void *p, size_t idx, int kind) {
+  return (const char *)p + idx * (kind == ELEM_F32 ? 4 : 2);
+}
+
+AVX2_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX2_INLINE __m256 load8(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm256_loadu_ps((const float *)p + idx);
+  __m128i h = _mm_loadu_si128((const __m128i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm256_cvtph_ps(h);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+AVX2_INLINE float hsum(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+  return _mm_cvtss_f32(lo);
+}
+
+/* ============================================================================
+ * W [N, K]: dot products
+ * ============================================================================
+ */
+
+AVX2_INLINE void gemv_rows(const void *W, const float *x, float *y, int K,
+                           int n_start, int n_end, int kind) {
+  int n = n_start;
+  for (; n + 4 <= n_end; n += 4) {
+    size_t r0 = (size_t)n * K;
+    size_t r1 = r0 + K;
+    size_t r2 = r1 + K;
+    size_t r3 = r2 + K;
+    __m256 a0 = _mm256_setzero_ps();
+    __m256 a1 = _mm256_setzero_ps();
+    __m256 a2 = _mm256_setzero_ps();
+    __m256 a3 = _mm256_setzero_ps();
+
+    int k = 0;
+    for (; k + 8 <= K; k += 8) {
+      if ((k & (LINE_ELEMS(kind) - 1)) == 0) {
+        _mm_prefetch(elem_ptr(W, r0 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+        _mm_prefetch(elem_ptr(W, r1 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+        _mm_prefetch(elem_ptr(W, r2 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+        _mm_prefetch(elem_ptr(W, r3 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+      }
+      __m256 xv = _mm256_loadu_ps(x + k);
+      a0 = _mm256_fmadd_ps(load8(W, r0 + k, kind), xv, a0);
+      a1 = _mm256_fmadd_ps(load8(W, r1 + k, kind), xv, a1);
+      a2 = _mm256_fmadd_ps(load8(W, r2 + k, kind), xv, a2);
+      a3 = _mm256_fmadd_ps(load8(W, r3 + k, kind), xv, a3);
+    }
+
+    float s0 = hsum(a0), s1 = hsum(a1), s2 = hsum(a2), s3 = hsum(a3);
+    for (; k < K; k++) {
+      s0 += load1(W, r0 + k, kind) * x[k];
+      s1 += load1(W, r1 + k, kind) * x[k];
+      s2 += load1(W, r2 + k, kind) * x[k];
+      s3 += load1(W, r3 + k, kind) * x[k];
+    }
+    y[n] = s0;
+    y[n + 1] = s1;
+    y[n + 2] = s2;
+    y[n + 3] = s3;
+  }
+
+  for (; n < n_end; n++) {
+    size_t r = (size_t)n * K;
+    __m256 a0 = _mm256_setzero_ps();
+    __m256 a1 = _mm256_setzero_ps();
+    int k = 0;
+    for (; k + 16 <= K; k += 16) {
+      _mm_prefetch(elem_ptr(W, r + k, kind) + GEMV_PREFETCH_BYTES,
+                   _MM_HINT_T0);
+      a0 = _mm256_fmadd_ps(load8(W, r + k, kind), _mm256_loadu_ps(x + k), a0);
+      a1 = _mm256_fmadd_ps(load8(W, r + k + 8, kind),
+                           _mm256_loadu_ps(x + k + 8), a1);
+    }
+    float s = hsum(_mm256_add_ps(a0, a1));
+    for (; k < K; k++)
+      s += load1(W, r + k, kind) * x[k];
+    y[n] = s;
+  }
+}
+
+/* ============================================================================
+ * W [K, N]: strips of outputs
+ * ============================================================================
+ */
+
+AVX2_INLINE void gemv_cols(const void *W, const float *x, float *y, int N,
+                           int K, int n_start, int n_end, int kind) {
+  float acc[GEMV_COL_TILE] __attribute__((aligned(32)));
+  const size_t stride = (size_t)N;
+
+  for (int n0 = n_start; n0 < n_end; n0 += GEMV_COL_TILE) {
+    int width = n_end - n0 < GEMV_COL_TILE ? n_end - n0 : GEMV_COL_TILE;
+    memset(acc, 0, (size_t)width * sizeof(float));
+
+    int k = 0;
+    for (; k + 4 <= K; k += 4) {
+      size_t r0 = (size_t)k * stride + n0;
+      size_t r1 = r0 + stride;
+      size_t r2 = r1 + stride;
+      size_t r3 = r2 + stride;
+      size_t next = r3 + stride;
+      __m256 x0 = _mm256_set1_ps(x[k]);
+      __m256 x1 = _mm256_set1_ps(x[k + 1]);
+      __m256 x2 = _mm256_set1_ps(x[k + 2]);
+      __m256 x3 = _mm256_set1_ps(x[k + 3]);
+
+      int j = 0;
+      for (; j + 8 <= width; j += 8) {
+        if ((j & (LINE_ELEMS(kind) - 1)) == 0) {
+          _mm_prefetch(elem_ptr(W, next + j, kind), _MM_HINT_T0);
+          _mm_prefetch(elem_ptr(W, next + stride + j, kind), _MM_HINT_T0);
+          _mm_prefetch(elem_ptr(W, next + 2 * stride + j, kind),
+                       _MM_HINT_T0);
+          _mm_prefetch(elem_ptr(W, next + 3 * stride + j, kind),
+                       _MM_HINT_T0);
+        }
+        __m256 a = _mm256_load_ps(acc + j);
+        a = _mm256_fmadd_ps(load8(W, r0 + j, kind), x0, a);
+        a = _mm256_fmadd_ps(load8(W, r1 + j, kind), x1, a);
+        a = _mm256_fmadd_ps(load8(W, r2 + j, kind), x2, a);
+        a = _mm256_fmadd_ps(load8(W, r3 + j, kind), x3, a);
+        _mm256_store_ps(acc + j, a);
+      }
+      for (; j < width; j++) {
+        acc[j] += load1(W, r0 + j, kind) * x[k] +
+                  load1(W, r1 + j, kind) * x[k + 1] +
+                  load1(W, r2 + j, kind) * x[k + 2] +
+                  load1(W, r3 + j, kind) * x[k + 3];
+      }
+    }
+
+    for (; k < K; k++) {
+      size_t r = (size_t)k * stride + n0;
+      __m256 xv = _mm256_set1_ps(x[k]);
+      int j = 0;
+      for (; j + 8 <= width; j += 8) {
+        __m256 a = _mm256_load_ps(acc + j);
+        _mm256_store_ps(acc + j,
+                        _mm256_fmadd_ps(load8(W, r + j, kind), xv, a));
+      }
+      for (; j < width; j++)
+        acc[j] += load1(W, r + j, kind) * x[k];
+    }
+
+    memcpy(y + n0, acc, (size_t)width * sizeof(float));
+  }
+}
+
+void gemv_rows_f32_kernel_avx2(const float *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_F32);
+}
+
+void gemv_rows_f16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_F16);
+}
+
+void gemv_rows_bf16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                                int N, int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_BF16);
+}
+
+void gemv_cols_f32_kernel_avx2(const float *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_F32);
+}
+
+void gemv_cols_f16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_F16);
+}
+
+void gemv_cols_bf16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                                int N, int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_BF16);
+}
+
+#else
+
+#define GEMV_AVX2_STUB(name, T)                                               \
+  void name(const T *W, const float *x, float *y, int N, int K, int n_start,  \
+            int n_end) {                                                       \
+    (void)W;                                                                   \
+    (void)x;                                                                   \
+    (void)y;                                                                   \
+    (void)N;                                                                   \
+    (void)K;                                                                   \
+    (void)n_start;                                                             \
+    (void)n_end;                                                               \
+  }
+
+GEMV_AVX2_STUB(gemv_rows_f32_kernel_avx2, float)
+GEMV_AVX2_STUB(gemv_rows_f16_kernel_avx2, uint16_t)
+GEMV_AVX2_STUB(gemv_rows_bf16_kernel_avx2, uint16_t)
+GEMV_AVX2_STUB(gemv_cols_f32_kernel_avx2, float)
+GEMV_AVX2_STUB(gemv_cols_f16_kernel_avx2, uint16_t)
+GEMV_AVX2_STUB(gemv_cols_bf16_kernel_avx2, uint16_t)
+
+#endif
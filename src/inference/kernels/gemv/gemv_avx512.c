@@ -0,0 +1,369 @@
+/*
+ * AVX-512 GEMV for FP32, FP16 and BF16 weights on x86-64
+ *
+ * Same structure as the AVX2 kernels with 16-lane zmm vectors, and masked
+ * loads instead of scalar tails. When the host has AVX512_BF16 the BF16
+ * rows kernel takes its dot products with vdpbf16ps: the FP32 activations
+ * are split into a BF16 high part and a BF16 residual, so two dpbf16 per
+ * weight vector keep close to FP32 accuracy without widening the weights.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/kernels/gemv/gemv_kernels.h"
+#include <string.h>
+
+#if defined(__AVX512F__) && defined(__AVX512BW__) && defined(__AVX512VL__)
+
+#include <immintrin.h>
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX512_INLINE static inline __attribute__((always_inline))
+
+/* Elements per 64-byte cache line */
+#define LINE_ELEMS(kind) ((kind) == ELEM_F32 ? 16 : 32)
+
+AVX512_INLINE const char *elem_ptr(const void *p, size_t idx, int kind) {
+  return (const char *)p + idx * (kind == ELEM_F32 ? 4 : 2);
+}
+
+AVX512_INLINE __m512 widen16(__m256i h, int kind) {
+  if (kind == ELEM_F16)
+    return _mm512_cvtph_ps(h);
+  return _mm512_castsi512_ps(_mm512_slli_epi32(_mm512_cvtepu16_epi32(h), 16));
+}
+
+AVX512_INLINE __m512 load16(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm512_loadu_ps((const float *)p + idx);
+  return widen16(
+      _mm256_loadu_si256((const __m256i *)((const uint16_t *)p + idx)),
+      kind);
+}
+
+/* The first lanes of mask loaded, the others zero */
+AVX512_INLINE __m512 load16_mask(const void *p, size_t idx, __mmask16 mask,
+                                 int kind) {
+  if (kind == ELEM_F32)
+    return _mm512_maskz_loadu_ps(mask, (const float *)p + idx);
+  return widen16(_mm256_maskz_loadu_epi16(mask, (const uint16_t *)p + idx),
+                 kind);
+}
+
+AVX512_INLINE __mmask16 tail_mask(int n) {
+  return (__mmask16)((1u << n) - 1);
+}
+
+/* ============================================================================
+ * W [N, K]: dot products
+ * ============================================================================
+ */
+
+AVX512_INLINE void gemv_rows(const void *W, const float *x, float *y, int K,
+                             int n_start, int n_end, int kind) {
+  int n = n_start;
+  int rem = K & 15;
+  __mmask16 mask = tail_mask(rem);
+
+  for (; n + 4 <= n_end; n += 4) {
+    size_t r0 = (size_t)n * K;
+    size_t r1 = r0 + K;
+    size_t r2 = r1 + K;
+    size_t r3 = r2 + K;
+    __m512 a0 = _mm512_setzero_ps();
+    __m512 a1 = _mm512_setzero_ps();
+    __m512 a2 = _mm512_setzero_ps();
+    __m512 a3 = _mm512_setzero_ps();
+
+    int k = 0;
+    for (; k + 16 <= K; k += 16) {
+      if ((k & (LINE_ELEMS(kind) - 1)) == 0) {
+        _mm_prefetch(elem_ptr(W, r0 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+        _mm_prefetch(elem_ptr(W, r1 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+        _mm_prefetch(elem_ptr(W, r2 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+        _mm_prefetch(elem_ptr(W, r3 + k, kind) + GEMV_PREFETCH_BYTES,
+                     _MM_HINT_T0);
+      }
+      __m512 xv = _mm512_loadu_ps(x + k);
+      a0 = _mm512_fmadd_ps(load16(W, r0 + k, kind), xv, a0);
+      a1 = _mm512_fmadd_ps(load16(W, r1 + k, kind), xv, a1);
+      a2 = _mm512_fmadd_ps(load16(W, r2 + k, kind), xv, a2);
+      a3 = _mm512_fmadd_ps(load16(W, r3 + k, kind), xv, a3);
+    }
+    if (rem) {
+      __m512 xv = _mm512_maskz_loadu_ps(mask, x + k);
+      a0 = _mm512_fmadd_ps(load16_mask(W, r0 + k, mask, kind), xv, a0);
+      a1 = _mm512_fmadd_ps(load16_mask(W, r1 + k, mask, kind), xv, a1);
+      a2 = _mm512_fmadd_ps(load16_mask(W, r2 + k, mask, kind), xv, a2);
+      a3 = _mm512_fmadd_ps(load16_mask(W, r3 + k, mask, kind), xv, a3);
+    }
+
+    y[n] = _mm512_reduce_add_ps(a0);
+    y[n + 1] = _mm512_reduce_add_ps(a1);
+    y[n + 2] = _mm512_reduce_add_ps(a2);
+    y[n + 3] = _mm512_reduce_add_ps(a3);
+  }
+
+  for (; n < n_end; n++) {
+    size_t r = (size_t)n * K;
+    __m512 a0 = _mm512_setzero_ps();
+    __m512 a1 = _mm512_setzero_ps();
+    int k = 0;
+    for (; k + 32 <= K; k += 32) {
+      _mm_prefetch(elem_ptr(W, r + k, kind) + GEMV_PREFETCH_BYTES,
+                   _MM_HINT_T0);
+      a0 = _mm512_fmadd_ps(load16(W, r + k, kind), _mm512_loadu_ps(x + k),
+                           a0);
+      a1 = _mm512_fmadd_ps(load16(W, r + k + 16, kind),
+                           _mm512_loadu_ps(x + k + 16), a1);
+    }
+    for (; k < K; k += 16) {
+      __mmask16 m = K - k < 16 ? mask : tail_mask(16);
+      a0 = _mm512_fmadd_ps(load16_mask(W, r + k, m, kind),
+                           _mm512_maskz_loadu_ps(m, x + k), a0);
+    }
+    y[n] = _mm512_reduce_add_ps(_mm512_add_ps(a0, a1));
+  }
+}
+
+/* ============================================================================
+ * W [N, K] in BF16: vdpbf16ps dot products
+ * ============================================================================
+ */
+
+/* BF16 bits of 32 floats, lo[0, 16) then hi[0, 16) */
+__attribute__((target("avx512bf16"))) AVX512_INLINE __m512bh
+to_bf16(__m512 lo, __m512 hi) {
+  return _mm512_cvtne2ps_pbh(hi, lo);
+}
+
+/* The FP32 values of the BF16 lanes [16 * half, 16 * half + 16) */
+AVX512_INLINE __m512 bf16_half(__m512bh v, int half) {
+  __m512i bits = (__m512i)v;
+  __m256i h = half ? _mm512_extracti64x4_epi64(bits, 1)
+                   : _mm512_castsi512_si256(bits);
+  return widen16(h, ELEM_BF16);
+}
+
+/*
+ * x[k, k + 32) as BF16 high parts and residuals, with the lanes past mask
+ * zeroed; hi + lo carries 16 of the 24 mantissa bits of each value
+ */
+__attribute__((target("avx512bf16"))) AVX512_INLINE void
+split_x(const float *x, __mmask32 mask, __m512bh *hi, __m512bh *lo) {
+  __m512 x0 = _mm512_maskz_loadu_ps((__mmask16)mask, x);
+  __m512 x1 = _mm512_maskz_loadu_ps((__mmask16)(mask >> 16), x + 16);
+  *hi = to_bf16(x0, x1);
+  *lo = to_bf16(_mm512_sub_ps(x0, bf16_half(*hi, 0)),
+                _mm512_sub_ps(x1, bf16_half(*hi, 1)));
+}
+
+__attribute__((target("avx512bf16"))) AVX512_INLINE __m512
+dot32(__m512 acc, const uint16_t *w, __mmask32 mask, __m512bh hi,
+      __m512bh lo) {
+  __m512bh wv = (__m512bh)_mm512_maskz_loadu_epi16(mask, w);
+  acc = _mm512_dpbf16_ps(acc, wv, hi);
+  return _mm512_dpbf16_ps(acc, wv, lo);
+}
+
+__attribute__((target("avx512bf16"))) static void
+gemv_rows_bf16_dpbf16(const uint16_t *W, const float *x, float *y, int K,
+                      int n_start, int n_end) {
+  const __mmask32 full = ~(__mmask32)0;
+  int rem = K & 31;
+  __mmask32 mask = (__mmask32)((1ull << rem) - 1);
+  int n = n_start;
+
+  for (; n + 4 <= n_end; n += 4) {
+    const uint16_t *w0 = W + (size_t)n * K;
+    const uint16_t *w1 = w0 + K;
+    const uint16_t *w2 = w1 + K;
+    const uint16_t *w3 = w2 + K;
+    __m512 a0 = _mm512_setzero_ps();
+    __m512 a1 = _mm512_setzero_ps();
+    __m512 a2 = _mm512_setzero_ps();
+    __m512 a3 = _mm512_setzero_ps();
+    __m512bh hi, lo;
+
+    int k = 0;
+    for (; k + 32 <= K; k += 32) {
+      _mm_prefetch((const char *)(w0 + k) + GEMV_PREFETCH_BYTES, _MM_HINT_T0);
+      _mm_prefetch((const char *)(w1 + k) + GEMV_PREFETCH_BYTES, _MM_HINT_T0);
+      _mm_prefetch((const char *)(w2 + k) + GEMV_PREFETCH_BYTES, _MM_HINT_T0);
+      _mm_prefetch((const char *)(w3 + k) + GEMV_PREFETCH_BYTES, _MM_HINT_T0);
+      split_x(x + k, full, &hi, &lo);
+      a0 = dot32(a0, w0 + k, full, hi, lo);
+      a1 = dot32(a1, w1 + k, full, hi, lo);
+      a2 = dot32(a2, w2 + k, full, hi, lo);
+      a3 = dot32(a3, w3 + k, full, hi, lo);
+    }
+    if (rem) {
+      split_x(x + k, mask, &hi, &lo);
+      a0 = dot32(a0, w0 + k, mask, hi, lo);
+      a1 = dot32(a1, w1 + k, mask, hi, lo);
+      a2 = dot32(a2, w2 + k, mask, hi, lo);
+      a3 = dot32(a3, w3 + k, mask, hi, lo);
+    }
+
+    y[n] = _mm512_reduce_add_ps(a0);
+    y[n + 1] = _mm512_reduce_add_ps(a1);
+    y[n + 2] = _mm512_reduce_add_ps(a2);
+    y[n + 3] = _mm512_reduce_add_ps(a3);
+  }
+
+  for (; n < n_end; n++) {
+    const uint16_t *w = W + (size_t)n * K;
+    __m512 a = _mm512_setzero_ps();
+    __m512bh hi, lo;
+    int k = 0;
+    for (; k + 32 <= K; k += 32) {
+      _mm_prefetch((const char *)(w + k) + GEMV_PREFETCH_BYTES, _MM_HINT_T0);
+      split_x(x + k, full, &hi, &lo);
+      a = dot32(a, w + k, full, hi, lo);
+    }
+    if (rem) {
+      split_x(x + k, mask, &hi, &lo);
+      a = dot32(a, w + k, mask, hi, lo);
+    }
+    y[n] = _mm512_reduce_add_ps(a);
+  }
+}
+
+/* ============================================================================
+ * W [K, N]: strips of outputs
+ * ============================================================================
+ */
+
+AVX512_INLINE void gemv_cols(const void *W, const float *x, float *y, int N,
+                             int K, int n_start, int n_end, int kind) {
+  float acc[GEMV_COL_TILE] __attribute__((aligned(64)));
+  const size_t stride = (size_t)N;
+
+  for (int n0 = n_start; n0 < n_end; n0 += GEMV_COL_TILE) {
+    int width = n_end - n0 < GEMV_COL_TILE ? n_end - n0 : GEMV_COL_TILE;
+    int body = width & ~15;
+    __mmask16 mask = tail_mask(width & 15);
+    memset(acc, 0, (size_t)width * sizeof(float));
+
+    int k = 0;
+    for (; k + 4 <= K; k += 4) {
+      size_t r0 = (size_t)k * stride + n0;
+      size_t r1 = r0 + stride;
+      size_t r2 = r1 + stride;
+      size_t r3 = r2 + stride;
+      size_t next = r3 + stride;
+      __m512 x0 = _mm512_set1_ps(x[k]);
+      __m512 x1 = _mm512_set1_ps(x[k + 1]);
+      __m512 x2 = _mm512_set1_ps(x[k + 2]);
+      __m512 x3 = _mm512_set1_ps(x[k + 3]);
+
+      int j = 0;
+      for (; j < body; j += 16) {
+        if ((j & (LINE_ELEMS(kind) - 1)) == 0) {
+          _mm_prefetch(elem_ptr(W, next + j, kind), _MM_HINT_T0);
+          _mm_prefetch(elem_ptr(W, next + stride + j, kind), _MM_HINT_T0);
+          _mm_prefetch(elem_ptr(W, next + 2 * stride + j, kind),
+                       _MM_HINT_T0);
+          _mm_prefetch(elem_ptr(W, next + 3 * stride + j, kind),
+                       _MM_HINT_T0);
+        }
+        __m512 a = _mm512_load_ps(acc + j);
+        a = _mm512_fmadd_ps(load16(W, r0 + j, kind), x0, a);
+        a = _mm512_fmadd_ps(load16(W, r1 + j, kind), x1, a);
+        a = _mm512_fmadd_ps(load16(W, r2 + j, kind), x2, a);
+        a = _mm512_fmadd_ps(load16(W, r3 + j, kind), x3, a);
+        _mm512_store_ps(acc + j, a);
+      }
+      if (mask) {
+        __m512 a = _mm512_maskz_loadu_ps(mask, acc + j);
+        a = _mm512_fmadd_ps(load16_mask(W, r0 + j, mask, kind), x0, a);
+        a = _mm512_fmadd_ps(load16_mask(W, r1 + j, mask, kind), x1, a);
+        a = _mm512_fmadd_ps(load16_mask(W, r2 + j, mask, kind), x2, a);
+        a = _mm512_fmadd_ps(load16_mask(W, r3 + j, mask, kind), x3, a);
+        _mm512_mask_storeu_ps(acc + j, mask, a);
+      }
+    }
+
+    for (; k < K; k++) {
+      size_t r = (size_t)k * stride + n0;
+      __m512 xv = _mm512_set1_ps(x[k]);
+      int j = 0;
+      for (; j < body; j += 16) {
+        __m512 a = _mm512_load_ps(acc + j);
+        _mm512_store_ps(acc + j,
+                        _mm512_fmadd_ps(load16(W, r + j, kind), xv, a));
+      }
+      if (mask) {
+        __m512 a = _mm512_maskz_loadu_ps(mask, acc + j);
+        a = _mm512_fmadd_ps(load16_mask(W, r + j, mask, kind), xv, a);
+        _mm512_mask_storeu_ps(acc + j, mask, a);
+      }
+    }
+
+    memcpy(y + n0, acc, (size_t)width * sizeof(float));
+  }
+}
+
+void gemv_rows_f32_kernel_avx512(const float *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_F32);
+}
+
+void gemv_rows_f16_kernel_avx512(const uint16_t *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_F16);
+}
+
+void gemv_rows_bf16_kernel_avx512(const uint16_t *W, const float *x,
+                                  float *y, int N, int K, int n_start,
+                                  int n_end) {
+  (void)N;
+  if (caps_get()->has_avx512_bf16)
+    gemv_rows_bf16_dpbf16(W, x, y, K, n_start, n_end);
+  else
+    gemv_rows(W, x, y, K, n_start, n_end, ELEM_BF16);
+}
+
+void gemv_cols_f32_kernel_avx512(const float *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_F32);
+}
+
+void gemv_cols_f16_kernel_avx512(const uint16_t *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_F16);
+}
+
+void gemv_cols_bf16_kernel_avx512(const uint16_t *W, const float *x,
+                                  float *y, int N, int K, int n_start,
+                                  int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_BF16);
+}
+
+#else
+
+#define GEMV_AVX512_STUB(name, T)                                             \
+  void name(const T *W, const float *x, float *y, int N, int K, int n_start,  \
+            int n_end) {                                                       \
+    (void)W;                                                                   \
+    (void)x;                                                                   \
+    (void)y;                                                                   \
+    (void)N;                                                                   \
+    (void)K;                                                                   \
+    (void)n_start;                                                             \
+    (void)n_end;                                                               \
+  }
+
+GEMV_AVX512_STUB(gemv_rows_f32_kernel_avx512, float)
+GEMV_AVX512_STUB(gemv_rows_f16_kernel_avx512, uint16_t)
+GEMV_AVX512_STUB(gemv_rows_bf16_kernel_avx512, uint16_t)
+GEMV_AVX512_STUB(gemv_cols_f32_kernel_avx512, float)
+GEMV_AVX512_STUB(gemv_cols_f16_kernel_avx512, uint16_t)
+GEMV_AVX512_STUB(gemv_cols_bf16_kernel_avx512, uint16_t)
+
+#endif
@@ -0,0 +1,81 @@
+/*
+ * GEMV kernel interface for architecture-specific implementations
+ *
+ * Each kernel computes the outputs y[n_start, n_end). The rows kernels read
+ * W as [N, K] and take one dot product per output; the cols kernels read W
+ * as [K, N] and accumulate a strip of outputs across every row of W.
+ */
+
+#ifndef GEMV_KERNELS_H
+#define GEMV_KERNELS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  bool has_neon;
+  bool has_avx2;
+  bool has_avx512;
+} gemv_caps_t;
+
+gemv_caps_t gemv_get_capabilities(void);
+
+/* Output columns accumulated at once by the cols kernels (FP32 on stack) */
+#define GEMV_COL_TILE 1024
+
+/*
+ * Bytes ahead along a row that the rows kernels prefetch; the cols kernels
+ * prefetch the next rows of their strip instead
+ */
+#define GEMV_PREFETCH_BYTES 512
+
+void gemv_rows_f32_kernel(const float *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end);
+void gemv_rows_f16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end);
+void gemv_rows_bf16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                           int K, int n_start, int n_end);
+void gemv_cols_f32_kernel(const float *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end);
+void gemv_cols_f16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end);
+void gemv_cols_bf16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                           int K, int n_start, int n_end);
+
+void gemv_rows_f32_kernel_avx2(const float *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end);
+void gemv_rows_f16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end);
+void gemv_rows_bf16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                                int N, int K, int n_start, int n_end);
+void gemv_cols_f32_kernel_avx2(const float *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end);
+void gemv_cols_f16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                               int N, int K, int n_start, int n_end);
+void gemv_cols_bf16_kernel_avx2(const uint16_t *W, const float *x, float *y,
+                                int N, int K, int n_start, int n_end);
+
+void gemv_rows_f32_kernel_avx512(const float *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end);
+void gemv_rows_f16_kernel_avx512(const uint16_t *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end);
+void gemv_rows_bf16_kernel_avx512(const uint16_t *W, const float *x,
+                                  float *y, int N, int K, int n_start,
+                                  int n_end);
+void gemv_cols_f32_kernel_avx512(const float *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end);
+void gemv_cols_f16_kernel_avx512(const uint16_t *W, const float *x, float *y,
+                                 int N, int K, int n_start, int n_end);
+void gemv_cols_bf16_kernel_avx512(const uint16_t *W, const float *x,
+                                  float *y, int N, int K, int n_start,
+                                  int n_end);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,228 @@
+/*
+ * NEON GEMV for FP32, FP16 and BF16 weights on ARM64
+ *
+ * Same structure as the AVX2 kernels: four dot products share each load of
+ * the activation vector, and column strips stay in L1 while four weight
+ * rows are folded in per pass.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/kernels/gemv/gemv_kernels.h"
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAS_NEON 1
+#else
+#define HAS_NEON 0
+#endif
+
+gemv_caps_t gemv_get_capabilities(void) {
+  gemv_caps_t caps = {0};
+  caps.has_neon = caps_has(CAP_NEON);
+  caps.has_avx2 = caps_has(CAP_AVX2);
+  caps.has_avx512 = caps_has(CAP_AVX512);
+  return caps;
+}
+
+#if HAS_NEON
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define NEON_INLINE static inline __attribute__((always_inline))
+
+/* Elements per 64-byte cache line */
+#define LINE_ELEMS(kind) ((kind) == ELEM_F32 ? 16 : 32)
+
+NEON_INLINE const char *elem_ptr(const void *p, size_t idx, int kind) {
+  return (const char *)p + idx * (kind == ELEM_F32 ? 4 : 2);
+}
+
+NEON_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  uint16_t h = ((const uint16_t *)p)[idx];
+  if (kind == ELEM_F16) {
+    float16_t f;
+    memcpy(&f, &h, sizeof(f));
+    return (float)f;
+  }
+  uint32_t bits = (uint32_t)h << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+NEON_INLINE float32x4_t load4(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return vld1q_f32((const float *)p + idx);
+  if (kind == ELEM_F16)
+    return vcvt_f32_f16(vld1_f16((const float16_t *)p + idx));
+  return vreinterpretq_f32_u32(
+      vshll_n_u16(vld1_u16((const uint16_t *)p + idx), 16));
+}
+
+NEON_INLINE void gemv_rows(const void *W, const float *x, float *y, int K,
+                           int n_start, int n_end, int kind) {
+  int n = n_start;
+  for (; n + 4 <= n_end; n += 4) {
+    size_t r0 = (size_t)n * K;
+    size_t r1 = r0 + K;
+    size_t r2 = r1 + K;
+    size_t r3 = r2 + K;
+    float32x4_t a0 = vdupq_n_f32(0.0f);
+    float32x4_t a1 = vdupq_n_f32(0.0f);
+    float32x4_t a2 = vdupq_n_f32(0.0f);
+    float32x4_t a3 = vdupq_n_f32(0.0f);
+
+    int k = 0;
+    for (; k + 4 <= K; k += 4) {
+      if ((k & (LINE_ELEMS(kind) - 1)) == 0) {
+        __builtin_prefetch(elem_ptr(W, r0 + k, kind) + GEMV_PREFETCH_BYTES);
+        __builtin_prefetch(elem_ptr(W, r1 + k, kind) + GEMV_PREFETCH_BYTES);
+        __builtin_prefetch(elem_ptr(W, r2 + k, kind) + GEMV_PREFETCH_BYTES);
+        __builtin_prefetch(elem_ptr(W, r3 + k, kind) + GEMV_PREFETCH_BYTES);
+      }
+      float32x4_t xv = vld1q_f32(x + k);
+      a0 = vfmaq_f32(a0, load4(W, r0 + k, kind), xv);
+      a1 = vfmaq_f32(a1, load4(W, r1 + k, kind), xv);
+      a2 = vfmaq_f32(a2, load4(W, r2 + k, kind), xv);
+      a3 = vfmaq_f32(a3, load4(W, r3 + k, kind), xv);
+    }
+
+    float s0 = vaddvq_f32(a0), s1 = vaddvq_f32(a1);
+    float s2 = vaddvq_f32(a2), s3 = vaddvq_f32(a3);
+    for (; k < K; k++) {
+      s0 += load1(W, r0 + k, kind) * x[k];
+      s1 += load1(W, r1 + k, kind) * x[k];
+      s2 += load1(W, r2 + k, kind) * x[k];
+      s3 += load1(W, r3 + k, kind) * x[k];
+    }
+    y[n] = s0;
+    y[n + 1] = s1;
+    y[n + 2] = s2;
+    y[n + 3] = s3;
+  }
+
+  for (; n < n_end; n++) {
+    size_t r = (size_t)n * K;
+    float32x4_t a = vdupq_n_f32(0.0f);
+    int k = 0;
+    for (; k + 4 <= K; k += 4)
+      a = vfmaq_f32(a, load4(W, r + k, kind), vld1q_f32(x + k));
+    float s = vaddvq_f32(a);
+    for (; k < K; k++)
+      s += load1(W, r + k, kind) * x[k];
+    y[n] = s;
+  }
+}
+
+NEON_INLINE void gemv_cols(const void *W, const float *x, float *y, int N,
+                           int K, int n_start, int n_end, int kind) {
+  float acc[GEMV_COL_TILE] __attribute__((aligned(16)));
+  const size_t stride = (size_t)N;
+
+  for (int n0 = n_start; n0 < n_end; n0 += GEMV_COL_TILE) {
+    int width = n_end - n0 < GEMV_COL_TILE ? n_end - n0 : GEMV_COL_TILE;
+    memset(acc, 0, (size_t)width * sizeof(float));
+
+    int k = 0;
+    for (; k + 4 <= K; k += 4) {
+      size_t r0 = (size_t)k * stride + n0;
+      size_t r1 = r0 + stride;
+      size_t r2 = r1 + stride;
+      size_t r3 = r2 + stride;
+      size_t next = r3 + stride;
+
+      int j = 0;
+      for (; j + 4 <= width; j += 4) {
+        if ((j & (LINE_ELEMS(kind) - 1)) == 0) {
+          __builtin_prefetch(elem_ptr(W, next + j, kind));
+          __builtin_prefetch(elem_ptr(W, next + stride + j, kind));
+          __builtin_prefetch(elem_ptr(W, next + 2 * stride + j, kind));
+          __builtin_prefetch(elem_ptr(W, next + 3 * stride + j, kind));
+        }
+        float32x4_t a = vld1q_f32(acc + j);
+        a = vfmaq_n_f32(a, load4(W, r0 + j, kind), x[k]);
+        a = vfmaq_n_f32(a, load4(W, r1 + j, kind), x[k + 1]);
+        a = vfmaq_n_f32(a, load4(W, r2 + j, kind), x[k + 2]);
+        a = vfmaq_n_f32(a, load4(W, r3 + j, kind), x[k + 3]);
+        vst1q_f32(acc + j, a);
+      }
+      for (; j < width; j++) {
+        acc[j] += load1(W, r0 + j, kind) * x[k] +
+                  load1(W, r1 + j, kind) * x[k + 1] +
+                  load1(W, r2 + j, kind) * x[k + 2] +
+                  load1(W, r3 + j, kind) * x[k + 3];
+      }
+    }
+
+    for (; k < K; k++) {
+      size_t r = (size_t)k * stride + n0;
+      int j = 0;
+      for (; j + 4 <= width; j += 4)
+        vst1q_f32(acc + j,
+                  vfmaq_n_f32(vld1q_f32(acc + j), load4(W, r + j, kind), x[k]));
+      for (; j < width; j++)
+        acc[j] += load1(W, r + j, kind) * x[k];
+    }
+
+    memcpy(y + n0, acc, (size_t)width * sizeof(float));
+  }
+}
+
+void gemv_rows_f32_kernel(const float *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_F32);
+}
+
+void gemv_rows_f16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_F16);
+}
+
+void gemv_rows_bf16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                           int K, int n_start, int n_end) {
+  (void)N;
+  gemv_rows(W, x, y, K, n_start, n_end, ELEM_BF16);
+}
+
+void gemv_cols_f32_kernel(const float *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_F32);
+}
+
+void gemv_cols_f16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                          int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_F16);
+}
+
+void gemv_cols_bf16_kernel(const uint16_t *W, const float *x, float *y, int N,
+                           int K, int n_start, int n_end) {
+  gemv_cols(W, x, y, N, K, n_start, n_end, ELEM_BF16);
+}
+
+#else
+
+#define GEMV_NEON_STUB(name, T)                                               \
+  void name(const T *W, const float *x, float *y, int N, int K, int n_start,  \
+            int n_end) {                                                       \
+    (void)W;                                                                   \
+    (void)x;                                                                   \
+    (void)y;                                                                   \
+    (void)N;                                                                   \
+    (void)K;                                                                   \
+    (void)n_start;                                                             \
+    (void)n_end;                                                               \
+  }
+
+GEMV_NEON_STUB(gemv_rows_f32_kernel, float)
+GEMV_NEON_STUB(gemv_rows_f16_kernel, uint16_t)
+GEMV_NEON_STUB(gemv_rows_bf16_kernel, uint16_t)
+GEMV_NEON_STUB(gemv_cols_f32_kernel, float)
+GEMV_NEON_STUB(gemv_cols_f16_kernel, uint16_t)
+GEMV_NEON_STUB(gemv_cols_bf16_kernel, uint16_t)
+
+#endif
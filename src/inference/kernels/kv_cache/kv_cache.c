@@ -3,7 +3,9 @@
  */
 
 #include "inference/kernels/kv_cache/kv_cache.h"
+#include "inference/core/dtype.h"
 #include "inference/kernels/kv_cache/kv_cache_kernels.h"
+#include <math.h>
 #include <string.h>
 
 static void kv_cache_append_f32_scalar(float *key_cache, float *value_cache,
@@ -101,3 +103,95 @@ void kv_cache_append_f16(uint16_t *key_cache, uint16_t *value_cache,
                                num_tokens, num_heads, head_dim);
   }
 }
+
+/* ============================================================================
+ * INT8 Cache
+ *
+ * Quantization runs once per new position, so the scalar loops are not on
+ * the hot path; the cost that matters is the attention reading the cache.
+ * ============================================================================
+ */
+
+static void quantize_head_f32(int8_t *dst, float *scale, const float *src,
+                              int head_dim) {
+  float amax = 0.0f;
+  for (int d = 0; d < head_dim; d++) {
+    float v = fabsf(src[d]);
+    if (v > amax)
+      amax = v;
+  }
+
+  float s = amax / 127.0f;
+  float inv = s != 0.0f ? 1.0f / s : 0.0f;
+  *scale = s;
+  for (int d = 0; d < head_dim; d++)
+    dst[d] = (int8_t)lrintf(src[d] * inv);
+}
+
+static void quantize_head_f16(int8_t *dst, float *scale, const uint16_t *src,
+                              int head_dim) {
+  float amax = 0.0f;
+  for (int d = 0; d < head_dim; d++) {
+    float v = fabsf(f16_to_f32(src[d]));
+    if (v > amax)
+      amax = v;
+  }
+
+  float s = amax / 127.0f;
+  float inv = s != 0.0f ? 1.0f / s : 0.0f;
+  *scale = s;
+  for (int d = 0; d < head_dim; d++)
+    dst[d] = (int8_t)lrintf(f16_to_f32(src[d]) * inv);
+}
+
+void kv_cache_append_q8_f32(int8_t *key_cache, float *key_scales,
+                            int8_t *value_cache, float *value_scales,
+                            const float *key, const float *value,
+                            int cache_len, int num_tokens, int num_heads,
+                            int head_dim) {
+  for (int t = 0; t < num_tokens; t++) {
+    for (int h = 0; h < num_heads; h++) {
+      size_t row = (size_t)(cache_len + t) * num_heads + h;
+      size_t in = (size_t)t * num_heads + h;
+      quantize_head_f32(key_cache + row * head_dim, key_scales + row,
+                        key + in * head_dim, head_dim);
+      quantize_head_f32(value_cache + row * head_dim, value_scales + row,
+                        value + in * head_dim, head_dim);
+    }
+  }
+}
+
+void kv_cache_append_q8_f16(int8_t *key_cache, float *key_scales,
+                            int8_t *value_cache, float *value_scales,
+                            const uint16_t *key, const uint16_t *value,
+                            int cache_len, int num_tokens, int num_heads,
+                            int head_dim) {
+  for (int t = 0; t < num_tokens; t++) {
+    for (int h = 0; h < num_heads; h++) {
+      size_t row = (size_t)(cache_len + t) * num_heads + h;
+      size_t in = (size_t)t * num_heads + h;
+      quantize_head_f16(key_cache + row * head_dim, key_scales + row,
+                        key + in * head_dim, head_dim);
+      quantize_head_f16(value_cache + row * head_dim, value_scales + row,
+                        value + in * head_dim, head_dim);
+    }
+  }
+}
+
+void kv_cache_quantize_q8_f32(int8_t *dst, float *scales, const float *src,
+                              int num_tokens, int num_heads, int head_dim) {
+  size_t rows = (size_t)num_tokens * num_heads;
+  for (size_t r = 0; r < rows; r++)
+    quantize_head_f32(dst + r * head_dim, scales + r, src + r * head_dim,
+                      head_dim);
+}
+
+void kv_cache_dequantize_q8_f32(float *dst, const int8_t *src,
+                                const float *scales, int num_tokens,
+                                int num_heads, int head_dim) {
+  size_t rows = (size_t)num_tokens * num_heads;
+  for (size_t r = 0; r < rows; r++) {
+    for (int d = 0; d < head_dim; d++)
+      dst[r * head_dim + d] = (float)src[r * head_dim + d] * scales[r];
+  }
+}
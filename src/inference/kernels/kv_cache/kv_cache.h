@@ -47,6 +47,53 @@ void kv_cache_append_f16(uint16_t *key_cache, uint16_t *value_cache,
                          int cache_len, int num_tokens, int num_heads,
                          int head_dim);
 
+/*
+ * Append key/value tensors to INT8 cache buffers (FP32 input)
+ *
+ * Each head of each new position is quantized on its own to round(x / s)
+ * with s = max|x| / 127, and s is stored alongside.
+ *
+ * Parameters:
+ *   key_cache:    [cache_len, num_heads, head_dim] - INT8 keys (modified)
+ *   key_scales:   [cache_len, num_heads] - key scales (modified)
+ *   value_cache:  [cache_len, num_heads, head_dim] - INT8 values (modified)
+ *   value_scales: [cache_len, num_heads] - value scales (modified)
+ *   key, value, cache_len, num_tokens, num_heads, head_dim: as for
+ *                 kv_cache_append_f32()
+ */
+void kv_cache_append_q8_f32(int8_t *key_cache, float *key_scales,
+                            int8_t *value_cache, float *value_scales,
+                            const float *key, const float *value,
+                            int cache_len, int num_tokens, int num_heads,
+                            int head_dim);
+
+/*
+ * Append key/value tensors to INT8 cache buffers (FP16 input)
+ */
+void kv_cache_append_q8_f16(int8_t *key_cache, float *key_scales,
+                            int8_t *value_cache, float *value_scales,
+                            const uint16_t *key, const uint16_t *value,
+                            int cache_len, int num_tokens, int num_heads,
+                            int head_dim);
+
+/*
+ * Quantize FP32 heads into INT8 cache rows, as the INT8 appends do
+ *
+ * Parameters:
+ *   dst:       [num_tokens, num_heads, head_dim] - INT8 output
+ *   scales:    [num_tokens, num_heads] - scale output
+ *   src:       [num_tokens, num_heads, head_dim] - FP32 input
+ */
+void kv_cache_quantize_q8_f32(int8_t *dst, float *scales, const float *src,
+                              int num_tokens, int num_heads, int head_dim);
+
+/*
+ * Dequantize INT8 cache rows: dst = src * scale, per head
+ */
+void kv_cache_dequantize_q8_f32(float *dst, const int8_t *src,
+                                const float *scales, int num_tokens,
+                                int num_heads, int head_dim);
+
 #ifdef __cplusplus
 }
 #endif
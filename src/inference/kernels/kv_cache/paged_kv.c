@@ -0,0 +1,434 @@
+/*
+ * Paged KV Cache - Page Pool, Block Tables and Paged Append
+ */
+
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include "inference/core/large_alloc.h"
+#include "inference/kernels/kv_cache/kv_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define KV_PAGE_ALIGN 64
+
+static size_t page_bytes(const kv_page_pool_t *pool) {
+  size_t bytes = (size_t)(2 * pool->num_layers) * pool->layer_bytes;
+  return (bytes + KV_PAGE_ALIGN - 1) & ~(size_t)(KV_PAGE_ALIGN - 1);
+}
+
+/* ============================================================================
+ * Page Pool
+ * ============================================================================
+ */
+
+kv_page_pool_t *kv_page_pool_create(int num_layers, int num_kv_heads,
+                                    int head_dim, size_t elem_size,
+                                    int page_tokens, int max_pages) {
+  if (num_layers <= 0 || num_kv_heads <= 0 || head_dim <= 0 || elem_size == 0)
+    return NULL;
+
+  kv_page_pool_t *pool = (kv_page_pool_t *)calloc(1, sizeof(kv_page_pool_t));
+  if (!pool)
+    return NULL;
+
+  pool->num_layers = num_layers;
+  pool->num_kv_heads = num_kv_heads;
+  pool->head_dim = head_dim;
+  pool->page_tokens = page_tokens > 0 ? page_tokens : KV_PAGE_TOKENS;
+  pool->elem_size = elem_size;
+  pool->layer_bytes =
+      (size_t)pool->page_tokens * num_kv_heads * head_dim * elem_size;
+  if (elem_size == KV_CACHE_INT8) {
+    /* Scales follow the values; blocks stay aligned for the float reads */
+    size_t scales = (size_t)pool->page_tokens * num_kv_heads * sizeof(float);
+    pool->scale_offset = (pool->layer_bytes + KV_PAGE_ALIGN - 1) &
+                         ~(size_t)(KV_PAGE_ALIGN - 1);
+    pool->layer_bytes = (pool->scale_offset + scales + KV_PAGE_ALIGN - 1) &
+                        ~(size_t)(KV_PAGE_ALIGN - 1);
+  }
+  pool->max_pages = max_pages > 0 ? max_pages : 0;
+  return pool;
+}
+
+void kv_page_pool_destroy(kv_page_pool_t *pool) {
+  if (!pool)
+    return;
+  for (int i = 0; i < pool->num_pages; i++)
+    large_free(pool->pages[i]);
+  free(pool->pages);
+  free(pool->refcount);
+  free(pool->free_list);
+  free(pool);
+}
+
+int kv_page_pool_page_tokens(const kv_page_pool_t *pool) {
+  return pool ? pool->page_tokens : 0;
+}
+
+int kv_page_pool_pages_in_use(const kv_page_pool_t *pool) {
+  return pool ? pool->in_use : 0;
+}
+
+size_t kv_page_pool_page_bytes(const kv_page_pool_t *pool) {
+  return pool ? page_bytes(pool) : 0;
+}
+
+size_t kv_page_pool_bytes(const kv_page_pool_t *pool) {
+  if (!pool)
+    return 0;
+  size_t resident = 0;
+  for (int i = 0; i < pool->num_pages; i++) {
+    if (pool->pages[i])
+      resident++;
+  }
+  return resident * page_bytes(pool);
+}
+
+void kv_page_pool_trim(kv_page_pool_t *pool) {
+  if (!pool)
+    return;
+  for (int i = 0; i < pool->num_free; i++) {
+    int page = pool->free_list[i];
+    large_free(pool->pages[page]);
+    pool->pages[page] = NULL;
+  }
+}
+
+static bool grow_pool(kv_page_pool_t *pool) {
+  int capacity = pool->capacity ? pool->capacity * 2 : 64;
+  if (pool->max_pages && capacity > pool->max_pages)
+    capacity = pool->max_pages;
+
+  uint8_t **pages =
+      (uint8_t **)realloc(pool->pages, (size_t)capacity * sizeof(uint8_t *));
+  if (!pages)
+    return false;
+  pool->pages = pages;
+
+  int *refcount =
+      (int *)realloc(pool->refcount, (size_t)capacity * sizeof(int));
+  if (!refcount)
+    return false;
+  pool->refcount = refcount;
+
+  int *free_list =
+      (int *)realloc(pool->free_list, (size_t)capacity * sizeof(int));
+  if (!free_list)
+    return false;
+  pool->free_list = free_list;
+
+  pool->capacity = capacity;
+  return true;
+}
+
+int kv_page_pool_alloc(kv_page_pool_t *pool) {
+  if (!pool)
+    return -1;
+
+  int page;
+  if (pool->num_free > 0) {
+    page = pool->free_list[pool->num_free - 1];
+    if (!pool->pages[page]) {
+      pool->pages[page] = (uint8_t *)large_alloc(page_bytes(pool));
+      if (!pool->pages[page])
+        return -1;
+    }
+    pool->num_free--;
+  } else {
+    if (pool->max_pages && pool->num_pages >= pool->max_pages)
+      return -1;
+    if (pool->num_pages == pool->capacity && !grow_pool(pool))
+      return -1;
+
+    uint8_t *mem = (uint8_t *)large_alloc(page_bytes(pool));
+    if (!mem)
+      return -1;
+    page = pool->num_pages++;
+    pool->pages[page] = mem;
+  }
+
+  pool->refcount[page] = 1;
+  pool->in_use++;
+  return page;
+}
+
+void kv_page_pool_ref(kv_page_pool_t *pool, int page) {
+  if (pool && page >= 0 && page < pool->num_pages)
+    pool->refcount[page]++;
+}
+
+void kv_page_pool_unref(kv_page_pool_t *pool, int page) {
+  if (!pool || page < 0 || page >= pool->num_pages ||
+      pool->refcount[page] <= 0)
+    return;
+  if (--pool->refcount[page] == 0) {
+    pool->free_list[pool->num_free++] = page;
+    pool->in_use--;
+  }
+}
+
+int kv_page_pool_refcount(const kv_page_pool_t *pool, int page) {
+  if (!pool || page < 0 || page >= pool->num_pages)
+    return 0;
+  return pool->refcount[page];
+}
+
+void *kv_page_pool_key(const kv_page_pool_t *pool, int page, int layer) {
+  return pool->pages[page] + (size_t)(2 * layer) * pool->layer_bytes;
+}
+
+void *kv_page_pool_value(const kv_page_pool_t *pool, int page, int layer) {
+  return pool->pages[page] + (size_t)(2 * layer + 1) * pool->layer_bytes;
+}
+
+float *kv_page_pool_key_scales(const kv_page_pool_t *pool, int page,
+                               int layer) {
+  return (float *)(pool->pages[page] + (size_t)(2 * layer) * pool->layer_bytes +
+                   pool->scale_offset);
+}
+
+float *kv_page_pool_value_scales(const kv_page_pool_t *pool, int page,
+                                 int layer) {
+  return (float *)(pool->pages[page] +
+                   (size_t)(2 * layer + 1) * pool->layer_bytes +
+                   pool->scale_offset);
+}
+
+/* ============================================================================
+ * Block Table
+ * ============================================================================
+ */
+
+void kv_block_table_init(kv_block_table_t *table, kv_page_pool_t *pool) {
+  if (!table)
+    return;
+  memset(table, 0, sizeof(*table));
+  table->pool = pool;
+}
+
+static bool ensure_blocks(kv_block_table_t *table, int needed) {
+  if (needed <= table->capacity)
+    return true;
+  int capacity = table->capacity ? table->capacity : 16;
+  while (capacity < needed)
+    capacity *= 2;
+  int *blocks = (int *)realloc(table->blocks, (size_t)capacity * sizeof(int));
+  if (!blocks)
+    return false;
+  table->blocks = blocks;
+  table->capacity = capacity;
+  return true;
+}
+
+/* Give the table a private copy of a page it shares with others */
+static bool unshare_page(kv_block_table_t *table, int index) {
+  kv_page_pool_t *pool = table->pool;
+  int shared = table->blocks[index];
+  int page = kv_page_pool_alloc(pool);
+  if (page < 0)
+    return false;
+  memcpy(pool->pages[page], pool->pages[shared], page_bytes(pool));
+  kv_page_pool_unref(pool, shared);
+  table->blocks[index] = page;
+  return true;
+}
+
+bool kv_block_table_reserve(kv_block_table_t *table, int num_tokens) {
+  if (!table || !table->pool)
+    return false;
+
+  /* Mapped pages past len are about to be written: copy them if shared */
+  int page_tokens = table->pool->page_tokens;
+  for (int i = table->len / page_tokens; i < table->num_blocks; i++) {
+    if (table->pool->refcount[table->blocks[i]] > 1 &&
+        !unshare_page(table, i))
+      return false;
+  }
+
+  int needed = (num_tokens + page_tokens - 1) / page_tokens;
+  if (needed <= table->num_blocks)
+    return true;
+  if (!ensure_blocks(table, needed))
+    return false;
+
+  while (table->num_blocks < needed) {
+    int page = kv_page_pool_alloc(table->pool);
+    if (page < 0)
+      return false;
+    table->blocks[table->num_blocks++] = page;
+  }
+  return true;
+}
+
+bool kv_block_table_append_page(kv_block_table_t *table, int page) {
+  if (!table || !table->pool || page < 0 || page >= table->pool->num_pages)
+    return false;
+  if (!ensure_blocks(table, table->num_blocks + 1))
+    return false;
+  kv_page_pool_ref(table->pool, page);
+  table->blocks[table->num_blocks++] = page;
+  return true;
+}
+
+void kv_block_table_truncate(kv_block_table_t *table, int len) {
+  if (!table || !table->pool)
+    return;
+  if (len < 0)
+    len = 0;
+
+  int page_tokens = table->pool->page_tokens;
+  int keep = (len + page_tokens - 1) / page_tokens;
+  while (table->num_blocks > keep)
+    kv_page_pool_unref(table->pool, table->blocks[--table->num_blocks]);
+  if (table->len > len)
+    table->len = len;
+}
+
+/* Copy every layer's K/V (and INT8 scales) of position src to dst */
+static void move_slot(kv_block_table_t *table, int dst, int src) {
+  const kv_page_pool_t *pool = table->pool;
+  size_t slot_bytes =
+      (size_t)pool->num_kv_heads * pool->head_dim * pool->elem_size;
+  size_t scale_bytes = (size_t)pool->num_kv_heads * sizeof(float);
+  for (int layer = 0; layer < pool->num_layers; layer++) {
+    memcpy(kv_block_table_key(table, layer, dst),
+           kv_block_table_key(table, layer, src), slot_bytes);
+    memcpy(kv_block_table_value(table, layer, dst),
+           kv_block_table_value(table, layer, src), slot_bytes);
+    if (pool->elem_size == KV_CACHE_INT8) {
+      memcpy(kv_block_table_key_scales(table, layer, dst),
+             kv_block_table_key_scales(table, layer, src), scale_bytes);
+      memcpy(kv_block_table_value_scales(table, layer, dst),
+             kv_block_table_value_scales(table, layer, src), scale_bytes);
+    }
+  }
+}
+
+bool kv_block_table_remove(kv_block_table_t *table, int start, int count) {
+  if (!table || !table->pool || start < 0 || count < 0 ||
+      start + count > table->len)
+    return false;
+  if (count == 0)
+    return true;
+
+  int page_tokens = table->pool->page_tokens;
+  int len = table->len - count;
+  if (start % page_tokens == 0 && count % page_tokens == 0) {
+    /* Whole pages: unmap them and slide the later entries down */
+    int first = start / page_tokens;
+    int pages = count / page_tokens;
+    for (int i = first + pages; i < table->num_blocks; i++) {
+      if (table->pool->refcount[table->blocks[i]] > 1 &&
+          !unshare_page(table, i))
+        return false;
+    }
+    for (int i = first; i < first + pages; i++)
+      kv_page_pool_unref(table->pool, table->blocks[i]);
+    memmove(table->blocks + first, table->blocks + first + pages,
+            (size_t)(table->num_blocks - first - pages) * sizeof(int));
+    table->num_blocks -= pages;
+    table->len = len;
+    return true;
+  }
+
+  /* Pages that receive the moved slots are written: copy them if shared */
+  int last = (len + page_tokens - 1) / page_tokens;
+  for (int i = start / page_tokens; i < last; i++) {
+    if (table->pool->refcount[table->blocks[i]] > 1 &&
+        !unshare_page(table, i))
+      return false;
+  }
+  for (int pos = start; pos < len; pos++)
+    move_slot(table, pos, pos + count);
+  kv_block_table_truncate(table, len);
+  return true;
+}
+
+void kv_block_table_free(kv_block_table_t *table) {
+  if (!table)
+    return;
+  kv_block_table_truncate(table, 0);
+  free(table->blocks);
+  kv_page_pool_t *pool = table->pool;
+  memset(table, 0, sizeof(*table));
+  table->pool = pool;
+}
+
+/* ============================================================================
+ * Paged Append
+ *
+ * Split the new tokens into runs that fall into one page each and hand every
+ * run to the contiguous kernel, which sees the page as a small cache. INT8
+ * pools pass the page's scale arrays along as well.
+ * ============================================================================
+ */
+
+#define PAGED_APPEND(table, layer, key, value, start, num_tokens, append)      \
+  do {                                                                         \
+    const kv_page_pool_t *pool_ = (table)->pool;                               \
+    int kv_dim_ = pool_->num_kv_heads * pool_->head_dim;                       \
+    int t_ = 0;                                                                \
+    while (t_ < (num_tokens)) {                                                \
+      int pos_ = (start) + t_;                                                 \
+      int page_ = (table)->blocks[pos_ / pool_->page_tokens];                  \
+      int slot_ = pos_ % pool_->page_tokens;                                   \
+      int run_ = pool_->page_tokens - slot_;                                   \
+      if (run_ > (num_tokens) - t_)                                            \
+        run_ = (num_tokens) - t_;                                              \
+      append(kv_page_pool_key(pool_, page_, layer),                            \
+             kv_page_pool_value(pool_, page_, layer),                          \
+             (key) + (size_t)t_ * kv_dim_, (value) + (size_t)t_ * kv_dim_,     \
+             slot_, run_, pool_->num_kv_heads, pool_->head_dim);               \
+      t_ += run_;                                                              \
+    }                                                                          \
+  } while (0)
+
+#define PAGED_APPEND_Q8(table, layer, key, value, start, num_tokens, append)   \
+  do {                                                                         \
+    const kv_page_pool_t *pool_ = (table)->pool;                               \
+    int kv_dim_ = pool_->num_kv_heads * pool_->head_dim;                       \
+    int t_ = 0;                                                                \
+    while (t_ < (num_tokens)) {                                                \
+      int pos_ = (start) + t_;                                                 \
+      int page_ = (table)->blocks[pos_ / pool_->page_tokens];                  \
+      int slot_ = pos_ % pool_->page_tokens;                                   \
+      int run_ = pool_->page_tokens - slot_;                                   \
+      if (run_ > (num_tokens) - t_)                                            \
+        run_ = (num_tokens) - t_;                                              \
+      append((int8_t *)kv_page_pool_key(pool_, page_, layer),                  \
+             kv_page_pool_key_scales(pool_, page_, layer),                     \
+             (int8_t *)kv_page_pool_value(pool_, page_, layer),                \
+             kv_page_pool_value_scales(pool_, page_, layer),                   \
+             (key) + (size_t)t_ * kv_dim_, (value) + (size_t)t_ * kv_dim_,     \
+             slot_, run_, pool_->num_kv_heads, pool_->head_dim);               \
+      t_ += run_;                                                              \
+    }                                                                          \
+  } while (0)
+
+void kv_cache_append_paged_f32(const kv_block_table_t *table, int layer,
+                               const float *key, const float *value, int start,
+                               int num_tokens) {
+  if (table->pool->elem_size == KV_CACHE_INT8)
+    PAGED_APPEND_Q8(table, layer, key, value, start, num_tokens,
+                    kv_cache_append_q8_f32);
+  else
+    PAGED_APPEND(table, layer, key, value, start, num_tokens,
+                 kv_cache_append_f32);
+}
+
+void kv_cache_append_paged_bf16(const kv_block_table_t *table, int layer,
+                                const uint16_t *key, const uint16_t *value,
+                                int start, int num_tokens) {
+  PAGED_APPEND(table, layer, key, value, start, num_tokens,
+               kv_cache_append_bf16);
+}
+
+void kv_cache_append_paged_f16(const kv_block_table_t *table, int layer,
+                               const uint16_t *key, const uint16_t *value,
+                               int start, int num_tokens) {
+  if (table->pool->elem_size == KV_CACHE_INT8)
+    PAGED_APPEND_Q8(table, layer, key, value, start, num_tokens,
+                    kv_cache_append_q8_f16);
+  else
+    PAGED_APPEND(table, layer, key, value, start, num_tokens,
+                 kv_cache_append_f16);
+}
@@ -0,0 +1,281 @@
+/*
+ * Paged KV Cache - Public API
+ *
+ * K/V storage is split into fixed-size pages of page_tokens positions that
+ * are allocated on demand from a shared pool. Each sequence owns a block
+ * table mapping its logical pages to physical ones, so memory grows with the
+ * tokens actually cached instead of max_position_embeddings, and any number
+ * of sequences can share one pool.
+ *
+ * A page holds its slots for every layer:
+ *   [layer][K | V][slot][kv_head][head_dim]
+ * so within one layer a page is laid out exactly like the old contiguous
+ * cache and the contiguous append/attention kernels work on it unchanged.
+ *
+ * Pages are reference counted so that several block tables can point at the
+ * same page (shared prompt prefixes). They come from large_alloc(), so pages
+ * of half a huge page or more are backed by huge pages.
+ *
+ * A pool created with elem_size KV_CACHE_INT8 stores each position's heads
+ * as 8-bit values with one FP32 scale per head, written after the values of
+ * the layer's K (or V) block:
+ *   [slot][kv_head][head_dim] int8, then [slot][kv_head] float
+ * The FP32 and FP16 appends quantize on write and the flash attention
+ * kernels dequantize as they read, at half the bytes of an FP16 cache.
+ */
+
+#ifndef PAGED_KV_H
+#define PAGED_KV_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Default positions per page */
+#define KV_PAGE_TOKENS 16
+
+/* elem_size of a pool holding INT8 K/V with per-position, per-head scales */
+#define KV_CACHE_INT8 1
+
+/*
+ * Page pool. Fields are read-only outside paged_kv.c; the pool is not
+ * thread-safe, so callers serialize access to a shared pool.
+ */
+typedef struct {
+  int num_layers;
+  int num_kv_heads;
+  int head_dim;
+  int page_tokens;
+  size_t elem_size;
+  size_t layer_bytes;  /* One layer's K (or V) within a page */
+  size_t scale_offset; /* INT8: scales within a K (or V) block, else 0 */
+  int max_pages;
+
+  uint8_t **pages; /* Page memory, NULL once trimmed */
+  int *refcount;   /* Per page, 0 = free */
+  int num_pages;   /* Page ids handed out so far */
+  int capacity;    /* Entries in pages/refcount/free_list */
+  int *free_list;  /* Free page ids, most recently freed last */
+  int num_free;
+  int in_use;
+} kv_page_pool_t;
+
+/*
+ * Per-sequence block table. Logical page i of the sequence lives in
+ * physical page blocks[i].
+ */
+typedef struct {
+  kv_page_pool_t *pool;
+  int *blocks;    /* Physical page ids */
+  int num_blocks; /* Pages currently mapped */
+  int capacity;   /* Allocated entries in blocks */
+  int len;        /* Positions holding valid K/V */
+} kv_block_table_t;
+
+/*
+ * Create a page pool. No page memory is allocated until it is needed.
+ *
+ * Parameters:
+ *   num_layers:   transformer layers stored per page
+ *   num_kv_heads: KV heads per layer
+ *   head_dim:     dimension per head
+ *   elem_size:    bytes per element (4 for FP32, 2 for FP16/BF16), or
+ *                 KV_CACHE_INT8 for quantized K/V
+ *   page_tokens:  positions per page (<= 0 uses KV_PAGE_TOKENS)
+ *   max_pages:    upper bound on live pages (0 = unlimited)
+ *
+ * Returns: new pool, or NULL on failure
+ */
+kv_page_pool_t *kv_page_pool_create(int num_layers, int num_kv_heads,
+                                    int head_dim, size_t elem_size,
+                                    int page_tokens, int max_pages);
+
+/*
+ * Free a pool and all of its pages. Block tables using the pool must not be
+ * used afterwards.
+ */
+void kv_page_pool_destroy(kv_page_pool_t *pool);
+
+/* Positions per page */
+int kv_page_pool_page_tokens(const kv_page_pool_t *pool);
+
+/* Pages currently referenced by at least one block table */
+int kv_page_pool_pages_in_use(const kv_page_pool_t *pool);
+
+/* Bytes of one page (all layers, K and V) */
+size_t kv_page_pool_page_bytes(const kv_page_pool_t *pool);
+
+/* Bytes held by the pool, including free pages kept for reuse */
+size_t kv_page_pool_bytes(const kv_page_pool_t *pool);
+
+/*
+ * Release the memory of free pages kept for reuse.
+ */
+void kv_page_pool_trim(kv_page_pool_t *pool);
+
+/*
+ * Take a page: a recycled one if available, otherwise a new allocation.
+ * The page starts with a reference count of 1.
+ *
+ * Returns: page id, or -1 if the pool is exhausted or allocation failed
+ */
+int kv_page_pool_alloc(kv_page_pool_t *pool);
+
+/* Add a reference to a page */
+void kv_page_pool_ref(kv_page_pool_t *pool, int page);
+
+/* Drop a reference; the page is recycled when the count reaches zero */
+void kv_page_pool_unref(kv_page_pool_t *pool, int page);
+
+/* Current reference count of a page */
+int kv_page_pool_refcount(const kv_page_pool_t *pool, int page);
+
+/*
+ * Key/value storage of one page for one layer:
+ * [page_tokens, num_kv_heads, head_dim] elements.
+ */
+void *kv_page_pool_key(const kv_page_pool_t *pool, int page, int layer);
+void *kv_page_pool_value(const kv_page_pool_t *pool, int page, int layer);
+
+/*
+ * Scales of an INT8 pool's page for one layer: [page_tokens, num_kv_heads]
+ */
+float *kv_page_pool_key_scales(const kv_page_pool_t *pool, int page,
+                               int layer);
+float *kv_page_pool_value_scales(const kv_page_pool_t *pool, int page,
+                                 int layer);
+
+/*
+ * Initialize an empty block table on a pool.
+ */
+void kv_block_table_init(kv_block_table_t *table, kv_page_pool_t *pool);
+
+/*
+ * Map enough pages to hold num_tokens positions. Pages already mapped are
+ * kept, except that a page shared with another table that covers positions
+ * from len onwards is replaced by a private copy before it gets written;
+ * len is not changed.
+ *
+ * Returns: false if the pool ran out of pages (already mapped pages stay)
+ */
+bool kv_block_table_reserve(kv_block_table_t *table, int num_tokens);
+
+/*
+ * Map an existing page as the table's next logical page, taking a reference
+ * to it. Used to share the pages of a common prefix; the caller sets len.
+ */
+bool kv_block_table_append_page(kv_block_table_t *table, int page);
+
+/*
+ * Drop positions from len onwards, releasing pages that no longer hold any
+ * of the remaining positions.
+ */
+void kv_block_table_truncate(kv_block_table_t *table, int len);
+
+/*
+ * Remove positions [start, start + count): later positions move down by
+ * count and len shrinks by count. When start and count are whole pages the
+ * pages are unmapped without copying; otherwise the later slots are copied
+ * down. Either way every page holding positions from start onwards is
+ * private to the table afterwards, so the caller may rewrite them (keys are
+ * moved as stored; re-rotating them is up to the model).
+ *
+ * Returns: false (table unchanged) for an invalid range or if the pool ran
+ * out of pages for private copies
+ */
+bool kv_block_table_remove(kv_block_table_t *table, int start, int count);
+
+/*
+ * Release every page and the table itself. The table can be reused after
+ * kv_block_table_init().
+ */
+void kv_block_table_free(kv_block_table_t *table);
+
+/*
+ * Key/value pointer for one position of one layer:
+ * [num_kv_heads, head_dim] elements. The position must be mapped.
+ */
+static inline void *kv_block_table_key(const kv_block_table_t *table,
+                                       int layer, int pos) {
+  const kv_page_pool_t *pool = table->pool;
+  int page = table->blocks[pos / pool->page_tokens];
+  size_t slot = (size_t)(pos % pool->page_tokens);
+  return pool->pages[page] + (size_t)(2 * layer) * pool->layer_bytes +
+         slot * (size_t)pool->num_kv_heads * pool->head_dim * pool->elem_size;
+}
+
+static inline void *kv_block_table_value(const kv_block_table_t *table,
+                                         int layer, int pos) {
+  const kv_page_pool_t *pool = table->pool;
+  int page = table->blocks[pos / pool->page_tokens];
+  size_t slot = (size_t)(pos % pool->page_tokens);
+  return pool->pages[page] + (size_t)(2 * layer + 1) * pool->layer_bytes +
+         slot * (size_t)pool->num_kv_heads * pool->head_dim * pool->elem_size;
+}
+
+/*
+ * Per-head scales of one position of an INT8 pool: [num_kv_heads] floats.
+ * The position must be mapped.
+ */
+static inline float *kv_block_table_key_scales(const kv_block_table_t *table,
+                                               int layer, int pos) {
+  const kv_page_pool_t *pool = table->pool;
+  int page = table->blocks[pos / pool->page_tokens];
+  size_t slot = (size_t)(pos % pool->page_tokens);
+  return (float *)(pool->pages[page] +
+                   (size_t)(2 * layer) * pool->layer_bytes +
+                   pool->scale_offset) +
+         slot * pool->num_kv_heads;
+}
+
+static inline float *
+kv_block_table_value_scales(const kv_block_table_t *table, int layer,
+                            int pos) {
+  const kv_page_pool_t *pool = table->pool;
+  int page = table->blocks[pos / pool->page_tokens];
+  size_t slot = (size_t)(pos % pool->page_tokens);
+  return (float *)(pool->pages[page] +
+                   (size_t)(2 * layer + 1) * pool->layer_bytes +
+                   pool->scale_offset) +
+         slot * pool->num_kv_heads;
+}
+
+/*
+ * Append key/value tensors to a paged cache (FP32). On an INT8 pool each
+ * position and head is quantized on write.
+ *
+ * Parameters:
+ *   table:      block table with pages mapped for [start, start + num_tokens)
+ *   layer:      layer to write
+ *   key:        [num_tokens, num_heads, head_dim] - new keys to append
+ *   value:      [num_tokens, num_heads, head_dim] - new values to append
+ *   start:      first position to write
+ *   num_tokens: number of new tokens to append
+ */
+void kv_cache_append_paged_f32(const kv_block_table_t *table, int layer,
+                               const float *key, const float *value, int start,
+                               int num_tokens);
+
+/*
+ * Append key/value tensors to a paged cache (BF16). Not for INT8 pools.
+ */
+void kv_cache_append_paged_bf16(const kv_block_table_t *table, int layer,
+                                const uint16_t *key, const uint16_t *value,
+                                int start, int num_tokens);
+
+/*
+ * Append key/value tensors to a paged cache (FP16), quantizing on INT8 pools
+ */
+void kv_cache_append_paged_f16(const kv_block_table_t *table, int layer,
+                               const uint16_t *key, const uint16_t *value,
+                               int start, int num_tokens);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PAGED_KV_H
@@ -0,0 +1,237 @@
+/*
+ * Prefix KV Cache - Radix Tree of Full Pages with LRU Eviction
+ */
+
+#include "inference/kernels/kv_cache/prefix_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct prefix_node {
+  struct prefix_node *parent;
+  struct prefix_node **children;
+  int num_children;
+  int children_capacity;
+  int page;           /* Physical page, one reference held by the cache */
+  int slot;           /* Index in cache->nodes */
+  uint64_t last_used; /* Cache tick of the last match or insert */
+  int tokens[];       /* page_tokens token ids */
+} prefix_node_t;
+
+struct kv_prefix_cache {
+  kv_page_pool_t *pool;
+  int page_tokens;
+  int max_pages;
+  uint64_t tick;
+
+  prefix_node_t *root;   /* Empty prefix, holds no page */
+  prefix_node_t **nodes; /* Every other node, for eviction scans */
+  int num_nodes;
+  int nodes_capacity;
+
+  kv_prefix_cache_stats_t stats;
+};
+
+kv_prefix_cache_t *kv_prefix_cache_create(kv_page_pool_t *pool,
+                                          int max_pages) {
+  if (!pool)
+    return NULL;
+
+  kv_prefix_cache_t *cache =
+      (kv_prefix_cache_t *)calloc(1, sizeof(kv_prefix_cache_t));
+  if (!cache)
+    return NULL;
+  cache->root = (prefix_node_t *)calloc(1, sizeof(prefix_node_t));
+  if (!cache->root) {
+    free(cache);
+    return NULL;
+  }
+  cache->root->page = -1;
+  cache->pool = pool;
+  cache->page_tokens = kv_page_pool_page_tokens(pool);
+  cache->max_pages = max_pages > 0 ? max_pages : 0;
+  return cache;
+}
+
+void kv_prefix_cache_destroy(kv_prefix_cache_t *cache) {
+  if (!cache)
+    return;
+  kv_prefix_cache_clear(cache);
+  free(cache->root->children);
+  free(cache->root);
+  free(cache->nodes);
+  free(cache);
+}
+
+static prefix_node_t *find_child(const kv_prefix_cache_t *cache,
+                                 const prefix_node_t *node,
+                                 const int *tokens) {
+  size_t bytes = (size_t)cache->page_tokens * sizeof(int);
+  for (int i = 0; i < node->num_children; i++) {
+    if (memcmp(node->children[i]->tokens, tokens, bytes) == 0)
+      return node->children[i];
+  }
+  return NULL;
+}
+
+static prefix_node_t *add_child(kv_prefix_cache_t *cache, prefix_node_t *node,
+                                const int *tokens, int page) {
+  if (node->num_children == node->children_capacity) {
+    int capacity = node->children_capacity ? node->children_capacity * 2 : 4;
+    prefix_node_t **children = (prefix_node_t **)realloc(
+        node->children, (size_t)capacity * sizeof(prefix_node_t *));
+    if (!children)
+      return NULL;
+    node->children = children;
+    node->children_capacity = capacity;
+  }
+  if (cache->num_nodes == cache->nodes_capacity) {
+    int capacity = cache->nodes_capacity ? cache->nodes_capacity * 2 : 64;
+    prefix_node_t **nodes = (prefix_node_t **)realloc(
+        cache->nodes, (size_t)capacity * sizeof(prefix_node_t *));
+    if (!nodes)
+      return NULL;
+    cache->nodes = nodes;
+    cache->nodes_capacity = capacity;
+  }
+
+  prefix_node_t *child = (prefix_node_t *)calloc(
+      1, sizeof(prefix_node_t) + (size_t)cache->page_tokens * sizeof(int));
+  if (!child)
+    return NULL;
+  memcpy(child->tokens, tokens, (size_t)cache->page_tokens * sizeof(int));
+  child->parent = node;
+  child->page = page;
+  child->slot = cache->num_nodes;
+  kv_page_pool_ref(cache->pool, page);
+
+  node->children[node->num_children++] = child;
+  cache->nodes[cache->num_nodes++] = child;
+  cache->stats.inserted++;
+  return child;
+}
+
+/* Unlink a leaf and drop its page reference */
+static void remove_leaf(kv_prefix_cache_t *cache, prefix_node_t *leaf) {
+  prefix_node_t *parent = leaf->parent;
+  for (int i = 0; i < parent->num_children; i++) {
+    if (parent->children[i] == leaf) {
+      parent->children[i] = parent->children[--parent->num_children];
+      break;
+    }
+  }
+
+  prefix_node_t *last = cache->nodes[--cache->num_nodes];
+  cache->nodes[leaf->slot] = last;
+  last->slot = leaf->slot;
+
+  kv_page_pool_unref(cache->pool, leaf->page);
+  free(leaf->children);
+  free(leaf);
+}
+
+int kv_prefix_cache_match(kv_prefix_cache_t *cache, kv_block_table_t *table,
+                          const int *tokens, int num_tokens) {
+  if (!cache || !table || table->pool != cache->pool || !tokens ||
+      num_tokens <= 0 || table->num_blocks > 0 || table->len > 0)
+    return 0;
+
+  uint64_t tick = ++cache->tick;
+  int page_tokens = cache->page_tokens;
+  prefix_node_t *node = cache->root;
+  int matched = 0;
+  while (matched + page_tokens <= num_tokens) {
+    prefix_node_t *child = find_child(cache, node, tokens + matched);
+    if (!child || !kv_block_table_append_page(table, child->page))
+      break;
+    child->last_used = tick;
+    node = child;
+    matched += page_tokens;
+  }
+  table->len = matched;
+
+  cache->stats.lookups++;
+  if (matched > 0)
+    cache->stats.hits++;
+  else
+    cache->stats.misses++;
+  cache->stats.hit_tokens += (uint64_t)matched;
+  cache->stats.miss_tokens += (uint64_t)(num_tokens - matched);
+  return matched;
+}
+
+void kv_prefix_cache_insert(kv_prefix_cache_t *cache,
+                            const kv_block_table_t *table, const int *tokens,
+                            int num_tokens) {
+  if (!cache || !table || table->pool != cache->pool || !tokens)
+    return;
+  if (num_tokens > table->len)
+    num_tokens = table->len;
+
+  uint64_t tick = ++cache->tick;
+  int page_tokens = cache->page_tokens;
+  int full_pages = num_tokens / page_tokens;
+  prefix_node_t *node = cache->root;
+  for (int i = 0; i < full_pages; i++) {
+    const int *page_ids = tokens + (size_t)i * page_tokens;
+    prefix_node_t *child = find_child(cache, node, page_ids);
+    if (!child)
+      child = add_child(cache, node, page_ids, table->blocks[i]);
+    if (!child)
+      break;
+    child->last_used = tick;
+    node = child;
+  }
+
+  if (cache->max_pages && cache->num_nodes > cache->max_pages)
+    kv_prefix_cache_evict(cache, cache->num_nodes - cache->max_pages);
+}
+
+int kv_prefix_cache_evict(kv_prefix_cache_t *cache, int num_pages) {
+  if (!cache)
+    return 0;
+
+  int evicted = 0;
+  while (evicted < num_pages && cache->num_nodes > 0) {
+    /* Oldest leaf, preferring ones whose page only the cache references */
+    prefix_node_t *unused = NULL;
+    prefix_node_t *any = NULL;
+    for (int i = 0; i < cache->num_nodes; i++) {
+      prefix_node_t *node = cache->nodes[i];
+      if (node->num_children > 0)
+        continue;
+      if (!any || node->last_used < any->last_used)
+        any = node;
+      if (kv_page_pool_refcount(cache->pool, node->page) == 1 &&
+          (!unused || node->last_used < unused->last_used))
+        unused = node;
+    }
+    remove_leaf(cache, unused ? unused : any);
+    cache->stats.evicted++;
+    evicted++;
+  }
+  return evicted;
+}
+
+void kv_prefix_cache_clear(kv_prefix_cache_t *cache) {
+  if (!cache)
+    return;
+  for (int i = 0; i < cache->num_nodes; i++) {
+    kv_page_pool_unref(cache->pool, cache->nodes[i]->page);
+    free(cache->nodes[i]->children);
+    free(cache->nodes[i]);
+  }
+  cache->num_nodes = 0;
+  cache->root->num_children = 0;
+}
+
+void kv_prefix_cache_get_stats(const kv_prefix_cache_t *cache,
+                               kv_prefix_cache_stats_t *stats) {
+  if (!stats)
+    return;
+  if (!cache) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  *stats = cache->stats;
+  stats->cached_pages = cache->num_nodes;
+}
@@ -0,0 +1,107 @@
+/*
+ * Prefix KV Cache - Public API
+ *
+ * Keeps the KV pages of previously processed token sequences so that a new
+ * request starting with the same tokens (the next turn of a chat, a swipe
+ * or regeneration, a shared system prompt) maps those pages instead of
+ * prefilling them again.
+ *
+ * The cache is a radix tree over token ids with one page per edge: a node
+ * holds the page_tokens ids of one full page and a reference to the page
+ * whose K/V were computed for exactly that prefix. Only full pages are
+ * cached, so a match covers a whole number of pages and the sequence writes
+ * its remaining tokens into pages of its own.
+ *
+ * Leaves are evicted least recently used first once the cache holds more
+ * than max_pages pages. Evicting a page only drops the cache's reference;
+ * sequences still using it keep it alive.
+ *
+ * Not thread-safe; callers serialize access together with the page pool.
+ */
+
+#ifndef PREFIX_CACHE_H
+#define PREFIX_CACHE_H
+
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct kv_prefix_cache kv_prefix_cache_t;
+
+typedef struct {
+  uint64_t lookups;     /* Calls to kv_prefix_cache_match */
+  uint64_t hits;        /* Lookups that reused at least one page */
+  uint64_t misses;      /* Lookups that reused nothing */
+  uint64_t hit_tokens;  /* Tokens mapped from the cache */
+  uint64_t miss_tokens; /* Looked-up tokens that were not cached */
+  uint64_t inserted;    /* Pages added to the cache */
+  uint64_t evicted;     /* Pages dropped by eviction */
+  int cached_pages;     /* Pages currently held */
+} kv_prefix_cache_stats_t;
+
+/*
+ * Create a prefix cache over a page pool.
+ *
+ * Parameters:
+ *   pool:      page pool of the block tables that use the cache
+ *   max_pages: pages kept before LRU eviction starts (0 = unlimited)
+ *
+ * Returns: new cache, or NULL on failure
+ */
+kv_prefix_cache_t *kv_prefix_cache_create(kv_page_pool_t *pool,
+                                          int max_pages);
+
+/* Drop every cached page and free the cache */
+void kv_prefix_cache_destroy(kv_prefix_cache_t *cache);
+
+/*
+ * Map the longest cached prefix of tokens into an empty block table and set
+ * its len to the number of tokens matched.
+ *
+ * Parameters:
+ *   table:      block table with no positions
+ *   tokens:     token ids of the sequence
+ *   num_tokens: tokens that may be matched; pass one less than the prompt
+ *               length so that the last prompt token is still run and
+ *               produces logits
+ *
+ * Returns: tokens matched (a multiple of the page size), 0 on a miss
+ */
+int kv_prefix_cache_match(kv_prefix_cache_t *cache, kv_block_table_t *table,
+                          const int *tokens, int num_tokens);
+
+/*
+ * Record the full pages of a block table as the KV of tokens. Pages already
+ * cached for the same prefix are kept and just marked as recently used.
+ *
+ * Parameters:
+ *   table:      block table holding the K/V of tokens[0, table->len)
+ *   tokens:     token ids the table was filled with
+ *   num_tokens: number of ids in tokens (clamped to table->len)
+ */
+void kv_prefix_cache_insert(kv_prefix_cache_t *cache,
+                            const kv_block_table_t *table, const int *tokens,
+                            int num_tokens);
+
+/*
+ * Evict up to num_pages least recently used pages, preferring pages that no
+ * sequence is using so that their memory is actually released.
+ *
+ * Returns: pages evicted
+ */
+int kv_prefix_cache_evict(kv_prefix_cache_t *cache, int num_pages);
+
+/* Drop every cached page */
+void kv_prefix_cache_clear(kv_prefix_cache_t *cache);
+
+void kv_prefix_cache_get_stats(const kv_prefix_cache_t *cache,
+                               kv_prefix_cache_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
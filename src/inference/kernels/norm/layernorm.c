@@ -3,14 +3,16 @@
  */
 
 #include "inference/kernels/norm/layernorm.h"
+#include "inference/backend/threadpool.h"
 #include "inference/kernels/norm/layernorm_kernels.h"
 #include <math.h>
 #include <string.h>
 
 /* ============ FP32 Implementation ============ */
 
-void rms_norm_f32(float *out, const float *input, const float *weight,
-                  float epsilon, int num_tokens, int hidden_size) {
+static void rms_norm_f32_rows(float *out, const float *input,
+                              const float *weight, float epsilon,
+                              int num_tokens, int hidden_size) {
   if (num_tokens <= 0 || hidden_size <= 0)
     return;
 
@@ -21,6 +23,12 @@ void rms_norm_f32(float *out, const float *input, const float *weight,
     return;
   }
 
+  if (caps.has_avx2) {
+    rms_norm_f32_kernel_avx2(out, input, weight, epsilon, num_tokens,
+                             hidden_size);
+    return;
+  }
+
   /* Scalar fallback */
   for (int i = 0; i < num_tokens; i++) {
     const float *in_row = input + i * hidden_size;
@@ -43,9 +51,10 @@ void rms_norm_f32(float *out, const float *input, const float *weight,
   }
 }
 
-void fused_add_rms_norm_f32(float *out, const float *input, float *residual,
-                            const float *weight, float epsilon, int num_tokens,
-                            int hidden_size) {
+static void fused_add_rms_norm_f32_rows(float *out, const float *input,
+                                        float *residual, const float *weight,
+                                        float epsilon, int num_tokens,
+                                        int hidden_size) {
   if (num_tokens <= 0 || hidden_size <= 0)
     return;
 
@@ -57,6 +66,12 @@ void fused_add_rms_norm_f32(float *out, const float *input, float *residual,
     return;
   }
 
+  if (caps.has_avx2) {
+    fused_add_rms_norm_f32_kernel_avx2(out, input, residual, weight, epsilon,
+                                       num_tokens, hidden_size);
+    return;
+  }
+
   /* Scalar fallback */
   for (int i = 0; i < num_tokens; i++) {
     const float *in_row = input + i * hidden_size;
@@ -99,8 +114,9 @@ static inline float bf16_to_float(uint16_t bf16) {
   return result;
 }
 
-void rms_norm_bf16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
-                   float epsilon, int num_tokens, int hidden_size) {
+static void rms_norm_bf16_rows(uint16_t *out, const uint16_t *input,
+                               const uint16_t *weight, float epsilon,
+                               int num_tokens, int hidden_size) {
   if (num_tokens <= 0 || hidden_size <= 0)
     return;
 
@@ -111,6 +127,12 @@ void rms_norm_bf16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
     return;
   }
 
+  if (caps.has_avx2) {
+    rms_norm_bf16_kernel_avx2(out, input, weight, epsilon, num_tokens,
+                              hidden_size);
+    return;
+  }
+
   /* Scalar fallback */
   for (int i = 0; i < num_tokens; i++) {
     const uint16_t *in_row = input + i * hidden_size;
@@ -135,9 +157,10 @@ void rms_norm_bf16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
   }
 }
 
-void fused_add_rms_norm_bf16(uint16_t *out, const uint16_t *input,
-                             uint16_t *residual, const uint16_t *weight,
-                             float epsilon, int num_tokens, int hidden_size) {
+static void fused_add_rms_norm_bf16_rows(uint16_t *out, const uint16_t *input,
+                                         uint16_t *residual,
+                                         const uint16_t *weight, float epsilon,
+                                         int num_tokens, int hidden_size) {
   if (num_tokens <= 0 || hidden_size <= 0)
     return;
 
@@ -149,6 +172,12 @@ void fused_add_rms_norm_bf16(uint16_t *out, const uint16_t *input,
     return;
   }
 
+  if (caps.has_avx2) {
+    fused_add_rms_norm_bf16_kernel_avx2(out, input, residual, weight, epsilon,
+                                        num_tokens, hidden_size);
+    return;
+  }
+
   /* Scalar fallback */
   for (int i = 0; i < num_tokens; i++) {
     const uint16_t *in_row = input + i * hidden_size;
@@ -234,8 +263,9 @@ static inline float fp16_to_float(uint16_t fp16) {
   return result;
 }
 
-void rms_norm_f16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
-                  float epsilon, int num_tokens, int hidden_size) {
+static void rms_norm_f16_rows(uint16_t *out, const uint16_t *input,
+                              const uint16_t *weight, float epsilon,
+                              int num_tokens, int hidden_size) {
   if (num_tokens <= 0 || hidden_size <= 0)
     return;
 
@@ -246,6 +276,12 @@ void rms_norm_f16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
     return;
   }
 
+  if (caps.has_avx2) {
+    rms_norm_f16_kernel_avx2(out, input, weight, epsilon, num_tokens,
+                             hidden_size);
+    return;
+  }
+
   /* Scalar fallback */
   for (int i = 0; i < num_tokens; i++) {
     const uint16_t *in_row = input + i * hidden_size;
@@ -270,9 +306,10 @@ void rms_norm_f16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
   }
 }
 
-void fused_add_rms_norm_f16(uint16_t *out, const uint16_t *input,
-                            uint16_t *residual, const uint16_t *weight,
-                            float epsilon, int num_tokens, int hidden_size) {
+static void fused_add_rms_norm_f16_rows(uint16_t *out, const uint16_t *input,
+                                        uint16_t *residual,
+                                        const uint16_t *weight, float epsilon,
+                                        int num_tokens, int hidden_size) {
   if (num_tokens <= 0 || hidden_size <= 0)
     return;
 
@@ -284,6 +321,12 @@ void fused_add_rms_norm_f16(uint16_t *out, const uint16_t *input,
     return;
   }
 
+  if (caps.has_avx2) {
+    fused_add_rms_norm_f16_kernel_avx2(out, input, residual, weight, epsilon,
+                                       num_tokens, hidden_size);
+    return;
+  }
+
   /* Scalar fallback */
   for (int i = 0; i < num_tokens; i++) {
     const uint16_t *in_row = input + i * hidden_size;
@@ -311,3 +354,126 @@ void fused_add_rms_norm_f16(uint16_t *out, const uint16_t *input,
     }
   }
 }
+
+/* ============ Public API (row-parallel) ============ */
+
+/*
+ * Rows are independent, so prefill-sized batches are split across the shared
+ * pool. Decode (one row) and per-head QK norms stay on the calling thread.
+ */
+#define NORM_MT_MIN_ELEMS (64 * 1024)
+
+typedef enum {
+  NORM_RMS_F32,
+  NORM_ADD_RMS_F32,
+  NORM_RMS_BF16,
+  NORM_ADD_RMS_BF16,
+  NORM_RMS_F16,
+  NORM_ADD_RMS_F16,
+} norm_op_t;
+
+typedef struct {
+  norm_op_t op;
+  void *out;
+  const void *input;
+  void *residual;
+  const void *weight;
+  float epsilon;
+  int hidden_size;
+} norm_task_t;
+
+static void norm_work(void *arg, int start, int end) {
+  const norm_task_t *t = (const norm_task_t *)arg;
+  size_t off = (size_t)start * t->hidden_size;
+  int n = end - start;
+
+  switch (t->op) {
+  case NORM_RMS_F32:
+    rms_norm_f32_rows((float *)t->out + off, (const float *)t->input + off,
+                      t->weight, t->epsilon, n, t->hidden_size);
+    break;
+  case NORM_ADD_RMS_F32:
+    fused_add_rms_norm_f32_rows(
+        (float *)t->out + off, (const float *)t->input + off,
+        (float *)t->residual + off, t->weight, t->epsilon, n, t->hidden_size);
+    break;
+  case NORM_RMS_BF16:
+    rms_norm_bf16_rows((uint16_t *)t->out + off,
+                       (const uint16_t *)t->input + off, t->weight,
+                       t->epsilon, n, t->hidden_size);
+    break;
+  case NORM_ADD_RMS_BF16:
+    fused_add_rms_norm_bf16_rows(
+        (uint16_t *)t->out + off, (const uint16_t *)t->input + off,
+        (uint16_t *)t->residual + off, t->weight, t->epsilon, n,
+        t->hidden_size);
+    break;
+  case NORM_RMS_F16:
+    rms_norm_f16_rows((uint16_t *)t->out + off,
+                      (const uint16_t *)t->input + off, t->weight, t->epsilon,
+                      n, t->hidden_size);
+    break;
+  case NORM_ADD_RMS_F16:
+    fused_add_rms_norm_f16_rows(
+        (uint16_t *)t->out + off, (const uint16_t *)t->input + off,
+        (uint16_t *)t->residual + off, t->weight, t->epsilon, n,
+        t->hidden_size);
+    break;
+  }
+}
+
+static void norm_run(norm_task_t *t, int num_tokens) {
+  if (num_tokens <= 0 || t->hidden_size <= 0)
+    return;
+  if (num_tokens < 2 ||
+      (long long)num_tokens * t->hidden_size < NORM_MT_MIN_ELEMS) {
+    norm_work(t, 0, num_tokens);
+    return;
+  }
+  threadpool_parallel_for(threadpool_global(), 0, num_tokens, 1, norm_work, t);
+}
+
+void rms_norm_f32(float *out, const float *input, const float *weight,
+                  float epsilon, int num_tokens, int hidden_size) {
+  norm_task_t t = {NORM_RMS_F32, out, input, NULL,
+                   weight, epsilon, hidden_size};
+  norm_run(&t, num_tokens);
+}
+
+void fused_add_rms_norm_f32(float *out, const float *input, float *residual,
+                            const float *weight, float epsilon, int num_tokens,
+                            int hidden_size) {
+  norm_task_t t = {NORM_ADD_RMS_F32, out, input, residual,
+                   weight, epsilon, hidden_size};
+  norm_run(&t, num_tokens);
+}
+
+void rms_norm_bf16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
+                   float epsilon, int num_tokens, int hidden_size) {
+  norm_task_t t = {NORM_RMS_BF16, out, input, NULL,
+                   weight, epsilon, hidden_size};
+  norm_run(&t, num_tokens);
+}
+
+void fused_add_rms_norm_bf16(uint16_t *out, const uint16_t *input,
+                             uint16_t *residual, const uint16_t *weight,
+                             float epsilon, int num_tokens, int hidden_size) {
+  norm_task_t t = {NORM_ADD_RMS_BF16, out, input, residual,
+                   weight, epsilon, hidden_size};
+  norm_run(&t, num_tokens);
+}
+
+void rms_norm_f16(uint16_t *out, const uint16_t *input, const uint16_t *weight,
+                  float epsilon, int num_tokens, int hidden_size) {
+  norm_task_t t = {NORM_RMS_F16, out, input, NULL,
+                   weight, epsilon, hidden_size};
+  norm_run(&t, num_tokens);
+}
+
+void fused_add_rms_norm_f16(uint16_t *out, const uint16_t *input,
+                            uint16_t *residual, const uint16_t *weight,
+                            float epsilon, int num_tokens, int hidden_size) {
+  norm_task_t t = {NORM_ADD_RMS_F16, out, input, residual,
+                   weight, epsilon, hidden_size};
+  norm_run(&t, num_tokens);
+}
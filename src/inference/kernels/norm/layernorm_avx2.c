@@ -0,0 +1,375 @@
+/*
+ * Layer Normalization - AVX2/FMA Optimized Kernels
+ */
+
+#include "inference/kernels/norm/layernorm_kernels.h"
+#include <math.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+/* ============ Load/Store Helpers ============ */
+
+static inline float hsum256_ps(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+  return _mm_cvtss_f32(lo);
+}
+
+static inline __m256 load_bf16x8(const uint16_t *p) {
+  __m128i h = _mm_loadu_si128((const __m128i *)p);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+static inline void store_bf16x8(uint16_t *p, __m256 v) {
+  __m256i bits = _mm256_castps_si256(v);
+  __m256i lsb =
+      _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+  bits =
+      _mm256_add_epi32(bits, _mm256_add_epi32(_mm256_set1_epi32(0x7fff), lsb));
+  bits = _mm256_srli_epi32(bits, 16);
+  __m128i h = _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                               _mm256_extracti128_si256(bits, 1));
+  _mm_storeu_si128((__m128i *)p, h);
+}
+
+static inline __m256 load_f16x8(const uint16_t *p) {
+  return _mm256_cvtph_ps(_mm_loadu_si128((const __m128i *)p));
+}
+
+static inline void store_f16x8(uint16_t *p, __m256 v) {
+  _mm_storeu_si128((__m128i *)p,
+                   _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT));
+}
+
+static inline float bf16_to_float(uint16_t bf16) {
+  uint32_t bits = ((uint32_t)bf16) << 16;
+  float result;
+  memcpy(&result, &bits, sizeof(float));
+  return result;
+}
+
+static inline uint16_t float_to_bf16(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(float));
+  bits += 0x7fff + ((bits >> 16) & 1);
+  return (uint16_t)(bits >> 16);
+}
+
+static inline float fp16_to_float(uint16_t h) { return _cvtsh_ss(h); }
+
+static inline uint16_t float_to_fp16(float f) {
+  return _cvtss_sh(f, _MM_FROUND_TO_NEAREST_INT);
+}
+
+/* ============ FP32 AVX2 Kernels ============ */
+
+static inline float sum_squares_f32(const float *x, int n) {
+  __m256 acc0 = _mm256_setzero_ps();
+  __m256 acc1 = _mm256_setzero_ps();
+  int j = 0;
+  for (; j + 16 <= n; j += 16) {
+    __m256 a = _mm256_loadu_ps(x + j);
+    __m256 b = _mm256_loadu_ps(x + j + 8);
+    acc0 = _mm256_fmadd_ps(a, a, acc0);
+    acc1 = _mm256_fmadd_ps(b, b, acc1);
+  }
+  for (; j + 8 <= n; j += 8) {
+    __m256 a = _mm256_loadu_ps(x + j);
+    acc0 = _mm256_fmadd_ps(a, a, acc0);
+  }
+  float sum = hsum256_ps(_mm256_add_ps(acc0, acc1));
+  for (; j < n; j++)
+    sum += x[j] * x[j];
+  return sum;
+}
+
+static inline void scale_mul_f32(float *out, const float *x, const float *w,
+                                 float scale, int n) {
+  __m256 s = _mm256_set1_ps(scale);
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256 v = _mm256_mul_ps(_mm256_loadu_ps(x + j), s);
+    _mm256_storeu_ps(out + j, _mm256_mul_ps(v, _mm256_loadu_ps(w + j)));
+  }
+  for (; j < n; j++)
+    out[j] = x[j] * scale * w[j];
+}
+
+void rms_norm_f32_kernel_avx2(float *out, const float *input,
+                              const float *weight, float epsilon,
+                              int num_tokens, int hidden_size) {
+  for (int i = 0; i < num_tokens; i++) {
+    const float *in_row = input + (size_t)i * hidden_size;
+    float *out_row = out + (size_t)i * hidden_size;
+
+    float variance = sum_squares_f32(in_row, hidden_size) / (float)hidden_size;
+    float scale = 1.0f / sqrtf(variance + epsilon);
+    scale_mul_f32(out_row, in_row, weight, scale, hidden_size);
+  }
+}
+
+void fused_add_rms_norm_f32_kernel_avx2(float *out, const float *input,
+                                        float *residual, const float *weight,
+                                        float epsilon, int num_tokens,
+                                        int hidden_size) {
+  for (int i = 0; i < num_tokens; i++) {
+    const float *in_row = input + (size_t)i * hidden_size;
+    float *res_row = residual + (size_t)i * hidden_size;
+    float *out_row = out + (size_t)i * hidden_size;
+
+    /* Fuse: residual += input, accumulate sum of squares */
+    __m256 acc = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 r = _mm256_add_ps(_mm256_loadu_ps(res_row + j),
+                               _mm256_loadu_ps(in_row + j));
+      _mm256_storeu_ps(res_row + j, r);
+      acc = _mm256_fmadd_ps(r, r, acc);
+    }
+    float variance = hsum256_ps(acc);
+    for (; j < hidden_size; j++) {
+      res_row[j] += in_row[j];
+      variance += res_row[j] * res_row[j];
+    }
+    variance /= (float)hidden_size;
+
+    float scale = 1.0f / sqrtf(variance + epsilon);
+    scale_mul_f32(out_row, res_row, weight, scale, hidden_size);
+  }
+}
+
+/* ============ BF16 AVX2 Kernels ============ */
+
+void rms_norm_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                               const uint16_t *weight, float epsilon,
+                               int num_tokens, int hidden_size) {
+  for (int i = 0; i < num_tokens; i++) {
+    const uint16_t *in_row = input + (size_t)i * hidden_size;
+    uint16_t *out_row = out + (size_t)i * hidden_size;
+
+    __m256 acc = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 x = load_bf16x8(in_row + j);
+      acc = _mm256_fmadd_ps(x, x, acc);
+    }
+    float variance = hsum256_ps(acc);
+    for (; j < hidden_size; j++) {
+      float x = bf16_to_float(in_row[j]);
+      variance += x * x;
+    }
+    variance /= (float)hidden_size;
+
+    float scale = 1.0f / sqrtf(variance + epsilon);
+    __m256 s = _mm256_set1_ps(scale);
+
+    j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 v = _mm256_mul_ps(load_bf16x8(in_row + j), s);
+      store_bf16x8(out_row + j, _mm256_mul_ps(v, load_bf16x8(weight + j)));
+    }
+    for (; j < hidden_size; j++) {
+      out_row[j] = float_to_bf16(bf16_to_float(in_row[j]) * scale *
+                                 bf16_to_float(weight[j]));
+    }
+  }
+}
+
+void fused_add_rms_norm_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                         uint16_t *residual,
+                                         const uint16_t *weight, float epsilon,
+                                         int num_tokens, int hidden_size) {
+  for (int i = 0; i < num_tokens; i++) {
+    const uint16_t *in_row = input + (size_t)i * hidden_size;
+    uint16_t *res_row = residual + (size_t)i * hidden_size;
+    uint16_t *out_row = out + (size_t)i * hidden_size;
+
+    /* Variance is taken over the un-rounded sum, matching the scalar path */
+    __m256 acc = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 r =
+          _mm256_add_ps(load_bf16x8(res_row + j), load_bf16x8(in_row + j));
+      store_bf16x8(res_row + j, r);
+      acc = _mm256_fmadd_ps(r, r, acc);
+    }
+    float variance = hsum256_ps(acc);
+    for (; j < hidden_size; j++) {
+      float sum = bf16_to_float(in_row[j]) + bf16_to_float(res_row[j]);
+      res_row[j] = float_to_bf16(sum);
+      variance += sum * sum;
+    }
+    variance /= (float)hidden_size;
+
+    float scale = 1.0f / sqrtf(variance + epsilon);
+    __m256 s = _mm256_set1_ps(scale);
+
+    j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 v = _mm256_mul_ps(load_bf16x8(res_row + j), s);
+      store_bf16x8(out_row + j, _mm256_mul_ps(v, load_bf16x8(weight + j)));
+    }
+    for (; j < hidden_size; j++) {
+      out_row[j] = float_to_bf16(bf16_to_float(res_row[j]) * scale *
+                                 bf16_to_float(weight[j]));
+    }
+  }
+}
+
+/* ============ FP16 AVX2 Kernels ============ */
+
+void rms_norm_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                              const uint16_t *weight, float epsilon,
+                              int num_tokens, int hidden_size) {
+  for (int i = 0; i < num_tokens; i++) {
+    const uint16_t *in_row = input + (size_t)i * hidden_size;
+    uint16_t *out_row = out + (size_t)i * hidden_size;
+
+    __m256 acc = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 x = load_f16x8(in_row + j);
+      acc = _mm256_fmadd_ps(x, x, acc);
+    }
+    float variance = hsum256_ps(acc);
+    for (; j < hidden_size; j++) {
+      float x = fp16_to_float(in_row[j]);
+      variance += x * x;
+    }
+    variance /= (float)hidden_size;
+
+    float scale = 1.0f / sqrtf(variance + epsilon);
+    __m256 s = _mm256_set1_ps(scale);
+
+    j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 v = _mm256_mul_ps(load_f16x8(in_row + j), s);
+      store_f16x8(out_row + j, _mm256_mul_ps(v, load_f16x8(weight + j)));
+    }
+    for (; j < hidden_size; j++) {
+      out_row[j] = float_to_fp16(fp16_to_float(in_row[j]) * scale *
+                                 fp16_to_float(weight[j]));
+    }
+  }
+}
+
+void fused_add_rms_norm_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                        uint16_t *residual,
+                                        const uint16_t *weight, float epsilon,
+                                        int num_tokens, int hidden_size) {
+  for (int i = 0; i < num_tokens; i++) {
+    const uint16_t *in_row = input + (size_t)i * hidden_size;
+    uint16_t *res_row = residual + (size_t)i * hidden_size;
+    uint16_t *out_row = out + (size_t)i * hidden_size;
+
+    __m256 acc = _mm256_setzero_ps();
+    int j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 r = _mm256_add_ps(load_f16x8(res_row + j), load_f16x8(in_row + j));
+      store_f16x8(res_row + j, r);
+      acc = _mm256_fmadd_ps(r, r, acc);
+    }
+    float variance = hsum256_ps(acc);
+    for (; j < hidden_size; j++) {
+      float sum = fp16_to_float(in_row[j]) + fp16_to_float(res_row[j]);
+      res_row[j] = float_to_fp16(sum);
+      variance += sum * sum;
+    }
+    variance /= (float)hidden_size;
+
+    float scale = 1.0f / sqrtf(variance + epsilon);
+    __m256 s = _mm256_set1_ps(scale);
+
+    j = 0;
+    for (; j + 8 <= hidden_size; j += 8) {
+      __m256 v = _mm256_mul_ps(load_f16x8(res_row + j), s);
+      store_f16x8(out_row + j, _mm256_mul_ps(v, load_f16x8(weight + j)));
+    }
+    for (; j < hidden_size; j++) {
+      out_row[j] = float_to_fp16(fp16_to_float(res_row[j]) * scale *
+                                 fp16_to_float(weight[j]));
+    }
+  }
+}
+
+#else
+
+void rms_norm_f32_kernel_avx2(float *out, const float *input,
+                              const float *weight, float epsilon,
+                              int num_tokens, int hidden_size) {
+  (void)out;
+  (void)input;
+  (void)weight;
+  (void)epsilon;
+  (void)num_tokens;
+  (void)hidden_size;
+}
+
+void fused_add_rms_norm_f32_kernel_avx2(float *out, const float *input,
+                                        float *residual, const float *weight,
+                                        float epsilon, int num_tokens,
+                                        int hidden_size) {
+  (void)out;
+  (void)input;
+  (void)residual;
+  (void)weight;
+  (void)epsilon;
+  (void)num_tokens;
+  (void)hidden_size;
+}
+
+void rms_norm_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                               const uint16_t *weight, float epsilon,
+                               int num_tokens, int hidden_size) {
+  (void)out;
+  (void)input;
+  (void)weight;
+  (void)epsilon;
+  (void)num_tokens;
+  (void)hidden_size;
+}
+
+void fused_add_rms_norm_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                         uint16_t *residual,
+                                         const uint16_t *weight, float epsilon,
+                                         int num_tokens, int hidden_size) {
+  (void)out;
+  (void)input;
+  (void)residual;
+  (void)weight;
+  (void)epsilon;
+  (void)num_tokens;
+  (void)hidden_size;
+}
+
+void rms_norm_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                              const uint16_t *weight, float epsilon,
+                              int num_tokens, int hidden_size) {
+  (void)out;
+  (void)input;
+  (void)weight;
+  (void)epsilon;
+  (void)num_tokens;
+  (void)hidden_size;
+}
+
+void fused_add_rms_norm_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                        uint16_t *residual,
+                                        const uint16_t *weight, float epsilon,
+                                        int num_tokens, int hidden_size) {
+  (void)out;
+  (void)input;
+  (void)residual;
+  (void)weight;
+  (void)epsilon;
+  (void)num_tokens;
+  (void)hidden_size;
+}
+
+#endif
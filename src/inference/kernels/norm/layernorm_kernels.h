@@ -45,4 +45,32 @@ void fused_add_rms_norm_f16_kernel(uint16_t *out, const uint16_t *input,
                                    float epsilon, int num_tokens,
                                    int hidden_size);
 
+/* AVX2/FMA kernels (x86-64) */
+void rms_norm_f32_kernel_avx2(float *out, const float *input,
+                              const float *weight, float epsilon,
+                              int num_tokens, int hidden_size);
+
+void fused_add_rms_norm_f32_kernel_avx2(float *out, const float *input,
+                                        float *residual, const float *weight,
+                                        float epsilon, int num_tokens,
+                                        int hidden_size);
+
+void rms_norm_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                               const uint16_t *weight, float epsilon,
+                               int num_tokens, int hidden_size);
+
+void fused_add_rms_norm_bf16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                         uint16_t *residual,
+                                         const uint16_t *weight, float epsilon,
+                                         int num_tokens, int hidden_size);
+
+void rms_norm_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                              const uint16_t *weight, float epsilon,
+                              int num_tokens, int hidden_size);
+
+void fused_add_rms_norm_f16_kernel_avx2(uint16_t *out, const uint16_t *input,
+                                        uint16_t *residual,
+                                        const uint16_t *weight, float epsilon,
+                                        int num_tokens, int hidden_size);
+
 #endif /* LAYERNORM_KERNELS_H */
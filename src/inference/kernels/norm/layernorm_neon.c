@@ -10,6 +10,8 @@
 norm_caps_t norm_get_capabilities(void) {
   norm_caps_t caps = {0};
   caps.has_neon = caps_has(CAP_NEON);
+  caps.has_avx2 = caps_has(CAP_AVX2);
+  caps.has_avx512 = caps_has(CAP_AVX512);
   return caps;
 }
 
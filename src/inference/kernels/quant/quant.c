@@ -0,0 +1,303 @@
+/*
+ * Block-Quantized Weights - Quantization, Dispatcher and Scalar Kernels
+ *
+ * The GEMM quantizes each activation row to Q8_0 once, then splits the
+ * weight rows across the shared thread pool. Each worker walks its rows in
+ * tiles of QUANT_TILE_N so that a tile stays in cache while every
+ * activation row is multiplied with it.
+ */
+
+#include "inference/kernels/quant/quant.h"
+#include "inference/backend/threadpool.h"
+#include "inference/kernels/quant/quant_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+
+_Static_assert(sizeof(block_q8_0_t) == 34, "block_q8_0_t must be packed");
+_Static_assert(sizeof(block_q4_0_t) == 18, "block_q4_0_t must be packed");
+
+/* Weight rows per cache tile */
+#define QUANT_TILE_N 16
+
+/* Below this many weight bytes the GEMM stays on the calling thread */
+#define QUANT_MT_MIN_BYTES (256 * 1024)
+
+/* ============================================================================
+ * Quantization
+ * ============================================================================
+ */
+
+void quantize_row_q8_0(const float *x, block_q8_0_t *y, int k) {
+  int nblocks = k / QUANT_BLOCK_SIZE;
+  for (int b = 0; b < nblocks; b++) {
+    const float *xb = x + b * QUANT_BLOCK_SIZE;
+    float amax = 0.0f;
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++) {
+      float v = fabsf(xb[j]);
+      if (v > amax)
+        amax = v;
+    }
+
+    float d = amax / 127.0f;
+    float id = d != 0.0f ? 1.0f / d : 0.0f;
+    y[b].d = f32_to_f16(d);
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+      y[b].qs[j] = (int8_t)lrintf(xb[j] * id);
+  }
+}
+
+void quantize_row_q4_0(const float *x, block_q4_0_t *y, int k) {
+  int nblocks = k / QUANT_BLOCK_SIZE;
+  for (int b = 0; b < nblocks; b++) {
+    const float *xb = x + b * QUANT_BLOCK_SIZE;
+
+    /* The value of largest magnitude maps to -8, using the full range */
+    float amax = 0.0f;
+    float max = 0.0f;
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++) {
+      if (fabsf(xb[j]) > amax) {
+        amax = fabsf(xb[j]);
+        max = xb[j];
+      }
+    }
+
+    float d = max / -8.0f;
+    float id = d != 0.0f ? 1.0f / d : 0.0f;
+    y[b].d = f32_to_f16(d);
+    for (int j = 0; j < QUANT_BLOCK_SIZE / 2; j++) {
+      int lo = (int)(xb[j] * id + 8.5f);
+      int hi = (int)(xb[j + QUANT_BLOCK_SIZE / 2] * id + 8.5f);
+      lo = lo < 0 ? 0 : (lo > 15 ? 15 : lo);
+      hi = hi < 0 ? 0 : (hi > 15 ? 15 : hi);
+      y[b].qs[j] = (uint8_t)(lo | (hi << 4));
+    }
+  }
+}
+
+void dequantize_row_q8_0(const block_q8_0_t *x, float *y, int k) {
+  int nblocks = k / QUANT_BLOCK_SIZE;
+  for (int b = 0; b < nblocks; b++) {
+    float d = f16_to_f32(x[b].d);
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+      y[b * QUANT_BLOCK_SIZE + j] = d * x[b].qs[j];
+  }
+}
+
+void dequantize_row_q4_0(const block_q4_0_t *x, float *y, int k) {
+  int nblocks = k / QUANT_BLOCK_SIZE;
+  for (int b = 0; b < nblocks; b++) {
+    float d = f16_to_f32(x[b].d);
+    float *yb = y + b * QUANT_BLOCK_SIZE;
+    for (int j = 0; j < QUANT_BLOCK_SIZE / 2; j++) {
+      yb[j] = d * ((x[b].qs[j] & 0x0F) - 8);
+      yb[j + QUANT_BLOCK_SIZE / 2] = d * ((x[b].qs[j] >> 4) - 8);
+    }
+  }
+}
+
+bool quantize_rows(dtype_t dtype, const float *src, void *dst, int rows,
+                   int k) {
+  if (!dtype_is_quantized(dtype) || k <= 0 || k % QUANT_BLOCK_SIZE != 0)
+    return false;
+  size_t row_bytes = dtype_nbytes(dtype, (size_t)k);
+  for (int r = 0; r < rows; r++) {
+    void *row = (uint8_t *)dst + (size_t)r * row_bytes;
+    if (dtype == DTYPE_Q8_0)
+      quantize_row_q8_0(src + (size_t)r * k, (block_q8_0_t *)row, k);
+    else
+      quantize_row_q4_0(src + (size_t)r * k, (block_q4_0_t *)row, k);
+  }
+  return true;
+}
+
+bool dequantize_rows(dtype_t dtype, const void *src, float *dst, int rows,
+                     int k) {
+  if (!dtype_is_quantized(dtype) || k <= 0 || k % QUANT_BLOCK_SIZE != 0)
+    return false;
+  size_t row_bytes = dtype_nbytes(dtype, (size_t)k);
+  for (int r = 0; r < rows; r++) {
+    const void *row = (const uint8_t *)src + (size_t)r * row_bytes;
+    if (dtype == DTYPE_Q8_0)
+      dequantize_row_q8_0((const block_q8_0_t *)row, dst + (size_t)r * k, k);
+    else
+      dequantize_row_q4_0((const block_q4_0_t *)row, dst + (size_t)r * k, k);
+  }
+  return true;
+}
+
+/* ============================================================================
+ * Scalar Dot Products
+ * ============================================================================
+ */
+
+static float dot_q8_0_scalar(const block_q8_0_t *w, const block_q8_0_t *a,
+                             int nblocks) {
+  float sum = 0.0f;
+  for (int b = 0; b < nblocks; b++) {
+    int32_t acc = 0;
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+      acc += (int32_t)w[b].qs[j] * a[b].qs[j];
+    sum += (float)acc * f16_to_f32(w[b].d) * f16_to_f32(a[b].d);
+  }
+  return sum;
+}
+
+static float dot_q4_0_scalar(const block_q4_0_t *w, const block_q8_0_t *a,
+                             int nblocks) {
+  float sum = 0.0f;
+  for (int b = 0; b < nblocks; b++) {
+    int32_t acc = 0;
+    for (int j = 0; j < QUANT_BLOCK_SIZE / 2; j++) {
+      acc += ((w[b].qs[j] & 0x0F) - 8) * a[b].qs[j];
+      acc += ((w[b].qs[j] >> 4) - 8) * a[b].qs[j + QUANT_BLOCK_SIZE / 2];
+    }
+    sum += (float)acc * f16_to_f32(w[b].d) * f16_to_f32(a[b].d);
+  }
+  return sum;
+}
+
+/* ============================================================================
+ * GEMM
+ * ============================================================================
+ */
+
+typedef float (*quant_dot_fn)(const void *w, const block_q8_0_t *a,
+                              int nblocks);
+
+static quant_dot_fn select_dot(dtype_t w_dtype) {
+  quant_caps_t caps = quant_get_capabilities();
+  if (w_dtype == DTYPE_Q8_0) {
+    if (caps.has_neon)
+      return (quant_dot_fn)quant_dot_q8_0_kernel;
+    if (caps.has_avx2)
+      return (quant_dot_fn)quant_dot_q8_0_kernel_avx2;
+    return (quant_dot_fn)dot_q8_0_scalar;
+  }
+  if (caps.has_neon)
+    return (quant_dot_fn)quant_dot_q4_0_kernel;
+  if (caps.has_avx2)
+    return (quant_dot_fn)quant_dot_q4_0_kernel_avx2;
+  return (quant_dot_fn)dot_q4_0_scalar;
+}
+
+typedef struct {
+  const block_q8_0_t *a; /* [M, nblocks] quantized activations */
+  const uint8_t *w;
+  size_t w_row_bytes;
+  float *c_f32; /* Exactly one of c_f32 / c_f16 is set */
+  uint16_t *c_f16;
+  int M;
+  int N;
+  int nblocks;
+  quant_dot_fn dot;
+} quant_gemm_task_t;
+
+static void quant_gemm_work(void *arg, int n_start, int n_end) {
+  const quant_gemm_task_t *t = (const quant_gemm_task_t *)arg;
+  for (int n0 = n_start; n0 < n_end; n0 += QUANT_TILE_N) {
+    int n1 = n0 + QUANT_TILE_N < n_end ? n0 + QUANT_TILE_N : n_end;
+    for (int m = 0; m < t->M; m++) {
+      const block_q8_0_t *a = t->a + (size_t)m * t->nblocks;
+      for (int n = n0; n < n1; n++) {
+        float v = t->dot(t->w + (size_t)n * t->w_row_bytes, a, t->nblocks);
+        if (t->c_f32)
+          t->c_f32[(size_t)m * t->N + n] = v;
+        else
+          t->c_f16[(size_t)m * t->N + n] = f32_to_f16(v);
+      }
+    }
+  }
+}
+
+static void quant_gemm_run(quant_gemm_task_t *task, dtype_t w_dtype, int K) {
+  task->nblocks = K / QUANT_BLOCK_SIZE;
+  task->w_row_bytes = dtype_nbytes(w_dtype, (size_t)K);
+  task->dot = select_dot(w_dtype);
+
+  size_t w_bytes = task->w_row_bytes * (size_t)task->N;
+  threadpool_t *pool =
+      w_bytes >= QUANT_MT_MIN_BYTES ? threadpool_global() : NULL;
+  threadpool_parallel_for(pool, 0, task->N, QUANT_TILE_N, quant_gemm_work,
+                          task);
+}
+
+size_t gemm_quant_scratch_bytes(int M, int K) {
+  if (M <= 0 || K <= 0)
+    return 0;
+  /* One FP32 row for widening FP16 activations, then the quantized rows */
+  size_t nblocks = (size_t)K / QUANT_BLOCK_SIZE;
+  return (size_t)K * sizeof(float) + (size_t)M * nblocks * sizeof(block_q8_0_t);
+}
+
+static block_q8_0_t *scratch_blocks(void *scratch, int K) {
+  return (block_q8_0_t *)((uint8_t *)scratch + (size_t)K * sizeof(float));
+}
+
+static bool gemm_quant_args_ok(dtype_t w_dtype, int M, int N, int K) {
+  return M > 0 && N > 0 && K > 0 && K % QUANT_BLOCK_SIZE == 0 &&
+         dtype_is_quantized(w_dtype);
+}
+
+void gemm_quant_f32_scratch(const float *A, const void *W, dtype_t w_dtype,
+                            float *C, int M, int N, int K, void *scratch) {
+  if (!gemm_quant_args_ok(w_dtype, M, N, K) || !scratch)
+    return;
+
+  int nblocks = K / QUANT_BLOCK_SIZE;
+  block_q8_0_t *a = scratch_blocks(scratch, K);
+  for (int m = 0; m < M; m++)
+    quantize_row_q8_0(A + (size_t)m * K, a + (size_t)m * nblocks, K);
+
+  quant_gemm_task_t task = {0};
+  task.a = a;
+  task.w = (const uint8_t *)W;
+  task.c_f32 = C;
+  task.M = M;
+  task.N = N;
+  quant_gemm_run(&task, w_dtype, K);
+}
+
+void gemm_quant_f16_scratch(const uint16_t *A, const void *W,
+                            dtype_t w_dtype, uint16_t *C, int M, int N, int K,
+                            void *scratch) {
+  if (!gemm_quant_args_ok(w_dtype, M, N, K) || !scratch)
+    return;
+
+  int nblocks = K / QUANT_BLOCK_SIZE;
+  block_q8_0_t *a = scratch_blocks(scratch, K);
+  float *row = (float *)scratch;
+  for (int m = 0; m < M; m++) {
+    f16_to_f32_array(A + (size_t)m * K, row, (size_t)K);
+    quantize_row_q8_0(row, a + (size_t)m * nblocks, K);
+  }
+
+  quant_gemm_task_t task = {0};
+  task.a = a;
+  task.w = (const uint8_t *)W;
+  task.c_f16 = C;
+  task.M = M;
+  task.N = N;
+  quant_gemm_run(&task, w_dtype, K);
+}
+
+void gemm_quant_f32(const float *A, const void *W, dtype_t w_dtype, float *C,
+                    int M, int N, int K) {
+  if (!gemm_quant_args_ok(w_dtype, M, N, K))
+    return;
+  void *scratch = malloc(gemm_quant_scratch_bytes(M, K));
+  if (!scratch)
+    return;
+  gemm_quant_f32_scratch(A, W, w_dtype, C, M, N, K, scratch);
+  free(scratch);
+}
+
+void gemm_quant_f16(const uint16_t *A, const void *W, dtype_t w_dtype,
+                    uint16_t *C, int M, int N, int K) {
+  if (!gemm_quant_args_ok(w_dtype, M, N, K))
+    return;
+  void *scratch = malloc(gemm_quant_scratch_bytes(M, K));
+  if (!scratch)
+    return;
+  gemm_quant_f16_scratch(A, W, w_dtype, C, M, N, K, scratch);
+  free(scratch);
+}
@@ -0,0 +1,100 @@
+/*
+ * Block-Quantized Weights - Public API
+ *
+ * Weight matrices are kept in their [N, K] (out, in) layout and every row is
+ * split into blocks of QUANT_BLOCK_SIZE consecutive values, each with its
+ * own FP16 scale d:
+ *
+ *   Q8_0: 32 x int8,  value = d * q        34 bytes per 32 weights
+ *   Q4_0: 32 x 4 bit, value = d * (q - 8)  18 bytes per 32 weights
+ *
+ * The blocks match the GGML formats of the same name. The GEMM quantizes
+ * the activations to Q8_0 on the fly and accumulates integer dot products
+ * per block, so weights are dequantized in registers and never expanded in
+ * memory.
+ */
+
+#ifndef QUANT_H
+#define QUANT_H
+
+#include "inference/core/dtype.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define QUANT_BLOCK_SIZE 32
+
+typedef struct {
+  uint16_t d;                  /* FP16 scale */
+  int8_t qs[QUANT_BLOCK_SIZE]; /* Quantized values */
+} block_q8_0_t;
+
+typedef struct {
+  uint16_t d; /* FP16 scale */
+  /* Value j in the low nibble of qs[j], value j + 16 in the high nibble */
+  uint8_t qs[QUANT_BLOCK_SIZE / 2];
+} block_q4_0_t;
+
+/*
+ * Quantize / dequantize one row of k values (k a multiple of
+ * QUANT_BLOCK_SIZE).
+ */
+void quantize_row_q8_0(const float *x, block_q8_0_t *y, int k);
+void quantize_row_q4_0(const float *x, block_q4_0_t *y, int k);
+void dequantize_row_q8_0(const block_q8_0_t *x, float *y, int k);
+void dequantize_row_q4_0(const block_q4_0_t *x, float *y, int k);
+
+/*
+ * Quantize a row-major [rows, k] F32 matrix into dtype (DTYPE_Q8_0 or
+ * DTYPE_Q4_0). dst holds dtype_nbytes(dtype, rows * k) bytes.
+ *
+ * Returns: false if dtype is not quantized or k is not a multiple of
+ * QUANT_BLOCK_SIZE
+ */
+bool quantize_rows(dtype_t dtype, const float *src, void *dst, int rows,
+                   int k);
+
+/* Inverse of quantize_rows() */
+bool dequantize_rows(dtype_t dtype, const void *src, float *dst, int rows,
+                     int k);
+
+/*
+ * C[M, N] = A[M, K] x W[N, K]^T with block-quantized W (FP32 activations)
+ *
+ * Parameters:
+ *   A:       [M, K] activations
+ *   W:       [N, K] weights in w_dtype, row by row
+ *   w_dtype: DTYPE_Q8_0 or DTYPE_Q4_0
+ *   C:       [M, N] output
+ *   K:       multiple of QUANT_BLOCK_SIZE
+ */
+void gemm_quant_f32(const float *A, const void *W, dtype_t w_dtype, float *C,
+                    int M, int N, int K);
+
+/* As gemm_quant_f32() with FP16 activations and output */
+void gemm_quant_f16(const uint16_t *A, const void *W, dtype_t w_dtype,
+                    uint16_t *C, int M, int N, int K);
+
+/* Scratch bytes the _scratch variants below need for M rows of K values */
+size_t gemm_quant_scratch_bytes(int M, int K);
+
+/*
+ * As gemm_quant_f32() / gemm_quant_f16(), with the quantized activations
+ * staged in caller-provided scratch of gemm_quant_scratch_bytes(M, K) bytes
+ * instead of heap allocations
+ */
+void gemm_quant_f32_scratch(const float *A, const void *W, dtype_t w_dtype,
+                            float *C, int M, int N, int K, void *scratch);
+void gemm_quant_f16_scratch(const uint16_t *A, const void *W,
+                            dtype_t w_dtype, uint16_t *C, int M, int N, int K,
+                            void *scratch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/*
+ * Block-Quantized Weights - AVX2 Dot Products
+ *
+ * A block is 32 int8 products: _mm256_maddubs_epi16 needs one unsigned
+ * operand, so the weights are made non-negative with _mm256_sign_epi8 and
+ * their signs moved onto the activations. Block sums are scaled in float
+ * and accumulated with FMA.
+ */
+
+#include "inference/kernels/quant/quant_kernels.h"
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+AVX2_INLINE float hsum256_ps(__m256 v) {
+  __m128 lo = _mm256_castps256_ps128(v);
+  __m128 hi = _mm256_extractf128_ps(v, 1);
+  lo = _mm_add_ps(lo, hi);
+  lo = _mm_add_ps(lo, _mm_movehl_ps(lo, lo));
+  lo = _mm_add_ss(lo, _mm_movehdup_ps(lo));
+  return _mm_cvtss_f32(lo);
+}
+
+AVX2_INLINE float fp16_scale(uint16_t d) {
+  return _cvtsh_ss(d);
+}
+
+/* Sum of the 32 int8 products of w and a, as 8 float lanes */
+AVX2_INLINE __m256 dot_i8x32(__m256i w, __m256i a) {
+  __m256i w_abs = _mm256_sign_epi8(w, w);
+  __m256i a_signed = _mm256_sign_epi8(a, w);
+  __m256i pairs = _mm256_maddubs_epi16(w_abs, a_signed);
+  __m256i sums = _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+  return _mm256_cvtepi32_ps(sums);
+}
+
+float quant_dot_q8_0_kernel_avx2(const block_q8_0_t *w,
+                                 const block_q8_0_t *a, int nblocks) {
+  __m256 acc = _mm256_setzero_ps();
+  for (int b = 0; b < nblocks; b++) {
+    __m256i wq = _mm256_loadu_si256((const __m256i *)w[b].qs);
+    __m256i aq = _mm256_loadu_si256((const __m256i *)a[b].qs);
+    __m256 d = _mm256_set1_ps(fp16_scale(w[b].d) * fp16_scale(a[b].d));
+    acc = _mm256_fmadd_ps(d, dot_i8x32(wq, aq), acc);
+  }
+  return hsum256_ps(acc);
+}
+
+float quant_dot_q4_0_kernel_avx2(const block_q4_0_t *w,
+                                 const block_q8_0_t *a, int nblocks) {
+  const __m256i low_mask = _mm256_set1_epi8(0x0F);
+  const __m256i offset = _mm256_set1_epi8(8);
+  __m256 acc = _mm256_setzero_ps();
+  for (int b = 0; b < nblocks; b++) {
+    /* Low nibbles are values 0..15, high nibbles 16..31 */
+    __m128i packed = _mm_loadu_si128((const __m128i *)w[b].qs);
+    __m256i nibbles = _mm256_set_m128i(_mm_srli_epi16(packed, 4), packed);
+    __m256i wq = _mm256_sub_epi8(_mm256_and_si256(nibbles, low_mask), offset);
+    __m256i aq = _mm256_loadu_si256((const __m256i *)a[b].qs);
+    __m256 d = _mm256_set1_ps(fp16_scale(w[b].d) * fp16_scale(a[b].d));
+    acc = _mm256_fmadd_ps(d, dot_i8x32(wq, aq), acc);
+  }
+  return hsum256_ps(acc);
+}
+
+#else
+
+float quant_dot_q8_0_kernel_avx2(const block_q8_0_t *w,
+                                 const block_q8_0_t *a, int nblocks) {
+  (void)w;
+  (void)a;
+  (void)nblocks;
+  return 0.0f;
+}
+
+float quant_dot_q4_0_kernel_avx2(const block_q4_0_t *w,
+                                 const block_q8_0_t *a, int nblocks) {
+  (void)w;
+  (void)a;
+  (void)nblocks;
+  return 0.0f;
+}
+
+#endif
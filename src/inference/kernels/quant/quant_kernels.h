@@ -0,0 +1,40 @@
+/*
+ * Quantized GEMM kernel interface for architecture-specific implementations
+ *
+ * Each kernel returns the dot product of one weight row (nblocks blocks of
+ * Q8_0 or Q4_0) with one activation row quantized to Q8_0.
+ */
+
+#ifndef QUANT_KERNELS_H
+#define QUANT_KERNELS_H
+
+#include "inference/kernels/quant/quant.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  bool has_neon;
+  bool has_avx2;
+} quant_caps_t;
+
+quant_caps_t quant_get_capabilities(void);
+
+float quant_dot_q8_0_kernel(const block_q8_0_t *w, const block_q8_0_t *a,
+                            int nblocks);
+float quant_dot_q4_0_kernel(const block_q4_0_t *w, const block_q8_0_t *a,
+                            int nblocks);
+
+float quant_dot_q8_0_kernel_avx2(const block_q8_0_t *w,
+                                 const block_q8_0_t *a, int nblocks);
+float quant_dot_q4_0_kernel_avx2(const block_q4_0_t *w,
+                                 const block_q8_0_t *a, int nblocks);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * Block-Quantized Weights - NEON Dot Products
+ *
+ * Uses SDOT where the target has it and widening multiplies otherwise.
+ */
+
+#include "inference/backend/caps.h"
+#include "inference/kernels/quant/quant_kernels.h"
+#include <string.h>
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define HAS_NEON 1
+#else
+#define HAS_NEON 0
+#endif
+
+quant_caps_t quant_get_capabilities(void) {
+  quant_caps_t caps = {0};
+  caps.has_neon = caps_has(CAP_NEON);
+  caps.has_avx2 = caps_has(CAP_AVX2);
+  return caps;
+}
+
+#if HAS_NEON
+
+static inline int32x4_t dot_i8x16(int32x4_t acc, int8x16_t w, int8x16_t a) {
+#if defined(__ARM_FEATURE_DOTPROD)
+  return vdotq_s32(acc, w, a);
+#else
+  int16x8_t lo = vmull_s8(vget_low_s8(w), vget_low_s8(a));
+  int16x8_t hi = vmull_s8(vget_high_s8(w), vget_high_s8(a));
+  return vpadalq_s16(vpadalq_s16(acc, lo), hi);
+#endif
+}
+
+static inline float fp16_scale(uint16_t d) {
+  float16_t h;
+  memcpy(&h, &d, sizeof(h));
+  return (float)h;
+}
+
+float quant_dot_q8_0_kernel(const block_q8_0_t *w, const block_q8_0_t *a,
+                            int nblocks) {
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (int b = 0; b < nblocks; b++) {
+    int32x4_t sum = vdupq_n_s32(0);
+    sum = dot_i8x16(sum, vld1q_s8(w[b].qs), vld1q_s8(a[b].qs));
+    sum = dot_i8x16(sum, vld1q_s8(w[b].qs + 16), vld1q_s8(a[b].qs + 16));
+    float d = fp16_scale(w[b].d) * fp16_scale(a[b].d);
+    acc = vmlaq_n_f32(acc, vcvtq_f32_s32(sum), d);
+  }
+  return vaddvq_f32(acc);
+}
+
+float quant_dot_q4_0_kernel(const block_q4_0_t *w, const block_q8_0_t *a,
+                            int nblocks) {
+  const uint8x16_t low_mask = vdupq_n_u8(0x0F);
+  const int8x16_t offset = vdupq_n_s8(8);
+  float32x4_t acc = vdupq_n_f32(0.0f);
+  for (int b = 0; b < nblocks; b++) {
+    uint8x16_t packed = vld1q_u8(w[b].qs);
+    int8x16_t lo =
+        vsubq_s8(vreinterpretq_s8_u8(vandq_u8(packed, low_mask)), offset);
+    int8x16_t hi = vsubq_s8(vreinterpretq_s8_u8(vshrq_n_u8(packed, 4)), offset);
+    int32x4_t sum = vdupq_n_s32(0);
+    sum = dot_i8x16(sum, lo, vld1q_s8(a[b].qs));
+    sum = dot_i8x16(sum, hi, vld1q_s8(a[b].qs + 16));
+    float d = fp16_scale(w[b].d) * fp16_scale(a[b].d);
+    acc = vmlaq_n_f32(acc, vcvtq_f32_s32(sum), d);
+  }
+  return vaddvq_f32(acc);
+}
+
+#else
+
+float quant_dot_q8_0_kernel(const block_q8_0_t *w, const block_q8_0_t *a,
+                            int nblocks) {
+  (void)w;
+  (void)a;
+  (void)nblocks;
+  return 0.0f;
+}
+
+float quant_dot_q4_0_kernel(const block_q4_0_t *w, const block_q8_0_t *a,
+                            int nblocks) {
+  (void)w;
+  (void)a;
+  (void)nblocks;
+  return 0.0f;
+}
+
+#endif
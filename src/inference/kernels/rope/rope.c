@@ -3,6 +3,7 @@
  */
 
 #include "inference/kernels/rope/rope.h"
+#include "inference/backend/threadpool.h"
 #include "inference/kernels/rope/rope_kernels.h"
 #include <math.h>
 #include <string.h>
@@ -343,11 +344,12 @@ static void rope_gptj_f16_scalar(const int64_t *positions, uint16_t *query,
   }
 }
 
-/* ============ Public API ============ */
+/* ============ Dispatch ============ */
 
-void rope_f32(const int64_t *positions, float *query, float *key,
-              const float *cos_sin_cache, int num_tokens, int num_heads,
-              int num_kv_heads, int head_size, int rot_dim, bool is_neox) {
+static void rope_f32_tokens(const int64_t *positions, float *query,
+                            float *key, const float *cos_sin_cache,
+                            int num_tokens, int num_heads, int num_kv_heads,
+                            int head_size, int rot_dim, bool is_neox) {
   if (num_tokens <= 0 || num_heads <= 0 || head_size <= 0 || rot_dim <= 0)
     return;
 
@@ -357,6 +359,10 @@ void rope_f32(const int64_t *positions, float *query, float *key,
     if (caps.has_neon) {
       rope_neox_f32_kernel(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
+    } else if (caps.has_avx2) {
+      rope_neox_f32_kernel_avx2(positions, query, key, cos_sin_cache,
+                                num_tokens, num_heads, num_kv_heads, head_size,
+                                rot_dim);
     } else {
       rope_neox_f32_scalar(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
@@ -365,6 +371,10 @@ void rope_f32(const int64_t *positions, float *query, float *key,
     if (caps.has_neon) {
       rope_gptj_f32_kernel(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
+    } else if (caps.has_avx2) {
+      rope_gptj_f32_kernel_avx2(positions, query, key, cos_sin_cache,
+                                num_tokens, num_heads, num_kv_heads, head_size,
+                                rot_dim);
     } else {
       rope_gptj_f32_scalar(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
@@ -372,9 +382,10 @@ void rope_f32(const int64_t *positions, float *query, float *key,
   }
 }
 
-void rope_bf16(const int64_t *positions, uint16_t *query, uint16_t *key,
-               const uint16_t *cos_sin_cache, int num_tokens, int num_heads,
-               int num_kv_heads, int head_size, int rot_dim, bool is_neox) {
+static void rope_bf16_tokens(const int64_t *positions, uint16_t *query,
+                             uint16_t *key, const uint16_t *cos_sin_cache,
+                             int num_tokens, int num_heads, int num_kv_heads,
+                             int head_size, int rot_dim, bool is_neox) {
   if (num_tokens <= 0 || num_heads <= 0 || head_size <= 0 || rot_dim <= 0)
     return;
 
@@ -384,6 +395,10 @@ void rope_bf16(const int64_t *positions, uint16_t *query, uint16_t *key,
     if (caps.has_neon) {
       rope_neox_bf16_kernel(positions, query, key, cos_sin_cache, num_tokens,
                             num_heads, num_kv_heads, head_size, rot_dim);
+    } else if (caps.has_avx2) {
+      rope_neox_bf16_kernel_avx2(positions, query, key, cos_sin_cache,
+                                 num_tokens, num_heads, num_kv_heads, head_size,
+                                 rot_dim);
     } else {
       rope_neox_bf16_scalar(positions, query, key, cos_sin_cache, num_tokens,
                             num_heads, num_kv_heads, head_size, rot_dim);
@@ -392,6 +407,10 @@ void rope_bf16(const int64_t *positions, uint16_t *query, uint16_t *key,
     if (caps.has_neon) {
       rope_gptj_bf16_kernel(positions, query, key, cos_sin_cache, num_tokens,
                             num_heads, num_kv_heads, head_size, rot_dim);
+    } else if (caps.has_avx2) {
+      rope_gptj_bf16_kernel_avx2(positions, query, key, cos_sin_cache,
+                                 num_tokens, num_heads, num_kv_heads, head_size,
+                                 rot_dim);
     } else {
       rope_gptj_bf16_scalar(positions, query, key, cos_sin_cache, num_tokens,
                             num_heads, num_kv_heads, head_size, rot_dim);
@@ -399,9 +418,10 @@ void rope_bf16(const int64_t *positions, uint16_t *query, uint16_t *key,
   }
 }
 
-void rope_f16(const int64_t *positions, uint16_t *query, uint16_t *key,
-              const uint16_t *cos_sin_cache, int num_tokens, int num_heads,
-              int num_kv_heads, int head_size, int rot_dim, bool is_neox) {
+static void rope_f16_tokens(const int64_t *positions, uint16_t *query,
+                            uint16_t *key, const uint16_t *cos_sin_cache,
+                            int num_tokens, int num_heads, int num_kv_heads,
+                            int head_size, int rot_dim, bool is_neox) {
   if (num_tokens <= 0 || num_heads <= 0 || head_size <= 0 || rot_dim <= 0)
     return;
 
@@ -411,6 +431,10 @@ void rope_f16(const int64_t *positions, uint16_t *query, uint16_t *key,
     if (caps.has_neon) {
       rope_neox_f16_kernel(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
+    } else if (caps.has_avx2) {
+      rope_neox_f16_kernel_avx2(positions, query, key, cos_sin_cache,
+                                num_tokens, num_heads, num_kv_heads, head_size,
+                                rot_dim);
     } else {
       rope_neox_f16_scalar(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
@@ -419,9 +443,123 @@ void rope_f16(const int64_t *positions, uint16_t *query, uint16_t *key,
     if (caps.has_neon) {
       rope_gptj_f16_kernel(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
+    } else if (caps.has_avx2) {
+      rope_gptj_f16_kernel_avx2(positions, query, key, cos_sin_cache,
+                                num_tokens, num_heads, num_kv_heads, head_size,
+                                rot_dim);
     } else {
       rope_gptj_f16_scalar(positions, query, key, cos_sin_cache, num_tokens,
                            num_heads, num_kv_heads, head_size, rot_dim);
     }
   }
 }
+
+/* ============ Public API (token-parallel) ============ */
+
+/*
+ * Each token rotates its own q/k rows, so prefill splits tokens across the
+ * shared pool; single-token decode stays on the calling thread.
+ */
+#define ROPE_MT_MIN_ELEMS (64 * 1024)
+
+typedef enum { ROPE_F32, ROPE_BF16, ROPE_F16 } rope_dtype_t;
+
+typedef struct {
+  rope_dtype_t dtype;
+  const int64_t *positions;
+  void *query;
+  void *key;
+  const void *cos_sin_cache;
+  int num_heads;
+  int num_kv_heads;
+  int head_size;
+  int rot_dim;
+  bool is_neox;
+} rope_task_t;
+
+static void rope_work(void *arg, int start, int end) {
+  const rope_task_t *t = (const rope_task_t *)arg;
+  size_t q_off = (size_t)start * t->num_heads * t->head_size;
+  size_t k_off = (size_t)start * t->num_kv_heads * t->head_size;
+  int n = end - start;
+
+  switch (t->dtype) {
+  case ROPE_F32:
+    rope_f32_tokens(t->positions + start, (float *)t->query + q_off,
+                    (float *)t->key + k_off, t->cos_sin_cache, n,
+                    t->num_heads, t->num_kv_heads, t->head_size, t->rot_dim,
+                    t->is_neox);
+    break;
+  case ROPE_BF16:
+    rope_bf16_tokens(t->positions + start, (uint16_t *)t->query + q_off,
+                     (uint16_t *)t->key + k_off, t->cos_sin_cache, n,
+                     t->num_heads, t->num_kv_heads, t->head_size, t->rot_dim,
+                     t->is_neox);
+    break;
+  case ROPE_F16:
+    rope_f16_tokens(t->positions + start, (uint16_t *)t->query + q_off,
+                    (uint16_t *)t->key + k_off, t->cos_sin_cache, n,
+                    t->num_heads, t->num_kv_heads, t->head_size, t->rot_dim,
+                    t->is_neox);
+    break;
+  }
+}
+
+static void rope_run(rope_task_t *t, int num_tokens) {
+  if (num_tokens <= 0 || t->num_heads <= 0 || t->head_size <= 0 ||
+      t->rot_dim <= 0)
+    return;
+  long long elems = (long long)num_tokens *
+                    (t->num_heads + t->num_kv_heads) * t->rot_dim;
+  if (num_tokens < 2 || elems < ROPE_MT_MIN_ELEMS) {
+    rope_work(t, 0, num_tokens);
+    return;
+  }
+  threadpool_parallel_for(threadpool_global(), 0, num_tokens, 1, rope_work, t);
+}
+
+void rope_f32(const int64_t *positions, float *query, float *key,
+              const float *cos_sin_cache, int num_tokens, int num_heads,
+              int num_kv_heads, int head_size, int rot_dim, bool is_neox) {
+  rope_task_t t = {ROPE_F32, positions, query, key, cos_sin_cache,
+                   num_heads, num_kv_heads, head_size, rot_dim, is_neox};
+  rope_run(&t, num_tokens);
+}
+
+void rope_bf16(const int64_t *positions, uint16_t *query, uint16_t *key,
+               const uint16_t *cos_sin_cache, int num_tokens, int num_heads,
+               int num_kv_heads, int head_size, int rot_dim, bool is_neox) {
+  rope_task_t t = {ROPE_BF16, positions, query, key, cos_sin_cache,
+                   num_heads, num_kv_heads, head_size, rot_dim, is_neox};
+  rope_run(&t, num_tokens);
+}
+
+void rope_f16(const int64_t *positions, uint16_t *query, uint16_t *key,
+              const uint16_t *cos_sin_cache, int num_tokens, int num_heads,
+              int num_kv_heads, int head_size, int rot_dim, bool is_neox) {
+  rope_task_t t = {ROPE_F16, positions, query, key, cos_sin_cache,
+                   num_heads, num_kv_heads, head_size, rot_dim, is_neox};
+  rope_run(&t, num_tokens);
+}
+
+/* ============ Position Shift ============ */
+
+void rope_shift_f32(float *vecs, const float *cos_sin, int num_vecs,
+                    int head_size, int rot_dim, bool is_neox) {
+  int half_dim = rot_dim / 2;
+  const float *cos_ptr = cos_sin;
+  const float *sin_ptr = cos_sin + half_dim;
+
+  for (int v = 0; v < num_vecs; v++) {
+    float *vec = vecs + (size_t)v * head_size;
+    for (int i = 0; i < half_dim; i++) {
+      int x_idx = is_neox ? i : 2 * i;
+      int y_idx = is_neox ? half_dim + i : 2 * i + 1;
+      float x = vec[x_idx];
+      float y = vec[y_idx];
+      /* Inverse rotation: cos(-a) = cos(a), sin(-a) = -sin(a) */
+      vec[x_idx] = x * cos_ptr[i] + y * sin_ptr[i];
+      vec[y_idx] = y * cos_ptr[i] - x * sin_ptr[i];
+    }
+  }
+}
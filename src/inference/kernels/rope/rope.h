@@ -57,6 +57,21 @@ void rope_f16(const int64_t *positions, uint16_t *query, uint16_t *key,
               const uint16_t *cos_sin_cache, int num_tokens, int num_heads,
               int num_kv_heads, int head_size, int rot_dim, bool is_neox);
 
+/*
+ * Move vectors that were rotated for position p to position p - delta, e.g.
+ * cached keys whose tokens slid down after a KV context shift. A rotation
+ * by -delta only needs the cache row of position delta with the sine
+ * negated, so the existing cos/sin cache serves any shift.
+ *
+ * Args:
+ *   vecs: [num_vecs, head_size], modified in-place
+ *   cos_sin: Row delta of the cos/sin cache (cos_sin_cache + delta * rot_dim)
+ *   num_vecs: Number of vectors (tokens times heads)
+ *   head_size, rot_dim, is_neox: as for rope_f32()
+ */
+void rope_shift_f32(float *vecs, const float *cos_sin, int num_vecs,
+                    int head_size, int rot_dim, bool is_neox);
+
 /*
  * Compute cos/sin cache for RoPE.
  *
@@ -0,0 +1,309 @@
+/*
+ * Rotary Position Embeddings - AVX2/FMA Optimized Kernels
+ */
+
+#include "inference/kernels/rope/rope_kernels.h"
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+/* ============ Load/Store Helpers ============ */
+
+AVX2_INLINE __m256 load8(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm256_loadu_ps((const float *)p + idx);
+  __m128i h = _mm_loadu_si128((const __m128i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm256_cvtph_ps(h);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+/* Load 4 values and duplicate each into adjacent lanes: a b c d -> aabbccdd */
+AVX2_INLINE __m256 load4_dup(const void *p, size_t idx, int kind) {
+  __m128 v;
+  if (kind == ELEM_F32) {
+    v = _mm_loadu_ps((const float *)p + idx);
+  } else {
+    __m128i h = _mm_loadl_epi64((const __m128i *)((const uint16_t *)p + idx));
+    if (kind == ELEM_F16)
+      v = _mm_cvtph_ps(h);
+    else
+      v = _mm_castsi128_ps(_mm_slli_epi32(_mm_cvtepu16_epi32(h), 16));
+  }
+  const __m256i dup = _mm256_setr_epi32(0, 0, 1, 1, 2, 2, 3, 3);
+  return _mm256_permutevar8x32_ps(_mm256_castps128_ps256(v), dup);
+}
+
+AVX2_INLINE void store8(void *p, size_t idx, __m256 v, int kind) {
+  if (kind == ELEM_F32) {
+    _mm256_storeu_ps((float *)p + idx, v);
+    return;
+  }
+  __m128i h;
+  if (kind == ELEM_F16) {
+    h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i lsb =
+        _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    bits = _mm256_add_epi32(bits,
+                            _mm256_add_epi32(_mm256_set1_epi32(0x7fff), lsb));
+    bits = _mm256_srli_epi32(bits, 16);
+    h = _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                         _mm256_extracti128_si256(bits, 1));
+  }
+  _mm_storeu_si128((__m128i *)((uint16_t *)p + idx), h);
+}
+
+AVX2_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX2_INLINE void store1(void *p, size_t idx, float v, int kind) {
+  if (kind == ELEM_F32) {
+    ((float *)p)[idx] = v;
+  } else if (kind == ELEM_F16) {
+    ((uint16_t *)p)[idx] = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    ((uint16_t *)p)[idx] = (uint16_t)(bits >> 16);
+  }
+}
+
+/* ============ NeoX Style (rotate halves) ============ */
+
+AVX2_INLINE void rope_neox_head(void *x, size_t base, const void *cache,
+                                size_t cos_off, int half_dim, int kind) {
+  size_t sin_off = cos_off + half_dim;
+  int i = 0;
+  for (; i + 8 <= half_dim; i += 8) {
+    __m256 c = load8(cache, cos_off + i, kind);
+    __m256 s = load8(cache, sin_off + i, kind);
+    __m256 a = load8(x, base + i, kind);
+    __m256 b = load8(x, base + half_dim + i, kind);
+    store8(x, base + i, _mm256_fmsub_ps(a, c, _mm256_mul_ps(b, s)), kind);
+    store8(x, base + half_dim + i, _mm256_fmadd_ps(b, c, _mm256_mul_ps(a, s)),
+           kind);
+  }
+  for (; i < half_dim; i++) {
+    float c = load1(cache, cos_off + i, kind);
+    float s = load1(cache, sin_off + i, kind);
+    float a = load1(x, base + i, kind);
+    float b = load1(x, base + half_dim + i, kind);
+    store1(x, base + i, a * c - b * s, kind);
+    store1(x, base + half_dim + i, b * c + a * s, kind);
+  }
+}
+
+/* ============ GPT-J Style (rotate interleaved pairs) ============ */
+
+AVX2_INLINE void rope_gptj_head(void *x, size_t base, const void *cache,
+                                size_t cos_off, int half_dim, int kind) {
+  size_t sin_off = cos_off + half_dim;
+  int i = 0;
+  /* v = [x0 y0 x1 y1 ...]; fmaddsub yields x*c - y*s (even), y*c + x*s (odd) */
+  for (; i + 4 <= half_dim; i += 4) {
+    __m256 c = load4_dup(cache, cos_off + i, kind);
+    __m256 s = load4_dup(cache, sin_off + i, kind);
+    __m256 v = load8(x, base + 2 * i, kind);
+    __m256 swapped = _mm256_permute_ps(v, 0xB1);
+    store8(x, base + 2 * i, _mm256_fmaddsub_ps(v, c, _mm256_mul_ps(swapped, s)),
+           kind);
+  }
+  for (; i < half_dim; i++) {
+    float c = load1(cache, cos_off + i, kind);
+    float s = load1(cache, sin_off + i, kind);
+    float a = load1(x, base + 2 * i, kind);
+    float b = load1(x, base + 2 * i + 1, kind);
+    store1(x, base + 2 * i, a * c - b * s, kind);
+    store1(x, base + 2 * i + 1, b * c + a * s, kind);
+  }
+}
+
+AVX2_INLINE void rope_avx2(const int64_t *positions, void *query, void *key,
+                           const void *cos_sin_cache, int num_tokens,
+                           int num_heads, int num_kv_heads, int head_size,
+                           int rot_dim, int neox, int kind) {
+  int half_dim = rot_dim / 2;
+  size_t query_stride = (size_t)num_heads * head_size;
+  size_t key_stride = (size_t)num_kv_heads * head_size;
+
+  for (int t = 0; t < num_tokens; t++) {
+    size_t cos_off = (size_t)positions[t] * rot_dim;
+
+    for (int h = 0; h < num_heads; h++) {
+      size_t base = t * query_stride + (size_t)h * head_size;
+      if (neox)
+        rope_neox_head(query, base, cos_sin_cache, cos_off, half_dim, kind);
+      else
+        rope_gptj_head(query, base, cos_sin_cache, cos_off, half_dim, kind);
+    }
+
+    if (key != NULL) {
+      for (int h = 0; h < num_kv_heads; h++) {
+        size_t base = t * key_stride + (size_t)h * head_size;
+        if (neox)
+          rope_neox_head(key, base, cos_sin_cache, cos_off, half_dim, kind);
+        else
+          rope_gptj_head(key, base, cos_sin_cache, cos_off, half_dim, kind);
+      }
+    }
+  }
+}
+
+void rope_neox_f32_kernel_avx2(const int64_t *positions, float *query,
+                               float *key, const float *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  rope_avx2(positions, query, key, cos_sin_cache, num_tokens, num_heads,
+            num_kv_heads, head_size, rot_dim, 1, ELEM_F32);
+}
+
+void rope_neox_bf16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                                uint16_t *key, const uint16_t *cos_sin_cache,
+                                int num_tokens, int num_heads,
+                                int num_kv_heads, int head_size, int rot_dim) {
+  rope_avx2(positions, query, key, cos_sin_cache, num_tokens, num_heads,
+            num_kv_heads, head_size, rot_dim, 1, ELEM_BF16);
+}
+
+void rope_neox_f16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                               uint16_t *key, const uint16_t *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  rope_avx2(positions, query, key, cos_sin_cache, num_tokens, num_heads,
+            num_kv_heads, head_size, rot_dim, 1, ELEM_F16);
+}
+
+void rope_gptj_f32_kernel_avx2(const int64_t *positions, float *query,
+                               float *key, const float *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  rope_avx2(positions, query, key, cos_sin_cache, num_tokens, num_heads,
+            num_kv_heads, head_size, rot_dim, 0, ELEM_F32);
+}
+
+void rope_gptj_bf16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                                uint16_t *key, const uint16_t *cos_sin_cache,
+                                int num_tokens, int num_heads,
+                                int num_kv_heads, int head_size, int rot_dim) {
+  rope_avx2(positions, query, key, cos_sin_cache, num_tokens, num_heads,
+            num_kv_heads, head_size, rot_dim, 0, ELEM_BF16);
+}
+
+void rope_gptj_f16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                               uint16_t *key, const uint16_t *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  rope_avx2(positions, query, key, cos_sin_cache, num_tokens, num_heads,
+            num_kv_heads, head_size, rot_dim, 0, ELEM_F16);
+}
+
+#else
+
+void rope_neox_f32_kernel_avx2(const int64_t *positions, float *query,
+                               float *key, const float *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  (void)positions;
+  (void)query;
+  (void)key;
+  (void)cos_sin_cache;
+  (void)num_tokens;
+  (void)num_heads;
+  (void)num_kv_heads;
+  (void)head_size;
+  (void)rot_dim;
+}
+
+void rope_neox_bf16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                                uint16_t *key, const uint16_t *cos_sin_cache,
+                                int num_tokens, int num_heads,
+                                int num_kv_heads, int head_size, int rot_dim) {
+  (void)positions;
+  (void)query;
+  (void)key;
+  (void)cos_sin_cache;
+  (void)num_tokens;
+  (void)num_heads;
+  (void)num_kv_heads;
+  (void)head_size;
+  (void)rot_dim;
+}
+
+void rope_neox_f16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                               uint16_t *key, const uint16_t *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  (void)positions;
+  (void)query;
+  (void)key;
+  (void)cos_sin_cache;
+  (void)num_tokens;
+  (void)num_heads;
+  (void)num_kv_heads;
+  (void)head_size;
+  (void)rot_dim;
+}
+
+void rope_gptj_f32_kernel_avx2(const int64_t *positions, float *query,
+                               float *key, const float *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  (void)positions;
+  (void)query;
+  (void)key;
+  (void)cos_sin_cache;
+  (void)num_tokens;
+  (void)num_heads;
+  (void)num_kv_heads;
+  (void)head_size;
+  (void)rot_dim;
+}
+
+void rope_gptj_bf16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                                uint16_t *key, const uint16_t *cos_sin_cache,
+                                int num_tokens, int num_heads,
+                                int num_kv_heads, int head_size, int rot_dim) {
+  (void)positions;
+  (void)query;
+  (void)key;
+  (void)cos_sin_cache;
+  (void)num_tokens;
+  (void)num_heads;
+  (void)num_kv_heads;
+  (void)head_size;
+  (void)rot_dim;
+}
+
+void rope_gptj_f16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                               uint16_t *key, const uint16_t *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim) {
+  (void)positions;
+  (void)query;
+  (void)key;
+  (void)cos_sin_cache;
+  (void)num_tokens;
+  (void)num_heads;
+  (void)num_kv_heads;
+  (void)head_size;
+  (void)rot_dim;
+}
+
+#endif
@@ -46,4 +46,35 @@ void rope_gptj_f16_kernel(const int64_t *positions, uint16_t *query,
                           int num_tokens, int num_heads, int num_kv_heads,
                           int head_size, int rot_dim);
 
+/* AVX2/FMA kernels (x86-64) */
+void rope_neox_f32_kernel_avx2(const int64_t *positions, float *query,
+                               float *key, const float *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim);
+
+void rope_neox_bf16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                                uint16_t *key, const uint16_t *cos_sin_cache,
+                                int num_tokens, int num_heads, int num_kv_heads,
+                                int head_size, int rot_dim);
+
+void rope_neox_f16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                               uint16_t *key, const uint16_t *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim);
+
+void rope_gptj_f32_kernel_avx2(const int64_t *positions, float *query,
+                               float *key, const float *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim);
+
+void rope_gptj_bf16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                                uint16_t *key, const uint16_t *cos_sin_cache,
+                                int num_tokens, int num_heads, int num_kv_heads,
+                                int head_size, int rot_dim);
+
+void rope_gptj_f16_kernel_avx2(const int64_t *positions, uint16_t *query,
+                               uint16_t *key, const uint16_t *cos_sin_cache,
+                               int num_tokens, int num_heads, int num_kv_heads,
+                               int head_size, int rot_dim);
+
 #endif /* ROPE_KERNELS_H */
@@ -3,6 +3,7 @@
  */
 
 #include "inference/kernels/sampling/sampling.h"
+#include "inference/backend/threadpool.h"
 #include "inference/kernels/sampling/sampling_kernels.h"
 #include <float.h>
 #include <math.h>
@@ -38,255 +39,438 @@ static float compute_max_logit(const float *logits, int vocab_size) {
   return max_val;
 }
 
-static void apply_temperature(float *probs, int vocab_size, float temperature) {
-  if (temperature == 1.0f) {
-    return;
-  }
-  float inv_temp = 1.0f / temperature;
-  for (int i = 0; i < vocab_size; i++) {
-    if (probs[i] > 0.0f) {
-      probs[i] = powf(probs[i], inv_temp);
-    }
-  }
-}
+#define SAMPLING_SCAN_BLOCK 256
 
-static int apply_top_k(float *probs, int vocab_size, int top_k) {
-  if (top_k <= 0 || top_k >= vocab_size) {
-    return vocab_size;
+/*
+ * Inverse-CDF draw; random_val is in [0, sum of probs). Whole blocks are
+ * skipped on their sums, which have no serial dependency, so only one block
+ * is scanned a token at a time. Rounding can leave the total short of
+ * random_val: the last token that has any mass is taken then, never a
+ * filtered-out one.
+ */
+static int sample_from_distribution(const float *probs, int vocab_size,
+                                    float random_val) {
+  float cumsum = 0.0f;
+  int i = 0;
+  for (; i + SAMPLING_SCAN_BLOCK <= vocab_size; i += SAMPLING_SCAN_BLOCK) {
+    float acc[8] = {0.0f};
+    for (int j = 0; j < SAMPLING_SCAN_BLOCK; j += 8) {
+      for (int l = 0; l < 8; l++)
+        acc[l] += probs[i + j + l];
+    }
+    float block = ((acc[0] + acc[1]) + (acc[2] + acc[3])) +
+                  ((acc[4] + acc[5]) + (acc[6] + acc[7]));
+    if (random_val < cumsum + block)
+      break;
+    cumsum += block;
   }
-
-  typedef struct {
-    float prob;
-    int idx;
-  } prob_idx_t;
-
-  prob_idx_t *candidates =
-      (prob_idx_t *)malloc(vocab_size * sizeof(prob_idx_t));
-  for (int i = 0; i < vocab_size; i++) {
-    candidates[i].prob = probs[i];
-    candidates[i].idx = i;
+  for (; i < vocab_size; i++) {
+    cumsum += probs[i];
+    if (random_val < cumsum)
+      return i;
   }
+  for (i = vocab_size - 1; i > 0 && probs[i] <= 0.0f; i--)
+    ;
+  return i;
+}
 
-  for (int i = 0; i < top_k; i++) {
-    int max_idx = i;
-    for (int j = i + 1; j < vocab_size; j++) {
-      if (candidates[j].prob > candidates[max_idx].prob) {
-        max_idx = j;
-      }
+static int sample_argmax(const float *logits, int vocab_size) {
+  int max_idx = 0;
+  float max_val = logits[0];
+  for (int i = 1; i < vocab_size; i++) {
+    if (logits[i] > max_val) {
+      max_val = logits[i];
+      max_idx = i;
     }
-    prob_idx_t tmp = candidates[i];
-    candidates[i] = candidates[max_idx];
-    candidates[max_idx] = tmp;
   }
-
-  for (int i = 0; i < vocab_size; i++) {
-    probs[i] = 0.0f;
-  }
-  for (int i = 0; i < top_k; i++) {
-    probs[candidates[i].idx] = candidates[i].prob;
-  }
-
-  free(candidates);
-  return top_k;
+  return max_idx;
 }
 
-static int apply_top_p(float *probs, int vocab_size, float top_p) {
-  if (top_p >= 1.0f) {
-    return vocab_size;
+static float sampling_prob_f32_scalar(const float *logits, int vocab_size,
+                                      int token_id) {
+  if (token_id < 0 || token_id >= vocab_size) {
+    return 0.0f;
   }
 
-  typedef struct {
-    float prob;
-    int idx;
-  } prob_idx_t;
+  float max_logit = compute_max_logit(logits, vocab_size);
 
-  prob_idx_t *sorted = (prob_idx_t *)malloc(vocab_size * sizeof(prob_idx_t));
-  int count = 0;
+  float sum = 0.0f;
   for (int i = 0; i < vocab_size; i++) {
-    if (probs[i] > 0.0f) {
-      sorted[count].prob = probs[i];
-      sorted[count].idx = i;
-      count++;
-    }
+    sum += expf(logits[i] - max_logit);
   }
 
-  for (int i = 0; i < count - 1; i++) {
-    for (int j = i + 1; j < count; j++) {
-      if (sorted[j].prob > sorted[i].prob) {
-        prob_idx_t tmp = sorted[i];
-        sorted[i] = sorted[j];
-        sorted[j] = tmp;
-      }
-    }
+  if (sum == 0.0f) {
+    return 0.0f;
   }
 
-  float cumsum = 0.0f;
-  int keep_count = 0;
-  for (int i = 0; i < count; i++) {
-    cumsum += sorted[i].prob;
-    keep_count++;
-    if (cumsum >= top_p) {
-      break;
-    }
-  }
+  return expf(logits[token_id] - max_logit) / sum;
+}
 
-  for (int i = 0; i < vocab_size; i++) {
-    probs[i] = 0.0f;
-  }
-  for (int i = 0; i < keep_count; i++) {
-    probs[sorted[i].idx] = sorted[i].prob;
+/*
+ * Greedy decoding over a large vocabulary is a single streaming reduction, so
+ * it is split into per-thread slices on the shared pool. Each slice keeps the
+ * first maximum it sees and slices are merged in order, which reproduces the
+ * serial tie-breaking exactly.
+ */
+#define SAMPLING_MT_MIN_VOCAB (32 * 1024)
+#define SAMPLING_MAX_SLICES 64
+
+typedef struct {
+  const float *logits;
+  int vocab_size;
+  int slice;
+  sampling_caps_t caps;
+  int best[SAMPLING_MAX_SLICES];
+} argmax_task_t;
+
+static int argmax_slice(const sampling_caps_t *caps, const float *logits,
+                        int n) {
+  unsigned long long unused = 0;
+  if (caps->has_neon)
+    return sampling_sample_f32_kernel(logits, n, 0.0f, -1, 1.0f, 0.0f,
+                                      &unused);
+  if (caps->has_avx2)
+    return sampling_sample_f32_kernel_avx2(logits, n, 0.0f, -1, 1.0f, 0.0f,
+                                           &unused);
+  return sample_argmax(logits, n);
+}
+
+static void argmax_work(void *arg, int start, int end) {
+  argmax_task_t *t = (argmax_task_t *)arg;
+  for (int s = start; s < end; s++) {
+    int lo = s * t->slice;
+    int hi = lo + t->slice < t->vocab_size ? lo + t->slice : t->vocab_size;
+    t->best[s] = lo < hi ? lo + argmax_slice(&t->caps, t->logits + lo, hi - lo)
+                         : -1;
   }
+}
 
-  free(sorted);
-  return keep_count;
+static int sample_argmax_parallel(const float *logits, int vocab_size,
+                                  sampling_caps_t caps) {
+  int slices = threadpool_get_num_threads();
+  if (slices > SAMPLING_MAX_SLICES)
+    slices = SAMPLING_MAX_SLICES;
+  if (slices <= 1 || vocab_size < SAMPLING_MT_MIN_VOCAB)
+    return argmax_slice(&caps, logits, vocab_size);
+
+  argmax_task_t task;
+  task.logits = logits;
+  task.vocab_size = vocab_size;
+  task.slice = (vocab_size + slices - 1) / slices;
+  task.caps = caps;
+  threadpool_parallel_for(threadpool_global(), 0, slices, 1, argmax_work,
+                          &task);
+
+  int best = task.best[0];
+  for (int s = 1; s < slices; s++) {
+    if (task.best[s] >= 0 && logits[task.best[s]] > logits[best])
+      best = task.best[s];
+  }
+  return best;
 }
 
-static int apply_min_p(float *probs, int vocab_size, float min_p) {
-  if (min_p <= 0.0f) {
-    return vocab_size;
-  }
+/*
+ * Sampler pipeline
+ *
+ * The filters are equivalent to softmax -> min-p -> top-k -> top-p ->
+ * temperature on the full distribution, without ever sorting:
+ *   - min-p is a cut at max + log(min_p) on the logits
+ *   - top-k keeps a k-entry min-heap while streaming over the logits
+ *   - top-p selects the nucleus with a mass-weighted quickselect
+ * Temperature is applied to the survivors only. Without filters the whole
+ * pipeline is two SIMD passes (max, then fused temperature and exponential)
+ * and a blocked scan.
+ */
+static bool workspace_reserve(sampling_workspace_t *ws, int vocab_size) {
+  if (ws->capacity >= vocab_size)
+    return true;
+  float *probs = (float *)malloc((size_t)vocab_size * sizeof(float));
+  sampling_candidate_t *candidates = (sampling_candidate_t *)malloc(
+      (size_t)vocab_size * sizeof(sampling_candidate_t));
+  if (!probs || !candidates) {
+    free(probs);
+    free(candidates);
+    return false;
+  }
+  sampling_workspace_free(ws);
+  ws->probs = probs;
+  ws->candidates = candidates;
+  ws->capacity = vocab_size;
+  return true;
+}
 
-  float max_prob = 0.0f;
-  for (int i = 0; i < vocab_size; i++) {
-    if (probs[i] > max_prob) {
-      max_prob = probs[i];
-    }
-  }
+bool sampling_workspace_init(sampling_workspace_t *ws, int vocab_size) {
+  memset(ws, 0, sizeof(*ws));
+  return workspace_reserve(ws, vocab_size);
+}
 
-  float threshold = max_prob * min_p;
-  int keep_count = 0;
-  for (int i = 0; i < vocab_size; i++) {
-    if (probs[i] < threshold) {
-      probs[i] = 0.0f;
-    } else {
-      keep_count++;
-    }
-  }
+void sampling_workspace_free(sampling_workspace_t *ws) {
+  free(ws->probs);
+  free(ws->candidates);
+  memset(ws, 0, sizeof(*ws));
+}
 
-  return keep_count;
+static float pipeline_max(const sampling_caps_t *caps, const float *x, int n) {
+  if (caps->has_neon)
+    return sampling_max_f32_kernel(x, n);
+  if (caps->has_avx2)
+    return sampling_max_f32_kernel_avx2(x, n);
+  return compute_max_logit(x, n);
 }
 
-static float compute_sum(const float *probs, int vocab_size) {
+/* out = exp((x - max) * scale); returns the sum */
+static float pipeline_exp(const sampling_caps_t *caps, float *out,
+                          const float *x, int n, float max, float scale) {
+  if (caps->has_neon)
+    return sampling_exp_f32_kernel(out, x, n, max, scale);
+  if (caps->has_avx2)
+    return sampling_exp_f32_kernel_avx2(out, x, n, max, scale);
   float sum = 0.0f;
-  for (int i = 0; i < vocab_size; i++) {
-    sum += probs[i];
+  for (int i = 0; i < n; i++) {
+    out[i] = expf((x[i] - max) * scale);
+    sum += out[i];
   }
   return sum;
 }
 
-static void normalize_probs(float *probs, int vocab_size, float sum) {
-  if (sum == 0.0f) {
-    return;
-  }
-  float inv_sum = 1.0f / sum;
-  for (int i = 0; i < vocab_size; i++) {
-    probs[i] *= inv_sum;
-  }
+static void swap_candidates(sampling_candidate_t *a, sampling_candidate_t *b) {
+  sampling_candidate_t tmp = *a;
+  *a = *b;
+  *b = tmp;
 }
 
-static int sample_from_distribution(const float *probs, int vocab_size,
-                                    float random_val) {
-  float cumsum = 0.0f;
-  for (int i = 0; i < vocab_size; i++) {
-    cumsum += probs[i];
-    if (random_val < cumsum) {
-      return i;
-    }
+static void heap_sift_down(sampling_candidate_t *heap, int n, int i) {
+  for (;;) {
+    int l = 2 * i + 1;
+    int min = i;
+    if (l < n && heap[l].prob < heap[min].prob)
+      min = l;
+    if (l + 1 < n && heap[l + 1].prob < heap[min].prob)
+      min = l + 1;
+    if (min == i)
+      return;
+    swap_candidates(&heap[i], &heap[min]);
+    i = min;
   }
-  return vocab_size - 1;
 }
 
-static int sample_argmax(const float *logits, int vocab_size) {
-  int max_idx = 0;
-  float max_val = logits[0];
-  for (int i = 1; i < vocab_size; i++) {
-    if (logits[i] > max_val) {
-      max_val = logits[i];
-      max_idx = i;
+/*
+ * The top_k largest logits at or above cut, as (logit, token) pairs. Ties
+ * keep the earlier token.
+ */
+static int select_top_k(sampling_candidate_t *heap, const float *logits,
+                        int vocab_size, int top_k, float cut) {
+  int n = 0;
+  int i = 0;
+  for (; i < vocab_size && n < top_k; i++) {
+    if (logits[i] >= cut) {
+      heap[n].prob = logits[i];
+      heap[n].idx = i;
+      n++;
     }
   }
-  return max_idx;
-}
-
-static int sampling_sample_f32_scalar(const float *logits, int vocab_size,
-                                      float temperature, int top_k, float top_p,
-                                      float min_p,
-                                      unsigned long long *rng_state) {
-  if (temperature == 0.0f) {
-    return sample_argmax(logits, vocab_size);
+  for (int j = n / 2 - 1; j >= 0; j--)
+    heap_sift_down(heap, n, j);
+  if (n < top_k)
+    return n;
+
+  while (i < vocab_size) {
+    /* Almost every logit loses to the heap's minimum: skip them in eights */
+    if (i + 8 <= vocab_size) {
+      float min = heap[0].prob;
+      int any = 0;
+      for (int j = 0; j < 8; j++)
+        any |= logits[i + j] > min;
+      if (!any) {
+        i += 8;
+        continue;
+      }
+    }
+    int end = i + 8 < vocab_size ? i + 8 : vocab_size;
+    for (; i < end; i++) {
+      if (logits[i] > heap[0].prob) {
+        heap[0].prob = logits[i];
+        heap[0].idx = i;
+        heap_sift_down(heap, n, 0);
+      }
+    }
   }
+  return n;
+}
 
-  float max_logit = compute_max_logit(logits, vocab_size);
-
-  float *probs = (float *)malloc(vocab_size * sizeof(float));
-  for (int i = 0; i < vocab_size; i++) {
-    probs[i] = expf(logits[i] - max_logit);
-  }
+/*
+ * Reorder the candidates so that the shortest run of the largest ones
+ * holding at least target of the mass comes first, and return its length.
+ * A quickselect that descends on the mass instead of a rank: O(n) expected,
+ * nothing is sorted.
+ */
+static int select_nucleus(sampling_candidate_t *c, int n, double target) {
+  int lo = 0;
+  int hi = n;
+  while (hi - lo > 1) {
+    float pivot = c[lo + (hi - lo) / 2].prob;
+
+    /* [lo, lt) > pivot, [lt, gt) == pivot, [gt, hi) < pivot */
+    int lt = lo;
+    int gt = hi;
+    int i = lo;
+    double upper = 0.0;
+    while (i < gt) {
+      if (c[i].prob > pivot) {
+        upper += c[i].prob;
+        swap_candidates(&c[lt++], &c[i++]);
+      } else if (c[i].prob < pivot) {
+        swap_candidates(&c[i], &c[--gt]);
+      } else {
+        i++;
+      }
+    }
 
-  if (min_p > 0.0f) {
-    apply_min_p(probs, vocab_size, min_p);
+    if (upper >= target) {
+      hi = lt;
+      continue;
+    }
+    target -= upper;
+    double equal = (double)pivot * (gt - lt);
+    if (equal >= target) {
+      int m = (int)ceil(target / pivot);
+      return lt + (m < gt - lt ? m : gt - lt);
+    }
+    target -= equal;
+    lo = gt;
   }
+  return hi;
+}
 
-  if (top_k > 0) {
-    apply_top_k(probs, vocab_size, top_k);
-  }
+/*
+ * Run the filters and temperature. Returns the number of survivors n, with
+ * their unnormalized weights in ws->probs[0, n) and *sum their total. The
+ * weights are for tokens ws->candidates[i].idx, or for tokens 0..n-1
+ * (*dense set) when nothing was filtered.
+ */
+static int pipeline_weights(sampling_workspace_t *ws, const float *logits,
+                            int vocab_size, float temperature, int top_k,
+                            float top_p, float min_p, bool *dense,
+                            float *sum) {
+  sampling_caps_t caps = sampling_get_capabilities();
+  float max = pipeline_max(&caps, logits, vocab_size);
+  float inv_temp = 1.0f / temperature;
+  bool use_top_k = top_k > 0 && top_k < vocab_size;
 
-  if (top_p < 1.0f) {
-    float sum = compute_sum(probs, vocab_size);
-    normalize_probs(probs, vocab_size, sum);
-    apply_top_p(probs, vocab_size, top_p);
+  if (min_p <= 0.0f && !use_top_k && top_p >= 1.0f) {
+    *dense = true;
+    *sum = pipeline_exp(&caps, ws->probs, logits, vocab_size, max, inv_temp);
+    return vocab_size;
   }
 
-  apply_temperature(probs, vocab_size, temperature);
-
-  float sum = compute_sum(probs, vocab_size);
-  normalize_probs(probs, vocab_size, sum);
-
-  float random_val = random_f32(rng_state);
-  int sampled = sample_from_distribution(probs, vocab_size, random_val);
-
-  free(probs);
-  return sampled;
-}
-
-static float sampling_prob_f32_scalar(const float *logits, int vocab_size,
-                                      int token_id) {
-  if (token_id < 0 || token_id >= vocab_size) {
-    return 0.0f;
+  /* Candidate weights are the unnormalized softmax until temperature */
+  sampling_candidate_t *c = ws->candidates;
+  int n = 0;
+  if (use_top_k) {
+    float cut = min_p > 0.0f ? max + logf(min_p) : -INFINITY;
+    n = select_top_k(c, logits, vocab_size, top_k, cut);
+    for (int i = 0; i < n; i++)
+      c[i].prob = expf(c[i].prob - max);
+  } else {
+    pipeline_exp(&caps, ws->probs, logits, vocab_size, max, 1.0f);
+    for (int i = 0; i < vocab_size; i++) {
+      c[n].prob = ws->probs[i];
+      c[n].idx = i;
+      n += ws->probs[i] > 0.0f && ws->probs[i] >= min_p;
+    }
   }
 
-  float max_logit = compute_max_logit(logits, vocab_size);
-
-  float sum = 0.0f;
-  for (int i = 0; i < vocab_size; i++) {
-    sum += expf(logits[i] - max_logit);
+  if (top_p < 1.0f && n > 1) {
+    double total = 0.0;
+    for (int i = 0; i < n; i++)
+      total += c[i].prob;
+    n = select_nucleus(c, n, top_p * total);
   }
 
-  if (sum == 0.0f) {
-    return 0.0f;
-  }
+  /* exp((l - max) / T) is the tempered weight p^(1/T), computed in SIMD */
+  float *w = ws->probs;
+  for (int i = 0; i < n; i++)
+    w[i] = logits[c[i].idx];
+  *dense = false;
+  *sum = pipeline_exp(&caps, w, w, n, max, inv_temp);
+  return n;
+}
 
-  return expf(logits[token_id] - max_logit) / sum;
+int sampling_sample_ws_f32(sampling_workspace_t *ws, const float *logits,
+                           int vocab_size, float temperature, int top_k,
+                           float top_p, float min_p, sampling_rng_t *rng) {
+  sampling_caps_t caps = sampling_get_capabilities();
+  if (temperature == 0.0f || !workspace_reserve(ws, vocab_size))
+    return sample_argmax_parallel(logits, vocab_size, caps);
+
+  bool dense;
+  float sum;
+  int n = pipeline_weights(ws, logits, vocab_size, temperature, top_k, top_p,
+                           min_p, &dense, &sum);
+  if (n == 0)
+    return sample_argmax(logits, vocab_size);
+  int i =
+      sample_from_distribution(ws->probs, n, random_f32(&rng->rng_state) * sum);
+  return dense ? i : ws->candidates[i].idx;
 }
 
 int sampling_sample_f32(const float *logits, int vocab_size, float temperature,
                         int top_k, float top_p, float min_p,
                         sampling_rng_t *rng) {
-  sampling_caps_t caps = sampling_get_capabilities();
-  if (caps.has_neon) {
-    return sampling_sample_f32_kernel(logits, vocab_size, temperature, top_k,
-                                      top_p, min_p, &rng->rng_state);
-  } else {
-    return sampling_sample_f32_scalar(logits, vocab_size, temperature, top_k,
-                                      top_p, min_p, &rng->rng_state);
-  }
+  if (temperature == 0.0f) {
+    return sample_argmax_parallel(logits, vocab_size,
+                                  sampling_get_capabilities());
+  }
+  sampling_workspace_t ws;
+  memset(&ws, 0, sizeof(ws));
+  int token = sampling_sample_ws_f32(&ws, logits, vocab_size, temperature,
+                                     top_k, top_p, min_p, rng);
+  sampling_workspace_free(&ws);
+  return token;
 }
 
 float sampling_prob_f32(const float *logits, int vocab_size, int token_id) {
   sampling_caps_t caps = sampling_get_capabilities();
   if (caps.has_neon) {
     return sampling_prob_f32_kernel(logits, vocab_size, token_id);
+  } else if (caps.has_avx2) {
+    return sampling_prob_f32_kernel_avx2(logits, vocab_size, token_id);
   } else {
     return sampling_prob_f32_scalar(logits, vocab_size, token_id);
   }
 }
+
+bool sampling_probs_f32(sampling_workspace_t *ws, const float *logits,
+                        float *probs, int vocab_size, float temperature,
+                        int top_k, float top_p, float min_p) {
+  if (temperature == 0.0f) {
+    int best =
+        sample_argmax_parallel(logits, vocab_size, sampling_get_capabilities());
+    memset(probs, 0, (size_t)vocab_size * sizeof(float));
+    probs[best] = 1.0f;
+    return true;
+  }
+  if (!workspace_reserve(ws, vocab_size))
+    return false;
+
+  bool dense;
+  float sum;
+  int n = pipeline_weights(ws, logits, vocab_size, temperature, top_k, top_p,
+                           min_p, &dense, &sum);
+  float inv_sum = sum > 0.0f ? 1.0f / sum : 0.0f;
+  if (dense) {
+    for (int i = 0; i < vocab_size; i++)
+      probs[i] = ws->probs[i] * inv_sum;
+    return true;
+  }
+  memset(probs, 0, (size_t)vocab_size * sizeof(float));
+  for (int i = 0; i < n; i++)
+    probs[ws->candidates[i].idx] = ws->probs[i] * inv_sum;
+  return true;
+}
+
+int sampling_sample_probs_f32(const float *probs, int vocab_size,
+                              sampling_rng_t *rng) {
+  return sample_from_distribution(probs, vocab_size,
+                                  random_f32(&rng->rng_state));
+}
@@ -5,6 +5,7 @@
 #ifndef SAMPLING_H
 #define SAMPLING_H
 
+#include <stdbool.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -18,8 +19,30 @@ typedef struct {
 void sampling_rng_init(sampling_rng_t *rng, unsigned long long seed);
 float sampling_rng_f32(sampling_rng_t *rng);
 
+typedef struct {
+  float prob;
+  int idx;
+} sampling_candidate_t;
+
+/*
+ * Scratch for the sampler pipeline, reused from token to token so that
+ * sampling allocates nothing. A zeroed workspace is valid and grows on first
+ * use; one workspace must not be shared between threads.
+ */
+typedef struct {
+  float *probs;                     /* [capacity] */
+  sampling_candidate_t *candidates; /* [capacity] */
+  int capacity;
+} sampling_workspace_t;
+
+/* Size a workspace for vocab_size tokens; false if allocation fails */
+bool sampling_workspace_init(sampling_workspace_t *ws, int vocab_size);
+void sampling_workspace_free(sampling_workspace_t *ws);
+
 /*
- * Sample a token from logits using temperature, top-k, and top-p
+ * Sample a token from logits using temperature, top-k, and top-p. Scratch
+ * is allocated per call; decode loops keep a workspace and use
+ * sampling_sample_ws_f32() instead.
  *
  * Parameters:
  *   logits:      [vocab_size] input logits
@@ -37,6 +60,39 @@ int sampling_sample_f32(const float *logits, int vocab_size, float temperature,
                         int top_k, float top_p, float min_p,
                         sampling_rng_t *rng);
 
+/*
+ * As sampling_sample_f32(), with scratch from a workspace. Cost is O(V) plus
+ * sorting the tokens that survive top-k/top-p, instead of sorting the whole
+ * vocabulary.
+ */
+int sampling_sample_ws_f32(sampling_workspace_t *ws, const float *logits,
+                           int vocab_size, float temperature, int top_k,
+                           float top_p, float min_p, sampling_rng_t *rng);
+
+/*
+ * Write the distribution sampling_sample_f32() draws from: softmax of the
+ * logits after min-p, top-k, top-p and temperature, normalized to sum to 1.
+ * Temperature 0 gives all of the mass to the argmax.
+ *
+ * Parameters:
+ *   ws:          sampler workspace
+ *   logits:      [vocab_size] input logits
+ *   probs:       [vocab_size] output probabilities, may alias logits
+ *   vocab_size, temperature, top_k, top_p, min_p: as for sampling_sample_f32
+ *
+ * Returns: false if the workspace could not grow to vocab_size
+ */
+bool sampling_probs_f32(sampling_workspace_t *ws, const float *logits,
+                        float *probs, int vocab_size, float temperature,
+                        int top_k, float top_p, float min_p);
+
+/*
+ * Draw a token from a normalized distribution such as sampling_probs_f32()
+ * writes. Tokens with zero probability are never returned unless all are.
+ */
+int sampling_sample_probs_f32(const float *probs, int vocab_size,
+                              sampling_rng_t *rng);
+
 /*
  * Compute probability of a specific token from logits
  *
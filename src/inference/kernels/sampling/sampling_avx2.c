@@ -0,0 +1,431 @@
+/*
+ * Token Sampling - AVX2/FMA Optimized Implementation
+ *
+ * Same filter order and RNG as the NEON/scalar paths (softmax -> min_p ->
+ * top_k -> top_p -> temperature -> sample), with the O(V) reductions and the
+ * exponentials vectorized.
+ */
+
+#include "inference/kernels/sampling/sampling_kernels.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+static unsigned int random_u32(unsigned long long *s) {
+  *s ^= *s >> 12;
+  *s ^= *s << 25;
+  *s ^= *s >> 27;
+  return (*s * 0x2545F4914F6CDD1DULL) >> 32;
+}
+
+static float random_f32(unsigned long long *s) {
+  return (random_u32(s) >> 8) / 16777216.0f;
+}
+
+static inline __m256 exp256_ps(__m256 x) {
+  const __m256 exp_hi = _mm256_set1_ps(88.3762626647949f);
+  const __m256 exp_lo = _mm256_set1_ps(-88.3762626647949f);
+  const __m256 log2e = _mm256_set1_ps(1.44269504088896341f);
+  const __m256 c1 = _mm256_set1_ps(0.693359375f);
+  const __m256 c2 = _mm256_set1_ps(-2.12194440e-4f);
+
+  x = _mm256_min_ps(_mm256_max_ps(x, exp_lo), exp_hi);
+
+  __m256 fx = _mm256_fmadd_ps(x, log2e, _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, c1, x);
+  x = _mm256_fnmadd_ps(fx, c2, x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+static inline float hmax256_ps(__m256 v) {
+  __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+  m = _mm_max_ss(m, _mm_movehdup_ps(m));
+  return _mm_cvtss_f32(m);
+}
+
+static inline float hsum256_ps(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+static float compute_max_logit_avx2(const float *logits, int vocab_size) {
+  __m256 max0 = _mm256_set1_ps(-FLT_MAX);
+  __m256 max1 = _mm256_set1_ps(-FLT_MAX);
+  int i = 0;
+
+  for (; i + 16 <= vocab_size; i += 16) {
+    max0 = _mm256_max_ps(max0, _mm256_loadu_ps(logits + i));
+    max1 = _mm256_max_ps(max1, _mm256_loadu_ps(logits + i + 8));
+  }
+  for (; i + 8 <= vocab_size; i += 8)
+    max0 = _mm256_max_ps(max0, _mm256_loadu_ps(logits + i));
+
+  float max_val = hmax256_ps(_mm256_max_ps(max0, max1));
+  for (; i < vocab_size; i++) {
+    if (logits[i] > max_val)
+      max_val = logits[i];
+  }
+  return max_val;
+}
+
+static float compute_sum_avx2(const float *probs, int vocab_size) {
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 16 <= vocab_size; i += 16) {
+    sum0 = _mm256_add_ps(sum0, _mm256_loadu_ps(probs + i));
+    sum1 = _mm256_add_ps(sum1, _mm256_loadu_ps(probs + i + 8));
+  }
+  for (; i + 8 <= vocab_size; i += 8)
+    sum0 = _mm256_add_ps(sum0, _mm256_loadu_ps(probs + i));
+
+  float sum = hsum256_ps(_mm256_add_ps(sum0, sum1));
+  for (; i < vocab_size; i++)
+    sum += probs[i];
+  return sum;
+}
+
+static void normalize_probs_avx2(float *probs, int vocab_size, float sum) {
+  if (sum == 0.0f)
+    return;
+  float inv_sum = 1.0f / sum;
+  __m256 inv_v = _mm256_set1_ps(inv_sum);
+  int i = 0;
+
+  for (; i + 8 <= vocab_size; i += 8)
+    _mm256_storeu_ps(probs + i,
+                     _mm256_mul_ps(_mm256_loadu_ps(probs + i), inv_v));
+  for (; i < vocab_size; i++)
+    probs[i] *= inv_sum;
+}
+
+static void apply_temperature(float *probs, int vocab_size,
+                              float temperature) {
+  if (temperature == 1.0f)
+    return;
+  float inv_temp = 1.0f / temperature;
+  for (int i = 0; i < vocab_size; i++) {
+    if (probs[i] > 0.0f)
+      probs[i] = powf(probs[i], inv_temp);
+  }
+}
+
+/* First index of the maximum, matching the scalar strict '>' scan */
+static int sample_argmax_avx2(const float *logits, int vocab_size) {
+  float max_val = compute_max_logit_avx2(logits, vocab_size);
+  __m256 max_v = _mm256_set1_ps(max_val);
+  int i = 0;
+
+  for (; i + 8 <= vocab_size; i += 8) {
+    __m256 eq = _mm256_cmp_ps(_mm256_loadu_ps(logits + i), max_v, _CMP_EQ_OQ);
+    int bits = _mm256_movemask_ps(eq);
+    if (bits)
+      return i + __builtin_ctz((unsigned)bits);
+  }
+  for (; i < vocab_size; i++) {
+    if (logits[i] == max_val)
+      return i;
+  }
+  return 0;
+}
+
+static int sample_from_distribution(const float *probs, int vocab_size,
+                                    float random_val) {
+  float cumsum = 0.0f;
+  for (int i = 0; i < vocab_size; i++) {
+    cumsum += probs[i];
+    if (random_val < cumsum)
+      return i;
+  }
+  return vocab_size - 1;
+}
+
+/* probs = exp(logits - max); returns the sum */
+static float compute_softmax_avx2(float *probs, const float *logits,
+                                  int vocab_size, float max_logit) {
+  __m256 max_b = _mm256_set1_ps(max_logit);
+  __m256 sum_v = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 8 <= vocab_size; i += 8) {
+    __m256 e = exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(logits + i), max_b));
+    _mm256_storeu_ps(probs + i, e);
+    sum_v = _mm256_add_ps(sum_v, e);
+  }
+
+  float sum = hsum256_ps(sum_v);
+  for (; i < vocab_size; i++) {
+    probs[i] = expf(logits[i] - max_logit);
+    sum += probs[i];
+  }
+  return sum;
+}
+
+typedef struct {
+  float prob;
+  int idx;
+} prob_idx_t;
+
+static int apply_top_k(float *probs, int vocab_size, int top_k) {
+  if (top_k <= 0 || top_k >= vocab_size)
+    return vocab_size;
+
+  prob_idx_t *candidates =
+      (prob_idx_t *)malloc(vocab_size * sizeof(prob_idx_t));
+  if (!candidates)
+    return vocab_size;
+  for (int i = 0; i < vocab_size; i++) {
+    candidates[i].prob = probs[i];
+    candidates[i].idx = i;
+  }
+
+  for (int i = 0; i < top_k; i++) {
+    int max_idx = i;
+    for (int j = i + 1; j < vocab_size; j++) {
+      if (candidates[j].prob > candidates[max_idx].prob)
+        max_idx = j;
+    }
+    prob_idx_t tmp = candidates[i];
+    candidates[i] = candidates[max_idx];
+    candidates[max_idx] = tmp;
+  }
+
+  memset(probs, 0, vocab_size * sizeof(float));
+  for (int i = 0; i < top_k; i++)
+    probs[candidates[i].idx] = candidates[i].prob;
+
+  free(candidates);
+  return top_k;
+}
+
+static int apply_top_p(float *probs, int vocab_size, float top_p) {
+  if (top_p >= 1.0f)
+    return vocab_size;
+
+  prob_idx_t *sorted = (prob_idx_t *)malloc(vocab_size * sizeof(prob_idx_t));
+  if (!sorted)
+    return vocab_size;
+  int count = 0;
+  for (int i = 0; i < vocab_size; i++) {
+    if (probs[i] > 0.0f) {
+      sorted[count].prob = probs[i];
+      sorted[count].idx = i;
+      count++;
+    }
+  }
+
+  for (int i = 0; i < count - 1; i++) {
+    for (int j = i + 1; j < count; j++) {
+      if (sorted[j].prob > sorted[i].prob) {
+        prob_idx_t tmp = sorted[i];
+        sorted[i] = sorted[j];
+        sorted[j] = tmp;
+      }
+    }
+  }
+
+  float cumsum = 0.0f;
+  int keep_count = 0;
+  for (int i = 0; i < count; i++) {
+    cumsum += sorted[i].prob;
+    keep_count++;
+    if (cumsum >= top_p)
+      break;
+  }
+
+  memset(probs, 0, vocab_size * sizeof(float));
+  for (int i = 0; i < keep_count; i++)
+    probs[sorted[i].idx] = sorted[i].prob;
+
+  free(sorted);
+  return keep_count;
+}
+
+static int apply_min_p(float *probs, int vocab_size, float min_p) {
+  if (min_p <= 0.0f)
+    return vocab_size;
+
+  float threshold = compute_max_logit_avx2(probs, vocab_size) * min_p;
+  __m256 thr_v = _mm256_set1_ps(threshold);
+  int keep_count = 0;
+  int i = 0;
+
+  for (; i + 8 <= vocab_size; i += 8) {
+    __m256 p = _mm256_loadu_ps(probs + i);
+    __m256 keep = _mm256_cmp_ps(p, thr_v, _CMP_GE_OQ);
+    _mm256_storeu_ps(probs + i, _mm256_and_ps(p, keep));
+    keep_count += __builtin_popcount((unsigned)_mm256_movemask_ps(keep));
+  }
+  for (; i < vocab_size; i++) {
+    if (probs[i] < threshold)
+      probs[i] = 0.0f;
+    else
+      keep_count++;
+  }
+
+  return keep_count;
+}
+
+int sampling_sample_f32_kernel_avx2(const float *logits, int vocab_size,
+                                    float temperature, int top_k, float top_p,
+                                    float min_p,
+                                    unsigned long long *rng_state) {
+  if (temperature == 0.0f)
+    return sample_argmax_avx2(logits, vocab_size);
+
+  float max_logit = compute_max_logit_avx2(logits, vocab_size);
+
+  float *probs = (float *)malloc(vocab_size * sizeof(float));
+  if (!probs)
+    return sample_argmax_avx2(logits, vocab_size);
+  compute_softmax_avx2(probs, logits, vocab_size, max_logit);
+
+  if (min_p > 0.0f)
+    apply_min_p(probs, vocab_size, min_p);
+
+  if (top_k > 0)
+    apply_top_k(probs, vocab_size, top_k);
+
+  if (top_p < 1.0f) {
+    float sum = compute_sum_avx2(probs, vocab_size);
+    normalize_probs_avx2(probs, vocab_size, sum);
+    apply_top_p(probs, vocab_size, top_p);
+  }
+
+  apply_temperature(probs, vocab_size, temperature);
+
+  float sum = compute_sum_avx2(probs, vocab_size);
+  normalize_probs_avx2(probs, vocab_size, sum);
+
+  float random_val = random_f32(rng_state);
+  int sampled = sample_from_distribution(probs, vocab_size, random_val);
+
+  free(probs);
+  return sampled;
+}
+
+float sampling_prob_f32_kernel_avx2(const float *logits, int vocab_size,
+                                    int token_id) {
+  if (token_id < 0 || token_id >= vocab_size)
+    return 0.0f;
+
+  float max_logit = compute_max_logit_avx2(logits, vocab_size);
+  __m256 max_b = _mm256_set1_ps(max_logit);
+  __m256 sum_v = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 8 <= vocab_size; i += 8)
+    sum_v = _mm256_add_ps(
+        sum_v, exp256_ps(_mm256_sub_ps(_mm256_loadu_ps(logits + i), max_b)));
+
+  float sum = hsum256_ps(sum_v);
+  for (; i < vocab_size; i++)
+    sum += expf(logits[i] - max_logit);
+
+  if (sum == 0.0f)
+    return 0.0f;
+
+  return expf(logits[token_id] - max_logit) / sum;
+}
+
+float sampling_max_f32_kernel_avx2(const float *x, int n) {
+  return compute_max_logit_avx2(x, n);
+}
+
+float sampling_exp_f32_kernel_avx2(float *out, const float *x, int n,
+                                   float max, float scale) {
+  __m256 max_b = _mm256_set1_ps(max);
+  __m256 scale_b = _mm256_set1_ps(scale);
+  __m256 sum0 = _mm256_setzero_ps();
+  __m256 sum1 = _mm256_setzero_ps();
+  int i = 0;
+
+  for (; i + 16 <= n; i += 16) {
+    __m256 e0 = exp256_ps(
+        _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), max_b), scale_b));
+    __m256 e1 = exp256_ps(_mm256_mul_ps(
+        _mm256_sub_ps(_mm256_loadu_ps(x + i + 8), max_b), scale_b));
+    _mm256_storeu_ps(out + i, e0);
+    _mm256_storeu_ps(out + i + 8, e1);
+    sum0 = _mm256_add_ps(sum0, e0);
+    sum1 = _mm256_add_ps(sum1, e1);
+  }
+  for (; i + 8 <= n; i += 8) {
+    __m256 e = exp256_ps(
+        _mm256_mul_ps(_mm256_sub_ps(_mm256_loadu_ps(x + i), max_b), scale_b));
+    _mm256_storeu_ps(out + i, e);
+    sum0 = _mm256_add_ps(sum0, e);
+  }
+
+  float sum = hsum256_ps(_mm256_add_ps(sum0, sum1));
+  for (; i < n; i++) {
+    out[i] = expf((x[i] - max) * scale);
+    sum += out[i];
+  }
+  return sum;
+}
+
+#else
+
+int sampling_sample_f32_kernel_avx2(const float *logits, int vocab_size,
+                                    float temperature, int top_k, float top_p,
+                                    float min_p,
+                                    unsigned long long *rng_state) {
+  (void)logits;
+  (void)vocab_size;
+  (void)temperature;
+  (void)top_k;
+  (void)top_p;
+  (void)min_p;
+  (void)rng_state;
+  return 0;
+}
+
+float sampling_prob_f32_kernel_avx2(const float *logits, int vocab_size,
+                                    int token_id) {
+  (void)logits;
+  (void)vocab_size;
+  (void)token_id;
+  return 0.0f;
+}
+
+float sampling_max_f32_kernel_avx2(const float *x, int n) {
+  (void)x;
+  (void)n;
+  return 0.0f;
+}
+
+float sampling_exp_f32_kernel_avx2(float *out, const float *x, int n,
+                                   float max, float scale) {
+  (void)out;
+  (void)x;
+  (void)n;
+  (void)max;
+  (void)scale;
+  return 0.0f;
+}
+
+#endif
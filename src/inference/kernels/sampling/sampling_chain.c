@@ -0,0 +1,634 @@
+/*
+ * Sampler Chain - Implementation
+ */
+
+#include "inference/kernels/sampling/sampling_chain.h"
+#include <float.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Candidates are the tokens within this many temperature-scaled nats of the
+ * best one; anything further holds under 1e-13 of the mass per token
+ */
+#define CHAIN_LOGIT_FLOOR 30.0f
+
+/* Tokens mirostat 1 fits its Zipf exponent on */
+#define CHAIN_MIROSTAT_M 100
+
+typedef struct {
+  float logit;
+  float prob;
+  float score;
+  int idx;
+} chain_cand_t;
+
+struct sampling_chain {
+  sampling_chain_params_t params;
+  int vocab_size;
+  int max_tokens;
+  sampling_workspace_t ws;
+  float *logits;       /* [vocab_size] penalized copy of the input */
+  chain_cand_t *cands; /* [vocab_size] */
+  float mirostat_mu;
+  int sampled;
+
+  int *history; /* [max_tokens] */
+  int len;
+
+  /* Penalty window */
+  int *counts;    /* [vocab_size] occurrences in the window */
+  int *seen;      /* Distinct tokens in the window */
+  int *seen_slot; /* [vocab_size] index into seen, -1 if absent */
+  int num_seen;
+
+  /*
+   * DRY: match[j], for j an earlier occurrence of the newest token, is the
+   * length of the common suffix of history[0..j] and the whole history
+   */
+  int *last_pos; /* [vocab_size] latest position of each token, -1 */
+  int *prev_pos; /* [max_tokens] previous position of the same token */
+  int *match;    /* [max_tokens] */
+  int *dry_len;  /* [vocab_size] scratch: longest match before each token */
+  int *dry_tokens;
+};
+
+void sampling_chain_params_init(sampling_chain_params_t *params) {
+  memset(params, 0, sizeof(*params));
+  params->temperature = 1.0f;
+  params->top_p = 1.0f;
+  params->typical_p = 1.0f;
+  params->tfs = 1.0f;
+  params->xtc_threshold = 0.1f;
+  params->dynatemp_exponent = 1.0f;
+  params->repetition_penalty = 1.0f;
+  params->dry_base = 1.75f;
+  params->dry_allowed_length = 2;
+  params->eos_token_id = -1;
+}
+
+static bool dry_enabled(const sampling_chain_t *chain) {
+  return chain->params.dry_multiplier > 0.0f && chain->params.dry_base > 1.0f;
+}
+
+static bool penalties_enabled(const sampling_chain_params_t *p) {
+  return p->repetition_penalty != 1.0f || p->frequency_penalty != 0.0f ||
+         p->presence_penalty != 0.0f;
+}
+
+sampling_chain_t *sampling_chain_create(const sampling_chain_params_t *params,
+                                        int vocab_size, int max_tokens) {
+  if (!params || vocab_size <= 0 || max_tokens <= 0)
+    return NULL;
+  sampling_chain_t *chain =
+      (sampling_chain_t *)calloc(1, sizeof(sampling_chain_t));
+  if (!chain)
+    return NULL;
+  chain->params = *params;
+  if (chain->params.num_dry_breakers > SAMPLING_CHAIN_MAX_BREAKERS)
+    chain->params.num_dry_breakers = SAMPLING_CHAIN_MAX_BREAKERS;
+  chain->vocab_size = vocab_size;
+  chain->max_tokens = max_tokens;
+
+  size_t V = (size_t)vocab_size;
+  size_t T = (size_t)max_tokens;
+  bool ok = sampling_workspace_init(&chain->ws, vocab_size);
+  chain->logits = (float *)malloc(V * sizeof(float));
+  chain->cands = (chain_cand_t *)malloc(V * sizeof(chain_cand_t));
+  chain->history = (int *)malloc(T * sizeof(int));
+  chain->counts = (int *)malloc(V * sizeof(int));
+  chain->seen = (int *)malloc(V * sizeof(int));
+  chain->seen_slot = (int *)malloc(V * sizeof(int));
+  chain->last_pos = (int *)malloc(V * sizeof(int));
+  chain->prev_pos = (int *)malloc(T * sizeof(int));
+  chain->match = (int *)malloc(T * sizeof(int));
+  chain->dry_len = (int *)calloc(V, sizeof(int));
+  chain->dry_tokens = (int *)malloc(V * sizeof(int));
+  if (!ok || !chain->logits || !chain->cands || !chain->history ||
+      !chain->counts || !chain->seen || !chain->seen_slot ||
+      !chain->last_pos || !chain->prev_pos || !chain->match ||
+      !chain->dry_len || !chain->dry_tokens) {
+    sampling_chain_free(chain);
+    return NULL;
+  }
+  sampling_chain_reset(chain);
+  return chain;
+}
+
+void sampling_chain_free(sampling_chain_t *chain) {
+  if (!chain)
+    return;
+  sampling_workspace_free(&chain->ws);
+  free(chain->logits);
+  free(chain->cands);
+  free(chain->history);
+  free(chain->counts);
+  free(chain->seen);
+  free(chain->seen_slot);
+  free(chain->last_pos);
+  free(chain->prev_pos);
+  free(chain->match);
+  free(chain->dry_len);
+  free(chain->dry_tokens);
+  free(chain);
+}
+
+void sampling_chain_reset(sampling_chain_t *chain) {
+  size_t V = (size_t)chain->vocab_size;
+  memset(chain->counts, 0, V * sizeof(int));
+  memset(chain->seen_slot, 0xff, V * sizeof(int));
+  memset(chain->last_pos, 0xff, V * sizeof(int));
+  chain->num_seen = 0;
+  chain->len = 0;
+  chain->sampled = 0;
+  chain->mirostat_mu = 2.0f * chain->params.mirostat_tau;
+}
+
+int sampling_chain_length(const sampling_chain_t *chain) {
+  return chain->len;
+}
+
+static bool is_breaker(const sampling_chain_t *chain, int token) {
+  for (int i = 0; i < chain->params.num_dry_breakers; i++) {
+    if (chain->params.dry_breakers[i] == token)
+      return true;
+  }
+  return false;
+}
+
+static void count_token(sampling_chain_t *chain, int token, int delta) {
+  int count = chain->counts[token] += delta;
+  if (count == 1 && delta > 0) {
+    chain->seen_slot[token] = chain->num_seen;
+    chain->seen[chain->num_seen++] = token;
+  } else if (count == 0) {
+    int slot = chain->seen_slot[token];
+    int last = chain->seen[--chain->num_seen];
+    chain->seen[slot] = last;
+    chain->seen_slot[last] = slot;
+    chain->seen_slot[token] = -1;
+  }
+}
+
+/* Earliest position DRY looks at while the history ends at pos */
+static int dry_start(const sampling_chain_t *chain, int pos) {
+  int range = chain->params.dry_range;
+  return range > 0 && pos - range > 0 ? pos - range : 0;
+}
+
+/*
+ * Extend the DRY matches by the token now at position n: an earlier
+ * occurrence j continues the match that ended at j - 1 when the token
+ * before it equals the one before n
+ */
+static void dry_update(sampling_chain_t *chain, int n) {
+  int *h = chain->history;
+  int token = h[n];
+  if (!is_breaker(chain, token)) {
+    int start = dry_start(chain, n);
+    bool extend = n > 0 && !is_breaker(chain, h[n - 1]);
+    for (int j = chain->last_pos[token]; j >= start; j = chain->prev_pos[j]) {
+      int prev = 0;
+      if (extend && j > 0 && h[j - 1] == h[n - 1])
+        prev = chain->match[j - 1];
+      chain->match[j] = prev + 1;
+    }
+  }
+  chain->prev_pos[n] = chain->last_pos[token];
+  chain->last_pos[token] = n;
+}
+
+bool sampling_chain_accept(sampling_chain_t *chain, const int *tokens,
+                           int num_tokens) {
+  const sampling_chain_params_t *p = &chain->params;
+  for (int i = 0; i < num_tokens; i++) {
+    int token = tokens[i];
+    if (chain->len >= chain->max_tokens || token < 0 ||
+        token >= chain->vocab_size)
+      return false;
+    int n = chain->len++;
+    chain->history[n] = token;
+
+    count_token(chain, token, 1);
+    if (p->penalty_range > 0 && n >= p->penalty_range)
+      count_token(chain, chain->history[n - p->penalty_range], -1);
+
+    if (dry_enabled(chain))
+      dry_update(chain, n);
+  }
+  return true;
+}
+
+static void apply_penalties(sampling_chain_t *chain) {
+  const sampling_chain_params_t *p = &chain->params;
+  float *logits = chain->logits;
+  for (int i = 0; i < chain->num_seen; i++) {
+    int token = chain->seen[i];
+    float l = logits[token];
+    if (p->repetition_penalty != 1.0f)
+      l = l > 0.0f ? l / p->repetition_penalty : l * p->repetition_penalty;
+    l -= (float)chain->counts[token] * p->frequency_penalty;
+    l -= p->presence_penalty;
+    logits[token] = l;
+  }
+}
+
+/*
+ * Penalize each token that would continue a repeat of at least
+ * dry_allowed_length tokens by multiplier * base^(length - allowed)
+ */
+static void apply_dry(sampling_chain_t *chain) {
+  const sampling_chain_params_t *p = &chain->params;
+  int n = chain->len - 1;
+  if (n < 1 || is_breaker(chain, chain->history[n]))
+    return;
+
+  int start = dry_start(chain, n);
+  int num_tokens = 0;
+  for (int j = chain->prev_pos[n]; j >= start; j = chain->prev_pos[j]) {
+    int next = chain->history[j + 1];
+    if (is_breaker(chain, next))
+      continue;
+    if (chain->dry_len[next] == 0)
+      chain->dry_tokens[num_tokens++] = next;
+    if (chain->match[j] > chain->dry_len[next])
+      chain->dry_len[next] = chain->match[j];
+  }
+
+  float max_exponent = logf(FLT_MAX / p->dry_multiplier) / logf(p->dry_base);
+  for (int i = 0; i < num_tokens; i++) {
+    int token = chain->dry_tokens[i];
+    int length = chain->dry_len[token];
+    chain->dry_len[token] = 0;
+    if (length < p->dry_allowed_length)
+      continue;
+    float exponent = (float)(length - p->dry_allowed_length);
+    if (exponent > max_exponent)
+      exponent = max_exponent;
+    chain->logits[token] -= p->dry_multiplier * powf(p->dry_base, exponent);
+  }
+}
+
+static bool uses_extended(const sampling_chain_params_t *p) {
+  return p->typical_p < 1.0f || p->tfs < 1.0f || p->top_a > 0.0f ||
+         p->nsigma > 0.0f || p->xtc_probability > 0.0f ||
+         p->smoothing_factor > 0.0f || p->dynatemp_max > p->dynatemp_min ||
+         p->mirostat_mode == 1 || p->mirostat_mode == 2;
+}
+
+/* ---- Candidate stages, over the tokens that survived so far ---- */
+
+static int compare_prob_desc(const void *a, const void *b) {
+  float pa = ((const chain_cand_t *)a)->prob;
+  float pb = ((const chain_cand_t *)b)->prob;
+  return (pa < pb) - (pa > pb);
+}
+
+static int compare_score_asc(const void *a, const void *b) {
+  float sa = ((const chain_cand_t *)a)->score;
+  float sb = ((const chain_cand_t *)b)->score;
+  return (sa > sb) - (sa < sb);
+}
+
+static void swap_cands(chain_cand_t *a, chain_cand_t *b) {
+  chain_cand_t tmp = *a;
+  *a = *b;
+  *b = tmp;
+}
+
+/* Move the m most probable candidates to the front, unordered */
+static void select_largest(chain_cand_t *c, int n, int m) {
+  int lo = 0;
+  int hi = n - 1;
+  while (lo < hi) {
+    float pivot = c[lo + (hi - lo) / 2].prob;
+    int i = lo;
+    int j = hi;
+    while (i <= j) {
+      while (c[i].prob > pivot)
+        i++;
+      while (c[j].prob < pivot)
+        j--;
+      if (i <= j)
+        swap_cands(&c[i++], &c[j--]);
+    }
+    if (m - 1 <= j)
+      hi = j;
+    else if (m - 1 >= i)
+      lo = i;
+    else
+      return;
+  }
+}
+
+/* prob = softmax(logit / temperature) over the candidates */
+static void softmax(chain_cand_t *c, int n, float temperature) {
+  float max = -INFINITY;
+  for (int i = 0; i < n; i++)
+    max = c[i].logit > max ? c[i].logit : max;
+  float inv_temp = 1.0f / temperature;
+  float sum = 0.0f;
+  for (int i = 0; i < n; i++) {
+    c[i].prob = expf((c[i].logit - max) * inv_temp);
+    sum += c[i].prob;
+  }
+  for (int i = 0; i < n; i++)
+    c[i].prob /= sum;
+}
+
+static void renormalize(chain_cand_t *c, int n) {
+  float sum = 0.0f;
+  for (int i = 0; i < n; i++)
+    sum += c[i].prob;
+  if (sum > 0.0f) {
+    for (int i = 0; i < n; i++)
+      c[i].prob /= sum;
+  }
+}
+
+/* Keep the candidates flagged by keep(), in order; always keeps one */
+#define FILTER_CANDS(c, n, keep_expr)                                          \
+  do {                                                                         \
+    int kept_ = 0;                                                             \
+    for (int i = 0; i < (n); i++) {                                            \
+      if (keep_expr)                                                           \
+        (c)[kept_++] = (c)[i];                                                 \
+    }                                                                          \
+    if (kept_ > 0) {                                                           \
+      (n) = kept_;                                                             \
+      renormalize((c), (n));                                                   \
+    }                                                                          \
+  } while (0)
+
+/* Tail-free sampling on candidates sorted by probability */
+static int apply_tfs(chain_cand_t *c, int n, float z) {
+  if (n <= 2)
+    return n;
+  float sum = 0.0f;
+  for (int i = 0; i < n - 2; i++) {
+    float d = (c[i].prob - c[i + 1].prob) - (c[i + 1].prob - c[i + 2].prob);
+    c[i].score = fabsf(d);
+    sum += c[i].score;
+  }
+  if (sum <= 0.0f)
+    return n;
+  float cumsum = 0.0f;
+  for (int i = 0; i < n - 2; i++) {
+    cumsum += c[i].score / sum;
+    if (cumsum > z && i >= 1) {
+      renormalize(c, i);
+      return i;
+    }
+  }
+  return n;
+}
+
+/* Locally typical sampling; leaves the candidates sorted by probability */
+static int apply_typical(chain_cand_t *c, int n, float typical_p) {
+  float entropy = 0.0f;
+  for (int i = 0; i < n; i++) {
+    if (c[i].prob > 0.0f)
+      entropy -= c[i].prob * logf(c[i].prob);
+  }
+  for (int i = 0; i < n; i++) {
+    c[i].score =
+        c[i].prob > 0.0f ? fabsf(-logf(c[i].prob) - entropy) : INFINITY;
+  }
+  qsort(c, n, sizeof(*c), compare_score_asc);
+
+  float cumsum = 0.0f;
+  int keep = n;
+  for (int i = 0; i < n; i++) {
+    cumsum += c[i].prob;
+    if (cumsum >= typical_p) {
+      keep = i + 1;
+      break;
+    }
+  }
+  qsort(c, keep, sizeof(*c), compare_prob_desc);
+  renormalize(c, keep);
+  return keep;
+}
+
+/* Top-p on candidates sorted by probability */
+static int apply_top_p(chain_cand_t *c, int n, float top_p) {
+  float cumsum = 0.0f;
+  for (int i = 0; i < n; i++) {
+    cumsum += c[i].prob;
+    if (cumsum >= top_p) {
+      renormalize(c, i + 1);
+      return i + 1;
+    }
+  }
+  return n;
+}
+
+static float max_prob(const chain_cand_t *c, int n) {
+  float max = 0.0f;
+  for (int i = 0; i < n; i++)
+    max = c[i].prob > max ? c[i].prob : max;
+  return max;
+}
+
+/* Exclude Top Choices: drop every token above threshold but the last one */
+static int apply_xtc(chain_cand_t *c, int n, float threshold) {
+  int above = 0;
+  float least = INFINITY;
+  for (int i = 0; i < n; i++) {
+    if (c[i].prob >= threshold) {
+      above++;
+      least = c[i].prob < least ? c[i].prob : least;
+    }
+  }
+  if (above < 2)
+    return n;
+  FILTER_CANDS(c, n, c[i].prob < threshold || c[i].prob == least);
+  return n;
+}
+
+static int sample_cands(const chain_cand_t *c, int n, sampling_rng_t *rng) {
+  float sum = 0.0f;
+  for (int i = 0; i < n; i++)
+    sum += c[i].prob;
+  float target = sampling_rng_f32(rng) * sum;
+  float cumsum = 0.0f;
+  for (int i = 0; i < n; i++) {
+    cumsum += c[i].prob;
+    if (target < cumsum)
+      return i;
+  }
+  return n - 1;
+}
+
+/* Mirostat: truncate to the target surprise, then track the observed one */
+static int sample_mirostat(sampling_chain_t *chain, chain_cand_t *c, int n,
+                           sampling_rng_t *rng) {
+  const sampling_chain_params_t *p = &chain->params;
+  softmax(c, n, p->temperature);
+
+  if (p->mirostat_mode == 1) {
+    /* Fit the Zipf exponent on the head, then pick k for the target */
+    int m = n < CHAIN_MIROSTAT_M ? n : CHAIN_MIROSTAT_M;
+    select_largest(c, n, m);
+    qsort(c, m, sizeof(*c), compare_prob_desc);
+    float sum_ti_bi = 0.0f;
+    float sum_ti_sq = 0.0f;
+    for (int i = 0; i < m - 1; i++) {
+      if (c[i + 1].prob <= 0.0f)
+        break;
+      float t = logf((float)(i + 2) / (float)(i + 1));
+      float b = logf(c[i].prob / c[i + 1].prob);
+      sum_ti_bi += t * b;
+      sum_ti_sq += t * t;
+    }
+    int k = 1;
+    if (sum_ti_sq > 0.0f && sum_ti_bi > 0.0f) {
+      float s_hat = sum_ti_bi / sum_ti_sq;
+      float eps = s_hat - 1.0f;
+      float kf = powf(eps * powf(2.0f, chain->mirostat_mu) /
+                          (1.0f - powf((float)chain->vocab_size, -eps)),
+                      1.0f / s_hat);
+      if (kf > 1.0f)
+        k = kf < (float)n ? (int)kf : n;
+    }
+    if (k < n)
+      select_largest(c, n, k);
+    n = k;
+    renormalize(c, n);
+  } else {
+    float min_prob = exp2f(-chain->mirostat_mu);
+    int best = 0;
+    for (int i = 1; i < n; i++)
+      best = c[i].prob > c[best].prob ? i : best;
+    FILTER_CANDS(c, n, c[i].prob >= min_prob || i == best);
+  }
+
+  int i = sample_cands(c, n, rng);
+  float surprise = -log2f(c[i].prob > 0.0f ? c[i].prob : FLT_MIN);
+  chain->mirostat_mu -= p->mirostat_eta * (surprise - p->mirostat_tau);
+  return c[i].idx;
+}
+
+static int sample_extended(sampling_chain_t *chain, sampling_rng_t *rng) {
+  const sampling_chain_params_t *p = &chain->params;
+  const float *logits = chain->logits;
+  int V = chain->vocab_size;
+
+  float max = -INFINITY;
+  for (int i = 0; i < V; i++)
+    max = logits[i] > max ? logits[i] : max;
+
+  float spread = p->temperature > 1.0f ? p->temperature : 1.0f;
+  if (p->dynatemp_max > spread)
+    spread = p->dynatemp_max;
+  float cut = max - CHAIN_LOGIT_FLOOR * spread;
+
+  if (p->nsigma > 0.0f && p->mirostat_mode == 0) {
+    double sum = 0.0, sum_sq = 0.0;
+    int finite = 0;
+    for (int i = 0; i < V; i++) {
+      if (isfinite(logits[i])) {
+        sum += logits[i];
+        sum_sq += (double)logits[i] * logits[i];
+        finite++;
+      }
+    }
+    double mean = sum / (finite > 0 ? finite : 1);
+    double var = sum_sq / (finite > 0 ? finite : 1) - mean * mean;
+    float sigma_cut = max - p->nsigma * (float)sqrt(var > 0.0 ? var : 0.0);
+    cut = sigma_cut > cut ? sigma_cut : cut;
+  }
+  /* min-p commutes with the stages before it unless typical drops the top */
+  if (p->min_p > 0.0f && p->typical_p >= 1.0f && p->mirostat_mode == 0) {
+    float min_p_cut = max + logf(p->min_p);
+    cut = min_p_cut > cut ? min_p_cut : cut;
+  }
+
+  chain_cand_t *c = chain->cands;
+  int n = 0;
+  for (int i = 0; i < V; i++) {
+    c[n].logit = logits[i];
+    c[n].idx = i;
+    n += logits[i] >= cut;
+  }
+
+  if (p->mirostat_mode == 1 || p->mirostat_mode == 2)
+    return sample_mirostat(chain, c, n, rng);
+
+  softmax(c, n, 1.0f);
+  if (p->top_k > 0 && p->top_k < n) {
+    select_largest(c, n, p->top_k);
+    n = p->top_k;
+    renormalize(c, n);
+  }
+  if (p->tfs < 1.0f || p->typical_p < 1.0f || p->top_p < 1.0f)
+    qsort(c, n, sizeof(*c), compare_prob_desc);
+  if (p->tfs < 1.0f)
+    n = apply_tfs(c, n, p->tfs);
+  if (p->typical_p < 1.0f)
+    n = apply_typical(c, n, p->typical_p);
+  if (p->top_p < 1.0f)
+    n = apply_top_p(c, n, p->top_p);
+  if (p->min_p > 0.0f) {
+    float threshold = p->min_p * max_prob(c, n);
+    FILTER_CANDS(c, n, c[i].prob >= threshold);
+  }
+  if (p->top_a > 0.0f) {
+    float top = max_prob(c, n);
+    float threshold = p->top_a * top * top;
+    FILTER_CANDS(c, n, c[i].prob >= threshold);
+  }
+  if (p->xtc_probability > 0.0f &&
+      sampling_rng_f32(rng) < p->xtc_probability)
+    n = apply_xtc(c, n, p->xtc_threshold);
+
+  /* Temperature stage: smoothing reshapes the logits around the maximum */
+  float top = -INFINITY;
+  for (int i = 0; i < n; i++)
+    top = c[i].logit > top ? c[i].logit : top;
+  if (p->smoothing_factor > 0.0f) {
+    for (int i = 0; i < n; i++) {
+      float d = c[i].logit - top;
+      c[i].logit = top - p->smoothing_factor * d * d;
+    }
+  }
+  float temperature = p->temperature;
+  if (p->dynatemp_max > p->dynatemp_min && n > 1) {
+    float entropy = 0.0f;
+    for (int i = 0; i < n; i++) {
+      if (c[i].prob > 0.0f)
+        entropy -= c[i].prob * logf(c[i].prob);
+    }
+    float ratio = entropy / logf((float)n);
+    temperature =
+        p->dynatemp_min + (p->dynatemp_max - p->dynatemp_min) *
+                              powf(ratio > 0.0f ? ratio : 0.0f,
+                                   p->dynatemp_exponent);
+    if (temperature <= 0.0f)
+      temperature = FLT_MIN;
+  }
+  softmax(c, n, temperature);
+  return c[sample_cands(c, n, rng)].idx;
+}
+
+int sampling_chain_sample(sampling_chain_t *chain, const float *logits,
+                          sampling_rng_t *rng) {
+  const sampling_chain_params_t *p = &chain->params;
+  int V = chain->vocab_size;
+  memcpy(chain->logits, logits, (size_t)V * sizeof(float));
+
+  if (penalties_enabled(p))
+    apply_penalties(chain);
+  if (dry_enabled(chain))
+    apply_dry(chain);
+  if (chain->sampled < p->min_tokens && p->eos_token_id >= 0 &&
+      p->eos_token_id < V)
+    chain->logits[p->eos_token_id] = -INFINITY;
+  chain->sampled++;
+
+  if (p->temperature > 0.0f && uses_extended(p))
+    return sample_extended(chain, rng);
+  return sampling_sample_ws_f32(&chain->ws, chain->logits, V, p->temperature,
+                                p->top_k, p->top_p, p->min_p, rng);
+}
@@ -0,0 +1,119 @@
+/*
+ * Sampler Chain - Public API
+ *
+ * The full text-completion sampler stack for local inference, with the
+ * settings SillyTavern exposes (see sampler_chain_params() in llm/sampler.h):
+ *
+ *   penalties (repetition, frequency, presence) -> DRY -> min_tokens ->
+ *   top-nsigma -> top-k -> TFS -> typical -> top-p -> min-p -> top-a ->
+ *   XTC -> smoothing / temperature / dynamic temperature -> sample
+ *
+ * with mirostat (mode 1 or 2) replacing the truncation samplers when set.
+ *
+ * A chain belongs to one sequence and is fed every token of it, prompt
+ * included, with sampling_chain_accept(). Its state is updated per accepted
+ * token instead of rescanning the history at every step:
+ *   - a token-count table plus the list of distinct tokens in the penalty
+ *     window, so penalties touch only tokens that occurred
+ *   - for DRY, the lengths of the matches between the context's suffix and
+ *     earlier text, extended by one token at a time through per-token
+ *     occurrence lists; only earlier occurrences of the newest token can
+ *     continue a match, so an update costs O(occurrences), not O(range)
+ * Without any of the extra samplers the chain reduces to the O(V) pipeline
+ * of sampling_sample_ws_f32().
+ */
+
+#ifndef SAMPLING_CHAIN_H
+#define SAMPLING_CHAIN_H
+
+#include "inference/kernels/sampling/sampling.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Most DRY sequence-breaker tokens a chain keeps */
+#define SAMPLING_CHAIN_MAX_BREAKERS 32
+
+typedef struct {
+  float temperature; /* 0 = greedy (after penalties) */
+  int top_k;         /* <= 0 = off */
+  float top_p;       /* 1 = off */
+  float min_p;       /* 0 = off */
+  float typical_p;   /* 1 = off */
+  float tfs;         /* Tail-free sampling z, 1 = off */
+  float top_a;       /* 0 = off */
+  float nsigma;      /* Top-nsigma, 0 = off */
+  float xtc_threshold;
+  float xtc_probability; /* 0 = off */
+  float smoothing_factor; /* Quadratic sampling, 0 = off */
+  float dynatemp_min;     /* Dynamic temperature range, off when equal */
+  float dynatemp_max;
+  float dynatemp_exponent;
+
+  float repetition_penalty; /* 1 = off */
+  float frequency_penalty;  /* 0 = off */
+  float presence_penalty;   /* 0 = off */
+  int penalty_range;        /* Tokens the penalties look back, 0 = all */
+
+  float dry_multiplier; /* 0 = off */
+  float dry_base;
+  int dry_allowed_length;
+  int dry_range; /* Tokens DRY looks back, 0 = all */
+  int dry_breakers[SAMPLING_CHAIN_MAX_BREAKERS]; /* Tokens matches stop at */
+  int num_dry_breakers;
+
+  int mirostat_mode; /* 0 = off, 1 or 2 */
+  float mirostat_tau;
+  float mirostat_eta;
+
+  int min_tokens;   /* EOS is banned until this many tokens were sampled */
+  int eos_token_id; /* -1 = none */
+} sampling_chain_params_t;
+
+typedef struct sampling_chain sampling_chain_t;
+
+/* Parameters with every sampler off and temperature 1 */
+void sampling_chain_params_init(sampling_chain_params_t *params);
+
+/*
+ * Create a chain for one sequence
+ *
+ * Parameters:
+ *   params:      sampler settings, copied
+ *   vocab_size:  vocabulary size
+ *   max_tokens:  longest history (prompt plus generated) the chain accepts
+ *
+ * Returns: NULL if allocation fails
+ */
+sampling_chain_t *sampling_chain_create(const sampling_chain_params_t *params,
+                                        int vocab_size, int max_tokens);
+void sampling_chain_free(sampling_chain_t *chain);
+
+/* Forget the history, counts and mirostat state */
+void sampling_chain_reset(sampling_chain_t *chain);
+
+/*
+ * Append tokens to the chain's history (the prompt, then every generated
+ * token). Returns false once the history would exceed max_tokens.
+ */
+bool sampling_chain_accept(sampling_chain_t *chain, const int *tokens,
+                           int num_tokens);
+
+/*
+ * Sample the next token from logits (left unmodified). The token is not
+ * accepted; pass it to sampling_chain_accept() once it is kept.
+ */
+int sampling_chain_sample(sampling_chain_t *chain, const float *logits,
+                          sampling_rng_t *rng);
+
+/* Tokens in the chain's history */
+int sampling_chain_length(const sampling_chain_t *chain);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -14,6 +14,7 @@ extern "C" {
 
 typedef struct {
   bool has_neon;
+  bool has_avx2;
 } sampling_caps_t;
 
 sampling_caps_t sampling_get_capabilities(void);
@@ -25,6 +26,27 @@ int sampling_sample_f32_kernel(const float *logits, int vocab_size,
 float sampling_prob_f32_kernel(const float *logits, int vocab_size,
                                int token_id);
 
+/*
+ * Streaming passes of the sampler pipeline: the maximum of x, and
+ * out = exp((x - max) * scale) returning the sum of out
+ */
+float sampling_max_f32_kernel(const float *x, int n);
+float sampling_exp_f32_kernel(float *out, const float *x, int n, float max,
+                              float scale);
+
+/* AVX2/FMA kernels (x86-64) */
+int sampling_sample_f32_kernel_avx2(const float *logits, int vocab_size,
+                                    float temperature, int top_k, float top_p,
+                                    float min_p,
+                                    unsigned long long *rng_state);
+
+float sampling_prob_f32_kernel_avx2(const float *logits, int vocab_size,
+                                    int token_id);
+
+float sampling_max_f32_kernel_avx2(const float *x, int n);
+float sampling_exp_f32_kernel_avx2(float *out, const float *x, int n,
+                                   float max, float scale);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,6 +19,7 @@
 sampling_caps_t sampling_get_capabilities(void) {
   sampling_caps_t caps = {0};
   caps.has_neon = caps_has(CAP_NEON);
+  caps.has_avx2 = caps_has(CAP_AVX2);
   return caps;
 }
 
@@ -382,6 +383,55 @@ float sampling_prob_f32_kernel(const float *logits, int vocab_size,
   return expf(logits[token_id] - max_logit) / sum;
 }
 
+static inline float32x4_t exp_f32x4(float32x4_t x) {
+  x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-88.3762626647949f)),
+                vdupq_n_f32(88.3762626647949f));
+
+  float32x4_t fx = vrndmq_f32(
+      vfmaq_f32(vdupq_n_f32(0.5f), x, vdupq_n_f32(1.44269504088896341f)));
+  x = vfmsq_f32(x, fx, vdupq_n_f32(0.693359375f));
+  x = vfmsq_f32(x, fx, vdupq_n_f32(-2.12194440e-4f));
+
+  float32x4_t y = vdupq_n_f32(1.9875691500e-4f);
+  y = vfmaq_f32(vdupq_n_f32(1.3981999507e-3f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(8.3334519073e-3f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(4.1665795894e-2f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(1.6666665459e-1f), y, x);
+  y = vfmaq_f32(vdupq_n_f32(5.0000001201e-1f), y, x);
+  y = vfmaq_f32(x, y, vmulq_f32(x, x));
+  y = vaddq_f32(y, vdupq_n_f32(1.0f));
+
+  int32x4_t n = vcvtq_s32_f32(fx);
+  n = vshlq_n_s32(vaddq_s32(n, vdupq_n_s32(127)), 23);
+  return vmulq_f32(y, vreinterpretq_f32_s32(n));
+}
+
+float sampling_max_f32_kernel(const float *x, int n) {
+  return compute_max_logit_neon(x, n);
+}
+
+float sampling_exp_f32_kernel(float *out, const float *x, int n, float max,
+                              float scale) {
+  float32x4_t max_v = vdupq_n_f32(max);
+  float32x4_t scale_v = vdupq_n_f32(scale);
+  float32x4_t sum_v = vdupq_n_f32(0.0f);
+  int i = 0;
+
+  for (; i + 4 <= n; i += 4) {
+    float32x4_t e =
+        exp_f32x4(vmulq_f32(vsubq_f32(vld1q_f32(x + i), max_v), scale_v));
+    vst1q_f32(out + i, e);
+    sum_v = vaddq_f32(sum_v, e);
+  }
+
+  float sum = hsum_f32x4(sum_v);
+  for (; i < n; i++) {
+    out[i] = expf((x[i] - max) * scale);
+    sum += out[i];
+  }
+  return sum;
+}
+
 #else // HAS_NEON
 
 int sampling_sample_f32_kernel(const float *logits, int vocab_size,
@@ -405,4 +455,20 @@ float sampling_prob_f32_kernel(const float *logits, int vocab_size,
   return 0.0f;
 }
 
+float sampling_max_f32_kernel(const float *x, int n) {
+  (void)x;
+  (void)n;
+  return 0.0f;
+}
+
+float sampling_exp_f32_kernel(float *out, const float *x, int n, float max,
+                              float scale) {
+  (void)out;
+  (void)x;
+  (void)n;
+  (void)max;
+  (void)scale;
+  return 0.0f;
+}
+
 #endif // HAS_NEON
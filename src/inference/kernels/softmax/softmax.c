@@ -165,6 +165,13 @@ static void softmax_f16_scalar(uint16_t *output, const uint16_t *input,
 #define HAS_NEON_IMPL 0
 #endif
 
+/* AVX2 kernels are built for every x86-64 target and gated on CPUID */
+#if defined(__x86_64__) || defined(_M_X64)
+#define HAS_AVX2_IMPL 1
+#else
+#define HAS_AVX2_IMPL 0
+#endif
+
 void softmax_f32(float *output, const float *input, int num_rows,
                  int row_size) {
 #if HAS_NEON_IMPL
@@ -173,6 +180,12 @@ void softmax_f32(float *output, const float *input, int num_rows,
     softmax_f32_kernel(output, input, num_rows, row_size, 1.0f);
     return;
   }
+#endif
+#if HAS_AVX2_IMPL
+  if (softmax_get_capabilities().has_avx2) {
+    softmax_f32_kernel_avx2(output, input, num_rows, row_size, 1.0f);
+    return;
+  }
 #endif
   softmax_f32_scalar(output, input, num_rows, row_size, 1.0f);
 }
@@ -185,6 +198,12 @@ void softmax_bf16(uint16_t *output, const uint16_t *input, int num_rows,
     softmax_bf16_kernel(output, input, num_rows, row_size, 1.0f);
     return;
   }
+#endif
+#if HAS_AVX2_IMPL
+  if (softmax_get_capabilities().has_avx2) {
+    softmax_bf16_kernel_avx2(output, input, num_rows, row_size, 1.0f);
+    return;
+  }
 #endif
   softmax_bf16_scalar(output, input, num_rows, row_size, 1.0f);
 }
@@ -197,6 +216,12 @@ void softmax_f16(uint16_t *output, const uint16_t *input, int num_rows,
     softmax_f16_kernel(output, input, num_rows, row_size, 1.0f);
     return;
   }
+#endif
+#if HAS_AVX2_IMPL
+  if (softmax_get_capabilities().has_avx2) {
+    softmax_f16_kernel_avx2(output, input, num_rows, row_size, 1.0f);
+    return;
+  }
 #endif
   softmax_f16_scalar(output, input, num_rows, row_size, 1.0f);
 }
@@ -221,6 +246,12 @@ void softmax_f32_scaled(float *output, const float *input, int num_rows,
     softmax_f32_kernel(output, input, num_rows, row_size, scale);
     return;
   }
+#endif
+#if HAS_AVX2_IMPL
+  if (softmax_get_capabilities().has_avx2) {
+    softmax_f32_kernel_avx2(output, input, num_rows, row_size, scale);
+    return;
+  }
 #endif
   softmax_f32_scalar(output, input, num_rows, row_size, scale);
 }
@@ -233,6 +264,12 @@ void softmax_bf16_scaled(uint16_t *output, const uint16_t *input, int num_rows,
     softmax_bf16_kernel(output, input, num_rows, row_size, scale);
     return;
   }
+#endif
+#if HAS_AVX2_IMPL
+  if (softmax_get_capabilities().has_avx2) {
+    softmax_bf16_kernel_avx2(output, input, num_rows, row_size, scale);
+    return;
+  }
 #endif
   softmax_bf16_scalar(output, input, num_rows, row_size, scale);
 }
@@ -245,6 +282,12 @@ void softmax_f16_scaled(uint16_t *output, const uint16_t *input, int num_rows,
     softmax_f16_kernel(output, input, num_rows, row_size, scale);
     return;
   }
+#endif
+#if HAS_AVX2_IMPL
+  if (softmax_get_capabilities().has_avx2) {
+    softmax_f16_kernel_avx2(output, input, num_rows, row_size, scale);
+    return;
+  }
 #endif
   softmax_f16_scalar(output, input, num_rows, row_size, scale);
 }
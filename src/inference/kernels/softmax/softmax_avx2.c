@@ -0,0 +1,232 @@
+/*
+ * Softmax - AVX2/FMA Optimized Kernels
+ *
+ * Three passes per row: scaled max, exp + sum (written to output), normalize.
+ */
+
+#include "inference/kernels/softmax/softmax_kernels.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__AVX2__) && defined(__FMA__) && defined(__F16C__)
+
+#include <immintrin.h>
+
+enum { ELEM_F32 = 0, ELEM_F16 = 1, ELEM_BF16 = 2 };
+
+#define AVX2_INLINE static inline __attribute__((always_inline))
+
+AVX2_INLINE __m256 exp256_ps(__m256 x) {
+  const __m256 exp_hi = _mm256_set1_ps(88.3762626647949f);
+  const __m256 exp_lo = _mm256_set1_ps(-88.3762626647949f);
+  const __m256 log2e = _mm256_set1_ps(1.44269504088896341f);
+  const __m256 c1 = _mm256_set1_ps(0.693359375f);
+  const __m256 c2 = _mm256_set1_ps(-2.12194440e-4f);
+
+  x = _mm256_min_ps(_mm256_max_ps(x, exp_lo), exp_hi);
+
+  __m256 fx = _mm256_fmadd_ps(x, log2e, _mm256_set1_ps(0.5f));
+  fx = _mm256_floor_ps(fx);
+
+  x = _mm256_fnmadd_ps(fx, c1, x);
+  x = _mm256_fnmadd_ps(fx, c2, x);
+
+  __m256 y = _mm256_set1_ps(1.9875691500e-4f);
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.3981999507e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(8.3334519073e-3f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(4.1665795894e-2f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(1.6666665459e-1f));
+  y = _mm256_fmadd_ps(y, x, _mm256_set1_ps(5.0000001201e-1f));
+  y = _mm256_fmadd_ps(y, _mm256_mul_ps(x, x), x);
+  y = _mm256_add_ps(y, _mm256_set1_ps(1.0f));
+
+  __m256i n = _mm256_cvttps_epi32(fx);
+  n = _mm256_slli_epi32(_mm256_add_epi32(n, _mm256_set1_epi32(127)), 23);
+  return _mm256_mul_ps(y, _mm256_castsi256_ps(n));
+}
+
+AVX2_INLINE float hmax256_ps(__m256 v) {
+  __m128 m = _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  m = _mm_max_ps(m, _mm_movehl_ps(m, m));
+  m = _mm_max_ss(m, _mm_movehdup_ps(m));
+  return _mm_cvtss_f32(m);
+}
+
+AVX2_INLINE float hsum256_ps(__m256 v) {
+  __m128 s = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+  s = _mm_add_ps(s, _mm_movehl_ps(s, s));
+  s = _mm_add_ss(s, _mm_movehdup_ps(s));
+  return _mm_cvtss_f32(s);
+}
+
+AVX2_INLINE __m256 load8(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return _mm256_loadu_ps((const float *)p + idx);
+  __m128i h = _mm_loadu_si128((const __m128i *)((const uint16_t *)p + idx));
+  if (kind == ELEM_F16)
+    return _mm256_cvtph_ps(h);
+  return _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_cvtepu16_epi32(h), 16));
+}
+
+AVX2_INLINE void store8(void *p, size_t idx, __m256 v, int kind) {
+  if (kind == ELEM_F32) {
+    _mm256_storeu_ps((float *)p + idx, v);
+    return;
+  }
+  __m128i h;
+  if (kind == ELEM_F16) {
+    h = _mm256_cvtps_ph(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    __m256i bits = _mm256_castps_si256(v);
+    __m256i lsb =
+        _mm256_and_si256(_mm256_srli_epi32(bits, 16), _mm256_set1_epi32(1));
+    bits = _mm256_add_epi32(bits,
+                            _mm256_add_epi32(_mm256_set1_epi32(0x7fff), lsb));
+    bits = _mm256_srli_epi32(bits, 16);
+    h = _mm_packus_epi32(_mm256_castsi256_si128(bits),
+                         _mm256_extracti128_si256(bits, 1));
+  }
+  _mm_storeu_si128((__m128i *)((uint16_t *)p + idx), h);
+}
+
+AVX2_INLINE float load1(const void *p, size_t idx, int kind) {
+  if (kind == ELEM_F32)
+    return ((const float *)p)[idx];
+  if (kind == ELEM_F16)
+    return _cvtsh_ss(((const uint16_t *)p)[idx]);
+  uint32_t bits = ((uint32_t)((const uint16_t *)p)[idx]) << 16;
+  float f;
+  memcpy(&f, &bits, sizeof(f));
+  return f;
+}
+
+AVX2_INLINE void store1(void *p, size_t idx, float v, int kind) {
+  if (kind == ELEM_F32) {
+    ((float *)p)[idx] = v;
+  } else if (kind == ELEM_F16) {
+    ((uint16_t *)p)[idx] = _cvtss_sh(v, _MM_FROUND_TO_NEAREST_INT);
+  } else {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    bits += 0x7fff + ((bits >> 16) & 1);
+    ((uint16_t *)p)[idx] = (uint16_t)(bits >> 16);
+  }
+}
+
+/*
+ * For 16-bit outputs the unnormalized exponentials are kept in F32 on the
+ * stack when the row fits, avoiding a lossy round-trip through the output.
+ */
+#define SOFTMAX_STACK_ROW 4096
+
+AVX2_INLINE void softmax_row_avx2(void *output, const void *input, size_t off,
+                                  int row_size, float scale, float *tmp,
+                                  int kind) {
+  const __m256 scale_v = _mm256_set1_ps(scale);
+
+  __m256 max_v = _mm256_set1_ps(-__builtin_inff());
+  int i = 0;
+  for (; i + 8 <= row_size; i += 8)
+    max_v = _mm256_max_ps(max_v,
+                          _mm256_mul_ps(load8(input, off + i, kind), scale_v));
+  float max_val = hmax256_ps(max_v);
+  for (; i < row_size; i++) {
+    float v = load1(input, off + i, kind) * scale;
+    if (v > max_val)
+      max_val = v;
+  }
+
+  /* Stash exps in F32 output directly, or in tmp for 16-bit types */
+  float *exps = kind == ELEM_F32 ? (float *)output + off : tmp;
+  const __m256 max_b = _mm256_set1_ps(max_val);
+  __m256 sum_v = _mm256_setzero_ps();
+  i = 0;
+  for (; i + 8 <= row_size; i += 8) {
+    __m256 v = _mm256_fmsub_ps(load8(input, off + i, kind), scale_v, max_b);
+    v = exp256_ps(v);
+    _mm256_storeu_ps(exps + i, v);
+    sum_v = _mm256_add_ps(sum_v, v);
+  }
+  float sum = hsum256_ps(sum_v);
+  for (; i < row_size; i++) {
+    float e = expf(load1(input, off + i, kind) * scale - max_val);
+    exps[i] = e;
+    sum += e;
+  }
+
+  float inv_sum = 1.0f / sum;
+  const __m256 inv_v = _mm256_set1_ps(inv_sum);
+  i = 0;
+  for (; i + 8 <= row_size; i += 8)
+    store8(output, off + i, _mm256_mul_ps(_mm256_loadu_ps(exps + i), inv_v),
+           kind);
+  for (; i < row_size; i++)
+    store1(output, off + i, exps[i] * inv_sum, kind);
+}
+
+AVX2_INLINE void softmax_avx2(void *output, const void *input, int num_rows,
+                              int row_size, float scale, int kind) {
+  float stack_tmp[SOFTMAX_STACK_ROW];
+  float *tmp = NULL;
+  if (kind != ELEM_F32) {
+    tmp = row_size <= SOFTMAX_STACK_ROW
+              ? stack_tmp
+              : (float *)malloc((size_t)row_size * sizeof(float));
+    if (!tmp)
+      return;
+  }
+
+  for (int r = 0; r < num_rows; r++)
+    softmax_row_avx2(output, input, (size_t)r * row_size, row_size, scale, tmp,
+                     kind);
+
+  if (tmp && tmp != stack_tmp)
+    free(tmp);
+}
+
+void softmax_f32_kernel_avx2(float *output, const float *input, int num_rows,
+                             int row_size, float scale) {
+  softmax_avx2(output, input, num_rows, row_size, scale, ELEM_F32);
+}
+
+void softmax_bf16_kernel_avx2(uint16_t *output, const uint16_t *input,
+                              int num_rows, int row_size, float scale) {
+  softmax_avx2(output, input, num_rows, row_size, scale, ELEM_BF16);
+}
+
+void softmax_f16_kernel_avx2(uint16_t *output, const uint16_t *input,
+                             int num_rows, int row_size, float scale) {
+  softmax_avx2(output, input, num_rows, row_size, scale, ELEM_F16);
+}
+
+#else
+
+void softmax_f32_kernel_avx2(float *output, const float *input, int num_rows,
+                             int row_size, float scale) {
+  (void)output;
+  (void)input;
+  (void)num_rows;
+  (void)row_size;
+  (void)scale;
+}
+
+void softmax_bf16_kernel_avx2(uint16_t *output, const uint16_t *input,
+                              int num_rows, int row_size, float scale) {
+  (void)output;
+  (void)input;
+  (void)num_rows;
+  (void)row_size;
+  (void)scale;
+}
+
+void softmax_f16_kernel_avx2(uint16_t *output, const uint16_t *input,
+                             int num_rows, int row_size, float scale) {
+  (void)output;
+  (void)input;
+  (void)num_rows;
+  (void)row_size;
+  (void)scale;
+}
+
+#endif
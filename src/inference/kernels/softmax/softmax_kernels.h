@@ -22,4 +22,11 @@ void softmax_bf16_kernel(uint16_t *output, const uint16_t *input, int num_rows,
 void softmax_f16_kernel(uint16_t *output, const uint16_t *input, int num_rows,
                         int row_size, float scale);
 
+void softmax_f32_kernel_avx2(float *output, const float *input, int num_rows,
+                             int row_size, float scale);
+void softmax_bf16_kernel_avx2(uint16_t *output, const uint16_t *input,
+                              int num_rows, int row_size, float scale);
+void softmax_f16_kernel_avx2(uint16_t *output, const uint16_t *input,
+                             int num_rows, int row_size, float scale);
+
 #endif
@@ -2,9 +2,25 @@
 #include "inference/core/dtype.h"
 #include "inference/model/qwen3/qwen3.h"
 #include "inference/model/registry.h"
+#include <pthread.h>
 #include <stdlib.h>
 #include <string.h>
 
+struct inference_seq {
+  kv_block_table_t kv;
+};
+
+struct inference_model_loader {
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  inference_load_progress_t progress; /* Guarded by lock */
+
+  char *model_type; /* NULL to detect it */
+  char *model_dir;
+  inference_dtype_t dtype;
+};
+
 static dtype_t inference_to_dtype(inference_dtype_t dtype) {
   return (dtype == INFERENCE_DTYPE_F16) ? DTYPE_F16 : DTYPE_F32;
 }
@@ -12,7 +28,25 @@ static dtype_t inference_to_dtype(inference_dtype_t dtype) {
 static bool qwen3_load_wrapper(inference_model_t *model, const char *model_dir,
                                inference_dtype_t dtype) {
   qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
-  return qwen3_model_load(qwen3, model_dir, inference_to_dtype(dtype));
+  if (!qwen3_model_load(qwen3, model_dir, inference_to_dtype(dtype)))
+    return false;
+  model->vocab_size = qwen3->config.vocab_size;
+  model->max_seq_len = qwen3->max_seq_len;
+  return true;
+}
+
+static bool qwen3_load_progress_wrapper(inference_model_t *model,
+                                        const char *model_dir,
+                                        inference_dtype_t dtype,
+                                        inference_load_progress_fn fn,
+                                        void *user) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  if (!qwen3_model_load_progress(qwen3, model_dir, inference_to_dtype(dtype),
+                                 fn, user))
+    return false;
+  model->vocab_size = qwen3->config.vocab_size;
+  model->max_seq_len = qwen3->max_seq_len;
+  return true;
 }
 
 static void qwen3_free_wrapper(inference_model_t *model) {
@@ -42,14 +76,106 @@ static int qwen3_generate_wrapper(inference_model_t *model, int *output_tokens,
                         num_input_tokens, temperature, top_k, top_p);
 }
 
+static inference_seq_t *qwen3_seq_create_wrapper(inference_model_t *model) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  inference_seq_t *seq = (inference_seq_t *)malloc(sizeof(inference_seq_t));
+  if (!seq)
+    return NULL;
+  kv_block_table_init(&seq->kv, qwen3->kv_pool);
+  return seq;
+}
+
+static void qwen3_seq_free_wrapper(inference_model_t *model,
+                                   inference_seq_t *seq) {
+  (void)model;
+  kv_block_table_free(&seq->kv);
+  free(seq);
+}
+
+/*
+ * Sequences per qwen3_forward_batch() call. Larger batches run as
+ * consecutive groups, which independent sequences allow; a failure retires
+ * the whole batch anyway.
+ */
+#define FORWARD_BATCH_GROUP 64
+
+static bool qwen3_forward_batch_wrapper(inference_model_t *model,
+                                        inference_seq_t *const *seqs,
+                                        const int *const *token_ids,
+                                        const int *num_tokens, int num_seqs,
+                                        float *logits) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  size_t vocab_size = (size_t)qwen3->config.vocab_size;
+  kv_block_table_t *kvs[FORWARD_BATCH_GROUP];
+
+  if (num_seqs <= 0)
+    return false;
+  for (int s0 = 0; s0 < num_seqs; s0 += FORWARD_BATCH_GROUP) {
+    int n = num_seqs - s0 < FORWARD_BATCH_GROUP ? num_seqs - s0
+                                                : FORWARD_BATCH_GROUP;
+    for (int s = 0; s < n; s++)
+      kvs[s] = &seqs[s0 + s]->kv;
+    if (!qwen3_forward_batch(qwen3, kvs, token_ids + s0, num_tokens + s0, n,
+                             logits ? logits + s0 * vocab_size : NULL))
+      return false;
+  }
+  return true;
+}
+
+static int qwen3_seq_reuse_prefix_wrapper(inference_model_t *model,
+                                          inference_seq_t *seq,
+                                          const int *tokens, int num_tokens) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  return kv_prefix_cache_match(qwen3->prefix_cache, &seq->kv, tokens,
+                               num_tokens);
+}
+
+static void qwen3_seq_cache_prefix_wrapper(inference_model_t *model,
+                                           inference_seq_t *seq,
+                                           const int *tokens, int num_tokens) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  kv_prefix_cache_insert(qwen3->prefix_cache, &seq->kv, tokens, num_tokens);
+}
+
+static bool qwen3_seq_forward_all_wrapper(inference_model_t *model,
+                                          inference_seq_t *seq,
+                                          const int *token_ids,
+                                          int num_tokens, float *logits) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  return qwen3_forward_seq_all(qwen3, &seq->kv, logits, token_ids,
+                               num_tokens);
+}
+
+static void qwen3_seq_truncate_wrapper(inference_model_t *model,
+                                       inference_seq_t *seq, int len) {
+  (void)model;
+  kv_block_table_truncate(&seq->kv, len);
+}
+
+static bool qwen3_seq_shift_wrapper(inference_model_t *model,
+                                    inference_seq_t *seq, int keep,
+                                    int discard) {
+  qwen3_model_t *qwen3 = (qwen3_model_t *)model->impl;
+  return qwen3_seq_shift(qwen3, &seq->kv, keep, discard);
+}
+
 static void *qwen3_alloc_impl(void) { return calloc(1, sizeof(qwen3_model_t)); }
 
 static const inference_model_ops_t qwen3_ops = {
     .load = qwen3_load_wrapper,
+    .load_progress = qwen3_load_progress_wrapper,
     .free = qwen3_free_wrapper,
     .reset_cache = qwen3_reset_cache_wrapper,
     .forward = qwen3_forward_wrapper,
     .generate = qwen3_generate_wrapper,
+    .seq_create = qwen3_seq_create_wrapper,
+    .seq_free = qwen3_seq_free_wrapper,
+    .forward_batch = qwen3_forward_batch_wrapper,
+    .seq_reuse_prefix = qwen3_seq_reuse_prefix_wrapper,
+    .seq_cache_prefix = qwen3_seq_cache_prefix_wrapper,
+    .seq_forward_all = qwen3_seq_forward_all_wrapper,
+    .seq_truncate = qwen3_seq_truncate_wrapper,
+    .seq_shift = qwen3_seq_shift_wrapper,
 };
 
 __attribute__((constructor)) static void register_qwen3_model(void) {
@@ -63,14 +189,9 @@ static void *alloc_impl_for_model(const char *model_type) {
   return NULL;
 }
 
-bool inference_model_load(inference_model_t *model, const char *model_type,
-                          const char *model_dir, inference_dtype_t dtype) {
-  if (!model || !model_dir)
-    return false;
-
-  memset(model, 0, sizeof(*model));
-  model->dtype = dtype;
-
+static bool load_model(inference_model_t *model, const char *model_type,
+                       const char *model_dir, inference_dtype_t dtype,
+                       inference_load_progress_fn fn, void *user) {
   const char *arch = model_type;
   if (!arch || arch[0] == '\0')
     arch = model_detect_arch(model_dir);
@@ -89,11 +210,135 @@ bool inference_model_load(inference_model_t *model, const char *model_type,
   model->ops = ops;
   model->impl = impl;
 
+  if (fn && model->ops->load_progress)
+    return model->ops->load_progress(model, model_dir, dtype, fn, user);
   return model->ops->load(model, model_dir, dtype);
 }
 
+bool inference_model_load(inference_model_t *model, const char *model_type,
+                          const char *model_dir, inference_dtype_t dtype) {
+  if (!model || !model_dir)
+    return false;
+
+  memset(model, 0, sizeof(*model));
+  model->dtype = dtype;
+  return load_model(model, model_type, model_dir, dtype, NULL, NULL);
+}
+
+static void loader_progress(void *user, size_t bytes_done, size_t bytes_total,
+                            int tensors_done, int tensors_total) {
+  inference_model_loader_t *loader = (inference_model_loader_t *)user;
+  pthread_mutex_lock(&loader->lock);
+  loader->progress.bytes_done = bytes_done;
+  loader->progress.bytes_total = bytes_total;
+  loader->progress.tensors_done = tensors_done;
+  loader->progress.tensors_total = tensors_total;
+  pthread_mutex_unlock(&loader->lock);
+}
+
+/* Runs the load; the model's other fields are only read after done is set */
+static void *loader_run(void *arg) {
+  inference_model_t *model = (inference_model_t *)arg;
+  inference_model_loader_t *loader = model->loader;
+  bool ok = load_model(model, loader->model_type, loader->model_dir,
+                       loader->dtype, loader_progress, loader);
+
+  pthread_mutex_lock(&loader->lock);
+  loader->progress.done = true;
+  loader->progress.ok = ok;
+  pthread_cond_broadcast(&loader->cond);
+  pthread_mutex_unlock(&loader->lock);
+  return NULL;
+}
+
+static void loader_free(inference_model_loader_t *loader) {
+  pthread_cond_destroy(&loader->cond);
+  pthread_mutex_destroy(&loader->lock);
+  free(loader->model_type);
+  free(loader->model_dir);
+  free(loader);
+}
+
+bool inference_model_load_async(inference_model_t *model,
+                                const char *model_type, const char *model_dir,
+                                inference_dtype_t dtype) {
+  if (!model || !model_dir)
+    return false;
+
+  memset(model, 0, sizeof(*model));
+  model->dtype = dtype;
+
+  inference_model_loader_t *loader =
+      (inference_model_loader_t *)calloc(1, sizeof(*loader));
+  if (!loader)
+    return false;
+  loader->model_dir = strdup(model_dir);
+  loader->model_type =
+      (model_type && model_type[0] != '\0') ? strdup(model_type) : NULL;
+  loader->dtype = dtype;
+  if (!loader->model_dir || (model_type && model_type[0] != '\0' &&
+                             !loader->model_type)) {
+    free(loader->model_type);
+    free(loader->model_dir);
+    free(loader);
+    return false;
+  }
+  pthread_mutex_init(&loader->lock, NULL);
+  pthread_cond_init(&loader->cond, NULL);
+
+  model->loader = loader;
+  if (pthread_create(&loader->thread, NULL, loader_run, model) != 0) {
+    model->loader = NULL;
+    loader_free(loader);
+    return false;
+  }
+  return true;
+}
+
+void inference_model_load_progress(inference_model_t *model,
+                                   inference_load_progress_t *progress) {
+  if (!progress)
+    return;
+  memset(progress, 0, sizeof(*progress));
+  if (!model)
+    return;
+  if (!model->loader) {
+    progress->done = true;
+    progress->ok = model->ops != NULL;
+    return;
+  }
+  pthread_mutex_lock(&model->loader->lock);
+  *progress = model->loader->progress;
+  pthread_mutex_unlock(&model->loader->lock);
+}
+
+bool inference_model_wait(inference_model_t *model) {
+  if (!model)
+    return false;
+  if (!model->loader)
+    return model->ops != NULL;
+
+  inference_model_loader_t *loader = model->loader;
+  pthread_mutex_lock(&loader->lock);
+  while (!loader->progress.done)
+    pthread_cond_wait(&loader->cond, &loader->lock);
+  bool ok = loader->progress.ok;
+  pthread_mutex_unlock(&loader->lock);
+  return ok;
+}
+
 void inference_model_free(inference_model_t *model) {
-  if (!model || !model->ops)
+  if (!model)
+    return;
+
+  /* A failed background load still frees what it allocated */
+  if (model->loader) {
+    inference_model_wait(model);
+    pthread_join(model->loader->thread, NULL);
+    loader_free(model->loader);
+    model->loader = NULL;
+  }
+  if (!model->ops)
     return;
 
   if (model->ops->free)
@@ -103,14 +348,14 @@ void inference_model_free(inference_model_t *model) {
 }
 
 void inference_model_reset_cache(inference_model_t *model) {
-  if (!model || !model->ops || !model->ops->reset_cache)
+  if (!inference_model_wait(model) || !model->ops->reset_cache)
     return;
   model->ops->reset_cache(model);
 }
 
 bool inference_model_forward(inference_model_t *model, float *logits,
                              const int *token_ids, int num_tokens) {
-  if (!model || !model->ops || !model->ops->forward)
+  if (!inference_model_wait(model) || !model->ops->forward)
     return false;
   return model->ops->forward(model, logits, token_ids, num_tokens);
 }
@@ -119,8 +364,68 @@ int inference_model_generate(inference_model_t *model, int *output_tokens,
                              int max_tokens, const int *input_tokens,
                              int num_input_tokens, float temperature, int top_k,
                              float top_p) {
-  if (!model || !model->ops || !model->ops->generate)
+  if (!inference_model_wait(model) || !model->ops->generate)
     return 0;
   return model->ops->generate(model, output_tokens, max_tokens, input_tokens,
                               num_input_tokens, temperature, top_k, top_p);
 }
+
+inference_seq_t *inference_seq_create(inference_model_t *model) {
+  if (!inference_model_wait(model) || !model->ops->seq_create)
+    return NULL;
+  return model->ops->seq_create(model);
+}
+
+void inference_seq_free(inference_model_t *model, inference_seq_t *seq) {
+  if (!inference_model_wait(model) || !model->ops->seq_free || !seq)
+    return;
+  model->ops->seq_free(model, seq);
+}
+
+bool inference_model_forward_batch(inference_model_t *model,
+                                   inference_seq_t *const *seqs,
+                                   const int *const *token_ids,
+                                   const int *num_tokens, int num_seqs,
+                                   float *logits) {
+  if (!inference_model_wait(model) || !model->ops->forward_batch)
+    return false;
+  return model->ops->forward_batch(model, seqs, token_ids, num_tokens,
+                                   num_seqs, logits);
+}
+
+int inference_seq_reuse_prefix(inference_model_t *model, inference_seq_t *seq,
+                               const int *tokens, int num_tokens) {
+  if (!inference_model_wait(model) || !model->ops->seq_reuse_prefix || !seq)
+    return 0;
+  return model->ops->seq_reuse_prefix(model, seq, tokens, num_tokens);
+}
+
+void inference_seq_cache_prefix(inference_model_t *model, inference_seq_t *seq,
+                                const int *tokens, int num_tokens) {
+  if (!inference_model_wait(model) || !model->ops->seq_cache_prefix || !seq)
+    return;
+  model->ops->seq_cache_prefix(model, seq, tokens, num_tokens);
+}
+
+bool inference_seq_forward_all(inference_model_t *model, inference_seq_t *seq,
+                               const int *token_ids, int num_tokens,
+                               float *logits) {
+  if (!inference_model_wait(model) || !model->ops->seq_forward_all || !seq)
+    return false;
+  return model->ops->seq_forward_all(model, seq, token_ids, num_tokens,
+                                     logits);
+}
+
+void inference_seq_truncate(inference_model_t *model, inference_seq_t *seq,
+                            int len) {
+  if (!inference_model_wait(model) || !model->ops->seq_truncate || !seq)
+    return;
+  model->ops->seq_truncate(model, seq, len);
+}
+
+bool inference_seq_shift(inference_model_t *model, inference_seq_t *seq,
+                         int keep, int discard) {
+  if (!inference_model_wait(model) || !model->ops->seq_shift || !seq)
+    return false;
+  return model->ops->seq_shift(model, seq, keep, discard);
+}
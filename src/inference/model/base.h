@@ -12,9 +12,37 @@ typedef enum {
 
 typedef struct inference_model inference_model_t;
 
+/* Per-sequence state (the sequence's KV cache), owned by a model */
+typedef struct inference_seq inference_seq_t;
+
+/* State of a background load; see inference_model_load_async() */
+typedef struct inference_model_loader inference_model_loader_t;
+
+/*
+ * Weight loading progress: running totals over the checkpoint's tensors,
+ * reported from the loader threads (serialized, only ever growing)
+ */
+typedef void (*inference_load_progress_fn)(void *user, size_t bytes_done,
+                                           size_t bytes_total,
+                                           int tensors_done,
+                                           int tensors_total);
+
+typedef struct {
+  size_t bytes_done;
+  size_t bytes_total; /* 0 until the checkpoint headers are read */
+  int tensors_done;
+  int tensors_total;
+  bool done; /* The load finished, successfully or not */
+  bool ok;   /* The model loaded (once done) */
+} inference_load_progress_t;
+
 typedef struct {
   bool (*load)(inference_model_t *model, const char *model_dir,
                inference_dtype_t dtype);
+  /* Optional, as load reporting progress to fn */
+  bool (*load_progress)(inference_model_t *model, const char *model_dir,
+                        inference_dtype_t dtype,
+                        inference_load_progress_fn fn, void *user);
   void (*free)(inference_model_t *model);
   void (*reset_cache)(inference_model_t *model);
   bool (*forward)(inference_model_t *model, float *logits, const int *token_ids,
@@ -22,16 +50,61 @@ typedef struct {
   int (*generate)(inference_model_t *model, int *output_tokens, int max_tokens,
                   const int *input_tokens, int num_input_tokens,
                   float temperature, int top_k, float top_p);
+  inference_seq_t *(*seq_create)(inference_model_t *model);
+  void (*seq_free)(inference_model_t *model, inference_seq_t *seq);
+  bool (*forward_batch)(inference_model_t *model, inference_seq_t *const *seqs,
+                        const int *const *token_ids, const int *num_tokens,
+                        int num_seqs, float *logits);
+  /* Optional prefix reuse; see inference_seq_reuse_prefix() */
+  int (*seq_reuse_prefix)(inference_model_t *model, inference_seq_t *seq,
+                          const int *tokens, int num_tokens);
+  void (*seq_cache_prefix)(inference_model_t *model, inference_seq_t *seq,
+                           const int *tokens, int num_tokens);
+  /* Optional, for speculative decoding; see inference_seq_forward_all() */
+  bool (*seq_forward_all)(inference_model_t *model, inference_seq_t *seq,
+                          const int *token_ids, int num_tokens, float *logits);
+  void (*seq_truncate)(inference_model_t *model, inference_seq_t *seq,
+                       int len);
+  /* Optional context shift; see inference_seq_shift() */
+  bool (*seq_shift)(inference_model_t *model, inference_seq_t *seq, int keep,
+                    int discard);
 } inference_model_ops_t;
 
 struct inference_model {
   const inference_model_ops_t *ops;
   void *impl;
   inference_dtype_t dtype;
+  int vocab_size;
+  int max_seq_len;
+  inference_model_loader_t *loader; /* NULL unless loaded asynchronously */
 };
 
 bool inference_model_load(inference_model_t *model, const char *model_type,
                           const char *model_dir, inference_dtype_t dtype);
+
+/*
+ * Start loading a model on a background thread and return at once. The
+ * model must stay at the same address until inference_model_free().
+ *
+ * Every other call on the model first waits for the load to finish, so the
+ * first forward pass starts as soon as the last layer is ready; the fields
+ * of inference_model_t are valid only after inference_model_wait() returns
+ * true. A failed load leaves a model that only inference_model_free()
+ * accepts. Returns false if the thread could not be started.
+ */
+bool inference_model_load_async(inference_model_t *model,
+                                const char *model_type, const char *model_dir,
+                                inference_dtype_t dtype);
+
+/*
+ * Snapshot the progress of a background load without blocking. A model
+ * loaded synchronously reports done.
+ */
+void inference_model_load_progress(inference_model_t *model,
+                                   inference_load_progress_t *progress);
+
+/* Wait for a background load; returns whether the model is usable */
+bool inference_model_wait(inference_model_t *model);
 void inference_model_free(inference_model_t *model);
 void inference_model_reset_cache(inference_model_t *model);
 bool inference_model_forward(inference_model_t *model, float *logits,
@@ -41,4 +114,62 @@ int inference_model_generate(inference_model_t *model, int *output_tokens,
                              int num_input_tokens, float temperature, int top_k,
                              float top_p);
 
+/*
+ * Independent sequences on one model. Each keeps its own KV cache, separate
+ * from the one used by inference_model_forward().
+ */
+inference_seq_t *inference_seq_create(inference_model_t *model);
+void inference_seq_free(inference_model_t *model, inference_seq_t *seq);
+
+/*
+ * Append num_tokens[s] tokens to each of seqs[s] in a single forward pass and
+ * write the logits of each sequence's last token to
+ * logits[s * vocab_size ...]. A sequence may appear only once per call.
+ */
+bool inference_model_forward_batch(inference_model_t *model,
+                                   inference_seq_t *const *seqs,
+                                   const int *const *token_ids,
+                                   const int *num_tokens, int num_seqs,
+                                   float *logits);
+
+/*
+ * Fill an empty sequence with the cached KV of the longest known prefix of
+ * tokens[0, num_tokens). Returns the number of tokens covered, which the
+ * caller then skips when prefilling (0 if the model keeps no prefix cache).
+ */
+int inference_seq_reuse_prefix(inference_model_t *model, inference_seq_t *seq,
+                               const int *tokens, int num_tokens);
+
+/*
+ * Offer a sequence's KV to the model's prefix cache. tokens are the ids the
+ * sequence was fed, in order.
+ */
+void inference_seq_cache_prefix(inference_model_t *model, inference_seq_t *seq,
+                                const int *tokens, int num_tokens);
+
+/*
+ * Append num_tokens tokens to one sequence and write the logits after each
+ * of them to logits[i * vocab_size ...].
+ */
+bool inference_seq_forward_all(inference_model_t *model, inference_seq_t *seq,
+                               const int *token_ids, int num_tokens,
+                               float *logits);
+
+/*
+ * Drop the sequence's KV from position len onwards, e.g. the rejected tail
+ * of a speculative step.
+ */
+void inference_seq_truncate(inference_model_t *model, inference_seq_t *seq,
+                            int len);
+
+/*
+ * Drop positions [keep, keep + discard) of the sequence's KV and move the
+ * later ones down, re-positioning their keys, so the sequence continues as
+ * if the dropped tokens had never been fed. The first keep positions are
+ * untouched. The shifted KV only approximates a fresh prefill. Returns
+ * false, leaving the sequence as it was, if the model cannot shift.
+ */
+bool inference_seq_shift(inference_model_t *model, inference_seq_t *seq,
+                         int keep, int discard);
+
 #endif
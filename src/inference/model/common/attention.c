@@ -1,208 +1,207 @@
 #include "attention.h"
-#include "inference/core/dtype.h"
-#include "inference/ops/gemm.h"
+#include "inference/model/common/linear.h"
+#include "inference/ops/attention.h"
 #include "inference/ops/kv_cache.h"
 #include "inference/ops/norm.h"
 #include "inference/ops/rope.h"
 #include <math.h>
-#include <stdlib.h>
 #include <string.h>
 
-#if defined(__ARM_NEON) || defined(__ARM_NEON__)
-#include <arm_neon.h>
-#define HAS_NEON 1
-#else
-#define HAS_NEON 0
-#endif
-
-void attention_forward_f32(float *output, const float *input,
-                           const attention_layer_t *attn, float *key_cache,
-                           float *value_cache, const int64_t *position_ids,
-                           const float *cos_sin_cache, int seq_len,
-                           int cache_len) {
-  if (!output || !input || !attn)
-    return;
-
-  int hidden_size = attn->hidden_size;
-  int num_heads = attn->num_heads;
-  int num_kv_heads = attn->num_kv_heads;
-  int head_dim = attn->head_dim;
-  int q_dim = num_heads * head_dim;
-  int kv_dim = num_kv_heads * head_dim;
-
-  const float *q_w = tensor_data_f32_const(attn->q_proj);
-  const float *k_w = tensor_data_f32_const(attn->k_proj);
-  const float *v_w = tensor_data_f32_const(attn->v_proj);
-  const float *o_w = tensor_data_f32_const(attn->o_proj);
-
-  float *q = (float *)malloc(seq_len * q_dim * sizeof(float));
-  float *k = (float *)malloc(seq_len * kv_dim * sizeof(float));
-  float *v = (float *)malloc(seq_len * kv_dim * sizeof(float));
-  if (!q || !k || !v) {
-    free(q);
-    free(k);
-    free(v);
-    return;
+/*
+ * Attention of one sequence's queries over its paged K/V: tiled causal
+ * attention for a prefill, split-KV decode for a single row
+ */
+static bool attend_seq_f32(float *attn_out, const float *q,
+                           const attention_layer_t *attn,
+                           const attention_seq_t *seq, int layer_idx,
+                           const int64_t *position_ids, void *scratch) {
+  int q_dim = attn->num_heads * attn->head_dim;
+  int total_seq_len = seq->cache_len + seq->num_tokens;
+  float scale = 1.0f / sqrtf((float)attn->head_dim);
+
+  if (seq->num_tokens > 1) {
+    size_t offset = (size_t)seq->row * q_dim;
+    return flash_prefill_f32(attn_out + offset, q + offset, seq->kv,
+                             layer_idx, seq->cache_len, seq->num_tokens,
+                             attn->num_heads, attn->num_kv_heads,
+                             attn->head_dim, scale, scratch);
   }
 
-  gemm_f32(input, q_w, q, seq_len, q_dim, hidden_size, false, true);
-  gemm_f32(input, k_w, k, seq_len, kv_dim, hidden_size, false, true);
-  gemm_f32(input, v_w, v, seq_len, kv_dim, hidden_size, false, true);
-
-  if (attn->has_qk_norm && attn->q_norm && attn->k_norm) {
-    const float *q_norm_w = tensor_data_f32_const(attn->q_norm);
-    const float *k_norm_w = tensor_data_f32_const(attn->k_norm);
-    for (int i = 0; i < seq_len; i++) {
-      for (int h = 0; h < num_heads; h++) {
-        float *q_head = q + i * q_dim + h * head_dim;
-        rms_norm_f32(q_head, q_head, q_norm_w, 1e-6f, 1, head_dim);
-      }
-    }
-    for (int i = 0; i < seq_len; i++) {
-      for (int h = 0; h < num_kv_heads; h++) {
-        float *k_head = k + i * kv_dim + h * head_dim;
-        rms_norm_f32(k_head, k_head, k_norm_w, 1e-6f, 1, head_dim);
-      }
-    }
+  for (int i = seq->row; i < seq->row + seq->num_tokens; i++) {
+    int limit = total_seq_len;
+    if (position_ids[i] + 1 < limit)
+      limit = (int)position_ids[i] + 1;
+    if (!flash_decode_f32(attn_out + i * q_dim, q + i * q_dim, seq->kv,
+                          layer_idx, limit, attn->num_heads,
+                          attn->num_kv_heads, attn->head_dim, scale, scratch))
+      return false;
   }
+  return true;
+}
 
-  rope_f32(position_ids, q, k, cos_sin_cache, seq_len, num_heads, num_kv_heads,
-           head_dim, head_dim, true);
-
-  kv_cache_append_f32(key_cache, value_cache, k, v, cache_len, seq_len,
-                      num_kv_heads, head_dim);
+static size_t max_size(size_t a, size_t b) { return a > b ? a : b; }
 
-  int total_seq_len = cache_len + seq_len;
-  float scale = 1.0f / sqrtf((float)head_dim);
-  int heads_per_kv = num_heads / num_kv_heads;
+/* Scratch shared by the prefill and decode paths of attend_seq_*() */
+static size_t attend_scratch_bytes(const attention_layer_t *attn) {
+  return max_size(flash_decode_scratch_bytes(attn->num_heads, attn->head_dim),
+                  flash_prefill_scratch_bytes(attn->num_heads,
+                                              attn->num_kv_heads,
+                                              attn->head_dim));
+}
 
-  float *attn_out = (float *)malloc(seq_len * q_dim * sizeof(float));
-  if (!attn_out) {
-    free(q);
-    free(k);
-    free(v);
-    return;
-  }
-  memset(attn_out, 0, seq_len * q_dim * sizeof(float));
-
-  for (int i = 0; i < seq_len; i++) {
-    int64_t query_abs_pos = position_ids[i];
-    for (int h = 0; h < num_heads; h++) {
-      int kv_head = h / heads_per_kv;
-      float *q_head = q + i * q_dim + h * head_dim;
-      float *out_head = attn_out + i * q_dim + h * head_dim;
-
-      memset(out_head, 0, head_dim * sizeof(float));
-      float M = -1e9f;
-      float sum = 0.0f;
-
-      for (int pos = 0; pos <= query_abs_pos && pos < total_seq_len; pos++) {
-        float *k_pos =
-            key_cache + pos * num_kv_heads * head_dim + kv_head * head_dim;
-        float *v_pos =
-            value_cache + pos * num_kv_heads * head_dim + kv_head * head_dim;
-
-        float score = 0.0f;
-        for (int d = 0; d < head_dim; d++) {
-          score += q_head[d] * k_pos[d];
-        }
-        score *= scale;
-
-        float M_new = (score > M) ? score : M;
-        float alpha = expf(M - M_new);
-
-        for (int d = 0; d < head_dim; d++) {
-          out_head[d] = out_head[d] * alpha + v_pos[d] * expf(score - M_new);
-        }
-        sum = sum * alpha + expf(score - M_new);
-        M = M_new;
-      }
-
-      if (sum > 0.0f) {
-        for (int d = 0; d < head_dim; d++) {
-          out_head[d] /= sum;
-        }
-      }
+/*
+ * q, k and v for every row. With a stacked projection the input is read by
+ * one GEMM into a [num_rows, q | k | v] buffer, returned in *qkv and left
+ * unsplit: the QK-norm and KV append read their rows in place.
+ */
+static bool project_qkv(void *q, void *k, void *v, void **qkv,
+                        const void *input, const attention_layer_t *attn,
+                        int num_rows, bool f16, workspace_t *ws) {
+  int hidden_size = attn->hidden_size;
+  int q_dim = attn->num_heads * attn->head_dim;
+  int kv_dim = attn->num_kv_heads * attn->head_dim;
+
+  *qkv = NULL;
+  if (!attn->qkv_proj) {
+    if (f16) {
+      linear_forward_f16(q, input, attn->q_proj, num_rows, q_dim,
+                         hidden_size, ws);
+      linear_forward_f16(k, input, attn->k_proj, num_rows, kv_dim,
+                         hidden_size, ws);
+      linear_forward_f16(v, input, attn->v_proj, num_rows, kv_dim,
+                         hidden_size, ws);
+    } else {
+      linear_forward_f32(q, input, attn->q_proj, num_rows, q_dim,
+                         hidden_size, ws);
+      linear_forward_f32(k, input, attn->k_proj, num_rows, kv_dim,
+                         hidden_size, ws);
+      linear_forward_f32(v, input, attn->v_proj, num_rows, kv_dim,
+                         hidden_size, ws);
     }
+    return true;
   }
 
-  gemm_f32(attn_out, o_w, output, seq_len, hidden_size, q_dim, false, true);
-
-  free(q);
-  free(k);
-  free(v);
-  free(attn_out);
+  int qkv_dim = q_dim + 2 * kv_dim;
+  size_t elem = f16 ? sizeof(uint16_t) : sizeof(float);
+  void *out = workspace_alloc(ws, (size_t)num_rows * qkv_dim * elem);
+  if (!out)
+    return false;
+  if (f16)
+    linear_forward_f16((uint16_t *)out, input, attn->qkv_proj, num_rows,
+                       qkv_dim, hidden_size, ws);
+  else
+    linear_forward_f32((float *)out, input, attn->qkv_proj, num_rows,
+                       qkv_dim, hidden_size, ws);
+  *qkv = out;
+  return true;
 }
 
-#if HAS_NEON
-static inline float dot_product_f16_neon(const uint16_t *a, const uint16_t *b,
-                                         int n) {
-  float32x4_t sum0 = vdupq_n_f32(0.0f);
-  float32x4_t sum1 = vdupq_n_f32(0.0f);
-  int i = 0;
-  for (; i + 8 <= n; i += 8) {
-    float16x8_t a_f16 = vld1q_f16((const float16_t *)&a[i]);
-    float16x8_t b_f16 = vld1q_f16((const float16_t *)&b[i]);
-    float32x4_t a_lo = vcvt_f32_f16(vget_low_f16(a_f16));
-    float32x4_t a_hi = vcvt_f32_f16(vget_high_f16(a_f16));
-    float32x4_t b_lo = vcvt_f32_f16(vget_low_f16(b_f16));
-    float32x4_t b_hi = vcvt_f32_f16(vget_high_f16(b_f16));
-    sum0 = vfmaq_f32(sum0, a_lo, b_lo);
-    sum1 = vfmaq_f32(sum1, a_hi, b_hi);
+/*
+ * Heads of src rows (row stride ld) into contiguous dst rows, RMS-normed
+ * when norm_w is set. In place when src is dst.
+ */
+static void gather_heads_f32(float *dst, const float *src, size_t ld,
+                             const float *norm_w, int num_rows,
+                             int num_heads, int head_dim) {
+  int dim = num_heads * head_dim;
+  for (int i = 0; i < num_rows; i++) {
+    float *out = dst + (size_t)i * dim;
+    const float *row = src + i * ld;
+    if (norm_w)
+      rms_norm_f32(out, row, norm_w, 1e-6f, num_heads, head_dim);
+    else if (out != row)
+      memcpy(out, row, (size_t)dim * sizeof(float));
   }
-  float32x4_t sum = vaddq_f32(sum0, sum1);
-  float result = vaddvq_f32(sum);
-  for (; i < n; i++) {
-    result += f16_to_f32(a[i]) * f16_to_f32(b[i]);
+}
+
+static void gather_heads_f16(uint16_t *dst, const uint16_t *src, size_t ld,
+                             const uint16_t *norm_w, int num_rows,
+                             int num_heads, int head_dim) {
+  int dim = num_heads * head_dim;
+  for (int i = 0; i < num_rows; i++) {
+    uint16_t *out = dst + (size_t)i * dim;
+    const uint16_t *row = src + i * ld;
+    if (norm_w)
+      rms_norm_f16(out, row, norm_w, 1e-6f, num_heads, head_dim);
+    else if (out != row)
+      memcpy(out, row, (size_t)dim * sizeof(uint16_t));
   }
-  return result;
 }
 
-static inline void scale_accumulate_f16_neon(float *out, const uint16_t *v,
-                                             float alpha, float weight, int n) {
-  float32x4_t alpha_v = vdupq_n_f32(alpha);
-  float32x4_t weight_v = vdupq_n_f32(weight);
-  int i = 0;
-  for (; i + 8 <= n; i += 8) {
-    float16x8_t v_f16 = vld1q_f16((const float16_t *)&v[i]);
-    float32x4_t v_lo = vcvt_f32_f16(vget_low_f16(v_f16));
-    float32x4_t v_hi = vcvt_f32_f16(vget_high_f16(v_f16));
-    float32x4_t out_lo = vld1q_f32(&out[i]);
-    float32x4_t out_hi = vld1q_f32(&out[i + 4]);
-    out_lo = vfmaq_f32(vmulq_f32(out_lo, alpha_v), v_lo, weight_v);
-    out_hi = vfmaq_f32(vmulq_f32(out_hi, alpha_v), v_hi, weight_v);
-    vst1q_f32(&out[i], out_lo);
-    vst1q_f32(&out[i + 4], out_hi);
+/* A sequence's K/V rows into its cache; v rows are v_ld apart */
+static void append_kv_f32(const attention_seq_t *seq, int layer_idx,
+                          const float *k, const float *v, size_t v_ld,
+                          int kv_dim) {
+  if (v_ld == (size_t)kv_dim) {
+    kv_cache_append_paged_f32(seq->kv, layer_idx, k + seq->row * kv_dim,
+                              v + seq->row * v_ld, seq->cache_len,
+                              seq->num_tokens);
+    return;
   }
-  for (; i < n; i++) {
-    out[i] = out[i] * alpha + f16_to_f32(v[i]) * weight;
+  for (int t = 0; t < seq->num_tokens; t++) {
+    int i = seq->row + t;
+    kv_cache_append_paged_f32(seq->kv, layer_idx, k + i * kv_dim, v + i * v_ld,
+                              seq->cache_len + t, 1);
   }
 }
 
-static inline void f32_to_f16_neon(uint16_t *out, const float *in, float scale,
-                                   int n) {
-  float32x4_t scale_v = vdupq_n_f32(scale);
-  int i = 0;
-  for (; i + 8 <= n; i += 8) {
-    float32x4_t in_lo = vmulq_f32(vld1q_f32(&in[i]), scale_v);
-    float32x4_t in_hi = vmulq_f32(vld1q_f32(&in[i + 4]), scale_v);
-    float16x8_t out_f16 =
-        vcombine_f16(vcvt_f16_f32(in_lo), vcvt_f16_f32(in_hi));
-    vst1q_f16((float16_t *)&out[i], out_f16);
+static void append_kv_f16(const attention_seq_t *seq, int layer_idx,
+                          const uint16_t *k, const uint16_t *v, size_t v_ld,
+                          int kv_dim) {
+  if (v_ld == (size_t)kv_dim) {
+    kv_cache_append_paged_f16(seq->kv, layer_idx, k + seq->row * kv_dim,
+                              v + seq->row * v_ld, seq->cache_len,
+                              seq->num_tokens);
+    return;
   }
-  for (; i < n; i++) {
-    out[i] = f32_to_f16(in[i] * scale);
+  for (int t = 0; t < seq->num_tokens; t++) {
+    int i = seq->row + t;
+    kv_cache_append_paged_f16(seq->kv, layer_idx, k + i * kv_dim, v + i * v_ld,
+                              seq->cache_len + t, 1);
   }
 }
-#endif
-
-void attention_forward_f16(uint16_t *output, const uint16_t *input,
-                           const attention_layer_t *attn, uint16_t *key_cache,
-                           uint16_t *value_cache, const int64_t *position_ids,
-                           const uint16_t *cos_sin_cache, int seq_len,
-                           int cache_len) {
-  if (!output || !input || !attn)
-    return;
+
+size_t attention_workspace_bytes(const attention_layer_t *attn, int num_rows,
+                                 size_t elem_size) {
+  int hidden_size = attn->hidden_size;
+  int q_dim = attn->num_heads * attn->head_dim;
+  int kv_dim = attn->num_kv_heads * attn->head_dim;
+  size_t q_bytes = workspace_slice_bytes((size_t)num_rows * q_dim * elem_size);
+  size_t kv_bytes =
+      workspace_slice_bytes((size_t)num_rows * kv_dim * elem_size);
+
+  size_t linear = linear_workspace_bytes(attn->o_proj, num_rows,
+                                         hidden_size, q_dim);
+  size_t qkv = 0;
+  if (attn->qkv_proj) {
+    int qkv_dim = q_dim + 2 * kv_dim;
+    qkv = workspace_slice_bytes((size_t)num_rows * qkv_dim * elem_size);
+    linear = max_size(linear, linear_workspace_bytes(attn->qkv_proj, num_rows,
+                                                     qkv_dim, hidden_size));
+  } else {
+    linear = max_size(linear, linear_workspace_bytes(attn->q_proj, num_rows,
+                                                     q_dim, hidden_size));
+    linear = max_size(linear, linear_workspace_bytes(attn->k_proj, num_rows,
+                                                     kv_dim, hidden_size));
+    linear = max_size(linear, linear_workspace_bytes(attn->v_proj, num_rows,
+                                                     kv_dim, hidden_size));
+  }
+  size_t scratch = workspace_slice_bytes(attend_scratch_bytes(attn));
+  /*
+   * q and attn_out, k and v, the stacked projection output, the attention
+   * scratch, the projections'
+   */
+  return 2 * q_bytes + 2 * kv_bytes + qkv + scratch + linear;
+}
+
+bool attention_forward_f32(float *output, const float *input,
+                           const attention_layer_t *attn,
+                           const attention_seq_t *seqs, int num_seqs,
+                           int layer_idx, const int64_t *position_ids,
+                           const float *cos_sin_cache, int num_rows,
+                           workspace_t *ws) {
+  if (!output || !input || !attn || !seqs || num_seqs <= 0)
+    return false;
 
   int hidden_size = attn->hidden_size;
   int num_heads = attn->num_heads;
@@ -211,120 +210,164 @@ void attention_forward_f16(uint16_t *output, const uint16_t *input,
   int q_dim = num_heads * head_dim;
   int kv_dim = num_kv_heads * head_dim;
 
-  const uint16_t *q_w = tensor_data_f16_const(attn->q_proj);
-  const uint16_t *k_w = tensor_data_f16_const(attn->k_proj);
-  const uint16_t *v_w = tensor_data_f16_const(attn->v_proj);
-  const uint16_t *o_w = tensor_data_f16_const(attn->o_proj);
-
-  uint16_t *q = (uint16_t *)malloc(seq_len * q_dim * sizeof(uint16_t));
-  uint16_t *k = (uint16_t *)malloc(seq_len * kv_dim * sizeof(uint16_t));
-  uint16_t *v = (uint16_t *)malloc(seq_len * kv_dim * sizeof(uint16_t));
-  if (!q || !k || !v) {
-    free(q);
-    free(k);
-    free(v);
-    return;
+  size_t mark = workspace_mark(ws);
+  float *q =
+      (float *)workspace_alloc(ws, (size_t)num_rows * q_dim * sizeof(float));
+  float *k =
+      (float *)workspace_alloc(ws, (size_t)num_rows * kv_dim * sizeof(float));
+  float *v =
+      (float *)workspace_alloc(ws, (size_t)num_rows * kv_dim * sizeof(float));
+  float *attn_out =
+      (float *)workspace_alloc(ws, (size_t)num_rows * q_dim * sizeof(float));
+  void *scratch = workspace_alloc(ws, attend_scratch_bytes(attn));
+  if (!q || !k || !v || !attn_out || !scratch) {
+    workspace_reset(ws, mark);
+    return false;
   }
 
-  gemm_f16(input, q_w, q, seq_len, q_dim, hidden_size);
-  gemm_f16(input, k_w, k, seq_len, kv_dim, hidden_size);
-  gemm_f16(input, v_w, v, seq_len, kv_dim, hidden_size);
-
-  if (attn->has_qk_norm && attn->q_norm && attn->k_norm) {
-    const uint16_t *q_norm_w = tensor_data_f16_const(attn->q_norm);
-    const uint16_t *k_norm_w = tensor_data_f16_const(attn->k_norm);
-    for (int i = 0; i < seq_len; i++) {
-      for (int h = 0; h < num_heads; h++) {
-        uint16_t *q_head = q + i * q_dim + h * head_dim;
-        rms_norm_f16(q_head, q_head, q_norm_w, 1e-6f, 1, head_dim);
-      }
-    }
-    for (int i = 0; i < seq_len; i++) {
-      for (int h = 0; h < num_kv_heads; h++) {
-        uint16_t *k_head = k + i * kv_dim + h * head_dim;
-        rms_norm_f16(k_head, k_head, k_norm_w, 1e-6f, 1, head_dim);
-      }
+  float *qkv;
+  if (!project_qkv(q, k, v, (void **)&qkv, input, attn, num_rows, false,
+                   ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
+
+  /* Row sources: the stacked output when there is one, else q, k and v */
+  int qkv_dim = q_dim + 2 * kv_dim;
+  const float *q_src = qkv ? qkv : q;
+  const float *k_src = qkv ? qkv + q_dim : k;
+  const float *v_src = qkv ? qkv + q_dim + kv_dim : v;
+  size_t q_ld = qkv ? (size_t)qkv_dim : (size_t)q_dim;
+  size_t kv_ld = qkv ? (size_t)qkv_dim : (size_t)kv_dim;
+
+  bool qk_norm = attn->has_qk_norm && attn->q_norm && attn->k_norm;
+  gather_heads_f32(q, q_src, q_ld,
+                   qk_norm ? tensor_data_f32_const(attn->q_norm) : NULL,
+                   num_rows, num_heads, head_dim);
+  gather_heads_f32(k, k_src, kv_ld,
+                   qk_norm ? tensor_data_f32_const(attn->k_norm) : NULL,
+                   num_rows, num_kv_heads, head_dim);
+
+  rope_f32(position_ids, q, k, cos_sin_cache, num_rows, num_heads,
+           num_kv_heads, head_dim, head_dim, true);
+
+  for (int s = 0; s < num_seqs; s++) {
+    const attention_seq_t *seq = &seqs[s];
+    append_kv_f32(seq, layer_idx, k, v_src, kv_ld, kv_dim);
+    if (!attend_seq_f32(attn_out, q, attn, seq, layer_idx, position_ids,
+                        scratch)) {
+      workspace_reset(ws, mark);
+      return false;
     }
   }
 
-  rope_f16(position_ids, q, k, cos_sin_cache, seq_len, num_heads, num_kv_heads,
-           head_dim, head_dim, true);
+  linear_forward_f32(output, attn_out, attn->o_proj, num_rows, hidden_size,
+                     q_dim, ws);
 
-  kv_cache_append_f16(key_cache, value_cache, k, v, cache_len, seq_len,
-                      num_kv_heads, head_dim);
+  workspace_reset(ws, mark);
+  return true;
+}
 
-  int total_seq_len = cache_len + seq_len;
-  float scale = 1.0f / sqrtf((float)head_dim);
-  int heads_per_kv = num_heads / num_kv_heads;
+/*
+ * Attention of one sequence's queries over its paged K/V: tiled causal
+ * attention for a prefill, split-KV decode for a single row
+ */
+static bool attend_seq_f16(uint16_t *attn_out, const uint16_t *q,
+                           const attention_layer_t *attn,
+                           const attention_seq_t *seq, int layer_idx,
+                           const int64_t *position_ids, void *scratch) {
+  int q_dim = attn->num_heads * attn->head_dim;
+  int total_seq_len = seq->cache_len + seq->num_tokens;
+  float scale = 1.0f / sqrtf((float)attn->head_dim);
+
+  if (seq->num_tokens > 1) {
+    size_t offset = (size_t)seq->row * q_dim;
+    return flash_prefill_f16(attn_out + offset, q + offset, seq->kv,
+                             layer_idx, seq->cache_len, seq->num_tokens,
+                             attn->num_heads, attn->num_kv_heads,
+                             attn->head_dim, scale, scratch);
+  }
 
-  uint16_t *attn_out = (uint16_t *)malloc(seq_len * q_dim * sizeof(uint16_t));
-  if (!attn_out) {
-    free(q);
-    free(k);
-    free(v);
-    return;
+  for (int i = seq->row; i < seq->row + seq->num_tokens; i++) {
+    int limit = total_seq_len;
+    if (position_ids[i] + 1 < limit)
+      limit = (int)position_ids[i] + 1;
+    if (!flash_decode_f16(attn_out + i * q_dim, q + i * q_dim, seq->kv,
+                          layer_idx, limit, attn->num_heads,
+                          attn->num_kv_heads, attn->head_dim, scale, scratch))
+      return false;
+  }
+  return true;
+}
+
+bool attention_forward_f16(uint16_t *output, const uint16_t *input,
+                           const attention_layer_t *attn,
+                           const attention_seq_t *seqs, int num_seqs,
+                           int layer_idx, const int64_t *position_ids,
+                           const uint16_t *cos_sin_cache, int num_rows,
+                           workspace_t *ws) {
+  if (!output || !input || !attn || !seqs || num_seqs <= 0)
+    return false;
+
+  int hidden_size = attn->hidden_size;
+  int num_heads = attn->num_heads;
+  int num_kv_heads = attn->num_kv_heads;
+  int head_dim = attn->head_dim;
+  int q_dim = num_heads * head_dim;
+  int kv_dim = num_kv_heads * head_dim;
+
+  size_t mark = workspace_mark(ws);
+  size_t q_bytes = (size_t)num_rows * q_dim * sizeof(uint16_t);
+  size_t kv_bytes = (size_t)num_rows * kv_dim * sizeof(uint16_t);
+  uint16_t *q = (uint16_t *)workspace_alloc(ws, q_bytes);
+  uint16_t *k = (uint16_t *)workspace_alloc(ws, kv_bytes);
+  uint16_t *v = (uint16_t *)workspace_alloc(ws, kv_bytes);
+  uint16_t *attn_out = (uint16_t *)workspace_alloc(ws, q_bytes);
+  void *scratch = workspace_alloc(ws, attend_scratch_bytes(attn));
+  if (!q || !k || !v || !attn_out || !scratch) {
+    workspace_reset(ws, mark);
+    return false;
+  }
+
+  uint16_t *qkv;
+  if (!project_qkv(q, k, v, (void **)&qkv, input, attn, num_rows, true,
+                   ws)) {
+    workspace_reset(ws, mark);
+    return false;
   }
 
-  for (int i = 0; i < seq_len; i++) {
-    int64_t query_abs_pos = position_ids[i];
-    for (int h = 0; h < num_heads; h++) {
-      int kv_head = h / heads_per_kv;
-      uint16_t *q_head = q + i * q_dim + h * head_dim;
-      uint16_t *out_head = attn_out + i * q_dim + h * head_dim;
-
-      float out_f32_buf[256];
-      memset(out_f32_buf, 0, head_dim * sizeof(float));
-      float M = -1e9f;
-      float sum = 0.0f;
-
-      for (int pos = 0; pos <= query_abs_pos && pos < total_seq_len; pos++) {
-        uint16_t *k_pos =
-            key_cache + pos * num_kv_heads * head_dim + kv_head * head_dim;
-        uint16_t *v_pos =
-            value_cache + pos * num_kv_heads * head_dim + kv_head * head_dim;
-
-#if HAS_NEON
-        float score = dot_product_f16_neon(q_head, k_pos, head_dim) * scale;
-#else
-        float score = 0.0f;
-        for (int d = 0; d < head_dim; d++) {
-          score += f16_to_f32(q_head[d]) * f16_to_f32(k_pos[d]);
-        }
-        score *= scale;
-#endif
-
-        float M_new = (score > M) ? score : M;
-        float alpha = expf(M - M_new);
-        float weight = expf(score - M_new);
-
-#if HAS_NEON
-        scale_accumulate_f16_neon(out_f32_buf, v_pos, alpha, weight, head_dim);
-#else
-        for (int d = 0; d < head_dim; d++) {
-          out_f32_buf[d] =
-              out_f32_buf[d] * alpha + f16_to_f32(v_pos[d]) * weight;
-        }
-#endif
-        sum = sum * alpha + weight;
-        M = M_new;
-      }
-
-      if (sum > 0.0f) {
-#if HAS_NEON
-        f32_to_f16_neon(out_head, out_f32_buf, 1.0f / sum, head_dim);
-#else
-        for (int d = 0; d < head_dim; d++) {
-          out_head[d] = f32_to_f16(out_f32_buf[d] / sum);
-        }
-#endif
-      }
+  /* Row sources: the stacked output when there is one, else q, k and v */
+  int qkv_dim = q_dim + 2 * kv_dim;
+  const uint16_t *q_src = qkv ? qkv : q;
+  const uint16_t *k_src = qkv ? qkv + q_dim : k;
+  const uint16_t *v_src = qkv ? qkv + q_dim + kv_dim : v;
+  size_t q_ld = qkv ? (size_t)qkv_dim : (size_t)q_dim;
+  size_t kv_ld = qkv ? (size_t)qkv_dim : (size_t)kv_dim;
+
+  bool qk_norm = attn->has_qk_norm && attn->q_norm && attn->k_norm;
+  gather_heads_f16(q, q_src, q_ld,
+                   qk_norm ? tensor_data_f16_const(attn->q_norm) : NULL,
+                   num_rows, num_heads, head_dim);
+  gather_heads_f16(k, k_src, kv_ld,
+                   qk_norm ? tensor_data_f16_const(attn->k_norm) : NULL,
+                   num_rows, num_kv_heads, head_dim);
+
+  rope_f16(position_ids, q, k, cos_sin_cache, num_rows, num_heads,
+           num_kv_heads, head_dim, head_dim, true);
+
+  for (int s = 0; s < num_seqs; s++) {
+    const attention_seq_t *seq = &seqs[s];
+    append_kv_f16(seq, layer_idx, k, v_src, kv_ld, kv_dim);
+    if (!attend_seq_f16(attn_out, q, attn, seq, layer_idx, position_ids,
+                        scratch)) {
+      workspace_reset(ws, mark);
+      return false;
     }
   }
 
-  gemm_f16(attn_out, o_w, output, seq_len, hidden_size, q_dim);
+  linear_forward_f16(output, attn_out, attn->o_proj, num_rows, hidden_size,
+                     q_dim, ws);
 
-  free(q);
-  free(k);
-  free(v);
-  free(attn_out);
+  workspace_reset(ws, mark);
+  return true;
 }
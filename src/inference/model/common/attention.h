@@ -2,6 +2,8 @@
 #define INFERENCE_MODEL_COMMON_ATTENTION_H
 
 #include "inference/core/tensor.h"
+#include "inference/core/workspace.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
 #include <stdbool.h>
 #include <stdint.h>
 
@@ -9,6 +11,8 @@ typedef struct {
   tensor_t *q_proj;
   tensor_t *k_proj;
   tensor_t *v_proj;
+  tensor_t *qkv_proj; /* q, k and v stacked along the outputs, or NULL to
+                         use the separate projections */
   tensor_t *o_proj;
   tensor_t *q_norm;
   tensor_t *k_norm;
@@ -32,16 +36,42 @@ typedef struct {
   dtype_t dtype;
 } kv_cache_t;
 
-void attention_forward_f32(float *output, const float *input,
-                           const attention_layer_t *attn, float *key_cache,
-                           float *value_cache, const int64_t *position_ids,
-                           const float *cos_sin_cache, int seq_len,
-                           int cache_len);
-
-void attention_forward_f16(uint16_t *output, const uint16_t *input,
-                           const attention_layer_t *attn, uint16_t *key_cache,
-                           uint16_t *value_cache, const int64_t *position_ids,
-                           const uint16_t *cos_sin_cache, int seq_len,
-                           int cache_len);
+/*
+ * One sequence's slice of a batched forward pass. Rows [row, row + num_tokens)
+ * of the activations belong to the sequence; their K/V are written to
+ * positions [cache_len, cache_len + num_tokens) of kv, which must already
+ * have pages mapped for them.
+ */
+typedef struct {
+  const kv_block_table_t *kv;
+  int row;
+  int num_tokens;
+  int cache_len;
+} attention_seq_t;
+
+/*
+ * Projections run once over all num_rows rows, so the weights are streamed
+ * once per batch; attention itself is evaluated per sequence. Q/K/V and
+ * the attention output are taken from ws.
+ *
+ * Returns: false on bad arguments or if ws has no room
+ */
+bool attention_forward_f32(float *output, const float *input,
+                           const attention_layer_t *attn,
+                           const attention_seq_t *seqs, int num_seqs,
+                           int layer_idx, const int64_t *position_ids,
+                           const float *cos_sin_cache, int num_rows,
+                           workspace_t *ws);
+
+bool attention_forward_f16(uint16_t *output, const uint16_t *input,
+                           const attention_layer_t *attn,
+                           const attention_seq_t *seqs, int num_seqs,
+                           int layer_idx, const int64_t *position_ids,
+                           const uint16_t *cos_sin_cache, int num_rows,
+                           workspace_t *ws);
+
+/* Workspace bytes attention_forward_*() takes for num_rows of elem_size */
+size_t attention_workspace_bytes(const attention_layer_t *attn, int num_rows,
+                                 size_t elem_size);
 
 #endif
@@ -1,33 +1,106 @@
 #include "ffn.h"
+#include "inference/model/common/linear.h"
 #include "inference/ops/activation.h"
-#include "inference/ops/gemm.h"
-#include <stdlib.h>
 #include <string.h>
 
-void ffn_forward_f32(float *output, const float *input, const ffn_layer_t *ffn,
-                     int seq_len) {
+static size_t max_size(size_t a, size_t b) { return a > b ? a : b; }
+
+size_t ffn_workspace_bytes(const ffn_layer_t *ffn, int seq_len,
+                           size_t elem_size) {
+  int hidden_size = ffn->hidden_size;
+  int intermediate_size = ffn->intermediate_size;
+  size_t inter = workspace_slice_bytes((size_t)seq_len * intermediate_size *
+                                       elem_size);
+  /* gate and up, plus gate_up and the activation output for F16 */
+  size_t buffers = elem_size == sizeof(float) ? 2 * inter : 5 * inter;
+
+  size_t down = linear_workspace_bytes(ffn->down_proj, seq_len, hidden_size,
+                                       intermediate_size);
+  if (ffn->gate_up_proj) {
+    /* The activation output, then the gated projection's staging */
+    size_t glu = linear_glu_workspace_bytes(ffn->gate_up_proj, seq_len,
+                                            intermediate_size, hidden_size,
+                                            elem_size);
+    return inter + max_size(glu, down);
+  }
+
+  size_t linear = max_size(
+      max_size(linear_workspace_bytes(ffn->gate_proj, seq_len,
+                                      intermediate_size, hidden_size),
+               linear_workspace_bytes(ffn->up_proj, seq_len,
+                                      intermediate_size, hidden_size)),
+      down);
+  return buffers + linear;
+}
+
+/* One projection of the stacked gate|up weights, activation included */
+static bool ffn_fused_f32(float *output, const float *input,
+                          const ffn_layer_t *ffn, int seq_len,
+                          workspace_t *ws) {
+  int hidden_size = ffn->hidden_size;
+  int intermediate_size = ffn->intermediate_size;
+
+  size_t mark = workspace_mark(ws);
+  float *act = (float *)workspace_alloc(
+      ws, (size_t)seq_len * intermediate_size * sizeof(float));
+  if (!act ||
+      !linear_glu_forward_f32(act, input, ffn->gate_up_proj, seq_len,
+                              intermediate_size, hidden_size,
+                              ffn->activation, ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
+  linear_forward_f32(output, act, ffn->down_proj, seq_len, hidden_size,
+                     intermediate_size, ws);
+  workspace_reset(ws, mark);
+  return true;
+}
+
+static bool ffn_fused_f16(uint16_t *output, const uint16_t *input,
+                          const ffn_layer_t *ffn, int seq_len,
+                          workspace_t *ws) {
+  int hidden_size = ffn->hidden_size;
+  int intermediate_size = ffn->intermediate_size;
+
+  size_t mark = workspace_mark(ws);
+  uint16_t *act = (uint16_t *)workspace_alloc(
+      ws, (size_t)seq_len * intermediate_size * sizeof(uint16_t));
+  if (!act ||
+      !linear_glu_forward_f16(act, input, ffn->gate_up_proj, seq_len,
+                              intermediate_size, hidden_size,
+                              ffn->activation, ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
+  linear_forward_f16(output, act, ffn->down_proj, seq_len, hidden_size,
+                     intermediate_size, ws);
+  workspace_reset(ws, mark);
+  return true;
+}
+
+bool ffn_forward_f32(float *output, const float *input, const ffn_layer_t *ffn,
+                     int seq_len, workspace_t *ws) {
   if (!output || !input || !ffn)
-    return;
+    return false;
+  if (ffn->gate_up_proj)
+    return ffn_fused_f32(output, input, ffn, seq_len, ws);
 
   int hidden_size = ffn->hidden_size;
   int intermediate_size = ffn->intermediate_size;
+  size_t bytes = (size_t)seq_len * intermediate_size * sizeof(float);
 
-  float *gate = (float *)malloc(seq_len * intermediate_size * sizeof(float));
-  float *up = (float *)malloc(seq_len * intermediate_size * sizeof(float));
+  size_t mark = workspace_mark(ws);
+  float *gate = (float *)workspace_alloc(ws, bytes);
+  float *up = (float *)workspace_alloc(ws, bytes);
   if (!gate || !up) {
-    free(gate);
-    free(up);
-    return;
+    workspace_reset(ws, mark);
+    return false;
   }
 
-  const float *gate_w = tensor_data_f32_const(ffn->gate_proj);
-  const float *up_w = tensor_data_f32_const(ffn->up_proj);
-  const float *down_w = tensor_data_f32_const(ffn->down_proj);
-
-  gemm_f32(input, gate_w, gate, seq_len, intermediate_size, hidden_size, false,
-           true);
-  gemm_f32(input, up_w, up, seq_len, intermediate_size, hidden_size, false,
-           true);
+  linear_forward_f32(gate, input, ffn->gate_proj, seq_len, intermediate_size,
+                     hidden_size, ws);
+  linear_forward_f32(up, input, ffn->up_proj, seq_len, intermediate_size,
+                     hidden_size, ws);
 
   switch (ffn->activation) {
   case ACT_SILU:
@@ -51,44 +124,38 @@ void ffn_forward_f32(float *output, const float *input, const ffn_layer_t *ffn,
     gate[i] = gate[i] * up[i];
   }
 
-  gemm_f32(gate, down_w, output, seq_len, hidden_size, intermediate_size, false,
-           true);
+  linear_forward_f32(output, gate, ffn->down_proj, seq_len, hidden_size,
+                     intermediate_size, ws);
 
-  free(gate);
-  free(up);
+  workspace_reset(ws, mark);
+  return true;
 }
 
-void ffn_forward_f16(uint16_t *output, const uint16_t *input,
-                     const ffn_layer_t *ffn, int seq_len) {
+bool ffn_forward_f16(uint16_t *output, const uint16_t *input,
+                     const ffn_layer_t *ffn, int seq_len, workspace_t *ws) {
   if (!output || !input || !ffn)
-    return;
+    return false;
+  if (ffn->gate_up_proj)
+    return ffn_fused_f16(output, input, ffn, seq_len, ws);
 
   int hidden_size = ffn->hidden_size;
   int intermediate_size = ffn->intermediate_size;
+  size_t bytes = (size_t)seq_len * intermediate_size * sizeof(uint16_t);
 
-  uint16_t *gate =
-      (uint16_t *)malloc(seq_len * intermediate_size * sizeof(uint16_t));
-  uint16_t *up =
-      (uint16_t *)malloc(seq_len * intermediate_size * sizeof(uint16_t));
-  uint16_t *gate_up =
-      (uint16_t *)malloc(seq_len * intermediate_size * 2 * sizeof(uint16_t));
-  uint16_t *gate_out =
-      (uint16_t *)malloc(seq_len * intermediate_size * sizeof(uint16_t));
-
+  size_t mark = workspace_mark(ws);
+  uint16_t *gate = (uint16_t *)workspace_alloc(ws, bytes);
+  uint16_t *up = (uint16_t *)workspace_alloc(ws, bytes);
+  uint16_t *gate_up = (uint16_t *)workspace_alloc(ws, 2 * bytes);
+  uint16_t *gate_out = (uint16_t *)workspace_alloc(ws, bytes);
   if (!gate || !up || !gate_up || !gate_out) {
-    free(gate);
-    free(up);
-    free(gate_up);
-    free(gate_out);
-    return;
+    workspace_reset(ws, mark);
+    return false;
   }
 
-  const uint16_t *gate_w = tensor_data_f16_const(ffn->gate_proj);
-  const uint16_t *up_w = tensor_data_f16_const(ffn->up_proj);
-  const uint16_t *down_w = tensor_data_f16_const(ffn->down_proj);
-
-  gemm_f16(input, gate_w, gate, seq_len, intermediate_size, hidden_size);
-  gemm_f16(input, up_w, up, seq_len, intermediate_size, hidden_size);
+  linear_forward_f16(gate, input, ffn->gate_proj, seq_len, intermediate_size,
+                     hidden_size, ws);
+  linear_forward_f16(up, input, ffn->up_proj, seq_len, intermediate_size,
+                     hidden_size, ws);
 
   for (int i = 0; i < seq_len; i++) {
     memcpy(gate_up + i * 2 * intermediate_size, gate + i * intermediate_size,
@@ -115,10 +182,9 @@ void ffn_forward_f16(uint16_t *output, const uint16_t *input,
     break;
   }
 
-  gemm_f16(gate_out, down_w, output, seq_len, hidden_size, intermediate_size);
+  linear_forward_f16(output, gate_out, ffn->down_proj, seq_len, hidden_size,
+                     intermediate_size, ws);
 
-  free(gate);
-  free(up);
-  free(gate_up);
-  free(gate_out);
+  workspace_reset(ws, mark);
+  return true;
 }
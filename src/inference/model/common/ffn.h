@@ -2,12 +2,15 @@
 #define INFERENCE_MODEL_COMMON_FFN_H
 
 #include "inference/core/tensor.h"
+#include "inference/core/workspace.h"
 #include "inference/model/config.h"
 #include <stdint.h>
 
 typedef struct {
   tensor_t *gate_proj;
   tensor_t *up_proj;
+  tensor_t *gate_up_proj; /* gate and up stacked along the outputs, or NULL
+                             to use gate_proj and up_proj */
   tensor_t *down_proj;
   int hidden_size;
   int intermediate_size;
@@ -18,9 +21,17 @@ typedef struct {
   tensor_t *down_bias;
 } ffn_layer_t;
 
-void ffn_forward_f32(float *output, const float *input, const ffn_layer_t *ffn,
-                     int seq_len);
-void ffn_forward_f16(uint16_t *output, const uint16_t *input,
-                     const ffn_layer_t *ffn, int seq_len);
+/*
+ * Scratch (gate, up and staging buffers) comes from ws.
+ * Returns: false if ws has no room for it
+ */
+bool ffn_forward_f32(float *output, const float *input, const ffn_layer_t *ffn,
+                     int seq_len, workspace_t *ws);
+bool ffn_forward_f16(uint16_t *output, const uint16_t *input,
+                     const ffn_layer_t *ffn, int seq_len, workspace_t *ws);
+
+/* Workspace bytes ffn_forward_*() takes for seq_len rows of elem_size */
+size_t ffn_workspace_bytes(const ffn_layer_t *ffn, int seq_len,
+                           size_t elem_size);
 
 #endif
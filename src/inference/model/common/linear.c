@@ -0,0 +1,199 @@
+#include "linear.h"
+#include "inference/ops/activation.h"
+#include "inference/ops/gemm.h"
+#include "inference/ops/gemv.h"
+#include "inference/ops/quant.h"
+#include <stdlib.h>
+
+size_t linear_workspace_bytes(const tensor_t *w, int rows, int out_features,
+                              int in_features) {
+  if (dtype_is_quantized(w->dtype))
+    return workspace_slice_bytes(gemm_quant_scratch_bytes(rows, in_features));
+  if (w->dtype == DTYPE_F16 && rows == 1)
+    return workspace_slice_bytes((size_t)in_features * sizeof(float)) +
+           workspace_slice_bytes((size_t)out_features * sizeof(float));
+  return 0;
+}
+
+void linear_forward_f32(float *output, const float *input, const tensor_t *w,
+                        int rows, int out_features, int in_features,
+                        workspace_t *ws) {
+  if (dtype_is_quantized(w->dtype)) {
+    size_t mark = workspace_mark(ws);
+    void *scratch =
+        workspace_alloc(ws, gemm_quant_scratch_bytes(rows, in_features));
+    if (scratch)
+      gemm_quant_f32_scratch(input, tensor_data_const(w), w->dtype, output,
+                             rows, out_features, in_features, scratch);
+    else
+      gemm_quant_f32(input, tensor_data_const(w), w->dtype, output, rows,
+                     out_features, in_features);
+    workspace_reset(ws, mark);
+    return;
+  }
+  /* Decode is a single row: stream the weights once through the GEMV */
+  if (rows == 1) {
+    gemv_f32(tensor_data_f32_const(w), input, output, out_features,
+             in_features, false);
+    return;
+  }
+  gemm_f32(input, tensor_data_f32_const(w), output, rows, out_features,
+           in_features, false, true);
+}
+
+/* One F16 row through the GEMV with F32 staging; false if out of memory */
+static bool linear_gemv_f16(uint16_t *output, const uint16_t *input,
+                            const tensor_t *w, int out_features,
+                            int in_features, workspace_t *ws) {
+  size_t x_bytes = (size_t)in_features * sizeof(float);
+  size_t y_bytes = (size_t)out_features * sizeof(float);
+  size_t mark = workspace_mark(ws);
+  float *x = (float *)workspace_alloc(ws, x_bytes);
+  float *y = (float *)workspace_alloc(ws, y_bytes);
+  bool heap = !x || !y;
+  if (heap) {
+    workspace_reset(ws, mark);
+    x = (float *)malloc(x_bytes);
+    y = (float *)malloc(y_bytes);
+  }
+
+  bool ok = x && y;
+  if (ok) {
+    f16_to_f32_array(input, x, (size_t)in_features);
+    gemv_f16(tensor_data_f16_const(w), x, y, out_features, in_features, true);
+    f32_to_f16_array(y, output, (size_t)out_features);
+  }
+  if (heap) {
+    free(x);
+    free(y);
+  }
+  workspace_reset(ws, mark);
+  return ok;
+}
+
+void linear_forward_f16(uint16_t *output, const uint16_t *input,
+                        const tensor_t *w, int rows, int out_features,
+                        int in_features, workspace_t *ws) {
+  if (dtype_is_quantized(w->dtype)) {
+    size_t mark = workspace_mark(ws);
+    void *scratch =
+        workspace_alloc(ws, gemm_quant_scratch_bytes(rows, in_features));
+    if (scratch)
+      gemm_quant_f16_scratch(input, tensor_data_const(w), w->dtype, output,
+                             rows, out_features, in_features, scratch);
+    else
+      gemm_quant_f16(input, tensor_data_const(w), w->dtype, output, rows,
+                     out_features, in_features);
+    workspace_reset(ws, mark);
+    return;
+  }
+  if (rows == 1 &&
+      linear_gemv_f16(output, input, w, out_features, in_features, ws))
+    return;
+  gemm_f16(input, tensor_data_f16_const(w), output, rows, out_features,
+           in_features);
+}
+
+typedef void (*glu_f16_fn)(uint16_t *out, const uint16_t *input,
+                           int num_tokens, int d);
+
+static gemv_glu_fn glu_f32(activation_type_t act) {
+  switch (act) {
+  case ACT_GELU:
+    return gelu_and_mul_f32;
+  case ACT_GELU_TANH:
+    return gelu_tanh_and_mul_f32;
+  case ACT_GELU_QUICK:
+    return gelu_quick_and_mul_f32;
+  default:
+    return silu_and_mul_f32;
+  }
+}
+
+static glu_f16_fn glu_f16(activation_type_t act) {
+  switch (act) {
+  case ACT_GELU:
+    return gelu_and_mul_f16;
+  case ACT_GELU_TANH:
+    return gelu_tanh_and_mul_f16;
+  case ACT_GELU_QUICK:
+    return gelu_quick_and_mul_f16;
+  default:
+    return silu_and_mul_f16;
+  }
+}
+
+/* A single row of dense weights takes the fused GEMV epilogue */
+static bool glu_fused(const tensor_t *w, int rows) {
+  return rows == 1 && !dtype_is_quantized(w->dtype);
+}
+
+size_t linear_glu_workspace_bytes(const tensor_t *w, int rows,
+                                  int out_features, int in_features,
+                                  size_t elem_size) {
+  if (glu_fused(w, rows)) {
+    if (w->dtype == DTYPE_F32)
+      return 0;
+    return workspace_slice_bytes((size_t)in_features * sizeof(float)) +
+           workspace_slice_bytes((size_t)out_features * sizeof(float));
+  }
+  size_t gate_up = workspace_slice_bytes((size_t)rows * 2 * out_features *
+                                         elem_size);
+  return gate_up +
+         linear_workspace_bytes(w, rows, 2 * out_features, in_features);
+}
+
+bool linear_glu_forward_f32(float *output, const float *input,
+                            const tensor_t *w, int rows, int out_features,
+                            int in_features, activation_type_t act,
+                            workspace_t *ws) {
+  if (glu_fused(w, rows)) {
+    gemv_glu_f32(tensor_data_f32_const(w), input, output, out_features,
+                 in_features, false, glu_f32(act));
+    return true;
+  }
+
+  size_t mark = workspace_mark(ws);
+  float *gate_up = (float *)workspace_alloc(
+      ws, (size_t)rows * 2 * out_features * sizeof(float));
+  if (!gate_up)
+    return false;
+  linear_forward_f32(gate_up, input, w, rows, 2 * out_features, in_features,
+                     ws);
+  glu_f32(act)(output, gate_up, rows, out_features);
+  workspace_reset(ws, mark);
+  return true;
+}
+
+bool linear_glu_forward_f16(uint16_t *output, const uint16_t *input,
+                            const tensor_t *w, int rows, int out_features,
+                            int in_features, activation_type_t act,
+                            workspace_t *ws) {
+  size_t mark = workspace_mark(ws);
+  if (glu_fused(w, rows)) {
+    float *x =
+        (float *)workspace_alloc(ws, (size_t)in_features * sizeof(float));
+    float *y =
+        (float *)workspace_alloc(ws, (size_t)out_features * sizeof(float));
+    if (!x || !y) {
+      workspace_reset(ws, mark);
+      return false;
+    }
+    f16_to_f32_array(input, x, (size_t)in_features);
+    gemv_glu_f16(tensor_data_f16_const(w), x, y, out_features, in_features,
+                 true, glu_f32(act));
+    f32_to_f16_array(y, output, (size_t)out_features);
+    workspace_reset(ws, mark);
+    return true;
+  }
+
+  uint16_t *gate_up = (uint16_t *)workspace_alloc(
+      ws, (size_t)rows * 2 * out_features * sizeof(uint16_t));
+  if (!gate_up)
+    return false;
+  linear_forward_f16(gate_up, input, w, rows, 2 * out_features, in_features,
+                     ws);
+  glu_f16(act)(output, gate_up, rows, out_features);
+  workspace_reset(ws, mark);
+  return true;
+}
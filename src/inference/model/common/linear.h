@@ -0,0 +1,53 @@
+#ifndef INFERENCE_MODEL_COMMON_LINEAR_H
+#define INFERENCE_MODEL_COMMON_LINEAR_H
+
+#include "inference/core/tensor.h"
+#include "inference/core/workspace.h"
+#include "inference/model/config.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ * output[rows, out_features] = input[rows, in_features] x W^T
+ *
+ * Dispatches on the weight dtype: F32 weights are stored [out, in], F16
+ * weights are pre-transposed to [in, out], and Q8_0 / Q4_0 weights are
+ * block-quantized [out, in] rows. Staging buffers come from ws; without
+ * room there they fall back to the heap.
+ */
+void linear_forward_f32(float *output, const float *input, const tensor_t *w,
+                        int rows, int out_features, int in_features,
+                        workspace_t *ws);
+void linear_forward_f16(uint16_t *output, const uint16_t *input,
+                        const tensor_t *w, int rows, int out_features,
+                        int in_features, workspace_t *ws);
+
+/* Workspace bytes linear_forward_*() takes for these dimensions */
+size_t linear_workspace_bytes(const tensor_t *w, int rows, int out_features,
+                              int in_features);
+
+/*
+ * output[rows, out_features] = act(input x W_gate^T) * (input x W_up^T)
+ *
+ * w holds the gate and up projections stacked along its outputs (2 *
+ * out_features of them, gate first) in the layout linear_forward_*() takes.
+ * A single row of dense weights applies act in the GEMV epilogue; otherwise
+ * the [rows, 2 * out_features] product is staged in ws and act runs over it.
+ *
+ * Returns: false if ws has no room for the staging buffers
+ */
+bool linear_glu_forward_f32(float *output, const float *input,
+                            const tensor_t *w, int rows, int out_features,
+                            int in_features, activation_type_t act,
+                            workspace_t *ws);
+bool linear_glu_forward_f16(uint16_t *output, const uint16_t *input,
+                            const tensor_t *w, int rows, int out_features,
+                            int in_features, activation_type_t act,
+                            workspace_t *ws);
+
+/* Workspace bytes linear_glu_forward_*() takes with elem_size activations */
+size_t linear_glu_workspace_bytes(const tensor_t *w, int rows,
+                                  int out_features, int in_features,
+                                  size_t elem_size);
+
+#endif
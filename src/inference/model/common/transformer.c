@@ -1,35 +1,37 @@
 #include "transformer.h"
 #include "inference/core/dtype.h"
 #include "inference/ops/norm.h"
-#include <stdlib.h>
 #include <string.h>
 
-void transformer_layer_forward_f32(float *output, const float *input,
+bool transformer_layer_forward_f32(float *output, const float *input,
                                    const transformer_layer_t *layer,
-                                   float *key_cache, float *value_cache,
-                                   const int64_t *position_ids,
+                                   const attention_seq_t *seqs, int num_seqs,
+                                   int layer_idx, const int64_t *position_ids,
                                    const float *cos_sin_cache, int seq_len,
-                                   int cache_len, int hidden_size) {
+                                   int hidden_size, workspace_t *ws) {
   if (!output || !input || !layer)
-    return;
+    return false;
 
-  float *normed = (float *)malloc(seq_len * hidden_size * sizeof(float));
-  float *attn_out = (float *)malloc(seq_len * hidden_size * sizeof(float));
-  float *residual = (float *)malloc(seq_len * hidden_size * sizeof(float));
+  size_t bytes = (size_t)seq_len * hidden_size * sizeof(float);
+  size_t mark = workspace_mark(ws);
+  float *normed = (float *)workspace_alloc(ws, bytes);
+  float *attn_out = (float *)workspace_alloc(ws, bytes);
+  float *residual = (float *)workspace_alloc(ws, bytes);
   if (!normed || !attn_out || !residual) {
-    free(normed);
-    free(attn_out);
-    free(residual);
-    return;
+    workspace_reset(ws, mark);
+    return false;
   }
 
   const float *norm_w = tensor_data_f32_const(layer->input_norm);
   (void)layer->norm_type;
   rms_norm_f32(normed, input, norm_w, layer->norm_eps, seq_len, hidden_size);
 
-  attention_forward_f32(attn_out, normed, &layer->attention, key_cache,
-                        value_cache, position_ids, cos_sin_cache, seq_len,
-                        cache_len);
+  if (!attention_forward_f32(attn_out, normed, &layer->attention, seqs,
+                             num_seqs, layer_idx, position_ids, cos_sin_cache,
+                             seq_len, ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
 
   for (int i = 0; i < seq_len * hidden_size; i++) {
     residual[i] = input[i] + attn_out[i];
@@ -39,45 +41,47 @@ void transformer_layer_forward_f32(float *output, const float *input,
   rms_norm_f32(normed, residual, post_norm_w, layer->norm_eps, seq_len,
                hidden_size);
 
-  ffn_forward_f32(attn_out, normed, &layer->ffn, seq_len);
+  if (!ffn_forward_f32(attn_out, normed, &layer->ffn, seq_len, ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
 
   for (int i = 0; i < seq_len * hidden_size; i++) {
     output[i] = residual[i] + attn_out[i];
   }
 
-  free(normed);
-  free(attn_out);
-  free(residual);
+  workspace_reset(ws, mark);
+  return true;
 }
 
-void transformer_layer_forward_f16(uint16_t *output, const uint16_t *input,
+bool transformer_layer_forward_f16(uint16_t *output, const uint16_t *input,
                                    const transformer_layer_t *layer,
-                                   uint16_t *key_cache, uint16_t *value_cache,
-                                   const int64_t *position_ids,
+                                   const attention_seq_t *seqs, int num_seqs,
+                                   int layer_idx, const int64_t *position_ids,
                                    const uint16_t *cos_sin_cache, int seq_len,
-                                   int cache_len, int hidden_size) {
+                                   int hidden_size, workspace_t *ws) {
   if (!output || !input || !layer)
-    return;
-
-  uint16_t *normed =
-      (uint16_t *)malloc(seq_len * hidden_size * sizeof(uint16_t));
-  uint16_t *attn_out =
-      (uint16_t *)malloc(seq_len * hidden_size * sizeof(uint16_t));
-  uint16_t *residual =
-      (uint16_t *)malloc(seq_len * hidden_size * sizeof(uint16_t));
+    return false;
+
+  size_t bytes = (size_t)seq_len * hidden_size * sizeof(uint16_t);
+  size_t mark = workspace_mark(ws);
+  uint16_t *normed = (uint16_t *)workspace_alloc(ws, bytes);
+  uint16_t *attn_out = (uint16_t *)workspace_alloc(ws, bytes);
+  uint16_t *residual = (uint16_t *)workspace_alloc(ws, bytes);
   if (!normed || !attn_out || !residual) {
-    free(normed);
-    free(attn_out);
-    free(residual);
-    return;
+    workspace_reset(ws, mark);
+    return false;
   }
 
   const uint16_t *norm_w = tensor_data_f16_const(layer->input_norm);
   rms_norm_f16(normed, input, norm_w, layer->norm_eps, seq_len, hidden_size);
 
-  attention_forward_f16(attn_out, normed, &layer->attention, key_cache,
-                        value_cache, position_ids, cos_sin_cache, seq_len,
-                        cache_len);
+  if (!attention_forward_f16(attn_out, normed, &layer->attention, seqs,
+                             num_seqs, layer_idx, position_ids, cos_sin_cache,
+                             seq_len, ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
 
   /* Residual connection: residual = input + attn_out */
   for (int i = 0; i < seq_len * hidden_size; i++) {
@@ -90,7 +94,10 @@ void transformer_layer_forward_f16(uint16_t *output, const uint16_t *input,
   rms_norm_f16(normed, residual, post_norm_w, layer->norm_eps, seq_len,
                hidden_size);
 
-  ffn_forward_f16(attn_out, normed, &layer->ffn, seq_len);
+  if (!ffn_forward_f16(attn_out, normed, &layer->ffn, seq_len, ws)) {
+    workspace_reset(ws, mark);
+    return false;
+  }
 
   /* Residual connection: output = residual + ffn_out */
   for (int i = 0; i < seq_len * hidden_size; i++) {
@@ -99,7 +106,17 @@ void transformer_layer_forward_f16(uint16_t *output, const uint16_t *input,
     output[i] = f32_to_f16(a + b);
   }
 
-  free(normed);
-  free(attn_out);
-  free(residual);
+  workspace_reset(ws, mark);
+  return true;
+}
+
+size_t transformer_layer_workspace_bytes(const transformer_layer_t *layer,
+                                         int seq_len, int hidden_size,
+                                         size_t elem_size) {
+  size_t act =
+      workspace_slice_bytes((size_t)seq_len * hidden_size * elem_size);
+  size_t attn =
+      attention_workspace_bytes(&layer->attention, seq_len, elem_size);
+  size_t ffn = ffn_workspace_bytes(&layer->ffn, seq_len, elem_size);
+  return 3 * act + (attn > ffn ? attn : ffn);
 }
@@ -32,18 +32,29 @@ typedef struct {
   dtype_t dtype;
 } transformer_model_t;
 
-void transformer_layer_forward_f32(float *output, const float *input,
+/*
+ * seq_len is the total number of rows across all of seqs. Every
+ * intermediate activation is taken from ws and released before returning.
+ *
+ * Returns: false if ws has no room for the layer
+ */
+bool transformer_layer_forward_f32(float *output, const float *input,
                                    const transformer_layer_t *layer,
-                                   float *key_cache, float *value_cache,
-                                   const int64_t *position_ids,
+                                   const attention_seq_t *seqs, int num_seqs,
+                                   int layer_idx, const int64_t *position_ids,
                                    const float *cos_sin_cache, int seq_len,
-                                   int cache_len, int hidden_size);
+                                   int hidden_size, workspace_t *ws);
 
-void transformer_layer_forward_f16(uint16_t *output, const uint16_t *input,
+bool transformer_layer_forward_f16(uint16_t *output, const uint16_t *input,
                                    const transformer_layer_t *layer,
-                                   uint16_t *key_cache, uint16_t *value_cache,
-                                   const int64_t *position_ids,
+                                   const attention_seq_t *seqs, int num_seqs,
+                                   int layer_idx, const int64_t *position_ids,
                                    const uint16_t *cos_sin_cache, int seq_len,
-                                   int cache_len, int hidden_size);
+                                   int hidden_size, workspace_t *ws);
+
+/* Workspace bytes transformer_layer_forward_*() takes for seq_len rows */
+size_t transformer_layer_workspace_bytes(const transformer_layer_t *layer,
+                                         int seq_len, int hidden_size,
+                                         size_t elem_size);
 
 #endif
@@ -1,11 +1,23 @@
 #include "qwen3.h"
+#include "inference/backend/threadpool.h"
 #include "inference/core/dtype.h"
+#include "inference/model/common/linear.h"
 #include "inference/model/common/transformer.h"
 #include "inference/ops/ops.h"
+#include <limits.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Default prefix cache budget, SILLYTUI_PREFIX_CACHE_MB overrides it */
+#define QWEN3_PREFIX_CACHE_MB 1024
+
+/* Rows the workspace is sized for at load, besides a decode step */
+#define QWEN3_WORKSPACE_ROWS 64
+
+/* Default prefill chunk in tokens, SILLYTUI_PREFILL_CHUNK overrides it */
+#define QWEN3_PREFILL_CHUNK 512
+
 /**
  * Build a transformer_layer_t from qwen3 layer weights.
  * This adapts the qwen3-specific weight layout to the common interface.
@@ -17,6 +29,7 @@ static void build_transformer_layer(transformer_layer_t *layer,
   layer->attention.q_proj = weights->q_proj;
   layer->attention.k_proj = weights->k_proj;
   layer->attention.v_proj = weights->v_proj;
+  layer->attention.qkv_proj = weights->qkv_proj;
   layer->attention.o_proj = weights->o_proj;
   layer->attention.q_norm = weights->q_norm;
   layer->attention.k_norm = weights->k_norm;
@@ -32,6 +45,7 @@ static void build_transformer_layer(transformer_layer_t *layer,
   /* FFN layer */
   layer->ffn.gate_proj = weights->gate_proj;
   layer->ffn.up_proj = weights->up_proj;
+  layer->ffn.gate_up_proj = weights->gate_up_proj;
   layer->ffn.down_proj = weights->down_proj;
   layer->ffn.hidden_size = config->hidden_size;
   layer->ffn.intermediate_size = config->intermediate_size;
@@ -48,8 +62,91 @@ static void build_transformer_layer(transformer_layer_t *layer,
   layer->norm_eps = config->norm_eps;
 }
 
+static size_t prefix_cache_mb(void) {
+  const char *mb = getenv("SILLYTUI_PREFIX_CACHE_MB");
+  if (mb && *mb)
+    return (size_t)strtoul(mb, NULL, 10);
+  return QWEN3_PREFIX_CACHE_MB;
+}
+
+static int prefill_chunk(void) {
+  const char *chunk = getenv("SILLYTUI_PREFILL_CHUNK");
+  if (chunk && *chunk)
+    return atoi(chunk);
+  return QWEN3_PREFILL_CHUNK;
+}
+
+/*
+ * KV cache element size: the activation dtype, or KV_CACHE_INT8 when
+ * SILLYTUI_KV_CACHE=int8 asks for the quantized cache (half of FP16)
+ */
+static size_t kv_elem_size(dtype_t dtype) {
+  const char *kv = getenv("SILLYTUI_KV_CACHE");
+  if (kv && strcmp(kv, "int8") == 0)
+    return KV_CACHE_INT8;
+  return dtype_size(dtype);
+}
+
+static size_t max_size(size_t a, size_t b) { return a > b ? a : b; }
+
+/* Workspace bytes of the final norm and lm_head over num_rows rows */
+static size_t logits_workspace_bytes(const qwen3_model_t *model,
+                                     int num_rows) {
+  int hidden_size = model->config.hidden_size;
+  int vocab_size = model->config.vocab_size;
+  const tensor_t *lm_head = model->weights.lm_head;
+
+  if (model->dtype != DTYPE_F16)
+    return linear_workspace_bytes(lm_head, num_rows, vocab_size, hidden_size);
+  if (dtype_is_quantized(lm_head->dtype))
+    return workspace_slice_bytes((size_t)num_rows * hidden_size *
+                                 sizeof(float)) +
+           linear_workspace_bytes(lm_head, num_rows, vocab_size, hidden_size);
+  if (num_rows == 1)
+    return workspace_slice_bytes((size_t)hidden_size * sizeof(float));
+  return workspace_slice_bytes((size_t)num_rows * vocab_size *
+                               sizeof(uint16_t));
+}
+
+/* Workspace bytes of a forward pass over num_rows rows of num_seqs seqs */
+static size_t forward_workspace_bytes(const qwen3_model_t *model, int num_rows,
+                                      int num_seqs) {
+  int hidden_size = model->config.hidden_size;
+  size_t elem_size = dtype_size(model->dtype);
+  size_t act = workspace_slice_bytes((size_t)num_rows * hidden_size *
+                                     elem_size);
+
+  size_t bytes = workspace_slice_bytes(num_seqs * sizeof(attention_seq_t));
+  bytes += 2 * workspace_slice_bytes(num_rows * sizeof(int64_t));
+  bytes += 2 * act;
+  bytes += workspace_slice_bytes((size_t)num_seqs * hidden_size * elem_size);
+
+  size_t inner = logits_workspace_bytes(model, num_seqs);
+  for (int i = 0; i < model->config.num_hidden_layers; i++) {
+    transformer_layer_t layer;
+    build_transformer_layer(&layer, &model->weights.layers[i],
+                            &model->config);
+    inner = max_size(inner, transformer_layer_workspace_bytes(
+                                &layer, num_rows, hidden_size, elem_size));
+  }
+  return bytes + inner;
+}
+
+static int round_up_pow2(int n) {
+  int p = 1;
+  while (p < n && p <= INT_MAX / 2)
+    p *= 2;
+  return p;
+}
+
 bool qwen3_model_load(qwen3_model_t *model, const char *model_dir,
                       dtype_t dtype) {
+  return qwen3_model_load_progress(model, model_dir, dtype, NULL, NULL);
+}
+
+bool qwen3_model_load_progress(qwen3_model_t *model, const char *model_dir,
+                               dtype_t dtype, qwen3_load_progress_fn fn,
+                               void *user) {
   if (!model || !model_dir)
     return false;
 
@@ -65,33 +162,37 @@ bool qwen3_model_load(qwen3_model_t *model, const char *model_dir,
 
   char model_path[512];
   snprintf(model_path, sizeof(model_path), "%s/model.safetensors", model_dir);
-  if (!qwen3_weights_load(&model->weights, &model->config, model_path, dtype)) {
+  if (!qwen3_weights_load_progress(&model->weights, &model->config,
+                                   model_path, dtype, fn, user)) {
     fprintf(stderr, "Failed to load weights from %s\n", model_path);
     model_config_free(&model->config);
     return false;
   }
 
   model->max_seq_len = model->config.max_position_embeddings;
+  model->prefill_chunk = prefill_chunk();
 
-  model->key_cache =
-      (void **)calloc(model->config.num_hidden_layers, sizeof(void *));
-  model->value_cache =
-      (void **)calloc(model->config.num_hidden_layers, sizeof(void *));
-  model->cache_len =
-      (int *)calloc(model->config.num_hidden_layers, sizeof(int));
-
-  if (!model->key_cache || !model->value_cache || !model->cache_len) {
+  /* KV memory is paged in as sequences grow, not reserved up front */
+  model->kv_pool = kv_page_pool_create(
+      model->config.num_hidden_layers, model->config.num_key_value_heads,
+      model->config.head_dim, kv_elem_size(dtype), KV_PAGE_TOKENS, 0);
+  if (!model->kv_pool) {
     qwen3_model_free(model);
     return false;
   }
-
-  int kv_cache_size = model->max_seq_len * model->config.num_key_value_heads *
-                      model->config.head_dim;
-  size_t elem_size = dtype_size(dtype);
-  for (int i = 0; i < model->config.num_hidden_layers; i++) {
-    model->key_cache[i] = calloc(kv_cache_size, elem_size);
-    model->value_cache[i] = calloc(kv_cache_size, elem_size);
-    if (!model->key_cache[i] || !model->value_cache[i]) {
+  kv_block_table_init(&model->kv, model->kv_pool);
+
+  /* Prompt prefixes are kept across generate calls, bounded in bytes */
+  size_t cache_mb = prefix_cache_mb();
+  if (cache_mb > 0) {
+    size_t pages =
+        cache_mb * 1024 * 1024 / kv_page_pool_page_bytes(model->kv_pool);
+    if (pages < 1)
+      pages = 1;
+    if (pages > INT_MAX)
+      pages = INT_MAX;
+    model->prefix_cache = kv_prefix_cache_create(model->kv_pool, (int)pages);
+    if (!model->prefix_cache) {
       qwen3_model_free(model);
       return false;
     }
@@ -126,9 +227,11 @@ bool qwen3_model_load(qwen3_model_t *model, const char *model_dir,
                                    model->config.rope_theta);
   }
 
-  model->temp_buffer_size = model->config.hidden_size * 8;
-  model->temp_buffer = malloc(model->temp_buffer_size * elem_size);
-  if (!model->temp_buffer) {
+  /* Decode and short prefills run without growing the workspace */
+  size_t ws_bytes =
+      max_size(forward_workspace_bytes(model, 1, 1),
+               forward_workspace_bytes(model, QWEN3_WORKSPACE_ROWS, 1));
+  if (!workspace_init(&model->workspace, ws_bytes)) {
     qwen3_model_free(model);
     return false;
   }
@@ -143,263 +246,362 @@ void qwen3_model_free(qwen3_model_t *model) {
   model_config_free(&model->config);
   qwen3_weights_free(&model->weights);
 
-  if (model->key_cache) {
-    for (int i = 0; i < model->config.num_hidden_layers; i++) {
-      if (model->key_cache[i])
-        free(model->key_cache[i]);
-    }
-    free(model->key_cache);
-  }
-
-  if (model->value_cache) {
-    for (int i = 0; i < model->config.num_hidden_layers; i++) {
-      if (model->value_cache[i])
-        free(model->value_cache[i]);
-    }
-    free(model->value_cache);
-  }
-
-  if (model->cache_len)
-    free(model->cache_len);
+  kv_block_table_free(&model->kv);
+  kv_prefix_cache_destroy(model->prefix_cache);
+  kv_page_pool_destroy(model->kv_pool);
 
   if (model->cos_sin_cache)
     free(model->cos_sin_cache);
 
-  if (model->temp_buffer)
-    free(model->temp_buffer);
+  workspace_free(&model->workspace);
 
   memset(model, 0, sizeof(*model));
 }
 
 void qwen3_model_reset_cache(qwen3_model_t *model) {
-  if (!model || !model->cache_len)
+  if (!model || !model->kv_pool)
     return;
-  for (int i = 0; i < model->config.num_hidden_layers; i++) {
-    model->cache_len[i] = 0;
-  }
+  kv_block_table_truncate(&model->kv, 0);
+}
+
+size_t qwen3_workspace_peak_bytes(const qwen3_model_t *model) {
+  return model ? workspace_peak(&model->workspace) : 0;
 }
 
 bool qwen3_forward(qwen3_model_t *model, float *logits, const int *token_ids,
                    int num_tokens) {
-  if (!model || !logits || !token_ids || num_tokens <= 0)
+  if (!model)
     return false;
+  return qwen3_forward_seq(model, &model->kv, logits, token_ids, num_tokens);
+}
 
-  int64_t *token_ids_i64 = (int64_t *)malloc(num_tokens * sizeof(int64_t));
-  if (!token_ids_i64)
-    return false;
-  for (int i = 0; i < num_tokens; i++) {
-    token_ids_i64[i] = token_ids[i];
+bool qwen3_forward_seq(qwen3_model_t *model, kv_block_table_t *kv,
+                       float *logits, const int *token_ids, int num_tokens) {
+  return qwen3_forward_batch(model, &kv, &token_ids, &num_tokens, 1, logits);
+}
+
+/* Final norm and lm_head over the rows that produce logits (F16 weights) */
+static bool compute_logits_f16(qwen3_model_t *model, float *logits,
+                               uint16_t *rows, int num_rows) {
+  int hidden_size = model->config.hidden_size;
+  int vocab_size = model->config.vocab_size;
+
+  rms_norm_f16(rows, rows, tensor_data_f16(model->weights.final_norm),
+               model->config.norm_eps, num_rows, hidden_size);
+
+  /* A single row (decode) goes through the GEMV, which streams the F16
+   * weights once and writes F32 logits directly. A quantized lm_head also
+   * runs from F32 rows so the logits keep full precision. */
+  const tensor_t *lm_head = model->weights.lm_head;
+  bool quantized = dtype_is_quantized(lm_head->dtype);
+  workspace_t *ws = &model->workspace;
+  size_t mark = workspace_mark(ws);
+  if (quantized || num_rows == 1) {
+    float *rows_f32 = (float *)workspace_alloc(
+        ws, (size_t)num_rows * hidden_size * sizeof(float));
+    if (!rows_f32)
+      return false;
+    f16_to_f32_array(rows, rows_f32, num_rows * hidden_size);
+    if (quantized)
+      linear_forward_f32(logits, rows_f32, lm_head, num_rows, vocab_size,
+                         hidden_size, ws);
+    else
+      gemv_f16(tensor_data_f16_const(lm_head), rows_f32, logits, vocab_size,
+               hidden_size, true);
+    workspace_reset(ws, mark);
+    return true;
   }
 
-  int64_t *position_ids = (int64_t *)malloc(num_tokens * sizeof(int64_t));
-  if (!position_ids) {
-    free(token_ids_i64);
+  uint16_t *logits_f16 = (uint16_t *)workspace_alloc(
+      ws, (size_t)num_rows * vocab_size * sizeof(uint16_t));
+  if (!logits_f16)
     return false;
-  }
-  int start_pos = 0;
-  if (model->cache_len && model->cache_len[0] > 0) {
-    start_pos = model->cache_len[0];
-  }
-  for (int i = 0; i < num_tokens; i++) {
-    position_ids[i] = start_pos + i;
-  }
+  gemm_f16(rows, tensor_data_f16(model->weights.lm_head), logits_f16, num_rows,
+           vocab_size, hidden_size);
+  f16_to_f32_array(logits_f16, logits, num_rows * vocab_size);
+  workspace_reset(ws, mark);
+  return true;
+}
 
-  if (model->dtype == DTYPE_F16) {
-    uint16_t *hidden = (uint16_t *)malloc(
-        num_tokens * model->config.hidden_size * sizeof(uint16_t));
-    if (!hidden) {
-      free(token_ids_i64);
-      free(position_ids);
+/* Final norm and lm_head over the rows that produce logits (F32 weights) */
+static bool compute_logits_f32(qwen3_model_t *model, float *logits,
+                               float *rows, int num_rows) {
+  int hidden_size = model->config.hidden_size;
+
+  rms_norm_f32(rows, rows, tensor_data_f32(model->weights.final_norm),
+               model->config.norm_eps, num_rows, hidden_size);
+  linear_forward_f32(logits, rows, model->weights.lm_head, num_rows,
+                     model->config.vocab_size, hidden_size, &model->workspace);
+  return true;
+}
+
+/*
+ * Forward pass over the rows of num_seqs sequences. Logits are produced for
+ * the last row of each sequence, or for every row when all_rows is set;
+ * with logits NULL the final norm and lm_head are skipped.
+ */
+static bool forward_rows(qwen3_model_t *model, kv_block_table_t *const *kvs,
+                         const int *const *token_ids, const int *num_tokens,
+                         int num_seqs, float *logits, bool all_rows) {
+  if (!model || !kvs || !token_ids || !num_tokens || num_seqs <= 0 ||
+      (all_rows && !logits))
+    return false;
+
+  int hidden_size = model->config.hidden_size;
+  size_t elem_size = dtype_size(model->dtype);
+
+  int num_rows = 0;
+  for (int s = 0; s < num_seqs; s++) {
+    if (num_tokens[s] <= 0 || num_tokens[s] > model->max_seq_len)
       return false;
-    }
+    num_rows += num_tokens[s];
+  }
+  int logit_rows = all_rows ? num_rows : logits ? num_seqs : 0;
+
+  /* Grow for power-of-two row counts so that prefill chunks of varying
+   * length settle on a few sizes instead of reallocating each time */
+  workspace_t *ws = &model->workspace;
+  if (!workspace_reserve(ws, forward_workspace_bytes(
+                                 model, round_up_pow2(num_rows),
+                                 round_up_pow2(logit_rows))))
+    return false;
 
-    embedding_lookup_f16(
-        hidden, token_ids_i64, tensor_data_f16(model->weights.embed_tokens),
-        num_tokens, model->config.vocab_size, model->config.hidden_size, -1);
-    free(token_ids_i64);
-
-    uint16_t *layer_input = hidden;
-    uint16_t *layer_output = (uint16_t *)malloc(
-        num_tokens * model->config.hidden_size * sizeof(uint16_t));
-    if (!layer_output) {
-      free(hidden);
-      free(position_ids);
+  attention_seq_t *seqs = (attention_seq_t *)workspace_alloc(
+      ws, num_seqs * sizeof(attention_seq_t));
+  int64_t *token_ids_i64 =
+      (int64_t *)workspace_alloc(ws, num_rows * sizeof(int64_t));
+  int64_t *position_ids =
+      (int64_t *)workspace_alloc(ws, num_rows * sizeof(int64_t));
+  void *layer_input =
+      workspace_alloc(ws, (size_t)num_rows * hidden_size * elem_size);
+  void *layer_output =
+      workspace_alloc(ws, (size_t)num_rows * hidden_size * elem_size);
+  void *last_rows =
+      all_rows || !logits
+          ? NULL
+          : workspace_alloc(ws, (size_t)num_seqs * hidden_size * elem_size);
+  if (!seqs || !token_ids_i64 || !position_ids || !layer_input ||
+      !layer_output || (!all_rows && logits && !last_rows)) {
+    workspace_reset(ws, 0);
+    return false;
+  }
+
+  int row = 0;
+  for (int s = 0; s < num_seqs; s++) {
+    kv_block_table_t *kv = kvs[s];
+    if (!kv || !token_ids[s] || kv->len + num_tokens[s] > model->max_seq_len ||
+        !kv_block_table_reserve(kv, kv->len + num_tokens[s])) {
+      workspace_reset(ws, 0);
       return false;
     }
+    seqs[s].kv = kv;
+    seqs[s].row = row;
+    seqs[s].num_tokens = num_tokens[s];
+    seqs[s].cache_len = kv->len;
+    row += num_tokens[s];
+  }
 
-    for (int layer_idx = 0; layer_idx < model->config.num_hidden_layers;
-         layer_idx++) {
-      /* Build transformer layer from weights */
-      transformer_layer_t layer;
-      build_transformer_layer(&layer, &model->weights.layers[layer_idx],
-                              &model->config);
-
-      transformer_layer_forward_f16(
-          layer_output, layer_input, &layer,
-          (uint16_t *)model->key_cache[layer_idx],
-          (uint16_t *)model->value_cache[layer_idx], position_ids,
-          (uint16_t *)model->cos_sin_cache, num_tokens,
-          model->cache_len[layer_idx], model->config.hidden_size);
-
-      model->cache_len[layer_idx] += num_tokens;
-
-      uint16_t *tmp = layer_input;
-      layer_input = layer_output;
-      layer_output = tmp;
+  for (int s = 0; s < num_seqs; s++) {
+    for (int i = 0; i < seqs[s].num_tokens; i++) {
+      token_ids_i64[seqs[s].row + i] = token_ids[s][i];
+      position_ids[seqs[s].row + i] = seqs[s].cache_len + i;
     }
+  }
 
-    uint16_t *final_hidden = layer_input;
+  if (model->dtype == DTYPE_F16) {
+    embedding_lookup_f16((uint16_t *)layer_input, token_ids_i64,
+                         tensor_data_f16(model->weights.embed_tokens),
+                         num_rows, model->config.vocab_size, hidden_size, -1);
+  } else {
+    embedding_lookup_f32((float *)layer_input, token_ids_i64,
+                         tensor_data_f32(model->weights.embed_tokens),
+                         num_rows, model->config.vocab_size, hidden_size, -1);
+  }
 
-    if (model->config.num_hidden_layers % 2 == 0) {
-      free(layer_output);
+  /* Every layer runs once over the rows of all sequences */
+  bool ok = true;
+  for (int layer_idx = 0;
+       ok && layer_idx < model->config.num_hidden_layers; layer_idx++) {
+    /* Build transformer layer from weights */
+    transformer_layer_t layer;
+    build_transformer_layer(&layer, &model->weights.layers[layer_idx],
+                            &model->config);
+
+    if (model->dtype == DTYPE_F16) {
+      ok = transformer_layer_forward_f16(
+          (uint16_t *)layer_output, (const uint16_t *)layer_input, &layer,
+          seqs, num_seqs, layer_idx, position_ids,
+          (uint16_t *)model->cos_sin_cache, num_rows, hidden_size, ws);
+    } else {
+      ok = transformer_layer_forward_f32(
+          (float *)layer_output, (const float *)layer_input, &layer, seqs,
+          num_seqs, layer_idx, position_ids, (float *)model->cos_sin_cache,
+          num_rows, hidden_size, ws);
     }
 
-    rms_norm_f16(final_hidden, final_hidden,
-                 tensor_data_f16(model->weights.final_norm),
-                 model->config.norm_eps, num_tokens, model->config.hidden_size);
-
-    /* Use optimized F32 path for single-token decode (common case).
-     * The pre-converted lm_head_f32 avoids ~11ms F16→F32 conversion. */
-    if (num_tokens == 1 && model->weights.lm_head_f32) {
-      float *final_hidden_f32 =
-          (float *)malloc(model->config.hidden_size * sizeof(float));
-      if (!final_hidden_f32) {
-        free(hidden);
-        free(position_ids);
-        if (model->config.num_hidden_layers % 2 == 0) {
-          free(layer_output);
-        }
-        return false;
-      }
+    void *tmp = layer_input;
+    layer_input = layer_output;
+    layer_output = tmp;
+  }
 
-      /* Convert final hidden state to F32 */
-      f16_to_f32_array(final_hidden, final_hidden_f32,
-                       model->config.hidden_size);
-
-      /* F32 GEMV: logits = final_hidden × lm_head
-       * lm_head_f32 is [hidden, vocab] (same transposed layout as F16 lm_head)
-       * So: [1, vocab] = [1, hidden] × [hidden, vocab] */
-      gemm_f32(final_hidden_f32, tensor_data_f32(model->weights.lm_head_f32),
-               logits, 1, model->config.vocab_size, model->config.hidden_size,
-               false, false);
-
-      free(final_hidden_f32);
-      free(hidden);
-      free(position_ids);
-      if (model->config.num_hidden_layers % 2 == 1) {
-        free(layer_output);
-      }
-    } else {
-      /* Multi-token (prefill) path - use F16 GEMM */
-      uint16_t *all_logits_f16 = (uint16_t *)malloc(
-          num_tokens * model->config.vocab_size * sizeof(uint16_t));
-      if (!all_logits_f16) {
-        free(hidden);
-        free(position_ids);
-        if (model->config.num_hidden_layers % 2 == 0) {
-          free(layer_output);
-        }
-        return false;
-      }
+  if (ok && all_rows) {
+    last_rows = layer_input;
+  } else if (ok && logits) {
+    /* Only the last row of each sequence produces logits */
+    size_t row_bytes = hidden_size * elem_size;
+    for (int s = 0; s < num_seqs; s++) {
+      int last = seqs[s].row + seqs[s].num_tokens - 1;
+      memcpy((uint8_t *)last_rows + s * row_bytes,
+             (const uint8_t *)layer_input + last * row_bytes, row_bytes);
+    }
+  }
 
-      gemm_f16(final_hidden, tensor_data_f16(model->weights.lm_head),
-               all_logits_f16, num_tokens, model->config.vocab_size,
-               model->config.hidden_size);
+  if (ok && logits) {
+    ok = model->dtype == DTYPE_F16
+             ? compute_logits_f16(model, logits, (uint16_t *)last_rows,
+                                  logit_rows)
+             : compute_logits_f32(model, logits, (float *)last_rows,
+                                  logit_rows);
+  }
 
-      uint16_t *last_token_logits_f16 =
-          all_logits_f16 + (num_tokens - 1) * model->config.vocab_size;
-      f16_to_f32_array(last_token_logits_f16, logits, model->config.vocab_size);
+  if (ok) {
+    for (int s = 0; s < num_seqs; s++)
+      kvs[s]->len += num_tokens[s];
+  }
 
-      free(all_logits_f16);
-      free(hidden);
-      free(position_ids);
+  workspace_reset(ws, 0);
+  return ok;
+}
 
-      if (model->config.num_hidden_layers % 2 == 1) {
-        free(layer_output);
-      }
-    }
-  } else {
-    float *hidden =
-        (float *)malloc(num_tokens * model->config.hidden_size * sizeof(float));
-    if (!hidden) {
-      free(token_ids_i64);
-      free(position_ids);
+/*
+ * Feed a long prompt of one sequence through the layers prefill_chunk tokens
+ * at a time, so activations and scratch stay bounded by the chunk instead
+ * of the prompt. Only the last chunk produces logits. On failure the
+ * sequence is truncated back to where it started.
+ */
+static bool forward_chunked(qwen3_model_t *model, kv_block_table_t *kv,
+                            const int *token_ids, int num_tokens,
+                            float *logits) {
+  int chunk = model->prefill_chunk;
+  int start_len = kv->len;
+  int done = 0;
+  while (num_tokens - done > chunk) {
+    const int *ids = token_ids + done;
+    if (!forward_rows(model, &kv, &ids, &chunk, 1, NULL, false)) {
+      kv_block_table_truncate(kv, start_len);
       return false;
     }
+    done += chunk;
+  }
 
-    embedding_lookup_f32(
-        hidden, token_ids_i64, tensor_data_f32(model->weights.embed_tokens),
-        num_tokens, model->config.vocab_size, model->config.hidden_size, -1);
-    free(token_ids_i64);
-
-    float *layer_input = hidden;
-    float *layer_output =
-        (float *)malloc(num_tokens * model->config.hidden_size * sizeof(float));
-    if (!layer_output) {
-      free(hidden);
-      free(position_ids);
-      return false;
-    }
+  const int *ids = token_ids + done;
+  int rest = num_tokens - done;
+  if (!forward_rows(model, &kv, &ids, &rest, 1, logits, false)) {
+    kv_block_table_truncate(kv, start_len);
+    return false;
+  }
+  return true;
+}
 
-    for (int layer_idx = 0; layer_idx < model->config.num_hidden_layers;
-         layer_idx++) {
-      /* Build transformer layer from weights */
-      transformer_layer_t layer;
-      build_transformer_layer(&layer, &model->weights.layers[layer_idx],
-                              &model->config);
-
-      transformer_layer_forward_f32(layer_output, layer_input, &layer,
-                                    (float *)model->key_cache[layer_idx],
-                                    (float *)model->value_cache[layer_idx],
-                                    position_ids, (float *)model->cos_sin_cache,
-                                    num_tokens, model->cache_len[layer_idx],
-                                    model->config.hidden_size);
-
-      model->cache_len[layer_idx] += num_tokens;
-
-      float *tmp = layer_input;
-      layer_input = layer_output;
-      layer_output = tmp;
-    }
+bool qwen3_forward_batch(qwen3_model_t *model, kv_block_table_t *const *kvs,
+                         const int *const *token_ids, const int *num_tokens,
+                         int num_seqs, float *logits) {
+  if (model && kvs && token_ids && num_tokens && logits && num_seqs == 1 &&
+      kvs[0] && token_ids[0] && model->prefill_chunk > 0 &&
+      num_tokens[0] > model->prefill_chunk &&
+      num_tokens[0] <= model->max_seq_len)
+    return forward_chunked(model, kvs[0], token_ids[0], num_tokens[0],
+                           logits);
+  return forward_rows(model, kvs, token_ids, num_tokens, num_seqs, logits,
+                      false);
+}
 
-    float *final_hidden = layer_input;
+bool qwen3_forward_seq_all(qwen3_model_t *model, kv_block_table_t *kv,
+                           float *logits, const int *token_ids,
+                           int num_tokens) {
+  return forward_rows(model, &kv, &token_ids, &num_tokens, 1, logits, true);
+}
 
-    if (model->config.num_hidden_layers % 2 == 0) {
-      free(layer_output);
-    }
+typedef struct {
+  const kv_block_table_t *kv;
+  int start;            /* First position whose key moved */
+  const float *cos_sin; /* F32 cache row of the shift distance */
+  float *scratch;       /* [num_layers, kv_dim], one row per layer */
+} shift_task_t;
 
-    rms_norm_f32(final_hidden, final_hidden,
-                 tensor_data_f32(model->weights.final_norm),
-                 model->config.norm_eps, num_tokens, model->config.hidden_size);
-
-    float *all_logits =
-        (float *)malloc(num_tokens * model->config.vocab_size * sizeof(float));
-    if (!all_logits) {
-      free(hidden);
-      free(position_ids);
-      if (model->config.num_hidden_layers % 2 == 0) {
-        free(layer_output);
+/*
+ * Re-rotate the moved keys of layers [l_start, l_end). FP16 and INT8 keys
+ * are widened to F32 for the rotation and stored back in their format.
+ */
+static void shift_keys_work(void *arg, int l_start, int l_end) {
+  const shift_task_t *t = (const shift_task_t *)arg;
+  const kv_page_pool_t *pool = t->kv->pool;
+  int heads = pool->num_kv_heads;
+  int head_dim = pool->head_dim;
+  size_t kv_dim = (size_t)heads * head_dim;
+
+  for (int layer = l_start; layer < l_end; layer++) {
+    float *row = t->scratch + (size_t)layer * kv_dim;
+    for (int pos = t->start; pos < t->kv->len; pos++) {
+      void *key = kv_block_table_key(t->kv, layer, pos);
+      if (pool->elem_size == KV_CACHE_INT8) {
+        float *scales = kv_block_table_key_scales(t->kv, layer, pos);
+        kv_cache_dequantize_q8_f32(row, (const int8_t *)key, scales, 1, heads,
+                                   head_dim);
+        rope_shift_f32(row, t->cos_sin, heads, head_dim, head_dim, true);
+        kv_cache_quantize_q8_f32((int8_t *)key, scales, row, 1, heads,
+                                 head_dim);
+      } else if (pool->elem_size == sizeof(uint16_t)) {
+        f16_to_f32_array((const uint16_t *)key, row, kv_dim);
+        rope_shift_f32(row, t->cos_sin, heads, head_dim, head_dim, true);
+        f32_to_f16_array(row, (uint16_t *)key, kv_dim);
+      } else {
+        rope_shift_f32((float *)key, t->cos_sin, heads, head_dim, head_dim,
+                       true);
       }
-      return false;
     }
+  }
+}
 
-    gemm_f32(tensor_data_f32(model->weights.lm_head), final_hidden, all_logits,
-             model->config.vocab_size, num_tokens, model->config.hidden_size,
-             false, true);
-
-    memcpy(logits, all_logits + (num_tokens - 1) * model->config.vocab_size,
-           model->config.vocab_size * sizeof(float));
+bool qwen3_seq_shift(qwen3_model_t *model, kv_block_table_t *kv, int keep,
+                     int discard) {
+  if (!model || !kv || keep < 0 || discard <= 0 || keep + discard > kv->len ||
+      discard >= model->max_seq_len)
+    return false;
 
-    free(all_logits);
-    free(hidden);
-    free(position_ids);
+  int num_layers = model->config.num_hidden_layers;
+  int rot_dim = model->config.head_dim;
+  size_t kv_dim =
+      (size_t)model->config.num_key_value_heads * model->config.head_dim;
+  size_t row_bytes = (size_t)rot_dim * sizeof(float);
+  size_t scratch_bytes = (size_t)num_layers * kv_dim * sizeof(float);
+
+  workspace_t *ws = &model->workspace;
+  if (!workspace_reserve(ws, workspace_slice_bytes(row_bytes) +
+                                 workspace_slice_bytes(scratch_bytes)))
+    return false;
+  float *cos_sin = (float *)workspace_alloc(ws, row_bytes);
+  float *scratch = (float *)workspace_alloc(ws, scratch_bytes);
 
-    if (model->config.num_hidden_layers % 2 == 1) {
-      free(layer_output);
-    }
+  /* Rotating back by discard positions uses the cache row of discard */
+  if (model->dtype == DTYPE_F16) {
+    f16_to_f32_array((const uint16_t *)model->cos_sin_cache +
+                         (size_t)discard * rot_dim,
+                     cos_sin, (size_t)rot_dim);
+  } else {
+    memcpy(cos_sin,
+           (const float *)model->cos_sin_cache + (size_t)discard * rot_dim,
+           row_bytes);
   }
 
-  return true;
+  bool ok = kv_block_table_remove(kv, keep, discard);
+  if (ok && keep < kv->len) {
+    shift_task_t task = {kv, keep, cos_sin, scratch};
+    threadpool_parallel_for(threadpool_global(), 0, num_layers, 1,
+                            shift_keys_work, &task);
+  }
+  workspace_reset(ws, 0);
+  return ok;
 }
 
 int qwen3_generate(qwen3_model_t *model, int *output_tokens, int max_tokens,
@@ -410,24 +612,34 @@ int qwen3_generate(qwen3_model_t *model, int *output_tokens, int max_tokens,
 
   qwen3_model_reset_cache(model);
 
+  /* The last prompt token always runs so that its logits are computed */
+  int cached = kv_prefix_cache_match(model->prefix_cache, &model->kv,
+                                     input_tokens, num_input_tokens - 1);
+
   float *logits = (float *)malloc(model->config.vocab_size * sizeof(float));
   if (!logits)
     return 0;
 
-  if (!qwen3_forward(model, logits, input_tokens, num_input_tokens)) {
+  if (!qwen3_forward(model, logits, input_tokens + cached,
+                     num_input_tokens - cached)) {
     free(logits);
     return 0;
   }
+  kv_prefix_cache_insert(model->prefix_cache, &model->kv, input_tokens,
+                         num_input_tokens);
 
   sampling_rng_t rng;
   sampling_rng_init(&rng, 42);
+  sampling_workspace_t sampler;
+  memset(&sampler, 0, sizeof(sampler));
 
   int num_generated = 0;
   int current_token;
 
   for (int i = 0; i < max_tokens; i++) {
-    current_token = sampling_sample_f32(logits, model->config.vocab_size,
-                                        temperature, top_k, top_p, 0.0f, &rng);
+    current_token =
+        sampling_sample_ws_f32(&sampler, logits, model->config.vocab_size,
+                               temperature, top_k, top_p, 0.0f, &rng);
     output_tokens[i] = current_token;
     num_generated++;
 
@@ -439,6 +651,20 @@ int qwen3_generate(qwen3_model_t *model, int *output_tokens, int max_tokens,
       break;
   }
 
+  /* Cache the reply too: the next turn's prompt starts with it */
+  int fed = model->kv.len - num_input_tokens;
+  if (model->prefix_cache && fed > 0) {
+    int *history = (int *)malloc(model->kv.len * sizeof(int));
+    if (history) {
+      memcpy(history, input_tokens, num_input_tokens * sizeof(int));
+      memcpy(history + num_input_tokens, output_tokens, fed * sizeof(int));
+      kv_prefix_cache_insert(model->prefix_cache, &model->kv, history,
+                             model->kv.len);
+      free(history);
+    }
+  }
+
   free(logits);
+  sampling_workspace_free(&sampler);
   return num_generated;
 }
@@ -2,6 +2,9 @@
 #define QWEN3_H
 
 #include "inference/core/dtype.h"
+#include "inference/core/workspace.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include "inference/kernels/kv_cache/prefix_cache.h"
 #include "inference/model/config.h"
 #include "weights.h"
 #include <stdbool.h>
@@ -13,24 +16,94 @@ typedef struct {
   qwen3_weights_t weights;
   dtype_t dtype;
 
-  void **key_cache;
-  void **value_cache;
-  int *cache_len;
+  kv_page_pool_t *kv_pool;         /* KV pages shared by all sequences */
+  kv_block_table_t kv;             /* Sequence used by qwen3_forward */
+  kv_prefix_cache_t *prefix_cache; /* Retained prompt KV, NULL if disabled */
   int max_seq_len;
+  int prefill_chunk; /* Longest prompt run per pass, 0 = unbounded */
 
   void *cos_sin_cache;
 
-  void *temp_buffer;
-  size_t temp_buffer_size;
+  workspace_t workspace; /* Scratch for every forward pass */
 } qwen3_model_t;
 
 bool qwen3_model_load(qwen3_model_t *model, const char *model_dir,
                       dtype_t dtype);
+/* As qwen3_model_load(), reporting weight progress to fn (may be NULL) */
+bool qwen3_model_load_progress(qwen3_model_t *model, const char *model_dir,
+                               dtype_t dtype, qwen3_load_progress_fn fn,
+                               void *user);
 void qwen3_model_free(qwen3_model_t *model);
 void qwen3_model_reset_cache(qwen3_model_t *model);
 
 bool qwen3_forward(qwen3_model_t *model, float *logits, const int *token_ids,
                    int num_tokens);
+
+/*
+ * Run a forward pass for one sequence. Any number of sequences can share a
+ * model: initialize each with kv_block_table_init(&seq, model->kv_pool) and
+ * release it with kv_block_table_free(). Their KV pages come from the shared
+ * pool as they grow.
+ */
+bool qwen3_forward_seq(qwen3_model_t *model, kv_block_table_t *kv,
+                       float *logits, const int *token_ids, int num_tokens);
+
+/*
+ * Run one forward pass over several sequences at once. Sequence s appends
+ * num_tokens[s] tokens (a decode step or a prefill chunk) to kvs[s], and
+ * logits[s * vocab_size ...] receives the logits of its last token. The
+ * linear layers see all rows together, so each weight matrix is read once
+ * per call regardless of num_seqs. A block table may appear only once.
+ *
+ * A single sequence longer than model->prefill_chunk tokens (set from
+ * SILLYTUI_PREFILL_CHUNK at load, default 512) is split into passes of that
+ * many tokens, which bounds peak activation and workspace memory
+ * independently of the prompt length.
+ */
+bool qwen3_forward_batch(qwen3_model_t *model, kv_block_table_t *const *kvs,
+                         const int *const *token_ids, const int *num_tokens,
+                         int num_seqs, float *logits);
+
+/*
+ * As qwen3_forward_seq(), but logits[i * vocab_size ...] receives the logits
+ * after token i for every one of the num_tokens tokens. Used to verify
+ * several drafted tokens in one pass.
+ */
+bool qwen3_forward_seq_all(qwen3_model_t *model, kv_block_table_t *kv,
+                           float *logits, const int *token_ids,
+                           int num_tokens);
+
+/*
+ * Context shift: drop positions [keep, keep + discard) of a sequence and
+ * move the later ones down by discard, so a conversation that outgrew its
+ * window continues without a re-prefill. The first keep positions (the
+ * system prompt and card, which act as attention sinks) stay as they are;
+ * the moved keys are re-rotated in place from position p to p - discard
+ * with the cos/sin cache. Values need no change.
+ *
+ * The result approximates a fresh prefill of the shortened sequence: the
+ * moved positions keep the K/V computed while the dropped tokens were
+ * still visible.
+ *
+ * Returns: false (sequence unchanged) for an invalid range or when no
+ * memory was available
+ */
+bool qwen3_seq_shift(qwen3_model_t *model, kv_block_table_t *kv, int keep,
+                     int discard);
+
+/*
+ * Most scratch bytes a forward pass has needed so far. The workspace is
+ * sized for decode at load and grows, between passes, to the largest batch
+ * or prefill chunk seen.
+ */
+size_t qwen3_workspace_peak_bytes(const qwen3_model_t *model);
+
+/*
+ * Generate from a prompt, starting from a fresh cache. KV pages of earlier
+ * prompts and replies that share a prefix with input_tokens are reused from
+ * the prefix cache, so only the new suffix is prefilled; the prompt and the
+ * generated tokens are added to the cache afterwards.
+ */
 int qwen3_generate(qwen3_model_t *model, int *output_tokens, int max_tokens,
                    const int *input_tokens, int num_input_tokens,
                    float temperature, int top_k, float top_p);
@@ -1,231 +1,619 @@
 #include "weights.h"
+#include "inference/backend/numa.h"
+#include "inference/backend/threadpool.h"
 #include "inference/core/dtype.h"
+#include "inference/core/large_alloc.h"
+#include "inference/kernels/quant/quant.h"
+#include <mutex>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <vector>
 
 #define SAFETENSORS_CPP_IMPLEMENTATION
 #include "inference/model_loader/safetensors.hh"
 
-/**
- * Load a tensor from safetensors file and wrap it in tensor_t.
- * Handles dtype conversion and optional transpose.
+/* Version of the layouts below; bump it to invalidate existing caches */
+#define QWEN3_WEIGHTS_LAYOUT 2
+
+/* Source rows per worker chunk when quantizing */
+#define QUANT_ROWS_PER_TASK 16
+
+/* Values converted to F32 at a time while quantizing, a block multiple */
+#define QUANT_CHUNK (8 * QUANT_BLOCK_SIZE)
+
+/* Square tile for the transposing copy (fits L1 for 4-byte elements) */
+#define TRANSPOSE_TILE 64
+
+/* Largest model.safetensors.index.json accepted */
+#define SHARD_INDEX_MAX_BYTES (64u << 20)
+
+/* Where a tensor lives: its shard and its index in that shard's header */
+typedef struct {
+  int shard;
+  size_t index;
+} tensor_ref_t;
+
+typedef std::unordered_map<std::string, tensor_ref_t> tensor_index_t;
+
+/* A source tensor's bytes within its shard's mapping */
+typedef struct {
+  int shard;
+  size_t offset;
+  size_t size;
+} byte_span_t;
+
+/*
+ * The source tensors of one layer, or (last group) of everything outside
+ * the layers. Layers are prefetched and reported as units.
  */
-static tensor_t *load_tensor(const safetensors::safetensors_t *st,
-                             const char *tensor_name, dtype_t target_dtype,
-                             bool transpose, int rows, int cols) {
-  const auto &keys = st->tensors.keys();
-  for (size_t i = 0; i < keys.size(); i++) {
-    if (keys[i] == tensor_name) {
-      safetensors::tensor_t st_tensor;
-      st->tensors.at(i, &st_tensor);
-
-      size_t tensor_size = safetensors::get_shape_size(st_tensor);
-      size_t elem_size = dtype_size(target_dtype);
-
-      void *data = malloc(tensor_size * elem_size);
-      if (!data)
-        return NULL;
-
-      const uint8_t *src = st->databuffer_addr + st_tensor.data_offsets[0];
-
-      /* Determine source dtype */
-      dtype_t src_dtype;
-      if (st_tensor.dtype == safetensors::dtype::kFLOAT32) {
-        src_dtype = DTYPE_F32;
-      } else if (st_tensor.dtype == safetensors::dtype::kFLOAT16) {
-        src_dtype = DTYPE_F16;
-      } else if (st_tensor.dtype == safetensors::dtype::kBFLOAT16) {
-        src_dtype = DTYPE_BF16;
-      } else {
-        free(data);
-        return NULL;
-      }
+typedef struct {
+  std::vector<byte_span_t> spans;
+  size_t bytes;
+} tensor_group_t;
+
+/* Running totals behind the progress callback */
+typedef struct {
+  qwen3_load_progress_fn fn;
+  void *user;
+  std::mutex lock;
+  size_t bytes_done;
+  size_t bytes_total;
+  int tensors_done;
+  int tensors_total;
+} load_progress_t;
+
+typedef struct {
+  const std::vector<safetensors::safetensors_t> *shards;
+  const tensor_index_t *names; /* Tensor name -> shard and header index */
+  const mapped_file_t *files;  /* Shard mappings */
+  const std::vector<tensor_group_t> *groups; /* Per layer, then the rest */
+  load_progress_t *progress;                 /* NULL if not reported */
+  qwen3_load_mode_t mode;
+  const weight_cache_t *cache;   /* Prepacked tensors, NULL if none */
+  weight_cache_writer_t *writer; /* Collects tensors for a new cache */
+  std::mutex *writer_lock;       /* Layers are loaded concurrently */
+  dtype_t weight_dtype;          /* Linear weights: Q8_0, Q4_0 or dtype */
+} load_ctx_t;
+
+/*
+ * Look a tensor up by name. On success *out is its header entry and *data
+ * points at its bytes in the shard's mapping.
+ */
+static bool find_tensor(const load_ctx_t *ctx, const char *name,
+                        safetensors::tensor_t *out, const uint8_t **data) {
+  tensor_index_t::const_iterator it = ctx->names->find(name);
+  if (it == ctx->names->end())
+    return false;
+  const safetensors::safetensors_t &st = (*ctx->shards)[it->second.shard];
+  if (!st.tensors.at(it->second.index, out))
+    return false;
+  *data = st.databuffer_addr + out->data_offsets[0];
+  return true;
+}
 
-      /* Load with optional transpose and dtype conversion */
-      if (transpose && rows > 0 && cols > 0) {
-        /* Transpose while converting */
-        for (int r = 0; r < rows; r++) {
-          for (int c = 0; c < cols; c++) {
-            size_t src_idx = r * cols + c;
-            size_t dst_idx = c * rows + r;
-
-            /* Convert single element */
-            float val;
-            if (src_dtype == DTYPE_F32) {
-              val = ((const float *)src)[src_idx];
-            } else if (src_dtype == DTYPE_F16) {
-              val = f16_to_f32(((const uint16_t *)src)[src_idx]);
-            } else { /* BF16 */
-              val = bf16_to_f32(((const uint16_t *)src)[src_idx]);
-            }
-
-            if (target_dtype == DTYPE_F32) {
-              ((float *)data)[dst_idx] = val;
-            } else { /* F16 */
-              ((uint16_t *)data)[dst_idx] = f32_to_f16(val);
-            }
-          }
-        }
-      } else {
-        /* Direct conversion without transpose */
-        if (src_dtype == target_dtype) {
-          memcpy(data, src, tensor_size * elem_size);
+static bool source_dtype(const safetensors::tensor_t &st_tensor,
+                         dtype_t *dtype) {
+  if (st_tensor.dtype == safetensors::dtype::kFLOAT32)
+    *dtype = DTYPE_F32;
+  else if (st_tensor.dtype == safetensors::dtype::kFLOAT16)
+    *dtype = DTYPE_F16;
+  else if (st_tensor.dtype == safetensors::dtype::kBFLOAT16)
+    *dtype = DTYPE_BF16;
+  else
+    return false;
+  return true;
+}
+
+static void cache_add(const load_ctx_t *ctx, const char *name,
+                      const tensor_t *t) {
+  if (!ctx->writer)
+    return;
+  std::lock_guard<std::mutex> guard(*ctx->writer_lock);
+  weight_cache_writer_add(ctx->writer, name, t);
+}
+
+/*
+ * Cache key "<name>" or "<name>:<tag>". Names too long for the cache are
+ * left uncached rather than truncated into a key another tensor may share.
+ */
+static bool cache_key(char *key, const char *name, const char *tag) {
+  int n = snprintf(key, WEIGHT_CACHE_NAME_MAX, "%s%s%s", name,
+                   tag ? ":" : "", tag ? tag : "");
+  return n >= 0 && n < WEIGHT_CACHE_NAME_MAX;
+}
+
+/*
+ * Start reading a group's source tensors while the previous one converts.
+ * Skipped with a prepacked cache, which supplies most tensors instead.
+ */
+static void group_prefetch(const load_ctx_t *ctx, int group) {
+  if (ctx->cache || group >= (int)ctx->groups->size())
+    return;
+  const tensor_group_t &g = (*ctx->groups)[group];
+  for (size_t i = 0; i < g.spans.size(); i++)
+    mapped_file_prefetch(&ctx->files[g.spans[i].shard], g.spans[i].offset,
+                         g.spans[i].size);
+}
+
+static void group_done(const load_ctx_t *ctx, int group) {
+  load_progress_t *p = ctx->progress;
+  if (!p)
+    return;
+  const tensor_group_t &g = (*ctx->groups)[group];
+  std::lock_guard<std::mutex> guard(p->lock);
+  p->bytes_done += g.bytes;
+  p->tensors_done += (int)g.spans.size();
+  p->fn(p->user, p->bytes_done, p->bytes_total, p->tensors_done,
+        p->tensors_total);
+}
+
+static inline float load_elem(const void *p, dtype_t dtype, size_t i) {
+  if (dtype == DTYPE_F32)
+    return ((const float *)p)[i];
+  if (dtype == DTYPE_F16)
+    return f16_to_f32(((const uint16_t *)p)[i]);
+  return bf16_to_f32(((const uint16_t *)p)[i]);
+}
+
+static inline void store_elem(void *p, dtype_t dtype, size_t i, float v) {
+  if (dtype == DTYPE_F32)
+    ((float *)p)[i] = v;
+  else if (dtype == DTYPE_F16)
+    ((uint16_t *)p)[i] = f32_to_f16(v);
+  else
+    ((uint16_t *)p)[i] = f32_to_bf16(v);
+}
+
+typedef struct {
+  const void *src;
+  dtype_t src_dtype;
+  void *dst;
+  dtype_t dst_dtype;
+  int rows; /* Source rows */
+  int cols; /* Source columns */
+} transpose_task_t;
+
+/*
+ * dst[c][r] = src[r][c] for destination rows [c_start, c_end), tile by tile
+ * so both sides stay in cache. Same-dtype copies move raw bits.
+ */
+static void transpose_work(void *arg, int c_start, int c_end) {
+  const transpose_task_t *t = (const transpose_task_t *)arg;
+  size_t rows = (size_t)t->rows, cols = (size_t)t->cols;
+  bool same = t->src_dtype == t->dst_dtype;
+  bool wide = dtype_size(t->src_dtype) == 4;
+
+  for (int c0 = c_start; c0 < c_end; c0 += TRANSPOSE_TILE) {
+    int c1 = c0 + TRANSPOSE_TILE < c_end ? c0 + TRANSPOSE_TILE : c_end;
+    for (int r0 = 0; r0 < t->rows; r0 += TRANSPOSE_TILE) {
+      int r1 = r0 + TRANSPOSE_TILE < t->rows ? r0 + TRANSPOSE_TILE : t->rows;
+      for (int c = c0; c < c1; c++) {
+        size_t d = (size_t)c * rows;
+        if (same && wide) {
+          const uint32_t *s = (const uint32_t *)t->src;
+          for (int r = r0; r < r1; r++)
+            ((uint32_t *)t->dst)[d + r] = s[(size_t)r * cols + c];
+        } else if (same) {
+          const uint16_t *s = (const uint16_t *)t->src;
+          for (int r = r0; r < r1; r++)
+            ((uint16_t *)t->dst)[d + r] = s[(size_t)r * cols + c];
         } else {
-          dtype_convert_array(src, src_dtype, data, target_dtype, tensor_size);
+          for (int r = r0; r < r1; r++)
+            store_elem(t->dst, t->dst_dtype, d + r,
+                       load_elem(t->src, t->src_dtype, (size_t)r * cols + c));
         }
       }
+    }
+  }
+}
 
-      /* Determine shape based on safetensors metadata */
-      int ndim = (int)st_tensor.shape.size();
-      int64_t shape[TENSOR_MAX_DIMS];
-      for (int d = 0; d < ndim && d < TENSOR_MAX_DIMS; d++) {
-        shape[d] = st_tensor.shape[d];
-      }
+typedef struct {
+  const void *src;
+  dtype_t src_dtype;
+  void *dst;
+  dtype_t dst_dtype; /* DTYPE_Q8_0 or DTYPE_Q4_0 */
+  int cols;
+} quantize_task_t;
+
+/*
+ * Quantize source rows [r_start, r_end). Blocks are independent, so each
+ * row goes through a small F32 buffer QUANT_CHUNK values at a time.
+ */
+static void quantize_work(void *arg, int r_start, int r_end) {
+  const quantize_task_t *t = (const quantize_task_t *)arg;
+  float chunk[QUANT_CHUNK];
+  size_t src_row = dtype_nbytes(t->src_dtype, (size_t)t->cols);
+  size_t dst_row = dtype_nbytes(t->dst_dtype, (size_t)t->cols);
+  for (int r = r_start; r < r_end; r++) {
+    const uint8_t *src = (const uint8_t *)t->src + (size_t)r * src_row;
+    uint8_t *dst = (uint8_t *)t->dst + (size_t)r * dst_row;
+    for (int c = 0; c < t->cols; c += QUANT_CHUNK) {
+      int n = t->cols - c < QUANT_CHUNK ? t->cols - c : QUANT_CHUNK;
+      dtype_convert_array(src + dtype_nbytes(t->src_dtype, (size_t)c),
+                          t->src_dtype, chunk, DTYPE_F32, (size_t)n);
+      quantize_rows(t->dst_dtype, chunk,
+                    dst + dtype_nbytes(t->dst_dtype, (size_t)c), 1, n);
+    }
+  }
+}
 
-      /* If transposed, swap the shape dimensions */
-      if (transpose && ndim == 2) {
-        int64_t tmp = shape[0];
-        shape[0] = shape[1];
-        shape[1] = tmp;
-      }
+/**
+ * Load a tensor from safetensors file and wrap it in tensor_t.
+ * Handles dtype conversion and optional transpose.
+ *
+ * Lookup order: the prepacked cache, then the file mapping itself (when no
+ * conversion is needed), and only then a converted heap copy, which is
+ * queued for the next cache.
+ */
+static tensor_t *load_tensor(const load_ctx_t *ctx, const char *tensor_name,
+                             dtype_t target_dtype, bool transpose, int rows,
+                             int cols) {
+  char cache_name[WEIGHT_CACHE_NAME_MAX];
+  bool cacheable = cache_key(cache_name, tensor_name, transpose ? "t" : NULL);
+  tensor_t *cached =
+      cacheable ? weight_cache_get(ctx->cache, cache_name) : NULL;
+  if (cached)
+    return cached;
+
+  safetensors::tensor_t st_tensor;
+  const uint8_t *src;
+  dtype_t src_dtype;
+  if (!find_tensor(ctx, tensor_name, &st_tensor, &src) ||
+      !source_dtype(st_tensor, &src_dtype))
+    return NULL;
+
+  size_t tensor_size = safetensors::get_shape_size(st_tensor);
+  size_t elem_size = dtype_size(target_dtype);
+
+  /* Determine shape based on safetensors metadata */
+  int ndim = (int)st_tensor.shape.size();
+  if (ndim > TENSOR_MAX_DIMS)
+    return NULL;
+  int64_t shape[TENSOR_MAX_DIMS];
+  for (int d = 0; d < ndim; d++) {
+    shape[d] = st_tensor.shape[d];
+  }
 
-      tensor_t *t = tensor_wrap(data, target_dtype, ndim, shape);
-      if (!t) {
-        free(data);
-        return NULL;
-      }
-      t->owns_data = true; /* Take ownership */
-      return t;
+  transpose = transpose && rows > 0 && cols > 0;
+
+  /* Already in the wanted layout: point straight into the mapping */
+  if (ctx->mode != QWEN3_LOAD_COPY && !transpose &&
+      src_dtype == target_dtype && (uintptr_t)src % elem_size == 0) {
+    return tensor_wrap((void *)src, target_dtype, ndim, shape);
+  }
+
+  void *data = large_alloc(tensor_size * elem_size);
+  if (!data)
+    return NULL;
+
+  /* Load with optional transpose and dtype conversion */
+  if (transpose) {
+    transpose_task_t task = {src, src_dtype, data, target_dtype, rows, cols};
+    threadpool_parallel_for(threadpool_global(), 0, cols, TRANSPOSE_TILE,
+                            transpose_work, &task);
+  } else {
+    /* Direct conversion without transpose */
+    if (src_dtype == target_dtype) {
+      memcpy(data, src, tensor_size * elem_size);
+    } else {
+      dtype_convert_array(src, src_dtype, data, target_dtype, tensor_size);
+    }
+  }
+
+  /* If transposed, swap the shape dimensions */
+  if (transpose && ndim == 2) {
+    int64_t tmp = shape[0];
+    shape[0] = shape[1];
+    shape[1] = tmp;
+  }
+
+  tensor_t *t = tensor_wrap(data, target_dtype, ndim, shape);
+  if (!t) {
+    large_free(data);
+    return NULL;
+  }
+  t->owns_data = true; /* Take ownership */
+
+  if (cacheable && (transpose || src_dtype != target_dtype))
+    cache_add(ctx, cache_name, t);
+  return t;
+}
+
+/**
+ * Load an [out, in] projection for the linear layers.
+ *
+ * With a quantized weight dtype the rows are block-quantized in their
+ * original layout (the quantized GEMM consumes [out, in] directly) and the
+ * result is cached as "<name>:<qtype>". Otherwise this is load_tensor(),
+ * transposed for F16.
+ */
+static tensor_t *load_linear(const load_ctx_t *ctx, const char *tensor_name,
+                             dtype_t dtype, dtype_t weight_dtype, int rows,
+                             int cols) {
+  if (!dtype_is_quantized(weight_dtype) || cols % QUANT_BLOCK_SIZE != 0)
+    return load_tensor(ctx, tensor_name, dtype, dtype == DTYPE_F16, rows,
+                       cols);
+
+  char cache_name[WEIGHT_CACHE_NAME_MAX];
+  bool cacheable =
+      cache_key(cache_name, tensor_name, dtype_name(weight_dtype));
+  tensor_t *cached =
+      cacheable ? weight_cache_get(ctx->cache, cache_name) : NULL;
+  if (cached)
+    return cached;
+
+  safetensors::tensor_t st_tensor;
+  const uint8_t *src;
+  dtype_t src_dtype;
+  if (!find_tensor(ctx, tensor_name, &st_tensor, &src) ||
+      !source_dtype(st_tensor, &src_dtype))
+    return NULL;
+  if (safetensors::get_shape_size(st_tensor) != (size_t)rows * cols)
+    return NULL;
+
+  int64_t shape[2] = {rows, cols};
+  tensor_t *t = tensor_create(weight_dtype, 2, shape);
+  if (!t)
+    return NULL;
+
+  quantize_task_t task = {src, src_dtype, t->data, weight_dtype, cols};
+  threadpool_parallel_for(threadpool_global(), 0, rows, QUANT_ROWS_PER_TASK,
+                          quantize_work, &task);
+
+  if (cacheable)
+    cache_add(ctx, cache_name, t);
+  return t;
+}
+
+/*
+ * Stack projections along their outputs into one new tensor. [out, in]
+ * layouts (F32 and quantized rows) are concatenated whole; the transposed
+ * F16 [in, out] layout is concatenated row by row.
+ */
+static tensor_t *concat_linear(tensor_t *const *parts, int count) {
+  dtype_t dtype = parts[0]->dtype;
+  bool transposed = dtype == DTYPE_F16;
+  int64_t in = transposed ? parts[0]->shape[0] : parts[0]->shape[1];
+  int64_t out = 0;
+  for (int i = 0; i < count; i++) {
+    int64_t part_in = transposed ? parts[i]->shape[0] : parts[i]->shape[1];
+    if (parts[i]->dtype != dtype || parts[i]->ndim != 2 || part_in != in)
+      return NULL;
+    out += transposed ? parts[i]->shape[1] : parts[i]->shape[0];
+  }
+
+  int64_t shape[2] = {transposed ? in : out, transposed ? out : in};
+  tensor_t *t = tensor_create(dtype, 2, shape);
+  if (!t)
+    return NULL;
+
+  uint8_t *dst = (uint8_t *)t->data;
+  if (!transposed) {
+    for (int i = 0; i < count; i++) {
+      size_t bytes = dtype_nbytes(dtype, (size_t)parts[i]->shape[0] * in);
+      memcpy(dst, parts[i]->data, bytes);
+      dst += bytes;
+    }
+    return t;
+  }
+
+  size_t elem = dtype_size(dtype);
+  for (int64_t r = 0; r < in; r++) {
+    for (int i = 0; i < count; i++) {
+      size_t bytes = (size_t)parts[i]->shape[1] * elem;
+      memcpy(dst, (const uint8_t *)parts[i]->data + r * bytes, bytes);
+      dst += bytes;
     }
   }
-  return NULL;
+  return t;
+}
+
+/*
+ * Load projections that share an input and stack them with
+ * concat_linear(). Only the stacked tensor is cached (as
+ * "<name>:<dtype>"), so later loads never touch the parts.
+ */
+static tensor_t *load_stacked(const load_ctx_t *ctx, const char *name,
+                              const char *const *part_names,
+                              const int *part_rows, int count, dtype_t dtype,
+                              int cols) {
+  dtype_t weight_dtype =
+      dtype_is_quantized(ctx->weight_dtype) && cols % QUANT_BLOCK_SIZE == 0
+          ? ctx->weight_dtype
+          : dtype;
+  char cache_name[WEIGHT_CACHE_NAME_MAX];
+  bool cacheable = cache_key(cache_name, name, dtype_name(weight_dtype));
+  tensor_t *cached =
+      cacheable ? weight_cache_get(ctx->cache, cache_name) : NULL;
+  if (cached)
+    return cached;
+
+  /* The parts are dropped once stacked, so they must not be queued */
+  load_ctx_t part_ctx = *ctx;
+  part_ctx.writer = NULL;
+
+  tensor_t *parts[3] = {NULL, NULL, NULL};
+  tensor_t *stacked = NULL;
+  bool ok = count <= 3;
+  for (int i = 0; ok && i < count; i++) {
+    parts[i] = load_linear(&part_ctx, part_names[i], dtype,
+                           ctx->weight_dtype, part_rows[i], cols);
+    ok = parts[i] != NULL;
+  }
+  if (ok)
+    stacked = concat_linear(parts, count);
+  for (int i = 0; i < count; i++)
+    tensor_free(parts[i]);
+
+  if (stacked && cacheable)
+    cache_add(ctx, cache_name, stacked);
+  return stacked;
 }
 
 static bool load_layer_weights(qwen3_layer_weights_t *layer_weights,
-                               const safetensors::safetensors_t *st,
-                               int layer_idx, const model_config_t *config,
-                               dtype_t dtype) {
+                               const load_ctx_t *ctx, int layer_idx,
+                               const model_config_t *config, dtype_t dtype) {
   char tensor_name[256];
   int hidden = config->hidden_size;
   int q_dim = config->num_attention_heads * config->head_dim;
   int kv_dim = config->num_key_value_heads * config->head_dim;
   int inter = config->intermediate_size;
 
-  /* For F16, we transpose weight matrices for efficient GEMM */
-  bool do_transpose = (dtype == DTYPE_F16);
-
-  snprintf(tensor_name, sizeof(tensor_name),
-           "model.layers.%d.self_attn.q_proj.weight", layer_idx);
-  layer_weights->q_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, q_dim, hidden);
-  if (!layer_weights->q_proj)
-    return false;
-
-  snprintf(tensor_name, sizeof(tensor_name),
-           "model.layers.%d.self_attn.k_proj.weight", layer_idx);
-  layer_weights->k_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, kv_dim, hidden);
-  if (!layer_weights->k_proj)
-    return false;
-
+  char q_name[256], k_name[256], v_name[256];
+  snprintf(q_name, sizeof(q_name), "model.layers.%d.self_attn.q_proj.weight",
+           layer_idx);
+  snprintf(k_name, sizeof(k_name), "model.layers.%d.self_attn.k_proj.weight",
+           layer_idx);
+  snprintf(v_name, sizeof(v_name), "model.layers.%d.self_attn.v_proj.weight",
+           layer_idx);
   snprintf(tensor_name, sizeof(tensor_name),
-           "model.layers.%d.self_attn.v_proj.weight", layer_idx);
-  layer_weights->v_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, kv_dim, hidden);
-  if (!layer_weights->v_proj)
+           "model.layers.%d.self_attn.qkv_proj.weight", layer_idx);
+  const char *qkv_names[3] = {q_name, k_name, v_name};
+  int qkv_rows[3] = {q_dim, kv_dim, kv_dim};
+  layer_weights->qkv_proj = load_stacked(ctx, tensor_name, qkv_names,
+                                         qkv_rows, 3, dtype, hidden);
+  if (!layer_weights->qkv_proj)
     return false;
 
   snprintf(tensor_name, sizeof(tensor_name),
            "model.layers.%d.self_attn.o_proj.weight", layer_idx);
   layer_weights->o_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, hidden, q_dim);
+      load_linear(ctx, tensor_name, dtype, ctx->weight_dtype, hidden, q_dim);
   if (!layer_weights->o_proj)
     return false;
 
   snprintf(tensor_name, sizeof(tensor_name),
            "model.layers.%d.self_attn.q_norm.weight", layer_idx);
-  layer_weights->q_norm = load_tensor(st, tensor_name, dtype, false, 0, 0);
+  layer_weights->q_norm = load_tensor(ctx, tensor_name, dtype, false, 0, 0);
   if (!layer_weights->q_norm)
     return false;
 
   snprintf(tensor_name, sizeof(tensor_name),
            "model.layers.%d.self_attn.k_norm.weight", layer_idx);
-  layer_weights->k_norm = load_tensor(st, tensor_name, dtype, false, 0, 0);
+  layer_weights->k_norm = load_tensor(ctx, tensor_name, dtype, false, 0, 0);
   if (!layer_weights->k_norm)
     return false;
 
-  snprintf(tensor_name, sizeof(tensor_name),
+  char gate_name[256], up_name[256];
+  snprintf(gate_name, sizeof(gate_name),
            "model.layers.%d.mlp.gate_proj.weight", layer_idx);
-  layer_weights->gate_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, inter, hidden);
-  if (!layer_weights->gate_proj)
-    return false;
-
+  snprintf(up_name, sizeof(up_name), "model.layers.%d.mlp.up_proj.weight",
+           layer_idx);
   snprintf(tensor_name, sizeof(tensor_name),
-           "model.layers.%d.mlp.up_proj.weight", layer_idx);
-  layer_weights->up_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, inter, hidden);
-  if (!layer_weights->up_proj)
+           "model.layers.%d.mlp.gate_up_proj.weight", layer_idx);
+  const char *gate_up_names[2] = {gate_name, up_name};
+  int gate_up_rows[2] = {inter, inter};
+  layer_weights->gate_up_proj = load_stacked(
+      ctx, tensor_name, gate_up_names, gate_up_rows, 2, dtype, hidden);
+  if (!layer_weights->gate_up_proj)
     return false;
 
   snprintf(tensor_name, sizeof(tensor_name),
            "model.layers.%d.mlp.down_proj.weight", layer_idx);
   layer_weights->down_proj =
-      load_tensor(st, tensor_name, dtype, do_transpose, hidden, inter);
+      load_linear(ctx, tensor_name, dtype, ctx->weight_dtype, hidden, inter);
   if (!layer_weights->down_proj)
     return false;
 
   snprintf(tensor_name, sizeof(tensor_name),
            "model.layers.%d.input_layernorm.weight", layer_idx);
-  layer_weights->input_norm = load_tensor(st, tensor_name, dtype, false, 0, 0);
+  layer_weights->input_norm = load_tensor(ctx, tensor_name, dtype, false, 0, 0);
   if (!layer_weights->input_norm)
     return false;
 
   snprintf(tensor_name, sizeof(tensor_name),
            "model.layers.%d.post_attention_layernorm.weight", layer_idx);
   layer_weights->post_attn_norm =
-      load_tensor(st, tensor_name, dtype, false, 0, 0);
+      load_tensor(ctx, tensor_name, dtype, false, 0, 0);
   if (!layer_weights->post_attn_norm)
     return false;
 
   return true;
 }
 
-bool qwen3_weights_load(qwen3_weights_t *weights, const model_config_t *config,
-                        const char *model_path, dtype_t dtype) {
-  if (!weights || !config || !model_path)
-    return false;
+typedef struct {
+  qwen3_weights_t *weights;
+  const load_ctx_t *ctx;
+  const model_config_t *config;
+  dtype_t dtype;
+  char *ok; /* Per layer */
+} layer_task_t;
+
+/*
+ * Load layers [l_start, l_end). With at least as many layers as threads,
+ * whole layers are spread over the pool, and each tensor is then converted
+ * serially on its worker (nested parallel_for calls run inline); otherwise
+ * layers go one by one and each tensor is split over the pool instead.
+ * Each layer's successor is prefetched before the layer itself converts.
+ */
+static void layer_work(void *arg, int l_start, int l_end) {
+  const layer_task_t *t = (const layer_task_t *)arg;
+  for (int i = l_start; i < l_end; i++) {
+    if (i + 1 < l_end)
+      group_prefetch(t->ctx, i + 1);
+    t->ok[i] = load_layer_weights(&t->weights->layers[i], t->ctx, i,
+                                  t->config, t->dtype);
+    if (t->ok[i])
+      group_done(t->ctx, i);
+  }
+}
 
-  memset(weights, 0, sizeof(*weights));
-  weights->dtype = dtype;
+static qwen3_load_mode_t default_load_mode(void) {
+  const char *mode = getenv("SILLYTUI_WEIGHTS_LOAD");
+  if (mode && strcmp(mode, "copy") == 0)
+    return QWEN3_LOAD_COPY;
+  if (mode && strcmp(mode, "mmap") == 0)
+    return QWEN3_LOAD_MMAP;
+  return QWEN3_LOAD_PREPACKED;
+}
 
-  safetensors::safetensors_t st;
-  std::string warn, err;
-  bool ret = safetensors::mmap_from_file(model_path, &st, &warn, &err);
-  if (!ret) {
-    fprintf(stderr, "Failed to load model: %s\n", err.c_str());
-    return false;
-  }
+static dtype_t default_weight_dtype(dtype_t dtype) {
+  const char *quant = getenv("SILLYTUI_WEIGHTS_QUANT");
+  if (quant && strcmp(quant, "q8_0") == 0)
+    return DTYPE_Q8_0;
+  if (quant && strcmp(quant, "q4_0") == 0)
+    return DTYPE_Q4_0;
+  return dtype;
+}
 
-  if (!safetensors::validate_data_offsets(st, err)) {
-    fprintf(stderr, "Invalid safetensors file: %s\n", err.c_str());
-    return false;
-  }
+bool qwen3_weights_load(qwen3_weights_t *weights, const model_config_t *config,
+                        const char *model_path, dtype_t dtype) {
+  return qwen3_weights_load_quant(weights, config, model_path, dtype,
+                                  default_load_mode(),
+                                  default_weight_dtype(dtype));
+}
 
+static bool load_all_weights(qwen3_weights_t *weights,
+                             const model_config_t *config,
+                             const load_ctx_t *ctx, dtype_t dtype) {
   int vocab = config->vocab_size;
   int hidden = config->hidden_size;
-  bool do_transpose = (dtype == DTYPE_F16);
+  int num_layers = config->num_hidden_layers;
+  threadpool_t *pool = threadpool_global();
+  bool parallel_layers = num_layers >= threadpool_size(pool);
+
+  /* The non-layer tensors, then the first layer of each worker's chunk;
+   * later layers are fetched one ahead by layer_work() */
+  int chunk = parallel_layers ? (num_layers + threadpool_size(pool) - 1) /
+                                    threadpool_size(pool)
+                              : num_layers;
+  group_prefetch(ctx, num_layers);
+  for (int i = 0; i < num_layers; i += chunk)
+    group_prefetch(ctx, i);
 
   weights->embed_tokens =
-      load_tensor(&st, "model.embed_tokens.weight", dtype, false, 0, 0);
+      load_tensor(ctx, "model.embed_tokens.weight", dtype, false, 0, 0);
   if (!weights->embed_tokens) {
     fprintf(stderr, "Failed to load embed_tokens\n");
     return false;
   }
 
   weights->final_norm =
-      load_tensor(&st, "model.norm.weight", dtype, false, 0, 0);
+      load_tensor(ctx, "model.norm.weight", dtype, false, 0, 0);
   if (!weights->final_norm) {
     fprintf(stderr, "Failed to load norm\n");
     return false;
@@ -234,8 +622,12 @@ bool qwen3_weights_load(qwen3_weights_t *weights, const model_config_t *config,
   const char *lm_head_name = config->tie_word_embeddings
                                  ? "model.embed_tokens.weight"
                                  : "lm_head.weight";
+  /* The logits are the most sensitive output, so a 4-bit model still
+   * keeps its lm_head in Q8_0 */
+  dtype_t lm_head_dtype =
+      dtype_is_quantized(ctx->weight_dtype) ? DTYPE_Q8_0 : dtype;
   weights->lm_head =
-      load_tensor(&st, lm_head_name, dtype, do_transpose, vocab, hidden);
+      load_linear(ctx, lm_head_name, dtype, lm_head_dtype, vocab, hidden);
   if (!weights->lm_head) {
     if (config->tie_word_embeddings) {
       /* For tied embeddings without transpose, just share the pointer */
@@ -252,29 +644,7 @@ bool qwen3_weights_load(qwen3_weights_t *weights, const model_config_t *config,
       return false;
     }
   }
-
-  /* Pre-convert LM head to F32 for fast single-token decode.
-   * The LM head GEMM (1×vocab×hidden) is memory-bound and cblas_sgemv
-   * is much faster than BNNS F16 for this shape. Pre-converting saves
-   * the ~11ms conversion overhead on every forward pass. */
-  weights->lm_head_f32 = NULL;
-  if (dtype == DTYPE_F16 && weights->lm_head) {
-    size_t num_elements = (size_t)vocab * hidden;
-    float *lm_head_f32_data = (float *)malloc(num_elements * sizeof(float));
-    if (lm_head_f32_data) {
-      f16_to_f32_array(tensor_data_f16(weights->lm_head), lm_head_f32_data,
-                       num_elements);
-      int64_t shape[2] = {vocab, hidden};
-      weights->lm_head_f32 = tensor_create(DTYPE_F32, 2, shape);
-      if (weights->lm_head_f32) {
-        free(weights->lm_head_f32->data);
-        weights->lm_head_f32->data = lm_head_f32_data;
-        weights->lm_head_f32->owns_data = true;
-      } else {
-        free(lm_head_f32_data);
-      }
-    }
-  }
+  group_done(ctx, num_layers);
 
   weights->num_layers = config->num_hidden_layers;
   weights->layers = (qwen3_layer_weights_t *)calloc(
@@ -284,24 +654,330 @@ bool qwen3_weights_load(qwen3_weights_t *weights, const model_config_t *config,
     return false;
   }
 
+  std::vector<char> layer_ok(config->num_hidden_layers, 0);
+  layer_task_t task = {weights, ctx, config, dtype, layer_ok.data()};
+  if (parallel_layers) {
+    threadpool_parallel_for(pool, 0, config->num_hidden_layers, 1,
+                            layer_work, &task);
+  } else {
+    layer_work(&task, 0, config->num_hidden_layers);
+  }
+
   for (int i = 0; i < config->num_hidden_layers; i++) {
-    if (!load_layer_weights(&weights->layers[i], &st, i, config, dtype)) {
+    if (!layer_ok[i]) {
       fprintf(stderr, "Failed to load layer %d weights\n", i);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/*
+ * Read the shard files of a sharded checkpoint from the weight_map of its
+ * model.safetensors.index.json, as paths next to the index, in first-seen
+ * order.
+ */
+static bool read_shard_index(const char *index_path,
+                             std::vector<std::string> *paths) {
+  FILE *f = fopen(index_path, "rb");
+  if (!f)
+    return false;
+  std::string json;
+  char buf[65536];
+  size_t n;
+  while ((n = fread(buf, 1, sizeof(buf), f)) > 0 &&
+         json.size() + n <= SHARD_INDEX_MAX_BYTES)
+    json.append(buf, n);
+  bool complete = feof(f) && !ferror(f);
+  fclose(f);
+  if (!complete)
+    return false;
+
+  const char *p = json.c_str();
+  ::minijson::value root, map_value;
+  if (::minijson::parse(p, root) != ::minijson::no_error)
+    return false;
+  const ::minijson::object *root_obj = root.as<::minijson::object>();
+  if (!root_obj || !root_obj->at("weight_map", &map_value))
+    return false;
+  const ::minijson::object *weight_map = map_value.as<::minijson::object>();
+  if (!weight_map || weight_map->size() == 0)
+    return false;
+
+  std::string dir(index_path);
+  size_t slash = dir.find_last_of('/');
+  dir = slash == std::string::npos ? std::string() : dir.substr(0, slash + 1);
+
+  std::unordered_map<std::string, bool> seen;
+  for (size_t i = 0; i < weight_map->size(); i++) {
+    ::minijson::value file_value;
+    if (!weight_map->at(i, &file_value))
+      return false;
+    const std::string *file = file_value.as<std::string>();
+    if (!file || file->empty() || file->find('/') != std::string::npos)
+      return false;
+    if (seen.insert(std::make_pair(*file, true)).second)
+      paths->push_back(dir + *file);
+  }
+  return true;
+}
+
+typedef struct {
+  const std::vector<std::string> *paths;
+  mapped_file_t *files;
+  safetensors::safetensors_t *shards;
+  char *ok; /* Per shard */
+  bool populate;
+} shard_task_t;
+
+/*
+ * Map and parse shards [s_start, s_end). Shards are faulted in
+ * concurrently, so populating them is spread over the disks they live on.
+ */
+static void shard_work(void *arg, int s_start, int s_end) {
+  const shard_task_t *t = (const shard_task_t *)arg;
+  for (int i = s_start; i < s_end; i++) {
+    const char *path = (*t->paths)[i].c_str();
+    if (!mapped_file_open(&t->files[i], path, t->populate)) {
+      fprintf(stderr, "Failed to load model: cannot map %s\n", path);
+      continue;
+    }
+
+    std::string warn, err;
+    if (!safetensors::mmap_from_memory(t->files[i].data, t->files[i].size,
+                                       path, &t->shards[i], &warn, &err)) {
+      fprintf(stderr, "Failed to load model: %s\n", err.c_str());
+      continue;
+    }
+    if (!safetensors::validate_data_offsets(t->shards[i], err)) {
+      fprintf(stderr, "Invalid safetensors file: %s\n", err.c_str());
+      continue;
+    }
+    t->ok[i] = 1;
+  }
+}
+
+static void place_tensor(const tensor_t *t) {
+  if (t && t->data)
+    numa_interleave(t->data, dtype_nbytes(t->dtype, t->numel));
+}
+
+/* Interleave every weight over the NUMA nodes (see numa.h) */
+static void place_weights(const qwen3_weights_t *weights) {
+  place_tensor(weights->embed_tokens);
+  place_tensor(weights->final_norm);
+  place_tensor(weights->lm_head);
+  for (int i = 0; i < weights->num_layers; i++) {
+    const qwen3_layer_weights_t *l = &weights->layers[i];
+    const tensor_t *tensors[] = {
+        l->q_proj,    l->k_proj,       l->v_proj,     l->qkv_proj,
+        l->o_proj,    l->q_norm,       l->k_norm,     l->gate_proj,
+        l->up_proj,   l->gate_up_proj, l->down_proj,  l->input_norm,
+        l->post_attn_norm};
+    for (size_t t = 0; t < sizeof(tensors) / sizeof(tensors[0]); t++)
+      place_tensor(tensors[t]);
+  }
+}
+
+/*
+ * Sort every source tensor into its layer's group, or the last group for
+ * the rest, with its byte span in the shard's mapping.
+ */
+static void group_tensors(const std::vector<safetensors::safetensors_t> &shards,
+                          const mapped_file_t *files, int num_layers,
+                          std::vector<tensor_group_t> *groups) {
+  groups->assign(num_layers + 1, tensor_group_t());
+  for (size_t i = 0; i < shards.size(); i++) {
+    const std::vector<std::string> &keys = shards[i].tensors.keys();
+    for (size_t k = 0; k < keys.size(); k++) {
+      safetensors::tensor_t st_tensor;
+      if (!shards[i].tensors.at(k, &st_tensor))
+        continue;
+      int layer = num_layers;
+      const char *name = keys[k].c_str();
+      if (strncmp(name, "model.layers.", 13) == 0) {
+        int l = atoi(name + 13);
+        if (l >= 0 && l < num_layers)
+          layer = l;
+      }
+      byte_span_t span;
+      span.shard = (int)i;
+      span.offset = (size_t)(shards[i].databuffer_addr - files[i].data) +
+                    st_tensor.data_offsets[0];
+      span.size = st_tensor.data_offsets[1] - st_tensor.data_offsets[0];
+      (*groups)[layer].spans.push_back(span);
+      (*groups)[layer].bytes += span.size;
+    }
+  }
+}
+
+static bool load_weights(qwen3_weights_t *weights,
+                         const model_config_t *config, const char *model_path,
+                         dtype_t dtype, qwen3_load_mode_t mode,
+                         dtype_t weight_dtype,
+                         qwen3_load_progress_fn progress_fn,
+                         void *progress_user) {
+  if (!weights || !config || !model_path)
+    return false;
+  if (!dtype_is_quantized(weight_dtype))
+    weight_dtype = dtype;
+
+  memset(weights, 0, sizeof(*weights));
+  weights->dtype = dtype;
+  weights->weight_dtype = weight_dtype;
+
+  /* Quantized models get their own cache: <model_path>.<dtype>.<qtype> */
+  char suffix[32];
+  if (weight_dtype != dtype)
+    snprintf(suffix, sizeof(suffix), ".%s", dtype_name(weight_dtype));
+  else
+    suffix[0] = '\0';
+
+  /* A sharded checkpoint has <model_path>.index.json instead of the file */
+  struct stat file_stat;
+  std::string index_path = std::string(model_path) + ".index.json";
+  std::vector<std::string> shard_paths;
+  const char *source_path = model_path;
+  if (stat(model_path, &file_stat) != 0 &&
+      stat(index_path.c_str(), &file_stat) == 0) {
+    if (!read_shard_index(index_path.c_str(), &shard_paths)) {
+      fprintf(stderr, "Failed to load model: bad shard index %s\n",
+              index_path.c_str());
+      return false;
+    }
+    source_path = index_path.c_str();
+  } else {
+    shard_paths.push_back(model_path);
+  }
+
+  char cache_path[1024];
+  weight_cache_key_t key;
+  bool use_cache =
+      mode == QWEN3_LOAD_PREPACKED &&
+      weight_cache_key_init(&key, source_path, dtype, QWEN3_WEIGHTS_LAYOUT) &&
+      snprintf(cache_path, sizeof(cache_path), "%s.%s%s.packed", model_path,
+               dtype_name(dtype), suffix) < (int)sizeof(cache_path);
+  /* The index does not change when a shard is replaced, so key on all */
+  if (source_path != model_path) {
+    for (size_t i = 0; use_cache && i < shard_paths.size(); i++)
+      use_cache = weight_cache_key_add_source(&key, shard_paths[i].c_str());
+  }
+  if (use_cache)
+    weights->cache = weight_cache_open(cache_path, &key);
+
+  int num_shards = (int)shard_paths.size();
+  weights->sources =
+      (mapped_file_t *)calloc(num_shards, sizeof(mapped_file_t));
+  if (!weights->sources) {
+    qwen3_weights_free(weights);
+    return false;
+  }
+  weights->num_sources = num_shards;
+
+  /* With a cache most bytes come from it, so fault the source in lazily.
+   * When progress is reported, layers are read as they are reached (see
+   * group_prefetch()) rather than all up front. */
+  std::vector<safetensors::safetensors_t> shards(num_shards);
+  std::vector<char> shard_ok(num_shards, 0);
+  shard_task_t shard_task = {&shard_paths, weights->sources, shards.data(),
+                             shard_ok.data(),
+                             !weights->cache && !progress_fn};
+  threadpool_parallel_for(threadpool_global(), 0, num_shards, 1, shard_work,
+                          &shard_task);
+  for (int i = 0; i < num_shards; i++) {
+    if (!shard_ok[i]) {
       qwen3_weights_free(weights);
       return false;
     }
   }
 
+  tensor_index_t names;
+  for (int i = 0; i < num_shards; i++) {
+    const std::vector<std::string> &keys = shards[i].tensors.keys();
+    for (size_t k = 0; k < keys.size(); k++) {
+      tensor_ref_t ref = {i, k};
+      names.insert(std::make_pair(keys[k], ref));
+    }
+  }
+
+  std::vector<tensor_group_t> groups;
+  group_tensors(shards, weights->sources, config->num_hidden_layers, &groups);
+
+  load_progress_t progress;
+  progress.fn = progress_fn;
+  progress.user = progress_user;
+  progress.bytes_done = progress.bytes_total = 0;
+  progress.tensors_done = progress.tensors_total = 0;
+  for (size_t g = 0; g < groups.size(); g++) {
+    progress.bytes_total += groups[g].bytes;
+    progress.tensors_total += (int)groups[g].spans.size();
+  }
+
+  std::mutex writer_lock;
+  load_ctx_t ctx = {&shards,
+                    &names,
+                    weights->sources,
+                    &groups,
+                    progress_fn ? &progress : NULL,
+                    mode,
+                    weights->cache,
+                    NULL,
+                    &writer_lock,
+                    weight_dtype};
+  if (use_cache && !weights->cache)
+    ctx.writer = weight_cache_writer_create();
+
+  if (!load_all_weights(weights, config, &ctx, dtype)) {
+    weight_cache_writer_free(ctx.writer);
+    qwen3_weights_free(weights);
+    return false;
+  }
+
+  /* Best effort: a read-only model directory just means no cache */
+  if (weight_cache_writer_count(ctx.writer) > 0)
+    weight_cache_writer_commit(ctx.writer, cache_path, &key);
+  weight_cache_writer_free(ctx.writer);
+
+  /* Every tensor was copied, so the mappings are no longer needed */
+  if (mode == QWEN3_LOAD_COPY) {
+    for (int i = 0; i < weights->num_sources; i++)
+      mapped_file_close(&weights->sources[i]);
+  }
+
+  if (numa_weight_placement() == NUMA_PLACEMENT_INTERLEAVE)
+    place_weights(weights);
   return true;
 }
 
+bool qwen3_weights_load_mode(qwen3_weights_t *weights,
+                             const model_config_t *config,
+                             const char *model_path, dtype_t dtype,
+                             qwen3_load_mode_t mode) {
+  return load_weights(weights, config, model_path, dtype, mode, dtype, NULL,
+                      NULL);
+}
+
+bool qwen3_weights_load_quant(qwen3_weights_t *weights,
+                              const model_config_t *config,
+                              const char *model_path, dtype_t dtype,
+                              qwen3_load_mode_t mode, dtype_t weight_dtype) {
+  return load_weights(weights, config, model_path, dtype, mode, weight_dtype,
+                      NULL, NULL);
+}
+
+bool qwen3_weights_load_progress(qwen3_weights_t *weights,
+                                 const model_config_t *config,
+                                 const char *model_path, dtype_t dtype,
+                                 qwen3_load_progress_fn fn, void *user) {
+  return load_weights(weights, config, model_path, dtype, default_load_mode(),
+                      default_weight_dtype(dtype), fn, user);
+}
+
 void qwen3_weights_free(qwen3_weights_t *weights) {
   if (!weights)
     return;
 
-  tensor_free(weights->embed_tokens);
-  tensor_free(weights->final_norm);
-
   /* Check if lm_head shares data with embed_tokens before freeing */
   if (weights->lm_head &&
       (!weights->embed_tokens ||
@@ -312,8 +988,8 @@ void qwen3_weights_free(qwen3_weights_t *weights) {
     free(weights->lm_head);
   }
 
-  /* Free the F32 version of LM head */
-  tensor_free(weights->lm_head_f32);
+  tensor_free(weights->embed_tokens);
+  tensor_free(weights->final_norm);
 
   if (weights->layers) {
     for (int i = 0; i < weights->num_layers; i++) {
@@ -321,11 +997,13 @@ void qwen3_weights_free(qwen3_weights_t *weights) {
       tensor_free(layer->q_proj);
       tensor_free(layer->k_proj);
       tensor_free(layer->v_proj);
+      tensor_free(layer->qkv_proj);
       tensor_free(layer->o_proj);
       tensor_free(layer->q_norm);
       tensor_free(layer->k_norm);
       tensor_free(layer->gate_proj);
       tensor_free(layer->up_proj);
+      tensor_free(layer->gate_up_proj);
       tensor_free(layer->down_proj);
       tensor_free(layer->input_norm);
       tensor_free(layer->post_attn_norm);
@@ -333,5 +1011,11 @@ void qwen3_weights_free(qwen3_weights_t *weights) {
     free(weights->layers);
   }
 
+  /* Mapped tensors point into these, so they go last */
+  weight_cache_close(weights->cache);
+  for (int i = 0; i < weights->num_sources; i++)
+    mapped_file_close(&weights->sources[i]);
+  free(weights->sources);
+
   memset(weights, 0, sizeof(*weights));
 }
@@ -4,6 +4,8 @@
 #include "inference/core/dtype.h"
 #include "inference/core/tensor.h"
 #include "inference/model/config.h"
+#include "inference/model_loader/mapped_file.h"
+#include "inference/model_loader/weight_cache.h"
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
@@ -12,24 +14,50 @@
 extern "C" {
 #endif
 
+/**
+ * How weights get from the safetensors file into memory.
+ */
+typedef enum {
+  /** Copy every tensor onto the heap; the file is unmapped after loading */
+  QWEN3_LOAD_COPY = 0,
+  /** Tensors already in the inference dtype point into the file mapping */
+  QWEN3_LOAD_MMAP,
+  /** As MMAP, and converted/transposed tensors come from a cache file
+   *  (<model_path>.<dtype>.packed) that the first load writes */
+  QWEN3_LOAD_PREPACKED,
+} qwen3_load_mode_t;
+
+/**
+ * Load progress callback, run after each layer (and once for the tensors
+ * outside the layers) with running totals over the checkpoint's source
+ * tensors. Layers load concurrently, so it can run on any loader thread,
+ * but calls are serialized and the totals only grow.
+ */
+typedef void (*qwen3_load_progress_fn)(void *user, size_t bytes_done,
+                                       size_t bytes_total, int tensors_done,
+                                       int tensors_total);
+
 /**
  * Per-layer weights for Qwen3 transformer.
  * Uses tensor_t for proper dtype tracking and memory management.
  */
 typedef struct {
-  /* Attention projections */
+  /* Attention projections; q/k/v are loaded stacked into qkv_proj, and the
+   * separate tensors are then NULL */
   tensor_t *q_proj;
   tensor_t *k_proj;
   tensor_t *v_proj;
+  tensor_t *qkv_proj;
   tensor_t *o_proj;
 
   /* QK normalization weights (Qwen3-specific) */
   tensor_t *q_norm;
   tensor_t *k_norm;
 
-  /* FFN projections */
+  /* FFN projections; gate/up are loaded stacked into gate_up_proj */
   tensor_t *gate_proj;
   tensor_t *up_proj;
+  tensor_t *gate_up_proj;
   tensor_t *down_proj;
 
   /* Layer normalization weights */
@@ -44,27 +72,109 @@ typedef struct {
   tensor_t *embed_tokens; /* Token embeddings [vocab_size, hidden_size] */
   tensor_t *final_norm;   /* Final layer norm [hidden_size] */
   tensor_t *lm_head;      /* Language model head [vocab_size, hidden_size] */
-  tensor_t *lm_head_f32;  /* F32 version for fast single-token decode (F16 only)
-                           */
 
   qwen3_layer_weights_t *layers; /* Per-layer weights */
   int num_layers;
 
-  dtype_t dtype; /* Inference dtype */
+  dtype_t dtype;        /* Inference dtype */
+  dtype_t weight_dtype; /* Projection weights: dtype, Q8_0 or Q4_0 */
+
+  /* Safetensors mappings, one per shard (MMAP/PREPACKED modes) */
+  mapped_file_t *sources;
+  int num_sources;
+  weight_cache_t *cache; /* Prepacked cache mapping, NULL if not in use */
 } qwen3_weights_t;
 
 /**
  * Load model weights from safetensors file.
  *
+ * A sharded checkpoint has no model_path itself but
+ * <model_path>.index.json, whose weight_map names the shard files in the
+ * same directory; they are mapped concurrently and tensors are found by name
+ * across all of them. When the model has at least as many layers as the
+ * shared pool has threads, layers are converted in parallel. The source
+ * pages of the next layer are prefetched while the current one converts.
+ *
+ * Projections that share an input are stacked along their outputs at load
+ * time (q|k|v and gate|up), so each runs as a single GEMM.
+ *
+ * Uses QWEN3_LOAD_PREPACKED unless the SILLYTUI_WEIGHTS_LOAD environment
+ * variable selects "copy" or "mmap". SILLYTUI_WEIGHTS_QUANT=q8_0 or q4_0
+ * quantizes the projections (see qwen3_weights_load_quant()).
+ *
+ * On hosts with several NUMA nodes every load mode interleaves the weight
+ * pages over the nodes once loaded (see numa_weight_placement()).
+ *
  * @param weights Output weights structure
  * @param config Model configuration
- * @param model_path Path to model.safetensors
+ * @param model_path Path to model.safetensors (see above for shards)
  * @param dtype Target dtype for inference (F32 or F16)
  * @return true on success, false on failure
  */
 bool qwen3_weights_load(qwen3_weights_t *weights, const model_config_t *config,
                         const char *model_path, dtype_t dtype);
 
+/**
+ * Load model weights with an explicit load mode.
+ *
+ * Mapped tensors do not own their data; the mappings are released by
+ * qwen3_weights_free(). A cache that cannot be written (read-only model
+ * directory) is not an error: the converted tensors simply stay on the heap.
+ *
+ * @param weights Output weights structure
+ * @param config Model configuration
+ * @param model_path Path to model.safetensors
+ * @param dtype Target dtype for inference (F32 or F16)
+ * @param mode Load mode
+ * @return true on success, false on failure
+ */
+bool qwen3_weights_load_mode(qwen3_weights_t *weights,
+                             const model_config_t *config,
+                             const char *model_path, dtype_t dtype,
+                             qwen3_load_mode_t mode);
+
+/**
+ * Load model weights with block-quantized projections.
+ *
+ * The attention and FFN projections are quantized to weight_dtype
+ * (DTYPE_Q8_0 or DTYPE_Q4_0) while loading, and the lm_head to Q8_0.
+ * Embeddings and norms stay in dtype, as does any projection whose input
+ * size is not a multiple of QUANT_BLOCK_SIZE. In PREPACKED mode the
+ * quantized tensors are cached in <model_path>.<dtype>.<qtype>.packed.
+ * Any other weight_dtype loads the model unquantized.
+ *
+ * @param weights Output weights structure
+ * @param config Model configuration
+ * @param model_path Path to model.safetensors
+ * @param dtype Target dtype for inference (F32 or F16)
+ * @param mode Load mode
+ * @param weight_dtype Projection weight dtype
+ * @return true on success, false on failure
+ */
+bool qwen3_weights_load_quant(qwen3_weights_t *weights,
+                              const model_config_t *config,
+                              const char *model_path, dtype_t dtype,
+                              qwen3_load_mode_t mode, dtype_t weight_dtype);
+
+/**
+ * Load model weights as qwen3_weights_load() does, reporting progress.
+ *
+ * The shards are not faulted in when they are mapped; each layer is read
+ * ahead of its conversion instead, so the reported bytes follow the disk.
+ *
+ * @param weights Output weights structure
+ * @param config Model configuration
+ * @param model_path Path to model.safetensors
+ * @param dtype Target dtype for inference (F32 or F16)
+ * @param fn Progress callback (NULL for none)
+ * @param user Opaque argument passed to fn
+ * @return true on success, false on failure
+ */
+bool qwen3_weights_load_progress(qwen3_weights_t *weights,
+                                 const model_config_t *config,
+                                 const char *model_path, dtype_t dtype,
+                                 qwen3_load_progress_fn fn, void *user);
+
 /**
  * Free all weights and tensors.
  */
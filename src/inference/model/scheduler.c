@@ -0,0 +1,375 @@
+/*
+ * Continuous Batching Scheduler - Implementation
+ *
+ * Each step first gives every decoding sequence its next token, then fills
+ * the remaining token budget with prompt chunks in submission order. Decodes
+ * go first so that running chats keep a steady token rate while new prompts
+ * are being prefilled.
+ *
+ * Only the model's ops table is used, so any model that implements the
+ * sequence ops can be scheduled.
+ */
+
+#include "inference/model/scheduler.h"
+#include "inference/kernels/sampling/sampling.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define SCHED_DEFAULT_BATCH_SEQS 16
+#define SCHED_DEFAULT_BATCH_TOKENS 256
+#define SCHED_DEFAULT_PREFILL_CHUNK 128
+
+typedef struct {
+  int id;
+  scheduler_seq_state_t state;
+  inference_seq_t *seq;
+  scheduler_params_t params;
+  sampling_rng_t rng;
+  scheduler_token_cb cb;
+  void *userdata;
+
+  int *prompt;
+  int num_prompt;
+  int prefilled; /* Prompt tokens already in the KV cache */
+
+  int *output;
+  int num_output;
+  int context_len; /* Tokens in the KV cache */
+} sched_seq_t;
+
+struct scheduler {
+  inference_model_t *model;
+  scheduler_config_t config;
+
+  sched_seq_t *seqs; /* In submission order */
+  int num_seqs;
+  int capacity;
+  int next_id;
+
+  /* Per-step batch, sized for config.max_batch_seqs */
+  inference_seq_t **batch_seqs;
+  const int **batch_tokens;
+  int *batch_counts;
+  int *batch_index;
+  float *logits;
+  sampling_workspace_t sampler; /* Sequences are sampled one at a time */
+
+  scheduler_stats_t stats;
+};
+
+static double now_ms(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static bool is_running(const sched_seq_t *s) {
+  return s->state == SCHED_SEQ_PREFILL || s->state == SCHED_SEQ_DECODE;
+}
+
+static sched_seq_t *find_seq(const scheduler_t *sched, int seq_id) {
+  if (!sched)
+    return NULL;
+  for (int i = 0; i < sched->num_seqs; i++) {
+    if (sched->seqs[i].id == seq_id)
+      return &sched->seqs[i];
+  }
+  return NULL;
+}
+
+/* Offer the tokens in a sequence's KV cache to the model's prefix cache */
+static void cache_prefix(scheduler_t *sched, sched_seq_t *s) {
+  inference_model_t *model = sched->model;
+  if (!model->ops->seq_cache_prefix || s->context_len <= 0)
+    return;
+
+  int *history = (int *)malloc(s->context_len * sizeof(int));
+  if (!history)
+    return;
+  int from_prompt =
+      s->context_len < s->num_prompt ? s->context_len : s->num_prompt;
+  memcpy(history, s->prompt, from_prompt * sizeof(int));
+  memcpy(history + from_prompt, s->output,
+         (s->context_len - from_prompt) * sizeof(int));
+  model->ops->seq_cache_prefix(model, s->seq, history, s->context_len);
+  free(history);
+}
+
+/* Drop the KV cache of a sequence that stopped running */
+static void retire_seq(scheduler_t *sched, sched_seq_t *s,
+                       scheduler_seq_state_t state) {
+  s->state = state;
+  if (s->seq && state != SCHED_SEQ_FAILED)
+    cache_prefix(sched, s);
+  if (s->seq)
+    sched->model->ops->seq_free(sched->model, s->seq);
+  s->seq = NULL;
+}
+
+scheduler_t *scheduler_create(inference_model_t *model,
+                              const scheduler_config_t *config) {
+  if (!model || !model->ops || !model->ops->forward_batch ||
+      !model->ops->seq_create || !model->ops->seq_free ||
+      model->vocab_size <= 0)
+    return NULL;
+
+  scheduler_t *sched = (scheduler_t *)calloc(1, sizeof(scheduler_t));
+  if (!sched)
+    return NULL;
+
+  sched->model = model;
+  if (config)
+    sched->config = *config;
+  if (sched->config.max_batch_seqs <= 0)
+    sched->config.max_batch_seqs = SCHED_DEFAULT_BATCH_SEQS;
+  if (sched->config.max_batch_tokens <= 0)
+    sched->config.max_batch_tokens = SCHED_DEFAULT_BATCH_TOKENS;
+  if (sched->config.prefill_chunk <= 0)
+    sched->config.prefill_chunk = SCHED_DEFAULT_PREFILL_CHUNK;
+
+  int n = sched->config.max_batch_seqs;
+  sched->batch_seqs = (inference_seq_t **)malloc(n * sizeof(inference_seq_t *));
+  sched->batch_tokens = (const int **)malloc(n * sizeof(const int *));
+  sched->batch_counts = (int *)malloc(n * sizeof(int));
+  sched->batch_index = (int *)malloc(n * sizeof(int));
+  sched->logits =
+      (float *)malloc((size_t)n * model->vocab_size * sizeof(float));
+  bool sampler = sampling_workspace_init(&sched->sampler, model->vocab_size);
+  if (!sched->batch_seqs || !sched->batch_tokens || !sched->batch_counts ||
+      !sched->batch_index || !sched->logits || !sampler) {
+    scheduler_destroy(sched);
+    return NULL;
+  }
+  return sched;
+}
+
+void scheduler_destroy(scheduler_t *sched) {
+  if (!sched)
+    return;
+  for (int i = 0; i < sched->num_seqs; i++) {
+    if (sched->seqs[i].seq)
+      sched->model->ops->seq_free(sched->model, sched->seqs[i].seq);
+    free(sched->seqs[i].prompt);
+    free(sched->seqs[i].output);
+  }
+  free(sched->seqs);
+  free(sched->batch_seqs);
+  free(sched->batch_tokens);
+  free(sched->batch_counts);
+  free(sched->batch_index);
+  free(sched->logits);
+  sampling_workspace_free(&sched->sampler);
+  free(sched);
+}
+
+int scheduler_submit(scheduler_t *sched, const int *prompt, int num_prompt,
+                     const scheduler_params_t *params, scheduler_token_cb cb,
+                     void *userdata) {
+  if (!sched || !prompt || num_prompt <= 0 || !params ||
+      params->max_tokens <= 0)
+    return -1;
+  if (sched->model->max_seq_len > 0 && num_prompt > sched->model->max_seq_len)
+    return -1;
+
+  if (sched->num_seqs == sched->capacity) {
+    int capacity = sched->capacity ? sched->capacity * 2 : 16;
+    sched_seq_t *seqs =
+        (sched_seq_t *)realloc(sched->seqs, capacity * sizeof(sched_seq_t));
+    if (!seqs)
+      return -1;
+    sched->seqs = seqs;
+    sched->capacity = capacity;
+  }
+
+  sched_seq_t s;
+  memset(&s, 0, sizeof(s));
+  s.prompt = (int *)malloc(num_prompt * sizeof(int));
+  s.output = (int *)malloc(params->max_tokens * sizeof(int));
+  s.seq = sched->model->ops->seq_create(sched->model);
+  if (!s.prompt || !s.output || !s.seq) {
+    free(s.prompt);
+    free(s.output);
+    if (s.seq)
+      sched->model->ops->seq_free(sched->model, s.seq);
+    return -1;
+  }
+
+  memcpy(s.prompt, prompt, num_prompt * sizeof(int));
+  s.num_prompt = num_prompt;
+
+  /* The last prompt token always runs so that it produces logits */
+  if (sched->model->ops->seq_reuse_prefix) {
+    s.prefilled = sched->model->ops->seq_reuse_prefix(sched->model, s.seq,
+                                                      prompt, num_prompt - 1);
+    s.context_len = s.prefilled;
+    sched->stats.cached_tokens += s.prefilled;
+  }
+  s.id = sched->next_id++;
+  s.state = SCHED_SEQ_PREFILL;
+  s.params = *params;
+  s.cb = cb;
+  s.userdata = userdata;
+  sampling_rng_init(&s.rng, params->seed);
+
+  sched->seqs[sched->num_seqs++] = s;
+  return s.id;
+}
+
+bool scheduler_cancel(scheduler_t *sched, int seq_id) {
+  sched_seq_t *s = find_seq(sched, seq_id);
+  if (!s || !is_running(s))
+    return false;
+  retire_seq(sched, s, SCHED_SEQ_CANCELLED);
+  return true;
+}
+
+void scheduler_release(scheduler_t *sched, int seq_id) {
+  sched_seq_t *s = find_seq(sched, seq_id);
+  if (!s)
+    return;
+
+  if (s->seq)
+    sched->model->ops->seq_free(sched->model, s->seq);
+  free(s->prompt);
+  free(s->output);
+
+  int index = (int)(s - sched->seqs);
+  memmove(&sched->seqs[index], &sched->seqs[index + 1],
+          (sched->num_seqs - index - 1) * sizeof(sched_seq_t));
+  sched->num_seqs--;
+}
+
+/* Sample the next token of a sequence from its row of logits */
+static void sample_token(scheduler_t *sched, sched_seq_t *s,
+                         const float *logits) {
+  const scheduler_params_t *p = &s->params;
+  int token = sampling_sample_ws_f32(&sched->sampler, logits,
+                                     sched->model->vocab_size, p->temperature,
+                                     p->top_k, p->top_p, p->min_p, &s->rng);
+  s->output[s->num_output++] = token;
+  sched->stats.decode_tokens++;
+
+  /* The token is fed back next step, which needs one more context slot */
+  bool finished = token == p->eos_token_id ||
+                  s->num_output >= p->max_tokens ||
+                  (sched->model->max_seq_len > 0 &&
+                   s->context_len >= sched->model->max_seq_len);
+  if (finished)
+    retire_seq(sched, s, SCHED_SEQ_FINISHED);
+  if (s->cb)
+    s->cb(s->id, token, finished, s->userdata);
+}
+
+int scheduler_step(scheduler_t *sched) {
+  if (!sched)
+    return -1;
+
+  int max_seqs = sched->config.max_batch_seqs;
+  int budget = sched->config.max_batch_tokens;
+  int n = 0;
+  int rows = 0;
+
+  /* Next token of every decoding sequence */
+  for (int i = 0; i < sched->num_seqs && n < max_seqs && rows < budget; i++) {
+    sched_seq_t *s = &sched->seqs[i];
+    if (s->state != SCHED_SEQ_DECODE)
+      continue;
+    sched->batch_seqs[n] = s->seq;
+    sched->batch_tokens[n] = &s->output[s->num_output - 1];
+    sched->batch_counts[n] = 1;
+    sched->batch_index[n] = i;
+    n++;
+    rows++;
+  }
+
+  /* Prompt chunks with whatever budget is left */
+  for (int i = 0; i < sched->num_seqs && n < max_seqs && rows < budget; i++) {
+    sched_seq_t *s = &sched->seqs[i];
+    if (s->state != SCHED_SEQ_PREFILL)
+      continue;
+    int chunk = s->num_prompt - s->prefilled;
+    if (chunk > sched->config.prefill_chunk)
+      chunk = sched->config.prefill_chunk;
+    if (chunk > budget - rows)
+      chunk = budget - rows;
+    sched->batch_seqs[n] = s->seq;
+    sched->batch_tokens[n] = &s->prompt[s->prefilled];
+    sched->batch_counts[n] = chunk;
+    sched->batch_index[n] = i;
+    n++;
+    rows += chunk;
+  }
+
+  if (n == 0)
+    return 0;
+
+  double start = now_ms();
+  bool ok = sched->model->ops->forward_batch(
+      sched->model, sched->batch_seqs, sched->batch_tokens,
+      sched->batch_counts, n, sched->logits);
+  sched->stats.forward_ms += now_ms() - start;
+  sched->stats.steps++;
+  if ((uint64_t)n > sched->stats.max_batch_seqs)
+    sched->stats.max_batch_seqs = n;
+
+  if (!ok) {
+    for (int b = 0; b < n; b++)
+      retire_seq(sched, &sched->seqs[sched->batch_index[b]],
+                 SCHED_SEQ_FAILED);
+    return -1;
+  }
+
+  size_t vocab_size = (size_t)sched->model->vocab_size;
+  for (int b = 0; b < n; b++) {
+    sched_seq_t *s = &sched->seqs[sched->batch_index[b]];
+    if (!is_running(s))
+      continue; /* Cancelled by a callback earlier in this step */
+    s->context_len += sched->batch_counts[b];
+
+    if (s->state == SCHED_SEQ_PREFILL) {
+      s->prefilled += sched->batch_counts[b];
+      sched->stats.prefill_tokens += sched->batch_counts[b];
+      if (s->prefilled < s->num_prompt)
+        continue; /* Logits of a partial prompt are not needed */
+      s->state = SCHED_SEQ_DECODE;
+    }
+    sample_token(sched, s, sched->logits + b * vocab_size);
+  }
+  return rows;
+}
+
+int scheduler_num_active(const scheduler_t *sched) {
+  if (!sched)
+    return 0;
+  int active = 0;
+  for (int i = 0; i < sched->num_seqs; i++) {
+    if (is_running(&sched->seqs[i]))
+      active++;
+  }
+  return active;
+}
+
+scheduler_seq_state_t scheduler_seq_state(const scheduler_t *sched,
+                                          int seq_id) {
+  const sched_seq_t *s = find_seq(sched, seq_id);
+  return s ? s->state : SCHED_SEQ_UNKNOWN;
+}
+
+const int *scheduler_seq_output(const scheduler_t *sched, int seq_id,
+                                int *num_tokens) {
+  const sched_seq_t *s = find_seq(sched, seq_id);
+  if (num_tokens)
+    *num_tokens = s ? s->num_output : 0;
+  return s ? s->output : NULL;
+}
+
+void scheduler_get_stats(const scheduler_t *sched, scheduler_stats_t *stats) {
+  if (!stats)
+    return;
+  if (!sched) {
+    memset(stats, 0, sizeof(*stats));
+    return;
+  }
+  *stats = sched->stats;
+}
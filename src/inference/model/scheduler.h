@@ -0,0 +1,144 @@
+/*
+ * Continuous Batching Scheduler
+ *
+ * Runs any number of independent generation requests on one model. Every
+ * scheduler_step() packs the next token of each decoding sequence and a
+ * chunk of pending prompts into a single forward_batch() call, so weights
+ * are streamed from memory once per step instead of once per sequence, and
+ * new prompts are prefilled in between ongoing decodes instead of stalling
+ * them.
+ *
+ * When the model keeps a prefix cache, a new prompt starts from the KV of
+ * the longest prefix it shares with earlier requests, and every sequence
+ * that finishes or is cancelled leaves its KV in the cache for later ones.
+ *
+ * The scheduler is single-threaded: submit, cancel and step must not be
+ * called concurrently.
+ */
+
+#ifndef INFERENCE_MODEL_SCHEDULER_H
+#define INFERENCE_MODEL_SCHEDULER_H
+
+#include "inference/model/base.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct scheduler scheduler_t;
+
+typedef enum {
+  SCHED_SEQ_UNKNOWN = 0, /* No such sequence (or released) */
+  SCHED_SEQ_PREFILL,     /* Prompt not fully processed yet */
+  SCHED_SEQ_DECODE,      /* Generating */
+  SCHED_SEQ_FINISHED,    /* Hit max_tokens, EOS or the context limit */
+  SCHED_SEQ_CANCELLED,
+  SCHED_SEQ_FAILED, /* The forward pass failed */
+} scheduler_seq_state_t;
+
+typedef struct {
+  int max_batch_seqs;   /* Sequences per step (0 = 16) */
+  int max_batch_tokens; /* Tokens per step, decode + prefill (0 = 256) */
+  int prefill_chunk;    /* Prompt tokens per sequence per step (0 = 128) */
+} scheduler_config_t;
+
+typedef struct {
+  float temperature;
+  int top_k;
+  float top_p;
+  float min_p;
+  uint64_t seed;
+  int max_tokens;   /* Tokens to generate */
+  int eos_token_id; /* Stops the sequence when sampled (-1 = none) */
+} scheduler_params_t;
+
+typedef struct {
+  uint64_t steps;          /* Forward passes run */
+  uint64_t prefill_tokens; /* Prompt tokens processed */
+  uint64_t cached_tokens;  /* Prompt tokens reused from the prefix cache */
+  uint64_t decode_tokens;  /* Tokens sampled */
+  uint64_t max_batch_seqs; /* Largest number of sequences in one step */
+  double forward_ms;       /* Time spent in forward passes */
+} scheduler_stats_t;
+
+/*
+ * Called for every sampled token. finished is true for the sequence's last
+ * token; its state has already been updated when the callback runs. The
+ * callback may submit or cancel sequences but must not release them.
+ */
+typedef void (*scheduler_token_cb)(int seq_id, int token, bool finished,
+                                   void *userdata);
+
+/*
+ * Create a scheduler on a loaded model that implements the sequence ops.
+ *
+ * Parameters:
+ *   model:  loaded model, must outlive the scheduler
+ *   config: batch limits, or NULL for the defaults
+ *
+ * Returns: new scheduler, or NULL on failure
+ */
+scheduler_t *scheduler_create(inference_model_t *model,
+                              const scheduler_config_t *config);
+
+/* Free the scheduler and every sequence still held by it */
+void scheduler_destroy(scheduler_t *sched);
+
+/*
+ * Queue a request. The prompt is copied.
+ *
+ * Parameters:
+ *   prompt:     prompt token ids
+ *   num_prompt: number of prompt tokens (at least 1)
+ *   params:     sampling parameters
+ *   cb:         token callback (can be NULL)
+ *   userdata:   passed to cb
+ *
+ * Returns: sequence id (>= 0), or -1 if the request is invalid or does not
+ * fit the model's context
+ */
+int scheduler_submit(scheduler_t *sched, const int *prompt, int num_prompt,
+                     const scheduler_params_t *params, scheduler_token_cb cb,
+                     void *userdata);
+
+/*
+ * Stop a running sequence and release its KV cache. Its output so far stays
+ * available until scheduler_release().
+ *
+ * Returns: false if the sequence is unknown or no longer running
+ */
+bool scheduler_cancel(scheduler_t *sched, int seq_id);
+
+/*
+ * Run one batched forward pass over the running sequences.
+ *
+ * Returns: number of tokens processed (0 when idle), or -1 if the forward
+ * pass failed; the sequences in that batch are then marked failed.
+ */
+int scheduler_step(scheduler_t *sched);
+
+/* Number of sequences still prefilling or decoding */
+int scheduler_num_active(const scheduler_t *sched);
+
+scheduler_seq_state_t scheduler_seq_state(const scheduler_t *sched,
+                                          int seq_id);
+
+/*
+ * Tokens generated so far. The pointer is valid until the next step or
+ * release.
+ */
+const int *scheduler_seq_output(const scheduler_t *sched, int seq_id,
+                                int *num_tokens);
+
+/* Forget a sequence, cancelling it first if it is still running */
+void scheduler_release(scheduler_t *sched, int seq_id);
+
+void scheduler_get_stats(const scheduler_t *sched, scheduler_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,359 @@
+/*
+ * Speculative Decoding - Implementation
+ *
+ * The last sampled token is kept pending (not yet in either KV cache). A
+ * step drafts up to num_draft tokens after it, runs the target over the
+ * pending token and the drafts with seq_forward_all(), and walks the drafts
+ * with the acceptance test. The target's logits after the last kept token
+ * give the next pending token, either resampled at the rejected position or
+ * sampled after a fully accepted draft, so every step makes progress.
+ *
+ * Only the models' ops tables are used, like the scheduler.
+ */
+
+#include "inference/model/speculative.h"
+#include "inference/kernels/sampling/sampling.h"
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#define SPECULATIVE_DEFAULT_DRAFT 4
+#define SPECULATIVE_DEFAULT_NGRAM_MAX 3
+#define SPECULATIVE_DEFAULT_NGRAM_MIN 1
+
+typedef struct {
+  inference_model_t *target;
+  inference_model_t *draft; /* NULL for prompt lookup */
+  inference_seq_t *target_seq;
+  inference_seq_t *draft_seq;
+  const speculative_params_t *params;
+  sampling_rng_t rng;
+  sampling_workspace_t sampler;
+  int vocab_size;
+  int num_draft;
+  int ngram_max;
+  int ngram_min;
+
+  int *ctx;       /* Prompt and generated tokens */
+  int ctx_len;    /* The last one is the pending token */
+  int target_len; /* Tokens in the target's KV cache */
+  int draft_len;  /* Tokens in the draft model's KV cache */
+
+  float *logits;      /* Target rows [num_draft + 1, vocab_size] */
+  float *draft_probs; /* Draft distributions [num_draft, vocab_size] */
+  float *probs;       /* [vocab_size] */
+} spec_state_t;
+
+static double now_ms(void) {
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return tv.tv_sec * 1000.0 + tv.tv_usec / 1000.0;
+}
+
+static void probs_from_logits(spec_state_t *s, const float *logits,
+                              float *probs) {
+  const speculative_params_t *p = s->params;
+  /* The workspace is sized up front, so this cannot fail */
+  sampling_probs_f32(&s->sampler, logits, probs, s->vocab_size, p->temperature,
+                     p->top_k, p->top_p, p->min_p);
+}
+
+/* Run the prompt, starting from the longest prefix the model has cached */
+static bool prefill(inference_model_t *model, inference_seq_t *seq,
+                    const int *tokens, int num_tokens, float *logits) {
+  int cached = 0;
+  if (model->ops->seq_reuse_prefix)
+    cached = model->ops->seq_reuse_prefix(model, seq, tokens, num_tokens - 1);
+  const int *rest = tokens + cached;
+  int count = num_tokens - cached;
+  return model->ops->forward_batch(model, &seq, &rest, &count, 1, logits);
+}
+
+/*
+ * Prompt lookup: find the most recent earlier occurrence of the context's
+ * last n tokens, longest n first, and propose what followed it
+ */
+static int lookup_draft(const spec_state_t *s, int *drafts, int max) {
+  const int *ctx = s->ctx;
+  int len = s->ctx_len;
+  for (int n = s->ngram_max; n >= s->ngram_min; n--) {
+    if (n >= len)
+      continue;
+    const int *tail = ctx + len - n;
+    for (int start = len - n - 1; start >= 0; start--) {
+      if (memcmp(ctx + start, tail, (size_t)n * sizeof(int)) != 0)
+        continue;
+      int count = 0;
+      while (count < max && start + n + count < len) {
+        drafts[count] = ctx[start + n + count];
+        count++;
+      }
+      return count;
+    }
+  }
+  return 0;
+}
+
+/*
+ * Draft model: catch its cache up to the pending token, then sample one
+ * token at a time, keeping each distribution for the acceptance test.
+ * Returns the number of drafts, or -1 if a forward pass failed.
+ */
+static int model_draft(spec_state_t *s, int *drafts, int max) {
+  inference_model_t *draft = s->draft;
+  inference_seq_t *seq = s->draft_seq;
+  int V = s->vocab_size;
+  /* The last draft is sampled but never fed */
+  if (s->ctx_len + max - 1 > draft->max_seq_len)
+    max = draft->max_seq_len - s->ctx_len + 1;
+  if (max <= 0)
+    return 0;
+
+  const int *tokens = s->ctx + s->draft_len;
+  int count = s->ctx_len - s->draft_len;
+  for (int i = 0; i < max; i++) {
+    float *q = s->draft_probs + (size_t)i * V;
+    if (!draft->ops->forward_batch(draft, &seq, &tokens, &count, 1, q))
+      return -1;
+    s->draft_len += count;
+    probs_from_logits(s, q, q);
+    drafts[i] = sampling_sample_probs_f32(q, V, &s->rng);
+    tokens = &drafts[i];
+    count = 1;
+  }
+  return max;
+}
+
+/*
+ * The acceptance test at draft position i. Returns true if drafts[i] is
+ * kept; otherwise *next receives the token resampled from max(0, p - q).
+ */
+static bool accept_draft(spec_state_t *s, const int *drafts, int i,
+                         int *next) {
+  int V = s->vocab_size;
+  float *p = s->probs;
+  int x = drafts[i];
+  probs_from_logits(s, s->logits + (size_t)i * V, p);
+
+  /* Prompt lookup drafts deterministically: q is all mass on x */
+  const float *q = s->draft ? s->draft_probs + (size_t)i * V : NULL;
+  float qx = q ? q[x] : 1.0f;
+  if (sampling_rng_f32(&s->rng) * qx < p[x])
+    return true;
+
+  float sum = 0.0f;
+  if (q) {
+    for (int v = 0; v < V; v++) {
+      float r = p[v] - q[v];
+      p[v] = r > 0.0f ? r : 0.0f;
+      sum += p[v];
+    }
+  } else {
+    p[x] = 0.0f;
+    for (int v = 0; v < V; v++)
+      sum += p[v];
+  }
+
+  if (sum > 0.0f) {
+    float inv = 1.0f / sum;
+    for (int v = 0; v < V; v++)
+      p[v] *= inv;
+  } else {
+    /* p <= q everywhere only up to rounding: fall back to p itself */
+    probs_from_logits(s, s->logits + (size_t)i * V, p);
+  }
+  *next = sampling_sample_probs_f32(p, V, &s->rng);
+  return false;
+}
+
+static bool is_finished(const spec_state_t *s, int token, int generated) {
+  return token == s->params->eos_token_id ||
+         generated >= s->params->max_tokens;
+}
+
+static bool check_models(inference_model_t *target, inference_model_t *draft) {
+  if (!target || !target->ops || !target->ops->seq_create ||
+      !target->ops->seq_free || !target->ops->forward_batch ||
+      !target->ops->seq_forward_all || !target->ops->seq_truncate)
+    return false;
+  if (!draft)
+    return true;
+  return draft->ops && draft->ops->seq_create && draft->ops->seq_free &&
+         draft->ops->forward_batch && draft->ops->seq_truncate &&
+         draft->vocab_size == target->vocab_size;
+}
+
+static void release(spec_state_t *s) {
+  if (s->target_seq)
+    s->target->ops->seq_free(s->target, s->target_seq);
+  if (s->draft_seq)
+    s->draft->ops->seq_free(s->draft, s->draft_seq);
+  free(s->ctx);
+  free(s->logits);
+  free(s->draft_probs);
+  free(s->probs);
+  sampling_workspace_free(&s->sampler);
+}
+
+int speculative_generate(inference_model_t *target, inference_model_t *draft,
+                         int *output_tokens, const int *input_tokens,
+                         int num_input_tokens,
+                         const speculative_params_t *params,
+                         speculative_stats_t *stats) {
+  if (stats)
+    memset(stats, 0, sizeof(*stats));
+  if (!check_models(target, draft) || !output_tokens || !input_tokens ||
+      num_input_tokens <= 0 || !params ||
+      num_input_tokens >= target->max_seq_len)
+    return -1;
+  if (params->max_tokens <= 0)
+    return 0;
+
+  spec_state_t s;
+  memset(&s, 0, sizeof(s));
+  s.target = target;
+  s.draft = draft;
+  s.params = params;
+  s.vocab_size = target->vocab_size;
+  s.num_draft = params->num_draft > 0 ? params->num_draft
+                                      : SPECULATIVE_DEFAULT_DRAFT;
+  if (s.num_draft > SPECULATIVE_MAX_DRAFT)
+    s.num_draft = SPECULATIVE_MAX_DRAFT;
+  s.ngram_max = params->ngram_max > 0 ? params->ngram_max
+                                      : SPECULATIVE_DEFAULT_NGRAM_MAX;
+  s.ngram_min = params->ngram_min > 0 ? params->ngram_min
+                                      : SPECULATIVE_DEFAULT_NGRAM_MIN;
+  if (s.ngram_min > s.ngram_max)
+    s.ngram_min = s.ngram_max;
+  sampling_rng_init(&s.rng, params->seed);
+
+  size_t V = (size_t)s.vocab_size;
+  s.ctx = (int *)malloc(
+      (size_t)(num_input_tokens + params->max_tokens) * sizeof(int));
+  s.logits = (float *)malloc((size_t)(s.num_draft + 1) * V * sizeof(float));
+  s.probs = (float *)malloc(V * sizeof(float));
+  if (draft)
+    s.draft_probs = (float *)malloc((size_t)s.num_draft * V * sizeof(float));
+  s.target_seq = target->ops->seq_create(target);
+  if (draft)
+    s.draft_seq = draft->ops->seq_create(draft);
+  bool sampler = sampling_workspace_init(&s.sampler, s.vocab_size);
+  if (!s.ctx || !s.logits || !s.probs || !sampler || !s.target_seq ||
+      (draft && (!s.draft_probs || !s.draft_seq))) {
+    release(&s);
+    return -1;
+  }
+
+  memcpy(s.ctx, input_tokens, (size_t)num_input_tokens * sizeof(int));
+  s.ctx_len = num_input_tokens;
+  if (!prefill(target, s.target_seq, input_tokens, num_input_tokens,
+               s.logits) ||
+      (draft && !prefill(draft, s.draft_seq, input_tokens, num_input_tokens,
+                         s.draft_probs))) {
+    release(&s);
+    return -1;
+  }
+  s.target_len = num_input_tokens;
+  s.draft_len = num_input_tokens;
+
+  probs_from_logits(&s, s.logits, s.probs);
+  int pending = sampling_sample_probs_f32(s.probs, s.vocab_size, &s.rng);
+  int generated = 0;
+  double start = now_ms();
+  int drafts[SPECULATIVE_MAX_DRAFT];
+
+  for (;;) {
+    output_tokens[generated++] = pending;
+    s.ctx[s.ctx_len++] = pending;
+    if (is_finished(&s, pending, generated))
+      break;
+
+    /* Room for the pending token and the drafts in the target's cache */
+    int room = target->max_seq_len - s.target_len - 1;
+    if (room < 0)
+      break;
+    int max = s.num_draft < room ? s.num_draft : room;
+    if (max > params->max_tokens - generated)
+      max = params->max_tokens - generated;
+
+    int k = draft ? model_draft(&s, drafts, max)
+                  : lookup_draft(&s, drafts, max);
+    if (k < 0)
+      break;
+
+    /* Verify the pending token and the drafts in one pass */
+    int verify[SPECULATIVE_MAX_DRAFT + 1];
+    verify[0] = pending;
+    memcpy(verify + 1, drafts, (size_t)k * sizeof(int));
+    if (!target->ops->seq_forward_all(target, s.target_seq, verify, k + 1,
+                                      s.logits))
+      break;
+    int base = s.target_len + 1; /* Cache length keeping only pending */
+    s.target_len += k + 1;
+    if (stats) {
+      stats->steps++;
+      stats->drafted += k;
+    }
+
+    int kept = 0;
+    int next = -1;
+    bool stop = false;
+    while (kept < k) {
+      if (!accept_draft(&s, drafts, kept, &next))
+        break;
+      int token = drafts[kept++];
+      output_tokens[generated++] = token;
+      s.ctx[s.ctx_len++] = token;
+      if (is_finished(&s, token, generated)) {
+        stop = true;
+        break;
+      }
+    }
+    if (stats)
+      stats->accepted += kept;
+
+    /* Drop the rejected drafts; the draft model may lack the last one */
+    if (s.target_len > base + kept) {
+      target->ops->seq_truncate(target, s.target_seq, base + kept);
+      s.target_len = base + kept;
+    }
+    if (draft && s.draft_len > base + kept) {
+      draft->ops->seq_truncate(draft, s.draft_seq, base + kept);
+      s.draft_len = base + kept;
+    }
+    if (stop)
+      break;
+
+    if (kept == k) {
+      probs_from_logits(&s, s.logits + (size_t)k * V, s.probs);
+      next = sampling_sample_probs_f32(s.probs, s.vocab_size, &s.rng);
+    }
+    pending = next;
+  }
+
+  if (stats) {
+    stats->generated = (uint64_t)generated;
+    stats->decode_ms = now_ms() - start;
+  }
+
+  /* Leave the KV of the whole exchange to later prompts */
+  if (target->ops->seq_cache_prefix)
+    target->ops->seq_cache_prefix(target, s.target_seq, s.ctx, s.target_len);
+  if (draft && draft->ops->seq_cache_prefix)
+    draft->ops->seq_cache_prefix(draft, s.draft_seq, s.ctx, s.draft_len);
+
+  release(&s);
+  return generated;
+}
+
+double speculative_acceptance_rate(const speculative_stats_t *stats) {
+  if (!stats || stats->drafted == 0)
+    return 0.0;
+  return (double)stats->accepted / (double)stats->drafted;
+}
+
+double speculative_tokens_per_second(const speculative_stats_t *stats) {
+  if (!stats || stats->decode_ms <= 0.0)
+    return 0.0;
+  return (double)stats->generated * 1000.0 / stats->decode_ms;
+}
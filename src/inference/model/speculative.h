@@ -0,0 +1,93 @@
+/*
+ * Speculative Decoding
+ *
+ * A cheap drafter proposes the next few tokens and the target model checks
+ * all of them in one forward pass, so every step yields between one and
+ * num_draft + 1 tokens for a single pass over the target's weights.
+ *
+ * Drafts come from a smaller draft model that shares the target's tokenizer
+ * or, without one, from prompt lookup: the longest recent n-gram that also
+ * occurs earlier in the context proposes the tokens that followed it there.
+ * Chat output repeats names, phrases and formatting from the prompt often
+ * enough for that to pay off without any extra model.
+ *
+ * Drafted tokens go through the rejection sampling of "Fast Inference from
+ * Transformers via Speculative Decoding" (Leviathan et al., 2023): a token
+ * the drafter picked with probability q(x) is kept with probability
+ * min(1, p(x) / q(x)) under the target's sampling distribution p, and the
+ * first rejected position is resampled from max(0, p - q). The output thus
+ * follows the target's distribution exactly; with temperature 0 it is the
+ * target's greedy output. Rejected tokens are truncated from the KV caches.
+ */
+
+#ifndef INFERENCE_MODEL_SPECULATIVE_H
+#define INFERENCE_MODEL_SPECULATIVE_H
+
+#include "inference/model/base.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Upper bound on tokens drafted per step */
+#define SPECULATIVE_MAX_DRAFT 16
+
+typedef struct {
+  float temperature;
+  int top_k;
+  float top_p;
+  float min_p;
+  uint64_t seed;
+  int max_tokens;   /* Tokens to generate */
+  int eos_token_id; /* Stops generation when sampled (-1 = none) */
+  int num_draft;    /* Tokens drafted per step (0 = 4) */
+  int ngram_max;    /* Longest n-gram prompt lookup matches (0 = 3) */
+  int ngram_min;    /* Shortest n-gram it falls back to (0 = 1) */
+} speculative_params_t;
+
+typedef struct {
+  uint64_t steps;     /* Target forward passes after the prompt */
+  uint64_t drafted;   /* Tokens proposed by the drafter */
+  uint64_t accepted;  /* Proposed tokens the target kept */
+  uint64_t generated; /* Tokens returned */
+  double decode_ms;   /* Time from the first sampled token to the last */
+} speculative_stats_t;
+
+/*
+ * Generate from a prompt with speculative decoding.
+ *
+ * Parameters:
+ *   target:        model whose distribution the output follows; must
+ *                  implement the sequence ops including seq_forward_all and
+ *                  seq_truncate
+ *   draft:         draft model with the same vocabulary (needs the sequence
+ *                  ops and seq_truncate), or NULL for prompt lookup
+ *   output_tokens: [params->max_tokens] generated tokens
+ *   input_tokens:  [num_input_tokens] prompt
+ *   params:        sampling and drafting parameters
+ *   stats:         filled with acceptance and timing counters, may be NULL
+ *
+ * Both models reuse and extend their prefix caches, if they keep one.
+ *
+ * Returns: number of tokens generated (including a final EOS), or -1 if the
+ * models do not support the required ops or a forward pass failed before
+ * anything was generated
+ */
+int speculative_generate(inference_model_t *target, inference_model_t *draft,
+                         int *output_tokens, const int *input_tokens,
+                         int num_input_tokens,
+                         const speculative_params_t *params,
+                         speculative_stats_t *stats);
+
+/* Fraction of drafted tokens that were accepted */
+double speculative_acceptance_rate(const speculative_stats_t *stats);
+
+/* Generated tokens per second of decoding */
+double speculative_tokens_per_second(const speculative_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,124 @@
+/**
+ * @file mapped_file.c
+ * @brief Implementation of read-only file mappings.
+ */
+
+#include "inference/model_loader/mapped_file.h"
+#include <string.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+
+bool mapped_file_open(mapped_file_t *file, const char *path, bool populate) {
+  (void)populate;
+  if (!file || !path)
+    return false;
+  memset(file, 0, sizeof(*file));
+
+  HANDLE handle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (handle == INVALID_HANDLE_VALUE)
+    return false;
+
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(handle, &size) || size.QuadPart == 0) {
+    CloseHandle(handle);
+    return false;
+  }
+
+  HANDLE mapping = CreateFileMappingA(handle, NULL, PAGE_READONLY, 0, 0, NULL);
+  CloseHandle(handle);
+  if (!mapping)
+    return false;
+
+  void *addr = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!addr)
+    return false;
+
+  file->data = (const uint8_t *)addr;
+  file->size = (size_t)size.QuadPart;
+  return true;
+}
+
+void mapped_file_close(mapped_file_t *file) {
+  if (!file || !file->data)
+    return;
+  UnmapViewOfFile((void *)file->data);
+  memset(file, 0, sizeof(*file));
+}
+
+void mapped_file_prefetch(const mapped_file_t *file, size_t offset,
+                          size_t length) {
+  /* The first touch reads the pages in */
+  (void)file;
+  (void)offset;
+  (void)length;
+}
+
+#else
+
+bool mapped_file_open(mapped_file_t *file, const char *path, bool populate) {
+  if (!file || !path)
+    return false;
+  memset(file, 0, sizeof(*file));
+
+  int fd = open(path, O_RDONLY);
+  if (fd < 0)
+    return false;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+
+  int flags = MAP_SHARED;
+#ifdef MAP_POPULATE
+  if (populate)
+    flags |= MAP_POPULATE;
+#endif
+  void *addr = mmap(NULL, (size_t)st.st_size, PROT_READ, flags, fd, 0);
+  close(fd);
+  if (addr == MAP_FAILED)
+    return false;
+
+  /* Without MAP_POPULATE at least start readahead for the whole file */
+  if (populate)
+    posix_madvise(addr, (size_t)st.st_size, POSIX_MADV_WILLNEED);
+
+  file->data = (const uint8_t *)addr;
+  file->size = (size_t)st.st_size;
+  return true;
+}
+
+void mapped_file_close(mapped_file_t *file) {
+  if (!file || !file->data)
+    return;
+  munmap((void *)file->data, file->size);
+  memset(file, 0, sizeof(*file));
+}
+
+void mapped_file_prefetch(const mapped_file_t *file, size_t offset,
+                          size_t length) {
+  if (!file || !file->data || offset >= file->size || length == 0)
+    return;
+  if (length > file->size - offset)
+    length = file->size - offset;
+
+  /* madvise wants a page-aligned start; the mapping itself is aligned */
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = offset - offset % page;
+  posix_madvise((void *)(file->data + start), offset + length - start,
+                POSIX_MADV_WILLNEED);
+}
+
+#endif
@@ -0,0 +1,61 @@
+/**
+ * @file mapped_file.h
+ * @brief Read-only file mappings for model weights.
+ *
+ * Weight files are mapped shared and read-only so that tensors can point
+ * straight into the page cache: nothing is copied onto the heap, and several
+ * processes serving the same model share one physical copy.
+ */
+
+#ifndef INFERENCE_MODEL_LOADER_MAPPED_FILE_H
+#define INFERENCE_MODEL_LOADER_MAPPED_FILE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A read-only mapping of a whole file.
+ */
+typedef struct {
+  const uint8_t *data; /**< Start of the mapping (NULL if not mapped) */
+  size_t size;         /**< File size in bytes */
+} mapped_file_t;
+
+/**
+ * Map a file read-only.
+ *
+ * @param file Output mapping
+ * @param path File to map
+ * @param populate Fault the whole file in up front instead of on first touch
+ * @return true on success, false on failure (file is left zeroed)
+ */
+bool mapped_file_open(mapped_file_t *file, const char *path, bool populate);
+
+/**
+ * Unmap a file. Tensors pointing into the mapping become invalid.
+ * @param file Mapping to release (can be zeroed/unmapped)
+ */
+void mapped_file_close(mapped_file_t *file);
+
+/**
+ * Start reading a byte range of the mapping in the background, so that a
+ * later first touch does not stall on the disk. Advisory only: the range is
+ * widened to whole pages and clamped to the file, and failures are ignored.
+ *
+ * @param file Mapping (can be unmapped)
+ * @param offset First byte of the range
+ * @param length Bytes in the range
+ */
+void mapped_file_prefetch(const mapped_file_t *file, size_t offset,
+                          size_t length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFERENCE_MODEL_LOADER_MAPPED_FILE_H */
@@ -0,0 +1,342 @@
+/**
+ * @file weight_cache.c
+ * @brief Implementation of the prepacked weight cache.
+ *
+ * File layout (native endianness, it never leaves the machine):
+ *   header | entry table | padding | tensor data, each page-aligned
+ *
+ * Page alignment keeps every tensor on its own pages so that they can be
+ * advised or prefetched independently and SIMD loads never straddle into a
+ * neighbour.
+ */
+
+#include "inference/model_loader/weight_cache.h"
+#include "inference/model_loader/mapped_file.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#define WEIGHT_CACHE_MAGIC "STWCACHE"
+#define WEIGHT_CACHE_VERSION 1
+#define WEIGHT_CACHE_ALIGN 4096
+#define WEIGHT_CACHE_MAX_DIMS 4
+
+typedef struct {
+  char magic[8];
+  uint32_t version;
+  uint32_t num_entries;
+  weight_cache_key_t key;
+} cache_header_t;
+
+typedef struct {
+  char name[WEIGHT_CACHE_NAME_MAX];
+  uint32_t dtype;
+  uint32_t ndim;
+  int64_t shape[WEIGHT_CACHE_MAX_DIMS];
+  uint64_t offset; /* From the start of the file */
+  uint64_t nbytes;
+} cache_entry_t;
+
+struct weight_cache {
+  mapped_file_t file;
+  const cache_entry_t *entries;
+  uint32_t num_entries;
+};
+
+typedef struct {
+  char name[WEIGHT_CACHE_NAME_MAX];
+  const tensor_t *tensor;
+} pending_tensor_t;
+
+struct weight_cache_writer {
+  pending_tensor_t *items;
+  int count;
+  int capacity;
+};
+
+static uint64_t align_up(uint64_t value) {
+  return (value + WEIGHT_CACHE_ALIGN - 1) & ~(uint64_t)(WEIGHT_CACHE_ALIGN - 1);
+}
+
+/* ============================================================================
+ * Key
+ * ============================================================================
+ */
+
+/* Size and modification time (ns since epoch) of a file */
+static bool stat_source(const char *path, uint64_t *size, int64_t *mtime) {
+#ifdef _WIN32
+  struct _stat64 st;
+  if (_stat64(path, &st) != 0)
+    return false;
+  *mtime = (int64_t)st.st_mtime * 1000000000;
+#else
+  struct stat st;
+  if (stat(path, &st) != 0)
+    return false;
+#if defined(__APPLE__)
+  *mtime = (int64_t)st.st_mtimespec.tv_sec * 1000000000 +
+           st.st_mtimespec.tv_nsec;
+#else
+  *mtime = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+#endif
+  *size = (uint64_t)st.st_size;
+  return true;
+}
+
+bool weight_cache_key_init(weight_cache_key_t *key, const char *source_path,
+                           dtype_t dtype, uint32_t layout) {
+  if (!key || !source_path)
+    return false;
+  memset(key, 0, sizeof(*key));
+  if (!stat_source(source_path, &key->source_size, &key->source_mtime))
+    return false;
+  key->dtype = (uint32_t)dtype;
+  key->layout = layout;
+  return true;
+}
+
+bool weight_cache_key_add_source(weight_cache_key_t *key,
+                                 const char *source_path) {
+  uint64_t size;
+  int64_t mtime;
+  if (!key || !source_path || !stat_source(source_path, &size, &mtime))
+    return false;
+
+  /* FNV-1a style mix, so a change to any one file changes the key */
+  uint64_t h = (uint64_t)key->source_mtime;
+  h = (h ^ size) * 0x100000001b3ull;
+  h = (h ^ (uint64_t)mtime) * 0x100000001b3ull;
+  key->source_mtime = (int64_t)h;
+  key->source_size += size;
+  return true;
+}
+
+/* ============================================================================
+ * Reader
+ * ============================================================================
+ */
+
+static bool entry_is_valid(const cache_entry_t *e, size_t file_size) {
+  if (memchr(e->name, '\0', sizeof(e->name)) == NULL)
+    return false;
+  if (e->dtype >= DTYPE_COUNT || e->ndim == 0 ||
+      e->ndim > WEIGHT_CACHE_MAX_DIMS)
+    return false;
+
+  uint64_t numel = 1;
+  for (uint32_t d = 0; d < e->ndim; d++) {
+    if (e->shape[d] <= 0)
+      return false;
+    numel *= (uint64_t)e->shape[d];
+  }
+
+  return e->nbytes == dtype_nbytes((dtype_t)e->dtype, numel) &&
+         e->offset % WEIGHT_CACHE_ALIGN == 0 && e->offset <= file_size &&
+         e->nbytes <= file_size - e->offset;
+}
+
+weight_cache_t *weight_cache_open(const char *path,
+                                  const weight_cache_key_t *key) {
+  if (!path || !key)
+    return NULL;
+
+  mapped_file_t file;
+  if (!mapped_file_open(&file, path, false))
+    return NULL;
+
+  const cache_header_t *header = (const cache_header_t *)file.data;
+  if (file.size < sizeof(*header) ||
+      memcmp(header->magic, WEIGHT_CACHE_MAGIC, 8) != 0 ||
+      header->version != WEIGHT_CACHE_VERSION ||
+      memcmp(&header->key, key, sizeof(*key)) != 0 ||
+      (file.size - sizeof(*header)) / sizeof(cache_entry_t) <
+          header->num_entries) {
+    mapped_file_close(&file);
+    return NULL;
+  }
+
+  const cache_entry_t *entries =
+      (const cache_entry_t *)(file.data + sizeof(*header));
+  for (uint32_t i = 0; i < header->num_entries; i++) {
+    if (!entry_is_valid(&entries[i], file.size)) {
+      mapped_file_close(&file);
+      return NULL;
+    }
+  }
+
+  weight_cache_t *cache = (weight_cache_t *)calloc(1, sizeof(weight_cache_t));
+  if (!cache) {
+    mapped_file_close(&file);
+    return NULL;
+  }
+  cache->file = file;
+  cache->entries = entries;
+  cache->num_entries = header->num_entries;
+  return cache;
+}
+
+tensor_t *weight_cache_get(const weight_cache_t *cache, const char *name) {
+  if (!cache || !name)
+    return NULL;
+
+  for (uint32_t i = 0; i < cache->num_entries; i++) {
+    const cache_entry_t *e = &cache->entries[i];
+    if (strcmp(e->name, name) != 0)
+      continue;
+
+    int64_t shape[WEIGHT_CACHE_MAX_DIMS];
+    for (uint32_t d = 0; d < e->ndim; d++)
+      shape[d] = e->shape[d];
+    return tensor_wrap((void *)(cache->file.data + e->offset),
+                       (dtype_t)e->dtype, (int)e->ndim, shape);
+  }
+  return NULL;
+}
+
+void weight_cache_close(weight_cache_t *cache) {
+  if (!cache)
+    return;
+  mapped_file_close(&cache->file);
+  free(cache);
+}
+
+/* ============================================================================
+ * Writer
+ * ============================================================================
+ */
+
+weight_cache_writer_t *weight_cache_writer_create(void) {
+  return (weight_cache_writer_t *)calloc(1, sizeof(weight_cache_writer_t));
+}
+
+bool weight_cache_writer_add(weight_cache_writer_t *writer, const char *name,
+                             const tensor_t *tensor) {
+  if (!writer || !name || !tensor || !tensor->data)
+    return false;
+  if (strlen(name) >= WEIGHT_CACHE_NAME_MAX || tensor->ndim <= 0 ||
+      tensor->ndim > WEIGHT_CACHE_MAX_DIMS)
+    return false;
+
+  if (writer->count == writer->capacity) {
+    int capacity = writer->capacity ? writer->capacity * 2 : 64;
+    pending_tensor_t *items = (pending_tensor_t *)realloc(
+        writer->items, (size_t)capacity * sizeof(pending_tensor_t));
+    if (!items)
+      return false;
+    writer->items = items;
+    writer->capacity = capacity;
+  }
+
+  pending_tensor_t *item = &writer->items[writer->count++];
+  memset(item->name, 0, sizeof(item->name));
+  strcpy(item->name, name);
+  item->tensor = tensor;
+  return true;
+}
+
+int weight_cache_writer_count(const weight_cache_writer_t *writer) {
+  return writer ? writer->count : 0;
+}
+
+static bool write_padding(FILE *fp, uint64_t from, uint64_t to) {
+  static const uint8_t zeros[WEIGHT_CACHE_ALIGN];
+  while (from < to) {
+    size_t n = (size_t)(to - from);
+    if (n > sizeof(zeros))
+      n = sizeof(zeros);
+    if (fwrite(zeros, 1, n, fp) != n)
+      return false;
+    from += n;
+  }
+  return true;
+}
+
+static bool write_cache_file(FILE *fp, const weight_cache_writer_t *writer,
+                             const weight_cache_key_t *key) {
+  cache_header_t header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, WEIGHT_CACHE_MAGIC, 8);
+  header.version = WEIGHT_CACHE_VERSION;
+  header.num_entries = (uint32_t)writer->count;
+  header.key = *key;
+  if (fwrite(&header, sizeof(header), 1, fp) != 1)
+    return false;
+
+  uint64_t table_end =
+      sizeof(header) + (uint64_t)writer->count * sizeof(cache_entry_t);
+  uint64_t offset = align_up(table_end);
+  for (int i = 0; i < writer->count; i++) {
+    const tensor_t *t = writer->items[i].tensor;
+    cache_entry_t entry;
+    memset(&entry, 0, sizeof(entry));
+    memcpy(entry.name, writer->items[i].name, sizeof(entry.name));
+    entry.dtype = (uint32_t)t->dtype;
+    entry.ndim = (uint32_t)t->ndim;
+    for (int d = 0; d < t->ndim; d++)
+      entry.shape[d] = t->shape[d];
+    entry.offset = offset;
+    entry.nbytes = t->nbytes;
+    if (fwrite(&entry, sizeof(entry), 1, fp) != 1)
+      return false;
+    offset = align_up(offset + t->nbytes);
+  }
+
+  uint64_t pos = table_end;
+  for (int i = 0; i < writer->count; i++) {
+    const tensor_t *t = writer->items[i].tensor;
+    if (!write_padding(fp, pos, align_up(pos)))
+      return false;
+    pos = align_up(pos);
+    if (fwrite(t->data, 1, t->nbytes, fp) != t->nbytes)
+      return false;
+    pos += t->nbytes;
+  }
+  return true;
+}
+
+bool weight_cache_writer_commit(weight_cache_writer_t *writer,
+                                const char *path,
+                                const weight_cache_key_t *key) {
+  if (!writer || !path || !key || writer->count == 0)
+    return false;
+
+  char tmp_path[1024];
+  int n = snprintf(tmp_path, sizeof(tmp_path), "%s.tmp.%d", path,
+                   (int)getpid());
+  if (n < 0 || (size_t)n >= sizeof(tmp_path))
+    return false;
+
+  FILE *fp = fopen(tmp_path, "wb");
+  if (!fp)
+    return false;
+
+  bool ok = write_cache_file(fp, writer, key);
+  ok = (fclose(fp) == 0) && ok;
+
+#ifdef _WIN32
+  if (ok)
+    remove(path);
+#endif
+  if (!ok || rename(tmp_path, path) != 0) {
+    remove(tmp_path);
+    return false;
+  }
+  return true;
+}
+
+void weight_cache_writer_free(weight_cache_writer_t *writer) {
+  if (!writer)
+    return;
+  free(writer->items);
+  free(writer);
+}
@@ -0,0 +1,147 @@
+/**
+ * @file weight_cache.h
+ * @brief On-disk cache of weights prepacked into the layout the kernels use.
+ *
+ * Some weights cannot be used straight from the safetensors mapping: they
+ * need a dtype conversion or the transposed layout the GEMM expects. The
+ * first load produces them on the heap and writes them to a cache file next
+ * to the model; later loads map that file and wrap its tensors without any
+ * copying.
+ *
+ * A cache is only used if its key matches: the source files' sizes and
+ * modification times, the inference dtype and the layout version of the
+ * loader. Anything else (stale, truncated or foreign files) is ignored and
+ * rebuilt.
+ */
+
+#ifndef INFERENCE_MODEL_LOADER_WEIGHT_CACHE_H
+#define INFERENCE_MODEL_LOADER_WEIGHT_CACHE_H
+
+#include "inference/core/dtype.h"
+#include "inference/core/tensor.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Longest tensor name stored in a cache, including the terminator */
+#define WEIGHT_CACHE_NAME_MAX 112
+
+/**
+ * Identifies the source weights a cache was built from.
+ */
+typedef struct {
+  uint64_t source_size;  /**< Total size of the source files in bytes */
+  int64_t source_mtime;  /**< Source modification time (ns since epoch);
+                              a hash of the files' sizes and times once
+                              weight_cache_key_add_source() folded more in */
+  uint32_t dtype;        /**< Inference dtype the tensors were built for */
+  uint32_t layout;       /**< Loader-defined layout version */
+} weight_cache_key_t;
+
+typedef struct weight_cache weight_cache_t;
+typedef struct weight_cache_writer weight_cache_writer_t;
+
+/**
+ * Build the key for a source file.
+ *
+ * @param key Output key
+ * @param source_path Weights file the cache is derived from
+ * @param dtype Inference dtype
+ * @param layout Layout version; bump it whenever the packed layout changes
+ * @return true on success, false if the source cannot be stat'ed
+ */
+bool weight_cache_key_init(weight_cache_key_t *key, const char *source_path,
+                           dtype_t dtype, uint32_t layout);
+
+/**
+ * Fold another source file into a key, for weights spread over several
+ * files (a sharded checkpoint keys on its index and every shard). Replacing
+ * any of them then invalidates the cache.
+ *
+ * @param key Key from weight_cache_key_init()
+ * @param source_path Additional weights file
+ * @return true on success, false if the file cannot be stat'ed
+ */
+bool weight_cache_key_add_source(weight_cache_key_t *key,
+                                 const char *source_path);
+
+/**
+ * Map a cache file if it exists and matches the key.
+ *
+ * @param path Cache file path
+ * @param key Expected key
+ * @return Cache, or NULL if missing, stale or malformed
+ */
+weight_cache_t *weight_cache_open(const char *path,
+                                  const weight_cache_key_t *key);
+
+/**
+ * Look up a tensor. The returned tensor does not own its data, which stays
+ * valid until weight_cache_close().
+ *
+ * @param cache Cache instance (can be NULL)
+ * @param name Tensor name
+ * @return New tensor wrapping the mapping, or NULL if not present
+ */
+tensor_t *weight_cache_get(const weight_cache_t *cache, const char *name);
+
+/**
+ * Unmap a cache.
+ * @param cache Cache to close (can be NULL)
+ */
+void weight_cache_close(weight_cache_t *cache);
+
+/**
+ * Start collecting tensors for a new cache file.
+ * @return New writer, or NULL on allocation failure
+ */
+weight_cache_writer_t *weight_cache_writer_create(void);
+
+/**
+ * Queue a tensor for writing. Only the pointer is kept, so the tensor must
+ * stay alive until weight_cache_writer_commit().
+ *
+ * @param writer Writer instance
+ * @param name Tensor name (shorter than WEIGHT_CACHE_NAME_MAX)
+ * @param tensor Contiguous tensor with at most 4 dimensions
+ * @return true on success
+ */
+bool weight_cache_writer_add(weight_cache_writer_t *writer, const char *name,
+                             const tensor_t *tensor);
+
+/**
+ * Get the number of queued tensors.
+ * @param writer Writer instance (can be NULL)
+ * @return Tensor count
+ */
+int weight_cache_writer_count(const weight_cache_writer_t *writer);
+
+/**
+ * Write the queued tensors to path. The file is written under a temporary
+ * name and renamed into place, so concurrent loaders never see a partial
+ * cache.
+ *
+ * @param writer Writer instance
+ * @param path Cache file path
+ * @param key Key to store
+ * @return true on success
+ */
+bool weight_cache_writer_commit(weight_cache_writer_t *writer,
+                                const char *path,
+                                const weight_cache_key_t *key);
+
+/**
+ * Free a writer (does not touch the queued tensors).
+ * @param writer Writer to free (can be NULL)
+ */
+void weight_cache_writer_free(weight_cache_writer_t *writer);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* INFERENCE_MODEL_LOADER_WEIGHT_CACHE_H */
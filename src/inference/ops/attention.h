@@ -0,0 +1,8 @@
+#ifndef INFERENCE_OPS_ATTENTION_H
+#define INFERENCE_OPS_ATTENTION_H
+
+#include "inference/kernels/attention/attention.h"
+#include "inference/kernels/attention/flash_decode.h"
+#include "inference/kernels/attention/flash_prefill.h"
+
+#endif /* INFERENCE_OPS_ATTENTION_H */
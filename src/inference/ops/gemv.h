@@ -0,0 +1,6 @@
+#ifndef INFERENCE_OPS_GEMV_H
+#define INFERENCE_OPS_GEMV_H
+
+#include "inference/kernels/gemv/gemv.h"
+
+#endif /* INFERENCE_OPS_GEMV_H */
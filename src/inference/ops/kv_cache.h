@@ -2,5 +2,6 @@
 #define INFERENCE_OPS_KV_CACHE_H
 
 #include "inference/kernels/kv_cache/kv_cache.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
 
 #endif /* INFERENCE_OPS_KV_CACHE_H */
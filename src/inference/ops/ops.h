@@ -2,10 +2,13 @@
 #define INFERENCE_OPS_OPS_H
 
 #include "inference/ops/activation.h"
+#include "inference/ops/attention.h"
 #include "inference/ops/embedding.h"
 #include "inference/ops/gemm.h"
+#include "inference/ops/gemv.h"
 #include "inference/ops/kv_cache.h"
 #include "inference/ops/norm.h"
+#include "inference/ops/quant.h"
 #include "inference/ops/rope.h"
 #include "inference/ops/sampling.h"
 
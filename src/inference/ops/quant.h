@@ -0,0 +1,6 @@
+#ifndef INFERENCE_OPS_QUANT_H
+#define INFERENCE_OPS_QUANT_H
+
+#include "inference/kernels/quant/quant.h"
+
+#endif /* INFERENCE_OPS_QUANT_H */
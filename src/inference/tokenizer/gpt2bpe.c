@@ -270,8 +270,10 @@ static char *read_file(const char *path, size_t *out_len) {
   return buf;
 }
 
+/* Read a {"token": id, ...} map into tok->tokens, growing vocab_size */
 static bool parse_vocab_json(GPT2BPETokenizer *tok, const char *json) {
-  tok->tokens = calloc(GPT2_MAX_VOCAB_SIZE, sizeof(GPT2Token));
+  if (!tok->tokens)
+    tok->tokens = calloc(GPT2_MAX_VOCAB_SIZE, sizeof(GPT2Token));
   if (!tok->tokens)
     return false;
 
@@ -282,7 +284,7 @@ static bool parse_vocab_json(GPT2BPETokenizer *tok, const char *json) {
     return false;
   p++;
 
-  size_t max_id = 0;
+  size_t max_id = tok->vocab_size;
 
   while (*p) {
     while (*p &&
@@ -368,6 +370,7 @@ static bool parse_vocab_json(GPT2BPETokenizer *tok, const char *json) {
     if (id < 0 || id >= GPT2_MAX_VOCAB_SIZE)
       continue;
 
+    free(tok->tokens[id].token);
     tok->tokens[id].token = malloc(token_len + 1);
     if (tok->tokens[id].token) {
       memcpy(tok->tokens[id].token, token_buf, token_len);
@@ -445,6 +448,29 @@ static bool parse_merges_txt(GPT2BPETokenizer *tok, const char *txt) {
   return true;
 }
 
+/*
+ * Special tokens (e.g. ChatML's <|im_start|>) are not in vocab.json; like
+ * Hugging Face tokenizers, read them from an optional added_tokens.json
+ * next to it
+ */
+static bool load_added_tokens(GPT2BPETokenizer *tok, const char *vocab_path) {
+  const char *slash = strrchr(vocab_path, '/');
+  size_t dir_len = slash ? (size_t)(slash - vocab_path) + 1 : 0;
+  size_t len = dir_len + sizeof("added_tokens.json");
+  char *path = malloc(len);
+  if (!path)
+    return false;
+  memcpy(path, vocab_path, dir_len);
+  memcpy(path + dir_len, "added_tokens.json", sizeof("added_tokens.json"));
+  char *json = read_file(path, NULL);
+  free(path);
+  if (!json)
+    return true;
+  bool ok = parse_vocab_json(tok, json);
+  free(json);
+  return ok;
+}
+
 bool gpt2_load(GPT2BPETokenizer *tok, const char *vocab_path,
                const char *merges_path) {
   size_t vocab_len, merges_len;
@@ -457,7 +483,8 @@ bool gpt2_load(GPT2BPETokenizer *tok, const char *vocab_path,
     return false;
   }
 
-  if (!parse_vocab_json(tok, vocab_json)) {
+  if (!parse_vocab_json(tok, vocab_json) ||
+      !load_added_tokens(tok, vocab_path)) {
     free(vocab_json);
     free(merges_txt);
     return false;
@@ -198,6 +198,35 @@ int chat_tokenizer_encode(ChatTokenizer *ct, const char *text,
   return count;
 }
 
+char *chat_tokenizer_decode(ChatTokenizer *ct, const uint32_t *ids,
+                            size_t count) {
+  if (!ct || !ids)
+    return NULL;
+  if (!ct->loaded || ct->selection == TOKENIZER_API)
+    return NULL;
+  const TokenizerDef *def = &TOKENIZER_DEFS[ct->selection];
+  if (def->type == TYPE_TIKTOKEN)
+    return tokenizer_decode((Tokenizer *)ct->instance, ids, count);
+  if (def->type == TYPE_GPT2BPE)
+    return gpt2_decode((GPT2BPETokenizer *)ct->instance, ids, count);
+  return NULL;
+}
+
+int chat_tokenizer_token_id(ChatTokenizer *ct, const char *token) {
+  if (!ct || !token)
+    return -1;
+  if (!ct->loaded || ct->selection == TOKENIZER_API)
+    return -1;
+  const TokenizerDef *def = &TOKENIZER_DEFS[ct->selection];
+  if (def->type != TYPE_GPT2BPE)
+    return -1;
+  /* Unknown tokens map to the unk id, so check the entry itself */
+  const GPT2BPETokenizer *tok = ct->instance;
+  int id = gpt2_token_to_id(tok, token);
+  const char *entry = gpt2_id_to_token(tok, id);
+  return entry && strcmp(entry, token) == 0 ? id : -1;
+}
+
 const char *tokenizer_selection_name(TokenizerSelection sel) {
   if (sel >= TOKENIZER_COUNT)
     return "unknown";
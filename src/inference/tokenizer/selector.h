@@ -39,6 +39,10 @@ int chat_tokenizer_count(ChatTokenizer *ct, const char *text);
 bool chat_tokenizer_is_api(ChatTokenizer *ct);
 int chat_tokenizer_encode(ChatTokenizer *ct, const char *text,
                           TokenResult *out);
+char *chat_tokenizer_decode(ChatTokenizer *ct, const uint32_t *ids,
+                            size_t count);
+/* Id of a whole vocabulary entry such as a special token, or -1 */
+int chat_tokenizer_token_id(ChatTokenizer *ct, const char *token);
 
 const char *tokenizer_selection_name(TokenizerSelection sel);
 const char *tokenizer_selection_description(TokenizerSelection sel);
@@ -381,7 +381,8 @@ void simd_init(void) {
 #if SIMD_ARM64
   g_simd_available = true;
 #elif SIMD_X86_64
-  g_simd_available = true;
+  /* The x86-64 routines use ymm registers; the build no longer assumes AVX2 */
+  g_simd_available = __builtin_cpu_supports("avx2");
 #else
   g_simd_available = false;
 #endif
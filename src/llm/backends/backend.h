@@ -78,6 +78,12 @@ typedef struct LLMBackend {
   void (*parse_stream)(StreamCtx *ctx, const char *line);
 
   void (*add_headers)(void *curl, const ModelConfig *config);
+
+  /* Set by backends that run the chat themselves instead of over HTTP */
+  LLMResponse (*chat)(const ModelConfig *config, const ChatHistory *history,
+                      const LLMContext *context, LLMStreamCallback stream_cb,
+                      LLMReasoningCallback reasoning_cb,
+                      LLMProgressCallback progress_cb, void *userdata);
 } LLMBackend;
 
 const LLMBackend *backend_get(ApiType type);
@@ -85,6 +91,12 @@ const LLMBackend *backend_get(ApiType type);
 extern const LLMBackend backend_openai;
 extern const LLMBackend backend_anthropic;
 extern const LLMBackend backend_kobold;
+extern const LLMBackend backend_local;
+
+/* Start loading a local model directory in the background */
+void backend_local_preload(const char *model_dir);
+/* Free the local backend's resident model */
+void backend_local_shutdown(void);
 
 static const char *ANTHROPIC_MODELS[] = {
     "claude-sonnet-4-5",
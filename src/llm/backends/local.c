@@ -0,0 +1,468 @@
+/*
+ * Local Backend
+ *
+ * Runs the chat on the in-process inference engine instead of an HTTP
+ * server. ModelConfig.base_url names the model directory (config.json plus
+ * safetensors). The model, the KV cache of the last conversation and the
+ * tokens behind it stay resident between turns, so a turn only prefills
+ * what changed since the previous prompt and reply.
+ *
+ * The prompt uses the ChatML template of the Qwen models the engine runs
+ * and is tokenized with the chat's ChatTokenizer, or the bundled Qwen3
+ * tokenizer when none is loaded. The template's special tokens are inserted
+ * by the ids that tokenizer gives them (its added_tokens.json); a tokenizer
+ * without them cannot drive the model. Tokens are generated on a
+ * background thread; the calling thread receives the decoded text and runs
+ * the stream, reasoning and progress callbacks, as it does for curl.
+ *
+ * The model loads in the background (see backend_local_preload()), so the
+ * UI is up while the weights are read; a chat that arrives first waits for
+ * the load, running the progress callback meanwhile.
+ *
+ * Once a chat outgrows the context window the prompt builder drops the
+ * oldest messages, which would leave only the system prompt reusable.
+ * Instead the dropped tokens are shifted out of the resident KV (see
+ * inference_seq_shift()), keeping the shared prefix as the attention sink,
+ * so the turn still only prefills what is new. SILLYTUI_CONTEXT_SHIFT=off
+ * re-prefills instead, for exact rather than approximate KV.
+ *
+ * The prompt, detokenizing and KV bookkeeping live in local_engine.c; this
+ * file runs them on the generation thread.
+ */
+
+#include "backend.h"
+#include "core/config.h"
+#include "core/log.h"
+#include "inference/core/large_alloc.h"
+#include "inference/kernels/sampling/sampling_chain.h"
+#include "inference/model/base.h"
+#include "inference/model/registry.h"
+#include "llm/common.h"
+#include "local_engine.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <time.h>
+
+/* Interval of progress callbacks while the prompt is prefilled, in ms */
+#define LOCAL_PROGRESS_MS 100
+
+typedef struct {
+  LocalEngine *engine;
+  const TokenBuf *prompt;
+  int max_tokens;
+  sampling_chain_params_t params;
+  uint64_t seed;
+
+  pthread_mutex_t lock;
+  pthread_cond_t cond;
+  StringBuilder content;   /* Decoded text not yet handed to the caller */
+  StringBuilder reasoning; /* Same, inside <think> */
+  bool done;
+  bool ok;
+  char error[256];
+  char finish_reason[32];
+  int completion_tokens;
+  bool has_first_token;
+  struct timeval first_token_time;
+  struct timeval last_token_time;
+  struct timeval reasoning_start_time;
+  struct timeval reasoning_end_time;
+
+  /* Generation thread only until done */
+  LocalStream stream;
+} LocalJob;
+
+static pthread_mutex_t g_local_lock = PTHREAD_MUTEX_INITIALIZER;
+static LocalEngine g_local;
+
+static double ms_between(const struct timeval *from,
+                         const struct timeval *to) {
+  return (to->tv_sec - from->tv_sec) * 1000.0 +
+         (to->tv_usec - from->tv_usec) / 1000.0;
+}
+
+/* "<what> <path>", keeping the end of a path too long for error */
+static void path_error(char *error, size_t error_size, const char *what,
+                       const char *path) {
+  int n = snprintf(error, error_size, "%s %s", what, path);
+  size_t what_len = strlen(what);
+  if (n < 0 || (size_t)n < error_size || error_size <= what_len + 5)
+    return;
+  size_t keep = error_size - what_len - 5;
+  snprintf(error, error_size, "%s ...%s", what, path + strlen(path) - keep);
+}
+
+static void engine_unload(LocalEngine *e) {
+  if (e->seq)
+    inference_seq_free(&e->model, e->seq);
+  if (e->loaded)
+    inference_model_free(&e->model);
+  chat_tokenizer_free(&e->tokenizer);
+  free(e->fed);
+  memset(e, 0, sizeof(*e));
+}
+
+/* Start loading model_dir in the background unless it already is */
+static bool engine_start(LocalEngine *e, const char *model_dir, char *error,
+                         size_t error_size) {
+  if (e->loaded && strcmp(e->model_dir, model_dir) == 0)
+    return true;
+  engine_unload(e);
+  chat_tokenizer_init(&e->tokenizer);
+
+  const char *arch = model_detect_arch(model_dir);
+  if (!arch) {
+    path_error(error, error_size, "No model config in", model_dir);
+    return false;
+  }
+  if (!inference_model_load_async(&e->model, arch, model_dir,
+                                  INFERENCE_DTYPE_F16)) {
+    path_error(error, error_size, "Failed to start loading", model_dir);
+    return false;
+  }
+  e->loaded = true;
+  snprintf(e->model_dir, sizeof(e->model_dir), "%s", model_dir);
+  return true;
+}
+
+/* Log how the weights, KV pages and workspaces ended up backed */
+static void log_page_backing(void) {
+  large_alloc_stats_t stats;
+  large_alloc_stats(&stats);
+  log_message(LOG_INFO, __FILE__, __LINE__,
+              "Model memory: %zu MB hugetlb, %zu MB THP, %zu MB small pages",
+              stats.bytes[LARGE_PAGES_HUGETLB] >> 20,
+              stats.bytes[LARGE_PAGES_THP] >> 20,
+              stats.bytes[LARGE_PAGES_NONE] >> 20);
+}
+
+static bool engine_load(LocalEngine *e, const char *model_dir,
+                        LLMProgressCallback progress_cb, void *userdata,
+                        char *error, size_t error_size) {
+  if (!engine_start(e, model_dir, error, error_size))
+    return false;
+  if (e->seq)
+    return true;
+
+  inference_load_progress_t progress;
+  for (;;) {
+    inference_model_load_progress(&e->model, &progress);
+    if (progress.done)
+      break;
+    if (progress_cb)
+      progress_cb(userdata);
+    struct timespec interval = {0, LOCAL_PROGRESS_MS * 1000000L};
+    nanosleep(&interval, NULL);
+  }
+  if (!inference_model_wait(&e->model)) {
+    path_error(error, error_size, "Failed to load model from", model_dir);
+    engine_unload(e);
+    return false;
+  }
+  e->seq = inference_seq_create(&e->model);
+  if (!e->seq) {
+    snprintf(error, error_size, "Failed to create a sequence");
+    engine_unload(e);
+    return false;
+  }
+  log_page_backing();
+  return true;
+}
+
+static void *job_run(void *arg) {
+  LocalJob *job = arg;
+  LocalEngine *e = job->engine;
+  const TokenBuf *prompt = job->prompt;
+  int vocab_size = e->model.vocab_size;
+
+  float *logits = malloc((size_t)vocab_size * sizeof(float));
+  sampling_chain_t *chain = sampling_chain_create(
+      &job->params, vocab_size, prompt->count + job->max_tokens);
+  bool ok = logits && chain;
+  if (!ok)
+    snprintf(job->error, sizeof(job->error), "Out of memory");
+
+  int skip = ok ? local_engine_reuse(e, prompt) : -1;
+  if (ok && (skip < 0 || !local_engine_feed(e, prompt->ids + skip,
+                                            prompt->count - skip, logits))) {
+    snprintf(job->error, sizeof(job->error), "Prompt prefill failed");
+    ok = false;
+  }
+  if (ok)
+    sampling_chain_accept(chain, prompt->ids, prompt->count);
+
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, job->seed);
+  const char *finish = "length";
+  for (int i = 0; ok && i < job->max_tokens; i++) {
+    int token = sampling_chain_sample(chain, logits, &rng);
+    char *text;
+    LocalStreamEvent event = local_stream_token(&job->stream, token, &text);
+
+    pthread_mutex_lock(&job->lock);
+    gettimeofday(&job->last_token_time, NULL);
+    if (!job->has_first_token) {
+      job->first_token_time = job->last_token_time;
+      job->has_first_token = true;
+    }
+    if (event == LOCAL_STREAM_THINK)
+      job->reasoning_start_time = job->last_token_time;
+    else if (event == LOCAL_STREAM_THINK_END)
+      job->reasoning_end_time = job->last_token_time;
+    if (event != LOCAL_STREAM_STOP)
+      job->completion_tokens++;
+    if (text) {
+      sb_append(job->stream.in_reasoning ? &job->reasoning : &job->content,
+                text);
+      pthread_cond_signal(&job->cond);
+    }
+    pthread_mutex_unlock(&job->lock);
+    free(text);
+
+    if (event == LOCAL_STREAM_STOP) {
+      finish = "stop";
+      break;
+    }
+    if (i + 1 == job->max_tokens || !sampling_chain_accept(chain, &token, 1))
+      break;
+    if (!local_engine_feed(e, &token, 1, logits)) {
+      snprintf(job->error, sizeof(job->error), "Decode step failed");
+      ok = job->completion_tokens > 0;
+      break;
+    }
+  }
+
+  local_engine_cache_prefix(e);
+  sampling_chain_free(chain);
+  free(logits);
+
+  char *rest = local_stream_flush(&job->stream);
+  pthread_mutex_lock(&job->lock);
+  if (job->stream.in_reasoning) {
+    job->stream.in_reasoning = false;
+    job->reasoning_end_time = job->last_token_time;
+  }
+  if (rest)
+    sb_append(&job->content, rest);
+  free(rest);
+  snprintf(job->finish_reason, sizeof(job->finish_reason), "%s", finish);
+  job->ok = ok;
+  job->done = true;
+  pthread_cond_signal(&job->cond);
+  pthread_mutex_unlock(&job->lock);
+  return NULL;
+}
+
+static ChatTokenizer *pick_tokenizer(LocalEngine *e,
+                                     const LLMContext *context) {
+  ChatTokenizer *ct = context ? context->tokenizer : NULL;
+  if (ct && ct->loaded && !chat_tokenizer_is_api(ct))
+    return ct;
+  if (!e->tokenizer.loaded && !chat_tokenizer_set(&e->tokenizer,
+                                                  TOKENIZER_QWEN3))
+    return NULL;
+  return &e->tokenizer;
+}
+
+static void add_ms(struct timespec *ts, int ms) {
+  ts->tv_nsec += (long)ms * 1000000L;
+  ts->tv_sec += ts->tv_nsec / 1000000000L;
+  ts->tv_nsec %= 1000000000L;
+}
+
+static LLMResponse local_chat(const ModelConfig *config,
+                              const ChatHistory *history,
+                              const LLMContext *context,
+                              LLMStreamCallback stream_cb,
+                              LLMReasoningCallback reasoning_cb,
+                              LLMProgressCallback progress_cb,
+                              void *userdata) {
+  LLMResponse resp = {0};
+  struct timeval start_time, end_time;
+  gettimeofday(&start_time, NULL);
+
+  pthread_mutex_lock(&g_local_lock);
+  LocalEngine *e = &g_local;
+  if (!engine_load(e, config->base_url, progress_cb, userdata, resp.error,
+                   sizeof(resp.error))) {
+    pthread_mutex_unlock(&g_local_lock);
+    return resp;
+  }
+  ChatTokenizer *tokenizer = pick_tokenizer(e, context);
+  if (!tokenizer) {
+    snprintf(resp.error, sizeof(resp.error), "Failed to load tokenizer");
+    pthread_mutex_unlock(&g_local_lock);
+    return resp;
+  }
+  LocalTokens tokens;
+  if (!local_tokens_resolve(&tokens, tokenizer, resp.error,
+                            sizeof(resp.error))) {
+    pthread_mutex_unlock(&g_local_lock);
+    return resp;
+  }
+
+  const SamplerSettings *s = context ? context->samplers : NULL;
+  int max_tokens = (s && s->max_tokens > 0) ? s->max_tokens : 512;
+  int context_length = config->context_length > 0 ? config->context_length
+                                                  : DEFAULT_CONTEXT_LENGTH;
+  if (context_length > e->model.max_seq_len)
+    context_length = e->model.max_seq_len;
+  if (max_tokens > context_length / 2)
+    max_tokens = context_length / 2;
+
+  TokenBuf prompt = {0};
+  if (!local_build_prompt(history, context, tokenizer, &tokens,
+                          context_length - max_tokens, &prompt) ||
+      prompt.count + max_tokens > context_length) {
+    snprintf(resp.error, sizeof(resp.error), "Prompt does not fit in %d tokens",
+             context_length);
+    free(prompt.ids);
+    pthread_mutex_unlock(&g_local_lock);
+    return resp;
+  }
+
+  int needed = prompt.count + max_tokens;
+  if (needed > e->fed_cap) {
+    int *fed = realloc(e->fed, needed * sizeof(int));
+    if (!fed) {
+      snprintf(resp.error, sizeof(resp.error), "Out of memory");
+      free(prompt.ids);
+      pthread_mutex_unlock(&g_local_lock);
+      return resp;
+    }
+    e->fed = fed;
+    e->fed_cap = needed;
+  }
+
+  LocalJob job;
+  memset(&job, 0, sizeof(job));
+  job.engine = e;
+  job.prompt = &prompt;
+  job.max_tokens = max_tokens;
+  if (s) {
+    sampler_chain_params(s, &job.params);
+  } else {
+    sampling_chain_params_init(&job.params);
+  }
+  job.params.eos_token_id = tokens.im_end;
+  job.stream.tokenizer = tokenizer;
+  job.stream.tokens = &tokens;
+  job.seed = ((uint64_t)start_time.tv_sec << 20) ^ (uint64_t)start_time.tv_usec;
+  pthread_mutex_init(&job.lock, NULL);
+  pthread_cond_init(&job.cond, NULL);
+
+  pthread_t thread;
+  if (pthread_create(&thread, NULL, job_run, &job) != 0) {
+    snprintf(resp.error, sizeof(resp.error), "Failed to start generation");
+    pthread_cond_destroy(&job.cond);
+    pthread_mutex_destroy(&job.lock);
+    free(prompt.ids);
+    pthread_mutex_unlock(&g_local_lock);
+    return resp;
+  }
+
+  /* Hand the generated text to the callbacks on this thread */
+  bool got_content = false;
+  pthread_mutex_lock(&job.lock);
+  for (;;) {
+    while (!job.done && job.content.len == 0 && job.reasoning.len == 0) {
+      struct timespec deadline;
+      clock_gettime(CLOCK_REALTIME, &deadline);
+      add_ms(&deadline, LOCAL_PROGRESS_MS);
+      if (pthread_cond_timedwait(&job.cond, &job.lock, &deadline) ==
+              ETIMEDOUT &&
+          !got_content && progress_cb) {
+        pthread_mutex_unlock(&job.lock);
+        progress_cb(userdata);
+        pthread_mutex_lock(&job.lock);
+      }
+    }
+    bool done = job.done;
+    char *reasoning = sb_finish(&job.reasoning);
+    char *content = sb_finish(&job.content);
+    struct timeval reasoning_start = job.reasoning_start_time;
+    pthread_mutex_unlock(&job.lock);
+
+    if (reasoning) {
+      append_to_reasoning(&resp, reasoning, strlen(reasoning));
+      if (reasoning_cb) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+        reasoning_cb(reasoning, ms_between(&reasoning_start, &now), userdata);
+      }
+      free(reasoning);
+    }
+    if (content) {
+      got_content = true;
+      append_to_response(&resp, content, strlen(content));
+      if (stream_cb)
+        stream_cb(content, userdata);
+      free(content);
+    }
+    if (done)
+      break;
+    pthread_mutex_lock(&job.lock);
+  }
+  pthread_join(thread, NULL);
+  pthread_cond_destroy(&job.cond);
+  pthread_mutex_destroy(&job.lock);
+  pthread_mutex_unlock(&g_local_lock);
+
+  gettimeofday(&end_time, NULL);
+  resp.success = job.ok;
+  if (!job.ok)
+    snprintf(resp.error, sizeof(resp.error), "%s", job.error);
+  snprintf(resp.finish_reason, sizeof(resp.finish_reason), "%s",
+           job.finish_reason);
+  resp.prompt_tokens = prompt.count;
+  resp.completion_tokens = job.completion_tokens;
+  resp.elapsed_ms = ms_between(&start_time, &end_time);
+  if (job.stream.has_reasoning)
+    resp.reasoning_ms =
+        ms_between(&job.reasoning_start_time, &job.reasoning_end_time);
+  if (job.has_first_token && job.completion_tokens > 0) {
+    double output_time_ms =
+        ms_between(&job.first_token_time, &job.last_token_time);
+    if (output_time_ms > 0)
+      resp.output_tps = (job.completion_tokens * 1000.0) / output_time_ms;
+  }
+  free(prompt.ids);
+  return resp;
+}
+
+static int local_tokenize(const ModelConfig *config, const char *text) {
+  (void)config;
+  pthread_mutex_lock(&g_local_lock);
+  int count = -1;
+  if (text && (g_local.tokenizer.loaded ||
+               chat_tokenizer_set(&g_local.tokenizer, TOKENIZER_QWEN3)))
+    count = chat_tokenizer_count(&g_local.tokenizer, text);
+  pthread_mutex_unlock(&g_local_lock);
+  return count;
+}
+
+void backend_local_preload(const char *model_dir) {
+  if (!model_dir || !model_dir[0])
+    return;
+  char error[256];
+  pthread_mutex_lock(&g_local_lock);
+  if (!engine_start(&g_local, model_dir, error, sizeof(error)))
+    log_message(LOG_WARNING, __FILE__, __LINE__, "%s", error);
+  pthread_mutex_unlock(&g_local_lock);
+}
+
+void backend_local_shutdown(void) {
+  pthread_mutex_lock(&g_local_lock);
+  engine_unload(&g_local);
+  pthread_mutex_unlock(&g_local_lock);
+}
+
+const LLMBackend backend_local = {
+    .tokenize = local_tokenize,
+    .chat = local_chat,
+};
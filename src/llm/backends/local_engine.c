@@ -0,0 +1,382 @@
+#include "local_engine.h"
+#include "core/log.h"
+#include "core/macros.h"
+#include "llm/common.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* Shared prefix a context shift needs to keep as the attention sink */
+#define LOCAL_SHIFT_MIN_KEEP 4
+
+/* Fewest reused tokens for which a shift beats re-prefilling them */
+#define LOCAL_SHIFT_MIN_MATCH 32
+
+bool local_tokens_resolve(LocalTokens *tokens, ChatTokenizer *tokenizer,
+                          char *error, size_t error_size) {
+  static const char *const names[] = {"<|endoftext|>", "<|im_start|>",
+                                      "<|im_end|>", "<think>", "</think>"};
+  int *const ids[] = {&tokens->endoftext, &tokens->im_start, &tokens->im_end,
+                      &tokens->think, &tokens->think_end};
+  for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+    *ids[i] = chat_tokenizer_token_id(tokenizer, names[i]);
+    if (*ids[i] < 0) {
+      snprintf(error, error_size, "Tokenizer has no %s token", names[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool tokens_push(TokenBuf *tb, int id) {
+  if (tb->count == tb->cap) {
+    int cap = tb->cap == 0 ? 1024 : tb->cap * 2;
+    int *tmp = realloc(tb->ids, cap * sizeof(int));
+    if (!tmp)
+      return false;
+    tb->ids = tmp;
+    tb->cap = cap;
+  }
+  tb->ids[tb->count++] = id;
+  return true;
+}
+
+static bool tokens_append_text(TokenBuf *tb, ChatTokenizer *tokenizer,
+                               const char *text) {
+  if (!text || !text[0])
+    return true;
+  TokenResult tr;
+  token_result_init(&tr);
+  int n = chat_tokenizer_encode(tokenizer, text, &tr);
+  bool ok = n >= 0;
+  for (int i = 0; ok && i < n; i++)
+    ok = tokens_push(tb, (int)tr.ids[i]);
+  token_result_free(&tr);
+  return ok;
+}
+
+/* <|im_start|>role\ncontent<|im_end|>\n */
+static bool tokens_append_message(TokenBuf *tb, ChatTokenizer *tokenizer,
+                                  const LocalTokens *tokens, const char *role,
+                                  const char *content) {
+  size_t len = strlen(role) + strlen(content) + 2;
+  char *text = malloc(len);
+  if (!text)
+    return false;
+  snprintf(text, len, "%s\n%s", role, content);
+  bool ok = tokens_push(tb, tokens->im_start) &&
+            tokens_append_text(tb, tokenizer, text) &&
+            tokens_push(tb, tokens->im_end) &&
+            tokens_append_text(tb, tokenizer, "\n");
+  free(text);
+  return ok;
+}
+
+/* History text without the UI's speaker prefix, attachments expanded */
+static char *history_content(const char *msg, MessageRole role,
+                             const char *char_name, const char *user_name) {
+  const char *content = msg;
+  if (role == ROLE_USER && strncmp(msg, "You: ", 5) == 0) {
+    content = msg + 5;
+  } else if (role == ROLE_ASSISTANT && strncmp(msg, "Bot:", 4) == 0) {
+    content = msg + 4;
+    while (*content == ' ')
+      content++;
+  }
+  char *expanded = expand_attachments(content);
+  char *substituted =
+      macro_substitute(expanded ? expanded : content, char_name, user_name);
+  free(expanded);
+  return substituted ? substituted : strdup(content);
+}
+
+bool local_build_prompt(const ChatHistory *history, const LLMContext *context,
+                        ChatTokenizer *tokenizer, const LocalTokens *tokens,
+                        int budget, TokenBuf *prompt) {
+  const char *char_name =
+      (context && context->character) ? context->character->name : NULL;
+  const char *user_name = (context && context->persona)
+                              ? persona_get_name(context->persona)
+                              : "User";
+  const AuthorNote *note = context ? context->author_note : NULL;
+  bool ok = true;
+
+  if (note && note->text[0] && note->position == AN_POS_BEFORE_SCENARIO)
+    ok = tokens_append_message(prompt, tokenizer, tokens,
+                               author_note_role_to_string(note->role),
+                               note->text);
+
+  char *system_prompt = build_system_prompt(context);
+  if (ok && system_prompt)
+    ok = tokens_append_message(prompt, tokenizer, tokens, "system",
+                               system_prompt);
+  free(system_prompt);
+
+  if (ok && context && context->lorebook) {
+    char *lore_ctx = lorebook_build_context(context->lorebook, history, 0);
+    if (lore_ctx && lore_ctx[0]) {
+      size_t len = strlen(lore_ctx) + 16;
+      char *text = malloc(len);
+      ok = text != NULL;
+      if (ok) {
+        snprintf(text, len, "[World Info]\n%s", lore_ctx);
+        ok = tokens_append_message(prompt, tokenizer, tokens, "system", text);
+        free(text);
+      }
+    }
+    free(lore_ctx);
+  }
+
+  if (ok && note && note->text[0] && note->position == AN_POS_AFTER_SCENARIO)
+    ok = tokens_append_message(prompt, tokenizer, tokens,
+                               author_note_role_to_string(note->role),
+                               note->text);
+
+  if (ok && context && context->character &&
+      context->character->mes_example) {
+    size_t example_count = 0;
+    ExampleMessage *examples = parse_mes_example(
+        context->character->mes_example, &example_count, char_name, user_name);
+    for (size_t i = 0; ok && examples && i < example_count; i++)
+      ok = tokens_append_message(prompt, tokenizer, tokens, examples[i].role,
+                                 examples[i].content);
+    if (examples)
+      free_example_messages(examples, example_count);
+  }
+
+  TokenBuf tail = {0};
+  if (ok && context && context->character &&
+      context->character->post_history_instructions &&
+      context->character->post_history_instructions[0]) {
+    char *substituted = macro_substitute(
+        context->character->post_history_instructions, char_name, user_name);
+    if (substituted) {
+      ok = tokens_append_message(&tail, tokenizer, tokens, "system",
+                                 substituted);
+      free(substituted);
+    }
+  }
+  ok = ok && tokens_push(&tail, tokens->im_start) &&
+       tokens_append_text(&tail, tokenizer, "assistant\n");
+
+  /* Newest messages first until the budget runs out */
+  size_t count = history ? history->count : 0;
+  TokenBuf *messages = count > 0 ? calloc(count, sizeof(TokenBuf)) : NULL;
+  if (count > 0 && !messages)
+    ok = false;
+  size_t start_index = count;
+  int available = budget - prompt->count - tail.count;
+  for (size_t i = count; ok && i > 0; i--) {
+    const char *msg = history_get(history, i - 1);
+    if (!msg)
+      continue;
+    MessageRole role = history_get_role(history, i - 1);
+    char *content = history_content(msg, role, char_name, user_name);
+    ok = content && tokens_append_message(&messages[i - 1], tokenizer, tokens,
+                                          role_to_string(role), content);
+    free(content);
+    if (!ok || messages[i - 1].count > available)
+      break;
+    available -= messages[i - 1].count;
+    start_index = i - 1;
+  }
+
+  size_t note_index = SIZE_MAX;
+  if (note && note->text[0] && note->position == AN_POS_IN_CHAT &&
+      count > 0) {
+    size_t from_end = (size_t)note->depth;
+    note_index = from_end < count ? count - from_end : start_index;
+    if (note_index < start_index)
+      note_index = start_index;
+  }
+
+  for (size_t i = start_index; ok && i < count; i++) {
+    if (i == note_index)
+      ok = tokens_append_message(prompt, tokenizer, tokens,
+                                 author_note_role_to_string(note->role),
+                                 note->text);
+    for (int t = 0; ok && t < messages[i].count; t++)
+      ok = tokens_push(prompt, messages[i].ids[t]);
+  }
+  for (int t = 0; ok && t < tail.count; t++)
+    ok = tokens_push(prompt, tail.ids[t]);
+
+  for (size_t i = 0; i < count; i++)
+    free(messages[i].ids);
+  free(messages);
+  free(tail.ids);
+  return ok;
+}
+
+size_t local_utf8_complete_len(const char *s, size_t len) {
+  size_t i = len;
+  while (i > 0 && len - i < 4 && ((unsigned char)s[i - 1] & 0xC0) == 0x80)
+    i--;
+  if (i == 0)
+    return len;
+  unsigned char lead = (unsigned char)s[i - 1];
+  size_t need = lead >= 0xF0 ? 4 : lead >= 0xE0 ? 3 : lead >= 0xC0 ? 2 : 1;
+  return len - (i - 1) >= need ? len : i - 1;
+}
+
+/* Decode one token and return the characters it completes */
+static char *stream_decode(LocalStream *stream, int token) {
+  uint32_t id = (uint32_t)token;
+  char *text = chat_tokenizer_decode(stream->tokenizer, &id, 1);
+  if (!text)
+    return NULL;
+
+  size_t text_len = strlen(text);
+  char *buf = malloc(stream->pending_len + text_len + 1);
+  if (!buf) {
+    free(text);
+    return NULL;
+  }
+  memcpy(buf, stream->pending, stream->pending_len);
+  memcpy(buf + stream->pending_len, text, text_len);
+  size_t len = stream->pending_len + text_len;
+  free(text);
+
+  size_t complete = local_utf8_complete_len(buf, len);
+  if (len - complete > LOCAL_UTF8_PENDING)
+    complete = len;
+  stream->pending_len = len - complete;
+  memcpy(stream->pending, buf + complete, stream->pending_len);
+  buf[complete] = '\0';
+  if (complete == 0) {
+    free(buf);
+    return NULL;
+  }
+  return buf;
+}
+
+LocalStreamEvent local_stream_token(LocalStream *stream, int token,
+                                    char **text) {
+  const LocalTokens *tokens = stream->tokens;
+  *text = NULL;
+  if (token == tokens->im_end || token == tokens->endoftext)
+    return LOCAL_STREAM_STOP;
+  if (token == tokens->think) {
+    if (stream->has_reasoning)
+      return LOCAL_STREAM_TEXT;
+    stream->in_reasoning = true;
+    stream->has_reasoning = true;
+    return LOCAL_STREAM_THINK;
+  }
+  if (token == tokens->think_end) {
+    if (!stream->in_reasoning)
+      return LOCAL_STREAM_TEXT;
+    stream->in_reasoning = false;
+    return LOCAL_STREAM_THINK_END;
+  }
+  *text = stream_decode(stream, token);
+  return LOCAL_STREAM_TEXT;
+}
+
+char *local_stream_flush(LocalStream *stream) {
+  if (stream->pending_len == 0)
+    return NULL;
+  stream->pending[stream->pending_len] = '\0';
+  stream->pending_len = 0;
+  return strdup(stream->pending);
+}
+
+static bool context_shift_enabled(void) {
+  const char *shift = getenv("SILLYTUI_CONTEXT_SHIFT");
+  return !shift || strcmp(shift, "off") != 0;
+}
+
+/*
+ * The prompt diverges from what was fed after keep tokens. If it continues
+ * with tokens fed later (older messages were dropped to fit the window),
+ * shift the fed tokens in between out of the KV and drop whatever no
+ * longer matches after them. Returns the prompt tokens now covered, or
+ * keep if no shift applies.
+ */
+static int engine_shift(LocalEngine *e, const TokenBuf *prompt, int keep) {
+  if (keep < LOCAL_SHIFT_MIN_KEEP || !context_shift_enabled())
+    return keep;
+
+  /* The smallest discard whose match runs to the end of fed is best */
+  int limit = prompt->count - 1;
+  int discard = 0;
+  int match = 0;
+  for (int skip = 1; keep + skip < e->num_fed; skip++) {
+    int n = 0;
+    while (keep + skip + n < e->num_fed && keep + n < limit &&
+           e->fed[keep + skip + n] == prompt->ids[keep + n])
+      n++;
+    if (n > match) {
+      match = n;
+      discard = skip;
+    }
+    if (keep + skip + n == e->num_fed || keep + n == limit)
+      break;
+  }
+  if (match < LOCAL_SHIFT_MIN_MATCH ||
+      !inference_seq_shift(&e->model, e->seq, keep, discard))
+    return keep;
+
+  log_message(LOG_DEBUG, __FILE__, __LINE__,
+              "Context shift: kept %d, dropped %d, reused %d tokens", keep,
+              discard, match);
+  memmove(e->fed + keep, e->fed + keep + discard,
+          (e->num_fed - keep - discard) * sizeof(int));
+  e->num_fed -= discard;
+  if (e->num_exact > keep)
+    e->num_exact = keep;
+  if (keep + match < e->num_fed) {
+    inference_seq_truncate(&e->model, e->seq, keep + match);
+    e->num_fed = keep + match;
+  }
+  return keep + match;
+}
+
+int local_engine_reuse(LocalEngine *e, const TokenBuf *prompt) {
+  inference_model_t *model = &e->model;
+  int limit = prompt->count - 1 < e->num_fed ? prompt->count - 1 : e->num_fed;
+  int keep = 0;
+  while (keep < limit && e->fed[keep] == prompt->ids[keep])
+    keep++;
+  if (keep == e->num_fed)
+    return keep;
+
+  if (model->ops->seq_truncate) {
+    int shifted = engine_shift(e, prompt, keep);
+    if (shifted > keep)
+      return shifted;
+    inference_seq_truncate(model, e->seq, keep);
+    e->num_fed = keep;
+    if (e->num_exact > keep)
+      e->num_exact = keep;
+    return keep;
+  }
+
+  inference_seq_free(model, e->seq);
+  e->num_fed = 0;
+  e->seq = inference_seq_create(model);
+  if (!e->seq)
+    return -1;
+  keep = inference_seq_reuse_prefix(model, e->seq, prompt->ids,
+                                    prompt->count - 1);
+  memcpy(e->fed, prompt->ids, keep * sizeof(int));
+  e->num_fed = keep;
+  e->num_exact = keep;
+  return keep;
+}
+
+bool local_engine_feed(LocalEngine *e, const int *ids, int n, float *logits) {
+  if (!inference_model_forward_batch(&e->model, &e->seq, &ids, &n, 1, logits))
+    return false;
+  memcpy(e->fed + e->num_fed, ids, n * sizeof(int));
+  if (e->num_exact == e->num_fed)
+    e->num_exact += n;
+  e->num_fed += n;
+  return true;
+}
+
+void local_engine_cache_prefix(LocalEngine *e) {
+  if (e->seq && e->num_exact > 0)
+    inference_seq_cache_prefix(&e->model, e->seq, e->fed, e->num_exact);
+}
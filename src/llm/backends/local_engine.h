@@ -0,0 +1,114 @@
+/*
+ * Local Backend Engine
+ *
+ * The parts of the local backend (see local.c) that need neither its
+ * generation thread nor a real model: rendering the chat into ChatML prompt
+ * tokens, turning generated tokens back into reply and reasoning text, and
+ * keeping the resident KV of the last conversation in step with the next
+ * prompt.
+ */
+
+#ifndef LLM_BACKENDS_LOCAL_ENGINE_H
+#define LLM_BACKENDS_LOCAL_ENGINE_H
+
+#include "inference/model/base.h"
+#include "llm/backends/backend.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+/* Longest partial UTF-8 sequence held back between tokens */
+#define LOCAL_UTF8_PENDING 8
+
+typedef struct {
+  int *ids;
+  int count;
+  int cap;
+} TokenBuf;
+
+/* Special tokens of the ChatML template, as ids of the chat's vocabulary */
+typedef struct {
+  int endoftext;
+  int im_start;
+  int im_end;
+  int think;
+  int think_end;
+} LocalTokens;
+
+typedef struct {
+  bool loaded; /* model is loaded or loading */
+  char model_dir[MAX_URL_LEN];
+  inference_model_t model;
+  inference_seq_t *seq; /* NULL until the load has finished */
+  int *fed; /* Tokens whose KV seq holds, in order */
+  int num_fed;
+  int fed_cap;
+  int num_exact; /* Leading fed tokens whose KV was not shifted */
+  ChatTokenizer tokenizer; /* Used when the chat has no local tokenizer */
+} LocalEngine;
+
+typedef enum {
+  LOCAL_STREAM_TEXT,      /* Part of the reply or of the reasoning */
+  LOCAL_STREAM_THINK,     /* <think> opened the reasoning */
+  LOCAL_STREAM_THINK_END, /* </think> closed it */
+  LOCAL_STREAM_STOP,      /* End of the reply */
+} LocalStreamEvent;
+
+/* Decoding state of one reply */
+typedef struct {
+  ChatTokenizer *tokenizer;
+  const LocalTokens *tokens;
+  bool in_reasoning;
+  bool has_reasoning;
+  char pending[LOCAL_UTF8_PENDING + 1]; /* Start of an unfinished character */
+  size_t pending_len;
+} LocalStream;
+
+/*
+ * Look the special tokens up in tokenizer. Returns false, with a message in
+ * error, if its vocabulary lacks any of them.
+ */
+bool local_tokens_resolve(LocalTokens *tokens, ChatTokenizer *tokenizer,
+                          char *error, size_t error_size);
+
+/*
+ * Render the conversation into prompt tokens, dropping the oldest history
+ * messages that do not fit in budget tokens
+ */
+bool local_build_prompt(const ChatHistory *history, const LLMContext *context,
+                        ChatTokenizer *tokenizer, const LocalTokens *tokens,
+                        int budget, TokenBuf *prompt);
+
+/* Bytes of s[0, len) that end on a UTF-8 character boundary */
+size_t local_utf8_complete_len(const char *s, size_t len);
+
+/*
+ * Classify one generated token and decode it. *text receives the characters
+ * it completes, or NULL if there are none; they belong to the reasoning if
+ * stream->in_reasoning is set afterwards, else to the reply. The special
+ * tokens themselves never show up in the text.
+ */
+LocalStreamEvent local_stream_token(LocalStream *stream, int token,
+                                    char **text);
+
+/* The bytes still held back at the end of the reply, or NULL */
+char *local_stream_flush(LocalStream *stream);
+
+/*
+ * Keep the resident KV of the longest prefix the new prompt shares with
+ * what was fed before, shifting out the tokens of dropped messages where
+ * that lets more of it be reused; the last prompt token always runs for its
+ * logits. Returns the number of prompt tokens to skip, or -1.
+ * SILLYTUI_CONTEXT_SHIFT=off disables the shift.
+ */
+int local_engine_reuse(LocalEngine *e, const TokenBuf *prompt);
+
+/* Feed n tokens to the sequence, leaving the last one's logits in logits */
+bool local_engine_feed(LocalEngine *e, const int *ids, int n, float *logits);
+
+/*
+ * Offer the fed tokens to the model's prefix cache, up to the first one
+ * whose KV was shifted: the cache holds exact prefixes only
+ */
+void local_engine_cache_prefix(LocalEngine *e);
+
+#endif
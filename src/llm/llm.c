@@ -10,7 +10,15 @@
 
 void llm_init(void) { curl_global_init(CURL_GLOBAL_DEFAULT); }
 
-void llm_cleanup(void) { curl_global_cleanup(); }
+void llm_preload(const ModelConfig *config) {
+  if (config && config->api_type == API_TYPE_LOCAL)
+    backend_local_preload(config->base_url);
+}
+
+void llm_cleanup(void) {
+  backend_local_shutdown();
+  curl_global_cleanup();
+}
 
 int llm_estimate_tokens(const char *text) {
   if (!text)
@@ -24,6 +32,8 @@ const LLMBackend *backend_get(ApiType type) {
     return &backend_anthropic;
   case API_TYPE_KOBOLDCPP:
     return &backend_kobold;
+  case API_TYPE_LOCAL:
+    return &backend_local;
   case API_TYPE_OPENAI:
   case API_TYPE_APHRODITE:
   case API_TYPE_VLLM:
@@ -86,6 +96,8 @@ static int parse_token_count(const char *json) {
 int llm_tokenize(const ModelConfig *config, const char *text) {
   if (!config || !text || !config->base_url[0])
     return -1;
+  if (config->api_type == API_TYPE_LOCAL)
+    return backend_local.tokenize(config, text);
 
   const char *base = config->base_url;
   size_t base_len = strlen(base);
@@ -228,7 +240,8 @@ LLMResponse llm_chat(const ModelConfig *config, const ChatHistory *history,
                      LLMProgressCallback progress_cb, void *userdata) {
   LLMResponse resp = {0};
 
-  if (!config || !config->base_url[0] || !config->model_id[0]) {
+  if (!config || !config->base_url[0] ||
+      (!config->model_id[0] && config->api_type != API_TYPE_LOCAL)) {
     snprintf(resp.error, sizeof(resp.error), "No model configured");
     return resp;
   }
@@ -238,6 +251,9 @@ LLMResponse llm_chat(const ModelConfig *config, const ChatHistory *history,
   }
 
   const LLMBackend *backend = backend_get(config->api_type);
+  if (backend->chat)
+    return backend->chat(config, history, context, stream_cb, reasoning_cb,
+                         progress_cb, userdata);
 
   CURL *curl = curl_easy_init();
   if (!curl) {
@@ -6,6 +6,10 @@
 void llm_init(void);
 void llm_cleanup(void);
 
+/* Start loading the model behind config ahead of the first chat, if it runs
+ * in-process; other backends have nothing to load */
+void llm_preload(const ModelConfig *config);
+
 int llm_estimate_tokens(const char *text);
 int llm_tokenize(const ModelConfig *config, const char *text);
 
@@ -571,3 +571,34 @@ bool sampler_remove_custom(SamplerSettings *s, int index) {
   s->custom_count--;
   return true;
 }
+
+void sampler_chain_params(const SamplerSettings *s,
+                          sampling_chain_params_t *p) {
+  memset(p, 0, sizeof(*p));
+  p->temperature = (float)s->temperature;
+  p->top_k = s->top_k;
+  p->top_p = (float)s->top_p;
+  p->min_p = (float)s->min_p;
+  p->typical_p = (float)s->typical_p;
+  p->tfs = (float)s->tfs;
+  p->top_a = (float)s->top_a;
+  p->nsigma = (float)s->nsigma;
+  p->xtc_threshold = (float)s->xtc_threshold;
+  p->xtc_probability = (float)s->xtc_probability;
+  p->smoothing_factor = (float)s->smoothing_factor;
+  p->dynatemp_min = (float)s->dynatemp_min;
+  p->dynatemp_max = (float)s->dynatemp_max;
+  p->dynatemp_exponent = (float)s->dynatemp_exponent;
+  p->repetition_penalty = (float)s->repetition_penalty;
+  p->frequency_penalty = (float)s->frequency_penalty;
+  p->presence_penalty = (float)s->presence_penalty;
+  p->dry_multiplier = (float)s->dry_multiplier;
+  p->dry_base = (float)s->dry_base;
+  p->dry_allowed_length = s->dry_allowed_length;
+  p->dry_range = s->dry_range;
+  p->mirostat_mode = s->mirostat_mode;
+  p->mirostat_tau = (float)s->mirostat_tau;
+  p->mirostat_eta = (float)s->mirostat_eta;
+  p->min_tokens = s->min_tokens;
+  p->eos_token_id = -1;
+}
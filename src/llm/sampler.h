@@ -2,6 +2,7 @@
 #define SAMPLER_H
 
 #include "core/config.h"
+#include "inference/kernels/sampling/sampling_chain.h"
 #include <stdbool.h>
 
 #define MAX_CUSTOM_SAMPLERS 256
@@ -92,4 +93,12 @@ bool sampler_add_custom(SamplerSettings *s, const char *name,
                         double step);
 bool sampler_remove_custom(SamplerSettings *s, int index);
 
+/*
+ * Map the settings onto the local engine's sampler chain. Fields with no
+ * setting (penalty range, DRY breakers, EOS) are left at their defaults;
+ * skew has no local equivalent and is ignored.
+ */
+void sampler_chain_params(const SamplerSettings *s,
+                          sampling_chain_params_t *p);
+
 #endif
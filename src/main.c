@@ -1331,6 +1331,8 @@ int main(void) {
   }
 
   llm_init();
+  /* A local model loads while the UI starts up */
+  llm_preload(active_model);
   log_message(LOG_INFO, __FILE__, __LINE__, "Application starting");
 
   setlocale(LC_ALL, "");
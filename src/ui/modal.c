@@ -653,6 +653,8 @@ static void draw_button(WINDOW *win, int y, int x, const char *label,
 static void draw_model_fields(Modal *m, WINDOW *w, int *y, int field_w) {
   const char *labels[] = {"Name", "Base URL", "API Key", "Model", "Context"};
   bool is_pw[] = {false, false, true, false, false};
+  if (m->api_type_selection == API_TYPE_LOCAL)
+    labels[1] = "Model Dir";
 
   bool is_anthropic = (m->api_type_selection == API_TYPE_ANTHROPIC);
   bool is_openai_compat = (m->api_type_selection == API_TYPE_APHRODITE ||
@@ -2694,7 +2696,8 @@ ModalResult modal_handle_key(Modal *m, int ch, ModelsFile *mf,
           modal_open_message(m, "Base URL is required", true);
           return MODAL_RESULT_NONE;
         }
-        if (m->fields[3][0] == '\0') {
+        if (m->fields[3][0] == '\0' &&
+            m->api_type_selection != API_TYPE_LOCAL) {
           modal_open_message(m, "Model ID is required", true);
           return MODAL_RESULT_NONE;
         }
@@ -2967,7 +2970,8 @@ ModalResult modal_handle_key(Modal *m, int ch, ModelsFile *mf,
           modal_open_message(m, "Base URL is required", true);
           return MODAL_RESULT_NONE;
         }
-        if (m->fields[3][0] == '\0') {
+        if (m->fields[3][0] == '\0' &&
+            m->api_type_selection != API_TYPE_LOCAL) {
           modal_open_message(m, "Model ID is required", true);
           return MODAL_RESULT_NONE;
         }
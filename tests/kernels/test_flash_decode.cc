@@ -0,0 +1,159 @@
+/*
+ * Split-KV Decode Attention Tests
+ */
+
+#include "test_framework.h"
+#include "kernels/test_helper.h"
+
+extern "C" {
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/attention/flash_decode.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
+}
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/* Two-pass softmax attention in double over the contiguous copy */
+static void attention_reference(const paged_cache *c, const float *q,
+                                float *out, int kv_len, int num_heads,
+                                int num_kv_heads, int head_dim, float scale) {
+  int kv_dim = num_kv_heads * head_dim;
+  int group = num_heads / num_kv_heads;
+  std::vector<double> scores(kv_len);
+  for (int h = 0; h < num_heads; h++) {
+    const float *qh = q + (size_t)h * head_dim;
+    int kv_head = h / group;
+    double max = -INFINITY;
+    for (int t = 0; t < kv_len; t++) {
+      const float *k = c->key.data() + (size_t)t * kv_dim + kv_head * head_dim;
+      double dot = 0.0;
+      for (int d = 0; d < head_dim; d++)
+        dot += (double)qh[d] * k[d];
+      scores[t] = dot * scale;
+      max = scores[t] > max ? scores[t] : max;
+    }
+    double sum = 0.0;
+    for (int t = 0; t < kv_len; t++) {
+      scores[t] = exp(scores[t] - max);
+      sum += scores[t];
+    }
+    for (int d = 0; d < head_dim; d++) {
+      double acc = 0.0;
+      for (int t = 0; t < kv_len; t++)
+        acc += scores[t] *
+               c->value[(size_t)t * kv_dim + kv_head * head_dim + d];
+      out[(size_t)h * head_dim + d] = (float)(acc / sum);
+    }
+  }
+}
+
+/* Runs one decode over a filled cache against the reference, then frees it */
+static bool run_decode(paged_cache *c, int kv_len, int num_heads,
+                       int num_kv_heads, int head_dim, bool f16, float tol) {
+  size_t q_size = (size_t)num_heads * head_dim;
+  std::vector<float> q(q_size), out(q_size), ref(q_size);
+  fill_values(q.data(), q_size, (unsigned)kv_len);
+  float scale = 1.0f / sqrtf((float)head_dim);
+  bool ok;
+
+  if (f16) {
+    std::vector<uint16_t> q16(q_size), out16(q_size);
+    f32_to_f16_array(q.data(), q16.data(), q_size);
+    f16_to_f32_array(q16.data(), q.data(), q_size);
+    ok = flash_decode_f16(out16.data(), q16.data(), &c->table, 1, kv_len,
+                          num_heads, num_kv_heads, head_dim, scale, NULL);
+    f16_to_f32_array(out16.data(), out.data(), q_size);
+  } else {
+    ok = flash_decode_f32(out.data(), q.data(), &c->table, 1, kv_len,
+                          num_heads, num_kv_heads, head_dim, scale, NULL);
+  }
+  attention_reference(c, q.data(), ref.data(), kv_len, num_heads,
+                      num_kv_heads, head_dim, scale);
+  free_cache(c);
+
+  if (!ok)
+    return false;
+  for (size_t i = 0; i < q_size; i++) {
+    if (fabsf(out[i] - ref[i]) > tol) {
+      printf("    mismatch kv_len=%d at %zu: %f vs %f\n", kv_len, i, out[i],
+             ref[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool check_decode(int kv_len, int num_heads, int num_kv_heads,
+                         int head_dim, bool f16, float tol) {
+  paged_cache c;
+  if (!make_cache(&c, kv_len, num_kv_heads, head_dim, f16, 7))
+    return false;
+  return run_decode(&c, kv_len, num_heads, num_kv_heads, head_dim, f16, tol);
+}
+
+static bool check_decode_q8(int kv_len, int num_heads, int num_kv_heads,
+                            int head_dim, bool f16, float tol) {
+  paged_cache c;
+  if (!make_cache_q8(&c, kv_len, num_kv_heads, head_dim, 7))
+    return false;
+  return run_decode(&c, kv_len, num_heads, num_kv_heads, head_dim, f16, tol);
+}
+
+TEST(flash_decode_f32_matches_reference) {
+  ASSERT_TRUE(check_decode(1, 4, 4, 64, false, 1e-5f));
+  ASSERT_TRUE(check_decode(37, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_decode(300, 16, 8, 128, false, 1e-5f));
+}
+
+TEST(flash_decode_f16_matches_reference) {
+  ASSERT_TRUE(check_decode(19, 8, 2, 128, true, 2e-3f));
+  ASSERT_TRUE(check_decode(520, 16, 8, 128, true, 2e-3f));
+}
+
+TEST(flash_decode_odd_head_dim) {
+  ASSERT_TRUE(check_decode(45, 6, 3, 36, false, 1e-5f));
+  ASSERT_TRUE(check_decode(45, 6, 3, 36, true, 2e-3f));
+}
+
+TEST(flash_decode_split_kv_matches_reference) {
+  /* Long enough to be split into ranges across the pool */
+  int saved = threadpool_get_num_threads();
+  threadpool_set_num_threads(4);
+  ASSERT_TRUE(check_decode(4000, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_decode(4000, 16, 8, 128, true, 2e-3f));
+  threadpool_set_num_threads(saved);
+}
+
+TEST(flash_decode_int8_cache_matches_reference) {
+  /* The reference attends the dequantized cache, so only rounding differs */
+  ASSERT_TRUE(check_decode_q8(37, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_decode_q8(45, 6, 3, 36, false, 1e-5f));
+  ASSERT_TRUE(check_decode_q8(520, 16, 8, 128, true, 2e-3f));
+  int saved = threadpool_get_num_threads();
+  threadpool_set_num_threads(4);
+  ASSERT_TRUE(check_decode_q8(4000, 16, 8, 128, false, 1e-5f));
+  threadpool_set_num_threads(saved);
+}
+
+TEST(flash_decode_rejects_bad_shapes) {
+  float q[8] = {0}, out[8];
+  paged_cache c;
+  ASSERT_TRUE(make_cache(&c, 4, 1, 4, false, 7));
+  ASSERT_FALSE(flash_decode_f32(out, q, &c.table, 1, 4, 3, 2, 4, 1.0f, NULL));
+  ASSERT_FALSE(flash_decode_f32(out, q, &c.table, 1, 4, 1, 1,
+                                FLASH_DECODE_MAX_HEAD_DIM + 1, 1.0f, NULL));
+  free_cache(&c);
+}
+
+extern "C" void run_flash_decode_tests(void) {
+  TEST_SUITE("Flash Decode");
+  RUN_TEST(flash_decode_f32_matches_reference);
+  RUN_TEST(flash_decode_f16_matches_reference);
+  RUN_TEST(flash_decode_odd_head_dim);
+  RUN_TEST(flash_decode_split_kv_matches_reference);
+  RUN_TEST(flash_decode_int8_cache_matches_reference);
+  RUN_TEST(flash_decode_rejects_bad_shapes);
+}
@@ -0,0 +1,174 @@
+/*
+ * Tiled Causal Prefill Attention Tests
+ */
+
+#include "test_framework.h"
+#include "kernels/test_helper.h"
+
+extern "C" {
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/attention/flash_prefill.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
+}
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/* Causal softmax attention in double, query row i at start_pos + i */
+static void attention_reference(const paged_cache *c, const float *q,
+                                float *out, int start_pos, int num_tokens,
+                                int num_heads, int num_kv_heads, int head_dim,
+                                float scale) {
+  int kv_dim = num_kv_heads * head_dim;
+  int q_dim = num_heads * head_dim;
+  int group = num_heads / num_kv_heads;
+  std::vector<double> scores(start_pos + num_tokens);
+  for (int i = 0; i < num_tokens; i++) {
+    int kv_len = start_pos + i + 1;
+    for (int h = 0; h < num_heads; h++) {
+      const float *qh = q + (size_t)i * q_dim + (size_t)h * head_dim;
+      int head = (h / group) * head_dim;
+      double max = -INFINITY;
+      for (int t = 0; t < kv_len; t++) {
+        const float *k = c->key.data() + (size_t)t * kv_dim + head;
+        double dot = 0.0;
+        for (int d = 0; d < head_dim; d++)
+          dot += (double)qh[d] * k[d];
+        scores[t] = dot * scale;
+        max = scores[t] > max ? scores[t] : max;
+      }
+      double sum = 0.0;
+      for (int t = 0; t < kv_len; t++) {
+        scores[t] = exp(scores[t] - max);
+        sum += scores[t];
+      }
+      for (int d = 0; d < head_dim; d++) {
+        double acc = 0.0;
+        for (int t = 0; t < kv_len; t++)
+          acc += scores[t] * c->value[(size_t)t * kv_dim + head + d];
+        out[(size_t)i * q_dim + (size_t)h * head_dim + d] =
+            (float)(acc / sum);
+      }
+    }
+  }
+}
+
+/* Runs one prefill over a filled cache against the reference, then frees it */
+static bool run_prefill(paged_cache *c, int start_pos, int num_tokens,
+                        int num_heads, int num_kv_heads, int head_dim,
+                        bool f16, float tol) {
+  size_t q_size = (size_t)num_tokens * num_heads * head_dim;
+  std::vector<float> q(q_size), out(q_size), ref(q_size);
+  fill_values(q.data(), q_size, (unsigned)num_tokens);
+  float scale = 1.0f / sqrtf((float)head_dim);
+  bool ok;
+
+  if (f16) {
+    std::vector<uint16_t> q16(q_size), out16(q_size);
+    f32_to_f16_array(q.data(), q16.data(), q_size);
+    f16_to_f32_array(q16.data(), q.data(), q_size);
+    ok = flash_prefill_f16(out16.data(), q16.data(), &c->table, 1, start_pos,
+                           num_tokens, num_heads, num_kv_heads, head_dim,
+                           scale, NULL);
+    f16_to_f32_array(out16.data(), out.data(), q_size);
+  } else {
+    ok = flash_prefill_f32(out.data(), q.data(), &c->table, 1, start_pos,
+                           num_tokens, num_heads, num_kv_heads, head_dim,
+                           scale, NULL);
+  }
+  attention_reference(c, q.data(), ref.data(), start_pos, num_tokens,
+                      num_heads, num_kv_heads, head_dim, scale);
+  free_cache(c);
+
+  if (!ok)
+    return false;
+  for (size_t i = 0; i < q_size; i++) {
+    if (fabsf(out[i] - ref[i]) > tol) {
+      printf("    mismatch start=%d tokens=%d at %zu: %f vs %f\n", start_pos,
+             num_tokens, i, out[i], ref[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool check_prefill(int start_pos, int num_tokens, int num_heads,
+                          int num_kv_heads, int head_dim, bool f16,
+                          float tol) {
+  paged_cache c;
+  if (!make_cache(&c, start_pos + num_tokens, num_kv_heads, head_dim, f16, 3))
+    return false;
+  return run_prefill(&c, start_pos, num_tokens, num_heads, num_kv_heads,
+                     head_dim, f16, tol);
+}
+
+static bool check_prefill_q8(int start_pos, int num_tokens, int num_heads,
+                             int num_kv_heads, int head_dim, bool f16,
+                             float tol) {
+  paged_cache c;
+  if (!make_cache_q8(&c, start_pos + num_tokens, num_kv_heads, head_dim,
+                     3))
+    return false;
+  return run_prefill(&c, start_pos, num_tokens, num_heads, num_kv_heads,
+                     head_dim, f16, tol);
+}
+
+TEST(flash_prefill_f32_matches_reference) {
+  ASSERT_TRUE(check_prefill(0, 2, 4, 4, 64, false, 1e-5f));
+  ASSERT_TRUE(check_prefill(0, 37, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_prefill(0, 150, 16, 8, 128, false, 1e-5f));
+}
+
+TEST(flash_prefill_f16_matches_reference) {
+  ASSERT_TRUE(check_prefill(0, 19, 8, 2, 128, true, 2e-3f));
+  ASSERT_TRUE(check_prefill(0, 130, 16, 8, 128, true, 2e-3f));
+}
+
+TEST(flash_prefill_with_cached_prefix) {
+  /* Query blocks start mid-tile, so the diagonal is offset */
+  ASSERT_TRUE(check_prefill(45, 30, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_prefill(100, 70, 16, 8, 128, true, 2e-3f));
+}
+
+TEST(flash_prefill_odd_head_dim) {
+  ASSERT_TRUE(check_prefill(3, 41, 6, 3, 36, false, 1e-5f));
+  ASSERT_TRUE(check_prefill(3, 41, 6, 3, 36, true, 2e-3f));
+}
+
+TEST(flash_prefill_threaded_matches_reference) {
+  int saved = threadpool_get_num_threads();
+  threadpool_set_num_threads(4);
+  ASSERT_TRUE(check_prefill(0, 300, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_prefill(20, 200, 16, 8, 128, true, 2e-3f));
+  threadpool_set_num_threads(saved);
+}
+
+TEST(flash_prefill_int8_cache_matches_reference) {
+  ASSERT_TRUE(check_prefill_q8(0, 37, 8, 2, 64, false, 1e-5f));
+  ASSERT_TRUE(check_prefill_q8(45, 30, 6, 3, 36, false, 1e-5f));
+  ASSERT_TRUE(check_prefill_q8(100, 70, 16, 8, 128, true, 2e-3f));
+}
+
+TEST(flash_prefill_rejects_bad_shapes) {
+  float q[8] = {0}, out[8];
+  paged_cache c;
+  ASSERT_TRUE(make_cache(&c, 4, 1, 4, false, 3));
+  ASSERT_FALSE(
+      flash_prefill_f32(out, q, &c.table, 1, 0, 2, 3, 2, 4, 1.0f, NULL));
+  ASSERT_FALSE(flash_prefill_f32(out, q, &c.table, 1, 0, 1, 1, 1,
+                                 FLASH_PREFILL_MAX_HEAD_DIM + 1, 1.0f, NULL));
+  free_cache(&c);
+}
+
+extern "C" void run_flash_prefill_tests(void) {
+  TEST_SUITE("Flash Prefill");
+  RUN_TEST(flash_prefill_f32_matches_reference);
+  RUN_TEST(flash_prefill_f16_matches_reference);
+  RUN_TEST(flash_prefill_with_cached_prefix);
+  RUN_TEST(flash_prefill_odd_head_dim);
+  RUN_TEST(flash_prefill_threaded_matches_reference);
+  RUN_TEST(flash_prefill_int8_cache_matches_reference);
+  RUN_TEST(flash_prefill_rejects_bad_shapes);
+}
@@ -300,6 +300,81 @@ TEST(gemm_f32_tail_m23_n19) {
   PASS();
 }
 
+TEST(gemm_bf16_tail_m7_n21) {
+  const int M = 7, N = 21, K = 40;
+  float A_f32[M * K], B_f32[K * N], C_f32[M * N], expected[M * N];
+  uint16_t A_bf16[M * K], B_bf16[K * N], C_bf16[M * N];
+
+  for (int i = 0; i < M * K; i++)
+    A_f32[i] = (float)(i % 9) * 0.125f - 0.5f;
+  for (int i = 0; i < K * N; i++)
+    B_f32[i] = (float)(i % 5) * 0.25f - 0.5f;
+
+  f32_array_to_bf16(A_f32, A_bf16, M * K);
+  f32_array_to_bf16(B_f32, B_bf16, K * N);
+
+  gemm_bf16(A_bf16, B_bf16, C_bf16, M, N, K);
+
+  bf16_array_to_f32(C_bf16, C_f32, M * N);
+  naive_matmul_f32(A_f32, B_f32, expected, M, N, K);
+
+  for (int i = 0; i < M * N; i++) {
+    ASSERT_NEAR(expected[i], C_f32[i], 0.05f);
+  }
+
+  PASS();
+}
+
+TEST(gemm_bf16_odd_k_m9_n40) {
+  const int M = 9, N = 40, K = 37;
+  float A_f32[M * K], B_f32[K * N], C_f32[M * N], expected[M * N];
+  uint16_t A_bf16[M * K], B_bf16[K * N], C_bf16[M * N];
+
+  for (int i = 0; i < M * K; i++)
+    A_f32[i] = (float)(i % 7) * 0.125f - 0.375f;
+  for (int i = 0; i < K * N; i++)
+    B_f32[i] = (float)(i % 11) * 0.0625f - 0.3125f;
+
+  f32_array_to_bf16(A_f32, A_bf16, M * K);
+  f32_array_to_bf16(B_f32, B_bf16, K * N);
+
+  gemm_bf16(A_bf16, B_bf16, C_bf16, M, N, K);
+
+  bf16_array_to_f32(C_bf16, C_f32, M * N);
+  naive_matmul_f32(A_f32, B_f32, expected, M, N, K);
+
+  for (int i = 0; i < M * N; i++) {
+    ASSERT_NEAR(expected[i], C_f32[i], 0.05f);
+  }
+
+  PASS();
+}
+
+TEST(gemm_f16_tail_m7_n21) {
+  const int M = 7, N = 21, K = 40;
+  float A_f32[M * K], B_f32[K * N], C_f32[M * N], expected[M * N];
+  uint16_t A_f16[M * K], B_f16[K * N], C_f16[M * N];
+
+  for (int i = 0; i < M * K; i++)
+    A_f32[i] = (float)(i % 9) * 0.125f - 0.5f;
+  for (int i = 0; i < K * N; i++)
+    B_f32[i] = (float)(i % 5) * 0.25f - 0.5f;
+
+  f32_array_to_f16(A_f32, A_f16, M * K);
+  f32_array_to_f16(B_f32, B_f16, K * N);
+
+  gemm_f16(A_f16, B_f16, C_f16, M, N, K);
+
+  f16_array_to_f32(C_f16, C_f32, M * N);
+  naive_matmul_f32(A_f32, B_f32, expected, M, N, K);
+
+  for (int i = 0; i < M * N; i++) {
+    ASSERT_NEAR(expected[i], C_f32[i], 0.01f);
+  }
+
+  PASS();
+}
+
 TEST(gemm_f32_large_256x256) {
   const int M = 256, N = 256, K = 128;
   float *A = (float *)malloc(M * K * sizeof(float));
@@ -360,6 +435,162 @@ TEST(gemm_f32_large_512x256) {
   PASS();
 }
 
+/* Runs every transpose combination against naive_matmul_f32 */
+static bool check_gemm_f32_transposes(int M, int N, int K) {
+  float *A = (float *)malloc(M * K * sizeof(float));
+  float *B = (float *)malloc(K * N * sizeof(float));
+  float *At = (float *)malloc(M * K * sizeof(float));
+  float *Bt = (float *)malloc(K * N * sizeof(float));
+  float *C = (float *)malloc(M * N * sizeof(float));
+  float *expected = (float *)malloc(M * N * sizeof(float));
+
+  for (int i = 0; i < M * K; i++)
+    A[i] = (float)(i % 13) * 0.0625f - 0.375f;
+  for (int i = 0; i < K * N; i++)
+    B[i] = (float)(i % 17) * 0.03125f - 0.25f;
+  for (int i = 0; i < M; i++)
+    for (int k = 0; k < K; k++)
+      At[k * M + i] = A[i * K + k];
+  for (int k = 0; k < K; k++)
+    for (int j = 0; j < N; j++)
+      Bt[j * K + k] = B[k * N + j];
+  naive_matmul_f32(A, B, expected, M, N, K);
+
+  bool ok = true;
+  for (int combo = 0; combo < 4 && ok; combo++) {
+    bool ta = combo & 1, tb = combo & 2;
+    memset(C, 0xff, M * N * sizeof(float));
+    gemm_f32(ta ? At : A, tb ? Bt : B, C, M, N, K, ta, tb);
+    for (int i = 0; i < M * N && ok; i++)
+      ok = fabsf(expected[i] - C[i]) < 1e-3f;
+  }
+
+  free(A);
+  free(B);
+  free(At);
+  free(Bt);
+  free(C);
+  free(expected);
+  return ok;
+}
+
+TEST(gemm_f32_transposes_decode) {
+  ASSERT_TRUE(check_gemm_f32_transposes(1, 67, 45));
+  ASSERT_TRUE(check_gemm_f32_transposes(5, 33, 130));
+  PASS();
+}
+
+TEST(gemm_f32_transposes_blocked) {
+  /* K spans several KC slices; M and N leave partial micro-tiles */
+  ASSERT_TRUE(check_gemm_f32_transposes(37, 53, 600));
+  ASSERT_TRUE(check_gemm_f32_transposes(200, 700, 64));
+  PASS();
+}
+
+TEST(gemm_f16_blocked_m40_n70) {
+  const int M = 40, N = 70, K = 600;
+  float *A_f32 = (float *)malloc(M * K * sizeof(float));
+  float *B_f32 = (float *)malloc(K * N * sizeof(float));
+  float *C_f32 = (float *)malloc(M * N * sizeof(float));
+  float *expected = (float *)malloc(M * N * sizeof(float));
+  uint16_t *A_f16 = (uint16_t *)malloc(M * K * sizeof(uint16_t));
+  uint16_t *B_f16 = (uint16_t *)malloc(K * N * sizeof(uint16_t));
+  uint16_t *C_f16 = (uint16_t *)malloc(M * N * sizeof(uint16_t));
+
+  for (int i = 0; i < M * K; i++)
+    A_f32[i] = (float)(i % 9) * 0.125f - 0.5f;
+  for (int i = 0; i < K * N; i++)
+    B_f32[i] = (float)(i % 5) * 0.0625f - 0.125f;
+
+  f32_array_to_f16(A_f32, A_f16, M * K);
+  f32_array_to_f16(B_f32, B_f16, K * N);
+
+  gemm_f16(A_f16, B_f16, C_f16, M, N, K);
+
+  f16_array_to_f32(C_f16, C_f32, M * N);
+  naive_matmul_f32(A_f32, B_f32, expected, M, N, K);
+
+  /* One rounding of the F32 sum: half an FP16 ulp */
+  for (int i = 0; i < M * N; i++)
+    ASSERT_NEAR(expected[i], C_f32[i], fabsf(expected[i]) * 1e-3f + 1e-3f);
+
+  free(A_f32);
+  free(B_f32);
+  free(C_f32);
+  free(expected);
+  free(A_f16);
+  free(B_f16);
+  free(C_f16);
+  PASS();
+}
+
+TEST(gemm_bf16_blocked_m31_n70) {
+  /* Two full micro-tile heights plus a partial one, and a partial strip */
+  const int M = 31, N = 70, K = 300;
+  float *A_f32 = (float *)malloc(M * K * sizeof(float));
+  float *B_f32 = (float *)malloc(K * N * sizeof(float));
+  float *C_f32 = (float *)malloc(M * N * sizeof(float));
+  float *expected = (float *)malloc(M * N * sizeof(float));
+  uint16_t *A_bf16 = (uint16_t *)malloc(M * K * sizeof(uint16_t));
+  uint16_t *B_bf16 = (uint16_t *)malloc(K * N * sizeof(uint16_t));
+  uint16_t *C_bf16 = (uint16_t *)malloc(M * N * sizeof(uint16_t));
+
+  for (int i = 0; i < M * K; i++)
+    A_f32[i] = (float)(i % 9) * 0.125f - 0.5f;
+  for (int i = 0; i < K * N; i++)
+    B_f32[i] = (float)(i % 5) * 0.0625f - 0.125f;
+
+  f32_array_to_bf16(A_f32, A_bf16, M * K);
+  f32_array_to_bf16(B_f32, B_bf16, K * N);
+
+  gemm_bf16(A_bf16, B_bf16, C_bf16, M, N, K);
+
+  bf16_array_to_f32(C_bf16, C_f32, M * N);
+  naive_matmul_f32(A_f32, B_f32, expected, M, N, K);
+
+  /* One rounding of the F32 sum: half a BF16 ulp */
+  for (int i = 0; i < M * N; i++)
+    ASSERT_NEAR(expected[i], C_f32[i], fabsf(expected[i]) * 4e-3f + 1e-3f);
+
+  free(A_f32);
+  free(B_f32);
+  free(C_f32);
+  free(expected);
+  free(A_bf16);
+  free(B_bf16);
+  free(C_bf16);
+  PASS();
+}
+
+TEST(gemm_f32_transposed_b_multithreaded) {
+  const int M = 70, N = 300, K = 256;
+  float *A = (float *)malloc(M * K * sizeof(float));
+  float *B = (float *)malloc(N * K * sizeof(float));
+  float *C_st = (float *)malloc(M * N * sizeof(float));
+  float *C_mt = (float *)malloc(M * N * sizeof(float));
+
+  for (int i = 0; i < M * K; i++)
+    A[i] = (float)(i % 19) * 0.05f - 0.45f;
+  for (int i = 0; i < N * K; i++)
+    B[i] = (float)(i % 23) * 0.04f - 0.44f;
+
+  gemm_set_num_threads(1);
+  gemm_f32(A, B, C_st, M, N, K, false, true);
+  gemm_set_num_threads(4);
+  gemm_f32(A, B, C_mt, M, N, K, false, true);
+  gemm_set_num_threads(0);
+
+  /* Threads only change the tile shape, not the order of the K sums */
+  for (int i = 0; i < M * N; i++)
+    ASSERT_NEAR(C_st[i], C_mt[i], 0.0f);
+
+  free(A);
+  free(B);
+  free(C_st);
+  free(C_mt);
+  PASS();
+}
+
 extern "C" {
 void run_gemm_tests(void) {
   TEST_SUITE("GEMM (FP32/FP16/BF16)");
@@ -374,7 +605,15 @@ void run_gemm_tests(void) {
   RUN_TEST(gemm_f32_m1_decode_path);
   RUN_TEST(gemm_f32_exact_16x16);
   RUN_TEST(gemm_f32_tail_m23_n19);
+  RUN_TEST(gemm_bf16_tail_m7_n21);
+  RUN_TEST(gemm_f16_tail_m7_n21);
+  RUN_TEST(gemm_bf16_odd_k_m9_n40);
   RUN_TEST(gemm_f32_large_256x256);
   RUN_TEST(gemm_f32_large_512x256);
+  RUN_TEST(gemm_f32_transposes_decode);
+  RUN_TEST(gemm_f32_transposes_blocked);
+  RUN_TEST(gemm_f16_blocked_m40_n70);
+  RUN_TEST(gemm_bf16_blocked_m31_n70);
+  RUN_TEST(gemm_f32_transposed_b_multithreaded);
 }
 }
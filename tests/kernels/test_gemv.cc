@@ -0,0 +1,201 @@
+/*
+ * GEMV Kernel Tests
+ */
+
+#include "test_framework.h"
+#include "kernels/test_helper.h"
+
+extern "C" {
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/activation/activation.h"
+#include "inference/kernels/gemv/gemv.h"
+}
+
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+/*
+ * y = W x in double from the F32 values of W ([N, K], or [K, N] when
+ * transposed); mag receives sum |w x| per output for the tolerance
+ */
+static void gemv_reference(const float *W, const float *x, float *y,
+                           float *mag, int N, int K, bool transposed) {
+  for (int n = 0; n < N; n++) {
+    double sum = 0.0, abs_sum = 0.0;
+    for (int k = 0; k < K; k++) {
+      float w = transposed ? W[(size_t)k * N + n] : W[(size_t)n * K + k];
+      sum += (double)w * x[k];
+      abs_sum += fabs((double)w * x[k]);
+    }
+    y[n] = (float)sum;
+    mag[n] = (float)abs_sum;
+  }
+}
+
+/* Runs one dtype and layout against the reference on the rounded weights */
+static bool check_gemv(dtype_t dtype, int N, int K, bool transposed) {
+  std::vector<float> W((size_t)N * K), x(K), y(N), ref(N), mag(N);
+  std::vector<uint16_t> W16((size_t)N * K);
+  fill_values(W.data(), N * K, (unsigned)(N + K));
+  fill_values(x.data(), K, (unsigned)K);
+
+  if (dtype == DTYPE_F16) {
+    f32_to_f16_array(W.data(), W16.data(), W16.size());
+    f16_to_f32_array(W16.data(), W.data(), W16.size());
+    gemv_f16(W16.data(), x.data(), y.data(), N, K, transposed);
+  } else if (dtype == DTYPE_BF16) {
+    f32_to_bf16_array(W.data(), W16.data(), W16.size());
+    bf16_to_f32_array(W16.data(), W.data(), W16.size());
+    gemv_bf16(W16.data(), x.data(), y.data(), N, K, transposed);
+  } else {
+    gemv_f32(W.data(), x.data(), y.data(), N, K, transposed);
+  }
+
+  gemv_reference(W.data(), x.data(), ref.data(), mag.data(), N, K,
+                 transposed);
+  for (int n = 0; n < N; n++) {
+    if (fabsf(y[n] - ref[n]) > mag[n] * 1e-5f + 1e-6f)
+      return false;
+  }
+  return true;
+}
+
+TEST(gemv_f32_matches_reference) {
+  /* Odd sizes cover the 4-row groups, vector bodies and scalar tails */
+  ASSERT_TRUE(check_gemv(DTYPE_F32, 37, 77, false));
+  ASSERT_TRUE(check_gemv(DTYPE_F32, 37, 77, true));
+  ASSERT_TRUE(check_gemv(DTYPE_F32, 3, 5, false));
+  ASSERT_TRUE(check_gemv(DTYPE_F32, 3, 5, true));
+}
+
+TEST(gemv_f16_matches_reference) {
+  ASSERT_TRUE(check_gemv(DTYPE_F16, 64, 130, false));
+  ASSERT_TRUE(check_gemv(DTYPE_F16, 61, 130, true));
+}
+
+TEST(gemv_bf16_matches_reference) {
+  ASSERT_TRUE(check_gemv(DTYPE_BF16, 45, 96, false));
+  ASSERT_TRUE(check_gemv(DTYPE_BF16, 45, 99, true));
+}
+
+TEST(gemv_lengths_around_vector_widths) {
+  /* Rows one short of, at and one past each 8/16/32-lane step */
+  const int lengths[] = {7, 8, 9, 15, 16, 17, 31, 32, 33, 63, 64, 65, 1000};
+  const dtype_t dtypes[] = {DTYPE_F32, DTYPE_F16, DTYPE_BF16};
+  for (dtype_t dtype : dtypes) {
+    for (int len : lengths) {
+      ASSERT_TRUE(check_gemv(dtype, 9, len, false));
+      ASSERT_TRUE(check_gemv(dtype, len, 6, true));
+    }
+  }
+}
+
+TEST(gemv_transposed_spans_column_tiles) {
+  /* Wider than one accumulator strip, with a partial last strip */
+  ASSERT_TRUE(check_gemv(DTYPE_F16, 2500, 19, true));
+  ASSERT_TRUE(check_gemv(DTYPE_F32, 2500, 19, true));
+}
+
+TEST(gemv_multithreaded_matches_single) {
+  /* Large enough for the GEMV to use the pool */
+  const int N = 2050, K = 300;
+  std::vector<float> W((size_t)N * K), x(K);
+  std::vector<float> rows_st(N), rows_mt(N), cols_st(N), cols_mt(N);
+  std::vector<uint16_t> W16((size_t)N * K);
+  fill_values(W.data(), N * K, 3);
+  fill_values(x.data(), K, 4);
+  f32_to_f16_array(W.data(), W16.data(), W16.size());
+
+  threadpool_set_num_threads(1);
+  gemv_f16(W16.data(), x.data(), rows_st.data(), N, K, false);
+  gemv_f16(W16.data(), x.data(), cols_st.data(), N, K, true);
+  threadpool_set_num_threads(4);
+  gemv_f16(W16.data(), x.data(), rows_mt.data(), N, K, false);
+  gemv_f16(W16.data(), x.data(), cols_mt.data(), N, K, true);
+  threadpool_set_num_threads(0);
+
+  for (int n = 0; n < N; n++) {
+    ASSERT_NEAR(rows_st[n], rows_mt[n], 0.0f);
+    ASSERT_NEAR(cols_st[n], cols_mt[n], 0.0f);
+  }
+}
+
+TEST(gemv_dtype_keeps_activation_dtype) {
+  const int N = 40, K = 72;
+  std::vector<float> W((size_t)N * K), x(K), y(N);
+  std::vector<uint16_t> W16((size_t)N * K), x16(K), y16(N);
+  fill_values(W.data(), N * K, 5);
+  fill_values(x.data(), K, 6);
+  f32_to_f16_array(W.data(), W16.data(), W16.size());
+  f32_to_f16_array(x.data(), x16.data(), x16.size());
+  f16_to_f32_array(x16.data(), x.data(), x.size());
+
+  ASSERT_TRUE(gemv_dtype(DTYPE_F16, W16.data(), x16.data(), y16.data(), N, K));
+  gemv_f16(W16.data(), x.data(), y.data(), N, K, false);
+  for (int n = 0; n < N; n++)
+    ASSERT_EQ(f32_to_f16(y[n]), y16[n]);
+
+  ASSERT_FALSE(gemv_dtype(DTYPE_Q8_0, W16.data(), x16.data(), y16.data(), N,
+                          K));
+}
+
+TEST(gemv_empty_k_clears_output) {
+  float y[3] = {1.0f, 2.0f, 3.0f};
+  float W = 0.0f, x = 0.0f;
+  gemv_f32(&W, &x, y, 3, 0, false);
+  for (int n = 0; n < 3; n++)
+    ASSERT_NEAR(0.0f, y[n], 0.0f);
+}
+
+TEST(gemv_glu_matches_separate_projections) {
+  /* Stacked [gate | up] through the epilogue against two GEMVs */
+  const int N = 2100, K = 96;
+  std::vector<float> W((size_t)2 * N * K), Wt((size_t)2 * N * K), x(K);
+  std::vector<float> gate_up(2 * N), ref(N), y(N);
+  std::vector<uint16_t> W16(W.size()), Wt16(W.size());
+  fill_values(W.data(), 2 * N * K, 9);
+  fill_values(x.data(), K, 10);
+  f32_to_f16_array(W.data(), W16.data(), W16.size());
+  f16_to_f32_array(W16.data(), W.data(), W16.size());
+  for (int n = 0; n < 2 * N; n++)
+    for (int k = 0; k < K; k++)
+      Wt[(size_t)k * 2 * N + n] = W[(size_t)n * K + k];
+  f32_to_f16_array(Wt.data(), Wt16.data(), Wt16.size());
+
+  gemv_f32(W.data(), x.data(), gate_up.data(), 2 * N, K, false);
+  silu_and_mul_f32(ref.data(), gate_up.data(), 1, N);
+
+  for (int threads = 1; threads <= 4; threads += 3) {
+    threadpool_set_num_threads(threads);
+    gemv_glu_f32(W.data(), x.data(), y.data(), N, K, false, silu_and_mul_f32);
+    for (int n = 0; n < N; n++)
+      ASSERT_NEAR(ref[n], y[n], 1e-5f * (1.0f + fabsf(ref[n])));
+    gemv_glu_f32(Wt.data(), x.data(), y.data(), N, K, true, silu_and_mul_f32);
+    for (int n = 0; n < N; n++)
+      ASSERT_NEAR(ref[n], y[n], 1e-5f * (1.0f + fabsf(ref[n])));
+    gemv_glu_f16(W16.data(), x.data(), y.data(), N, K, false,
+                 silu_and_mul_f32);
+    for (int n = 0; n < N; n++)
+      ASSERT_NEAR(ref[n], y[n], 1e-5f * (1.0f + fabsf(ref[n])));
+    gemv_glu_f16(Wt16.data(), x.data(), y.data(), N, K, true,
+                 silu_and_mul_f32);
+    for (int n = 0; n < N; n++)
+      ASSERT_NEAR(ref[n], y[n], 1e-5f * (1.0f + fabsf(ref[n])));
+  }
+  threadpool_set_num_threads(0);
+}
+
+extern "C" void run_gemv_tests(void) {
+  TEST_SUITE("GEMV");
+  RUN_TEST(gemv_f32_matches_reference);
+  RUN_TEST(gemv_f16_matches_reference);
+  RUN_TEST(gemv_bf16_matches_reference);
+  RUN_TEST(gemv_lengths_around_vector_widths);
+  RUN_TEST(gemv_transposed_spans_column_tiles);
+  RUN_TEST(gemv_multithreaded_matches_single);
+  RUN_TEST(gemv_dtype_keeps_activation_dtype);
+  RUN_TEST(gemv_empty_k_clears_output);
+  RUN_TEST(gemv_glu_matches_separate_projections);
+}
@@ -0,0 +1,118 @@
+/*
+ * Shared fixtures for the kernel tests: a deterministic value generator and
+ * F32/F16/INT8 paged KV caches of one layer filled from it
+ */
+
+#ifndef KERNELS_TEST_HELPER_H
+#define KERNELS_TEST_HELPER_H
+
+extern "C" {
+#include "inference/core/dtype.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
+}
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* x[0, n) in [-1, 1), the same sequence for the same seed on every host */
+__attribute__((unused)) static void fill_values(float *x, size_t n,
+                                                unsigned seed) {
+  unsigned s = seed * 2654435761u + 1;
+  for (size_t i = 0; i < n; i++) {
+    s = s * 1664525u + 1013904223u;
+    x[i] = (float)(s >> 8) / (float)(1u << 24) * 2.0f - 1.0f;
+  }
+}
+
+/*
+ * Layer 1 of a two-layer paged cache, holding K/V for kv_len positions;
+ * key/value keep the values the kernels read, as [kv_len, kv_dim]
+ */
+struct paged_cache {
+  kv_page_pool_t *pool;
+  kv_block_table_t table;
+  std::vector<float> key, value;
+};
+
+/* Keys are filled from seed and values from seed + 1 */
+__attribute__((unused)) static bool make_cache(paged_cache *c, int kv_len,
+                                               int num_kv_heads, int head_dim,
+                                               bool f16, unsigned seed) {
+  size_t count = (size_t)kv_len * num_kv_heads * head_dim;
+  c->key.resize(count);
+  c->value.resize(count);
+  fill_values(c->key.data(), count, seed);
+  fill_values(c->value.data(), count, seed + 1);
+
+  c->pool = kv_page_pool_create(2, num_kv_heads, head_dim,
+                                f16 ? sizeof(uint16_t) : sizeof(float), 0, 0);
+  if (!c->pool)
+    return false;
+  kv_block_table_init(&c->table, c->pool);
+  if (!kv_block_table_reserve(&c->table, kv_len))
+    return false;
+
+  if (f16) {
+    std::vector<uint16_t> k16(count), v16(count);
+    f32_to_f16_array(c->key.data(), k16.data(), count);
+    f32_to_f16_array(c->value.data(), v16.data(), count);
+    f16_to_f32_array(k16.data(), c->key.data(), count);
+    f16_to_f32_array(v16.data(), c->value.data(), count);
+    kv_cache_append_paged_f16(&c->table, 1, k16.data(), v16.data(), 0,
+                              kv_len);
+  } else {
+    kv_cache_append_paged_f32(&c->table, 1, c->key.data(), c->value.data(),
+                              0, kv_len);
+  }
+  c->table.len = kv_len;
+  return true;
+}
+
+/*
+ * INT8 cache of one layer; key/value receive the dequantized values the
+ * kernels read, so the reference sees the same inputs
+ */
+__attribute__((unused)) static bool make_cache_q8(paged_cache *c, int kv_len,
+                                                  int num_kv_heads,
+                                                  int head_dim,
+                                                  unsigned seed) {
+  size_t count = (size_t)kv_len * num_kv_heads * head_dim;
+  c->key.resize(count);
+  c->value.resize(count);
+  fill_values(c->key.data(), count, seed);
+  fill_values(c->value.data(), count, seed + 1);
+
+  c->pool =
+      kv_page_pool_create(2, num_kv_heads, head_dim, KV_CACHE_INT8, 0, 0);
+  if (!c->pool)
+    return false;
+  kv_block_table_init(&c->table, c->pool);
+  if (!kv_block_table_reserve(&c->table, kv_len))
+    return false;
+  kv_cache_append_paged_f32(&c->table, 1, c->key.data(), c->value.data(), 0,
+                            kv_len);
+  c->table.len = kv_len;
+
+  for (int t = 0; t < kv_len; t++) {
+    const int8_t *k = (const int8_t *)kv_block_table_key(&c->table, 1, t);
+    const int8_t *v = (const int8_t *)kv_block_table_value(&c->table, 1, t);
+    const float *ks = kv_block_table_key_scales(&c->table, 1, t);
+    const float *vs = kv_block_table_value_scales(&c->table, 1, t);
+    for (int h = 0; h < num_kv_heads; h++) {
+      for (int d = 0; d < head_dim; d++) {
+        size_t i = (size_t)h * head_dim + d;
+        c->key[(size_t)t * num_kv_heads * head_dim + i] = k[i] * ks[h];
+        c->value[(size_t)t * num_kv_heads * head_dim + i] = v[i] * vs[h];
+      }
+    }
+  }
+  return true;
+}
+
+__attribute__((unused)) static void free_cache(paged_cache *c) {
+  kv_block_table_free(&c->table);
+  kv_page_pool_destroy(c->pool);
+}
+
+#endif
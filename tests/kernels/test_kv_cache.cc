@@ -6,6 +6,8 @@
 
 extern "C" {
 #include "inference/kernels/kv_cache/kv_cache.h"
+#include "inference/kernels/kv_cache/paged_kv.h"
+#include "inference/kernels/kv_cache/prefix_cache.h"
 }
 
 #include <cmath>
@@ -239,6 +241,389 @@ TEST(kv_cache_f32_large) {
   free(value);
 }
 
+TEST(paged_kv_alloc_and_reuse) {
+  kv_page_pool_t *pool = kv_page_pool_create(2, 2, 4, sizeof(float), 4, 0);
+  ASSERT_NOT_NULL(pool);
+  ASSERT_EQ(4, kv_page_pool_page_tokens(pool));
+
+  int a = kv_page_pool_alloc(pool);
+  int b = kv_page_pool_alloc(pool);
+  ASSERT_TRUE(a >= 0 && b >= 0 && a != b);
+  ASSERT_EQ(2, kv_page_pool_pages_in_use(pool));
+
+  kv_page_pool_ref(pool, a);
+  ASSERT_EQ(2, kv_page_pool_refcount(pool, a));
+  kv_page_pool_unref(pool, a);
+  ASSERT_EQ(2, kv_page_pool_pages_in_use(pool));
+  kv_page_pool_unref(pool, a);
+  ASSERT_EQ(1, kv_page_pool_pages_in_use(pool));
+
+  /* A freed page is handed out again before the pool grows */
+  ASSERT_EQ(a, kv_page_pool_alloc(pool));
+  kv_page_pool_unref(pool, a);
+  kv_page_pool_unref(pool, b);
+  ASSERT_EQ(0, kv_page_pool_pages_in_use(pool));
+  ASSERT_TRUE(kv_page_pool_bytes(pool) > 0);
+
+  kv_page_pool_trim(pool);
+  ASSERT_EQ(0, (int)kv_page_pool_bytes(pool));
+  ASSERT_TRUE(kv_page_pool_alloc(pool) >= 0);
+  ASSERT_TRUE(kv_page_pool_bytes(pool) > 0);
+
+  kv_page_pool_destroy(pool);
+}
+
+TEST(paged_kv_reserve_and_truncate) {
+  kv_page_pool_t *pool = kv_page_pool_create(1, 1, 8, sizeof(float), 4, 3);
+  ASSERT_NOT_NULL(pool);
+
+  kv_block_table_t table;
+  kv_block_table_init(&table, pool);
+  ASSERT_TRUE(kv_block_table_reserve(&table, 5));
+  ASSERT_EQ(2, table.num_blocks);
+  ASSERT_TRUE(kv_block_table_reserve(&table, 8));
+  ASSERT_EQ(2, table.num_blocks);
+  ASSERT_TRUE(kv_block_table_reserve(&table, 12));
+  ASSERT_EQ(3, table.num_blocks);
+
+  /* max_pages caps the pool */
+  ASSERT_FALSE(kv_block_table_reserve(&table, 13));
+  ASSERT_EQ(3, kv_page_pool_pages_in_use(pool));
+
+  table.len = 12;
+  kv_block_table_truncate(&table, 5);
+  ASSERT_EQ(5, table.len);
+  ASSERT_EQ(2, table.num_blocks);
+  ASSERT_EQ(2, kv_page_pool_pages_in_use(pool));
+
+  kv_block_table_free(&table);
+  ASSERT_EQ(0, kv_page_pool_pages_in_use(pool));
+  kv_page_pool_destroy(pool);
+}
+
+TEST(paged_kv_append_matches_contiguous) {
+  const int num_layers = 2;
+  const int num_heads = 2;
+  const int head_dim = 8;
+  const int kv_dim = num_heads * head_dim;
+  const int total = 23;
+
+  kv_page_pool_t *pool =
+      kv_page_pool_create(num_layers, num_heads, head_dim, sizeof(float), 4, 0);
+  ASSERT_NOT_NULL(pool);
+  kv_block_table_t table;
+  kv_block_table_init(&table, pool);
+
+  float *key = (float *)malloc(total * kv_dim * sizeof(float));
+  float *value = (float *)malloc(total * kv_dim * sizeof(float));
+  for (int i = 0; i < total * kv_dim; i++) {
+    key[i] = (float)i * 0.25f;
+    value[i] = -(float)i * 0.5f;
+  }
+
+  /* Uneven chunks so that appends start and end mid-page */
+  const int chunks[] = {3, 6, 1, 13};
+  int start = 0;
+  for (int c = 0; c < 4; c++) {
+    ASSERT_TRUE(kv_block_table_reserve(&table, start + chunks[c]));
+    for (int layer = 0; layer < num_layers; layer++)
+      kv_cache_append_paged_f32(&table, layer, key + start * kv_dim,
+                                value + start * kv_dim, start, chunks[c]);
+    start += chunks[c];
+    table.len = start;
+  }
+  ASSERT_EQ(total, table.len);
+  ASSERT_EQ(6, table.num_blocks);
+
+  for (int layer = 0; layer < num_layers; layer++) {
+    for (int pos = 0; pos < total; pos++) {
+      const float *k =
+          (const float *)kv_block_table_key(&table, layer, pos);
+      const float *v =
+          (const float *)kv_block_table_value(&table, layer, pos);
+      ASSERT_ARRAY_NEAR(key + pos * kv_dim, k, kv_dim, 0.0f);
+      ASSERT_ARRAY_NEAR(value + pos * kv_dim, v, kv_dim, 0.0f);
+    }
+  }
+
+  kv_block_table_free(&table);
+  kv_page_pool_destroy(pool);
+  free(key);
+  free(value);
+}
+
+TEST(paged_kv_shared_pages) {
+  kv_page_pool_t *pool = kv_page_pool_create(1, 1, 4, sizeof(float), 4, 0);
+  ASSERT_NOT_NULL(pool);
+
+  kv_block_table_t a, b;
+  kv_block_table_init(&a, pool);
+  kv_block_table_init(&b, pool);
+  ASSERT_TRUE(kv_block_table_reserve(&a, 8));
+  ASSERT_TRUE(kv_block_table_reserve(&b, 8));
+  ASSERT_EQ(4, kv_page_pool_pages_in_use(pool));
+
+  /* Two sequences on one pool never share pages unless asked to */
+  for (int i = 0; i < a.num_blocks; i++)
+    for (int j = 0; j < b.num_blocks; j++)
+      ASSERT_TRUE(a.blocks[i] != b.blocks[j]);
+
+  kv_page_pool_ref(pool, a.blocks[0]);
+  kv_block_table_free(&a);
+  ASSERT_EQ(3, kv_page_pool_pages_in_use(pool));
+  kv_block_table_free(&b);
+  ASSERT_EQ(1, kv_page_pool_pages_in_use(pool));
+
+  kv_page_pool_destroy(pool);
+}
+
+/* Fill positions [0, len) of every layer with values naming the position */
+static void fill_positions(kv_block_table_t *table, int len) {
+  const kv_page_pool_t *pool = table->pool;
+  int kv_dim = pool->num_kv_heads * pool->head_dim;
+  for (int layer = 0; layer < pool->num_layers; layer++) {
+    for (int pos = 0; pos < len; pos++) {
+      float *k = (float *)kv_block_table_key(table, layer, pos);
+      float *v = (float *)kv_block_table_value(table, layer, pos);
+      for (int i = 0; i < kv_dim; i++) {
+        k[i] = (float)(layer * 1000 + pos);
+        v[i] = -(float)(layer * 1000 + pos);
+      }
+    }
+  }
+  table->len = len;
+}
+
+static bool holds_position(const kv_block_table_t *table, int pos,
+                           int original) {
+  const kv_page_pool_t *pool = table->pool;
+  for (int layer = 0; layer < pool->num_layers; layer++) {
+    const float *k = (const float *)kv_block_table_key(table, layer, pos);
+    const float *v = (const float *)kv_block_table_value(table, layer, pos);
+    if (k[0] != (float)(layer * 1000 + original) ||
+        v[pool->head_dim] != -(float)(layer * 1000 + original))
+      return false;
+  }
+  return true;
+}
+
+TEST(paged_kv_remove_moves_later_positions) {
+  kv_page_pool_t *pool = kv_page_pool_create(2, 2, 4, sizeof(float), 4, 0);
+  ASSERT_NOT_NULL(pool);
+  kv_block_table_t table, other;
+  kv_block_table_init(&table, pool);
+  kv_block_table_init(&other, pool);
+  ASSERT_TRUE(kv_block_table_reserve(&table, 14));
+  fill_positions(&table, 14);
+
+  /* Another table shares page 1, which the removal rewrites */
+  ASSERT_TRUE(kv_block_table_append_page(&other, table.blocks[1]));
+  other.len = 4;
+
+  ASSERT_FALSE(kv_block_table_remove(&table, 10, 5));
+  ASSERT_TRUE(kv_block_table_remove(&table, 3, 5));
+  ASSERT_EQ(9, table.len);
+  ASSERT_EQ(3, table.num_blocks);
+  for (int pos = 0; pos < 3; pos++)
+    ASSERT_TRUE(holds_position(&table, pos, pos));
+  for (int pos = 3; pos < 9; pos++)
+    ASSERT_TRUE(holds_position(&table, pos, pos + 5));
+  ASSERT_TRUE(table.blocks[1] != other.blocks[0]);
+  for (int pos = 0; pos < 4; pos++)
+    ASSERT_TRUE(holds_position(&other, pos, pos + 4));
+
+  /* Whole pages are unmapped instead of copied */
+  int third = table.blocks[2];
+  ASSERT_TRUE(kv_block_table_remove(&table, 4, 4));
+  ASSERT_EQ(5, table.len);
+  ASSERT_EQ(2, table.num_blocks);
+  ASSERT_EQ(third, table.blocks[1]);
+  for (int pos = 4; pos < 5; pos++)
+    ASSERT_TRUE(holds_position(&table, pos, pos + 9));
+
+  kv_block_table_free(&table);
+  kv_block_table_free(&other);
+  ASSERT_EQ(0, kv_page_pool_pages_in_use(pool));
+  kv_page_pool_destroy(pool);
+}
+
+TEST(paged_kv_int8_layers_keep_their_scales) {
+  const int num_heads = 2, head_dim = 64, kv_dim = num_heads * head_dim;
+  kv_page_pool_t *f16 =
+      kv_page_pool_create(2, num_heads, head_dim, sizeof(uint16_t), 16, 0);
+  kv_page_pool_t *pool =
+      kv_page_pool_create(2, num_heads, head_dim, KV_CACHE_INT8, 16, 0);
+  ASSERT_NOT_NULL(f16);
+  ASSERT_NOT_NULL(pool);
+  /* Values plus one float per head and position: about half of FP16 */
+  ASSERT_TRUE(kv_page_pool_page_bytes(pool) * 100 <=
+              kv_page_pool_page_bytes(f16) * 54);
+
+  kv_block_table_t table;
+  kv_block_table_init(&table, pool);
+  ASSERT_TRUE(kv_block_table_reserve(&table, 20));
+
+  /* Each layer and head gets its own range, so the scales differ */
+  float key[20 * kv_dim], value[20 * kv_dim];
+  for (int layer = 0; layer < 2; layer++) {
+    for (int i = 0; i < 20 * kv_dim; i++) {
+      float mag = (float)(1 + layer * 4 + (i / head_dim) % num_heads);
+      key[i] = mag * (float)(i % 7 - 3) / 3.0f;
+      value[i] = -mag * (float)(i % 5 - 2) / 2.0f;
+    }
+    kv_cache_append_paged_f32(&table, layer, key, value, 0, 20);
+  }
+
+  for (int pos = 0; pos < 20; pos++) {
+    const int8_t *k = (const int8_t *)kv_block_table_key(&table, 1, pos);
+    const int8_t *v = (const int8_t *)kv_block_table_value(&table, 1, pos);
+    const float *ks = kv_block_table_key_scales(&table, 1, pos);
+    const float *vs = kv_block_table_value_scales(&table, 1, pos);
+    for (int i = 0; i < kv_dim; i++) {
+      int h = i / head_dim;
+      ASSERT_NEAR(key[pos * kv_dim + i], k[i] * ks[h], ks[h] * 0.5f);
+      ASSERT_NEAR(value[pos * kv_dim + i], v[i] * vs[h], vs[h] * 0.5f);
+    }
+    ASSERT_NEAR((float)(5 + 1) / 127.0f, ks[1], 1e-6f);
+  }
+
+  kv_block_table_free(&table);
+  kv_page_pool_destroy(pool);
+  kv_page_pool_destroy(f16);
+}
+
+TEST(prefix_cache_match_and_insert) {
+  const int head_dim = 4;
+  kv_page_pool_t *pool =
+      kv_page_pool_create(1, 1, head_dim, sizeof(float), 4, 0);
+  ASSERT_NOT_NULL(pool);
+  kv_prefix_cache_t *cache = kv_prefix_cache_create(pool, 0);
+  ASSERT_NOT_NULL(cache);
+
+  int tokens[10];
+  float kv[10 * head_dim];
+  for (int i = 0; i < 10; i++)
+    tokens[i] = 100 + i;
+  for (int i = 0; i < 10 * head_dim; i++)
+    kv[i] = (float)i;
+
+  kv_block_table_t a;
+  kv_block_table_init(&a, pool);
+  ASSERT_TRUE(kv_block_table_reserve(&a, 10));
+  kv_cache_append_paged_f32(&a, 0, kv, kv, 0, 10);
+  a.len = 10;
+
+  /* Only the two full pages are cached */
+  kv_prefix_cache_insert(cache, &a, tokens, 10);
+  kv_prefix_cache_stats_t stats;
+  kv_prefix_cache_get_stats(cache, &stats);
+  ASSERT_EQ(2, stats.cached_pages);
+
+  kv_block_table_t b;
+  kv_block_table_init(&b, pool);
+  ASSERT_EQ(8, kv_prefix_cache_match(cache, &b, tokens, 9));
+  ASSERT_EQ(8, b.len);
+  ASSERT_EQ(a.blocks[0], b.blocks[0]);
+  ASSERT_EQ(a.blocks[1], b.blocks[1]);
+  ASSERT_EQ(3, kv_page_pool_refcount(pool, a.blocks[1]));
+  kv_block_table_free(&b);
+
+  /* A prompt that diverges in the second page reuses the first one */
+  int other[10];
+  memcpy(other, tokens, sizeof(other));
+  other[5] = 7;
+  kv_block_table_init(&b, pool);
+  ASSERT_EQ(4, kv_prefix_cache_match(cache, &b, other, 9));
+
+  /* Writing past a shared page copies it first */
+  kv_block_table_truncate(&b, 2);
+  ASSERT_TRUE(kv_block_table_reserve(&b, 4));
+  ASSERT_TRUE(b.blocks[0] != a.blocks[0]);
+  ASSERT_EQ(2, kv_page_pool_refcount(pool, a.blocks[0]));
+  float fresh[2 * head_dim] = {0};
+  kv_cache_append_paged_f32(&b, 0, fresh, fresh, 2, 2);
+  ASSERT_ARRAY_NEAR(kv + head_dim,
+                    (const float *)kv_block_table_key(&b, 0, 1), head_dim,
+                    0.0f);
+  ASSERT_ARRAY_NEAR(kv + 2 * head_dim,
+                    (const float *)kv_block_table_key(&a, 0, 2), head_dim,
+                    0.0f);
+  kv_block_table_free(&b);
+
+  /* Too short for a full page */
+  kv_block_table_init(&b, pool);
+  ASSERT_EQ(0, kv_prefix_cache_match(cache, &b, tokens, 3));
+  ASSERT_EQ(0, b.num_blocks);
+
+  kv_prefix_cache_get_stats(cache, &stats);
+  ASSERT_EQ(3, (int)stats.lookups);
+  ASSERT_EQ(2, (int)stats.hits);
+  ASSERT_EQ(1, (int)stats.misses);
+  ASSERT_EQ(12, (int)stats.hit_tokens);
+  ASSERT_EQ(9, (int)stats.miss_tokens);
+
+  /* The cache keeps its pages after the sequence is gone */
+  kv_block_table_free(&a);
+  ASSERT_EQ(2, kv_page_pool_pages_in_use(pool));
+  kv_prefix_cache_destroy(cache);
+  ASSERT_EQ(0, kv_page_pool_pages_in_use(pool));
+  kv_page_pool_destroy(pool);
+}
+
+static void insert_prefix(kv_prefix_cache_t *cache, kv_page_pool_t *pool,
+                          const int *tokens, int num_tokens) {
+  kv_block_table_t table;
+  kv_block_table_init(&table, pool);
+  kv_block_table_reserve(&table, num_tokens);
+  table.len = num_tokens;
+  kv_prefix_cache_insert(cache, &table, tokens, num_tokens);
+  kv_block_table_free(&table);
+}
+
+TEST(prefix_cache_lru_eviction) {
+  kv_page_pool_t *pool = kv_page_pool_create(1, 1, 4, sizeof(float), 4, 0);
+  ASSERT_NOT_NULL(pool);
+  kv_prefix_cache_t *cache = kv_prefix_cache_create(pool, 2);
+  ASSERT_NOT_NULL(cache);
+
+  int a[4] = {1, 2, 3, 4};
+  int b[4] = {5, 6, 7, 8};
+  int c[4] = {9, 10, 11, 12};
+  insert_prefix(cache, pool, a, 4);
+  insert_prefix(cache, pool, b, 4);
+
+  /* Using a makes b the least recently used page */
+  kv_block_table_t table;
+  kv_block_table_init(&table, pool);
+  ASSERT_EQ(4, kv_prefix_cache_match(cache, &table, a, 4));
+  kv_block_table_free(&table);
+
+  insert_prefix(cache, pool, c, 4);
+  kv_prefix_cache_stats_t stats;
+  kv_prefix_cache_get_stats(cache, &stats);
+  ASSERT_EQ(2, stats.cached_pages);
+  ASSERT_EQ(1, (int)stats.evicted);
+  ASSERT_EQ(2, kv_page_pool_pages_in_use(pool));
+
+  kv_block_table_init(&table, pool);
+  ASSERT_EQ(0, kv_prefix_cache_match(cache, &table, b, 4));
+  ASSERT_EQ(4, kv_prefix_cache_match(cache, &table, c, 4));
+  kv_block_table_free(&table);
+
+  /* Inner pages go only after the pages that extend them */
+  int ab[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+  insert_prefix(cache, pool, ab, 8);
+  ASSERT_EQ(1, kv_prefix_cache_evict(cache, 1));
+  kv_block_table_init(&table, pool);
+  ASSERT_EQ(4, kv_prefix_cache_match(cache, &table, ab, 8));
+  kv_block_table_free(&table);
+
+  kv_prefix_cache_clear(cache);
+  ASSERT_EQ(0, kv_page_pool_pages_in_use(pool));
+  kv_prefix_cache_destroy(cache);
+  kv_page_pool_destroy(pool);
+}
+
 extern "C" void run_kv_cache_tests(void) {
   TEST_SUITE("KV Cache");
   RUN_TEST(kv_cache_f32_single_token);
@@ -247,4 +632,12 @@ extern "C" void run_kv_cache_tests(void) {
   RUN_TEST(kv_cache_bf16_basic);
   RUN_TEST(kv_cache_f16_basic);
   RUN_TEST(kv_cache_f32_large);
+  RUN_TEST(paged_kv_alloc_and_reuse);
+  RUN_TEST(paged_kv_reserve_and_truncate);
+  RUN_TEST(paged_kv_append_matches_contiguous);
+  RUN_TEST(paged_kv_shared_pages);
+  RUN_TEST(paged_kv_remove_moves_later_positions);
+  RUN_TEST(paged_kv_int8_layers_keep_their_scales);
+  RUN_TEST(prefix_cache_match_and_insert);
+  RUN_TEST(prefix_cache_lru_eviction);
 }
@@ -12,6 +12,7 @@ extern "C" {
 #include <cmath>
 #include <cstring>
 #include <string>
+#include <vector>
 
 static safetensors::safetensors_t g_st;
 static bool g_loaded = false;
@@ -355,6 +356,115 @@ static void run_kv_cache_f16_test(const char *case_name) {
   free(value_cache);
 }
 
+/*
+ * Largest error of an INT8 cache against the reference, relative to the
+ * largest magnitude of each head (the quantization step is amax / 127)
+ */
+static float compute_max_q8_error(const float *expected, const int8_t *cache,
+                                  const float *scales, int rows,
+                                  int head_dim) {
+  float max_err = 0.0f;
+  for (int r = 0; r < rows; r++) {
+    const float *e = expected + (size_t)r * head_dim;
+    const int8_t *q = cache + (size_t)r * head_dim;
+    float amax = 0.0f;
+    for (int d = 0; d < head_dim; d++)
+      amax = fmaxf(amax, fabsf(e[d]));
+    for (int d = 0; d < head_dim; d++) {
+      float err = fabsf(e[d] - (float)q[d] * scales[r]);
+      float rel_err = amax > 0.0f ? err / amax : err;
+      if (rel_err > max_err)
+        max_err = rel_err;
+    }
+  }
+  return max_err;
+}
+
+/*
+ * The reference cache contents (prefix and new tokens) go through the INT8
+ * appends; a quantized element may be off by half a step, 1/254 of the
+ * head's largest magnitude
+ */
+static void run_kv_cache_q8_test(const char *case_name, bool f16_input) {
+  if (!load_reference_data()) {
+    ASSERT(false);
+    return;
+  }
+
+  std::string f32_prefix = std::string("f32_") + case_name;
+  std::string prefix = (f16_input ? "f16_" : "f32_") + std::string(case_name);
+  size_t key_count, value_count, cache_out_count;
+
+  int cache_len = get_metadata_int(f32_prefix + "_cache_len");
+  int num_tokens = get_metadata_int(f32_prefix + "_num_tokens");
+  int num_heads = get_metadata_int(f32_prefix + "_num_heads");
+  int head_dim = get_metadata_int(f32_prefix + "_head_dim");
+  int total_len = cache_len + num_tokens;
+  size_t total_size = (size_t)total_len * num_heads * head_dim;
+
+  std::vector<int8_t> key_cache(total_size), value_cache(total_size);
+  std::vector<float> key_scales((size_t)total_len * num_heads);
+  std::vector<float> value_scales((size_t)total_len * num_heads);
+  std::vector<float> expected_key(total_size), expected_value(total_size);
+
+  if (f16_input) {
+    const uint16_t *key =
+        get_f16_tensor(prefix + "_key_cache_out", &cache_out_count);
+    const uint16_t *value =
+        get_f16_tensor(prefix + "_value_cache_out", &cache_out_count);
+    if (!key || !value || cache_out_count != total_size) {
+      printf("Missing tensors for %s\n", case_name);
+      ASSERT(false);
+      return;
+    }
+    /* Prefix and new tokens in two appends, as a prefill would */
+    kv_cache_append_q8_f16(key_cache.data(), key_scales.data(),
+                           value_cache.data(), value_scales.data(), key,
+                           value, 0, cache_len, num_heads, head_dim);
+    size_t offset = (size_t)cache_len * num_heads * head_dim;
+    kv_cache_append_q8_f16(key_cache.data(), key_scales.data(),
+                           value_cache.data(), value_scales.data(),
+                           key + offset, value + offset, cache_len,
+                           num_tokens, num_heads, head_dim);
+    for (size_t i = 0; i < total_size; i++) {
+      expected_key[i] = fp16_to_float_scalar(key[i]);
+      expected_value[i] = fp16_to_float_scalar(value[i]);
+    }
+  } else {
+    const float *key =
+        get_f32_tensor(prefix + "_key_cache_out", &cache_out_count);
+    const float *value =
+        get_f32_tensor(prefix + "_value_cache_out", &cache_out_count);
+    const float *new_key = get_f32_tensor(prefix + "_key", &key_count);
+    const float *new_value = get_f32_tensor(prefix + "_value", &value_count);
+    if (!key || !value || !new_key || !new_value ||
+        cache_out_count != total_size) {
+      printf("Missing tensors for %s\n", case_name);
+      ASSERT(false);
+      return;
+    }
+    kv_cache_append_q8_f32(key_cache.data(), key_scales.data(),
+                           value_cache.data(), value_scales.data(), key,
+                           value, 0, cache_len, num_heads, head_dim);
+    kv_cache_append_q8_f32(key_cache.data(), key_scales.data(),
+                           value_cache.data(), value_scales.data(), new_key,
+                           new_value, cache_len, num_tokens, num_heads,
+                           head_dim);
+    memcpy(expected_key.data(), key, total_size * sizeof(float));
+    memcpy(expected_value.data(), value, total_size * sizeof(float));
+  }
+
+  int rows = total_len * num_heads;
+  float max_err_key = compute_max_q8_error(
+      expected_key.data(), key_cache.data(), key_scales.data(), rows, head_dim);
+  float max_err_value =
+      compute_max_q8_error(expected_value.data(), value_cache.data(),
+                           value_scales.data(), rows, head_dim);
+
+  ASSERT_LT(max_err_key, 1.0f / 254.0f + 1e-6f);
+  ASSERT_LT(max_err_value, 1.0f / 254.0f + 1e-6f);
+}
+
 TEST(kv_cache_pytorch_f32_small) { run_kv_cache_f32_test("small"); }
 TEST(kv_cache_pytorch_f32_medium) { run_kv_cache_f32_test("medium"); }
 TEST(kv_cache_pytorch_f32_large) { run_kv_cache_f32_test("large"); }
@@ -373,6 +483,11 @@ TEST(kv_cache_pytorch_f16_small) { run_kv_cache_f16_test("small"); }
 TEST(kv_cache_pytorch_f16_medium) { run_kv_cache_f16_test("medium"); }
 TEST(kv_cache_pytorch_f16_large) { run_kv_cache_f16_test("large"); }
 
+TEST(kv_cache_pytorch_q8_f32_small) { run_kv_cache_q8_test("small", false); }
+TEST(kv_cache_pytorch_q8_f32_large) { run_kv_cache_q8_test("large", false); }
+TEST(kv_cache_pytorch_q8_f16_medium) { run_kv_cache_q8_test("medium", true); }
+TEST(kv_cache_pytorch_q8_f16_large) { run_kv_cache_q8_test("large", true); }
+
 extern "C" void run_kv_cache_pytorch_tests(void) {
   TEST_SUITE("KV Cache PyTorch Accuracy");
   RUN_TEST(kv_cache_pytorch_f32_small);
@@ -386,4 +501,8 @@ extern "C" void run_kv_cache_pytorch_tests(void) {
   RUN_TEST(kv_cache_pytorch_f16_small);
   RUN_TEST(kv_cache_pytorch_f16_medium);
   RUN_TEST(kv_cache_pytorch_f16_large);
+  RUN_TEST(kv_cache_pytorch_q8_f32_small);
+  RUN_TEST(kv_cache_pytorch_q8_f32_large);
+  RUN_TEST(kv_cache_pytorch_q8_f16_medium);
+  RUN_TEST(kv_cache_pytorch_q8_f16_large);
 }
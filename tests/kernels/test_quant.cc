@@ -0,0 +1,239 @@
+/*
+ * Block-Quantized Weight Tests (Q8_0 / Q4_0)
+ */
+
+#include "test_framework.h"
+#include "kernels/test_helper.h"
+
+extern "C" {
+#include "inference/backend/threadpool.h"
+#include "inference/core/dtype.h"
+#include "inference/kernels/quant/quant.h"
+#include "inference/kernels/quant/quant_kernels.h"
+}
+
+#include <cmath>
+#include <vector>
+
+/* Deterministic values in [-scale, scale) with varying block maxima */
+static void fill_values(float *x, int n, unsigned seed, float scale) {
+  fill_values(x, (size_t)n, seed);
+  for (int i = 0; i < n; i++)
+    x[i] = x[i] * scale * (1.0f + (float)((i / 32) % 4));
+}
+
+static float block_amax(const float *x) {
+  float amax = 0.0f;
+  for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+    amax = fmaxf(amax, fabsf(x[j]));
+  return amax;
+}
+
+TEST(quant_block_sizes) {
+  ASSERT_EQ_SIZE((size_t)34, sizeof(block_q8_0_t));
+  ASSERT_EQ_SIZE((size_t)18, sizeof(block_q4_0_t));
+  ASSERT_EQ_SIZE((size_t)34 * 4, dtype_nbytes(DTYPE_Q8_0, 128));
+  ASSERT_EQ_SIZE((size_t)18 * 4, dtype_nbytes(DTYPE_Q4_0, 128));
+  ASSERT_EQ_SIZE((size_t)0, dtype_size(DTYPE_Q8_0));
+  ASSERT_TRUE(dtype_is_quantized(DTYPE_Q4_0));
+  ASSERT_FALSE(dtype_is_quantized(DTYPE_F16));
+}
+
+TEST(quant_q8_0_round_trip) {
+  const int k = 256;
+  std::vector<float> x(k), y(k);
+  std::vector<block_q8_0_t> q(k / QUANT_BLOCK_SIZE);
+  fill_values(x.data(), k, 1, 0.7f);
+
+  quantize_row_q8_0(x.data(), q.data(), k);
+  dequantize_row_q8_0(q.data(), y.data(), k);
+
+  for (int b = 0; b < k / QUANT_BLOCK_SIZE; b++) {
+    const float *xb = x.data() + b * QUANT_BLOCK_SIZE;
+    /* Half a step of rounding plus the FP16 scale error */
+    float tol = block_amax(xb) / 127.0f * 0.5f + block_amax(xb) * 1e-3f;
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+      ASSERT_NEAR(xb[j], y[b * QUANT_BLOCK_SIZE + j], tol);
+  }
+}
+
+TEST(quant_q4_0_round_trip) {
+  const int k = 256;
+  std::vector<float> x(k), y(k);
+  std::vector<block_q4_0_t> q(k / QUANT_BLOCK_SIZE);
+  fill_values(x.data(), k, 2, 0.7f);
+
+  quantize_row_q4_0(x.data(), q.data(), k);
+  dequantize_row_q4_0(q.data(), y.data(), k);
+
+  for (int b = 0; b < k / QUANT_BLOCK_SIZE; b++) {
+    const float *xb = x.data() + b * QUANT_BLOCK_SIZE;
+    /* One step: the side opposite the extreme value clamps at +7 */
+    float tol = block_amax(xb) / 8.0f * 1.01f;
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+      ASSERT_NEAR(xb[j], y[b * QUANT_BLOCK_SIZE + j], tol);
+  }
+}
+
+TEST(quant_zero_block_stays_zero) {
+  float x[QUANT_BLOCK_SIZE] = {0};
+  float y[QUANT_BLOCK_SIZE];
+  block_q8_0_t q8;
+  block_q4_0_t q4;
+
+  quantize_row_q8_0(x, &q8, QUANT_BLOCK_SIZE);
+  dequantize_row_q8_0(&q8, y, QUANT_BLOCK_SIZE);
+  for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+    ASSERT_NEAR(0.0f, y[j], 0.0f);
+
+  quantize_row_q4_0(x, &q4, QUANT_BLOCK_SIZE);
+  dequantize_row_q4_0(&q4, y, QUANT_BLOCK_SIZE);
+  for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+    ASSERT_NEAR(0.0f, y[j], 0.0f);
+}
+
+TEST(quant_rows_reject_partial_blocks) {
+  std::vector<float> x(48);
+  std::vector<uint8_t> q(dtype_nbytes(DTYPE_Q8_0, 64));
+  ASSERT_FALSE(quantize_rows(DTYPE_Q8_0, x.data(), q.data(), 1, 48));
+  ASSERT_FALSE(quantize_rows(DTYPE_F16, x.data(), q.data(), 1, 32));
+}
+
+/*
+ * The GEMM quantizes the activations to Q8_0 too, so compare against the
+ * exact product with the dequantized weights, scaled by sum |a * w|.
+ */
+static void check_gemm_f32(dtype_t w_dtype, int M, int N, int K) {
+  std::vector<float> A(M * K), W(N * K), Wd(N * K), C(M * N);
+  std::vector<uint8_t> Wq(dtype_nbytes(w_dtype, (size_t)N * K));
+  fill_values(A.data(), M * K, 3, 1.0f);
+  fill_values(W.data(), N * K, 4, 0.05f);
+
+  ASSERT_TRUE(quantize_rows(w_dtype, W.data(), Wq.data(), N, K));
+  ASSERT_TRUE(dequantize_rows(w_dtype, Wq.data(), Wd.data(), N, K));
+  gemm_quant_f32(A.data(), Wq.data(), w_dtype, C.data(), M, N, K);
+
+  for (int m = 0; m < M; m++) {
+    for (int n = 0; n < N; n++) {
+      double ref = 0.0, mag = 0.0;
+      for (int k = 0; k < K; k++) {
+        ref += (double)A[m * K + k] * Wd[n * K + k];
+        mag += fabs((double)A[m * K + k] * Wd[n * K + k]);
+      }
+      ASSERT_NEAR((float)ref, C[m * N + n], (float)(mag * 0.01) + 1e-5f);
+    }
+  }
+}
+
+TEST(quant_gemm_q8_0_f32_matches_reference) {
+  check_gemm_f32(DTYPE_Q8_0, 5, 40, 96);
+}
+
+TEST(quant_gemm_q4_0_f32_matches_reference) {
+  check_gemm_f32(DTYPE_Q4_0, 5, 40, 96);
+}
+
+TEST(quant_gemm_f16_matches_f32) {
+  const int M = 3, N = 24, K = 64;
+  std::vector<float> A(M * K), W(N * K), C32(M * N);
+  std::vector<uint16_t> A16(M * K), C16(M * N);
+  std::vector<uint8_t> Wq(dtype_nbytes(DTYPE_Q4_0, (size_t)N * K));
+  fill_values(A.data(), M * K, 5, 1.0f);
+  fill_values(W.data(), N * K, 6, 0.05f);
+
+  /* Round A through FP16 so both paths see identical activations */
+  f32_to_f16_array(A.data(), A16.data(), A.size());
+  f16_to_f32_array(A16.data(), A.data(), A.size());
+  ASSERT_TRUE(quantize_rows(DTYPE_Q4_0, W.data(), Wq.data(), N, K));
+
+  gemm_quant_f32(A.data(), Wq.data(), DTYPE_Q4_0, C32.data(), M, N, K);
+  gemm_quant_f16(A16.data(), Wq.data(), DTYPE_Q4_0, C16.data(), M, N, K);
+
+  for (int i = 0; i < M * N; i++)
+    ASSERT_NEAR(C32[i], f16_to_f32(C16[i]), fabsf(C32[i]) * 1e-3f + 1e-4f);
+}
+
+TEST(quant_gemm_multithreaded_matches_single) {
+  /* Large enough for the GEMM to use the pool */
+  const int M = 4, N = 1024, K = 256;
+  std::vector<float> A(M * K), W(N * K), C_st(M * N), C_mt(M * N);
+  std::vector<uint8_t> Wq(dtype_nbytes(DTYPE_Q8_0, (size_t)N * K));
+  fill_values(A.data(), M * K, 7, 1.0f);
+  fill_values(W.data(), N * K, 8, 0.05f);
+  ASSERT_TRUE(quantize_rows(DTYPE_Q8_0, W.data(), Wq.data(), N, K));
+
+  threadpool_set_num_threads(1);
+  gemm_quant_f32(A.data(), Wq.data(), DTYPE_Q8_0, C_st.data(), M, N, K);
+  threadpool_set_num_threads(4);
+  gemm_quant_f32(A.data(), Wq.data(), DTYPE_Q8_0, C_mt.data(), M, N, K);
+  threadpool_set_num_threads(0);
+
+  for (int i = 0; i < M * N; i++)
+    ASSERT_NEAR(C_st[i], C_mt[i], 0.0f);
+}
+
+/* Integer block sums scaled in float, as the scalar kernels do */
+static float dot_reference(const float *w_deq_int, const block_q8_0_t *a,
+                           const float *w_scale, int nblocks) {
+  float sum = 0.0f;
+  for (int b = 0; b < nblocks; b++) {
+    int32_t acc = 0;
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++)
+      acc += (int32_t)w_deq_int[b * QUANT_BLOCK_SIZE + j] * a[b].qs[j];
+    sum += (float)acc * w_scale[b] * f16_to_f32(a[b].d);
+  }
+  return sum;
+}
+
+TEST(quant_simd_dot_matches_scalar) {
+  quant_caps_t caps = quant_get_capabilities();
+  if (!caps.has_neon && !caps.has_avx2)
+    return;
+
+  const int k = 512, nblocks = k / QUANT_BLOCK_SIZE;
+  std::vector<float> x(k), w(k), wi8(k), wi4(k), s8(nblocks), s4(nblocks);
+  std::vector<block_q8_0_t> a(nblocks), w8(nblocks);
+  std::vector<block_q4_0_t> w4(nblocks);
+  fill_values(x.data(), k, 9, 1.0f);
+  fill_values(w.data(), k, 10, 0.1f);
+  quantize_row_q8_0(x.data(), a.data(), k);
+  quantize_row_q8_0(w.data(), w8.data(), k);
+  quantize_row_q4_0(w.data(), w4.data(), k);
+
+  for (int b = 0; b < nblocks; b++) {
+    s8[b] = f16_to_f32(w8[b].d);
+    s4[b] = f16_to_f32(w4[b].d);
+    for (int j = 0; j < QUANT_BLOCK_SIZE; j++) {
+      wi8[b * QUANT_BLOCK_SIZE + j] = w8[b].qs[j];
+      uint8_t byte = w4[b].qs[j % (QUANT_BLOCK_SIZE / 2)];
+      int nib = j < QUANT_BLOCK_SIZE / 2 ? (byte & 0x0F) : (byte >> 4);
+      wi4[b * QUANT_BLOCK_SIZE + j] = (float)(nib - 8);
+    }
+  }
+
+  float ref8 = dot_reference(wi8.data(), a.data(), s8.data(), nblocks);
+  float ref4 = dot_reference(wi4.data(), a.data(), s4.data(), nblocks);
+  float got8 = caps.has_neon
+                   ? quant_dot_q8_0_kernel(w8.data(), a.data(), nblocks)
+                   : quant_dot_q8_0_kernel_avx2(w8.data(), a.data(), nblocks);
+  float got4 = caps.has_neon
+                   ? quant_dot_q4_0_kernel(w4.data(), a.data(), nblocks)
+                   : quant_dot_q4_0_kernel_avx2(w4.data(), a.data(), nblocks);
+
+  ASSERT_NEAR(ref8, got8, fabsf(ref8) * 1e-5f + 1e-5f);
+  ASSERT_NEAR(ref4, got4, fabsf(ref4) * 1e-5f + 1e-5f);
+}
+
+extern "C" void run_quant_tests(void) {
+  TEST_SUITE("Quantized Weights");
+  RUN_TEST(quant_block_sizes);
+  RUN_TEST(quant_q8_0_round_trip);
+  RUN_TEST(quant_q4_0_round_trip);
+  RUN_TEST(quant_zero_block_stays_zero);
+  RUN_TEST(quant_rows_reject_partial_blocks);
+  RUN_TEST(quant_gemm_q8_0_f32_matches_reference);
+  RUN_TEST(quant_gemm_q4_0_f32_matches_reference);
+  RUN_TEST(quant_gemm_f16_matches_f32);
+  RUN_TEST(quant_gemm_multithreaded_matches_single);
+  RUN_TEST(quant_simd_dot_matches_scalar);
+}
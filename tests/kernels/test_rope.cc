@@ -338,6 +338,35 @@ TEST(rope_unaligned_rot_dim) {
   free(query_ref);
 }
 
+TEST(rope_shift_moves_keys_back) {
+  const int num_heads = 2;
+  const int head_size = 64;
+  const int max_pos = 256;
+  const int n = num_heads * head_size;
+
+  float *cache = (float *)malloc(max_pos * head_size * sizeof(float));
+  rope_compute_cos_sin_cache_f32(cache, max_pos, head_size, 10000.0f);
+
+  for (int neox = 0; neox < 2; neox++) {
+    float at_200[n], at_37[n], dummy[n];
+    for (int i = 0; i < n; i++)
+      at_200[i] = at_37[i] = dummy[i] = sinf((float)i * 0.37f);
+
+    /* A key rotated for position 200, shifted back by 163, is one at 37 */
+    int64_t pos_200 = 200, pos_37 = 37;
+    rope_f32(&pos_200, dummy, at_200, cache, 1, num_heads, num_heads,
+             head_size, head_size, neox);
+    rope_f32(&pos_37, dummy, at_37, cache, 1, num_heads, num_heads,
+             head_size, head_size, neox);
+    rope_shift_f32(at_200, cache + 163 * head_size, num_heads, head_size,
+                   head_size, neox);
+    for (int i = 0; i < n; i++)
+      ASSERT_NEAR(at_37[i], at_200[i], 1e-4f);
+  }
+
+  free(cache);
+}
+
 /* ============ Test Registration ============ */
 
 extern "C" void run_rope_tests(void) {
@@ -350,4 +379,5 @@ extern "C" void run_rope_tests(void) {
   RUN_TEST(rope_position_zero);
   RUN_TEST(rope_large_position);
   RUN_TEST(rope_unaligned_rot_dim);
+  RUN_TEST(rope_shift_moves_keys_back);
 }
@@ -3,14 +3,17 @@
  */
 
 #include "test_framework.h"
+#include "kernels/test_helper.h"
 
 extern "C" {
 #include "inference/kernels/sampling/sampling.h"
 }
 
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
 
 TEST(sampling_greedy_argmax) {
   const int vocab_size = 10;
@@ -117,6 +120,140 @@ TEST(sampling_combined_filters) {
   ASSERT_TRUE(sampled >= 0 && sampled < vocab_size);
 }
 
+/* softmax -> min-p -> top-k -> top-p -> temperature with full sorts */
+static std::vector<double> reference_probs(const std::vector<float> &logits,
+                                           float temperature, int top_k,
+                                           float top_p, float min_p) {
+  int n = (int)logits.size();
+  double max = *std::max_element(logits.begin(), logits.end());
+  std::vector<double> p(n);
+  for (int i = 0; i < n; i++)
+    p[i] = exp(logits[i] - max);
+  if (min_p > 0.0f) {
+    for (int i = 0; i < n; i++)
+      p[i] = p[i] < min_p ? 0.0 : p[i];
+  }
+
+  std::vector<int> order(n);
+  for (int i = 0; i < n; i++)
+    order[i] = i;
+  std::stable_sort(order.begin(), order.end(),
+                   [&](int a, int b) { return p[a] > p[b]; });
+  if (top_k > 0) {
+    for (int i = top_k; i < n; i++)
+      p[order[i]] = 0.0;
+  }
+  if (top_p < 1.0f) {
+    double sum = 0.0, cumsum = 0.0;
+    for (int i = 0; i < n; i++)
+      sum += p[i];
+    int keep = 0;
+    while (keep < n && p[order[keep]] > 0.0) {
+      cumsum += p[order[keep++]] / sum;
+      if (cumsum >= top_p)
+        break;
+    }
+    for (int i = keep; i < n; i++)
+      p[order[i]] = 0.0;
+  }
+
+  double sum = 0.0;
+  for (int i = 0; i < n; i++) {
+    p[i] = p[i] > 0.0 ? pow(p[i], 1.0 / temperature) : 0.0;
+    sum += p[i];
+  }
+  for (int i = 0; i < n; i++)
+    p[i] /= sum;
+  return p;
+}
+
+static bool check_pipeline(int vocab_size, float temperature, int top_k,
+                           float top_p, float min_p) {
+  std::vector<float> logits(vocab_size), probs(vocab_size);
+  fill_values(logits.data(), logits.size(), (unsigned)vocab_size);
+  for (int i = 0; i < vocab_size; i++)
+    logits[i] *= 6.0f;
+  std::vector<double> ref =
+      reference_probs(logits, temperature, top_k, top_p, min_p);
+
+  sampling_workspace_t ws;
+  if (!sampling_workspace_init(&ws, vocab_size) ||
+      !sampling_probs_f32(&ws, logits.data(), probs.data(), vocab_size,
+                          temperature, top_k, top_p, min_p))
+    return false;
+  sampling_workspace_free(&ws);
+
+  for (int i = 0; i < vocab_size; i++) {
+    if ((ref[i] > 0.0) != (probs[i] > 0.0f) ||
+        fabs(ref[i] - probs[i]) > 1e-5 + 1e-4 * ref[i]) {
+      printf("    mismatch V=%d T=%g k=%d p=%g min_p=%g at %d: %g vs %g\n",
+             vocab_size, temperature, top_k, top_p, min_p, i, probs[i],
+             ref[i]);
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(sampling_pipeline_matches_reference) {
+  ASSERT_TRUE(check_pipeline(1000, 1.0f, -1, 1.0f, 0.0f));
+  ASSERT_TRUE(check_pipeline(1000, 0.7f, 40, 1.0f, 0.0f));
+  ASSERT_TRUE(check_pipeline(1000, 1.3f, -1, 0.9f, 0.0f));
+  ASSERT_TRUE(check_pipeline(1000, 1.0f, -1, 1.0f, 0.05f));
+  ASSERT_TRUE(check_pipeline(1003, 0.8f, 50, 0.95f, 0.02f));
+  ASSERT_TRUE(check_pipeline(151936, 0.6f, 20, 0.95f, 0.0f));
+  ASSERT_TRUE(check_pipeline(151936, 1.0f, -1, 0.5f, 0.0f));
+}
+
+TEST(sampling_workspace_matches_one_shot) {
+  const int vocab_size = 5000;
+  std::vector<float> logits(vocab_size);
+  for (int i = 0; i < vocab_size; i++)
+    logits[i] = sinf((float)i * 0.37f) * 4.0f;
+
+  /* A zeroed workspace grows on first use and is reused afterwards */
+  sampling_workspace_t ws;
+  memset(&ws, 0, sizeof(ws));
+  sampling_rng_t rng1, rng2;
+  sampling_rng_init(&rng1, 7);
+  sampling_rng_init(&rng2, 7);
+  for (int i = 0; i < 50; i++) {
+    int a = sampling_sample_f32(logits.data(), vocab_size, 0.9f, 30, 0.9f,
+                                0.01f, &rng1);
+    int b = sampling_sample_ws_f32(&ws, logits.data(), vocab_size, 0.9f, 30,
+                                   0.9f, 0.01f, &rng2);
+    ASSERT_EQ_INT(a, b);
+  }
+  ASSERT_EQ_INT(vocab_size, ws.capacity);
+  sampling_workspace_free(&ws);
+}
+
+TEST(sampling_pipeline_distribution) {
+  /* Token frequencies follow the filtered distribution */
+  const int vocab_size = 8;
+  std::vector<float> logits = {0.0f, 1.0f, 2.0f, 0.5f,
+                               1.5f, -1.0f, 2.5f, 0.2f};
+  std::vector<double> ref = reference_probs(logits, 0.8f, 5, 0.9f, 0.0f);
+
+  sampling_workspace_t ws;
+  ASSERT_TRUE(sampling_workspace_init(&ws, vocab_size));
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 3);
+  const int n = 20000;
+  int counts[8] = {0};
+  for (int i = 0; i < n; i++)
+    counts[sampling_sample_ws_f32(&ws, logits.data(), vocab_size, 0.8f, 5,
+                                  0.9f, 0.0f, &rng)]++;
+  sampling_workspace_free(&ws);
+
+  for (int v = 0; v < vocab_size; v++) {
+    if (ref[v] == 0.0)
+      ASSERT_EQ_INT(0, counts[v]);
+    else
+      ASSERT_NEAR(ref[v], (double)counts[v] / n, 0.015);
+  }
+}
+
 extern "C" void run_sampling_tests(void) {
   TEST_SUITE("Token Sampling");
   RUN_TEST(sampling_greedy_argmax);
@@ -127,4 +264,7 @@ extern "C" void run_sampling_tests(void) {
   RUN_TEST(sampling_prob_computation);
   RUN_TEST(sampling_rng_consistency);
   RUN_TEST(sampling_combined_filters);
+  RUN_TEST(sampling_pipeline_matches_reference);
+  RUN_TEST(sampling_workspace_matches_one_shot);
+  RUN_TEST(sampling_pipeline_distribution);
 }
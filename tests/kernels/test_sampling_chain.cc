@@ -0,0 +1,353 @@
+/*
+ * Sampler Chain Unit Tests
+ */
+
+#include "test_framework.h"
+
+extern "C" {
+#include "inference/kernels/sampling/sampling_chain.h"
+}
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static int chain_argmax(const float *x, int n) {
+  int best = 0;
+  for (int i = 1; i < n; i++)
+    best = x[i] > x[best] ? i : best;
+  return best;
+}
+
+/* Histogram of n samples from fixed logits without accepting them */
+static std::vector<int> chain_histogram(const sampling_chain_params_t *params,
+                                        const float *logits, int vocab_size,
+                                        int n) {
+  sampling_chain_t *chain = sampling_chain_create(params, vocab_size, 16);
+  std::vector<int> counts(vocab_size, 0);
+  if (!chain)
+    return counts;
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 99);
+  for (int i = 0; i < n; i++)
+    counts[sampling_chain_sample(chain, logits, &rng)]++;
+  sampling_chain_free(chain);
+  return counts;
+}
+
+/*
+ * Penalties and DRY recomputed from the whole history at every step, the
+ * way the chain must behave without its incremental state
+ */
+static void brute_force_penalize(const sampling_chain_params_t *p,
+                                 const std::vector<int> &h, float *logits,
+                                 int vocab_size) {
+  int n = (int)h.size();
+  std::vector<int> counts(vocab_size, 0);
+  int from = p->penalty_range > 0 && n > p->penalty_range
+                 ? n - p->penalty_range
+                 : 0;
+  for (int i = from; i < n; i++)
+    counts[h[i]]++;
+  for (int v = 0; v < vocab_size; v++) {
+    if (counts[v] == 0)
+      continue;
+    float l = logits[v];
+    l = l > 0.0f ? l / p->repetition_penalty : l * p->repetition_penalty;
+    logits[v] = l - counts[v] * p->frequency_penalty - p->presence_penalty;
+  }
+
+  auto breaker = [p](int t) {
+    for (int i = 0; i < p->num_dry_breakers; i++) {
+      if (p->dry_breakers[i] == t)
+        return true;
+    }
+    return false;
+  };
+  std::vector<int> best(vocab_size, 0);
+  for (int j = 0; j + 1 < n; j++) {
+    int next = h[j + 1];
+    if (breaker(next))
+      continue;
+    int len = 0;
+    while (len <= j && h[j - len] == h[n - 1 - len] &&
+           !breaker(h[n - 1 - len]))
+      len++;
+    if (len > best[next])
+      best[next] = len;
+  }
+  for (int v = 0; v < vocab_size; v++) {
+    if (best[v] >= p->dry_allowed_length) {
+      logits[v] -= p->dry_multiplier *
+                   powf(p->dry_base, (float)(best[v] - p->dry_allowed_length));
+    }
+  }
+}
+
+TEST(sampling_chain_penalties_and_dry_match_brute_force) {
+  const int vocab_size = 12;
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  params.temperature = 0.0f;
+  params.repetition_penalty = 1.3f;
+  params.frequency_penalty = 0.2f;
+  params.presence_penalty = 0.1f;
+  params.penalty_range = 24;
+  params.dry_multiplier = 0.8f;
+  params.dry_base = 1.75f;
+  params.dry_allowed_length = 2;
+  params.dry_breakers[0] = 11;
+  params.num_dry_breakers = 1;
+
+  sampling_chain_t *chain = sampling_chain_create(&params, vocab_size, 512);
+  ASSERT_NOT_NULL(chain);
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 7);
+  srand(1234);
+
+  std::vector<int> history;
+  float logits[vocab_size], expected[vocab_size];
+  for (int step = 0; step < 400; step++) {
+    for (int v = 0; v < vocab_size; v++)
+      logits[v] = (float)(rand() % 1000) / 250.0f - 1.0f;
+    memcpy(expected, logits, sizeof(logits));
+    brute_force_penalize(&params, history, expected, vocab_size);
+    int want = chain_argmax(expected, vocab_size);
+    ASSERT_EQ_INT(want, sampling_chain_sample(chain, logits, &rng));
+
+    /* Feed a mix of the sampled token and short repeats of earlier text */
+    int token = want;
+    if (step > 8 && rand() % 3 == 0)
+      token = history[history.size() - 4 - rand() % 4];
+    history.push_back(token);
+    ASSERT_TRUE(sampling_chain_accept(chain, &token, 1));
+  }
+  ASSERT_EQ_INT(400, sampling_chain_length(chain));
+  sampling_chain_free(chain);
+}
+
+TEST(sampling_chain_penalty_window) {
+  float logits[6] = {1.0f, 0.9f, 0.0f, 0.5f, 0.0f, 0.0f};
+  int history[3] = {0, 1, 2};
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  params.temperature = 0.0f;
+  params.repetition_penalty = 10.0f;
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 1);
+
+  /* Token 0 left the two-token window and is no longer penalized */
+  params.penalty_range = 2;
+  sampling_chain_t *chain = sampling_chain_create(&params, 6, 8);
+  ASSERT_NOT_NULL(chain);
+  ASSERT_TRUE(sampling_chain_accept(chain, history, 3));
+  ASSERT_EQ_INT(0, sampling_chain_sample(chain, logits, &rng));
+  sampling_chain_free(chain);
+
+  params.penalty_range = 0;
+  chain = sampling_chain_create(&params, 6, 8);
+  ASSERT_NOT_NULL(chain);
+  ASSERT_TRUE(sampling_chain_accept(chain, history, 3));
+  ASSERT_EQ_INT(3, sampling_chain_sample(chain, logits, &rng));
+
+  /* Reset forgets the history */
+  sampling_chain_reset(chain);
+  ASSERT_EQ_INT(0, sampling_chain_length(chain));
+  ASSERT_EQ_INT(0, sampling_chain_sample(chain, logits, &rng));
+  sampling_chain_free(chain);
+}
+
+TEST(sampling_chain_dry_blocks_repeats_and_respects_breakers) {
+  float logits[8] = {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f};
+  logits[5] = 0.5f;
+  int history[7] = {1, 2, 3, 4, 1, 2, 3};
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  params.temperature = 0.0f;
+  params.dry_multiplier = 1.0f;
+  params.dry_base = 1.75f;
+  params.dry_allowed_length = 2;
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 1);
+
+  /* "1 2 3" already continued with 4: penalized by 1.75^(3 - 2) */
+  sampling_chain_t *chain = sampling_chain_create(&params, 8, 16);
+  ASSERT_NOT_NULL(chain);
+  ASSERT_TRUE(sampling_chain_accept(chain, history, 7));
+  ASSERT_EQ_INT(5, sampling_chain_sample(chain, logits, &rng));
+  sampling_chain_free(chain);
+
+  /* With 2 as a breaker the match is only "3", below the allowed length */
+  params.dry_breakers[0] = 2;
+  params.num_dry_breakers = 1;
+  chain = sampling_chain_create(&params, 8, 16);
+  ASSERT_NOT_NULL(chain);
+  ASSERT_TRUE(sampling_chain_accept(chain, history, 7));
+  ASSERT_EQ_INT(4, sampling_chain_sample(chain, logits, &rng));
+  sampling_chain_free(chain);
+}
+
+TEST(sampling_chain_min_tokens_bans_eos) {
+  float logits[4] = {0.0f, 0.5f, 0.0f, 10.0f};
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  params.temperature = 0.0f;
+  params.min_tokens = 3;
+  params.eos_token_id = 3;
+  sampling_chain_t *chain = sampling_chain_create(&params, 4, 8);
+  ASSERT_NOT_NULL(chain);
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 1);
+  for (int i = 0; i < 3; i++)
+    ASSERT_EQ_INT(1, sampling_chain_sample(chain, logits, &rng));
+  ASSERT_EQ_INT(3, sampling_chain_sample(chain, logits, &rng));
+  sampling_chain_free(chain);
+}
+
+TEST(sampling_chain_defaults_match_pipeline) {
+  const int vocab_size = 1000;
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  params.temperature = 0.8f;
+  params.top_k = 50;
+  params.top_p = 0.9f;
+  params.min_p = 0.02f;
+  sampling_chain_t *chain = sampling_chain_create(&params, vocab_size, 8);
+  ASSERT_NOT_NULL(chain);
+  sampling_workspace_t ws;
+  memset(&ws, 0, sizeof(ws));
+
+  sampling_rng_t rng_a, rng_b;
+  sampling_rng_init(&rng_a, 5);
+  sampling_rng_init(&rng_b, 5);
+  srand(77);
+  std::vector<float> logits(vocab_size);
+  for (int step = 0; step < 50; step++) {
+    for (int v = 0; v < vocab_size; v++)
+      logits[v] = (float)(rand() % 2000) / 200.0f;
+    int want = sampling_sample_ws_f32(&ws, logits.data(), vocab_size, 0.8f,
+                                      50, 0.9f, 0.02f, &rng_b);
+    ASSERT_EQ_INT(want, sampling_chain_sample(chain, logits.data(), &rng_a));
+  }
+  sampling_workspace_free(&ws);
+  sampling_chain_free(chain);
+}
+
+TEST(sampling_chain_truncation_samplers) {
+  /* Probabilities 0.5, 0.3, 0.15, 0.05 */
+  float logits[4] = {logf(0.5f), logf(0.3f), logf(0.15f), logf(0.05f)};
+  sampling_chain_params_t params;
+
+  /* top-a keeps p >= 0.5 * 0.5^2 */
+  sampling_chain_params_init(&params);
+  params.top_a = 0.5f;
+  std::vector<int> counts = chain_histogram(&params, logits, 4, 2000);
+  ASSERT_EQ_INT(0, counts[3]);
+  ASSERT_GT(counts[2], 0);
+
+  /* Typical keeps the tokens whose surprise is closest to the entropy */
+  sampling_chain_params_init(&params);
+  params.typical_p = 0.5f;
+  counts = chain_histogram(&params, logits, 4, 2000);
+  ASSERT_EQ_INT(0, counts[2] + counts[3]);
+  ASSERT_GT(counts[0], 0);
+  ASSERT_GT(counts[1], 0);
+
+  /* The second derivative is flat, so TFS keeps the head only */
+  sampling_chain_params_init(&params);
+  params.tfs = 0.5f;
+  counts = chain_histogram(&params, logits, 4, 200);
+  ASSERT_EQ_INT(200, counts[0]);
+
+  /* XTC drops every token above the threshold except the least likely */
+  sampling_chain_params_init(&params);
+  params.xtc_threshold = 0.2f;
+  params.xtc_probability = 1.0f;
+  counts = chain_histogram(&params, logits, 4, 2000);
+  ASSERT_EQ_INT(0, counts[0]);
+  ASSERT_GT(counts[1], counts[2]);
+
+  /* A very low dynamic temperature is close to greedy */
+  sampling_chain_params_init(&params);
+  params.dynatemp_min = 0.01f;
+  params.dynatemp_max = 0.02f;
+  counts = chain_histogram(&params, logits, 4, 200);
+  ASSERT_EQ_INT(200, counts[0]);
+}
+
+TEST(sampling_chain_top_nsigma) {
+  /* One outlier over a plateau that holds most of the mass */
+  float logits[64];
+  for (int v = 0; v < 64; v++)
+    logits[v] = 7.0f;
+  logits[0] = 10.0f;
+  logits[1] = 9.0f;
+
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  params.nsigma = 1.0f;
+  std::vector<int> counts = chain_histogram(&params, logits, 64, 500);
+  ASSERT_EQ_INT(500, counts[0]);
+
+  params.nsigma = 0.0f;
+  params.smoothing_factor = 0.01f; /* Still takes the extended path */
+  counts = chain_histogram(&params, logits, 64, 500);
+  ASSERT_LT(counts[0], 400);
+}
+
+TEST(sampling_chain_mirostat_tracks_target_surprise) {
+  const int vocab_size = 64;
+  float logits[vocab_size];
+  for (int v = 0; v < vocab_size; v++)
+    logits[v] = -1.1f * logf((float)(v + 1));
+
+  for (int mode = 1; mode <= 2; mode++) {
+    sampling_chain_params_t params;
+    sampling_chain_params_init(&params);
+    params.mirostat_mode = mode;
+    params.mirostat_eta = 0.1f;
+
+    params.mirostat_tau = 0.5f;
+    std::vector<int> low = chain_histogram(&params, logits, vocab_size, 2000);
+    params.mirostat_tau = 6.0f;
+    std::vector<int> high = chain_histogram(&params, logits, vocab_size, 2000);
+
+    int distinct = 0;
+    for (int v = 0; v < vocab_size; v++)
+      distinct += high[v] > 0;
+    ASSERT_GT(low[0], 1400);
+    ASSERT_LT(high[0], 1000);
+    ASSERT_GT(distinct, 16);
+  }
+}
+
+TEST(sampling_chain_accept_bounds) {
+  sampling_chain_params_t params;
+  sampling_chain_params_init(&params);
+  sampling_chain_t *chain = sampling_chain_create(&params, 8, 4);
+  ASSERT_NOT_NULL(chain);
+  int tokens[5] = {1, 2, 3, 4, 5};
+  ASSERT_TRUE(sampling_chain_accept(chain, tokens, 4));
+  ASSERT_FALSE(sampling_chain_accept(chain, tokens + 4, 1));
+  ASSERT_EQ_INT(4, sampling_chain_length(chain));
+
+  int bad = 8;
+  sampling_chain_reset(chain);
+  ASSERT_FALSE(sampling_chain_accept(chain, &bad, 1));
+  sampling_chain_free(chain);
+  ASSERT_TRUE(sampling_chain_create(&params, 0, 4) == NULL);
+}
+
+extern "C" void run_sampling_chain_tests(void) {
+  TEST_SUITE("Sampler Chain");
+  RUN_TEST(sampling_chain_penalties_and_dry_match_brute_force);
+  RUN_TEST(sampling_chain_penalty_window);
+  RUN_TEST(sampling_chain_dry_blocks_repeats_and_respects_breakers);
+  RUN_TEST(sampling_chain_min_tokens_bans_eos);
+  RUN_TEST(sampling_chain_defaults_match_pipeline);
+  RUN_TEST(sampling_chain_truncation_samplers);
+  RUN_TEST(sampling_chain_top_nsigma);
+  RUN_TEST(sampling_chain_mirostat_tracks_target_surprise);
+  RUN_TEST(sampling_chain_accept_bounds);
+}
@@ -0,0 +1,193 @@
+/*
+ * Thread Pool Unit Tests
+ */
+
+#include "test_framework.h"
+
+extern "C" {
+#include "inference/backend/caps.h"
+#include "inference/backend/numa.h"
+#include "inference/backend/threadpool.h"
+#include "inference/kernels/gemm/gemm.h"
+#include "inference/kernels/sampling/sampling.h"
+}
+
+#include <atomic>
+#include <cmath>
+#include <vector>
+
+struct coverage_ctx {
+  std::atomic<int> *hits;
+  int base;
+  int grain;
+  std::atomic<int> misaligned;
+};
+
+static void count_range(void *arg, int start, int end) {
+  coverage_ctx *ctx = (coverage_ctx *)arg;
+  if ((start - ctx->base) % ctx->grain != 0)
+    ctx->misaligned++;
+  for (int i = start; i < end; i++)
+    ctx->hits[i - ctx->base]++;
+}
+
+TEST(threadpool_covers_range_once) {
+  threadpool_t *pool = threadpool_create(4);
+  ASSERT(pool != NULL);
+  ASSERT_EQ_INT(4, threadpool_size(pool));
+
+  const int base = 5, n = 1000;
+  std::vector<std::atomic<int>> hits(n);
+  coverage_ctx ctx = {hits.data(), base, 3, {0}};
+
+  for (int rep = 0; rep < 50; rep++)
+    threadpool_parallel_for(pool, base, base + n, 3, count_range, &ctx);
+
+  for (int i = 0; i < n; i++)
+    ASSERT_EQ_INT(50, hits[i].load());
+  ASSERT_EQ_INT(0, ctx.misaligned.load());
+
+  threadpool_destroy(pool);
+}
+
+TEST(threadpool_null_pool_runs_serially) {
+  std::vector<std::atomic<int>> hits(64);
+  coverage_ctx ctx = {hits.data(), 0, 1, {0}};
+  threadpool_parallel_for(NULL, 0, 64, 1, count_range, &ctx);
+  for (int i = 0; i < 64; i++)
+    ASSERT_EQ_INT(1, hits[i].load());
+}
+
+struct nested_ctx {
+  threadpool_t *pool;
+  std::atomic<int> *hits;
+};
+
+static void nested_inner(void *arg, int start, int end) {
+  std::atomic<int> *hits = (std::atomic<int> *)arg;
+  for (int i = start; i < end; i++)
+    hits[i]++;
+}
+
+static void nested_outer(void *arg, int start, int end) {
+  nested_ctx *ctx = (nested_ctx *)arg;
+  for (int row = start; row < end; row++)
+    threadpool_parallel_for(ctx->pool, row * 16, row * 16 + 16, 1,
+                            nested_inner, ctx->hits);
+}
+
+TEST(threadpool_nested_call_runs_inline) {
+  threadpool_t *pool = threadpool_create(4);
+  ASSERT(pool != NULL);
+
+  std::vector<std::atomic<int>> hits(8 * 16);
+  nested_ctx ctx = {pool, hits.data()};
+  threadpool_parallel_for(pool, 0, 8, 1, nested_outer, &ctx);
+
+  for (int i = 0; i < 8 * 16; i++)
+    ASSERT_EQ_INT(1, hits[i].load());
+
+  threadpool_destroy(pool);
+}
+
+TEST(threadpool_global_resize_keeps_pool) {
+  threadpool_t *pool = threadpool_global();
+  ASSERT(pool != NULL);
+
+  threadpool_set_num_threads(3);
+  ASSERT(threadpool_global() == pool);
+  ASSERT_EQ_INT(3, threadpool_get_num_threads());
+  ASSERT_EQ_INT(3, gemm_get_num_threads());
+
+  threadpool_set_num_threads(0);
+  ASSERT(threadpool_global() == pool);
+}
+
+TEST(threadpool_gemm_matches_single_thread) {
+  const int M = 130, N = 48, K = 72;
+  std::vector<float> A(M * K), B(K * N), C_mt(M * N), C_st(M * N);
+  for (int i = 0; i < M * K; i++)
+    A[i] = (float)(i % 17) * 0.0625f - 0.5f;
+  for (int i = 0; i < K * N; i++)
+    B[i] = (float)(i % 13) * 0.125f - 0.75f;
+
+  threadpool_set_num_threads(1);
+  gemm_f32(A.data(), B.data(), C_st.data(), M, N, K, false, false);
+
+  threadpool_set_num_threads(4);
+  gemm_f32(A.data(), B.data(), C_mt.data(), M, N, K, false, false);
+  threadpool_set_num_threads(0);
+
+  for (int i = 0; i < M * N; i++)
+    ASSERT_NEAR(C_st[i], C_mt[i], 1e-4f);
+}
+
+TEST(threadpool_greedy_sampling_keeps_first_max) {
+  const int vocab = 151936;
+  std::vector<float> logits(vocab);
+  for (int i = 0; i < vocab; i++)
+    logits[i] = (float)(i % 1000) * 0.001f;
+  logits[90001] = 5.0f;
+  logits[140000] = 5.0f;
+
+  sampling_rng_t rng;
+  sampling_rng_init(&rng, 1);
+
+  threadpool_set_num_threads(4);
+  int token = sampling_sample_f32(logits.data(), vocab, 0.0f, -1, 1.0f, 0.0f,
+                                  &rng);
+  threadpool_set_num_threads(0);
+
+  ASSERT_EQ_INT(90001, token);
+}
+
+TEST(caps_parse_cpulist_ranges) {
+  bool cpus[16];
+  ASSERT_EQ_INT(7, caps_parse_cpulist("0-3,8,10-11\n", cpus, 16));
+  for (int i = 0; i < 16; i++)
+    ASSERT_EQ_INT(i <= 3 || i == 8 || i == 10 || i == 11, cpus[i]);
+
+  /* CPUs past the array are counted but not stored */
+  ASSERT_EQ_INT(4, caps_parse_cpulist("14-17", cpus, 16));
+  ASSERT(cpus[14] && cpus[15]);
+
+  ASSERT_EQ_INT(0, caps_parse_cpulist("\n", cpus, 16));
+  ASSERT_EQ_INT(-1, caps_parse_cpulist("3-1", cpus, 16));
+  ASSERT_EQ_INT(-1, caps_parse_cpulist("0,,2", cpus, 16));
+  ASSERT_EQ_INT(-1, caps_parse_cpulist("0-", cpus, 16));
+  ASSERT_EQ_INT(-1, caps_parse_cpulist("a", cpus, 16));
+}
+
+TEST(caps_numa_topology_is_consistent) {
+  const system_caps_t *caps = caps_get();
+  ASSERT(caps->num_numa_nodes >= 1);
+  for (int cpu = 0; cpu < caps->num_cpus; cpu++) {
+    int node = caps_numa_node_of_cpu(cpu);
+    ASSERT(node >= 0 && node < caps->num_numa_nodes);
+  }
+  for (int n = 0; n < caps->num_numa_nodes; n++)
+    ASSERT(caps_numa_node_id(n) >= 0);
+  ASSERT_EQ_INT(-1, caps_numa_node_id(caps->num_numa_nodes));
+
+  /* Placement never changes the data, whether or not it applies */
+  std::vector<float> data(1 << 16);
+  for (size_t i = 0; i < data.size(); i++)
+    data[i] = (float)i;
+  bool placed = numa_interleave(data.data(), data.size() * sizeof(float));
+  if (caps->num_numa_nodes == 1)
+    ASSERT(!placed);
+  for (size_t i = 0; i < data.size(); i++)
+    ASSERT(data[i] == (float)i);
+}
+
+extern "C" void run_threadpool_tests(void) {
+  TEST_SUITE("Thread Pool");
+  RUN_TEST(threadpool_covers_range_once);
+  RUN_TEST(threadpool_null_pool_runs_serially);
+  RUN_TEST(threadpool_nested_call_runs_inline);
+  RUN_TEST(threadpool_global_resize_keeps_pool);
+  RUN_TEST(threadpool_gemm_matches_single_thread);
+  RUN_TEST(threadpool_greedy_sampling_keeps_first_max);
+  RUN_TEST(caps_parse_cpulist_ranges);
+  RUN_TEST(caps_numa_topology_is_consistent);
+}
@@ -0,0 +1,160 @@
+/*
+ * Forward-Pass Workspace Tests
+ */
+
+#include "test_framework.h"
+
+extern "C" {
+#include "inference/core/large_alloc.h"
+#include "inference/core/workspace.h"
+}
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+TEST(workspace_slices_are_aligned) {
+  workspace_t ws;
+  ASSERT_TRUE(workspace_init(&ws, 4096));
+
+  void *a = workspace_alloc(&ws, 3);
+  void *b = workspace_alloc(&ws, 100);
+  ASSERT_NOT_NULL(a);
+  ASSERT_NOT_NULL(b);
+  ASSERT_EQ(0, (int)((uintptr_t)a % WORKSPACE_ALIGN));
+  ASSERT_EQ(0, (int)((uintptr_t)b % WORKSPACE_ALIGN));
+  ASSERT_EQ_SIZE((size_t)WORKSPACE_ALIGN, (size_t)((uint8_t *)b -
+                                                   (uint8_t *)a));
+  ASSERT_EQ_SIZE(workspace_slice_bytes(3) + workspace_slice_bytes(100),
+                 workspace_mark(&ws));
+
+  workspace_free(&ws);
+}
+
+TEST(workspace_reset_reuses_memory) {
+  workspace_t ws;
+  ASSERT_TRUE(workspace_init(&ws, 4096));
+
+  void *outer = workspace_alloc(&ws, 256);
+  size_t mark = workspace_mark(&ws);
+  void *first = workspace_alloc(&ws, 512);
+  workspace_alloc(&ws, 512);
+  workspace_reset(&ws, mark);
+  void *again = workspace_alloc(&ws, 512);
+
+  ASSERT_NOT_NULL(outer);
+  ASSERT_TRUE(first == again);
+  ASSERT_EQ_SIZE(mark + workspace_slice_bytes(512), workspace_mark(&ws));
+
+  workspace_free(&ws);
+}
+
+TEST(workspace_exhaustion_returns_null) {
+  workspace_t ws;
+  ASSERT_TRUE(workspace_init(&ws, 1024));
+
+  ASSERT_NOT_NULL(workspace_alloc(&ws, 1000));
+  ASSERT_NULL(workspace_alloc(&ws, 64));
+  ASSERT_EQ_SIZE((size_t)1024, workspace_mark(&ws));
+  ASSERT_NULL(workspace_alloc(NULL, 64));
+
+  workspace_free(&ws);
+}
+
+TEST(workspace_reserve_grows_only_when_empty) {
+  workspace_t ws;
+  ASSERT_TRUE(workspace_init(&ws, 0));
+  ASSERT_NULL(workspace_alloc(&ws, 1));
+
+  ASSERT_TRUE(workspace_reserve(&ws, 1000));
+  ASSERT_TRUE(ws.capacity >= 1000);
+  size_t capacity = ws.capacity;
+
+  /* Growth is geometric so nearby sizes do not reallocate again */
+  ASSERT_TRUE(workspace_reserve(&ws, capacity + 1));
+  ASSERT_TRUE(ws.capacity >= capacity + capacity / 2);
+  capacity = ws.capacity;
+
+  memset(workspace_alloc(&ws, capacity), 0xAB, capacity);
+  ASSERT_TRUE(workspace_reserve(&ws, capacity));
+  ASSERT_FALSE(workspace_reserve(&ws, capacity + 1));
+  ASSERT_EQ_SIZE(capacity, ws.capacity);
+
+  workspace_reset(&ws, 0);
+  ASSERT_TRUE(workspace_reserve(&ws, capacity + 1));
+
+  workspace_free(&ws);
+}
+
+TEST(workspace_tracks_peak) {
+  workspace_t ws;
+  ASSERT_TRUE(workspace_init(&ws, 4096));
+  ASSERT_EQ_SIZE((size_t)0, workspace_peak(&ws));
+
+  workspace_alloc(&ws, 1024);
+  workspace_alloc(&ws, 1024);
+  workspace_reset(&ws, 0);
+  workspace_alloc(&ws, 512);
+
+  ASSERT_EQ_SIZE((size_t)2048, workspace_peak(&ws));
+  ASSERT_EQ_SIZE((size_t)512, workspace_mark(&ws));
+
+  workspace_free(&ws);
+  ASSERT_EQ_SIZE((size_t)0, workspace_peak(&ws));
+}
+
+static bool all_zero(const uint8_t *p, size_t n) {
+  for (size_t i = 0; i < n; i++) {
+    if (p[i])
+      return false;
+  }
+  return true;
+}
+
+TEST(large_alloc_blocks_are_zeroed_and_counted) {
+  large_alloc_stats_t before, during, after;
+  large_alloc_stats(&before);
+
+  size_t sizes[2] = {100, 3 * LARGE_PAGE_SIZE + 17};
+  uint8_t *blocks[2];
+  for (int i = 0; i < 2; i++) {
+    blocks[i] = (uint8_t *)large_alloc(sizes[i]);
+    ASSERT_NOT_NULL(blocks[i]);
+    ASSERT_EQ(0, (int)((uintptr_t)blocks[i] % LARGE_ALLOC_ALIGN));
+    ASSERT_TRUE(all_zero(blocks[i], sizes[i]));
+    memset(blocks[i], 0xab, sizes[i]);
+  }
+  ASSERT_EQ(LARGE_PAGES_NONE, large_alloc_backing(blocks[0]));
+
+  large_alloc_stats(&during);
+  size_t grown = 0;
+  for (int i = 0; i < LARGE_PAGES_COUNT; i++)
+    grown += during.bytes[i] - before.bytes[i];
+  ASSERT_TRUE(grown >= sizes[0] + sizes[1]);
+
+  for (int i = 0; i < 2; i++)
+    large_free(blocks[i]);
+  large_alloc_stats(&after);
+  for (int i = 0; i < LARGE_PAGES_COUNT; i++)
+    ASSERT_EQ_SIZE(before.bytes[i], after.bytes[i]);
+}
+
+TEST(large_alloc_honours_hugepages_off) {
+  setenv("SILLYTUI_HUGEPAGES", "off", 1);
+  void *block = large_alloc(4 * LARGE_PAGE_SIZE);
+  unsetenv("SILLYTUI_HUGEPAGES");
+  ASSERT_NOT_NULL(block);
+  ASSERT_EQ(LARGE_PAGES_NONE, large_alloc_backing(block));
+  large_free(block);
+}
+
+extern "C" void run_workspace_tests(void) {
+  TEST_SUITE("Workspace");
+  RUN_TEST(workspace_slices_are_aligned);
+  RUN_TEST(workspace_reset_reuses_memory);
+  RUN_TEST(workspace_exhaustion_returns_null);
+  RUN_TEST(workspace_reserve_grows_only_when_empty);
+  RUN_TEST(workspace_tracks_peak);
+  RUN_TEST(large_alloc_blocks_are_zeroed_and_counted);
+  RUN_TEST(large_alloc_honours_hugepages_off);
+}
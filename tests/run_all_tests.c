@@ -39,6 +39,10 @@ extern void run_config_integration_tests(void);
 extern void run_persona_integration_tests(void);
 extern void run_tokenizer_integration_tests(void);
 extern void run_safetensors_tests(void);
+extern void run_weight_cache_tests(void);
+extern void run_qwen3_weights_tests(void);
+extern void run_scheduler_tests(void);
+extern void run_speculative_tests(void);
 extern void run_gemm_tests(void);
 extern void run_gemm_pytorch_accuracy_tests(void);
 extern void run_layernorm_tests(void);
@@ -53,8 +57,15 @@ extern void run_embedding_tests(void);
 extern void run_embedding_pytorch_tests(void);
 extern void run_sampling_tests(void);
 extern void run_sampling_pytorch_tests(void);
+extern void run_sampling_chain_tests(void);
 extern void run_kv_cache_tests(void);
 extern void run_kv_cache_pytorch_tests(void);
+extern void run_threadpool_tests(void);
+extern void run_quant_tests(void);
+extern void run_gemv_tests(void);
+extern void run_workspace_tests(void);
+extern void run_flash_decode_tests(void);
+extern void run_flash_prefill_tests(void);
 
 int main(int argc, char **argv) {
   (void)argc;
@@ -114,6 +125,10 @@ int main(int argc, char **argv) {
   run_persona_integration_tests();
   run_tokenizer_integration_tests();
   run_safetensors_tests();
+  run_weight_cache_tests();
+  run_qwen3_weights_tests();
+  run_scheduler_tests();
+  run_speculative_tests();
   run_gemm_tests();
   run_gemm_pytorch_accuracy_tests();
   run_layernorm_tests();
@@ -128,8 +143,15 @@ int main(int argc, char **argv) {
   run_embedding_pytorch_tests();
   run_sampling_tests();
   run_sampling_pytorch_tests();
+  run_sampling_chain_tests();
   run_kv_cache_tests();
   run_kv_cache_pytorch_tests();
+  run_threadpool_tests();
+  run_quant_tests();
+  run_gemv_tests();
+  run_workspace_tests();
+  run_flash_decode_tests();
+  run_flash_prefill_tests();
 
   clock_t end = clock();
   double elapsed = (double)(end - start) / CLOCKS_PER_SEC;
@@ -14,7 +14,12 @@ extern void run_simd_tests(void);
 extern void run_tokenizer_tests(void);
 extern void run_modal_tests(void);
 extern void run_attachment_tests(void);
+extern void run_local_backend_tests(void);
 extern void run_safetensors_tests(void);
+extern void run_weight_cache_tests(void);
+extern void run_qwen3_weights_tests(void);
+extern void run_scheduler_tests(void);
+extern void run_speculative_tests(void);
 extern void run_gemm_tests(void);
 extern void run_gemm_pytorch_accuracy_tests(void);
 extern void run_layernorm_tests(void);
@@ -29,8 +34,15 @@ extern void run_embedding_tests(void);
 extern void run_embedding_pytorch_tests(void);
 extern void run_sampling_tests(void);
 extern void run_sampling_pytorch_tests(void);
+extern void run_sampling_chain_tests(void);
 extern void run_kv_cache_tests(void);
 extern void run_kv_cache_pytorch_tests(void);
+extern void run_threadpool_tests(void);
+extern void run_quant_tests(void);
+extern void run_gemv_tests(void);
+extern void run_workspace_tests(void);
+extern void run_flash_decode_tests(void);
+extern void run_flash_prefill_tests(void);
 
 int main(int argc, char **argv) {
   (void)argc;
@@ -53,7 +65,12 @@ int main(int argc, char **argv) {
   run_tokenizer_tests();
   run_modal_tests();
   run_attachment_tests();
+  run_local_backend_tests();
   run_safetensors_tests();
+  run_weight_cache_tests();
+  run_qwen3_weights_tests();
+  run_scheduler_tests();
+  run_speculative_tests();
   run_gemm_tests();
   run_gemm_pytorch_accuracy_tests();
   run_layernorm_tests();
@@ -68,8 +85,15 @@ int main(int argc, char **argv) {
   run_embedding_pytorch_tests();
   run_sampling_tests();
   run_sampling_pytorch_tests();
+  run_sampling_chain_tests();
   run_kv_cache_tests();
   run_kv_cache_pytorch_tests();
+  run_threadpool_tests();
+  run_quant_tests();
+  run_gemv_tests();
+  run_workspace_tests();
+  run_flash_decode_tests();
+  run_flash_prefill_tests();
 
   print_test_summary();
 
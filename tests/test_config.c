@@ -9,6 +9,7 @@ TEST(api_type_name_valid) {
   ASSERT_EQ_STR("koboldcpp", api_type_name(API_TYPE_KOBOLDCPP));
   ASSERT_EQ_STR("tabby", api_type_name(API_TYPE_TABBY));
   ASSERT_EQ_STR("anthropic", api_type_name(API_TYPE_ANTHROPIC));
+  ASSERT_EQ_STR("local", api_type_name(API_TYPE_LOCAL));
   PASS();
 }
 
@@ -26,6 +27,7 @@ TEST(api_type_from_name_valid) {
   ASSERT_EQ(API_TYPE_KOBOLDCPP, api_type_from_name("koboldcpp"));
   ASSERT_EQ(API_TYPE_TABBY, api_type_from_name("tabby"));
   ASSERT_EQ(API_TYPE_ANTHROPIC, api_type_from_name("anthropic"));
+  ASSERT_EQ(API_TYPE_LOCAL, api_type_from_name("local"));
   PASS();
 }
 
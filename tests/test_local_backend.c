@@ -0,0 +1,612 @@
+#include "inference/tokenizer/gpt2bpe.h"
+#include "llm/backends/local_engine.h"
+#include "test_framework.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/* Ids of the special tokens in the test vocabulary, after the 256 bytes */
+#define TL_ENDOFTEXT 256
+#define TL_IM_START 257
+#define TL_IM_END 258
+#define TL_THINK 259
+#define TL_THINK_END 260
+
+static bool byte_is_printable(int b) {
+  return (b >= '!' && b <= '~') || (b >= 0xA1 && b <= 0xAC) ||
+         (b >= 0xAE && b <= 0xFF);
+}
+
+/* GPT-2's byte-to-unicode table: printable bytes stand for themselves */
+static int byte_char(int b) {
+  if (byte_is_printable(b))
+    return b;
+  int n = 0;
+  for (int c = 0; c < b; c++)
+    n += !byte_is_printable(c);
+  return 256 + n;
+}
+
+/*
+ * A byte-level vocabulary without merges, so every byte of the text is one
+ * token whose id is the byte, plus the ChatML tokens if with_special
+ */
+static bool load_test_tokenizer(ChatTokenizer *ct, bool with_special) {
+  const char *tmp = getenv("TMPDIR");
+  char dir[512], path[600];
+  snprintf(dir, sizeof(dir), "%s/sillytui_local_tokenizer_%d",
+           tmp ? tmp : "/tmp", with_special);
+  mkdir(dir, 0755);
+
+  snprintf(path, sizeof(path), "%s/vocab.json", dir);
+  FILE *f = fopen(path, "w");
+  if (!f)
+    return false;
+  fprintf(f, "{");
+  for (int b = 0; b < 256; b++)
+    fprintf(f, "%s\"\\u%04x\": %d", b ? ", " : "", byte_char(b), b);
+  fprintf(f, "}\n");
+  fclose(f);
+
+  snprintf(path, sizeof(path), "%s/merges.txt", dir);
+  f = fopen(path, "w");
+  if (!f)
+    return false;
+  fprintf(f, "#version: 0.2\n");
+  fclose(f);
+
+  snprintf(path, sizeof(path), "%s/added_tokens.json", dir);
+  unlink(path);
+  if (with_special) {
+    f = fopen(path, "w");
+    if (!f)
+      return false;
+    fprintf(f, "{\"<|endoftext|>\": %d, \"<|im_start|>\": %d, "
+               "\"<|im_end|>\": %d, \"<think>\": %d, \"</think>\": %d}\n",
+            TL_ENDOFTEXT, TL_IM_START, TL_IM_END, TL_THINK, TL_THINK_END);
+    fclose(f);
+  }
+
+  char merges[600];
+  snprintf(path, sizeof(path), "%s/vocab.json", dir);
+  snprintf(merges, sizeof(merges), "%s/merges.txt", dir);
+  GPT2BPETokenizer *tok = malloc(sizeof(GPT2BPETokenizer));
+  if (!tok)
+    return false;
+  gpt2_init(tok);
+  if (!gpt2_load(tok, path, merges)) {
+    free(tok);
+    return false;
+  }
+  chat_tokenizer_init(ct);
+  ct->selection = TOKENIZER_QWEN3;
+  ct->instance = tok;
+  ct->loaded = true;
+  return true;
+}
+
+static void push_text(TokenBuf *tb, const char *text) {
+  for (const char *p = text; *p; p++)
+    tb->ids[tb->count++] = (unsigned char)*p;
+}
+
+static void push_message(TokenBuf *tb, const char *role, const char *text) {
+  tb->ids[tb->count++] = TL_IM_START;
+  push_text(tb, role);
+  push_text(tb, "\n");
+  push_text(tb, text);
+  tb->ids[tb->count++] = TL_IM_END;
+  push_text(tb, "\n");
+}
+
+static bool same_tokens(const TokenBuf *a, const TokenBuf *b) {
+  return a->count == b->count &&
+         memcmp(a->ids, b->ids, a->count * sizeof(int)) == 0;
+}
+
+TEST(local_tokens_resolve_from_tokenizer) {
+  ChatTokenizer ct;
+  ASSERT_TRUE(load_test_tokenizer(&ct, true));
+  LocalTokens tokens;
+  char error[256] = "";
+  ASSERT_TRUE(local_tokens_resolve(&tokens, &ct, error, sizeof(error)));
+  ASSERT_EQ_INT(TL_ENDOFTEXT, tokens.endoftext);
+  ASSERT_EQ_INT(TL_IM_START, tokens.im_start);
+  ASSERT_EQ_INT(TL_IM_END, tokens.im_end);
+  ASSERT_EQ_INT(TL_THINK, tokens.think);
+  ASSERT_EQ_INT(TL_THINK_END, tokens.think_end);
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
+TEST(local_tokens_missing_special_tokens_fail) {
+  ChatTokenizer ct;
+  ASSERT_TRUE(load_test_tokenizer(&ct, false));
+  LocalTokens tokens;
+  char error[256] = "";
+  ASSERT_FALSE(local_tokens_resolve(&tokens, &ct, error, sizeof(error)));
+  ASSERT_EQ_STR("Tokenizer has no <|endoftext|> token", error);
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
+TEST(local_prompt_renders_chatml) {
+  ChatTokenizer ct;
+  ASSERT_TRUE(load_test_tokenizer(&ct, true));
+  LocalTokens tokens;
+  char error[256];
+  ASSERT_TRUE(local_tokens_resolve(&tokens, &ct, error, sizeof(error)));
+
+  ChatHistory history;
+  history_init(&history);
+  history_add_with_role(&history, "You: Hi", ROLE_USER);
+  history_add_with_role(&history, "Bot: Yo", ROLE_ASSISTANT);
+
+  TokenBuf prompt = {0};
+  ASSERT_TRUE(
+      local_build_prompt(&history, NULL, &ct, &tokens, 1000, &prompt));
+
+  int ids[64];
+  TokenBuf expected = {ids, 0, 64};
+  push_message(&expected, "user", "Hi");
+  push_message(&expected, "assistant", "Yo");
+  expected.ids[expected.count++] = TL_IM_START;
+  push_text(&expected, "assistant\n");
+  ASSERT_TRUE(same_tokens(&expected, &prompt));
+
+  free(prompt.ids);
+  history_free(&history);
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
+TEST(local_prompt_drops_oldest_messages) {
+  ChatTokenizer ct;
+  ASSERT_TRUE(load_test_tokenizer(&ct, true));
+  LocalTokens tokens;
+  char error[256];
+  ASSERT_TRUE(local_tokens_resolve(&tokens, &ct, error, sizeof(error)));
+
+  ChatHistory history;
+  history_init(&history);
+  history_add_with_role(&history, "You: one", ROLE_USER);
+  history_add_with_role(&history, "Bot: two", ROLE_ASSISTANT);
+  history_add_with_role(&history, "You: three", ROLE_USER);
+
+  /* 11 tokens of tail, then 13 for the newest message and 16 for the next */
+  int ids[64];
+  TokenBuf expected = {ids, 0, 64};
+  push_message(&expected, "assistant", "two");
+  push_message(&expected, "user", "three");
+  expected.ids[expected.count++] = TL_IM_START;
+  push_text(&expected, "assistant\n");
+  ASSERT_EQ_INT(40, expected.count);
+
+  TokenBuf prompt = {0};
+  ASSERT_TRUE(local_build_prompt(&history, NULL, &ct, &tokens, 40, &prompt));
+  ASSERT_TRUE(same_tokens(&expected, &prompt));
+
+  /* One token short drops the assistant message too */
+  prompt.count = 0;
+  ASSERT_TRUE(local_build_prompt(&history, NULL, &ct, &tokens, 39, &prompt));
+  ASSERT_EQ_INT(24, prompt.count);
+  ASSERT_EQ_INT(TL_IM_START, prompt.ids[0]);
+  ASSERT_EQ_INT('u', prompt.ids[1]);
+
+  /* The tail is kept even when nothing else fits */
+  prompt.count = 0;
+  ASSERT_TRUE(local_build_prompt(&history, NULL, &ct, &tokens, 5, &prompt));
+  ASSERT_EQ_INT(11, prompt.count);
+  ASSERT_EQ_INT(TL_IM_START, prompt.ids[0]);
+  ASSERT_EQ_INT('a', prompt.ids[1]);
+
+  free(prompt.ids);
+  history_free(&history);
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
+TEST(local_utf8_complete_len_boundaries) {
+  ASSERT_EQ_SIZE(0, local_utf8_complete_len("", 0));
+  ASSERT_EQ_SIZE(3, local_utf8_complete_len("abc", 3));
+  ASSERT_EQ_SIZE(1, local_utf8_complete_len("a\xc3", 2));
+  ASSERT_EQ_SIZE(3, local_utf8_complete_len("a\xc3\xa9", 3));
+  ASSERT_EQ_SIZE(1, local_utf8_complete_len("a\xe2\x82", 3));
+  ASSERT_EQ_SIZE(1, local_utf8_complete_len("a\xf0\x9f\x98", 4));
+  ASSERT_EQ_SIZE(5, local_utf8_complete_len("a\xf0\x9f\x98\x80", 5));
+  /* Stray continuation bytes are not held back */
+  ASSERT_EQ_SIZE(2, local_utf8_complete_len("\xa9\xa9", 2));
+  PASS();
+}
+
+TEST(local_stream_holds_back_partial_utf8) {
+  ChatTokenizer ct;
+  ASSERT_TRUE(load_test_tokenizer(&ct, true));
+  LocalTokens tokens;
+  char error[256];
+  ASSERT_TRUE(local_tokens_resolve(&tokens, &ct, error, sizeof(error)));
+  LocalStream stream = {0};
+  stream.tokenizer = &ct;
+  stream.tokens = &tokens;
+
+  char *text;
+  ASSERT_EQ_INT(LOCAL_STREAM_TEXT, local_stream_token(&stream, 'a', &text));
+  ASSERT_EQ_STR("a", text);
+  free(text);
+  local_stream_token(&stream, 0xe2, &text);
+  ASSERT_NULL(text);
+  local_stream_token(&stream, 0x82, &text);
+  ASSERT_NULL(text);
+  local_stream_token(&stream, 0xac, &text);
+  ASSERT_EQ_STR("\xe2\x82\xac", text);
+  free(text);
+
+  /* An unfinished character is handed over at the end of the reply */
+  ASSERT_NULL(local_stream_flush(&stream));
+  local_stream_token(&stream, 0xc3, &text);
+  ASSERT_NULL(text);
+  text = local_stream_flush(&stream);
+  ASSERT_EQ_STR("\xc3", text);
+  free(text);
+  ASSERT_NULL(local_stream_flush(&stream));
+
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
+TEST(local_stream_routes_reasoning) {
+  ChatTokenizer ct;
+  ASSERT_TRUE(load_test_tokenizer(&ct, true));
+  LocalTokens tokens;
+  char error[256];
+  ASSERT_TRUE(local_tokens_resolve(&tokens, &ct, error, sizeof(error)));
+  LocalStream stream = {0};
+  stream.tokenizer = &ct;
+  stream.tokens = &tokens;
+
+  char *text;
+  ASSERT_EQ_INT(LOCAL_STREAM_THINK,
+                local_stream_token(&stream, TL_THINK, &text));
+  ASSERT_NULL(text);
+  ASSERT_TRUE(stream.in_reasoning);
+  ASSERT_EQ_INT(LOCAL_STREAM_TEXT, local_stream_token(&stream, 'h', &text));
+  ASSERT_EQ_STR("h", text);
+  ASSERT_TRUE(stream.in_reasoning);
+  free(text);
+
+  ASSERT_EQ_INT(LOCAL_STREAM_THINK_END,
+                local_stream_token(&stream, TL_THINK_END, &text));
+  ASSERT_NULL(text);
+  ASSERT_FALSE(stream.in_reasoning);
+  ASSERT_EQ_INT(LOCAL_STREAM_TEXT, local_stream_token(&stream, 'o', &text));
+  ASSERT_EQ_STR("o", text);
+  free(text);
+
+  /* Only the first <think> opens reasoning; stray tags vanish */
+  ASSERT_EQ_INT(LOCAL_STREAM_TEXT,
+                local_stream_token(&stream, TL_THINK, &text));
+  ASSERT_NULL(text);
+  ASSERT_EQ_INT(LOCAL_STREAM_TEXT,
+                local_stream_token(&stream, TL_THINK_END, &text));
+  ASSERT_NULL(text);
+  ASSERT_FALSE(stream.in_reasoning);
+  ASSERT_TRUE(stream.has_reasoning);
+
+  ASSERT_EQ_INT(LOCAL_STREAM_STOP,
+                local_stream_token(&stream, TL_IM_END, &text));
+  ASSERT_NULL(text);
+  ASSERT_EQ_INT(LOCAL_STREAM_STOP,
+                local_stream_token(&stream, TL_ENDOFTEXT, &text));
+
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
+/* A model that only records what the engine asks of its one sequence */
+typedef struct {
+  bool can_shift;
+  int prefix_hit; /* Tokens seq_reuse_prefix() claims to cover */
+  int len;        /* KV positions the sequence holds */
+  int truncates;
+  int shifts;
+  int shift_keep;
+  int shift_discard;
+  int cached[256];
+  int num_cached;
+} FakeModel;
+
+static inference_seq_t *fake_seq_create(inference_model_t *model) {
+  FakeModel *fm = model->impl;
+  fm->len = 0;
+  return (inference_seq_t *)fm;
+}
+
+static void fake_seq_free(inference_model_t *model, inference_seq_t *seq) {
+  (void)model;
+  (void)seq;
+}
+
+static bool fake_forward_batch(inference_model_t *model,
+                               inference_seq_t *const *seqs,
+                               const int *const *token_ids,
+                               const int *num_tokens, int num_seqs,
+                               float *logits) {
+  FakeModel *fm = model->impl;
+  (void)seqs;
+  (void)token_ids;
+  (void)num_seqs;
+  fm->len += num_tokens[0];
+  logits[0] = 0.0f;
+  return true;
+}
+
+static int fake_seq_reuse_prefix(inference_model_t *model,
+                                 inference_seq_t *seq, const int *tokens,
+                                 int num_tokens) {
+  FakeModel *fm = model->impl;
+  (void)seq;
+  (void)tokens;
+  fm->len = fm->prefix_hit < num_tokens ? fm->prefix_hit : num_tokens;
+  return fm->len;
+}
+
+static void fake_seq_cache_prefix(inference_model_t *model,
+                                  inference_seq_t *seq, const int *tokens,
+                                  int num_tokens) {
+  FakeModel *fm = model->impl;
+  (void)seq;
+  memcpy(fm->cached, tokens, num_tokens * sizeof(int));
+  fm->num_cached = num_tokens;
+}
+
+static void fake_seq_truncate(inference_model_t *model, inference_seq_t *seq,
+                              int len) {
+  FakeModel *fm = model->impl;
+  (void)seq;
+  fm->truncates++;
+  fm->len = len;
+}
+
+static bool fake_seq_shift(inference_model_t *model, inference_seq_t *seq,
+                           int keep, int discard) {
+  FakeModel *fm = model->impl;
+  (void)seq;
+  if (!fm->can_shift)
+    return false;
+  fm->shifts++;
+  fm->shift_keep = keep;
+  fm->shift_discard = discard;
+  fm->len -= discard;
+  return true;
+}
+
+static const inference_model_ops_t fake_ops = {
+    .seq_create = fake_seq_create,
+    .seq_free = fake_seq_free,
+    .forward_batch = fake_forward_batch,
+    .seq_cache_prefix = fake_seq_cache_prefix,
+    .seq_truncate = fake_seq_truncate,
+    .seq_shift = fake_seq_shift,
+};
+
+/* Same model without truncation: every turn starts a new sequence */
+static const inference_model_ops_t fake_ops_no_truncate = {
+    .seq_create = fake_seq_create,
+    .seq_free = fake_seq_free,
+    .forward_batch = fake_forward_batch,
+    .seq_reuse_prefix = fake_seq_reuse_prefix,
+    .seq_cache_prefix = fake_seq_cache_prefix,
+};
+
+static void fake_engine_init(LocalEngine *e, FakeModel *fm,
+                             const inference_model_ops_t *ops) {
+  memset(e, 0, sizeof(*e));
+  memset(fm, 0, sizeof(*fm));
+  fm->can_shift = true;
+  e->model.ops = ops;
+  e->model.impl = fm;
+  e->model.vocab_size = 1;
+  e->seq = inference_seq_create(&e->model);
+  e->fed_cap = 256;
+  e->fed = malloc(e->fed_cap * sizeof(int));
+}
+
+/* Append count tokens first, first + 1, ... */
+static void push_run(TokenBuf *tb, int first, int count) {
+  for (int i = 0; i < count; i++)
+    tb->ids[tb->count++] = first + i;
+}
+
+/* Prefill the prompt the way a turn does, skipping what reuse kept */
+static int fake_turn(LocalEngine *e, const TokenBuf *prompt) {
+  float logits[1];
+  int skip = local_engine_reuse(e, prompt);
+  if (skip < 0 || !local_engine_feed(e, prompt->ids + skip,
+                                     prompt->count - skip, logits))
+    return -1;
+  return skip;
+}
+
+TEST(local_engine_truncates_to_shared_prefix) {
+  LocalEngine e;
+  FakeModel fm;
+  fake_engine_init(&e, &fm, &fake_ops);
+  int a[64], b[64];
+  TokenBuf first = {a, 0, 64}, second = {b, 0, 64};
+  push_run(&first, 100, 50);
+  push_run(&second, 100, 10);
+  push_run(&second, 500, 20);
+
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  ASSERT_EQ_INT(50, e.num_exact);
+  ASSERT_EQ_INT(10, fake_turn(&e, &second));
+  ASSERT_EQ_INT(1, fm.truncates);
+  ASSERT_EQ_INT(0, fm.shifts);
+  ASSERT_EQ_INT(30, fm.len);
+  ASSERT_EQ_INT(30, e.num_fed);
+  ASSERT_EQ_INT(30, e.num_exact);
+
+  /* A prompt that only extends what was fed keeps all of it */
+  push_run(&second, 900, 5);
+  ASSERT_EQ_INT(30, fake_turn(&e, &second));
+  ASSERT_EQ_INT(1, fm.truncates);
+  ASSERT_EQ_INT(35, e.num_exact);
+
+  local_engine_cache_prefix(&e);
+  ASSERT_EQ_INT(35, fm.num_cached);
+  ASSERT_EQ_INT(0, memcmp(fm.cached, second.ids, 35 * sizeof(int)));
+  free(e.fed);
+  PASS();
+}
+
+TEST(local_engine_shifts_out_dropped_messages) {
+  LocalEngine e;
+  FakeModel fm;
+  fake_engine_init(&e, &fm, &fake_ops);
+  int a[160], b[160];
+  TokenBuf first = {a, 0, 160}, second = {b, 0, 160};
+  /* System prompt, two messages and a reply; then the oldest is dropped */
+  push_run(&first, 100, 8);
+  push_run(&first, 200, 40);
+  push_run(&first, 300, 40);
+  push_run(&first, 400, 10);
+  push_run(&second, 100, 8);
+  push_run(&second, 300, 40);
+  push_run(&second, 500, 6);
+
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  ASSERT_EQ_INT(48, fake_turn(&e, &second));
+  ASSERT_EQ_INT(1, fm.shifts);
+  ASSERT_EQ_INT(8, fm.shift_keep);
+  ASSERT_EQ_INT(40, fm.shift_discard);
+  /* The reply no longer matches and is truncated after the shift */
+  ASSERT_EQ_INT(1, fm.truncates);
+  ASSERT_EQ_INT(54, fm.len);
+  ASSERT_EQ_INT(54, e.num_fed);
+  ASSERT_EQ_INT(0, memcmp(e.fed, second.ids, 54 * sizeof(int)));
+
+  /* Only the unshifted system prompt is exact */
+  ASSERT_EQ_INT(8, e.num_exact);
+  local_engine_cache_prefix(&e);
+  ASSERT_EQ_INT(8, fm.num_cached);
+  ASSERT_EQ_INT(0, memcmp(fm.cached, second.ids, 8 * sizeof(int)));
+
+  /* Later turns on top of shifted KV do not make it exact again */
+  push_run(&second, 600, 4);
+  ASSERT_EQ_INT(54, fake_turn(&e, &second));
+  ASSERT_EQ_INT(58, e.num_fed);
+  ASSERT_EQ_INT(8, e.num_exact);
+  free(e.fed);
+  PASS();
+}
+
+TEST(local_engine_shift_needs_a_long_match) {
+  LocalEngine e;
+  FakeModel fm;
+  int a[160], b[160];
+  TokenBuf first = {a, 0, 160}, second = {b, 0, 160};
+  push_run(&first, 100, 8);
+  push_run(&first, 200, 40);
+  push_run(&first, 300, 20);
+  push_run(&second, 100, 8);
+  push_run(&second, 300, 20);
+  push_run(&second, 500, 6);
+
+  /* 20 reusable tokens are not worth a shift */
+  fake_engine_init(&e, &fm, &fake_ops);
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  ASSERT_EQ_INT(8, fake_turn(&e, &second));
+  ASSERT_EQ_INT(0, fm.shifts);
+  ASSERT_EQ_INT(1, fm.truncates);
+  ASSERT_EQ_INT(34, e.num_exact);
+  free(e.fed);
+
+  /* Nor is a shift that would drop the attention sink */
+  first.count = second.count = 0;
+  push_run(&first, 100, 2);
+  push_run(&first, 200, 40);
+  push_run(&first, 300, 40);
+  push_run(&second, 100, 2);
+  push_run(&second, 300, 40);
+  push_run(&second, 500, 6);
+  fake_engine_init(&e, &fm, &fake_ops);
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  ASSERT_EQ_INT(2, fake_turn(&e, &second));
+  ASSERT_EQ_INT(0, fm.shifts);
+  ASSERT_EQ_INT(48, e.num_exact);
+  free(e.fed);
+  PASS();
+}
+
+TEST(local_engine_truncates_when_shift_unavailable) {
+  LocalEngine e;
+  FakeModel fm;
+  int a[160], b[160];
+  TokenBuf first = {a, 0, 160}, second = {b, 0, 160};
+  push_run(&first, 100, 8);
+  push_run(&first, 200, 40);
+  push_run(&first, 300, 40);
+  push_run(&second, 100, 8);
+  push_run(&second, 300, 40);
+  push_run(&second, 500, 6);
+
+  /* The model refuses */
+  fake_engine_init(&e, &fm, &fake_ops);
+  fm.can_shift = false;
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  ASSERT_EQ_INT(8, fake_turn(&e, &second));
+  ASSERT_EQ_INT(1, fm.truncates);
+  ASSERT_EQ_INT(54, e.num_fed);
+  ASSERT_EQ_INT(54, e.num_exact);
+  free(e.fed);
+
+  /* The user turned shifting off */
+  setenv("SILLYTUI_CONTEXT_SHIFT", "off", 1);
+  fake_engine_init(&e, &fm, &fake_ops);
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  ASSERT_EQ_INT(8, fake_turn(&e, &second));
+  unsetenv("SILLYTUI_CONTEXT_SHIFT");
+  ASSERT_EQ_INT(0, fm.shifts);
+  ASSERT_EQ_INT(54, e.num_exact);
+  free(e.fed);
+  PASS();
+}
+
+TEST(local_engine_without_truncate_uses_prefix_cache) {
+  LocalEngine e;
+  FakeModel fm;
+  fake_engine_init(&e, &fm, &fake_ops_no_truncate);
+  int a[64], b[64];
+  TokenBuf first = {a, 0, 64}, second = {b, 0, 64};
+  push_run(&first, 100, 30);
+  push_run(&second, 100, 20);
+  push_run(&second, 500, 10);
+
+  ASSERT_EQ_INT(0, fake_turn(&e, &first));
+  fm.prefix_hit = 12;
+  ASSERT_EQ_INT(12, fake_turn(&e, &second));
+  ASSERT_EQ_INT(30, fm.len);
+  ASSERT_EQ_INT(30, e.num_fed);
+  ASSERT_EQ_INT(30, e.num_exact);
+  free(e.fed);
+  PASS();
+}
+
+void run_local_backend_tests(void) {
+  TEST_SUITE("Local Backend");
+
+  RUN_TEST(local_tokens_resolve_from_tokenizer);
+  RUN_TEST(local_tokens_missing_special_tokens_fail);
+  RUN_TEST(local_prompt_renders_chatml);
+  RUN_TEST(local_prompt_drops_oldest_messages);
+  RUN_TEST(local_utf8_complete_len_boundaries);
+  RUN_TEST(local_stream_holds_back_partial_utf8);
+  RUN_TEST(local_stream_routes_reasoning);
+  RUN_TEST(local_engine_truncates_to_shared_prefix);
+  RUN_TEST(local_engine_shifts_out_dropped_messages);
+  RUN_TEST(local_engine_shift_needs_a_long_match);
+  RUN_TEST(local_engine_truncates_when_shift_unavailable);
+  RUN_TEST(local_engine_without_truncate_uses_prefix_cache);
+}
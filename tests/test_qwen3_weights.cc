@@ -0,0 +1,557 @@
+#include "kernels/test_helper.h"
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <string>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+extern "C" {
+#include "inference/backend/threadpool.h"
+#include "inference/model/base.h"
+#include "inference/model/qwen3/qwen3.h"
+#include "inference/model/qwen3/weights.h"
+}
+
+/*
+ * A tiny Qwen3 checkpoint written both as one model.safetensors and as two
+ * shards with a model.safetensors.index.json.
+ */
+#define TW_HIDDEN 32
+#define TW_HEADS 2
+#define TW_KV_HEADS 1
+#define TW_HEAD_DIM 16
+#define TW_INTER 64
+#define TW_VOCAB 48
+#define TW_LAYERS 4
+
+struct test_tensor {
+  std::string name;
+  std::vector<size_t> shape;
+  std::vector<float> data;
+};
+
+static void init_config(model_config_t *config) {
+  memset(config, 0, sizeof(*config));
+  config->hidden_size = TW_HIDDEN;
+  config->num_attention_heads = TW_HEADS;
+  config->num_key_value_heads = TW_KV_HEADS;
+  config->num_hidden_layers = TW_LAYERS;
+  config->intermediate_size = TW_INTER;
+  config->vocab_size = TW_VOCAB;
+  config->head_dim = TW_HEAD_DIM;
+}
+
+static void add_tensor(std::vector<test_tensor> &tensors,
+                       const std::string &name, size_t rows, size_t cols) {
+  test_tensor t;
+  t.name = name;
+  t.shape.push_back(rows);
+  if (cols > 0)
+    t.shape.push_back(cols);
+  size_t n = rows * (cols > 0 ? cols : 1);
+  t.data.resize(n);
+  fill_values(t.data.data(), n, (unsigned)tensors.size());
+  tensors.push_back(t);
+}
+
+static std::vector<test_tensor> make_tensors(void) {
+  std::vector<test_tensor> tensors;
+  int q_dim = TW_HEADS * TW_HEAD_DIM, kv_dim = TW_KV_HEADS * TW_HEAD_DIM;
+  add_tensor(tensors, "model.embed_tokens.weight", TW_VOCAB, TW_HIDDEN);
+  add_tensor(tensors, "model.norm.weight", TW_HIDDEN, 0);
+  add_tensor(tensors, "lm_head.weight", TW_VOCAB, TW_HIDDEN);
+  for (int l = 0; l < TW_LAYERS; l++) {
+    std::string p = "model.layers." + std::to_string(l) + ".";
+    add_tensor(tensors, p + "self_attn.q_proj.weight", q_dim, TW_HIDDEN);
+    add_tensor(tensors, p + "self_attn.k_proj.weight", kv_dim, TW_HIDDEN);
+    add_tensor(tensors, p + "self_attn.v_proj.weight", kv_dim, TW_HIDDEN);
+    add_tensor(tensors, p + "self_attn.o_proj.weight", TW_HIDDEN, q_dim);
+    add_tensor(tensors, p + "self_attn.q_norm.weight", TW_HEAD_DIM, 0);
+    add_tensor(tensors, p + "self_attn.k_norm.weight", TW_HEAD_DIM, 0);
+    add_tensor(tensors, p + "mlp.gate_proj.weight", TW_INTER, TW_HIDDEN);
+    add_tensor(tensors, p + "mlp.up_proj.weight", TW_INTER, TW_HIDDEN);
+    add_tensor(tensors, p + "mlp.down_proj.weight", TW_HIDDEN, TW_INTER);
+    add_tensor(tensors, p + "input_layernorm.weight", TW_HIDDEN, 0);
+    add_tensor(tensors, p + "post_attention_layernorm.weight", TW_HIDDEN, 0);
+  }
+  return tensors;
+}
+
+static bool write_safetensors(const std::string &path,
+                              const std::vector<test_tensor> &tensors,
+                              size_t first, size_t last) {
+  std::string header = "{";
+  size_t offset = 0;
+  for (size_t i = first; i < last; i++) {
+    const test_tensor &t = tensors[i];
+    size_t bytes = t.data.size() * sizeof(float);
+    if (i > first)
+      header += ",";
+    header += "\"" + t.name + "\":{\"dtype\":\"F32\",\"shape\":[";
+    for (size_t d = 0; d < t.shape.size(); d++)
+      header += (d ? "," : "") + std::to_string(t.shape[d]);
+    header += "],\"data_offsets\":[" + std::to_string(offset) + "," +
+              std::to_string(offset + bytes) + "]}";
+    offset += bytes;
+  }
+  header += "}";
+  while (header.size() % 8 != 0)
+    header += " ";
+
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f)
+    return false;
+  uint64_t header_size = header.size();
+  bool ok = fwrite(&header_size, sizeof(header_size), 1, f) == 1 &&
+            fwrite(header.data(), 1, header.size(), f) == header.size();
+  for (size_t i = first; ok && i < last; i++)
+    ok = fwrite(tensors[i].data.data(), sizeof(float), tensors[i].data.size(),
+                f) == tensors[i].data.size();
+  return fclose(f) == 0 && ok;
+}
+
+static std::string test_dir(const char *name) {
+  const char *tmp = getenv("TMPDIR");
+  std::string dir = std::string(tmp ? tmp : "/tmp") + "/" + name;
+  mkdir(dir.c_str(), 0755);
+  return dir;
+}
+
+/* Two shards split between the layers, plus the index naming them */
+static bool write_sharded(const std::string &dir,
+                          const std::vector<test_tensor> &tensors) {
+  size_t split = tensors.size() / 2;
+  const char *files[2] = {"model-00001-of-00002.safetensors",
+                          "model-00002-of-00002.safetensors"};
+  if (!write_safetensors(dir + "/" + files[0], tensors, 0, split) ||
+      !write_safetensors(dir + "/" + files[1], tensors, split, tensors.size()))
+    return false;
+
+  std::string index = "{\"metadata\":{},\"weight_map\":{";
+  for (size_t i = 0; i < tensors.size(); i++)
+    index += std::string(i ? "," : "") + "\"" + tensors[i].name + "\":\"" +
+             files[i < split ? 0 : 1] + "\"";
+  index += "}}";
+  FILE *f = fopen((dir + "/model.safetensors.index.json").c_str(), "wb");
+  if (!f)
+    return false;
+  bool ok = fwrite(index.data(), 1, index.size(), f) == index.size();
+  return fclose(f) == 0 && ok;
+}
+
+static bool write_config(const std::string &dir) {
+  FILE *f = fopen((dir + "/config.json").c_str(), "wb");
+  if (!f)
+    return false;
+  fprintf(f,
+          "{\"model_type\": \"qwen3\", \"hidden_size\": %d, "
+          "\"num_attention_heads\": %d, \"num_key_value_heads\": %d, "
+          "\"num_hidden_layers\": %d, \"intermediate_size\": %d, "
+          "\"vocab_size\": %d, \"head_dim\": %d, "
+          "\"max_position_embeddings\": 64, \"rope_theta\": 10000.0, "
+          "\"rms_norm_eps\": 1e-6, \"hidden_act\": \"silu\", "
+          "\"tie_word_embeddings\": false}",
+          TW_HIDDEN, TW_HEADS, TW_KV_HEADS, TW_LAYERS, TW_INTER, TW_VOCAB,
+          TW_HEAD_DIM);
+  return fclose(f) == 0;
+}
+
+static void remove_files(const std::string &dir) {
+  remove((dir + "/config.json").c_str());
+  remove((dir + "/model.safetensors").c_str());
+  remove((dir + "/model-00001-of-00002.safetensors").c_str());
+  remove((dir + "/model-00002-of-00002.safetensors").c_str());
+  remove((dir + "/model.safetensors.index.json").c_str());
+  remove((dir + "/model.safetensors.f16.packed").c_str());
+  rmdir(dir.c_str());
+}
+
+static bool same_tensor(const tensor_t *a, const tensor_t *b) {
+  if (!a || !b || a->dtype != b->dtype || a->ndim != b->ndim ||
+      a->numel != b->numel)
+    return false;
+  for (int d = 0; d < a->ndim; d++)
+    if (a->shape[d] != b->shape[d])
+      return false;
+  return memcmp(a->data, b->data, dtype_nbytes(a->dtype, a->numel)) == 0;
+}
+
+TEST(qwen3_weights_sharded_matches_single_file) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string single = test_dir("sillytui_weights_single");
+  std::string sharded = test_dir("sillytui_weights_sharded");
+  ASSERT_TRUE(write_safetensors(single + "/model.safetensors", tensors, 0,
+                                tensors.size()));
+  ASSERT_TRUE(write_sharded(sharded, tensors));
+
+  model_config_t config;
+  init_config(&config);
+  /* Fewer threads than layers, so layers load concurrently */
+  threadpool_set_num_threads(2);
+
+  dtype_t dtypes[2] = {DTYPE_F32, DTYPE_F16};
+  for (int i = 0; i < 2; i++) {
+    qwen3_weights_t a, b;
+    ASSERT_TRUE(qwen3_weights_load_mode(
+        &a, &config, (single + "/model.safetensors").c_str(), dtypes[i],
+        QWEN3_LOAD_COPY));
+    ASSERT_TRUE(qwen3_weights_load_mode(
+        &b, &config, (sharded + "/model.safetensors").c_str(), dtypes[i],
+        QWEN3_LOAD_MMAP));
+    ASSERT_EQ(2, b.num_sources);
+
+    ASSERT_TRUE(same_tensor(a.embed_tokens, b.embed_tokens));
+    ASSERT_TRUE(same_tensor(a.final_norm, b.final_norm));
+    ASSERT_TRUE(same_tensor(a.lm_head, b.lm_head));
+    for (int l = 0; l < TW_LAYERS; l++) {
+      const qwen3_layer_weights_t *la = &a.layers[l], *lb = &b.layers[l];
+      ASSERT_TRUE(same_tensor(la->qkv_proj, lb->qkv_proj));
+      ASSERT_TRUE(same_tensor(la->o_proj, lb->o_proj));
+      ASSERT_TRUE(same_tensor(la->q_norm, lb->q_norm));
+      ASSERT_TRUE(same_tensor(la->k_norm, lb->k_norm));
+      ASSERT_TRUE(same_tensor(la->gate_up_proj, lb->gate_up_proj));
+      ASSERT_TRUE(same_tensor(la->down_proj, lb->down_proj));
+      ASSERT_TRUE(same_tensor(la->input_norm, lb->input_norm));
+      ASSERT_TRUE(same_tensor(la->post_attn_norm, lb->post_attn_norm));
+    }
+    qwen3_weights_free(&a);
+    qwen3_weights_free(&b);
+  }
+
+  threadpool_set_num_threads(0);
+  remove_files(single);
+  remove_files(sharded);
+  PASS();
+}
+
+TEST(qwen3_weights_sharded_missing_shard_fails) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string dir = test_dir("sillytui_weights_missing_shard");
+  ASSERT_TRUE(write_sharded(dir, tensors));
+  remove((dir + "/model-00002-of-00002.safetensors").c_str());
+
+  model_config_t config;
+  init_config(&config);
+  qwen3_weights_t w;
+  ASSERT_FALSE(qwen3_weights_load_mode(
+      &w, &config, (dir + "/model.safetensors").c_str(), DTYPE_F32,
+      QWEN3_LOAD_MMAP));
+
+  remove_files(dir);
+  PASS();
+}
+
+TEST(qwen3_weights_sharded_cache_tracks_shards) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string dir = test_dir("sillytui_weights_shard_cache");
+  std::string path = dir + "/model.safetensors";
+  ASSERT_TRUE(write_sharded(dir, tensors));
+
+  model_config_t config;
+  init_config(&config);
+  qwen3_weights_t w;
+  ASSERT_TRUE(qwen3_weights_load_mode(&w, &config, path.c_str(), DTYPE_F16,
+                                      QWEN3_LOAD_PREPACKED));
+  qwen3_weights_free(&w);
+  struct stat st;
+  ASSERT_EQ(0, stat((path + ".f16.packed").c_str(), &st));
+
+  /*
+   * Re-download the second shard with other values of the same size; the
+   * index keeps its size and mtime, so only the shard can tell the packed
+   * copy is stale
+   */
+  for (size_t i = 0; i < tensors.size(); i++)
+    for (size_t j = 0; j < tensors[i].data.size(); j++)
+      tensors[i].data[j] = -tensors[i].data[j];
+  std::string shard = dir + "/model-00002-of-00002.safetensors";
+  ASSERT_TRUE(
+      write_safetensors(shard, tensors, tensors.size() / 2, tensors.size()));
+  struct timespec times[2] = {{0, UTIME_OMIT}, {1000000000, 0}};
+  ASSERT_EQ(0, utimensat(AT_FDCWD, shard.c_str(), times, 0));
+
+  qwen3_weights_t cached, copied;
+  ASSERT_TRUE(qwen3_weights_load_mode(&cached, &config, path.c_str(),
+                                      DTYPE_F16, QWEN3_LOAD_PREPACKED));
+  ASSERT_TRUE(qwen3_weights_load_mode(&copied, &config, path.c_str(),
+                                      DTYPE_F16, QWEN3_LOAD_COPY));
+  const qwen3_layer_weights_t *a = &cached.layers[TW_LAYERS - 1];
+  const qwen3_layer_weights_t *b = &copied.layers[TW_LAYERS - 1];
+  ASSERT_TRUE(same_tensor(a->qkv_proj, b->qkv_proj));
+  ASSERT_TRUE(same_tensor(a->down_proj, b->down_proj));
+  qwen3_weights_free(&cached);
+  qwen3_weights_free(&copied);
+
+  remove_files(dir);
+  PASS();
+}
+
+struct progress_log {
+  size_t bytes_done, bytes_total;
+  int tensors_done, tensors_total;
+  int calls;
+  bool monotonic;
+};
+
+static void record_progress(void *user, size_t bytes_done, size_t bytes_total,
+                            int tensors_done, int tensors_total) {
+  progress_log *log = (progress_log *)user;
+  if (bytes_done < log->bytes_done || tensors_done < log->tensors_done ||
+      bytes_done > bytes_total || tensors_done > tensors_total)
+    log->monotonic = false;
+  log->bytes_done = bytes_done;
+  log->bytes_total = bytes_total;
+  log->tensors_done = tensors_done;
+  log->tensors_total = tensors_total;
+  log->calls++;
+}
+
+TEST(qwen3_weights_progress_counts_every_tensor) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string dir = test_dir("sillytui_weights_progress");
+  ASSERT_TRUE(write_sharded(dir, tensors));
+  size_t bytes = 0;
+  for (size_t i = 0; i < tensors.size(); i++)
+    bytes += tensors[i].data.size() * sizeof(float);
+
+  model_config_t config;
+  init_config(&config);
+  threadpool_set_num_threads(2);
+  setenv("SILLYTUI_WEIGHTS_LOAD", "mmap", 1);
+
+  progress_log log = {0, 0, 0, 0, 0, true};
+  qwen3_weights_t w;
+  ASSERT_TRUE(qwen3_weights_load_progress(
+      &w, &config, (dir + "/model.safetensors").c_str(), DTYPE_F16,
+      record_progress, &log));
+  /* Once per layer, plus the tensors outside the layers */
+  ASSERT_EQ(TW_LAYERS + 1, log.calls);
+  ASSERT_TRUE(log.monotonic);
+  ASSERT_EQ(bytes, log.bytes_total);
+  ASSERT_EQ(bytes, log.bytes_done);
+  ASSERT_EQ((int)tensors.size(), log.tensors_total);
+  ASSERT_EQ((int)tensors.size(), log.tensors_done);
+  qwen3_weights_free(&w);
+
+  unsetenv("SILLYTUI_WEIGHTS_LOAD");
+  threadpool_set_num_threads(0);
+  remove_files(dir);
+  PASS();
+}
+
+TEST(inference_model_load_async_matches_sync) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string dir = test_dir("sillytui_weights_async");
+  ASSERT_TRUE(write_safetensors(dir + "/model.safetensors", tensors, 0,
+                                tensors.size()));
+  ASSERT_TRUE(write_config(dir));
+  setenv("SILLYTUI_WEIGHTS_LOAD", "mmap", 1);
+
+  inference_model_t sync_model, async_model;
+  ASSERT_TRUE(inference_model_load(&sync_model, "qwen3", dir.c_str(),
+                                   INFERENCE_DTYPE_F32));
+  ASSERT_TRUE(inference_model_load_async(&async_model, "qwen3", dir.c_str(),
+                                         INFERENCE_DTYPE_F32));
+
+  inference_load_progress_t progress;
+  do {
+    inference_model_load_progress(&async_model, &progress);
+    ASSERT_TRUE(progress.bytes_done <= progress.bytes_total);
+  } while (!progress.done);
+  ASSERT_TRUE(progress.ok);
+  ASSERT_EQ((int)tensors.size(), progress.tensors_done);
+  ASSERT_TRUE(inference_model_wait(&async_model));
+  ASSERT_EQ(TW_VOCAB, async_model.vocab_size);
+
+  const int tokens[3] = {1, 7, 3};
+  std::vector<float> expected(TW_VOCAB), actual(TW_VOCAB);
+  ASSERT_TRUE(
+      inference_model_forward(&sync_model, expected.data(), tokens, 3));
+  ASSERT_TRUE(
+      inference_model_forward(&async_model, actual.data(), tokens, 3));
+  ASSERT_EQ(0, memcmp(expected.data(), actual.data(),
+                      TW_VOCAB * sizeof(float)));
+
+  inference_model_free(&sync_model);
+  inference_model_free(&async_model);
+  unsetenv("SILLYTUI_WEIGHTS_LOAD");
+  remove_files(dir);
+  PASS();
+}
+
+TEST(inference_model_load_async_reports_failure) {
+  std::string dir = test_dir("sillytui_weights_async_missing");
+  ASSERT_TRUE(write_config(dir));
+
+  /* The config is there, the weights are not */
+  inference_model_t model;
+  ASSERT_TRUE(inference_model_load_async(&model, "qwen3", dir.c_str(),
+                                         INFERENCE_DTYPE_F32));
+  ASSERT_FALSE(inference_model_wait(&model));
+  inference_load_progress_t progress;
+  inference_model_load_progress(&model, &progress);
+  ASSERT_TRUE(progress.done);
+  ASSERT_FALSE(progress.ok);
+  float logits[TW_VOCAB];
+  const int token = 1;
+  ASSERT_FALSE(inference_model_forward(&model, logits, &token, 1));
+  inference_model_free(&model);
+
+  remove_files(dir);
+  PASS();
+}
+
+/* Key (or value) element i of one layer and position, dequantized */
+static float kv_elem(const kv_block_table_t *kv, int layer, int pos, int i,
+                     bool key) {
+  const void *row = key ? kv_block_table_key(kv, layer, pos)
+                        : kv_block_table_value(kv, layer, pos);
+  if (kv->pool->elem_size != KV_CACHE_INT8)
+    return ((const float *)row)[i];
+  const float *scales = key ? kv_block_table_key_scales(kv, layer, pos)
+                            : kv_block_table_value_scales(kv, layer, pos);
+  return ((const int8_t *)row)[i] * scales[i / TW_HEAD_DIM];
+}
+
+TEST(qwen3_chunked_prefill_matches_single_pass) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string dir = test_dir("sillytui_weights_chunked");
+  ASSERT_TRUE(write_safetensors(dir + "/model.safetensors", tensors, 0,
+                                tensors.size()));
+  ASSERT_TRUE(write_config(dir));
+
+  qwen3_model_t model;
+  memset(&model, 0, sizeof(model));
+  ASSERT_TRUE(qwen3_model_load(&model, dir.c_str(), DTYPE_F32));
+
+  int tokens[60];
+  for (int i = 0; i < 60; i++)
+    tokens[i] = (i * 7 + 3) % TW_VOCAB;
+
+  /* 11 tokens in chunks of 4: two passes without logits, then the last */
+  kv_block_table_t whole, chunked;
+  kv_block_table_init(&whole, model.kv_pool);
+  kv_block_table_init(&chunked, model.kv_pool);
+  std::vector<float> expected(TW_VOCAB), actual(TW_VOCAB);
+  model.prefill_chunk = 0;
+  ASSERT_TRUE(qwen3_forward_seq(&model, &whole, expected.data(), tokens, 11));
+  model.prefill_chunk = 4;
+  ASSERT_TRUE(qwen3_forward_seq(&model, &chunked, actual.data(), tokens, 11));
+  ASSERT_EQ(11, chunked.len);
+  for (int i = 0; i < TW_VOCAB; i++)
+    ASSERT_NEAR(expected[i], actual[i], 1e-4f);
+  int kv_dim = TW_KV_HEADS * TW_HEAD_DIM;
+  for (int l = 0; l < TW_LAYERS; l++) {
+    for (int pos = 0; pos < 11; pos++) {
+      for (int i = 0; i < kv_dim; i++) {
+        ASSERT_NEAR(kv_elem(&whole, l, pos, i, true),
+                    kv_elem(&chunked, l, pos, i, true), 1e-4f);
+        ASSERT_NEAR(kv_elem(&whole, l, pos, i, false),
+                    kv_elem(&chunked, l, pos, i, false), 1e-4f);
+      }
+    }
+  }
+
+  /*
+   * 5 cached plus 60 new tokens outgrow the 64-position window on the last
+   * chunk, after three chunks were already written: the sequence must come
+   * back at 5 tokens and still continue correctly
+   */
+  kv_block_table_t failed, fresh;
+  kv_block_table_init(&failed, model.kv_pool);
+  kv_block_table_init(&fresh, model.kv_pool);
+  model.prefill_chunk = 16;
+  ASSERT_TRUE(qwen3_forward_seq(&model, &failed, actual.data(), tokens, 5));
+  ASSERT_FALSE(qwen3_forward_seq(&model, &failed, actual.data(), tokens, 60));
+  ASSERT_EQ(5, failed.len);
+  ASSERT_TRUE(
+      qwen3_forward_seq(&model, &failed, actual.data(), tokens + 5, 1));
+  ASSERT_TRUE(qwen3_forward_seq(&model, &fresh, expected.data(), tokens, 6));
+  for (int i = 0; i < TW_VOCAB; i++)
+    ASSERT_NEAR(expected[i], actual[i], 1e-4f);
+
+  kv_block_table_free(&whole);
+  kv_block_table_free(&chunked);
+  kv_block_table_free(&failed);
+  kv_block_table_free(&fresh);
+  qwen3_model_free(&model);
+  remove_files(dir);
+  PASS();
+}
+
+TEST(qwen3_seq_shift_repositions_keys) {
+  std::vector<test_tensor> tensors = make_tensors();
+  std::string dir = test_dir("sillytui_weights_shift");
+  ASSERT_TRUE(write_safetensors(dir + "/model.safetensors", tensors, 0,
+                                tensors.size()));
+  ASSERT_TRUE(write_config(dir));
+
+  const int tokens[12] = {1, 7, 3, 9, 11, 13, 5, 2, 40, 21, 8, 30};
+  const int kept[9] = {1, 7, 3, 2, 40, 21, 8, 30, 4};
+  for (int int8 = 0; int8 < 2; int8++) {
+    if (int8)
+      setenv("SILLYTUI_KV_CACHE", "int8", 1);
+    qwen3_model_t model;
+    memset(&model, 0, sizeof(model));
+    ASSERT_TRUE(qwen3_model_load(&model, dir.c_str(), DTYPE_F32));
+
+    kv_block_table_t shifted, fresh;
+    kv_block_table_init(&shifted, model.kv_pool);
+    kv_block_table_init(&fresh, model.kv_pool);
+    std::vector<float> logits(TW_VOCAB);
+    ASSERT_TRUE(
+        qwen3_forward_seq(&model, &shifted, logits.data(), tokens, 12));
+
+    /* Keep 3 sink tokens, drop 4 and continue from the shortened window */
+    ASSERT_FALSE(qwen3_seq_shift(&model, &shifted, 3, 10));
+    ASSERT_TRUE(qwen3_seq_shift(&model, &shifted, 3, 4));
+    ASSERT_EQ(8, shifted.len);
+    ASSERT_TRUE(
+        qwen3_forward_seq(&model, &shifted, logits.data(), kept + 8, 1));
+    ASSERT_TRUE(qwen3_forward_seq(&model, &fresh, logits.data(), kept, 9));
+    ASSERT_EQ(fresh.len, shifted.len);
+
+    /*
+     * The first layer's K/V depend on the token and position only, so
+     * there the shift must reproduce a prefill of the shortened sequence
+     */
+    int kv_dim = TW_KV_HEADS * TW_HEAD_DIM;
+    for (int pos = 0; pos < 9; pos++) {
+      float tol = 1e-4f;
+      if (int8)
+        tol = 2.0f * kv_block_table_key_scales(&fresh, 0, pos)[0];
+      for (int i = 0; i < kv_dim; i++) {
+        ASSERT_NEAR(kv_elem(&fresh, 0, pos, i, true),
+                    kv_elem(&shifted, 0, pos, i, true), tol);
+        ASSERT_NEAR(kv_elem(&fresh, 0, pos, i, false),
+                    kv_elem(&shifted, 0, pos, i, false), tol);
+      }
+    }
+
+    kv_block_table_free(&shifted);
+    kv_block_table_free(&fresh);
+    qwen3_model_free(&model);
+    unsetenv("SILLYTUI_KV_CACHE");
+  }
+
+  remove_files(dir);
+  PASS();
+}
+
+extern "C" {
+void run_qwen3_weights_tests(void) {
+  TEST_SUITE("Qwen3 Weights");
+  RUN_TEST(qwen3_weights_sharded_matches_single_file);
+  RUN_TEST(qwen3_weights_sharded_missing_shard_fails);
+  RUN_TEST(qwen3_weights_sharded_cache_tracks_shards);
+  RUN_TEST(qwen3_weights_progress_counts_every_tensor);
+  RUN_TEST(inference_model_load_async_matches_sync);
+  RUN_TEST(inference_model_load_async_reports_failure);
+  RUN_TEST(qwen3_chunked_prefill_matches_single_pass);
+  RUN_TEST(qwen3_seq_shift_repositions_keys);
+}
+}
@@ -239,6 +239,52 @@ TEST(sampler_add_custom_default_step_int) {
   PASS();
 }
 
+TEST(sampler_chain_params_defaults_are_off) {
+  SamplerSettings s;
+  sampler_init_defaults(&s);
+  sampling_chain_params_t p;
+  sampler_chain_params(&s, &p);
+  ASSERT_NEAR(1.0, p.temperature, 0.001);
+  ASSERT_TRUE(p.top_k <= 0);
+  ASSERT_NEAR(1.0, p.top_p, 0.001);
+  ASSERT_NEAR(1.0, p.typical_p, 0.001);
+  ASSERT_NEAR(1.0, p.tfs, 0.001);
+  ASSERT_NEAR(1.0, p.repetition_penalty, 0.001);
+  ASSERT_NEAR(0.0, p.dry_multiplier, 0.001);
+  ASSERT_NEAR(0.0, p.xtc_probability, 0.001);
+  ASSERT_EQ(0, p.mirostat_mode);
+  ASSERT_EQ(0, p.penalty_range);
+  ASSERT_EQ(0, p.num_dry_breakers);
+  ASSERT_EQ(-1, p.eos_token_id);
+  PASS();
+}
+
+TEST(sampler_chain_params_copies_settings) {
+  SamplerSettings s;
+  sampler_init_defaults(&s);
+  s.temperature = 0.7;
+  s.top_k = 40;
+  s.min_p = 0.05;
+  s.repetition_penalty = 1.1;
+  s.dry_multiplier = 0.8;
+  s.dry_allowed_length = 3;
+  s.mirostat_mode = 2;
+  s.mirostat_tau = 5.0;
+  s.min_tokens = 16;
+  sampling_chain_params_t p;
+  sampler_chain_params(&s, &p);
+  ASSERT_NEAR(0.7, p.temperature, 0.001);
+  ASSERT_EQ(40, p.top_k);
+  ASSERT_NEAR(0.05, p.min_p, 0.001);
+  ASSERT_NEAR(1.1, p.repetition_penalty, 0.001);
+  ASSERT_NEAR(0.8, p.dry_multiplier, 0.001);
+  ASSERT_EQ(3, p.dry_allowed_length);
+  ASSERT_EQ(2, p.mirostat_mode);
+  ASSERT_NEAR(5.0, p.mirostat_tau, 0.001);
+  ASSERT_EQ(16, p.min_tokens);
+  PASS();
+}
+
 void run_sampler_tests(void) {
   TEST_SUITE("Sampler Settings");
   RUN_TEST(sampler_init_defaults_temperature);
@@ -265,4 +311,6 @@ void run_sampler_tests(void) {
   RUN_TEST(sampler_remove_custom_invalid);
   RUN_TEST(sampler_add_custom_default_step_float);
   RUN_TEST(sampler_add_custom_default_step_int);
+  RUN_TEST(sampler_chain_params_defaults_are_off);
+  RUN_TEST(sampler_chain_params_copies_settings);
 }
@@ -0,0 +1,350 @@
+#include "test_framework.h"
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include "inference/model/scheduler.h"
+}
+
+/*
+ * Fake model: the logits of a sequence put all mass on (last token + 1), so
+ * greedy decoding counts upwards from the last prompt token.
+ */
+#define FAKE_VOCAB 64
+#define FAKE_MAX_SEQ 32
+
+struct inference_seq {
+  int len;
+};
+
+struct fake_model_state {
+  int calls;
+  int max_seqs_per_call;
+  int live_seqs;
+  bool fail;
+  int cached[FAKE_MAX_SEQ]; /* Tokens of the last sequence offered */
+  int num_cached;
+};
+
+static fake_model_state fake;
+
+static inference_seq_t *fake_seq_create(inference_model_t *model) {
+  (void)model;
+  fake.live_seqs++;
+  return (inference_seq_t *)calloc(1, sizeof(inference_seq_t));
+}
+
+static void fake_seq_free(inference_model_t *model, inference_seq_t *seq) {
+  (void)model;
+  fake.live_seqs--;
+  free(seq);
+}
+
+static bool fake_forward_batch(inference_model_t *model,
+                               inference_seq_t *const *seqs,
+                               const int *const *token_ids,
+                               const int *num_tokens, int num_seqs,
+                               float *logits) {
+  (void)model;
+  if (fake.fail)
+    return false;
+  for (int s = 0; s < num_seqs; s++) {
+    if (seqs[s]->len + num_tokens[s] > FAKE_MAX_SEQ)
+      return false;
+    seqs[s]->len += num_tokens[s];
+    float *row = logits + s * FAKE_VOCAB;
+    for (int v = 0; v < FAKE_VOCAB; v++)
+      row[v] = 0.0f;
+    row[(token_ids[s][num_tokens[s] - 1] + 1) % FAKE_VOCAB] = 1.0f;
+  }
+  fake.calls++;
+  if (num_seqs > fake.max_seqs_per_call)
+    fake.max_seqs_per_call = num_seqs;
+  return true;
+}
+
+/* A one-entry prefix cache that matches at token granularity */
+static int fake_seq_reuse_prefix(inference_model_t *model,
+                                 inference_seq_t *seq, const int *tokens,
+                                 int num_tokens) {
+  (void)model;
+  int n = 0;
+  while (n < num_tokens && n < fake.num_cached && tokens[n] == fake.cached[n])
+    n++;
+  seq->len = n;
+  return n;
+}
+
+static void fake_seq_cache_prefix(inference_model_t *model,
+                                  inference_seq_t *seq, const int *tokens,
+                                  int num_tokens) {
+  (void)model;
+  if (num_tokens > seq->len)
+    num_tokens = seq->len;
+  memcpy(fake.cached, tokens, num_tokens * sizeof(int));
+  fake.num_cached = num_tokens;
+}
+
+static inference_model_ops_t fake_ops;
+
+static void init_fake_model(inference_model_t *model) {
+  memset(&fake, 0, sizeof(fake));
+  memset(&fake_ops, 0, sizeof(fake_ops));
+  fake_ops.seq_create = fake_seq_create;
+  fake_ops.seq_free = fake_seq_free;
+  fake_ops.forward_batch = fake_forward_batch;
+  memset(model, 0, sizeof(*model));
+  model->ops = &fake_ops;
+  model->vocab_size = FAKE_VOCAB;
+  model->max_seq_len = FAKE_MAX_SEQ;
+}
+
+static scheduler_params_t greedy_params(int max_tokens) {
+  scheduler_params_t params;
+  memset(&params, 0, sizeof(params));
+  params.max_tokens = max_tokens;
+  params.eos_token_id = -1;
+  return params;
+}
+
+static int run_to_completion(scheduler_t *sched) {
+  int steps = 0;
+  while (scheduler_num_active(sched) > 0 && steps < 1000) {
+    if (scheduler_step(sched) < 0)
+      return -1;
+    steps++;
+  }
+  return steps;
+}
+
+TEST(scheduler_single_sequence) {
+  inference_model_t model;
+  init_fake_model(&model);
+  scheduler_t *sched = scheduler_create(&model, NULL);
+  ASSERT_NOT_NULL(sched);
+
+  int prompt[3] = {1, 2, 3};
+  scheduler_params_t params = greedy_params(4);
+  int id = scheduler_submit(sched, prompt, 3, &params, NULL, NULL);
+  ASSERT_TRUE(id >= 0);
+  ASSERT_EQ(SCHED_SEQ_PREFILL, scheduler_seq_state(sched, id));
+
+  /* One prefill step plus one step per fed-back token */
+  ASSERT_EQ_INT(4, run_to_completion(sched));
+  ASSERT_EQ(SCHED_SEQ_FINISHED, scheduler_seq_state(sched, id));
+
+  int n = 0;
+  const int *out = scheduler_seq_output(sched, id, &n);
+  ASSERT_EQ_INT(4, n);
+  for (int i = 0; i < 4; i++)
+    ASSERT_EQ_INT(4 + i, out[i]);
+  ASSERT_EQ_INT(0, fake.live_seqs);
+
+  scheduler_release(sched, id);
+  ASSERT_EQ(SCHED_SEQ_UNKNOWN, scheduler_seq_state(sched, id));
+  scheduler_destroy(sched);
+  PASS();
+}
+
+TEST(scheduler_batches_decodes) {
+  inference_model_t model;
+  init_fake_model(&model);
+  scheduler_t *sched = scheduler_create(&model, NULL);
+  ASSERT_NOT_NULL(sched);
+
+  int ids[4];
+  for (int s = 0; s < 4; s++) {
+    int prompt[2] = {10 * s, 10 * s + 1};
+    scheduler_params_t params = greedy_params(5);
+    ids[s] = scheduler_submit(sched, prompt, 2, &params, NULL, NULL);
+    ASSERT_TRUE(ids[s] >= 0);
+  }
+
+  /* All four sequences share every forward pass */
+  ASSERT_EQ_INT(5, run_to_completion(sched));
+  ASSERT_EQ_INT(5, fake.calls);
+  ASSERT_EQ_INT(4, fake.max_seqs_per_call);
+
+  for (int s = 0; s < 4; s++) {
+    int n = 0;
+    const int *out = scheduler_seq_output(sched, ids[s], &n);
+    ASSERT_EQ_INT(5, n);
+    for (int i = 0; i < 5; i++)
+      ASSERT_EQ_INT(10 * s + 2 + i, out[i]);
+  }
+
+  scheduler_stats_t stats;
+  scheduler_get_stats(sched, &stats);
+  ASSERT_EQ_INT(8, (int)stats.prefill_tokens);
+  ASSERT_EQ_INT(20, (int)stats.decode_tokens);
+  scheduler_destroy(sched);
+  PASS();
+}
+
+TEST(scheduler_chunked_prefill_interleaves) {
+  inference_model_t model;
+  init_fake_model(&model);
+  scheduler_config_t config = {4, 6, 4};
+  scheduler_t *sched = scheduler_create(&model, &config);
+  ASSERT_NOT_NULL(sched);
+
+  int short_prompt[1] = {40};
+  scheduler_params_t params = greedy_params(6);
+  int a = scheduler_submit(sched, short_prompt, 1, &params, NULL, NULL);
+  ASSERT_EQ_INT(1, scheduler_step(sched));
+  ASSERT_EQ(SCHED_SEQ_DECODE, scheduler_seq_state(sched, a));
+
+  /* A long prompt arrives while a is decoding */
+  int long_prompt[10];
+  for (int i = 0; i < 10; i++)
+    long_prompt[i] = i;
+  int b = scheduler_submit(sched, long_prompt, 10, &params, NULL, NULL);
+
+  /* Each step: a's decode token plus up to 4 prompt tokens of b */
+  ASSERT_EQ_INT(5, scheduler_step(sched));
+  ASSERT_EQ(SCHED_SEQ_PREFILL, scheduler_seq_state(sched, b));
+  ASSERT_EQ_INT(5, scheduler_step(sched));
+  ASSERT_EQ_INT(3, scheduler_step(sched));
+  ASSERT_EQ(SCHED_SEQ_DECODE, scheduler_seq_state(sched, b));
+
+  int n = 0;
+  const int *out = scheduler_seq_output(sched, a, &n);
+  ASSERT_EQ_INT(4, n);
+  out = scheduler_seq_output(sched, b, &n);
+  ASSERT_EQ_INT(1, n);
+  ASSERT_EQ_INT(10, out[0]);
+
+  ASSERT_TRUE(run_to_completion(sched) > 0);
+  out = scheduler_seq_output(sched, b, &n);
+  ASSERT_EQ_INT(6, n);
+  ASSERT_EQ_INT(15, out[5]);
+  scheduler_destroy(sched);
+  PASS();
+}
+
+static int cb_tokens;
+static int cb_finished;
+
+static void count_tokens(int seq_id, int token, bool finished, void *ud) {
+  (void)seq_id;
+  (void)token;
+  (void)ud;
+  cb_tokens++;
+  if (finished)
+    cb_finished++;
+}
+
+TEST(scheduler_cancel_and_stop) {
+  inference_model_t model;
+  init_fake_model(&model);
+  scheduler_t *sched = scheduler_create(&model, NULL);
+  ASSERT_NOT_NULL(sched);
+  cb_tokens = 0;
+  cb_finished = 0;
+
+  int prompt[1] = {5};
+  scheduler_params_t params = greedy_params(20);
+  int a = scheduler_submit(sched, prompt, 1, &params, count_tokens, NULL);
+  params.eos_token_id = 8;
+  int b = scheduler_submit(sched, prompt, 1, &params, count_tokens, NULL);
+
+  ASSERT_TRUE(scheduler_step(sched) > 0);
+  ASSERT_TRUE(scheduler_cancel(sched, a));
+  ASSERT_FALSE(scheduler_cancel(sched, a));
+  ASSERT_EQ(SCHED_SEQ_CANCELLED, scheduler_seq_state(sched, a));
+  ASSERT_EQ_INT(1, fake.live_seqs);
+
+  /* b stops at its EOS token: 6, 7, 8 */
+  run_to_completion(sched);
+  int n = 0;
+  const int *out = scheduler_seq_output(sched, b, &n);
+  ASSERT_EQ_INT(3, n);
+  ASSERT_EQ_INT(8, out[2]);
+  ASSERT_EQ(SCHED_SEQ_FINISHED, scheduler_seq_state(sched, b));
+  ASSERT_EQ_INT(4, cb_tokens);
+  ASSERT_EQ_INT(1, cb_finished);
+  ASSERT_EQ_INT(0, fake.live_seqs);
+  scheduler_destroy(sched);
+  PASS();
+}
+
+TEST(scheduler_context_limit_and_failure) {
+  inference_model_t model;
+  init_fake_model(&model);
+  scheduler_t *sched = scheduler_create(&model, NULL);
+  ASSERT_NOT_NULL(sched);
+
+  int prompt[FAKE_MAX_SEQ + 1] = {0};
+  scheduler_params_t params = greedy_params(100);
+  ASSERT_EQ_INT(-1, scheduler_submit(sched, prompt, FAKE_MAX_SEQ + 1, &params,
+                                     NULL, NULL));
+
+  /* Generation stops when the context is full */
+  int id = scheduler_submit(sched, prompt, FAKE_MAX_SEQ - 2, &params, NULL,
+                            NULL);
+  ASSERT_TRUE(run_to_completion(sched) > 0);
+  int n = 0;
+  scheduler_seq_output(sched, id, &n);
+  ASSERT_EQ_INT(3, n);
+  ASSERT_EQ(SCHED_SEQ_FINISHED, scheduler_seq_state(sched, id));
+
+  fake.fail = true;
+  id = scheduler_submit(sched, prompt, 2, &params, NULL, NULL);
+  ASSERT_EQ_INT(-1, scheduler_step(sched));
+  ASSERT_EQ(SCHED_SEQ_FAILED, scheduler_seq_state(sched, id));
+  ASSERT_EQ_INT(0, scheduler_num_active(sched));
+  ASSERT_EQ_INT(0, fake.live_seqs);
+  scheduler_destroy(sched);
+  PASS();
+}
+
+TEST(scheduler_reuses_cached_prefix) {
+  inference_model_t model;
+  init_fake_model(&model);
+  fake_ops.seq_reuse_prefix = fake_seq_reuse_prefix;
+  fake_ops.seq_cache_prefix = fake_seq_cache_prefix;
+  scheduler_t *sched = scheduler_create(&model, NULL);
+  ASSERT_NOT_NULL(sched);
+
+  /* First turn: 5 prompt tokens, 3 sampled of which 2 were fed back */
+  int turn1[5] = {1, 2, 3, 4, 5};
+  scheduler_params_t params = greedy_params(3);
+  scheduler_submit(sched, turn1, 5, &params, NULL, NULL);
+  ASSERT_TRUE(run_to_completion(sched) > 0);
+  ASSERT_EQ_INT(7, fake.num_cached);
+  ASSERT_EQ_INT(7, fake.cached[6]);
+
+  /* Second turn repeats the history, only the new token is prefilled */
+  int turn2[8] = {1, 2, 3, 4, 5, 6, 7, 20};
+  int id = scheduler_submit(sched, turn2, 8, &params, NULL, NULL);
+  ASSERT_EQ_INT(1, scheduler_step(sched));
+  int n = 0;
+  const int *out = scheduler_seq_output(sched, id, &n);
+  ASSERT_EQ_INT(1, n);
+  ASSERT_EQ_INT(21, out[0]);
+
+  /* A prompt covered entirely by the cache still runs its last token */
+  id = scheduler_submit(sched, turn2, 7, &params, NULL, NULL);
+  ASSERT_EQ_INT(2, scheduler_step(sched));
+  out = scheduler_seq_output(sched, id, &n);
+  ASSERT_EQ_INT(8, out[0]);
+
+  scheduler_stats_t stats;
+  scheduler_get_stats(sched, &stats);
+  ASSERT_EQ_INT(13, (int)stats.cached_tokens);
+  ASSERT_EQ_INT(7, (int)stats.prefill_tokens);
+  scheduler_destroy(sched);
+  PASS();
+}
+
+extern "C" {
+void run_scheduler_tests(void) {
+  TEST_SUITE("Scheduler");
+  RUN_TEST(scheduler_single_sequence);
+  RUN_TEST(scheduler_batches_decodes);
+  RUN_TEST(scheduler_chunked_prefill_interleaves);
+  RUN_TEST(scheduler_cancel_and_stop);
+  RUN_TEST(scheduler_context_limit_and_failure);
+  RUN_TEST(scheduler_reuses_cached_prefix);
+}
+}
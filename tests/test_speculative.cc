@@ -0,0 +1,298 @@
+#include "test_framework.h"
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+extern "C" {
+#include "inference/model/speculative.h"
+}
+
+/*
+ * Fake models: the logits after a token put all mass on (token + step) %
+ * modulus, so greedy decoding counts upwards from the last prompt token. A
+ * model with fixed logits ignores the context instead.
+ */
+#define FAKE_VOCAB 64
+
+struct inference_seq {
+  int len;
+};
+
+struct spec_fake_model {
+  int step;
+  int modulus;
+  const float *fixed; /* [FAKE_VOCAB] logits for every position, or NULL */
+  int live_seqs;
+  int forward_calls;
+  int last_len; /* Length of the last sequence freed */
+};
+
+static inference_seq_t *spec_seq_create(inference_model_t *model) {
+  ((spec_fake_model *)model->impl)->live_seqs++;
+  return (inference_seq_t *)calloc(1, sizeof(inference_seq_t));
+}
+
+static void spec_seq_free(inference_model_t *model, inference_seq_t *seq) {
+  spec_fake_model *fm = (spec_fake_model *)model->impl;
+  fm->live_seqs--;
+  fm->last_len = seq->len;
+  free(seq);
+}
+
+static void spec_row(const spec_fake_model *fm, int token, float *row) {
+  if (fm->fixed) {
+    memcpy(row, fm->fixed, FAKE_VOCAB * sizeof(float));
+    return;
+  }
+  for (int v = 0; v < FAKE_VOCAB; v++)
+    row[v] = 0.0f;
+  row[(token + fm->step) % fm->modulus] = 1.0f;
+}
+
+static bool spec_forward_batch(inference_model_t *model,
+                               inference_seq_t *const *seqs,
+                               const int *const *token_ids,
+                               const int *num_tokens, int num_seqs,
+                               float *logits) {
+  spec_fake_model *fm = (spec_fake_model *)model->impl;
+  for (int s = 0; s < num_seqs; s++) {
+    if (seqs[s]->len + num_tokens[s] > model->max_seq_len)
+      return false;
+    seqs[s]->len += num_tokens[s];
+    spec_row(fm, token_ids[s][num_tokens[s] - 1], logits + s * FAKE_VOCAB);
+  }
+  fm->forward_calls++;
+  return true;
+}
+
+static bool spec_forward_all(inference_model_t *model, inference_seq_t *seq,
+                             const int *token_ids, int num_tokens,
+                             float *logits) {
+  spec_fake_model *fm = (spec_fake_model *)model->impl;
+  if (seq->len + num_tokens > model->max_seq_len)
+    return false;
+  seq->len += num_tokens;
+  for (int i = 0; i < num_tokens; i++)
+    spec_row(fm, token_ids[i], logits + i * FAKE_VOCAB);
+  fm->forward_calls++;
+  return true;
+}
+
+static void spec_truncate(inference_model_t *model, inference_seq_t *seq,
+                          int len) {
+  (void)model;
+  if (len < seq->len)
+    seq->len = len;
+}
+
+static inference_model_ops_t spec_ops;
+
+static void init_spec_model(inference_model_t *model, spec_fake_model *fm,
+                            int step, int modulus) {
+  memset(&spec_ops, 0, sizeof(spec_ops));
+  spec_ops.seq_create = spec_seq_create;
+  spec_ops.seq_free = spec_seq_free;
+  spec_ops.forward_batch = spec_forward_batch;
+  spec_ops.seq_forward_all = spec_forward_all;
+  spec_ops.seq_truncate = spec_truncate;
+  memset(fm, 0, sizeof(*fm));
+  fm->step = step;
+  fm->modulus = modulus;
+  memset(model, 0, sizeof(*model));
+  model->ops = &spec_ops;
+  model->impl = fm;
+  model->vocab_size = FAKE_VOCAB;
+  model->max_seq_len = 256;
+}
+
+static speculative_params_t greedy_spec_params(int max_tokens) {
+  speculative_params_t params;
+  memset(&params, 0, sizeof(params));
+  params.max_tokens = max_tokens;
+  params.eos_token_id = -1;
+  return params;
+}
+
+TEST(speculative_greedy_matches_plain_decoding) {
+  inference_model_t target;
+  spec_fake_model tf;
+  init_spec_model(&target, &tf, 1, FAKE_VOCAB);
+
+  int prompt[3] = {1, 2, 3};
+  int out[10];
+  speculative_params_t params = greedy_spec_params(10);
+  speculative_stats_t stats;
+  ASSERT_EQ_INT(10,
+                speculative_generate(&target, NULL, out, prompt, 3, &params,
+                                     &stats));
+  for (int i = 0; i < 10; i++)
+    ASSERT_EQ_INT(4 + i, out[i]);
+
+  /* Nothing repeats, so there is nothing to look up */
+  ASSERT_EQ_INT(0, (int)stats.drafted);
+  ASSERT_EQ_INT(10, (int)stats.generated);
+  ASSERT_EQ_INT(0, tf.live_seqs);
+}
+
+TEST(speculative_prompt_lookup_accepts_repeats) {
+  inference_model_t target;
+  spec_fake_model tf;
+  init_spec_model(&target, &tf, 1, 8);
+
+  int prompt[10] = {0, 1, 2, 3, 4, 5, 6, 7, 0, 1};
+  int out[24];
+  speculative_params_t params = greedy_spec_params(24);
+  speculative_stats_t stats;
+  ASSERT_EQ_INT(24,
+                speculative_generate(&target, NULL, out, prompt, 10, &params,
+                                     &stats));
+  for (int i = 0; i < 24; i++)
+    ASSERT_EQ_INT((2 + i) % 8, out[i]);
+
+  /* Every lookup draft continues the cycle; four tokens per draft step */
+  ASSERT_GT((int)stats.drafted, 0);
+  ASSERT_EQ_INT((int)stats.drafted, (int)stats.accepted);
+  ASSERT_NEAR(1.0, speculative_acceptance_rate(&stats), 1e-9);
+  ASSERT_LE((int)stats.steps, 24 / 5 + 1);
+  ASSERT_EQ_INT(0, tf.live_seqs);
+}
+
+TEST(speculative_agreeing_draft_is_fully_accepted) {
+  inference_model_t target, draft;
+  spec_fake_model tf, df;
+  init_spec_model(&target, &tf, 1, FAKE_VOCAB);
+  init_spec_model(&draft, &df, 1, FAKE_VOCAB);
+
+  int prompt[2] = {5, 6};
+  int out[20];
+  speculative_params_t params = greedy_spec_params(20);
+  params.num_draft = 3;
+  speculative_stats_t stats;
+  ASSERT_EQ_INT(20,
+                speculative_generate(&target, &draft, out, prompt, 2, &params,
+                                     &stats));
+  for (int i = 0; i < 20; i++)
+    ASSERT_EQ_INT(7 + i, out[i]);
+
+  ASSERT_EQ_INT((int)stats.drafted, (int)stats.accepted);
+  /* Prefill plus one verification per num_draft + 1 tokens */
+  ASSERT_LE(tf.forward_calls, 1 + 20 / 4 + 1);
+  ASSERT_EQ_INT(0, tf.live_seqs);
+  ASSERT_EQ_INT(0, df.live_seqs);
+}
+
+TEST(speculative_rejected_drafts_are_rolled_back) {
+  inference_model_t target, draft;
+  spec_fake_model tf, df;
+  init_spec_model(&target, &tf, 1, FAKE_VOCAB);
+  init_spec_model(&draft, &df, 2, FAKE_VOCAB);
+
+  int prompt[3] = {1, 2, 3};
+  int out[12];
+  speculative_params_t params = greedy_spec_params(12);
+  speculative_stats_t stats;
+  ASSERT_EQ_INT(12,
+                speculative_generate(&target, &draft, out, prompt, 3, &params,
+                                     &stats));
+  for (int i = 0; i < 12; i++)
+    ASSERT_EQ_INT(4 + i, out[i]);
+
+  ASSERT_GT((int)stats.drafted, 0);
+  ASSERT_EQ_INT(0, (int)stats.accepted);
+  /* Each step keeps only the token it verified; the last is never fed */
+  ASSERT_EQ_INT(3 + 12 - 1, tf.last_len);
+  ASSERT_LE(df.last_len, tf.last_len);
+  ASSERT_EQ_INT(0, tf.live_seqs);
+  ASSERT_EQ_INT(0, df.live_seqs);
+}
+
+TEST(speculative_stops_at_eos) {
+  inference_model_t target, draft;
+  spec_fake_model tf, df;
+  init_spec_model(&target, &tf, 1, FAKE_VOCAB);
+  init_spec_model(&draft, &df, 1, FAKE_VOCAB);
+
+  int prompt[1] = {10};
+  int out[32];
+  speculative_params_t params = greedy_spec_params(32);
+  params.eos_token_id = 16;
+  ASSERT_EQ_INT(6,
+                speculative_generate(&target, &draft, out, prompt, 1, &params,
+                                     NULL));
+  ASSERT_EQ_INT(16, out[5]);
+}
+
+TEST(speculative_sampling_follows_target_distribution) {
+  /* Draft and target disagree; the output must still follow the target */
+  float target_logits[FAKE_VOCAB], draft_logits[FAKE_VOCAB];
+  const float p[4] = {0.1f, 0.2f, 0.3f, 0.4f};
+  const float q[4] = {0.4f, 0.3f, 0.2f, 0.1f};
+  for (int v = 0; v < FAKE_VOCAB; v++) {
+    target_logits[v] = v < 4 ? logf(p[v]) : -100.0f;
+    draft_logits[v] = v < 4 ? logf(q[v]) : -100.0f;
+  }
+
+  inference_model_t target, draft;
+  spec_fake_model tf, df;
+  init_spec_model(&target, &tf, 1, FAKE_VOCAB);
+  init_spec_model(&draft, &df, 1, FAKE_VOCAB);
+  tf.fixed = target_logits;
+  df.fixed = draft_logits;
+  target.max_seq_len = 8192;
+  draft.max_seq_len = 8192;
+
+  const int n = 6000;
+  std::vector<int> out(n);
+  int prompt[1] = {0};
+  speculative_params_t params = greedy_spec_params(n);
+  params.temperature = 1.0f;
+  params.top_p = 1.0f;
+  params.seed = 1234;
+  params.num_draft = 1;
+  speculative_stats_t stats;
+  ASSERT_EQ_INT(n, speculative_generate(&target, &draft, out.data(), prompt,
+                                        1, &params, &stats));
+
+  int counts[4] = {0, 0, 0, 0};
+  for (int i = 0; i < n; i++) {
+    ASSERT_TRUE(out[i] >= 0 && out[i] < 4);
+    counts[out[i]]++;
+  }
+  for (int v = 0; v < 4; v++)
+    ASSERT_NEAR(p[v], (double)counts[v] / n, 0.03);
+
+  /* A single draft is accepted with probability sum(min(p, q)) = 0.6 */
+  ASSERT_NEAR(0.6, speculative_acceptance_rate(&stats), 0.05);
+}
+
+TEST(speculative_rejects_unsupported_models) {
+  inference_model_t target, draft;
+  spec_fake_model tf, df;
+  init_spec_model(&target, &tf, 1, FAKE_VOCAB);
+  init_spec_model(&draft, &df, 1, FAKE_VOCAB);
+
+  int prompt[2] = {1, 2};
+  int out[4];
+  speculative_params_t params = greedy_spec_params(4);
+
+  draft.vocab_size = FAKE_VOCAB / 2;
+  ASSERT_EQ_INT(-1, speculative_generate(&target, &draft, out, prompt, 2,
+                                         &params, NULL));
+
+  spec_ops.seq_forward_all = NULL;
+  ASSERT_EQ_INT(-1, speculative_generate(&target, NULL, out, prompt, 2,
+                                         &params, NULL));
+  ASSERT_EQ_INT(0, tf.live_seqs);
+}
+
+extern "C" void run_speculative_tests(void) {
+  TEST_SUITE("Speculative Decoding");
+  RUN_TEST(speculative_greedy_matches_plain_decoding);
+  RUN_TEST(speculative_prompt_lookup_accepts_repeats);
+  RUN_TEST(speculative_agreeing_draft_is_fully_accepted);
+  RUN_TEST(speculative_rejected_drafts_are_rolled_back);
+  RUN_TEST(speculative_stops_at_eos);
+  RUN_TEST(speculative_sampling_follows_target_distribution);
+  RUN_TEST(speculative_rejects_unsupported_models);
+}
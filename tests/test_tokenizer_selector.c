@@ -187,6 +187,26 @@ TEST(tokenizer_selector_switch_tokenizers) {
   PASS();
 }
 
+TEST(tokenizer_decode_roundtrip) {
+  ChatTokenizer ct;
+  chat_tokenizer_init(&ct);
+  ASSERT(chat_tokenizer_decode(&ct, NULL, 0) == NULL);
+  bool loaded = chat_tokenizer_set(&ct, TOKENIZER_QWEN3);
+  if (loaded) {
+    TokenResult tr;
+    token_result_init(&tr);
+    ASSERT(chat_tokenizer_encode(&ct, "Hello, world! \xc3\xa9t\xc3\xa9", &tr) >
+           0);
+    char *text = chat_tokenizer_decode(&ct, tr.ids, tr.count);
+    ASSERT(text != NULL);
+    ASSERT_EQ_STR("Hello, world! \xc3\xa9t\xc3\xa9", text);
+    free(text);
+    token_result_free(&tr);
+  }
+  chat_tokenizer_free(&ct);
+  PASS();
+}
+
 TEST(tokenizer_count_empty_string) {
   ChatTokenizer ct;
   chat_tokenizer_init(&ct);
@@ -362,4 +382,5 @@ void run_tokenizer_selector_tests(void) {
   RUN_TEST(tokenizer_encode_with_offsets);
   RUN_TEST(tokenizer_encode_offsets_monotonic);
   RUN_TEST(tokenizer_encode_reuses_buffer);
+  RUN_TEST(tokenizer_decode_roundtrip);
 }
@@ -0,0 +1,168 @@
+#include "test_framework.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+#include "inference/core/tensor.h"
+#include "inference/model_loader/weight_cache.h"
+}
+
+static const char *get_source_path(void) {
+  return "tests/reference/hadamard.safetensors";
+}
+
+static const char *get_cache_path(void) {
+  static char path[512];
+  const char *dir = getenv("TMPDIR");
+  snprintf(path, sizeof(path), "%s/sillytui_weight_cache_test.packed",
+           dir ? dir : "/tmp");
+  return path;
+}
+
+static bool write_test_cache(const weight_cache_key_t *key) {
+  int64_t shape_a[2] = {3, 5};
+  int64_t shape_b[1] = {7};
+  tensor_t *a = tensor_create(DTYPE_F16, 2, shape_a);
+  tensor_t *b = tensor_create(DTYPE_F32, 1, shape_b);
+  if (!a || !b) {
+    tensor_free(a);
+    tensor_free(b);
+    return false;
+  }
+  for (int i = 0; i < 15; i++)
+    ((uint16_t *)a->data)[i] = (uint16_t)(i * 31);
+  for (int i = 0; i < 7; i++)
+    ((float *)b->data)[i] = (float)i * 0.5f;
+
+  weight_cache_writer_t *writer = weight_cache_writer_create();
+  bool ok = writer && weight_cache_writer_add(writer, "layer.w:t", a) &&
+            weight_cache_writer_add(writer, "norm", b) &&
+            weight_cache_writer_commit(writer, get_cache_path(), key);
+  weight_cache_writer_free(writer);
+  tensor_free(a);
+  tensor_free(b);
+  return ok;
+}
+
+TEST(weight_cache_roundtrip) {
+  weight_cache_key_t key;
+  ASSERT_TRUE(weight_cache_key_init(&key, get_source_path(), DTYPE_F16, 1));
+  ASSERT_TRUE(write_test_cache(&key));
+
+  weight_cache_t *cache = weight_cache_open(get_cache_path(), &key);
+  ASSERT_NOT_NULL(cache);
+
+  tensor_t *a = weight_cache_get(cache, "layer.w:t");
+  tensor_t *b = weight_cache_get(cache, "norm");
+  ASSERT_NOT_NULL(a);
+  ASSERT_NOT_NULL(b);
+  ASSERT_NULL(weight_cache_get(cache, "layer.w"));
+
+  ASSERT_EQ(DTYPE_F16, a->dtype);
+  ASSERT_EQ(2, a->ndim);
+  ASSERT_EQ(3, a->shape[0]);
+  ASSERT_EQ(5, a->shape[1]);
+  ASSERT_FALSE(a->owns_data);
+  ASSERT_EQ(0, (int)((uintptr_t)a->data % 64));
+  ASSERT_EQ(14 * 31, ((const uint16_t *)a->data)[14]);
+  ASSERT_EQ(7, (int)b->numel);
+  ASSERT_TRUE(((const float *)b->data)[6] == 3.0f);
+
+  tensor_free(a);
+  tensor_free(b);
+  weight_cache_close(cache);
+  remove(get_cache_path());
+
+  PASS();
+}
+
+TEST(weight_cache_rejects_other_key) {
+  weight_cache_key_t key;
+  ASSERT_TRUE(weight_cache_key_init(&key, get_source_path(), DTYPE_F16, 1));
+  ASSERT_TRUE(write_test_cache(&key));
+
+  weight_cache_key_t other = key;
+  other.layout = 2;
+  ASSERT_NULL(weight_cache_open(get_cache_path(), &other));
+
+  other = key;
+  other.dtype = DTYPE_F32;
+  ASSERT_NULL(weight_cache_open(get_cache_path(), &other));
+
+  other = key;
+  other.source_mtime += 1;
+  ASSERT_NULL(weight_cache_open(get_cache_path(), &other));
+
+  remove(get_cache_path());
+  PASS();
+}
+
+TEST(weight_cache_rejects_truncated_file) {
+  weight_cache_key_t key;
+  ASSERT_TRUE(weight_cache_key_init(&key, get_source_path(), DTYPE_F16, 1));
+  ASSERT_TRUE(write_test_cache(&key));
+
+  /* Keep the header and table but drop the tensor data */
+  FILE *fp = fopen(get_cache_path(), "rb");
+  ASSERT_NOT_NULL(fp);
+  char head[512];
+  size_t n = fread(head, 1, sizeof(head), fp);
+  fclose(fp);
+  fp = fopen(get_cache_path(), "wb");
+  ASSERT_NOT_NULL(fp);
+  fwrite(head, 1, n, fp);
+  fclose(fp);
+
+  ASSERT_NULL(weight_cache_open(get_cache_path(), &key));
+
+  remove(get_cache_path());
+  PASS();
+}
+
+TEST(weight_cache_key_covers_every_source) {
+  weight_cache_key_t one, both, swapped;
+  ASSERT_TRUE(weight_cache_key_init(&one, get_source_path(), DTYPE_F16, 1));
+  both = one;
+  ASSERT_TRUE(weight_cache_key_add_source(
+      &both, "tests/reference/softmax_reference.safetensors"));
+  swapped = one;
+  ASSERT_TRUE(weight_cache_key_add_source(
+      &swapped, "tests/reference/sampling_reference.safetensors"));
+
+  ASSERT_TRUE(both.source_mtime != one.source_mtime);
+  ASSERT_TRUE(both.source_mtime != swapped.source_mtime);
+  ASSERT_TRUE(both.source_size > one.source_size);
+  ASSERT_EQ(one.dtype, both.dtype);
+  ASSERT_EQ(one.layout, both.layout);
+
+  ASSERT_TRUE(write_test_cache(&both));
+  ASSERT_NULL(weight_cache_open(get_cache_path(), &one));
+  ASSERT_NULL(weight_cache_open(get_cache_path(), &swapped));
+  weight_cache_t *cache = weight_cache_open(get_cache_path(), &both);
+  ASSERT_NOT_NULL(cache);
+  weight_cache_close(cache);
+
+  ASSERT_FALSE(weight_cache_key_add_source(&both, "nonexistent.safetensors"));
+  remove(get_cache_path());
+  PASS();
+}
+
+TEST(weight_cache_missing_source) {
+  weight_cache_key_t key;
+  ASSERT_FALSE(weight_cache_key_init(&key, "nonexistent.safetensors",
+                                     DTYPE_F16, 1));
+  ASSERT_NULL(weight_cache_open("nonexistent.packed", &key));
+  PASS();
+}
+
+extern "C" {
+void run_weight_cache_tests(void) {
+  TEST_SUITE("Weight Cache");
+  RUN_TEST(weight_cache_roundtrip);
+  RUN_TEST(weight_cache_rejects_other_key);
+  RUN_TEST(weight_cache_rejects_truncated_file);
+  RUN_TEST(weight_cache_key_covers_every_source);
+  RUN_TEST(weight_cache_missing_source);
+}
+}